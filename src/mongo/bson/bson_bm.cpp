@@ -59,6 +59,31 @@ BSONObj buildSampleObj(long long unsigned int i) {
                        << "random" << random << "phone_no" << phone_no << "long_string"
                        << long_string);
 }
+
+/**
+ * Builds a flat document with 'numFields' fields, shaped like a typical wide record: descriptive
+ * field names of 10 to 40 characters holding small scalars and strings.
+ */
+BSONObj buildWideObj(int numFields) {
+    static const std::vector<std::string> kStems = {"customer",
+                                                    "shipping_address_line",
+                                                    "lastModifiedTimestamp",
+                                                    "order_total_including_tax_and_discounts",
+                                                    "status"};
+    BSONObjBuilder builder;
+    builder.append("_id", OID::gen());
+    for (int i = 0; i < numFields; ++i) {
+        auto name = fmt::format("{}_{}", kStems[i % kStems.size()], i);
+        if (i % 3 == 0) {
+            builder.append(name, fmt::format("value of field {}", i));
+        } else if (i % 3 == 1) {
+            builder.append(name, i * 7919);
+        } else {
+            builder.append(name, i * 0.5);
+        }
+    }
+    return builder.obj();
+}
 }  // namespace
 
 void BM_arrayBuilder(benchmark::State& state) {
@@ -112,8 +137,50 @@ void BM_validate(benchmark::State& state) {
     state.SetBytesProcessed(totalSize);
 }
 
+// Validates documents one at a time, as done for each inbound message and applied oplog entry.
+void BM_validateDocuments(benchmark::State& state) {
+    std::vector<BSONObj> docs;
+    for (auto i = 0; i < 1000; i++)
+        docs.push_back(state.range(0) ? buildWideObj(state.range(0)) : buildSampleObj(i));
+
+    size_t totalSize = 0;
+    for (auto _ : state) {
+        for (auto&& doc : docs) {
+            benchmark::DoNotOptimize(validateBSON(doc.objdata(), doc.objsize()));
+            totalSize += doc.objsize();
+        }
+    }
+    state.SetBytesProcessed(totalSize);
+}
+
+// Looks up the first, a middle and the last field of each document by name.
+void BM_getField(benchmark::State& state) {
+    std::vector<BSONObj> docs;
+    for (auto i = 0; i < 1000; i++)
+        docs.push_back(state.range(0) ? buildWideObj(state.range(0)) : buildSampleObj(i));
+
+    std::vector<std::string> names;
+    for (auto&& elem : docs[0])
+        names.push_back(elem.fieldName());
+    const std::vector<std::string> lookups = {names.front(), names[names.size() / 2], names.back()};
+
+    size_t lookupCount = 0;
+    for (auto _ : state) {
+        for (auto&& doc : docs) {
+            for (auto&& name : lookups) {
+                benchmark::DoNotOptimize(doc.getField(name));
+            }
+            lookupCount += lookups.size();
+        }
+    }
+    state.SetItemsProcessed(lookupCount);
+}
+
 BENCHMARK(BM_arrayBuilder)->Ranges({{{1}, {100'000}}});
 BENCHMARK(BM_arrayLookup)->Ranges({{{1}, {100'000}}});
 BENCHMARK(BM_validate)->Ranges({{{1}, {1'000}}});
+// An argument of 0 uses the sample documents, others use wide documents with that many fields.
+BENCHMARK(BM_validateDocuments)->Arg(0)->Arg(20)->Arg(200);
+BENCHMARK(BM_getField)->Arg(0)->Arg(20)->Arg(200);
 
 }  // namespace mongo
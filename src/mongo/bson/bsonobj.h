@@ -46,6 +46,7 @@
 #include "mongo/bson/oid.h"
 #include "mongo/bson/timestamp.h"
 #include "mongo/bson/util/builder.h"
+#include "mongo/bson/util/simd_strlen.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/shared_buffer.h"
@@ -795,7 +796,9 @@ public:
 
     BSONElement next() {
         verify(_pos <= _theend);
-        BSONElement e(_pos);
+        // Every field name is terminated before the EOO byte at '_theend'. Scanning from the type
+        // byte counts it in place of the terminator, which yields the size the constructor expects.
+        BSONElement e(_pos, simdStrlen(_pos, _theend + 1), -1, BSONElement::CachedSizeTag());
         _pos += e.size();
         return e;
     }
@@ -0,0 +1,90 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_AMD64) || defined(__amd64__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+
+/**
+ * Returns the length of the NUL-terminated string at 'str', which must be terminated before 'end'.
+ * No bytes at or past 'end' are read, so this can scan the field names and strings of a BSON buffer
+ * whose end is known without touching the memory that follows it.
+ *
+ * Field names are usually short, so this is written to be inlined into BSON iteration and
+ * validation rather than to call out to the platform's strlen. The string is searched for its
+ * terminator 16 bytes at a time with SSE2 on x86-64 and NEON on AArch64; both are part of the
+ * baseline instruction set of those architectures, so no runtime dispatch is needed. The last
+ * bytes before 'end', and other architectures, are scanned one byte at a time.
+ */
+inline size_t simdStrlen(const char* str, const char* end) {
+    size_t len = 0;
+
+#if defined(_M_AMD64) || defined(__amd64__)
+    const __m128i zero = _mm_setzero_si128();
+    while (end - (str + len) >= 16) {
+        // This function is documented as taking an unaligned pointer.
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + len));
+        if (uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero))) {
+            return len + countTrailingZeros64(mask);
+        }
+        len += 16;
+    }
+#elif defined(__aarch64__)
+    while (end - (str + len) >= 16) {
+        const uint8x16_t isZero = vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(str + len)),
+                                           vdupq_n_u8(0));
+        // Narrow each byte of the comparison to a nibble, yielding a 64-bit mask.
+        const uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(isZero), 4)), 0);
+        if (mask) {
+            return len + countTrailingZeros64(mask) / 4;
+        }
+        len += 16;
+    }
+#endif
+
+    while (str[len]) {
+        ++len;
+    }
+    return len;
+}
+
+}  // namespace mongo
@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <cstring>
+#include <memory>
+
+#include "mongo/bson/util/simd_strlen.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(SimdStrlenTest, MatchesStrlenForEveryLengthAndAlignment) {
+    char buf[128];
+    for (size_t offset = 0; offset < 16; ++offset) {
+        for (size_t len = 0; len + offset < sizeof(buf); ++len) {
+            memset(buf, 'x', sizeof(buf));
+            buf[offset + len] = '\0';
+            ASSERT_EQ(simdStrlen(buf + offset, buf + sizeof(buf)), len);
+            ASSERT_EQ(simdStrlen(buf + offset, buf + offset + len + 1), len);
+        }
+    }
+}
+
+TEST(SimdStrlenTest, FindsTheFirstOfSeveralTerminators) {
+    const char str[] = "field\0name\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0";
+    ASSERT_EQ(simdStrlen(str, str + sizeof(str)), 5U);
+    ASSERT_EQ(simdStrlen(str + 6, str + sizeof(str)), 4U);
+    ASSERT_EQ(simdStrlen(str + 10, str + sizeof(str)), 0U);
+}
+
+TEST(SimdStrlenTest, HandlesBytesWithTheHighBitSet) {
+    char buf[40];
+    memset(buf, '\xff', sizeof(buf));
+    buf[33] = '\0';
+    ASSERT_EQ(simdStrlen(buf, buf + sizeof(buf)), 33U);
+}
+
+TEST(SimdStrlenTest, DoesNotReadPastTheEnd) {
+    // Place the string at the very end of a heap allocation, so that reading past 'end' would be
+    // reported by the address sanitizer.
+    for (size_t len = 0; len < 40; ++len) {
+        auto buf = std::make_unique<char[]>(len + 1);
+        memset(buf.get(), 'y', len);
+        buf[len] = '\0';
+        ASSERT_EQ(simdStrlen(buf.get(), buf.get() + len + 1), len);
+    }
+}
+
+}  // namespace
+}  // namespace mongo
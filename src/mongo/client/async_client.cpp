@@ -33,6 +33,7 @@
 
 #include "mongo/client/async_client.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "mongo/bson/bsonobjbuilder.h"
@@ -317,6 +318,167 @@ Future<executor::RemoteCommandResponse> AsyncDBClient::runCommandRequest(
         });
 }
 
+Future<executor::RemoteCommandResponse> AsyncDBClient::runPipelinedCommandRequest(
+    executor::RemoteCommandRequest request, int32_t msgId) {
+    auto startTimer = Timer();
+    invariant(_negotiatedProtocol);
+    auto opMsgRequest = OpMsgRequest::fromDBAndBody(
+        std::move(request.dbname), std::move(request.cmdObj), std::move(request.metadata));
+    auto requestMsg = rpc::messageFromOpMsgRequest(*_negotiatedProtocol, std::move(opMsgRequest));
+
+    auto pf = makePromiseFuture<Message>();
+    bool startReading = false;
+    bool startWriting = false;
+    {
+        stdx::lock_guard lk(_pipelineMutex);
+        if (!_pipelineStatus.isOK()) {
+            return _pipelineStatus;
+        }
+
+        invariant(_pipelinedReplies.emplace(msgId, std::move(pf.promise)).second);
+        startReading = !std::exchange(_pipelineReading, true);
+        startWriting = !std::exchange(_pipelineWriting, true);
+        if (!startWriting) {
+            _pipelinedWrites.emplace_back(std::move(requestMsg), msgId);
+        }
+    }
+
+    if (startReading) {
+        _readPipelined();
+    }
+    if (startWriting) {
+        _writePipelined(std::move(requestMsg), msgId);
+    }
+
+    return std::move(pf.future).then([startTimer = std::move(startTimer)](Message responseMsg) {
+        rpc::UniqueReply response(responseMsg, rpc::makeReply(&responseMsg));
+        return executor::RemoteCommandResponse(*response, startTimer.elapsed());
+    });
+}
+
+void AsyncDBClient::cancelPipelinedRequest(int32_t msgId, Status reason) {
+    boost::optional<Promise<Message>> promise;
+    {
+        stdx::lock_guard lk(_pipelineMutex);
+        auto it = _pipelinedReplies.find(msgId);
+        if (it == _pipelinedReplies.end() || !it->second) {
+            return;
+        }
+        promise = std::exchange(it->second, boost::none);
+
+        auto queued = std::find_if(_pipelinedWrites.begin(),
+                                   _pipelinedWrites.end(),
+                                   [&](const auto& write) { return write.second == msgId; });
+        if (queued != _pipelinedWrites.end()) {
+            // The request never reached the wire, so there is no reply to wait for.
+            _pipelinedWrites.erase(queued);
+            _pipelinedReplies.erase(it);
+        }
+    }
+
+    promise->setError(std::move(reason));
+}
+
+bool AsyncDBClient::isPipelineIdle() {
+    stdx::lock_guard lk(_pipelineMutex);
+    // A read or write may still be in flight for a request which was canceled, and so erased
+    // from the maps, meanwhile.
+    return _pipelineStatus.isOK() && _pipelinedReplies.empty() && _pipelinedWrites.empty() &&
+        !_pipelineReading && !_pipelineWriting;
+}
+
+void AsyncDBClient::setProtocolForTest(rpc::Protocol protocol) {
+    _negotiatedProtocol = protocol;
+}
+
+void AsyncDBClient::_writePipelined(Message request, int32_t msgId) {
+    _call(std::move(request), msgId).getAsync([this, anchor = shared_from_this()](Status status) {
+        if (!status.isOK()) {
+            _failPipeline(std::move(status));
+            return;
+        }
+
+        boost::optional<std::pair<Message, int32_t>> next;
+        {
+            stdx::lock_guard lk(_pipelineMutex);
+            if (_pipelinedWrites.empty() || !_pipelineStatus.isOK()) {
+                _pipelineWriting = false;
+                return;
+            }
+            next = std::move(_pipelinedWrites.front());
+            _pipelinedWrites.pop_front();
+        }
+
+        _writePipelined(std::move(next->first), next->second);
+    });
+}
+
+void AsyncDBClient::_readPipelined() {
+    _waitForResponse(boost::none)
+        .getAsync([this, anchor = shared_from_this()](StatusWith<Message> swResponse) {
+            if (!swResponse.isOK()) {
+                _failPipeline(swResponse.getStatus());
+                return;
+            }
+
+            auto& response = swResponse.getValue();
+            auto responseTo = response.header().getResponseToMsgId();
+            boost::optional<Promise<Message>> promise;
+            bool isKnownRequest = false;
+            bool readMore = false;
+            {
+                stdx::lock_guard lk(_pipelineMutex);
+                if (!_pipelineStatus.isOK()) {
+                    return;
+                }
+
+                auto it = _pipelinedReplies.find(responseTo);
+                if (it != _pipelinedReplies.end()) {
+                    // A canceled request has no promise left, so its reply is dropped.
+                    isKnownRequest = true;
+                    promise = std::move(it->second);
+                    _pipelinedReplies.erase(it);
+                    readMore = !_pipelinedReplies.empty();
+                    _pipelineReading = readMore;
+                }
+            }
+
+            if (!isKnownRequest) {
+                _failPipeline(Status(ErrorCodes::ProtocolError,
+                                     str::stream() << "Received a reply to unknown request "
+                                                   << responseTo << " from " << _peer));
+                return;
+            }
+
+            if (promise) {
+                promise->emplaceValue(std::move(response));
+            }
+            if (readMore) {
+                _readPipelined();
+            }
+        });
+}
+
+void AsyncDBClient::_failPipeline(Status status) {
+    decltype(_pipelinedReplies) replies;
+    {
+        stdx::lock_guard lk(_pipelineMutex);
+        if (_pipelineStatus.isOK()) {
+            _pipelineStatus = status;
+        }
+        replies = std::exchange(_pipelinedReplies, {});
+        _pipelinedWrites.clear();
+        _pipelineWriting = false;
+        _pipelineReading = false;
+    }
+
+    for (auto& [msgId, promise] : replies) {
+        if (promise) {
+            promise->setError(status);
+        }
+    }
+}
+
 Future<executor::RemoteCommandResponse> AsyncDBClient::_continueReceiveExhaustResponse(
     ClockSource::StopWatch stopwatch, boost::optional<int32_t> msgId, const BatonHandle& baton) {
     return _waitForResponse(msgId, baton)
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 
 #include "mongo/client/authenticate.h"
@@ -36,8 +37,10 @@
 #include "mongo/executor/network_connection_hook.h"
 #include "mongo/executor/remote_command_request.h"
 #include "mongo/executor/remote_command_response.h"
+#include "mongo/platform/mutex.h"
 #include "mongo/rpc/protocol.h"
 #include "mongo/rpc/unique_message.h"
+#include "mongo/stdx/unordered_map.h"
 #include "mongo/transport/baton.h"
 #include "mongo/transport/message_compressor_manager.h"
 #include "mongo/transport/transport_layer.h"
@@ -66,6 +69,32 @@ public:
                                         const BatonHandle& baton = nullptr,
                                         bool fireAndForget = false);
 
+    /**
+     * Runs a command which may share the connection with other pipelined commands. The request is
+     * written as soon as the writes queued before it complete, without waiting for their replies,
+     * and its reply is matched to it through the responseTo field of the reply header. 'msgId'
+     * must come from nextMessageId().
+     *
+     * A failure to write or read on the connection fails every pipelined command in flight, and
+     * no further command can be pipelined over it. Must not be mixed with the other ways of running
+     * commands while any pipelined command is in flight.
+     */
+    Future<executor::RemoteCommandResponse> runPipelinedCommandRequest(
+        executor::RemoteCommandRequest request, int32_t msgId);
+
+    /**
+     * Fails the pipelined command sent as 'msgId' with 'reason', if it has not completed yet. A
+     * command which has not been written yet is dropped. Otherwise its reply is still read off the
+     * connection once it arrives, and then discarded.
+     */
+    void cancelPipelinedRequest(int32_t msgId, Status reason);
+
+    /**
+     * Returns true if the connection has not failed and no pipelined command is in flight over it,
+     * including canceled commands whose reply has not been read yet.
+     */
+    bool isPipelineIdle();
+
     Future<executor::RemoteCommandResponse> beginExhaustCommandRequest(
         executor::RemoteCommandRequest request, const BatonHandle& baton = nullptr);
     Future<executor::RemoteCommandResponse> runExhaustCommand(OpMsgRequest request,
@@ -93,6 +122,11 @@ public:
     const HostAndPort& remote() const;
     const HostAndPort& local() const;
 
+    /**
+     * Sets the protocol which is otherwise negotiated by initWireVersion().
+     */
+    void setProtocolForTest(rpc::Protocol protocol);
+
 private:
     Future<executor::RemoteCommandResponse> _continueReceiveExhaustResponse(
         ClockSource::StopWatch stopwatch,
@@ -106,12 +140,27 @@ private:
     void _parseIsMasterResponse(BSONObj request,
                                 const std::unique_ptr<rpc::ReplyInterface>& response);
     auth::RunCommandHook _makeAuthRunCommandHook();
+    void _writePipelined(Message request, int32_t msgId);
+    void _readPipelined();
+    void _failPipeline(Status status);
 
     const HostAndPort _peer;
     transport::SessionHandle _session;
     ServiceContext* const _svcCtx;
     MessageCompressorManager _compressorManager;
     boost::optional<rpc::Protocol> _negotiatedProtocol;
+
+    // State of the pipelined commands, which is only used by runPipelinedCommandRequest().
+    Mutex _pipelineMutex = MONGO_MAKE_LATCH("AsyncDBClient::_pipelineMutex");
+    // Awaited replies by request id. A canceled request keeps its entry, without a promise, until
+    // its reply has been read.
+    stdx::unordered_map<int32_t, boost::optional<Promise<Message>>> _pipelinedReplies;
+    // Requests waiting for the write in progress to complete.
+    std::deque<std::pair<Message, int32_t>> _pipelinedWrites;
+    bool _pipelineWriting = false;
+    bool _pipelineReading = false;
+    // The first failure on the connection, after which no command can be pipelined.
+    Status _pipelineStatus = Status::OK();
 };
 
 }  // namespace mongo
@@ -0,0 +1,288 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <deque>
+
+#include "mongo/client/async_client.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/transport/mock_session.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * A session whose writes complete immediately, unless the test holds them, and whose reads
+ * complete only when the test hands them a reply or a failure, so that replies can be delivered in
+ * any order.
+ */
+class PipelineSession : public transport::MockSession {
+public:
+    PipelineSession() : transport::MockSession(nullptr) {}
+
+    Future<Message> asyncSourceMessage(const BatonHandle& baton = nullptr) override {
+        auto pf = makePromiseFuture<Message>();
+        stdx::lock_guard lk(_mutex);
+        _reads.push_back(std::move(pf.promise));
+        return std::move(pf.future);
+    }
+
+    Future<void> asyncSinkMessage(Message message, const BatonHandle& baton = nullptr) override {
+        stdx::lock_guard lk(_mutex);
+        if (!_sinkStatus.isOK()) {
+            return _sinkStatus;
+        }
+        _sent.push_back(message.header().getId());
+        if (_holdWrites) {
+            auto pf = makePromiseFuture<void>();
+            _writes.push_back(std::move(pf.promise));
+            return std::move(pf.future);
+        }
+        return Status::OK();
+    }
+
+    void setSinkStatus(Status status) {
+        stdx::lock_guard lk(_mutex);
+        _sinkStatus = std::move(status);
+    }
+
+    /**
+     * Makes the writes which follow wait for completeWrite().
+     */
+    void holdWrites() {
+        stdx::lock_guard lk(_mutex);
+        _holdWrites = true;
+    }
+
+    /**
+     * Completes the oldest held write.
+     */
+    void completeWrite() {
+        Promise<void> promise;
+        {
+            stdx::lock_guard lk(_mutex);
+            ASSERT_FALSE(_writes.empty());
+            promise = std::move(_writes.front());
+            _writes.pop_front();
+        }
+        promise.emplaceValue();
+    }
+
+    /**
+     * Returns the ids of the messages written so far.
+     */
+    std::vector<int32_t> sent() {
+        stdx::lock_guard lk(_mutex);
+        return _sent;
+    }
+
+    /**
+     * Completes the oldest outstanding read with a reply to 'msgId' carrying 'body'.
+     */
+    void reply(int32_t msgId, BSONObj body) {
+        OpMsgBuilder builder;
+        builder.setBody(body);
+        auto message = builder.finish();
+        message.header().setId(nextMessageId());
+        message.header().setResponseToMsgId(msgId);
+        _popRead().emplaceValue(std::move(message));
+    }
+
+    /**
+     * Fails the oldest outstanding read with 'status'.
+     */
+    void failRead(Status status) {
+        _popRead().setError(std::move(status));
+    }
+
+private:
+    Promise<Message> _popRead() {
+        stdx::lock_guard lk(_mutex);
+        ASSERT_FALSE(_reads.empty());
+        auto promise = std::move(_reads.front());
+        _reads.pop_front();
+        return promise;
+    }
+
+    Mutex _mutex = MONGO_MAKE_LATCH("PipelineSession::_mutex");
+    std::deque<Promise<Message>> _reads;
+    std::deque<Promise<void>> _writes;
+    std::vector<int32_t> _sent;
+    Status _sinkStatus = Status::OK();
+    bool _holdWrites = false;
+};
+
+class AsyncDBClientPipelineTest : public unittest::Test {
+public:
+    void setUp() override {
+        _session = std::make_shared<PipelineSession>();
+        _client =
+            std::make_shared<AsyncDBClient>(HostAndPort("localhost", 27017), _session, nullptr);
+        _client->setProtocolForTest(rpc::Protocol::kOpMsg);
+    }
+
+    void tearDown() override {
+        _client.reset();
+        _session.reset();
+    }
+
+    PipelineSession& session() {
+        return *_session;
+    }
+
+    AsyncDBClient& client() {
+        return *_client;
+    }
+
+    Future<executor::RemoteCommandResponse> runEcho(int32_t msgId, int value) {
+        executor::RemoteCommandRequest request(HostAndPort("localhost", 27017),
+                                               "admin",
+                                               BSON("echo" << value),
+                                               BSONObj(),
+                                               nullptr);
+        return _client->runPipelinedCommandRequest(std::move(request), msgId);
+    }
+
+private:
+    std::shared_ptr<PipelineSession> _session;
+    std::shared_ptr<AsyncDBClient> _client;
+};
+
+TEST_F(AsyncDBClientPipelineTest, RepliesArriveOutOfOrder) {
+    auto firstId = nextMessageId();
+    auto secondId = nextMessageId();
+    auto first = runEcho(firstId, 1);
+    auto second = runEcho(secondId, 2);
+    auto sent = session().sent();
+    ASSERT_EQ(sent.size(), 2U);
+    ASSERT_EQ(sent[0], firstId);
+    ASSERT_EQ(sent[1], secondId);
+
+    session().reply(secondId, BSON("ok" << 1 << "echo" << 2));
+    ASSERT_TRUE(second.isReady());
+    ASSERT_FALSE(first.isReady());
+    ASSERT_EQ(second.get().data["echo"].numberInt(), 2);
+
+    session().reply(firstId, BSON("ok" << 1 << "echo" << 1));
+    ASSERT_EQ(first.get().data["echo"].numberInt(), 1);
+    ASSERT_TRUE(client().isPipelineIdle());
+}
+
+TEST_F(AsyncDBClientPipelineTest, CancelingOneRequestLeavesOthersRunning) {
+    auto canceledId = nextMessageId();
+    auto otherId = nextMessageId();
+    auto canceled = runEcho(canceledId, 1);
+    auto other = runEcho(otherId, 2);
+
+    client().cancelPipelinedRequest(canceledId, Status(ErrorCodes::CallbackCanceled, "canceled"));
+    ASSERT_EQ(canceled.getNoThrow().getStatus(), ErrorCodes::CallbackCanceled);
+
+    // The reply to the canceled request is read off the connection and dropped.
+    session().reply(canceledId, BSON("ok" << 1 << "echo" << 1));
+    ASSERT_FALSE(other.isReady());
+    ASSERT_FALSE(client().isPipelineIdle());
+
+    session().reply(otherId, BSON("ok" << 1 << "echo" << 2));
+    ASSERT_EQ(other.get().data["echo"].numberInt(), 2);
+    ASSERT_TRUE(client().isPipelineIdle());
+}
+
+TEST_F(AsyncDBClientPipelineTest, CanceledRequestKeepsConnectionBusyUntilItsReplyIsRead) {
+    auto canceledId = nextMessageId();
+    auto otherId = nextMessageId();
+    auto canceled = runEcho(canceledId, 1);
+    auto other = runEcho(otherId, 2);
+
+    client().cancelPipelinedRequest(canceledId, Status(ErrorCodes::CallbackCanceled, "canceled"));
+    session().reply(otherId, BSON("ok" << 1 << "echo" << 2));
+    ASSERT_EQ(other.get().data["echo"].numberInt(), 2);
+    ASSERT_FALSE(client().isPipelineIdle());
+
+    session().reply(canceledId, BSON("ok" << 1 << "echo" << 1));
+    ASSERT_TRUE(client().isPipelineIdle());
+}
+
+TEST_F(AsyncDBClientPipelineTest, OutstandingReadKeepsConnectionBusyAfterQueuedRequestIsCanceled) {
+    session().holdWrites();
+    auto writtenId = nextMessageId();
+    auto queuedId = nextMessageId();
+    auto written = runEcho(writtenId, 1);
+    auto queued = runEcho(queuedId, 2);
+    ASSERT_EQ(session().sent().size(), 1U);
+
+    // The reply to the written request arrives before its write completes, so a read is started
+    // for the queued request.
+    session().reply(writtenId, BSON("ok" << 1 << "echo" << 1));
+    ASSERT_EQ(written.get().data["echo"].numberInt(), 1);
+
+    // The queued request never reaches the wire, but the read started for it is still in flight.
+    client().cancelPipelinedRequest(queuedId, Status(ErrorCodes::CallbackCanceled, "canceled"));
+    ASSERT_EQ(queued.getNoThrow().getStatus(), ErrorCodes::CallbackCanceled);
+    ASSERT_FALSE(client().isPipelineIdle());
+
+    session().completeWrite();
+    ASSERT_EQ(session().sent().size(), 1U);
+    ASSERT_FALSE(client().isPipelineIdle());
+
+    session().failRead(Status(ErrorCodes::HostUnreachable, "connection reset"));
+    ASSERT_FALSE(client().isPipelineIdle());
+}
+
+TEST_F(AsyncDBClientPipelineTest, TransportFailureFailsEveryRequest) {
+    auto first = runEcho(nextMessageId(), 1);
+    auto second = runEcho(nextMessageId(), 2);
+
+    session().failRead(Status(ErrorCodes::HostUnreachable, "connection reset"));
+    ASSERT_EQ(first.getNoThrow().getStatus(), ErrorCodes::HostUnreachable);
+    ASSERT_EQ(second.getNoThrow().getStatus(), ErrorCodes::HostUnreachable);
+    ASSERT_FALSE(client().isPipelineIdle());
+
+    // No further request may be pipelined over the failed connection.
+    ASSERT_EQ(runEcho(nextMessageId(), 3).getNoThrow().getStatus(), ErrorCodes::HostUnreachable);
+}
+
+TEST_F(AsyncDBClientPipelineTest, WriteFailureFailsEveryRequest) {
+    session().setSinkStatus(Status(ErrorCodes::HostUnreachable, "connection reset"));
+    auto first = runEcho(nextMessageId(), 1);
+
+    ASSERT_EQ(first.getNoThrow().getStatus(), ErrorCodes::HostUnreachable);
+    ASSERT_EQ(runEcho(nextMessageId(), 2).getNoThrow().getStatus(), ErrorCodes::HostUnreachable);
+}
+
+TEST_F(AsyncDBClientPipelineTest, ReplyToUnknownRequestFailsPipeline) {
+    auto pending = runEcho(nextMessageId(), 1);
+
+    session().reply(nextMessageId(), BSON("ok" << 1));
+    ASSERT_EQ(pending.getNoThrow().getStatus(), ErrorCodes::ProtocolError);
+}
+
+}  // namespace
+}  // namespace mongo
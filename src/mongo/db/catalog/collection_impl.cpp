@@ -531,6 +531,9 @@ Status CollectionImpl::insertDocuments(OperationContext* opCtx,
 
     const SnapshotId sid = opCtx->recoveryUnit()->getSnapshotId();
 
+    // Filled in by _insertDocuments() with the RecordIds of the inserted documents.
+    OpObserver::ObservedRecordIds::Scope observedRecordIds(opCtx);
+
     status = _insertDocuments(opCtx, begin, end, opDebug);
     if (!status.isOK()) {
         return status;
@@ -623,6 +626,8 @@ Status CollectionImpl::insertDocumentForBulkLoader(
     }
     inserts.emplace_back(kUninitializedStmtId, doc, slot);
 
+    OpObserver::ObservedRecordIds::Scope observedRecordIds(opCtx, {loc.getValue()});
+
     getGlobalServiceContext()->getOpObserver()->onInserts(
         opCtx, ns(), uuid(), inserts.begin(), inserts.end(), false);
 
@@ -679,11 +684,13 @@ Status CollectionImpl::_insertDocuments(OperationContext* opCtx,
 
     std::vector<BsonRecord> bsonRecords;
     bsonRecords.reserve(count);
+    auto& observedRecordIds = OpObserver::ObservedRecordIds::get(opCtx).ids;
     int recordIndex = 0;
     for (auto it = begin; it != end; it++) {
         RecordId loc = records[recordIndex++].id;
         invariant(RecordId::min() < loc);
         invariant(loc < RecordId::max());
+        observedRecordIds.push_back(loc);
 
         BsonRecord bsonRecord = {loc, Timestamp(it->oplogSlot.getTimestamp()), &(it->doc)};
         bsonRecords.push_back(bsonRecord);
@@ -763,6 +770,8 @@ void CollectionImpl::deleteDocument(OperationContext* opCtx,
     _indexCatalog->unindexRecord(opCtx, doc.value(), loc, noWarn, &keysDeleted);
     _recordStore->deleteRecord(opCtx, loc);
 
+    OpObserver::ObservedRecordIds::Scope observedRecordIds(opCtx, {loc});
+
     getGlobalServiceContext()->getOpObserver()->onDelete(
         opCtx, ns(), uuid(), stmtId, fromMigrate, deletedDoc);
 
@@ -859,6 +868,8 @@ RecordId CollectionImpl::updateDocument(OperationContext* opCtx,
     invariant(sid == opCtx->recoveryUnit()->getSnapshotId());
     args->updatedDoc = newDoc;
 
+    OpObserver::ObservedRecordIds::Scope observedRecordIds(opCtx, {oldLocation});
+
     OplogUpdateEntryArgs entryArgs(*args, ns(), _uuid);
     getGlobalServiceContext()->getOpObserver()->onUpdate(opCtx, entryArgs);
 
@@ -896,6 +907,9 @@ StatusWith<RecordData> CollectionImpl::updateDocumentWithDamages(
     if (newRecStatus.isOK()) {
         args->updatedDoc = newRecStatus.getValue().toBson();
         args->preImageRecordingEnabledForCollection = getRecordPreImages();
+
+        OpObserver::ObservedRecordIds::Scope observedRecordIds(opCtx, {loc});
+
         OplogUpdateEntryArgs entryArgs(*args, ns(), _uuid);
         getGlobalServiceContext()->getOpObserver()->onUpdate(opCtx, entryArgs);
     }
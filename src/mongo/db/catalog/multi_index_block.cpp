@@ -206,10 +206,13 @@ StatusWith<std::vector<BSONObj>> MultiIndexBlock::init(
         std::vector<BSONObj> indexInfoObjs;
         indexInfoObjs.reserve(indexSpecs.size());
         std::size_t eachIndexBuildMaxMemoryUsageBytes = 0;
+        std::size_t eachIndexBuildSortThreads = 1;
         if (!indexSpecs.empty()) {
             eachIndexBuildMaxMemoryUsageBytes =
                 static_cast<std::size_t>(maxIndexBuildMemoryUsageMegabytes.load()) * 1024 * 1024 /
                 indexSpecs.size();
+            eachIndexBuildSortThreads = std::max<std::size_t>(
+                1, static_cast<std::size_t>(maxIndexBuildSortThreads.load()) / indexSpecs.size());
         }
 
         for (size_t i = 0; i < indexSpecs.size(); i++) {
@@ -275,7 +278,8 @@ StatusWith<std::vector<BSONObj>> MultiIndexBlock::init(
             if (!status.isOK())
                 return status;
 
-            index.bulk = index.real->initiateBulk(eachIndexBuildMaxMemoryUsageBytes, stateInfo);
+            index.bulk = index.real->initiateBulk(
+                eachIndexBuildMaxMemoryUsageBytes, stateInfo, eachIndexBuildSortThreads);
 
             const IndexDescriptor* descriptor = indexCatalogEntry->descriptor();
 
@@ -296,7 +300,8 @@ StatusWith<std::vector<BSONObj>> MultiIndexBlock::init(
                   "properties"_attr = *descriptor,
                   "method"_attr = _method,
                   "maxTemporaryMemoryUsageMB"_attr =
-                      eachIndexBuildMaxMemoryUsageBytes / 1024 / 1024);
+                      eachIndexBuildMaxMemoryUsageBytes / 1024 / 1024,
+                  "sortThreads"_attr = eachIndexBuildSortThreads);
 
             index.filterExpression = indexCatalogEntry->getFilterExpression();
 
@@ -885,6 +890,7 @@ BSONObj MultiIndexBlock::_constructStateObject(OperationContext* opCtx,
         if (_phase != IndexBuildPhaseEnum::kDrainWrites) {
             // Persist the data to disk so that we see all of the data that has been inserted into
             // the Sorter.
+            uassertStatusOK(index.bulk->waitForPendingInserts(opCtx));
             auto state = index.bulk->persistDataForShutdown();
 
             indexInfo.append("fileName", state.fileName);
@@ -893,9 +899,7 @@ BSONObj MultiIndexBlock::_constructStateObject(OperationContext* opCtx,
             BSONArrayBuilder ranges(indexInfo.subarrayStart("ranges"));
             for (const auto& rangeInfo : state.ranges) {
                 BSONObjBuilder range(ranges.subobjStart());
-                range.append("startOffset", rangeInfo.getStartOffset());
-                range.append("endOffset", rangeInfo.getEndOffset());
-                range.append("checksum", rangeInfo.getChecksum());
+                rangeInfo.serialize(&range);
             }
         }
 
@@ -32,10 +32,13 @@
 #include "mongo/db/catalog/multi_index_block.h"
 
 #include "mongo/db/catalog/catalog_test_fixture.h"
+#include "mongo/db/catalog/multi_index_block_gen.h"
 #include "mongo/db/catalog_raii.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/repl/replication_coordinator_mock.h"
+#include "mongo/db/resumable_index_builds_gen.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -151,6 +154,139 @@ TEST_F(MultiIndexBlockTest, AbortWithoutCleanupAfterInsertingSingleDocument) {
     indexer->abortWithoutCleanupForRollback(operationContext(), coll.get(), isResumable);
 }
 
+TEST_F(MultiIndexBlockTest, CommitAfterGeneratingKeysOnMultipleThreads) {
+    const auto originalSortThreads = maxIndexBuildSortThreads.load();
+    maxIndexBuildSortThreads.store(8);
+    ON_BLOCK_EXIT([&] { maxIndexBuildSortThreads.store(originalSortThreads); });
+
+    auto indexer = getIndexer();
+
+    AutoGetCollection autoColl(operationContext(), getNSS(), MODE_X);
+    CollectionWriter coll(autoColl);
+
+    const auto makeSpec = [](StringData field) {
+        return BSON("key" << BSON(field << 1) << "name" << field + "_1"
+                          << "v" << static_cast<int>(IndexDescriptor::kLatestIndexVersion));
+    };
+
+    {
+        WriteUnitOfWork wuow(operationContext());
+        ASSERT_OK(indexer
+                      ->init(operationContext(),
+                             coll,
+                             {makeSpec("a"), makeSpec("b")},
+                             MultiIndexBlock::kNoopOnInitFn)
+                      .getStatus());
+        wuow.commit();
+    }
+
+    // Insert enough documents for every thread to receive several batches. Array values make 'b_1'
+    // multikey, and documents are inserted in the reverse order of their 'a' keys.
+    const int numDocs = 5000;
+    for (int i = 0; i < numDocs; ++i) {
+        ASSERT_OK(indexer->insertSingleDocumentForInitialSyncOrRecovery(
+            operationContext(),
+            BSON("a" << numDocs - i << "b" << BSON_ARRAY(i << -i)),
+            RecordId(i + 1)));
+    }
+    ASSERT_OK(indexer->dumpInsertsFromBulk(operationContext(), coll.get()));
+    ASSERT_OK(indexer->checkConstraints(operationContext(), coll.get()));
+
+    {
+        WriteUnitOfWork wunit(operationContext());
+        ASSERT_OK(indexer->commit(operationContext(),
+                                  coll.getWritableCollection(),
+                                  MultiIndexBlock::kNoopOnCreateEachFn,
+                                  MultiIndexBlock::kNoopOnCommitFn));
+        wunit.commit();
+    }
+
+    auto indexCatalog = coll->getIndexCatalog();
+    auto aEntry = indexCatalog->getEntry(indexCatalog->findIndexByName(operationContext(), "a_1"));
+    ASSERT_FALSE(aEntry->isMultikey());
+    ASSERT_EQ(numDocs,
+              aEntry->accessMethod()->getSortedDataInterface()->numEntries(operationContext()));
+
+    // The document with 'b: [0, 0]' only has one key.
+    auto bEntry = indexCatalog->getEntry(indexCatalog->findIndexByName(operationContext(), "b_1"));
+    ASSERT_TRUE(bEntry->isMultikey());
+    ASSERT_EQ(2 * numDocs - 1,
+              bEntry->accessMethod()->getSortedDataInterface()->numEntries(operationContext()));
+}
+
+TEST_F(MultiIndexBlockTest, ResumeFromKeysPersistedOnMultipleThreads) {
+    auto indexer = getIndexer();
+
+    AutoGetCollection autoColl(operationContext(), getNSS(), MODE_X);
+    CollectionWriter coll(autoColl);
+
+    BSONObj spec = BSON("key" << BSON("a" << 1) << "name"
+                              << "a_1"
+                              << "v" << static_cast<int>(IndexDescriptor::kLatestIndexVersion));
+
+    {
+        WriteUnitOfWork wuow(operationContext());
+        ASSERT_OK(indexer->init(operationContext(), coll, {spec}, MultiIndexBlock::kNoopOnInitFn)
+                      .getStatus());
+        wuow.commit();
+    }
+
+    // The indexer only uses its own bulk builders, so the test may use others on the same index.
+    auto indexCatalog = coll->getIndexCatalog();
+    auto accessMethod = const_cast<IndexAccessMethod*>(
+        indexCatalog
+            ->getEntry(indexCatalog->findIndexByName(
+                operationContext(), "a_1", true /* includeUnfinishedIndexes */))
+            ->accessMethod());
+
+    // Every partition receives several batches, and spills its keys to a file of its own when
+    // persisted. The files of the other partitions are appended to that of the first.
+    const size_t maxMemoryUsageBytes = 64 * 1024 * 1024;
+    const int numDocs = 2000;
+    auto bulk = accessMethod->initiateBulk(maxMemoryUsageBytes, boost::none, 2);
+    for (int i = 0; i < numDocs; ++i) {
+        ASSERT_OK(bulk->insert(
+            operationContext(), BSON("a" << numDocs - i), RecordId(i + 1), InsertDeleteOptions()));
+    }
+    ASSERT_OK(bulk->waitForPendingInserts(operationContext()));
+    auto state = bulk->persistDataForShutdown();
+    ASSERT_EQ(numDocs, bulk->getKeysInserted());
+    bulk.reset();
+
+    ASSERT_GTE(state.ranges.size(), 2U);
+    for (size_t i = 1; i < state.ranges.size(); ++i) {
+        ASSERT_GTE(state.ranges[i].getStartOffset(), state.ranges[i - 1].getEndOffset());
+    }
+
+    // Resuming from the file of the first partition sees the keys of every partition, in order.
+    IndexStateInfo stateInfo;
+    stateInfo.setSideWritesTable("");
+    stateInfo.setSpec(spec);
+    stateInfo.setIsMultikey(false);
+    stateInfo.setMultikeyPaths({});
+    stateInfo.setFileName(StringData(state.fileName));
+    stateInfo.setNumKeys(static_cast<long long>(numDocs));
+    stateInfo.setRanges(std::move(state.ranges));
+
+    auto resumed = accessMethod->initiateBulk(maxMemoryUsageBytes, stateInfo, 1);
+    ASSERT_OK(resumed->waitForPendingInserts(operationContext()));
+    std::unique_ptr<IndexAccessMethod::BulkBuilder::Sorter::Iterator> it(resumed->done());
+    int numKeys = 0;
+    KeyString::Value lastKey;
+    while (it->more()) {
+        auto key = it->next().first;
+        if (numKeys > 0) {
+            ASSERT_LT(lastKey.compare(key), 0);
+        }
+        lastKey = std::move(key);
+        ++numKeys;
+    }
+    ASSERT_EQ(numDocs, numKeys);
+    ASSERT_EQ(numDocs, resumed->getKeysInserted());
+
+    indexer->abortIndexBuild(operationContext(), coll, MultiIndexBlock::kNoopOnCleanUpFn);
+}
+
 TEST_F(MultiIndexBlockTest, InitWriteConflictException) {
     auto indexer = getIndexer();
 
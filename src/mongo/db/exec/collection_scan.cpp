@@ -41,6 +41,7 @@
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/optime.h"
 #include "mongo/db/storage/oplog_hack.h"
 #include "mongo/logv2/log.h"
@@ -64,7 +65,13 @@ CollectionScan::CollectionScan(ExpressionContext* expCtx,
     : RequiresCollectionStage(kStageType, expCtx, collection),
       _workingSet(workingSet),
       _filter((filter && !filter->isTriviallyTrue()) ? filter : nullptr),
-      _params(params) {
+      _params(params),
+      _useBatches(!params.tailable && !params.minTs && !params.feedsWriteStage),
+      // An unbounded scan of a regular collection is long-running work, so whenever it reacquires
+      // a ticket after yielding it gives way to latency-sensitive operations.
+      _deprioritizeYields(internalQueryDeprioritizeUnboundedCollectionScans.load() &&
+                          !params.tailable && !params.minTs && !params.maxTs &&
+                          !collection->ns().isOplog()) {
     // Explain reports the direction of the collection scan.
     _specificStats.direction = params.direction;
     _specificStats.minTs = params.minTs;
@@ -182,7 +189,7 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         }
 
         if (!record) {
-            record = _cursor->next();
+            record = nextRecord();
         }
     } catch (const WriteConflictException&) {
         // Leave us in a state to try again next time.
@@ -214,7 +221,9 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     WorkingSetID id = _workingSet->allocate();
     WorkingSetMember* member = _workingSet->get(id);
     member->recordId = record->id;
-    member->resetDocument(opCtx()->recoveryUnit()->getSnapshotId(), record->data.releaseToBson());
+    member->resetDocument(
+        _useBatches ? _batchSnapshotId : opCtx()->recoveryUnit()->getSnapshotId(),
+        record->data.releaseToBson());
     _workingSet->transitionToRecordIdAndObj(id);
 
     return returnIfMatches(member, id, out);
@@ -271,13 +280,46 @@ bool CollectionScan::isEOF() {
     return _commonStats.isEOF;
 }
 
+boost::optional<Record> CollectionScan::nextRecord() {
+    if (!_useBatches) {
+        return _cursor->next();
+    }
+
+    if (_batchPos == _batch.size()) {
+        // Start with a single record so that scans which stop early, for example because of a
+        // limit, read little ahead, and double the batch size with each refill. If the refill
+        // throws a WriteConflictException, the records read before it are kept and returned after
+        // the yield.
+        _batchPos = 0;
+        _batchSnapshotId = opCtx()->recoveryUnit()->getSnapshotId();
+        const size_t maxBatchSize = internalQueryCollectionScanMaxBatchSize.load();
+        _nextBatchSize = std::min(_nextBatchSize, maxBatchSize);
+        if (_cursor->nextBatch(&_batch, _nextBatchSize) == 0) {
+            return boost::none;
+        }
+        _nextBatchSize = std::min(2 * _nextBatchSize, maxBatchSize);
+    }
+
+    const size_t pos = _batchPos++;
+    return Record{_batch.id(pos), _batch.data(pos)};
+}
+
 void CollectionScan::doSaveStateRequiresCollection() {
     if (_cursor) {
         _cursor->save();
     }
+
+    // The locks released by a yield are reacquired before the plan is restored. Operations which
+    // already have a priority of their own keep it.
+    if (_deprioritizeYields && !_yieldTicketPriority &&
+        getTicketPriority(opCtx()) == TicketPriority::kNormal) {
+        _yieldTicketPriority.emplace(opCtx(), TicketPriority::kLow);
+    }
 }
 
 void CollectionScan::doRestoreStateRequiresCollection() {
+    _yieldTicketPriority.reset();
+
     if (_cursor) {
         const bool couldRestore = _cursor->restore();
         uassert(ErrorCodes::CappedPositionLost,
@@ -289,6 +331,7 @@ void CollectionScan::doRestoreStateRequiresCollection() {
 }
 
 void CollectionScan::doDetachFromOperationContext() {
+    _yieldTicketPriority.reset();
     if (_cursor)
         _cursor->detachFromOperationContext();
 }
@@ -36,6 +36,7 @@
 #include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/record_id.h"
 #include "mongo/s/resharding/resume_token_gen.h"
+#include "mongo/util/concurrency/ticketholder.h"
 
 namespace mongo {
 
@@ -115,6 +116,12 @@ private:
      */
     void assertMinTsHasNotFallenOffOplog(const Record& record);
 
+    /**
+     * Returns the next record of the scan, refilling '_batch' from the cursor when batching is
+     * enabled and all of its records have been returned.
+     */
+    boost::optional<Record> nextRecord();
+
     // WorkingSet is not owned by us.
     WorkingSet* _workingSet;
 
@@ -130,6 +137,24 @@ private:
 
     CollectionScanParams _params;
 
+    // Whether records are read from '_cursor' in batches. Batching is not used for tailable scans,
+    // which must observe new records as soon as the cursor does, for scans starting from 'minTs',
+    // which position the cursor themselves, or for scans feeding a write stage.
+    const bool _useBatches;
+
+    // The records read ahead from '_cursor', the snapshot they were read in and the position of
+    // the next record to return. A batch survives yields; its records keep the snapshot id of the
+    // read so that consumers which need the latest version of a document refetch it.
+    RecordBatch _batch;
+    SnapshotId _batchSnapshotId;
+    size_t _batchPos = 0;
+    size_t _nextBatchSize = 1;
+
+    // Whether the operation waits for tickets with low priority while this scan is yielding, and
+    // the priority it waited with before, set from saveState() until restoreState() or detaching.
+    const bool _deprioritizeYields;
+    boost::optional<ScopedTicketPriority> _yieldTicketPriority;
+
     RecordId _lastSeenId;  // Null if nothing has been returned from _cursor yet.
 
     // If _params.shouldTrackLatestOplogTimestamp is set and the collection is the oplog, the latest
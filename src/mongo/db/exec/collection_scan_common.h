@@ -78,6 +78,12 @@ struct CollectionScanParams {
 
     // Whether or not to wait for oplog visibility on oplog collection scans.
     bool shouldWaitForOplogVisibility = false;
+
+    // Set if the documents returned by the scan are written to as they are returned, e.g. by an
+    // update or delete stage. Each write moves the operation to a new snapshot, after which every
+    // record read ahead in a batch would have to be fetched again, so the scan reads records one at
+    // a time instead.
+    bool feedsWriteStage = false;
 };
 
 }  // namespace mongo
@@ -126,6 +126,46 @@ bool DocumentStorageIterator::shouldSkipDeleted() {
     return false;
 }
 
+BSONFieldIndex::BSONFieldIndex(const BSONObj& obj) {
+    std::vector<uint32_t> offsets;
+    for (auto&& elem : obj) {
+        offsets.push_back(elem.rawdata() - obj.objdata());
+    }
+
+    // Keep the load factor at or below one half.
+    size_t numSlots = 8;
+    while (numSlots < offsets.size() * 2) {
+        numSlots *= 2;
+    }
+    _slots.resize(numSlots);
+    _mask = numSlots - 1;
+
+    for (auto offset : offsets) {
+        const auto name = BSONElement(obj.objdata() + offset).fieldNameStringData();
+        for (auto slot = DocumentStorage::hashKey(name) & _mask;; slot = (slot + 1) & _mask) {
+            if (!_slots[slot]) {
+                _slots[slot] = offset + 1;
+                break;
+            }
+            if (BSONElement(obj.objdata() + _slots[slot] - 1).fieldNameStringData() == name) {
+                // Like a scan of the object, lookups find the first of several equal names.
+                break;
+            }
+        }
+    }
+}
+
+BSONElement BSONFieldIndex::find(const BSONObj& obj, StringData name) const {
+    for (auto slot = DocumentStorage::hashKey(name) & _mask; _slots[slot];
+         slot = (slot + 1) & _mask) {
+        BSONElement elem(obj.objdata() + _slots[slot] - 1);
+        if (elem.fieldNameStringData() == name) {
+            return elem;
+        }
+    }
+    return BSONElement();
+}
+
 Position DocumentStorage::findFieldInCache(StringData requested) const {
     int reqSize = requested.size();  // get size calculation out of the way if needed
 
@@ -155,15 +195,33 @@ Position DocumentStorage::findFieldInCache(StringData requested) const {
     return Position();
 }
 
+BSONElement DocumentStorage::findFieldInBson(StringData requested) const {
+    if (!_bsonIndex) {
+        if (_bsonElementsScanned < BSON_INDEX_MIN_SCANNED) {
+            for (auto&& bsonElement : _bson) {
+                ++_bsonElementsScanned;
+                if (requested == bsonElement.fieldNameStringData()) {
+                    return bsonElement;
+                }
+            }
+            return BSONElement();
+        }
+
+        // The fields of this document are looked up often enough that one more pass to index
+        // them all is cheaper than continuing to scan for each of them.
+        _bsonIndex = std::make_shared<BSONFieldIndex>(_bson);
+    }
+
+    return _bsonIndex->find(_bson, requested);
+}
+
 Position DocumentStorage::findField(StringData requested, LookupPolicy policy) const {
     if (auto pos = findFieldInCache(requested); pos.found() || policy == LookupPolicy::kCacheOnly) {
         return pos;
     }
 
-    for (auto&& bsonElement : _bson) {
-        if (requested == bsonElement.fieldNameStringData()) {
-            return const_cast<DocumentStorage*>(this)->constructInCache(bsonElement);
-        }
+    if (auto bsonElement = findFieldInBson(requested)) {
+        return const_cast<DocumentStorage*>(this)->constructInCache(bsonElement);
     }
 
     // if we got here, there's no such field
@@ -318,6 +376,7 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
         dassert(out->_numFields == _numFields);
     }
 
+    out->_bsonIndex = _bsonIndex;
     out->_haveLazyLoadedMetadata = _haveLazyLoadedMetadata;
     out->_metadataFields = _metadataFields;
 
@@ -338,6 +397,8 @@ DocumentStorage::~DocumentStorage() {
 
 void DocumentStorage::reset(const BSONObj& bson, bool stripMetadata) {
     _bson = bson;
+    _bsonIndex.reset();
+    _bsonElementsScanned = 0;
     _stripMetadata = stripMetadata;
     _modified = false;
 
@@ -442,6 +503,14 @@ void Document::toBson(BSONObjBuilder* builder, size_t recursionLevel) const {
                           << BSONDepth::getMaxAllowableDepth() << " levels of nesting",
             recursionLevel <= BSONDepth::getMaxAllowableDepth());
 
+    if (auto bson = toBsonIfTriviallyConvertible()) {
+        // Nothing in this subtree has changed since it was read from BSON, so copy the original
+        // bytes in one go, the same way the uncached fields of a modified document are copied
+        // below, rather than rebuilding the subtree one field at a time.
+        builder->appendElements(*bson);
+        return;
+    }
+
     for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
         if (auto cached = it.cachedValue()) {
             cached->val.addToBsonObj(builder, cached->nameSD(), recursionLevel);
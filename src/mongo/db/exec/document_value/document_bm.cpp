@@ -0,0 +1,98 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Builds a document of roughly 'numFields' * 1KB, made of scalar fields and subdocuments, like the
+ * large documents that $addFields pipelines typically run over.
+ */
+BSONObj makeLargeDocument(int numFields) {
+    const std::string filler(900, 'x');
+    BSONObjBuilder builder;
+    for (int i = 0; i < numFields; ++i) {
+        const std::string name = str::stream() << "field" << i;
+        if (i % 2) {
+            builder.append(name, filler);
+        } else {
+            BSONObjBuilder sub(builder.subobjStart(name));
+            sub.append("a", i);
+            sub.append("b", filler);
+            sub.append("c", BSON("d" << i << "e" << BSON_ARRAY(1 << 2 << 3)));
+        }
+    }
+    return builder.obj();
+}
+
+// Sets a single field of a large document, after reading another one, and converts the result
+// back to BSON: the work done for each document by a pipeline such as
+// [{$addFields: {total: {$add: ['$field0.a', 1]}}}].
+void BM_AddFieldToBson(benchmark::State& state) {
+    const auto bson = makeLargeDocument(state.range(0));
+    for (auto _ : state) {
+        MutableDocument md{Document(bson)};
+        auto total = md.peek()["field0"]["a"].getInt() + 1;
+        md.addField("total", Value(total));
+        benchmark::DoNotOptimize(md.freeze().toBson());
+    }
+    state.SetBytesProcessed(state.iterations() * bson.objsize());
+}
+
+// Reads every field of a document by name, in reverse order.
+void BM_GetFieldsByName(benchmark::State& state) {
+    const auto bson = makeLargeDocument(state.range(0));
+    std::vector<std::string> names;
+    for (auto&& elem : bson) {
+        names.push_back(elem.fieldName());
+    }
+
+    for (auto _ : state) {
+        Document doc(bson);
+        for (auto name = names.rbegin(); name != names.rend(); ++name) {
+            benchmark::DoNotOptimize(doc[*name]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+
+BENCHMARK(BM_AddFieldToBson)->Arg(10)->Arg(100);
+BENCHMARK(BM_GetFieldsByName)->Arg(10)->Arg(100)->Arg(1000);
+
+}  // namespace
+}  // namespace mongo
@@ -33,6 +33,8 @@
 
 #include <bitset>
 #include <boost/intrusive_ptr.hpp>
+#include <memory>
+#include <vector>
 
 #include "mongo/base/static_assert.h"
 #include "mongo/db/exec/document_value/document_metadata_fields.h"
@@ -275,6 +277,28 @@ private:
     const ValueElement* _end;
 };
 
+/**
+ * Maps the names of the top-level fields of a BSON object to their elements, so that looking up
+ * fields which have not been cached yet does not rescan the object each time. It is built in a
+ * single pass and records offsets into the object rather than pointers, so it stays valid for any
+ * copy of the same bytes, such as the result of BSONObj::getOwned().
+ */
+class BSONFieldIndex {
+public:
+    explicit BSONFieldIndex(const BSONObj& obj);
+
+    /**
+     * Returns the first element of 'obj' named 'name', or an EOO element if there is none. 'obj'
+     * must hold the same bytes as the object the index was built from.
+     */
+    BSONElement find(const BSONObj& obj, StringData name) const;
+
+private:
+    // An open addressing table of element offsets plus one, with zero marking an empty slot.
+    std::vector<uint32_t> _slots;
+    uint32_t _mask{0};
+};
+
 /// Storage class used by both Document and MutableDocument
 class DocumentStorage : public RefCountable {
 public:
@@ -363,10 +387,8 @@ public:
             return {getField(pos).val};
         }
 
-        for (auto&& bsonElement : _bson) {
-            if (name == bsonElement.fieldNameStringData()) {
-                return {bsonElement};
-            }
+        if (auto bsonElement = findFieldInBson(name)) {
+            return {bsonElement};
         }
 
         // Field not found. Return EOO Value.
@@ -496,6 +518,9 @@ private:
     /// Returns the position of the named field in the cache or Position()
     Position findFieldInCache(StringData name) const;
 
+    /// Returns the named element of the backing BSON or an EOO element
+    BSONElement findFieldInBson(StringData name) const;
+
     /// Allocates space in _cache. Copies existing data if there is any.
     void alloc(unsigned newSize);
 
@@ -537,6 +562,8 @@ private:
         HASH_TAB_INIT_SIZE = 8,  // must be power of 2
         HASH_TAB_MIN = 4,        // don't hash fields for docs smaller than this
                                  // set to 1 to always hash
+        // index the BSON once lookups of uncached fields have stepped over this many elements
+        BSON_INDEX_MIN_SCANNED = 64,
     };
 
     // _cache layout:
@@ -565,6 +592,11 @@ private:
 
     BSONObj _bson;
 
+    // Built lazily once lookups of uncached fields have scanned enough of '_bson'. It is immutable,
+    // so clones of this storage, which share '_bson', share it too.
+    mutable std::shared_ptr<const BSONFieldIndex> _bsonIndex;
+    mutable unsigned _bsonElementsScanned = 0;
+
     // If '_stripMetadata' is true, tracks whether or not the metadata has been lazy-loaded from the
     // backing '_bson' object. If so, then no attempt will be made to load the metadata again, even
     // if the metadata has been released by a call to 'releaseMetadata()'.
@@ -176,6 +176,50 @@ TEST(DocumentSerialization, CannotSerializeDocumentThatExceedsDepthLimit) {
     throwaway.abandon();
 }
 
+TEST(DocumentSerialization, UnmodifiedSubdocumentsSerializeAsTheOriginalBson) {
+    BSONObj bson = fromjson("{a: {b: 1, c: {d: 2}}, e: {f: [1, {g: 3}]}, x: 1}");
+    MutableDocument md(fromBson(bson));
+
+    // Reading a subdocument caches it in the parent without modifying it.
+    ASSERT_VALUE_EQ(md.peek()["a"]["c"]["d"], Value(2));
+    md["x"] = Value(2);
+    ASSERT_BSONOBJ_BINARY_EQ(md.peek().toBson(),
+                             fromjson("{a: {b: 1, c: {d: 2}}, e: {f: [1, {g: 3}]}, x: 2}"));
+
+    // Modifying a nested field must not be hidden by its unmodified original.
+    md.setNestedField("e.h", Value(4));
+    md.setNestedField("a.c.d", Value(5));
+    ASSERT_BSONOBJ_BINARY_EQ(md.freeze().toBson(),
+                             fromjson("{a: {b: 1, c: {d: 5}}, e: {f: [1, {g: 3}], h: 4}, x: 2}"));
+}
+
+TEST(DocumentGetField, LookupsInLargeDocumentsMatchAScanOfTheBson) {
+    BSONObjBuilder builder;
+    for (int i = 0; i < 200; ++i) {
+        builder.append(str::stream() << "f" << i, i);
+    }
+    // Lookups return the first of several fields with the same name.
+    builder.append("f7", -1);
+    Document document = fromBson(builder.obj());
+
+    // Looking up the fields from the last one forces enough scanning of the BSON to index it.
+    for (int i = 199; i >= 0; --i) {
+        ASSERT_VALUE_EQ(document[str::stream() << "f" << i], Value(i));
+    }
+    ASSERT_VALUE_EQ(document["f7"], Value(7));
+    ASSERT_TRUE(document["f200"].missing());
+
+    auto valueVariant = document.getNestedFieldNonCaching("f7");
+    ASSERT_TRUE(stdx::holds_alternative<Value>(valueVariant));
+    ASSERT_VALUE_EQ(stdx::get<Value>(valueVariant), Value(7));
+
+    // A copy of the document shares the index of the original.
+    MutableDocument md(document);
+    md["f0"] = Value(-2);
+    ASSERT_VALUE_EQ(md.peek()["f100"], Value(100));
+    ASSERT_TRUE(md.peek()["nonexistent"].missing());
+}
+
 TEST(DocumentGetFieldNonCaching, UncachedTopLevelFields) {
     BSONObj bson = BSON("scalar" << 1 << "array" << BSON_ARRAY(1 << 2 << 3) << "scalar2" << true);
     Document document = fromBson(bson);
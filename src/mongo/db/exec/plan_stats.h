@@ -37,6 +37,7 @@
 #include "mongo/db/index/multikey_paths.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/stage_types.h"
+#include "mongo/db/sorter/sorter_stats.h"
 #include "mongo/util/container_size_helper.h"
 #include "mongo/util/time_support.h"
 
@@ -637,6 +638,9 @@ struct SortStats : public SpecificStats {
 
     // Whether we spilled data to disk during the execution of this query.
     bool wasDiskUsed = false;
+
+    // The amount of data spilled to disk, and the time spent reading it back while merging.
+    SorterFileStats spillStats;
 };
 
 struct MergeSortStats : public SpecificStats {
@@ -394,6 +394,37 @@ static stdx::unordered_map<std::string, BuiltinFn> kBuiltinFunctions = {
     {"tanh", BuiltinFn{[](size_t n) { return n == 1; }, vm::Builtin::tanh, false}},
     {"concat", BuiltinFn{[](size_t n) { return n > 0; }, vm::Builtin::concat, false}},
     {"isMember", BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::isMember, false}},
+    {"valueBlockAdd",
+     BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockAdd, false}},
+    {"valueBlockSub",
+     BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockSub, false}},
+    {"valueBlockMul",
+     BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockMul, false}},
+    {"valueBlockGt", BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockGt, false}},
+    {"valueBlockGte",
+     BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockGte, false}},
+    {"valueBlockLt", BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockLt, false}},
+    {"valueBlockLte",
+     BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockLte, false}},
+    {"valueBlockEq", BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockEq, false}},
+    {"valueBlockNeq",
+     BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockNeq, false}},
+    {"valueBlockLogicalAnd",
+     BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockLogicalAnd, false}},
+    {"valueBlockLogicalOr",
+     BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockLogicalOr, false}},
+    {"valueBlockGetField",
+     BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockGetField, false}},
+    {"valueBlockFillEmpty",
+     BuiltinFn{[](size_t n) { return n == 2; }, vm::Builtin::valueBlockFillEmpty, false}},
+    {"valueBlockAggSum",
+     BuiltinFn{[](size_t n) { return n == 1 || n == 2; }, vm::Builtin::valueBlockAggSum, true}},
+    {"valueBlockAggMin",
+     BuiltinFn{[](size_t n) { return n == 1 || n == 2; }, vm::Builtin::valueBlockAggMin, true}},
+    {"valueBlockAggMax",
+     BuiltinFn{[](size_t n) { return n == 1 || n == 2; }, vm::Builtin::valueBlockAggMax, true}},
+    {"valueBlockAggCount",
+     BuiltinFn{[](size_t n) { return n == 1 || n == 2; }, vm::Builtin::valueBlockAggCount, true}},
 };
 
 /**
@@ -773,6 +804,13 @@ value::SlotId RuntimeEnvironment::getSlot(StringData type) {
     uasserted(4946305, str::stream() << "environment slot is not registered for type: " << type);
 }
 
+boost::optional<value::SlotId> RuntimeEnvironment::getSlotIfExists(StringData type) const {
+    if (auto it = _state->slots.find(type); it != _state->slots.end()) {
+        return it->second.first;
+    }
+    return boost::none;
+}
+
 void RuntimeEnvironment::resetSlot(value::SlotId slot,
                                    value::TypeTags tag,
                                    value::Value val,
@@ -806,6 +844,29 @@ std::unique_ptr<RuntimeEnvironment> RuntimeEnvironment::makeCopy(bool isSmp) {
     return std::unique_ptr<RuntimeEnvironment>(new RuntimeEnvironment(*this));
 }
 
+std::unique_ptr<RuntimeEnvironment> RuntimeEnvironment::makeDeepCopy() const {
+    auto env = std::make_unique<RuntimeEnvironment>();
+    auto& state = *env->_state;
+
+    state.slots = _state->slots;
+    state.typeTags.reserve(_state->vals.size());
+    state.vals.reserve(_state->vals.size());
+    state.owned.reserve(_state->vals.size());
+    for (size_t idx = 0; idx < _state->vals.size(); ++idx) {
+        auto [tag, val] = _state->owned[idx]
+            ? value::copyValue(_state->typeTags[idx], _state->vals[idx])
+            : std::make_pair(_state->typeTags[idx], _state->vals[idx]);
+        state.typeTags.push_back(tag);
+        state.vals.push_back(val);
+        state.owned.push_back(_state->owned[idx]);
+    }
+
+    for (auto&& [type, slot] : state.slots) {
+        env->emplaceAccessor(slot.first, slot.second);
+    }
+    return env;
+}
+
 void RuntimeEnvironment::debugString(StringBuilder* builder) {
     *builder << "env: { ";
     for (auto&& [type, slot] : _state->slots) {
@@ -92,6 +92,12 @@ public:
      */
     value::SlotId getSlot(StringData type);
 
+    /**
+     * Returns a SlotId registered for the given slot 'type', or boost::none if the slot hasn't been
+     * registered yet.
+     */
+    boost::optional<value::SlotId> getSlotIfExists(StringData type) const;
+
     /**
      * Store the given value in the specified slot within this runtime environment instance.
      *
@@ -118,6 +124,13 @@ public:
      */
     std::unique_ptr<RuntimeEnvironment> makeCopy(bool isSmp);
 
+    /**
+     * Make a copy of this environment which does not share any data with it: the values of owned
+     * slots are copied, so a slot can be reset in either environment without affecting the other.
+     * The copy is a serial environment.
+     */
+    std::unique_ptr<RuntimeEnvironment> makeDeepCopy() const;
+
     /**
      * Dumps all the slots currently defined in this environment into the given string builder.
      */
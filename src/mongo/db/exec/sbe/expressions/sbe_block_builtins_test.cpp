@@ -0,0 +1,192 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/exec/sbe/expression_test_base.h"
+
+namespace mongo::sbe {
+
+class SBEBlockBuiltinsTest : public EExpressionTestFixture {
+protected:
+    using TypedValue = std::pair<value::TypeTags, value::Value>;
+
+    static TypedValue makeInt32(int32_t i) {
+        return {value::TypeTags::NumberInt32, value::bitcastFrom<int32_t>(i)};
+    }
+
+    static TypedValue makeDouble(double d) {
+        return {value::TypeTags::NumberDouble, value::bitcastFrom<double>(d)};
+    }
+
+    static TypedValue makeBool(bool b) {
+        return {value::TypeTags::Boolean, value::bitcastFrom<bool>(b)};
+    }
+
+    static TypedValue makeNothing() {
+        return {value::TypeTags::Nothing, 0};
+    }
+
+    /**
+     * Builds an owned block from shallow values.
+     */
+    static TypedValue makeBlock(const std::vector<TypedValue>& values) {
+        auto [tag, val] = value::makeNewValueBlock();
+        auto block = value::getValueBlockView(val);
+        for (auto [elemTag, elemVal] : values) {
+            block->push_back(elemTag, elemVal);
+        }
+        return {tag, val};
+    }
+
+    /**
+     * Runs the binary builtin 'name' over the given arguments, which are owned by the caller, and
+     * checks that the result is a block equal to 'expected'.
+     */
+    void runAndAssertBlock(const std::string& name,
+                           TypedValue lhs,
+                           TypedValue rhs,
+                           const std::vector<TypedValue>& expected) {
+        value::OwnedValueAccessor lhsAccessor;
+        auto lhsSlot = bindAccessor(&lhsAccessor);
+        value::OwnedValueAccessor rhsAccessor;
+        auto rhsSlot = bindAccessor(&rhsAccessor);
+        lhsAccessor.reset(lhs.first, lhs.second);
+        rhsAccessor.reset(rhs.first, rhs.second);
+
+        auto expr = makeE<EFunction>(
+            name, makeEs(makeE<EVariable>(lhsSlot), makeE<EVariable>(rhsSlot)));
+        auto compiledExpr = compileExpression(*expr);
+        auto [resTag, resVal] = runCompiledExpression(compiledExpr.get());
+        value::ValueGuard guard{resTag, resVal};
+
+        ASSERT_EQ(value::TypeTags::valueBlock, resTag);
+        auto block = value::getValueBlockView(resVal);
+        ASSERT_EQ(expected.size(), block->size());
+        for (size_t idx = 0; idx < expected.size(); ++idx) {
+            auto [tag, val] = block->getAt(idx);
+            ASSERT_EQ(expected[idx].first, tag) << "at position " << idx;
+            if (tag != value::TypeTags::Nothing) {
+                auto [cmpTag, cmpVal] =
+                    value::compareValue(tag, val, expected[idx].first, expected[idx].second);
+                ASSERT_EQ(value::TypeTags::NumberInt32, cmpTag);
+                ASSERT_EQ(0, value::bitcastTo<int32_t>(cmpVal)) << "at position " << idx;
+            }
+        }
+    }
+};
+
+TEST_F(SBEBlockBuiltinsTest, AddDoubleBlocks) {
+    runAndAssertBlock("valueBlockAdd",
+                      makeBlock({makeDouble(1.5), makeDouble(2.0), makeDouble(-3.0)}),
+                      makeBlock({makeDouble(1.0), makeDouble(0.5), makeDouble(3.0)}),
+                      {makeDouble(2.5), makeDouble(2.5), makeDouble(0.0)});
+}
+
+TEST_F(SBEBlockBuiltinsTest, ArithmeticWithMixedTypesAndNothing) {
+    runAndAssertBlock("valueBlockAdd",
+                      makeBlock({makeInt32(1), makeNothing(), makeDouble(2.5)}),
+                      makeInt32(10),
+                      {makeInt32(11), makeNothing(), makeDouble(12.5)});
+    runAndAssertBlock("valueBlockSub",
+                      makeInt32(10),
+                      makeBlock({makeInt32(1), makeDouble(0.5)}),
+                      {makeInt32(9), makeDouble(9.5)});
+    runAndAssertBlock("valueBlockMul",
+                      makeBlock({makeDouble(1.5), makeDouble(2.0)}),
+                      makeDouble(2.0),
+                      {makeDouble(3.0), makeDouble(4.0)});
+}
+
+TEST_F(SBEBlockBuiltinsTest, MismatchedBlockSizesProduceNothing) {
+    value::OwnedValueAccessor lhsAccessor;
+    auto lhsSlot = bindAccessor(&lhsAccessor);
+    auto [lhsTag, lhsVal] = makeBlock({makeInt32(1), makeInt32(2)});
+    lhsAccessor.reset(lhsTag, lhsVal);
+
+    auto [otherTag, otherVal] = makeBlock({makeInt32(1)});
+    auto mismatched = makeE<EFunction>(
+        "valueBlockAdd",
+        makeEs(makeE<EVariable>(lhsSlot), makeE<EConstant>(otherTag, otherVal)));
+    auto compiledMismatched = compileExpression(*mismatched);
+    auto [misTag, misVal] = runCompiledExpression(compiledMismatched.get());
+    value::ValueGuard misGuard{misTag, misVal};
+    ASSERT_EQ(value::TypeTags::Nothing, misTag);
+}
+
+TEST_F(SBEBlockBuiltinsTest, Comparisons) {
+    runAndAssertBlock("valueBlockGt",
+                      makeBlock({makeInt32(1), makeInt32(5), makeNothing()}),
+                      makeInt32(3),
+                      {makeBool(false), makeBool(true), makeNothing()});
+    runAndAssertBlock("valueBlockLte",
+                      makeBlock({makeInt32(1), makeDouble(3.0), makeInt32(4)}),
+                      makeInt32(3),
+                      {makeBool(true), makeBool(true), makeBool(false)});
+    runAndAssertBlock("valueBlockEq",
+                      makeBlock({makeInt32(3), makeDouble(3.0), makeInt32(4)}),
+                      makeInt32(3),
+                      {makeBool(true), makeBool(true), makeBool(false)});
+}
+
+TEST_F(SBEBlockBuiltinsTest, LogicalOperators) {
+    runAndAssertBlock("valueBlockLogicalAnd",
+                      makeBlock({makeBool(true), makeBool(true), makeBool(false), makeNothing()}),
+                      makeBlock({makeBool(true), makeBool(false), makeNothing(), makeBool(true)}),
+                      {makeBool(true), makeBool(false), makeBool(false), makeNothing()});
+    runAndAssertBlock("valueBlockLogicalOr",
+                      makeBlock({makeBool(false), makeBool(false), makeBool(true), makeNothing()}),
+                      makeBlock({makeBool(true), makeBool(false), makeNothing(), makeBool(false)}),
+                      {makeBool(true), makeBool(false), makeBool(true), makeNothing()});
+}
+
+TEST_F(SBEBlockBuiltinsTest, FillEmpty) {
+    runAndAssertBlock("valueBlockFillEmpty",
+                      makeBlock({makeInt32(1), makeNothing(), makeInt32(3)}),
+                      makeInt32(0),
+                      {makeInt32(1), makeInt32(0), makeInt32(3)});
+}
+
+TEST_F(SBEBlockBuiltinsTest, GetField) {
+    auto obj1 = BSON("a" << 1 << "b" << 2.5);
+    auto obj2 = BSON("b" << 3);
+    auto obj3 = BSON("a" << 4);
+
+    // The block only holds views of the objects, so it must not own them.
+    auto [blockTag, blockVal] = value::makeNewValueBlock(false);
+    auto block = value::getValueBlockView(blockVal);
+    for (auto& obj : {obj1, obj2, obj3}) {
+        block->push_back(value::TypeTags::bsonObject, value::bitcastFrom(obj.objdata()));
+    }
+
+    auto [fieldTag, fieldVal] = value::makeNewString("b");
+    runAndAssertBlock("valueBlockGetField",
+                      {blockTag, blockVal},
+                      {fieldTag, fieldVal},
+                      {makeDouble(2.5), makeInt32(3), makeNothing()});
+}
+}  // namespace mongo::sbe
@@ -860,6 +860,9 @@ void Parser::walkGroup(AstQuery& ast) {
     ast.stage = makeS<HashAggStage>(std::move(ast.nodes[2]->stage),
                                     lookupSlots(std::move(ast.nodes[0]->identifiers)),
                                     lookupSlots(std::move(ast.nodes[1]->projects)),
+                                    makeEM(),
+                                    boost::none,
+                                    false,
                                     kEmptyPlanNodeId);
 }
 
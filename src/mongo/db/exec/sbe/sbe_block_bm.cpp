@@ -0,0 +1,217 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * Compares row-at-a-time execution of a filter/project/group pipeline with the same pipeline
+ * evaluated block-at-a-time using RowToBlockStage, the 'valueBlock*' builtins and
+ * BlockToRowStage.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/exec/sbe/stages/block_to_row.h"
+#include "mongo/db/exec/sbe/stages/bson_scan.h"
+#include "mongo/db/exec/sbe/stages/filter.h"
+#include "mongo/db/exec/sbe/stages/hash_agg.h"
+#include "mongo/db/exec/sbe/stages/project.h"
+#include "mongo/db/exec/sbe/stages/row_to_block.h"
+
+namespace mongo::sbe {
+namespace {
+
+constexpr size_t kBlockSize = 1024;
+constexpr int kNumGroups = 16;
+
+/**
+ * Generates 'numDocs' documents of the form {a: <double>, b: <double>, g: <int>} laid out
+ * back-to-back, as BSONScanStage expects.
+ */
+BufBuilder makeDocuments(int numDocs) {
+    BufBuilder buf;
+    for (int i = 0; i < numDocs; ++i) {
+        auto obj = BSON("a" << (i % 100) * 0.01 << "b" << i * 0.5 << "g" << i % kNumGroups);
+        buf.appendBuf(obj.objdata(), obj.objsize());
+    }
+    return buf;
+}
+
+std::unique_ptr<EExpression> makeDouble(double d) {
+    return makeE<EConstant>(value::TypeTags::NumberDouble, value::bitcastFrom<double>(d));
+}
+
+/**
+ * Builds the plan for "match a > 0.5, then group by g (or everything if 'grouped' is false) and
+ * sum a * b" evaluated row by row. Returns the plan and the slot holding the sum.
+ */
+std::pair<std::unique_ptr<PlanStage>, value::SlotId> makeRowPlan(const BufBuilder& docs,
+                                                                 value::SlotIdGenerator& ids,
+                                                                 bool grouped) {
+    auto a = ids.generate(), b = ids.generate(), g = ids.generate();
+    auto product = ids.generate(), sum = ids.generate();
+
+    auto scan = makeS<BSONScanStage>(docs.buf(),
+                                     docs.buf() + docs.len(),
+                                     boost::none,
+                                     std::vector<std::string>{"a", "b", "g"},
+                                     makeSV(a, b, g),
+                                     kEmptyPlanNodeId);
+    auto filter = makeS<FilterStage<false>>(
+        std::move(scan),
+        makeE<EPrimBinary>(EPrimBinary::greater, makeE<EVariable>(a), makeDouble(0.5)),
+        kEmptyPlanNodeId);
+    auto project = makeProjectStage(
+        std::move(filter),
+        kEmptyPlanNodeId,
+        product,
+        makeE<EPrimBinary>(EPrimBinary::mul, makeE<EVariable>(a), makeE<EVariable>(b)));
+    auto agg = makeS<HashAggStage>(
+        std::move(project),
+        grouped ? makeSV(g) : makeSV(),
+        makeEM(sum, makeE<EFunction>("sum", makeEs(makeE<EVariable>(product)))),
+        makeEM(),
+        boost::none,
+        false,
+        kEmptyPlanNodeId);
+    return {std::move(agg), sum};
+}
+
+/**
+ * Builds the same plan as makeRowPlan(), but evaluates the predicate and the product on blocks of
+ * 'kBlockSize' rows. The grouped variant converts back to rows before the group, whereas the
+ * ungrouped one aggregates the blocks directly.
+ */
+std::pair<std::unique_ptr<PlanStage>, value::SlotId> makeBlockPlan(const BufBuilder& docs,
+                                                                   value::SlotIdGenerator& ids,
+                                                                   bool grouped) {
+    auto a = ids.generate(), b = ids.generate(), g = ids.generate();
+    auto aBlock = ids.generate(), bBlock = ids.generate(), gBlock = ids.generate();
+    auto bitmap = ids.generate(), productBlock = ids.generate(), sum = ids.generate();
+
+    auto scan = makeS<BSONScanStage>(docs.buf(),
+                                     docs.buf() + docs.len(),
+                                     boost::none,
+                                     std::vector<std::string>{"a", "b", "g"},
+                                     makeSV(a, b, g),
+                                     kEmptyPlanNodeId);
+    auto toBlock = makeS<RowToBlockStage>(std::move(scan),
+                                          makeSV(a, b, g),
+                                          makeSV(aBlock, bBlock, gBlock),
+                                          kBlockSize,
+                                          kEmptyPlanNodeId);
+    auto project = makeProjectStage(
+        std::move(toBlock),
+        kEmptyPlanNodeId,
+        bitmap,
+        makeE<EFunction>("valueBlockGt", makeEs(makeE<EVariable>(aBlock), makeDouble(0.5))),
+        productBlock,
+        makeE<EFunction>("valueBlockMul",
+                         makeEs(makeE<EVariable>(aBlock), makeE<EVariable>(bBlock))));
+
+    if (!grouped) {
+        auto agg = makeS<HashAggStage>(
+            std::move(project),
+            makeSV(),
+            makeEM(sum,
+                   makeE<EFunction>("valueBlockAggSum",
+                                    makeEs(makeE<EVariable>(productBlock),
+                                           makeE<EVariable>(bitmap)))),
+            makeEM(),
+            boost::none,
+            false,
+            kEmptyPlanNodeId);
+        return {std::move(agg), sum};
+    }
+
+    auto product = ids.generate(), groupKey = ids.generate();
+    auto toRow = makeS<BlockToRowStage>(std::move(project),
+                                        makeSV(gBlock, productBlock),
+                                        makeSV(groupKey, product),
+                                        bitmap,
+                                        kEmptyPlanNodeId);
+    auto agg = makeS<HashAggStage>(
+        std::move(toRow),
+        makeSV(groupKey),
+        makeEM(sum, makeE<EFunction>("sum", makeEs(makeE<EVariable>(product)))),
+        makeEM(),
+        boost::none,
+        false,
+        kEmptyPlanNodeId);
+    return {std::move(agg), sum};
+}
+
+template <typename MakePlanFn>
+void runPlan(benchmark::State& state, MakePlanFn makePlan, bool grouped) {
+    const int numDocs = state.range(0);
+    auto docs = makeDocuments(numDocs);
+
+    value::SlotIdGenerator ids;
+    auto [root, sumSlot] = makePlan(docs, ids, grouped);
+    CompileCtx ctx{std::make_unique<RuntimeEnvironment>()};
+    root->prepare(ctx);
+    auto sumAccessor = root->getAccessor(ctx, sumSlot);
+
+    for (auto _ : state) {
+        root->open(false);
+        size_t groups = 0;
+        while (root->getNext() == PlanState::ADVANCED) {
+            benchmark::DoNotOptimize(sumAccessor->getViewOfValue());
+            ++groups;
+        }
+        root->close();
+        invariant(groups == (grouped ? kNumGroups : 1));
+    }
+    state.SetItemsProcessed(state.iterations() * numDocs);
+}
+
+void BM_RowGroupedSum(benchmark::State& state) {
+    runPlan(state, makeRowPlan, true);
+}
+
+void BM_BlockGroupedSum(benchmark::State& state) {
+    runPlan(state, makeBlockPlan, true);
+}
+
+void BM_RowSum(benchmark::State& state) {
+    runPlan(state, makeRowPlan, false);
+}
+
+void BM_BlockSum(benchmark::State& state) {
+    runPlan(state, makeBlockPlan, false);
+}
+
+BENCHMARK(BM_RowGroupedSum)->Arg(10 * 1000)->Arg(100 * 1000);
+BENCHMARK(BM_BlockGroupedSum)->Arg(10 * 1000)->Arg(100 * 1000);
+BENCHMARK(BM_RowSum)->Arg(10 * 1000)->Arg(100 * 1000);
+BENCHMARK(BM_BlockSum)->Arg(10 * 1000)->Arg(100 * 1000);
+
+}  // namespace
+}  // namespace mongo::sbe
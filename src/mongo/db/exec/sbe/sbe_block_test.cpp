@@ -0,0 +1,211 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for the block-at-a-time stages sbe::RowToBlockStage and
+ * sbe::BlockToRowStage, and for the value::ValueBlock type they exchange.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/sbe_plan_stage_test.h"
+#include "mongo/db/exec/sbe/stages/block_to_row.h"
+#include "mongo/db/exec/sbe/stages/hash_agg.h"
+#include "mongo/db/exec/sbe/stages/project.h"
+#include "mongo/db/exec/sbe/stages/row_to_block.h"
+#include "mongo/util/bufreader.h"
+
+namespace mongo::sbe {
+
+using BlockStageTest = PlanStageTestFixture;
+
+TEST_F(BlockStageTest, RowToBlockToRowRoundTrip) {
+    auto [inputTag, inputVal] = makeValue(BSON_ARRAY(1 << "two" << 3.5 << BSON("a" << 4) << 5LL));
+    value::ValueGuard inputGuard{inputTag, inputVal};
+
+    auto [expectedTag, expectedVal] = value::copyValue(inputTag, inputVal);
+    value::ValueGuard expectedGuard{expectedTag, expectedVal};
+
+    auto makeStageFn = [this](value::SlotId scanSlot, std::unique_ptr<PlanStage> scanStage) {
+        auto blockSlot = generateSlotId();
+        auto outSlot = generateSlotId();
+
+        // Use a block size which does not divide the input, so the last block is partial.
+        auto rowToBlock = makeS<RowToBlockStage>(
+            std::move(scanStage), makeSV(scanSlot), makeSV(blockSlot), 2, kEmptyPlanNodeId);
+        auto blockToRow = makeS<BlockToRowStage>(std::move(rowToBlock),
+                                                 makeSV(blockSlot),
+                                                 makeSV(outSlot),
+                                                 boost::none,
+                                                 kEmptyPlanNodeId);
+
+        return std::make_pair(outSlot, std::move(blockToRow));
+    };
+
+    inputGuard.reset();
+    expectedGuard.reset();
+    runTest(inputTag, inputVal, expectedTag, expectedVal, makeStageFn);
+}
+
+TEST_F(BlockStageTest, BitmapFiltersRows) {
+    auto [inputTag, inputVal] = makeValue(BSON_ARRAY(1 << 7 << 3 << 9 << 2 << 10 << 4));
+    value::ValueGuard inputGuard{inputTag, inputVal};
+
+    auto [expectedTag, expectedVal] = makeValue(BSON_ARRAY(7 << 9 << 10 << 4));
+    value::ValueGuard expectedGuard{expectedTag, expectedVal};
+
+    auto makeStageFn = [this](value::SlotId scanSlot, std::unique_ptr<PlanStage> scanStage) {
+        auto blockSlot = generateSlotId();
+        auto bitmapSlot = generateSlotId();
+        auto outSlot = generateSlotId();
+
+        auto rowToBlock = makeS<RowToBlockStage>(
+            std::move(scanStage), makeSV(scanSlot), makeSV(blockSlot), 3, kEmptyPlanNodeId);
+        auto project = makeProjectStage(
+            std::move(rowToBlock),
+            kEmptyPlanNodeId,
+            bitmapSlot,
+            makeE<EFunction>("valueBlockGt",
+                             makeEs(makeE<EVariable>(blockSlot),
+                                    makeE<EConstant>(value::TypeTags::NumberInt32,
+                                                     value::bitcastFrom<int32_t>(3)))));
+        auto blockToRow = makeS<BlockToRowStage>(
+            std::move(project), makeSV(blockSlot), makeSV(outSlot), bitmapSlot, kEmptyPlanNodeId);
+
+        return std::make_pair(outSlot, std::move(blockToRow));
+    };
+
+    inputGuard.reset();
+    expectedGuard.reset();
+    runTest(inputTag, inputVal, expectedTag, expectedVal, makeStageFn);
+}
+
+TEST_F(BlockStageTest, BlockAggregatesOverAllBlocks) {
+    BSONArrayBuilder inputBuilder;
+    double expectedSum = 0;
+    for (int i = 0; i < 100; ++i) {
+        inputBuilder.append(i * 0.5);
+        expectedSum += i * 0.5;
+    }
+    auto [scanSlot, scanStage] = generateMockScan(inputBuilder.arr());
+
+    auto blockSlot = generateSlotId();
+    auto sumSlot = generateSlotId();
+    auto minSlot = generateSlotId();
+    auto countSlot = generateSlotId();
+    auto rowToBlock = makeS<RowToBlockStage>(
+        std::move(scanStage), makeSV(scanSlot), makeSV(blockSlot), 16, kEmptyPlanNodeId);
+    auto stage = makeS<HashAggStage>(
+        std::move(rowToBlock),
+        makeSV(),
+        makeEM(sumSlot,
+               makeE<EFunction>("valueBlockAggSum", makeEs(makeE<EVariable>(blockSlot))),
+               minSlot,
+               makeE<EFunction>("valueBlockAggMin", makeEs(makeE<EVariable>(blockSlot))),
+               countSlot,
+               makeE<EFunction>("valueBlockAggCount", makeEs(makeE<EVariable>(blockSlot)))),
+        makeEM(),
+        boost::none,
+        false,
+        kEmptyPlanNodeId);
+
+    auto accessors = prepareTree(stage.get(), makeSV(sumSlot, minSlot, countSlot));
+    ASSERT_TRUE(stage->getNext() == PlanState::ADVANCED);
+
+    auto [sumTag, sumVal] = accessors[0]->getViewOfValue();
+    ASSERT_EQ(value::TypeTags::NumberDouble, sumTag);
+    ASSERT_EQ(expectedSum, value::bitcastTo<double>(sumVal));
+
+    auto [minTag, minVal] = accessors[1]->getViewOfValue();
+    ASSERT_EQ(value::TypeTags::NumberDouble, minTag);
+    ASSERT_EQ(0.0, value::bitcastTo<double>(minVal));
+
+    auto [countTag, countVal] = accessors[2]->getViewOfValue();
+    ASSERT_EQ(value::TypeTags::NumberInt64, countTag);
+    ASSERT_EQ(100, value::bitcastTo<int64_t>(countVal));
+
+    ASSERT_TRUE(stage->getNext() == PlanState::IS_EOF);
+    stage->close();
+}
+
+TEST_F(BlockStageTest, BlockToRowRejectsNonBlockInput) {
+    auto [scanSlot, scanStage] = generateMockScan(BSON_ARRAY(1 << 2));
+    auto outSlot = generateSlotId();
+    auto stage = makeS<BlockToRowStage>(
+        std::move(scanStage), makeSV(scanSlot), makeSV(outSlot), boost::none, kEmptyPlanNodeId);
+
+    prepareTree(stage.get(), outSlot);
+    ASSERT_THROWS_CODE(stage->getNext(), AssertionException, 5150803);
+    stage->close();
+}
+
+TEST(ValueBlockTest, HashCompareAndSerialize) {
+    auto makeBlock = [](std::vector<int64_t> elems) {
+        auto [tag, val] = value::makeNewValueBlock();
+        for (auto elem : elems) {
+            value::getValueBlockView(val)->push_back(value::TypeTags::NumberInt64,
+                                                     value::bitcastFrom<int64_t>(elem));
+        }
+        value::getValueBlockView(val)->push_back(value::TypeTags::Nothing, 0);
+        return std::make_pair(tag, val);
+    };
+    auto compare = [](std::pair<value::TypeTags, value::Value> lhs,
+                      std::pair<value::TypeTags, value::Value> rhs) {
+        auto [tag, val] = value::compareValue(lhs.first, lhs.second, rhs.first, rhs.second);
+        ASSERT(tag == value::TypeTags::NumberInt32);
+        return value::bitcastTo<int32_t>(val);
+    };
+
+    auto [tag, val] = makeBlock({1, 2});
+    value::ValueGuard guard{tag, val};
+    auto [equalTag, equalVal] = makeBlock({1, 2});
+    value::ValueGuard equalGuard{equalTag, equalVal};
+    auto [greaterTag, greaterVal] = makeBlock({1, 3});
+    value::ValueGuard greaterGuard{greaterTag, greaterVal};
+
+    ASSERT_EQ(0, compare({tag, val}, {equalTag, equalVal}));
+    ASSERT_EQ(value::hashValue(tag, val), value::hashValue(equalTag, equalVal));
+    ASSERT_EQ(-1, compare({tag, val}, {greaterTag, greaterVal}));
+    ASSERT_EQ(1, compare({greaterTag, greaterVal}, {tag, val}));
+    ASSERT_THROWS_CODE(compare({tag, val}, {value::TypeTags::NumberInt64, 0}),
+                       AssertionException,
+                       5150840);
+
+    value::MaterializedRow row{1};
+    row.reset(0, false, tag, val);
+    BufBuilder builder;
+    row.serializeForSorter(builder);
+    BufReader reader(builder.buf(), builder.len());
+    auto roundTripped = value::MaterializedRow::deserializeForSorter(reader, {});
+    auto [roundTrippedTag, roundTrippedVal] = roundTripped.getViewOfValue(0);
+    ASSERT(roundTrippedTag == value::TypeTags::valueBlock);
+    ASSERT_EQ(3U, value::getValueBlockView(roundTrippedVal)->size());
+    ASSERT_EQ(0, compare({tag, val}, {roundTrippedTag, roundTrippedVal}));
+}
+}  // namespace mongo::sbe
@@ -0,0 +1,87 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/stages/exchange.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo::sbe {
+namespace {
+
+TEST(ExchangeWorkerReservationTest, ReservesUpToTheBudget) {
+    const auto initial = ExchangeWorkerReservation::numReservedWorkers();
+    const auto budget = initial + 6;
+
+    auto first = ExchangeWorkerReservation::reserve(4, budget);
+    ASSERT_EQ(4u, first.numWorkers());
+
+    // Only two workers are left in the budget.
+    auto second = ExchangeWorkerReservation::reserve(4, budget);
+    ASSERT_EQ(2u, second.numWorkers());
+
+    auto third = ExchangeWorkerReservation::reserve(4, budget);
+    ASSERT_EQ(0u, third.numWorkers());
+    ASSERT_EQ(initial + 6, ExchangeWorkerReservation::numReservedWorkers());
+}
+
+TEST(ExchangeWorkerReservationTest, ReleasesWorkersWhenDestroyed) {
+    const auto initial = ExchangeWorkerReservation::numReservedWorkers();
+    const auto budget = initial + 4;
+
+    {
+        auto reservation = ExchangeWorkerReservation::reserve(4, budget);
+        ASSERT_EQ(4u, reservation.numWorkers());
+        ASSERT_EQ(0u, ExchangeWorkerReservation::reserve(1, budget).numWorkers());
+    }
+    ASSERT_EQ(initial, ExchangeWorkerReservation::numReservedWorkers());
+
+    auto reservation = ExchangeWorkerReservation::reserve(4, budget);
+    ASSERT_EQ(4u, reservation.numWorkers());
+}
+
+TEST(ExchangeWorkerReservationTest, MovingTransfersTheReservation) {
+    const auto initial = ExchangeWorkerReservation::numReservedWorkers();
+
+    ExchangeWorkerReservation target;
+    ASSERT_EQ(0u, target.numWorkers());
+    {
+        auto source = ExchangeWorkerReservation::reserve(3, initial + 3);
+        target = std::move(source);
+    }
+    ASSERT_EQ(3u, target.numWorkers());
+    ASSERT_EQ(initial + 3, ExchangeWorkerReservation::numReservedWorkers());
+
+    target = ExchangeWorkerReservation{};
+    ASSERT_EQ(initial, ExchangeWorkerReservation::numReservedWorkers());
+}
+
+}  // namespace
+}  // namespace mongo::sbe
@@ -0,0 +1,232 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <map>
+
+#include "mongo/db/exec/sbe/sbe_plan_stage_test.h"
+#include "mongo/db/exec/sbe/stages/hash_agg.h"
+#include "mongo/db/exec/trial_run_progress_tracker.h"
+#include "mongo/db/storage/storage_options.h"
+#include "mongo/unittest/temp_dir.h"
+
+namespace mongo::sbe {
+
+class HashAggStageTest : public PlanStageTestFixture {
+public:
+    void setUp() override {
+        PlanStageTestFixture::setUp();
+        _oldDbPath = storageGlobalParams.dbpath;
+        storageGlobalParams.dbpath = _tempDir.path();
+    }
+
+    void tearDown() override {
+        storageGlobalParams.dbpath = _oldDbPath;
+        PlanStageTestFixture::tearDown();
+    }
+
+    /**
+     * Builds a stage which groups the (key, value) pairs of 'input' by key and sums the values,
+     * then returns the sums produced by the stage keyed by group.
+     */
+    std::map<int32_t, int64_t> runSumGroup(const BSONArray& input,
+                                           boost::optional<size_t> memoryLimit,
+                                           bool allowDiskUse,
+                                           HashAggStats* statsOut = nullptr) {
+        auto [scanSlots, scanStage] = generateMockScanMulti(2, input);
+        auto sumSlot = generateSlotId();
+        auto stage = makeS<HashAggStage>(
+            std::move(scanStage),
+            makeSV(scanSlots[0]),
+            makeEM(sumSlot, makeE<EFunction>("sum", makeEs(makeE<EVariable>(scanSlots[1])))),
+            makeEM(sumSlot, makeE<EFunction>("sum", makeEs(makeE<EVariable>(sumSlot)))),
+            memoryLimit,
+            allowDiskUse,
+            kEmptyPlanNodeId);
+
+        auto accessors = prepareTree(stage.get(), makeSV(scanSlots[0], sumSlot));
+
+        std::map<int32_t, int64_t> results;
+        for (auto st = stage->getNext(); st == PlanState::ADVANCED; st = stage->getNext()) {
+            auto [keyTag, keyVal] = accessors[0]->getViewOfValue();
+            auto [sumTag, sumVal] = accessors[1]->getViewOfValue();
+            ASSERT_EQ(value::TypeTags::NumberInt32, keyTag);
+            ASSERT_EQ(value::TypeTags::NumberInt64, sumTag);
+
+            auto [it, inserted] = results.emplace(value::bitcastTo<int32_t>(keyVal),
+                                                  value::bitcastTo<int64_t>(sumVal));
+            ASSERT_TRUE(inserted);
+        }
+
+        if (statsOut) {
+            *statsOut = *static_cast<const HashAggStats*>(stage->getSpecificStats());
+        }
+        stage->close();
+        return results;
+    }
+
+private:
+    unittest::TempDir _tempDir{"sbe_hash_agg_test"};
+    std::string _oldDbPath;
+};
+
+TEST_F(HashAggStageTest, SumWithoutMemoryLimit) {
+    auto input = BSON_ARRAY(BSON_ARRAY(1 << 1LL) << BSON_ARRAY(2 << 10LL) << BSON_ARRAY(1 << 2LL)
+                                                 << BSON_ARRAY(3 << 100LL)
+                                                 << BSON_ARRAY(2 << 20LL));
+
+    HashAggStats stats;
+    auto results = runSumGroup(input, boost::none, false, &stats);
+
+    std::map<int32_t, int64_t> expected{{1, 3}, {2, 30}, {3, 100}};
+    ASSERT(results == expected);
+    ASSERT_FALSE(stats.usedDisk);
+    ASSERT_EQ(0u, stats.spills);
+}
+
+TEST_F(HashAggStageTest, SpillsAndMergesPartialAggregates) {
+    BSONArrayBuilder inputBuilder;
+    std::map<int32_t, int64_t> expected;
+    for (int i = 0; i < 1000; ++i) {
+        int32_t key = (i * 7) % 50;
+        inputBuilder.append(BSON_ARRAY(key << static_cast<long long>(i)));
+        expected[key] += i;
+    }
+
+    // A limit this small forces the hash table to be spilled many times, so that every key
+    // appears in several spilled runs.
+    HashAggStats stats;
+    auto results = runSumGroup(inputBuilder.arr(), 1024, true, &stats);
+
+    ASSERT(results == expected);
+    ASSERT_TRUE(stats.usedDisk);
+    ASSERT_GT(stats.spills, 1u);
+    ASSERT_GTE(stats.spilledRecords, expected.size());
+}
+
+TEST_F(HashAggStageTest, ExceedingMemoryLimitWithoutDiskUseFails) {
+    BSONArrayBuilder inputBuilder;
+    for (int i = 0; i < 1000; ++i) {
+        inputBuilder.append(BSON_ARRAY(i << 1LL));
+    }
+
+    ASSERT_THROWS_CODE(runSumGroup(inputBuilder.arr(), 1024, false),
+                       AssertionException,
+                       ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed);
+}
+
+TEST_F(HashAggStageTest, MinAndMaxCompareValuesOfDifferentTypes) {
+    // Numbers sort before strings, so the minimum is the smallest number and the maximum is the
+    // string, regardless of the order in which they arrive.
+    auto input = BSON_ARRAY(BSON_ARRAY(1 << 5) << BSON_ARRAY(1 << "a") << BSON_ARRAY(1 << 2.5)
+                                               << BSON_ARRAY(2 << "b") << BSON_ARRAY(2 << 7LL));
+    auto [scanSlots, scanStage] = generateMockScanMulti(2, input);
+    auto minSlot = generateSlotId();
+    auto maxSlot = generateSlotId();
+    auto stage = makeS<HashAggStage>(
+        std::move(scanStage),
+        makeSV(scanSlots[0]),
+        makeEM(minSlot,
+               makeE<EFunction>("min", makeEs(makeE<EVariable>(scanSlots[1]))),
+               maxSlot,
+               makeE<EFunction>("max", makeEs(makeE<EVariable>(scanSlots[1])))),
+        makeEM(minSlot,
+               makeE<EFunction>("min", makeEs(makeE<EVariable>(minSlot))),
+               maxSlot,
+               makeE<EFunction>("max", makeEs(makeE<EVariable>(maxSlot)))),
+        boost::none,
+        false,
+        kEmptyPlanNodeId);
+
+    auto accessors = prepareTree(stage.get(), makeSV(scanSlots[0], minSlot, maxSlot));
+
+    size_t numGroups = 0;
+    for (auto st = stage->getNext(); st == PlanState::ADVANCED; st = stage->getNext()) {
+        ++numGroups;
+        auto [keyTag, keyVal] = accessors[0]->getViewOfValue();
+        auto [minTag, minVal] = accessors[1]->getViewOfValue();
+        auto [maxTag, maxVal] = accessors[2]->getViewOfValue();
+        ASSERT_EQ(value::TypeTags::NumberInt32, keyTag);
+        if (value::bitcastTo<int32_t>(keyVal) == 1) {
+            ASSERT_EQ(value::TypeTags::NumberDouble, minTag);
+            ASSERT_EQ(2.5, value::bitcastTo<double>(minVal));
+            ASSERT_TRUE(value::isString(maxTag));
+            ASSERT_EQ("a", value::getStringView(maxTag, maxVal));
+        } else {
+            ASSERT_EQ(value::TypeTags::NumberInt64, minTag);
+            ASSERT_EQ(7, value::bitcastTo<int64_t>(minVal));
+            ASSERT_TRUE(value::isString(maxTag));
+            ASSERT_EQ("b", value::getStringView(maxTag, maxVal));
+        }
+    }
+    ASSERT_EQ(2u, numGroups);
+    stage->close();
+}
+
+TEST_F(HashAggStageTest, TrialRunEndsEarlyAndReopenStartsOver) {
+    auto input = BSON_ARRAY(BSON_ARRAY(1 << 1LL) << BSON_ARRAY(2 << 10LL) << BSON_ARRAY(1 << 2LL)
+                                                 << BSON_ARRAY(3 << 100LL));
+    auto [scanSlots, scanStage] = generateMockScanMulti(2, input);
+    auto sumSlot = generateSlotId();
+
+    // Allow only two input rows to be consumed during the trial run.
+    TrialRunProgressTracker tracker{size_t{2}, size_t{1000}};
+    auto stage = makeS<HashAggStage>(
+        std::move(scanStage),
+        makeSV(scanSlots[0]),
+        makeEM(sumSlot, makeE<EFunction>("sum", makeEs(makeE<EVariable>(scanSlots[1])))),
+        makeEM(sumSlot, makeE<EFunction>("sum", makeEs(makeE<EVariable>(sumSlot)))),
+        boost::none,
+        false,
+        kEmptyPlanNodeId,
+        &tracker);
+
+    ASSERT_THROWS_CODE(
+        prepareTree(stage.get()), AssertionException, ErrorCodes::QueryTrialRunCompleted);
+
+    // Once the trial run is over, reopening the stage must discard the partially built hash table
+    // and aggregate the whole input.
+    stage->close();
+    stage->open(true);
+    auto keyAccessor = stage->getAccessor(*compileCtx(), scanSlots[0]);
+    auto sumAccessor = stage->getAccessor(*compileCtx(), sumSlot);
+
+    std::map<int32_t, int64_t> results;
+    for (auto st = stage->getNext(); st == PlanState::ADVANCED; st = stage->getNext()) {
+        auto [keyTag, keyVal] = keyAccessor->getViewOfValue();
+        auto [sumTag, sumVal] = sumAccessor->getViewOfValue();
+        results.emplace(value::bitcastTo<int32_t>(keyVal), value::bitcastTo<int64_t>(sumVal));
+    }
+    stage->close();
+
+    std::map<int32_t, int64_t> expected{{1, 3}, {2, 10}, {3, 100}};
+    ASSERT(results == expected);
+}
+}  // namespace mongo::sbe
@@ -0,0 +1,186 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/stages/block_to_row.h"
+
+namespace mongo::sbe {
+BlockToRowStage::BlockToRowStage(std::unique_ptr<PlanStage> input,
+                                 value::SlotVector blockSlots,
+                                 value::SlotVector outSlots,
+                                 boost::optional<value::SlotId> bitmapSlot,
+                                 PlanNodeId planNodeId)
+    : PlanStage("blocktorow"_sd, planNodeId),
+      _blockSlots(std::move(blockSlots)),
+      _outSlots(std::move(outSlots)),
+      _bitmapSlot(bitmapSlot) {
+    invariant(_blockSlots.size() == _outSlots.size());
+    _children.emplace_back(std::move(input));
+}
+
+std::unique_ptr<PlanStage> BlockToRowStage::clone() const {
+    return std::make_unique<BlockToRowStage>(
+        _children[0]->clone(), _blockSlots, _outSlots, _bitmapSlot, _commonStats.nodeId);
+}
+
+void BlockToRowStage::prepare(CompileCtx& ctx) {
+    _children[0]->prepare(ctx);
+
+    value::SlotSet dupCheck;
+    for (size_t idx = 0; idx < _outSlots.size(); ++idx) {
+        auto [it, inserted] = dupCheck.emplace(_outSlots[idx]);
+        uassert(5150802, str::stream() << "duplicate field: " << _outSlots[idx], inserted);
+
+        _blockAccessors.push_back(_children[0]->getAccessor(ctx, _blockSlots[idx]));
+        _outAccessorsMap[_outSlots[idx]] = idx;
+    }
+    _outAccessors.resize(_outSlots.size());
+    _blocks.resize(_blockSlots.size());
+
+    if (_bitmapSlot) {
+        _bitmapAccessor = _children[0]->getAccessor(ctx, *_bitmapSlot);
+    }
+}
+
+value::SlotAccessor* BlockToRowStage::getAccessor(CompileCtx& ctx, value::SlotId slot) {
+    if (auto it = _outAccessorsMap.find(slot); it != _outAccessorsMap.end()) {
+        return &_outAccessors[it->second];
+    }
+
+    return _children[0]->getAccessor(ctx, slot);
+}
+
+void BlockToRowStage::open(bool reOpen) {
+    _commonStats.opens++;
+    _children[0]->open(reOpen);
+    _blockSize = 0;
+    _pos = 0;
+}
+
+void BlockToRowStage::readBlocks() {
+    auto getBlock = [](value::SlotAccessor* accessor) {
+        auto [tag, val] = accessor->getViewOfValue();
+        uassert(5150803,
+                str::stream() << "expected a block of values but got: " << tag,
+                tag == value::TypeTags::valueBlock);
+        return value::getValueBlockView(val);
+    };
+
+    _blockSize = 0;
+    for (size_t idx = 0; idx < _blockAccessors.size(); ++idx) {
+        _blocks[idx] = getBlock(_blockAccessors[idx]);
+        uassert(5150804,
+                "blocks of a row must have the same size",
+                idx == 0 || _blocks[idx]->size() == _blockSize);
+        _blockSize = _blocks[idx]->size();
+    }
+
+    _bitmap = nullptr;
+    if (_bitmapAccessor) {
+        _bitmap = getBlock(_bitmapAccessor);
+        uassert(5150805,
+                "the bitmap must have the same size as the blocks",
+                _blockAccessors.empty() || _bitmap->size() == _blockSize);
+        _blockSize = _bitmap->size();
+    }
+    _pos = 0;
+}
+
+PlanState BlockToRowStage::getNext() {
+    for (;;) {
+        // Skip the positions filtered out by the bitmap.
+        if (_bitmap) {
+            while (_pos < _blockSize &&
+                   !(_bitmap->tags()[_pos] == value::TypeTags::Boolean &&
+                     value::bitcastTo<bool>(_bitmap->values()[_pos]))) {
+                ++_pos;
+            }
+        }
+
+        if (_pos < _blockSize) {
+            break;
+        }
+
+        if (_children[0]->getNext() == PlanState::IS_EOF) {
+            return trackPlanState(PlanState::IS_EOF);
+        }
+        readBlocks();
+    }
+
+    for (size_t idx = 0; idx < _outAccessors.size(); ++idx) {
+        auto [tag, val] = _blocks[idx]->getAt(_pos);
+        _outAccessors[idx].reset(tag, val);
+    }
+    ++_pos;
+
+    return trackPlanState(PlanState::ADVANCED);
+}
+
+void BlockToRowStage::close() {
+    _commonStats.closes++;
+    _children[0]->close();
+}
+
+std::unique_ptr<PlanStageStats> BlockToRowStage::getStats() const {
+    auto ret = std::make_unique<PlanStageStats>(_commonStats);
+    ret->children.emplace_back(_children[0]->getStats());
+    return ret;
+}
+
+const SpecificStats* BlockToRowStage::getSpecificStats() const {
+    return nullptr;
+}
+
+std::vector<DebugPrinter::Block> BlockToRowStage::debugPrint() const {
+    std::vector<DebugPrinter::Block> ret;
+    DebugPrinter::addKeyword(ret, "blocktorow");
+
+    ret.emplace_back(DebugPrinter::Block("[`"));
+    for (size_t idx = 0; idx < _outSlots.size(); ++idx) {
+        if (idx) {
+            ret.emplace_back(DebugPrinter::Block("`,"));
+        }
+
+        DebugPrinter::addIdentifier(ret, _outSlots[idx]);
+        ret.emplace_back("=");
+        DebugPrinter::addIdentifier(ret, _blockSlots[idx]);
+    }
+    ret.emplace_back(DebugPrinter::Block("`]"));
+
+    if (_bitmapSlot) {
+        DebugPrinter::addIdentifier(ret, *_bitmapSlot);
+    }
+
+    DebugPrinter::addNewLine(ret);
+    DebugPrinter::addBlocks(ret, _children[0]->debugPrint());
+
+    return ret;
+}
+}  // namespace mongo::sbe
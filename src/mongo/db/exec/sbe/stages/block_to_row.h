@@ -0,0 +1,88 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/db/exec/sbe/stages/stages.h"
+
+namespace mongo::sbe {
+/**
+ * Turns a stream of blocks back into a stream of rows. For every block produced by the child, it
+ * returns one row per block position, exposing the value at that position of each block slot in
+ * the corresponding output slot. All blocks of a row of blocks must have the same size.
+ *
+ * If a bitmap slot is given, it must hold a block of the same size, and only the positions where
+ * the bitmap is true are returned. This is how the result of a vectorized filter is applied.
+ *
+ * The output values are views into the child's blocks and are valid until the next call to
+ * getNext().
+ */
+class BlockToRowStage final : public PlanStage {
+public:
+    BlockToRowStage(std::unique_ptr<PlanStage> input,
+                    value::SlotVector blockSlots,
+                    value::SlotVector outSlots,
+                    boost::optional<value::SlotId> bitmapSlot,
+                    PlanNodeId planNodeId);
+
+    std::unique_ptr<PlanStage> clone() const final;
+
+    void prepare(CompileCtx& ctx) final;
+    value::SlotAccessor* getAccessor(CompileCtx& ctx, value::SlotId slot) final;
+    void open(bool reOpen) final;
+    PlanState getNext() final;
+    void close() final;
+
+    std::unique_ptr<PlanStageStats> getStats() const final;
+    const SpecificStats* getSpecificStats() const final;
+    std::vector<DebugPrinter::Block> debugPrint() const final;
+
+private:
+    /**
+     * Reads the blocks of the current child row into '_blocks' and '_bitmap'.
+     */
+    void readBlocks();
+
+    const value::SlotVector _blockSlots;
+    const value::SlotVector _outSlots;
+    const boost::optional<value::SlotId> _bitmapSlot;
+
+    std::vector<value::SlotAccessor*> _blockAccessors;
+    value::SlotAccessor* _bitmapAccessor{nullptr};
+    std::vector<value::ViewOfValueAccessor> _outAccessors;
+    value::SlotMap<size_t> _outAccessorsMap;
+
+    std::vector<const value::ValueBlock*> _blocks;
+    const value::ValueBlock* _bitmap{nullptr};
+
+    // The size of the current blocks and the position of the next row to return.
+    size_t _blockSize{0};
+    size_t _pos{0};
+};
+}  // namespace mongo::sbe
@@ -33,6 +33,9 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/client.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/service_context.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo::sbe {
 std::unique_ptr<ThreadPool> s_globalThreadPool;
@@ -49,6 +52,50 @@ MONGO_INITIALIZER(s_globalThreadPool)(InitializerContext* context) {
     return Status::OK();
 }
 
+namespace {
+// The number of exchange producers reserved by all live ExchangeWorkerReservations.
+AtomicWord<size_t> reservedWorkers{0};
+}  // namespace
+
+ExchangeWorkerReservation ExchangeWorkerReservation::reserve(size_t requested, size_t budget) {
+    auto current = reservedWorkers.load();
+    while (true) {
+        auto granted = std::min(requested, budget > current ? budget - current : 0);
+        if (granted == 0) {
+            return {};
+        }
+        if (reservedWorkers.compareAndSwap(&current, current + granted)) {
+            return ExchangeWorkerReservation{granted};
+        }
+    }
+}
+
+size_t ExchangeWorkerReservation::numReservedWorkers() {
+    return reservedWorkers.load();
+}
+
+ExchangeWorkerReservation::ExchangeWorkerReservation(ExchangeWorkerReservation&& other) noexcept
+    : _numWorkers(std::exchange(other._numWorkers, 0)) {}
+
+ExchangeWorkerReservation& ExchangeWorkerReservation::operator=(
+    ExchangeWorkerReservation&& other) noexcept {
+    if (this != &other) {
+        release();
+        _numWorkers = std::exchange(other._numWorkers, 0);
+    }
+    return *this;
+}
+
+ExchangeWorkerReservation::~ExchangeWorkerReservation() {
+    release();
+}
+
+void ExchangeWorkerReservation::release() {
+    if (_numWorkers) {
+        reservedWorkers.fetchAndSubtract(std::exchange(_numWorkers, 0));
+    }
+}
+
 ExchangePipe::ExchangePipe(size_t size) {
     // All buffers start empty.
     _fullCount = 0;
@@ -84,10 +131,15 @@ std::unique_ptr<ExchangeBuffer> ExchangePipe::getEmptyBuffer() {
     return std::move(_emptyBuffers[_emptyCount]);
 }
 
-std::unique_ptr<ExchangeBuffer> ExchangePipe::getFullBuffer() {
+std::unique_ptr<ExchangeBuffer> ExchangePipe::getFullBuffer(OperationContext* opCtx) {
     stdx::unique_lock lock(_mutex);
 
-    _cond.wait(lock, [this]() { return _closed || _fullCount != _fullPosition; });
+    auto pred = [this]() { return _closed || _fullCount != _fullPosition; };
+    if (opCtx) {
+        opCtx->waitForConditionOrInterrupt(_cond, lock, pred);
+    } else {
+        _cond.wait(lock, pred);
+    }
 
     if (_closed) {
         return nullptr;
@@ -134,12 +186,63 @@ ExchangePipe* ExchangeState::pipe(size_t consumerTid, size_t producerTid) {
     return _consumers[consumerTid]->pipe(producerTid);
 }
 
+void ExchangeState::captureConsumerReadState(OperationContext* opCtx) {
+    _readConcern = repl::ReadConcernArgs::get(opCtx);
+    _readSource = opCtx->recoveryUnit()->getTimestampReadSource();
+    _readTimestamp = opCtx->recoveryUnit()->getPointInTimeReadTimestamp();
+    _deadline = opCtx->getDeadline();
+    _timeoutError = opCtx->getTimeoutError();
+}
+
+void ExchangeState::registerProducerOpCtx(OperationContext* opCtx) {
+    repl::ReadConcernArgs::get(opCtx) = _readConcern;
+    // A point in time read is pinned to the timestamp the consumers read at, so that every
+    // producer sees the same snapshot.
+    if (_readTimestamp) {
+        opCtx->recoveryUnit()->setTimestampReadSource(RecoveryUnit::ReadSource::kProvided,
+                                                      _readTimestamp);
+    } else {
+        opCtx->recoveryUnit()->setTimestampReadSource(_readSource);
+    }
+    if (_deadline != Date_t::max()) {
+        opCtx->setDeadlineByDate(_deadline, _timeoutError);
+    }
+
+    stdx::lock_guard lock(_producerOpCtxsMutex);
+    if (_producerKillCode != ErrorCodes::OK) {
+        stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+        opCtx->getServiceContext()->killOperation(clientLock, opCtx, _producerKillCode);
+    }
+    _producerOpCtxs.push_back(opCtx);
+}
+
+void ExchangeState::unregisterProducerOpCtx(OperationContext* opCtx) {
+    stdx::lock_guard lock(_producerOpCtxsMutex);
+    _producerOpCtxs.erase(std::remove(_producerOpCtxs.begin(), _producerOpCtxs.end(), opCtx),
+                          _producerOpCtxs.end());
+}
+
+void ExchangeState::interruptProducers(ErrorCodes::Error code) {
+    stdx::lock_guard lock(_producerOpCtxsMutex);
+    _producerKillCode = code;
+    for (auto opCtx : _producerOpCtxs) {
+        stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+        opCtx->getServiceContext()->killOperation(clientLock, opCtx, code);
+    }
+}
+
 ExchangeBuffer* ExchangeConsumer::getBuffer(size_t producerId) {
     if (_fullBuffers[producerId]) {
         return _fullBuffers[producerId].get();
     }
 
-    _fullBuffers[producerId] = _pipes[producerId]->getFullBuffer();
+    try {
+        _fullBuffers[producerId] = _pipes[producerId]->getFullBuffer(_opCtx);
+    } catch (const DBException& ex) {
+        // The producers work on behalf of this operation, so they stop along with it.
+        _state->interruptProducers(ex.code());
+        throw;
+    }
 
     return _fullBuffers[producerId].get();
 }
@@ -232,6 +335,8 @@ void ExchangeConsumer::open(bool reOpen) {
                     lock, [this]() { return _state->consumerOpen() == _state->numOfConsumers(); });
             }
 
+            _state->captureConsumerReadState(_opCtx);
+
             // Clone n copies of the subtree for every producer.
 
             PlanStage* masterSubTree = _children[0].get();
@@ -254,10 +359,15 @@ void ExchangeConsumer::open(bool reOpen) {
             for (size_t idx = 0; idx < _state->numOfProducers(); ++idx) {
                 auto pf = makePromiseFuture<void>();
                 s_globalThreadPool->schedule(
-                    [this, idx, promise = std::move(pf.promise)](auto status) mutable {
+                    [this, state = _state, idx, promise = std::move(pf.promise)](
+                        auto status) mutable {
                         invariant(status);
 
+                        // The consumer may be gone as soon as the promise is set, so the state is
+                        // kept alive until the operation is unregistered.
                         auto opCtx = cc().makeOperationContext();
+                        state->registerProducerOpCtx(opCtx.get());
+                        ON_BLOCK_EXIT([&] { state->unregisterProducerOpCtx(opCtx.get()); });
 
                         promise.setWith([&] {
                             ExchangeProducer::start(opCtx.get(),
@@ -363,7 +473,10 @@ void ExchangeConsumer::close() {
 
 std::unique_ptr<PlanStageStats> ExchangeConsumer::getStats() const {
     auto ret = std::make_unique<PlanStageStats>(_commonStats);
-    ret->children.emplace_back(_children[0]->getStats());
+    // Once the consumer has been opened its subtree has been handed over to the producers.
+    if (!_children.empty()) {
+        ret->children.emplace_back(_children[0]->getStats());
+    }
     return ret;
 }
 
@@ -398,7 +511,9 @@ std::vector<DebugPrinter::Block> ExchangeConsumer::debugPrint() const {
     }
 
     DebugPrinter::addNewLine(ret);
-    DebugPrinter::addBlocks(ret, _children[0]->debugPrint());
+    if (!_children.empty()) {
+        DebugPrinter::addBlocks(ret, _children[0]->debugPrint());
+    }
 
     return ret;
 }
@@ -33,6 +33,8 @@
 
 #include "mongo/db/exec/sbe/expressions/expression.h"
 #include "mongo/db/exec/sbe/stages/stages.h"
+#include "mongo/db/repl/read_concern_args.h"
+#include "mongo/db/storage/recovery_unit.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/future.h"
 #include "mongo/util/concurrency/thread_pool.h"
@@ -44,6 +46,41 @@ class ExchangeProducer;
 
 enum class ExchangePolicy { broadcast, roundrobin, partition };
 
+/**
+ * A reservation of exchange producer threads against a process-wide budget, which bounds the total
+ * number of producers that parallel plans may run at any one time. The workers are returned to the
+ * budget when the reservation is destroyed.
+ */
+class ExchangeWorkerReservation {
+public:
+    /**
+     * Reserves up to 'requested' workers without letting the total number of reserved workers
+     * exceed 'budget'. The returned reservation may hold fewer workers than requested, or none.
+     */
+    static ExchangeWorkerReservation reserve(size_t requested, size_t budget);
+
+    /**
+     * Returns the number of workers currently reserved by all reservations.
+     */
+    static size_t numReservedWorkers();
+
+    ExchangeWorkerReservation() = default;
+    ExchangeWorkerReservation(ExchangeWorkerReservation&& other) noexcept;
+    ExchangeWorkerReservation& operator=(ExchangeWorkerReservation&& other) noexcept;
+    ~ExchangeWorkerReservation();
+
+    size_t numWorkers() const {
+        return _numWorkers;
+    }
+
+private:
+    explicit ExchangeWorkerReservation(size_t numWorkers) : _numWorkers(numWorkers) {}
+
+    void release();
+
+    size_t _numWorkers{0};
+};
+
 // A unit of exchange between a consumer and a producer
 class ExchangeBuffer {
 public:
@@ -123,7 +160,10 @@ public:
 
     void close();
     std::unique_ptr<ExchangeBuffer> getEmptyBuffer();
-    std::unique_ptr<ExchangeBuffer> getFullBuffer();
+    /**
+     * Waits for a full buffer. The wait is interrupted along with 'opCtx' when one is given.
+     */
+    std::unique_ptr<ExchangeBuffer> getFullBuffer(OperationContext* opCtx = nullptr);
     void putEmptyBuffer(std::unique_ptr<ExchangeBuffer>);
     void putFullBuffer(std::unique_ptr<ExchangeBuffer>);
 
@@ -217,6 +257,24 @@ public:
     }
     ExchangePipe* pipe(size_t consumerTid, size_t producerTid);
 
+    /**
+     * Records how the operation of the consumers reads, so that the producers read the same
+     * snapshot and expire at the same deadline.
+     */
+    void captureConsumerReadState(OperationContext* opCtx);
+
+    /**
+     * Prepares 'opCtx' to run a producer on behalf of the consumers, and registers it to be
+     * interrupted along with them until it is unregistered.
+     */
+    void registerProducerOpCtx(OperationContext* opCtx);
+    void unregisterProducerOpCtx(OperationContext* opCtx);
+
+    /**
+     * Kills the operations of all producers, which have not finished yet or are still to start.
+     */
+    void interruptProducers(ErrorCodes::Error code);
+
 private:
     const ExchangePolicy _policy;
     const size_t _numOfProducers;
@@ -244,6 +302,18 @@ private:
     mongo::Mutex _consumerCloseMutex;
     stdx::condition_variable _consumerCloseCond;
     size_t _consumerClose{0};
+
+    // The read concern, snapshot and deadline of the operation of the consumers.
+    repl::ReadConcernArgs _readConcern;
+    RecoveryUnit::ReadSource _readSource{RecoveryUnit::ReadSource::kNoTimestamp};
+    boost::optional<Timestamp> _readTimestamp;
+    Date_t _deadline{Date_t::max()};
+    ErrorCodes::Error _timeoutError{ErrorCodes::ExceededTimeLimit};
+
+    // The operations the producers run on, and the error they have been interrupted with, if any.
+    mongo::Mutex _producerOpCtxsMutex = MONGO_MAKE_LATCH("ExchangeState::_producerOpCtxsMutex");
+    std::vector<OperationContext*> _producerOpCtxs;
+    ErrorCodes::Error _producerKillCode{ErrorCodes::OK};
 };
 
 class ExchangeConsumer final : public PlanStage {
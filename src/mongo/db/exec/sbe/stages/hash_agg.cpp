@@ -31,25 +31,85 @@
 
 #include "mongo/db/exec/sbe/stages/hash_agg.h"
 
+#include <boost/filesystem/operations.hpp>
+
+#include "mongo/db/storage/storage_options.h"
+#include "mongo/util/destructor_guard.h"
 #include "mongo/util/str.h"
 
+namespace {
+std::string nextFileName() {
+    static mongo::AtomicWord<unsigned> hashAggFileCounter;
+    return "extsort-hash-agg-sbe." + std::to_string(hashAggFileCounter.fetchAndAdd(1));
+}
+}  // namespace
+
+#include "mongo/db/sorter/sorter.cpp"
+
 namespace mongo {
 namespace sbe {
+namespace {
+/**
+ * Compares two group-by keys column by column. Spilled runs are sorted in this order so that rows
+ * with the same key from different runs are returned next to each other when the runs are merged.
+ */
+int compareKeys(const value::MaterializedRow& lhs, const value::MaterializedRow& rhs) {
+    for (size_t idx = 0; idx < lhs.size(); ++idx) {
+        auto [lhsTag, lhsVal] = lhs.getViewOfValue(idx);
+        auto [rhsTag, rhsVal] = rhs.getViewOfValue(idx);
+        auto [tag, val] = value::compareValue(lhsTag, lhsVal, rhsTag, rhsVal);
+
+        auto result = value::bitcastTo<int32_t>(val);
+        if (result) {
+            return result;
+        }
+    }
+
+    return 0;
+}
+}  // namespace
+
 HashAggStage::HashAggStage(std::unique_ptr<PlanStage> input,
                            value::SlotVector gbs,
                            value::SlotMap<std::unique_ptr<EExpression>> aggs,
-                           PlanNodeId planNodeId)
-    : PlanStage("group"_sd, planNodeId), _gbs(std::move(gbs)), _aggs(std::move(aggs)) {
+                           value::SlotMap<std::unique_ptr<EExpression>> mergingExprs,
+                           boost::optional<size_t> memoryLimit,
+                           bool allowDiskUse,
+                           PlanNodeId planNodeId,
+                           TrialRunProgressTracker* tracker)
+    : PlanStage("group"_sd, planNodeId),
+      _gbs(std::move(gbs)),
+      _aggs(std::move(aggs)),
+      _mergingExprs(std::move(mergingExprs)),
+      _memoryLimit(memoryLimit),
+      _allowDiskUse(allowDiskUse),
+      _tracker(tracker) {
     _children.emplace_back(std::move(input));
 }
 
+HashAggStage::~HashAggStage() {
+    if (_ownsSpillFile) {
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_spillFileName));
+    }
+}
+
 std::unique_ptr<PlanStage> HashAggStage::clone() const {
     value::SlotMap<std::unique_ptr<EExpression>> aggs;
     for (auto& [k, v] : _aggs) {
         aggs.emplace(k, v->clone());
     }
-    return std::make_unique<HashAggStage>(
-        _children[0]->clone(), _gbs, std::move(aggs), _commonStats.nodeId);
+    value::SlotMap<std::unique_ptr<EExpression>> mergingExprs;
+    for (auto& [k, v] : _mergingExprs) {
+        mergingExprs.emplace(k, v->clone());
+    }
+    return std::make_unique<HashAggStage>(_children[0]->clone(),
+                                          _gbs,
+                                          std::move(aggs),
+                                          std::move(mergingExprs),
+                                          _memoryLimit,
+                                          _allowDiskUse,
+                                          _commonStats.nodeId,
+                                          _tracker);
 }
 
 void HashAggStage::prepare(CompileCtx& ctx) {
@@ -86,10 +146,45 @@ void HashAggStage::prepare(CompileCtx& ctx) {
         _aggCodes.emplace_back(expr->compile(ctx));
         ctx.aggExpression = false;
     }
+
+    if (_allowDiskUse) {
+        // The merging expressions accumulate into the same hash table rows as the regular
+        // aggregates, but read the aggregate slots from the spilled row instead (see
+        // getAccessor()).
+        counter = 0;
+        for (auto& [slot, expr] : _aggs) {
+            _spilledAggAccessors.emplace(
+                slot, std::make_unique<SpilledAggAccessor>(_spilledRowIt, counter++));
+        }
+
+        _compilingMergingExprs = true;
+        counter = 0;
+        for (auto& [slot, expr] : _aggs) {
+            const auto slotId = slot;
+            auto it = _mergingExprs.find(slot);
+            uassert(5150800,
+                    str::stream() << "missing merging expression for field: " << slotId,
+                    it != _mergingExprs.end());
+
+            ctx.root = this;
+            ctx.aggExpression = true;
+            ctx.accumulator = _outAggAccessors[counter++].get();
+
+            _mergingCodes.emplace_back(it->second->compile(ctx));
+            ctx.aggExpression = false;
+        }
+        _compilingMergingExprs = false;
+    }
     _compiled = true;
 }
 
 value::SlotAccessor* HashAggStage::getAccessor(CompileCtx& ctx, value::SlotId slot) {
+    if (_compilingMergingExprs) {
+        if (auto it = _spilledAggAccessors.find(slot); it != _spilledAggAccessors.end()) {
+            return it->second.get();
+        }
+    }
+
     if (_compiled) {
         if (auto it = _outAccessors.find(slot); it != _outAccessors.end()) {
             return it->second;
@@ -101,10 +196,65 @@ value::SlotAccessor* HashAggStage::getAccessor(CompileCtx& ctx, value::SlotId sl
     return ctx.getAccessor(slot);
 }
 
+void HashAggStage::trackMemoryUsage(int64_t delta) {
+    invariant(delta >= 0 || static_cast<size_t>(-delta) <= _htMemoryUsage);
+    _htMemoryUsage += delta;
+
+    if (_htMemoryUsage > *_memoryLimit) {
+        uassert(ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed,
+                "Exceeded memory limit for $group, but didn't allow external sort."
+                " Pass allowDiskUse:true to opt in.",
+                _allowDiskUse);
+        spill();
+    }
+}
+
+void HashAggStage::spill() {
+    const auto tempDir = storageGlobalParams.dbpath + "/_tmp";
+    if (_spillFileName.empty()) {
+        _spillFileName = tempDir + "/" + nextFileName();
+        _ownsSpillFile = true;
+    }
+
+    std::vector<const TableType::value_type*> rows;
+    rows.reserve(_ht.size());
+    for (auto& row : _ht) {
+        rows.push_back(&row);
+    }
+    std::sort(rows.begin(), rows.end(), [](auto lhs, auto rhs) {
+        return compareKeys(lhs->first, rhs->first) < 0;
+    });
+
+    SortedFileWriter<value::MaterializedRow, value::MaterializedRow> writer(
+        SortOptions().TempDir(tempDir), _spillFileName, _nextSpillFileOffset);
+    for (auto row : rows) {
+        writer.addAlreadySorted(row->first, row->second);
+    }
+    _spilledRuns.emplace_back(writer.done());
+    _nextSpillFileOffset = writer.getFileEndOffset();
+
+    _specificStats.usedDisk = true;
+    _specificStats.spills++;
+    _specificStats.spilledRecords += rows.size();
+
+    _ht.clear();
+    _htIt = _ht.end();
+    _htMemoryUsage = 0;
+}
+
 void HashAggStage::open(bool reOpen) {
     _commonStats.opens++;
     _children[0]->open(reOpen);
 
+    _mergeIt.reset();
+    _haveSpilledRow = false;
+
+    // Discard any groups left over from a previous execution, e.g. when the stage is reopened
+    // after a trial run which has ended early.
+    _ht.clear();
+    _htMemoryUsage = 0;
+    _spilledRuns.clear();
+
     while (_children[0]->getNext() == PlanState::ADVANCED) {
         value::MaterializedRow key{_inKeyAccessors.size()};
         // Copy keys in order to do the lookup.
@@ -115,11 +265,20 @@ void HashAggStage::open(bool reOpen) {
         }
 
         auto [it, inserted] = _ht.try_emplace(std::move(key), value::MaterializedRow{0});
+        int64_t memoryDelta = 0;
         if (inserted) {
             // Copy keys.
             const_cast<value::MaterializedRow&>(it->first).makeOwned();
             // Initialize accumulators.
             it->second.resize(_outAggAccessors.size());
+
+            if (_memoryLimit) {
+                memoryDelta += it->first.memUsageForSorter();
+            }
+        }
+
+        if (_memoryLimit) {
+            memoryDelta -= it->second.memUsageForSorter();
         }
 
         // Accumulate.
@@ -128,14 +287,89 @@ void HashAggStage::open(bool reOpen) {
             auto [owned, tag, val] = _bytecode.run(_aggCodes[idx].get());
             _outAggAccessors[idx]->reset(owned, tag, val);
         }
+
+        if (_memoryLimit) {
+            memoryDelta += it->second.memUsageForSorter();
+            trackMemoryUsage(memoryDelta);
+        }
+
+        if (_tracker && _tracker->trackProgress<TrialRunProgressTracker::kNumResults>(1)) {
+            // The group stage is a blocking operation, so, just like the sort stage, it signals
+            // the runtime planner that this candidate plan has completed its trial run by raising
+            // a special exception rather than returning control with a partially built table.
+            _tracker = nullptr;
+            _children[0]->close();
+            uasserted(ErrorCodes::QueryTrialRunCompleted, "Trial run early exit");
+        }
     }
 
     _children[0]->close();
 
+    if (!_spilledRuns.empty()) {
+        // Write out whatever is left in the hash table, so that all groups are produced by merging
+        // the spilled runs.
+        if (!_ht.empty()) {
+            spill();
+        }
+
+        _mergeIt.reset(SpilledIterator::merge(
+            _spilledRuns, _spillFileName, SortOptions(), [](const auto& lhs, const auto& rhs) {
+                return compareKeys(lhs.first, rhs.first);
+            }));
+        // The merge iterator is now responsible for removing the spill file.
+        _ownsSpillFile = false;
+        _spilledRuns.clear();
+        _spillFileName.clear();
+        _nextSpillFileOffset = 0;
+
+        _haveSpilledRow = _mergeIt->more();
+        if (_haveSpilledRow) {
+            _spilledRow = _mergeIt->next();
+        }
+    }
+
     _htIt = _ht.end();
 }
 
+PlanState HashAggStage::getNextSpilled() {
+    _ht.clear();
+    if (!_haveSpilledRow) {
+        _htIt = _ht.end();
+        return trackPlanState(PlanState::IS_EOF);
+    }
+
+    // The hash table holds just the group being returned, so that the output accessors work the
+    // same way as when nothing was spilled.
+    auto [it, inserted] = _ht.try_emplace(std::move(_spilledRow.first), value::MaterializedRow{0});
+    invariant(inserted);
+    it->second.resize(_outAggAccessors.size());
+    _htIt = it;
+
+    while (true) {
+        for (size_t idx = 0; idx < _outAggAccessors.size(); ++idx) {
+            auto [owned, tag, val] = _bytecode.run(_mergingCodes[idx].get());
+            _outAggAccessors[idx]->reset(owned, tag, val);
+        }
+
+        if (!_mergeIt->more()) {
+            _haveSpilledRow = false;
+            break;
+        }
+
+        _spilledRow = _mergeIt->next();
+        if (compareKeys(_spilledRow.first, _htIt->first) != 0) {
+            break;
+        }
+    }
+
+    return trackPlanState(PlanState::ADVANCED);
+}
+
 PlanState HashAggStage::getNext() {
+    if (_mergeIt) {
+        return getNextSpilled();
+    }
+
     if (_htIt == _ht.end()) {
         _htIt = _ht.begin();
     } else {
@@ -151,16 +385,18 @@ PlanState HashAggStage::getNext() {
 
 std::unique_ptr<PlanStageStats> HashAggStage::getStats() const {
     auto ret = std::make_unique<PlanStageStats>(_commonStats);
+    ret->specific = std::make_unique<HashAggStats>(_specificStats);
     ret->children.emplace_back(_children[0]->getStats());
     return ret;
 }
 
 const SpecificStats* HashAggStage::getSpecificStats() const {
-    return nullptr;
+    return &_specificStats;
 }
 
 void HashAggStage::close() {
     _commonStats.closes++;
+    _mergeIt.reset();
 }
 
 std::vector<DebugPrinter::Block> HashAggStage::debugPrint() const {
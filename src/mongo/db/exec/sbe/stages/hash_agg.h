@@ -32,18 +32,47 @@
 #include <unordered_map>
 
 #include "mongo/db/exec/sbe/expressions/expression.h"
+#include "mongo/db/exec/sbe/stages/plan_stats.h"
 #include "mongo/db/exec/sbe/stages/stages.h"
 #include "mongo/db/exec/sbe/vm/vm.h"
+#include "mongo/db/exec/trial_run_progress_tracker.h"
 #include "mongo/stdx/unordered_map.h"
 
+namespace mongo {
+template <typename Key, typename Value>
+class SortIteratorInterface;
+}  // namespace mongo
+
 namespace mongo {
 namespace sbe {
+/**
+ * Groups the rows produced by its child by the values in the 'gbs' slots and computes the 'aggs'
+ * expressions for every group.
+ *
+ * If 'memoryLimit' is given and the approximate size of the hash table exceeds it, the stage either
+ * fails with 'QueryExceededMemoryLimitNoDiskUseAllowed' or, when 'allowDiskUse' is true, writes the
+ * hash table out to disk as a run of (key, partial aggregate) pairs sorted by key and starts over
+ * with an empty table. Once the input is exhausted the spilled runs are merged and the partial
+ * aggregates for each key are combined using 'mergingExprs'. There must be one merging expression
+ * for every aggregate, keyed by the aggregate's output slot; while a merging expression runs, that
+ * output slot refers to the partial aggregate read back from disk. For example, the aggregate
+ * 's2 = sum(s1)' is merged with 's2 = sum(s2)'.
+ *
+ * If a 'tracker' is given, the stage counts the rows it consumes during a trial run of the runtime
+ * planner and ends the trial run early once the tracker's limits are reached, like the sort stage.
+ */
 class HashAggStage final : public PlanStage {
 public:
     HashAggStage(std::unique_ptr<PlanStage> input,
                  value::SlotVector gbs,
                  value::SlotMap<std::unique_ptr<EExpression>> aggs,
-                 PlanNodeId planNodeId);
+                 value::SlotMap<std::unique_ptr<EExpression>> mergingExprs,
+                 boost::optional<size_t> memoryLimit,
+                 bool allowDiskUse,
+                 PlanNodeId planNodeId,
+                 TrialRunProgressTracker* tracker = nullptr);
+
+    ~HashAggStage();
 
     std::unique_ptr<PlanStage> clone() const final;
 
@@ -64,8 +93,37 @@ private:
     using HashKeyAccessor = value::MaterializedRowKeyAccessor<TableType::iterator>;
     using HashAggAccessor = value::MaterializedRowValueAccessor<TableType::iterator>;
 
+    using SpilledRow = std::pair<value::MaterializedRow, value::MaterializedRow>;
+    using SpilledIterator = SortIteratorInterface<value::MaterializedRow, value::MaterializedRow>;
+    using SpilledAggAccessor = value::MaterializedRowValueAccessor<SpilledRow*>;
+
+    /**
+     * Adds the memory used by a newly inserted hash table entry, or the growth of an existing
+     * entry's accumulators, to the running total and spills the table if it no longer fits.
+     */
+    void trackMemoryUsage(int64_t delta);
+
+    /**
+     * Writes the contents of the hash table to the spill file as a run sorted by key and empties
+     * the table.
+     */
+    void spill();
+
+    /**
+     * Produces the next group from the merged spilled runs, combining the partial aggregates of
+     * all runs holding the same key.
+     */
+    PlanState getNextSpilled();
+
     const value::SlotVector _gbs;
     const value::SlotMap<std::unique_ptr<EExpression>> _aggs;
+    const value::SlotMap<std::unique_ptr<EExpression>> _mergingExprs;
+    const boost::optional<size_t> _memoryLimit;
+    const bool _allowDiskUse;
+
+    // If provided, used during a trial run to accumulate certain execution stats. Once the trial
+    // run is complete, this pointer is reset to nullptr.
+    TrialRunProgressTracker* _tracker{nullptr};
 
     value::SlotAccessorMap _outAccessors;
     std::vector<value::SlotAccessor*> _inKeyAccessors;
@@ -74,12 +132,35 @@ private:
     std::vector<std::unique_ptr<HashAggAccessor>> _outAggAccessors;
     std::vector<std::unique_ptr<vm::CodeFragment>> _aggCodes;
 
+    // Provide a view of the partial aggregates of the spilled row being merged. These are only
+    // visible to the merging expressions.
+    value::SlotMap<std::unique_ptr<SpilledAggAccessor>> _spilledAggAccessors;
+    std::vector<std::unique_ptr<vm::CodeFragment>> _mergingCodes;
+
     TableType _ht;
     TableType::iterator _htIt;
 
+    // Approximate number of bytes held by the keys and accumulators in '_ht'.
+    size_t _htMemoryUsage{0};
+
+    std::string _spillFileName;
+    std::streampos _nextSpillFileOffset{0};
+    bool _ownsSpillFile{false};
+    std::vector<std::shared_ptr<SpilledIterator>> _spilledRuns;
+
+    // Once the input has been consumed after spilling, iterates over all spilled runs in key order.
+    // '_spilledRow' holds the first row of the next group to be returned.
+    std::unique_ptr<SpilledIterator> _mergeIt;
+    SpilledRow _spilledRow;
+    SpilledRow* _spilledRowIt{&_spilledRow};
+    bool _haveSpilledRow{false};
+
     vm::ByteCode _bytecode;
 
     bool _compiled{false};
+    bool _compilingMergingExprs{false};
+
+    HashAggStats _specificStats;
 };
 }  // namespace sbe
 }  // namespace mongo
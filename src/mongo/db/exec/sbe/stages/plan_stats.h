@@ -72,6 +72,8 @@ struct ScanStats : public SpecificStats {
     }
 
     size_t numReads{0};
+    // The number of those reads served by a columnar cache.
+    size_t numColumnarCacheReads{0};
 };
 
 struct IndexScanStats : public SpecificStats {
@@ -111,6 +113,23 @@ struct LimitSkipStats : public SpecificStats {
     boost::optional<long long> skip;
 };
 
+struct HashAggStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        return new HashAggStats(*this);
+    }
+
+    uint64_t estimateObjectSizeInBytes() const {
+        return sizeof(*this);
+    }
+
+    // Whether the hash table was spilled to disk because it exceeded the memory limit.
+    bool usedDisk{false};
+    // The number of times the hash table was spilled.
+    size_t spills{0};
+    // The total number of (key, partial aggregate) pairs written to disk.
+    size_t spilledRecords{0};
+};
+
 /**
  * Calculates the total number of physical reads in the given plan stats tree. If a stage can do
  * a physical read (e.g. COLLSCAN or IXSCAN), then its 'numReads' stats is added to the total.
@@ -0,0 +1,160 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/stages/row_to_block.h"
+
+#include "mongo/db/exec/sbe/expressions/expression.h"
+
+namespace mongo::sbe {
+RowToBlockStage::RowToBlockStage(std::unique_ptr<PlanStage> input,
+                                 value::SlotVector inSlots,
+                                 value::SlotVector outSlots,
+                                 size_t blockSize,
+                                 PlanNodeId planNodeId)
+    : PlanStage("rowtoblock"_sd, planNodeId),
+      _inSlots(std::move(inSlots)),
+      _outSlots(std::move(outSlots)),
+      _blockSize(blockSize) {
+    invariant(_inSlots.size() == _outSlots.size());
+    invariant(_blockSize > 0);
+    _children.emplace_back(std::move(input));
+}
+
+std::unique_ptr<PlanStage> RowToBlockStage::clone() const {
+    return std::make_unique<RowToBlockStage>(
+        _children[0]->clone(), _inSlots, _outSlots, _blockSize, _commonStats.nodeId);
+}
+
+void RowToBlockStage::prepare(CompileCtx& ctx) {
+    _children[0]->prepare(ctx);
+
+    value::SlotSet dupCheck;
+    for (size_t idx = 0; idx < _outSlots.size(); ++idx) {
+        auto [it, inserted] = dupCheck.emplace(_outSlots[idx]);
+        uassert(5150801, str::stream() << "duplicate field: " << _outSlots[idx], inserted);
+
+        _inAccessors.push_back(_children[0]->getAccessor(ctx, _inSlots[idx]));
+        _outAccessorsMap[_outSlots[idx]] = idx;
+    }
+    _outAccessors.resize(_outSlots.size());
+}
+
+value::SlotAccessor* RowToBlockStage::getAccessor(CompileCtx& ctx, value::SlotId slot) {
+    if (auto it = _outAccessorsMap.find(slot); it != _outAccessorsMap.end()) {
+        return &_outAccessors[it->second];
+    }
+
+    return ctx.getAccessor(slot);
+}
+
+void RowToBlockStage::open(bool reOpen) {
+    _commonStats.opens++;
+    _children[0]->open(reOpen);
+    _childEOF = false;
+}
+
+PlanState RowToBlockStage::getNext() {
+    if (_childEOF) {
+        return trackPlanState(PlanState::IS_EOF);
+    }
+
+    std::vector<std::unique_ptr<value::ValueBlock>> blocks;
+    blocks.reserve(_inAccessors.size());
+    for (size_t idx = 0; idx < _inAccessors.size(); ++idx) {
+        blocks.emplace_back(std::make_unique<value::ValueBlock>());
+        blocks.back()->reserve(_blockSize);
+    }
+
+    size_t rows = 0;
+    for (; rows < _blockSize; ++rows) {
+        if (_children[0]->getNext() == PlanState::IS_EOF) {
+            _childEOF = true;
+            break;
+        }
+
+        for (size_t idx = 0; idx < _inAccessors.size(); ++idx) {
+            auto [tag, val] = _inAccessors[idx]->copyOrMoveValue();
+            blocks[idx]->push_back(tag, val);
+        }
+    }
+
+    if (rows == 0) {
+        return trackPlanState(PlanState::IS_EOF);
+    }
+
+    for (size_t idx = 0; idx < _outAccessors.size(); ++idx) {
+        _outAccessors[idx].reset(true,
+                                 value::TypeTags::valueBlock,
+                                 value::bitcastFrom<value::ValueBlock*>(blocks[idx].release()));
+    }
+
+    return trackPlanState(PlanState::ADVANCED);
+}
+
+void RowToBlockStage::close() {
+    _commonStats.closes++;
+    _children[0]->close();
+}
+
+std::unique_ptr<PlanStageStats> RowToBlockStage::getStats() const {
+    auto ret = std::make_unique<PlanStageStats>(_commonStats);
+    ret->children.emplace_back(_children[0]->getStats());
+    return ret;
+}
+
+const SpecificStats* RowToBlockStage::getSpecificStats() const {
+    return nullptr;
+}
+
+std::vector<DebugPrinter::Block> RowToBlockStage::debugPrint() const {
+    std::vector<DebugPrinter::Block> ret;
+    DebugPrinter::addKeyword(ret, "rowtoblock");
+
+    ret.emplace_back(DebugPrinter::Block("[`"));
+    for (size_t idx = 0; idx < _outSlots.size(); ++idx) {
+        if (idx) {
+            ret.emplace_back(DebugPrinter::Block("`,"));
+        }
+
+        DebugPrinter::addIdentifier(ret, _outSlots[idx]);
+        ret.emplace_back("=");
+        DebugPrinter::addIdentifier(ret, _inSlots[idx]);
+    }
+    ret.emplace_back(DebugPrinter::Block("`]"));
+
+    ret.emplace_back(std::to_string(_blockSize));
+
+    DebugPrinter::addNewLine(ret);
+    DebugPrinter::addBlocks(ret, _children[0]->debugPrint());
+
+    return ret;
+}
+}  // namespace mongo::sbe
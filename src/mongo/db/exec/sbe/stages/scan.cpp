@@ -32,11 +32,39 @@
 #include "mongo/db/exec/sbe/stages/scan.h"
 
 #include "mongo/db/exec/sbe/expressions/expression.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
 namespace sbe {
+namespace {
+/**
+ * Returns whether a scan of the whole of 'nss' reacquires its locks with low ticket priority when
+ * it is restored after yielding. An unbounded scan of a regular collection is long-running work,
+ * so like the classic collection scan it gives way to latency-sensitive operations.
+ */
+bool shouldDeprioritizeRestore(const NamespaceString& nss) {
+    return internalQueryDeprioritizeUnboundedCollectionScans.load() && !nss.isOplog();
+}
+
+/**
+ * Acquires the collection of a scan being restored, with low ticket priority if 'deprioritize' is
+ * set and the operation has no priority of its own. The priority only applies to this acquisition.
+ */
+void restoreCollection(OperationContext* opCtx,
+                       const NamespaceStringOrUUID& name,
+                       bool deprioritize,
+                       boost::optional<AutoGetCollectionForRead>& coll) {
+    boost::optional<ScopedTicketPriority> lowPriority;
+    if (deprioritize && getTicketPriority(opCtx) == TicketPriority::kNormal) {
+        lowPriority.emplace(opCtx, TicketPriority::kLow);
+    }
+    coll.emplace(opCtx, name);
+}
+}  // namespace
+
 ScanStage::ScanStage(const NamespaceStringOrUUID& name,
                      boost::optional<value::SlotId> recordSlot,
                      boost::optional<value::SlotId> recordIdSlot,
@@ -47,7 +75,8 @@ ScanStage::ScanStage(const NamespaceStringOrUUID& name,
                      PlanYieldPolicy* yieldPolicy,
                      TrialRunProgressTracker* tracker,
                      PlanNodeId nodeId,
-                     ScanOpenCallback openCallback)
+                     ScanOpenCallback openCallback,
+                     std::shared_ptr<ColumnarCollectionCache> columnarCache)
     : PlanStage(seekKeySlot ? "seek"_sd : "scan"_sd, yieldPolicy, nodeId),
       _name(name),
       _recordSlot(recordSlot),
@@ -57,9 +86,11 @@ ScanStage::ScanStage(const NamespaceStringOrUUID& name,
       _seekKeySlot(seekKeySlot),
       _forward(forward),
       _tracker(tracker),
-      _openCallback(openCallback) {
+      _openCallback(openCallback),
+      _columnarCache(std::move(columnarCache)) {
     invariant(_fields.size() == _vars.size());
     invariant(!_seekKeySlot || _forward);
+    invariant(!_columnarCache || (!_seekKeySlot && _forward));
 }
 
 std::unique_ptr<PlanStage> ScanStage::clone() const {
@@ -73,7 +104,8 @@ std::unique_ptr<PlanStage> ScanStage::clone() const {
                                        _yieldPolicy,
                                        _tracker,
                                        _commonStats.nodeId,
-                                       _openCallback);
+                                       _openCallback,
+                                       _columnarCache);
 }
 
 void ScanStage::prepare(CompileCtx& ctx) {
@@ -131,7 +163,7 @@ void ScanStage::doRestoreState() {
         return;
     }
 
-    _coll.emplace(_opCtx, _name);
+    restoreCollection(_opCtx, _name, _deprioritizeRestore, _coll);
 
     uassertStatusOK(repl::ReplicationCoordinator::get(_opCtx)->checkCanServeReadsFor(
         _opCtx, _coll->getNss(), true));
@@ -167,6 +199,7 @@ void ScanStage::open(bool reOpen) {
 
         uassertStatusOK(repl::ReplicationCoordinator::get(_opCtx)->checkCanServeReadsFor(
             _opCtx, _coll->getNss(), true));
+        _deprioritizeRestore = !_seekKeySlot && shouldDeprioritizeRestore(_coll->getNss());
     } else {
         invariant(_cursor);
         invariant(_coll);
@@ -196,10 +229,99 @@ void ScanStage::open(bool reOpen) {
         _cursor.reset();
     }
 
+    _batch.clear();
+    _batchPos = 0;
+    _nextBatchSize = 1;
+
+    // The cache reflects the latest committed writes, so it can only serve reads which are not
+    // bound to a point in time. Rows with writes in flight are read from '_cursor'.
+    _columnarView.reset();
+    _rowReader.reset();
+    if (_columnarCache && _cursor && !_opCtx->inMultiDocumentTransaction() &&
+        _opCtx->recoveryUnit()->getTimestampReadSource() ==
+            RecoveryUnit::ReadSource::kNoTimestamp) {
+        _columnarView = ColumnarCacheRegistry::get(_opCtx->getServiceContext())
+                            .acquireReadView(_columnarCache, _coll->getCollection()->uuid());
+        _rowGroupPos = 0;
+        _rowPos = 0;
+        _inFlightPos = 0;
+    }
+
     _open = true;
     _firstGetNext = true;
 }
 
+boost::optional<Record> ScanStage::nextRecordFromCursor() {
+    if (_seekKeyAccessor) {
+        return _cursor->next();
+    }
+
+    if (_batchPos == _batch.size()) {
+        // Start with a single record, so that scans which are cut short read little ahead, and
+        // double the batch size with each refill.
+        _batchPos = 0;
+        const size_t maxBatchSize = internalQueryCollectionScanMaxBatchSize.load();
+        _nextBatchSize = std::min(_nextBatchSize, maxBatchSize);
+        if (_cursor->nextBatch(&_batch, _nextBatchSize) == 0) {
+            return boost::none;
+        }
+        _nextBatchSize = std::min(2 * _nextBatchSize, maxBatchSize);
+    }
+
+    const size_t pos = _batchPos++;
+    return Record{_batch.id(pos), _batch.data(pos)};
+}
+
+boost::optional<Record> ScanStage::nextRecordFromColumnarCache() {
+    const auto& rowGroups = _columnarView->snapshot->rowGroups;
+    const auto& inFlight = _columnarView->inFlight;
+
+    while (true) {
+        const RecordId* cachedId = nullptr;
+        while (_rowGroupPos < rowGroups.size()) {
+            const auto& rowGroup = *rowGroups[_rowGroupPos];
+            if (_rowPos < rowGroup.recordIds.size()) {
+                if (!_rowReader) {
+                    _rowReader.emplace(*_columnarCache, rowGroup);
+                }
+                cachedId = &rowGroup.recordIds[_rowPos];
+                break;
+            }
+            _rowReader.reset();
+            ++_rowGroupPos;
+            _rowPos = 0;
+        }
+        const RecordId* inFlightId =
+            _inFlightPos < inFlight.size() ? &inFlight[_inFlightPos] : nullptr;
+
+        if (!cachedId && !inFlightId) {
+            return boost::none;
+        }
+
+        if (inFlightId && (!cachedId || !(*cachedId < *inFlightId))) {
+            // The cached version of the row, if any, may be stale. A row which is not found was
+            // deleted, or inserted by a write which is not visible to this read.
+            if (cachedId && *cachedId == *inFlightId) {
+                _rowReader->skip();
+                ++_rowPos;
+            }
+            ++_inFlightPos;
+            if (auto record = _cursor->seekExact(*inFlightId)) {
+                return record;
+            }
+            continue;
+        }
+
+        _columnarRow.reset();
+        BSONObjBuilder builder(_columnarRow);
+        _rowReader->next(&builder);
+        builder.doneFast();
+        ++_rowPos;
+        ++_specificStats.numColumnarCacheReads;
+        return Record{*cachedId, RecordData(_columnarRow.buf(), _columnarRow.len())};
+    }
+}
+
 PlanState ScanStage::getNext() {
     if (!_cursor) {
         return trackPlanState(PlanState::IS_EOF);
@@ -207,8 +329,14 @@ PlanState ScanStage::getNext() {
 
     checkForInterrupt(_opCtx);
 
-    auto nextRecord =
-        (_firstGetNext && _seekKeyAccessor) ? _cursor->seekExact(_key) : _cursor->next();
+    boost::optional<Record> nextRecord;
+    if (_firstGetNext && _seekKeyAccessor) {
+        nextRecord = _cursor->seekExact(_key);
+    } else if (_columnarView) {
+        nextRecord = nextRecordFromColumnarCache();
+    } else {
+        nextRecord = nextRecordFromCursor();
+    }
     _firstGetNext = false;
 
     if (!nextRecord) {
@@ -264,6 +392,8 @@ PlanState ScanStage::getNext() {
 
 void ScanStage::close() {
     _commonStats.closes++;
+    _rowReader.reset();
+    _columnarView.reset();
     _cursor.reset();
     _coll.reset();
     _open = false;
@@ -416,7 +546,7 @@ void ParallelScanStage::doRestoreState() {
         return;
     }
 
-    _coll.emplace(_opCtx, _name);
+    restoreCollection(_opCtx, _name, _deprioritizeRestore, _coll);
 
     uassertStatusOK(repl::ReplicationCoordinator::get(_opCtx)->checkCanServeReadsFor(
         _opCtx, _coll->getNss(), true));
@@ -452,6 +582,7 @@ void ParallelScanStage::open(bool reOpen) {
 
     uassertStatusOK(repl::ReplicationCoordinator::get(_opCtx)->checkCanServeReadsFor(
         _opCtx, _coll->getNss(), true));
+    _deprioritizeRestore = shouldDeprioritizeRestore(_coll->getNss());
 
     const auto& collection = _coll->getCollection();
 
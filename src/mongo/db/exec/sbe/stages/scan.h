@@ -33,6 +33,7 @@
 #include "mongo/db/exec/sbe/stages/stages.h"
 #include "mongo/db/exec/sbe/values/bson.h"
 #include "mongo/db/exec/trial_run_progress_tracker.h"
+#include "mongo/db/query/columnar_cache.h"
 #include "mongo/db/storage/record_store.h"
 
 namespace mongo {
@@ -51,7 +52,8 @@ public:
               PlanYieldPolicy* yieldPolicy,
               TrialRunProgressTracker* tracker,
               PlanNodeId nodeId,
-              ScanOpenCallback openCallback = {});
+              ScanOpenCallback openCallback = {},
+              std::shared_ptr<ColumnarCollectionCache> columnarCache = nullptr);
 
     std::unique_ptr<PlanStage> clone() const final;
 
@@ -72,6 +74,18 @@ protected:
     void doAttachFromOperationContext(OperationContext* opCtx) override;
 
 private:
+    /**
+     * Returns the next record from the cursor. Full scans read records in batches of growing size;
+     * scans driven by a seek key read one record at a time.
+     */
+    boost::optional<Record> nextRecordFromCursor();
+
+    /**
+     * Returns the next row of '_columnarView' in RecordId order: a document rebuilt from the
+     * cached columns, or the record itself for a row with writes in flight.
+     */
+    boost::optional<Record> nextRecordFromColumnarCache();
+
     const NamespaceStringOrUUID _name;
     const boost::optional<value::SlotId> _recordSlot;
     const boost::optional<value::SlotId> _recordIdSlot;
@@ -86,6 +100,10 @@ private:
 
     ScanOpenCallback _openCallback;
 
+    // If set, a cache holding every field the query depends on. It serves the scan whenever it
+    // is built and the read doesn't need a point-in-time snapshot.
+    const std::shared_ptr<ColumnarCollectionCache> _columnarCache;
+
     std::unique_ptr<value::ViewOfValueAccessor> _recordAccessor;
     std::unique_ptr<value::ViewOfValueAccessor> _recordIdAccessor;
 
@@ -100,6 +118,25 @@ private:
     RecordId _key;
     bool _firstGetNext{false};
 
+    // Whether '_coll' is reacquired with low ticket priority when the stage is restored.
+    bool _deprioritizeRestore{false};
+
+    // Records read ahead from '_cursor' and the position of the next one to return. The slots of
+    // this stage hold views into the batch, which stay valid until the batch is refilled.
+    RecordBatch _batch;
+    size_t _batchPos{0};
+    size_t _nextBatchSize{1};
+
+    // The rows of '_columnarCache' read by this scan if it is served from the cache, the position
+    // of the next cached row and of the next row with writes in flight, and the buffer holding
+    // the document rebuilt for the current row.
+    boost::optional<ColumnarCollectionCache::ReadView> _columnarView;
+    size_t _rowGroupPos{0};
+    size_t _rowPos{0};
+    boost::optional<ColumnarCollectionCache::RowReader> _rowReader;
+    size_t _inFlightPos{0};
+    BufBuilder _columnarRow;
+
     ScanStats _specificStats;
 };
 
@@ -180,6 +217,9 @@ private:
 
     std::unique_ptr<SeekableRecordCursor> _cursor;
     boost::optional<AutoGetCollectionForRead> _coll;
+
+    // Whether '_coll' is reacquired with low ticket priority when the stage is restored.
+    bool _deprioritizeRestore{false};
 };
 }  // namespace sbe
 }  // namespace mongo
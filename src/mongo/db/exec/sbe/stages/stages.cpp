@@ -75,5 +75,15 @@ void CanChangeState::restoreState() {
 
     doRestoreState();
 }
+
+void PlanStage::attachNewYieldPolicy(PlanYieldPolicy* yieldPolicy) {
+    if (_yieldPolicy) {
+        _yieldPolicy = yieldPolicy;
+    }
+
+    for (auto&& child : _children) {
+        child->attachNewYieldPolicy(yieldPolicy);
+    }
+}
 }  // namespace sbe
 }  // namespace mongo
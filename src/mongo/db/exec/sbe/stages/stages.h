@@ -208,7 +208,7 @@ public:
     }
 
 protected:
-    PlanYieldPolicy* const _yieldPolicy{nullptr};
+    PlanYieldPolicy* _yieldPolicy{nullptr};
 
 private:
     static const int kInterruptCheckPeriod = 128;
@@ -239,6 +239,13 @@ public:
      */
     virtual std::unique_ptr<PlanStage> clone() const = 0;
 
+    /**
+     * Makes every stage of this tree which yields use 'yieldPolicy' instead of the policy it was
+     * built with. Stages built without a yield policy keep yielding disabled. Used to hand a
+     * clone of a cached tree over to the executor which is going to run it.
+     */
+    void attachNewYieldPolicy(PlanYieldPolicy* yieldPolicy);
+
     /**
      * Prepare this SBE PlanStage tree for execution. Must be called once, and must be called
      * prior to open(), getNext(), close(), saveState(), or restoreState(),
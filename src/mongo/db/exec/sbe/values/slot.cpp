@@ -155,6 +155,19 @@ static std::pair<TypeTags, Value> deserializeTagVal(BufReader& buf) {
             val = ksVal;
             break;
         }
+        case TypeTags::valueBlock: {
+            auto cnt = buf.read<size_t>();
+            auto [blockTag, blockVal] = makeNewValueBlock();
+            auto block = getValueBlockView(blockVal);
+            block->reserve(cnt);
+            for (size_t idx = 0; idx < cnt; ++idx) {
+                auto [elemTag, elemVal] = deserializeTagVal(buf);
+                block->push_back(elemTag, elemVal);
+            }
+            tag = blockTag;
+            val = blockVal;
+            break;
+        }
         default:
             MONGO_UNREACHABLE;
     }
@@ -273,6 +286,17 @@ static void serializeTagValue(BufBuilder& buf, TypeTags tag, Value val) {
             ks->serialize(buf);
             break;
         }
+        case TypeTags::valueBlock: {
+            // An unowned block is serialized with copies of its values, and read back as an owned
+            // one.
+            auto block = getValueBlockView(val);
+            buf.appendNum(block->size());
+            for (size_t idx = 0; idx < block->size(); ++idx) {
+                auto [elemTag, elemVal] = block->getAt(idx);
+                serializeTagValue(buf, elemTag, elemVal);
+            }
+            break;
+        }
         default:
             MONGO_UNREACHABLE;
     }
@@ -358,6 +382,15 @@ static int getApproximateSize(TypeTags tag, Value val) {
             result += ks->memUsageForSorter();
             break;
         }
+        case TypeTags::valueBlock: {
+            auto block = getValueBlockView(val);
+            result += sizeof(*block);
+            for (size_t idx = 0; idx < block->size(); ++idx) {
+                auto [tag, val] = block->getAt(idx);
+                result += block->owned() ? getApproximateSize(tag, val) : sizeof(tag) + sizeof(val);
+            }
+            break;
+        }
         default:
             MONGO_UNREACHABLE;
     }
@@ -84,6 +84,9 @@ void releaseValue(TypeTags tag, Value val) noexcept {
         case TypeTags::pcreRegex:
             delete getPcreRegexView(val);
             break;
+        case TypeTags::valueBlock:
+            delete getValueBlockView(val);
+            break;
         default:
             break;
     }
@@ -161,6 +164,9 @@ void writeTagToStream(T& stream, const TypeTags tag) {
         case TypeTags::timeZoneDB:
             stream << "timeZoneDB";
             break;
+        case TypeTags::valueBlock:
+            stream << "valueBlock";
+            break;
         default:
             stream << "unknown tag";
             break;
@@ -210,6 +216,19 @@ void writeValueToStream(T& stream, TypeTags tag, Value val) {
             stream << ']';
             break;
         }
+        case value::TypeTags::valueBlock: {
+            auto block = getValueBlockView(val);
+            stream << "block[";
+            for (size_t idx = 0; idx < block->size(); ++idx) {
+                if (idx != 0) {
+                    stream << ", ";
+                }
+                auto [tag, val] = block->getAt(idx);
+                writeValueToStream(stream, tag, val);
+            }
+            stream << ']';
+            break;
+        }
         case value::TypeTags::ArraySet: {
             auto arr = getArraySetView(val);
             stream << '[';
@@ -464,6 +483,18 @@ std::size_t hashValue(TypeTags tag, Value val) noexcept {
 
             return res;
         }
+        case TypeTags::valueBlock: {
+            auto block = getValueBlockView(val);
+            auto res = hashInit();
+
+            // There should be enough entropy in the first 4 elements.
+            for (size_t idx = 0; idx < 4 && idx < block->size(); ++idx) {
+                auto [elemTag, elemVal] = block->getAt(idx);
+                res = hashCombine(res, hashValue(elemTag, elemVal));
+            }
+
+            return res;
+        }
         case TypeTags::bsonBinData: {
             auto size = getBSONBinDataSize(tag, val);
             if (size < 8) {
@@ -619,6 +650,25 @@ std::pair<TypeTags, Value> compareValue(TypeTags lhsTag,
     } else if (lhsTag == TypeTags::ksValue && rhsTag == TypeTags::ksValue) {
         auto result = getKeyStringView(lhsValue)->compare(*getKeyStringView(lhsValue));
         return {TypeTags::NumberInt32, bitcastFrom(result)};
+    } else if (lhsTag == TypeTags::valueBlock || rhsTag == TypeTags::valueBlock) {
+        // Blocks have no BSON type to order them by, so they only compare with one another.
+        uassert(5150840,
+                "Cannot compare a value block with a value of another type",
+                lhsTag == rhsTag);
+        auto lhsBlock = getValueBlockView(lhsValue);
+        auto rhsBlock = getValueBlockView(rhsValue);
+        const auto size = std::min(lhsBlock->size(), rhsBlock->size());
+        for (size_t idx = 0; idx < size; ++idx) {
+            auto [lhsTag, lhsVal] = lhsBlock->getAt(idx);
+            auto [rhsTag, rhsVal] = rhsBlock->getAt(idx);
+
+            auto [tag, val] = compareValue(lhsTag, lhsVal, rhsTag, rhsVal);
+            if (tag != TypeTags::NumberInt32 || val != 0) {
+                return {tag, val};
+            }
+        }
+        return {TypeTags::NumberInt32,
+                bitcastFrom(compareHelper(lhsBlock->size(), rhsBlock->size()))};
     } else if (lhsTag == TypeTags::Nothing && rhsTag == TypeTags::Nothing) {
         // Special case for Nothing in a hash table (group) and sort comparison.
         return {TypeTags::NumberInt32, 0};
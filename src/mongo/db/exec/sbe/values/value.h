@@ -113,6 +113,9 @@ enum class TypeTags : uint8_t {
 
     // Pointer to a timezone database object.
     timeZoneDB,
+
+    // Pointer to a block of values used by the block-at-a-time execution mode.
+    valueBlock,
 };
 
 inline constexpr bool isNumber(TypeTags tag) noexcept {
@@ -428,6 +431,100 @@ private:
     SetType _values;
 };
 
+/**
+ * A block of values of one slot taken from consecutive rows. Blocks are produced and consumed by
+ * the block-at-a-time execution mode, where a slot holds a whole block instead of a single value
+ * and the 'valueBlock*' builtins process all of its elements in one VM call.
+ *
+ * The tags and values are kept in separate contiguous arrays so that the builtins can loop over
+ * them tightly. Unlike Array, a block keeps Nothing values because the position of a value
+ * identifies the row it came from. A block either owns all of its values or none of them; an
+ * unowned block holds views into values owned by another block (e.g. the result of extracting a
+ * field from a block of objects).
+ */
+class ValueBlock {
+public:
+    explicit ValueBlock(bool owned = true) : _owned(owned) {}
+
+    /**
+     * Makes a deep copy. The copy always owns its values.
+     */
+    ValueBlock(const ValueBlock& other) : _owned(true) {
+        reserve(other.size());
+        for (size_t idx = 0; idx < other.size(); ++idx) {
+            const auto [tag, val] = copyValue(other._typeTags[idx], other._values[idx]);
+            _typeTags.push_back(tag);
+            _values.push_back(val);
+        }
+    }
+    ValueBlock(ValueBlock&&) = default;
+    ~ValueBlock() {
+        if (_owned) {
+            for (size_t idx = 0; idx < _typeTags.size(); ++idx) {
+                releaseValue(_typeTags[idx], _values[idx]);
+            }
+        }
+    }
+
+    /**
+     * Appends a value to the block. If the block is owned, it takes ownership of the value.
+     */
+    void push_back(TypeTags tag, Value val) {
+        _typeTags.push_back(tag);
+        _values.push_back(val);
+    }
+
+    /**
+     * Resizes the block to 'count' elements. Newly added elements are Nothing. Must only be used to
+     * grow a block or on an unowned block.
+     */
+    void resize(size_t count) {
+        invariant(!_owned || count >= size());
+        _typeTags.resize(count, TypeTags::Nothing);
+        _values.resize(count, 0);
+    }
+
+    size_t size() const noexcept {
+        return _values.size();
+    }
+
+    bool owned() const noexcept {
+        return _owned;
+    }
+
+    std::pair<TypeTags, Value> getAt(std::size_t idx) const {
+        if (idx >= _values.size()) {
+            return {TypeTags::Nothing, 0};
+        }
+
+        return {_typeTags[idx], _values[idx]};
+    }
+
+    TypeTags* tags() noexcept {
+        return _typeTags.data();
+    }
+    const TypeTags* tags() const noexcept {
+        return _typeTags.data();
+    }
+
+    Value* values() noexcept {
+        return _values.data();
+    }
+    const Value* values() const noexcept {
+        return _values.data();
+    }
+
+    void reserve(size_t s) {
+        _typeTags.reserve(s);
+        _values.reserve(s);
+    }
+
+private:
+    bool _owned;
+    std::vector<TypeTags> _typeTags;
+    std::vector<Value> _values;
+};
+
 constexpr size_t kSmallStringThreshold = 8;
 using ObjectIdType = std::array<uint8_t, 12>;
 static_assert(sizeof(ObjectIdType) == 12);
@@ -617,6 +714,20 @@ inline Object* getObjectView(Value val) noexcept {
     return reinterpret_cast<Object*>(val);
 }
 
+inline std::pair<TypeTags, Value> makeNewValueBlock(bool owned = true) {
+    auto b = new ValueBlock(owned);
+    return {TypeTags::valueBlock, reinterpret_cast<Value>(b)};
+}
+
+inline std::pair<TypeTags, Value> makeCopyValueBlock(const ValueBlock& inB) {
+    auto b = new ValueBlock(inB);
+    return {TypeTags::valueBlock, reinterpret_cast<Value>(b)};
+}
+
+inline ValueBlock* getValueBlockView(Value val) noexcept {
+    return reinterpret_cast<ValueBlock*>(val);
+}
+
 inline std::pair<TypeTags, Value> makeNewObjectId() {
     auto o = new ObjectIdType;
     return {TypeTags::ObjectId, reinterpret_cast<Value>(o)};
@@ -716,6 +827,8 @@ inline std::pair<TypeTags, Value> copyValue(TypeTags tag, Value val) {
             return makeCopyKeyString(*getKeyStringView(val));
         case TypeTags::pcreRegex:
             return makeCopyPcreRegex(*getPcreRegexView(val));
+        case TypeTags::valueBlock:
+            return makeCopyValueBlock(*getValueBlockView(val));
         default:
             break;
     }
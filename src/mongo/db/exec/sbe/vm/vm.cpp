@@ -521,8 +521,11 @@ std::tuple<bool, value::TypeTags, value::Value> ByteCode::aggMin(value::TypeTags
         return {true, tag, val};
     }
 
-    auto [tag, val] = genericCompare<std::less<>>(accTag, accValue, fieldTag, fieldValue);
-    if (tag == value::TypeTags::Boolean && val) {
+    // Use the total order over all types rather than a numeric comparison, so that values of
+    // different types are ranked the same way as in the rest of the query language. On a tie the
+    // accumulated value is kept.
+    auto [tag, val] = value::compareValue(accTag, accValue, fieldTag, fieldValue);
+    if (tag == value::TypeTags::NumberInt32 && value::bitcastTo<int32_t>(val) <= 0) {
         auto [tag, val] = value::copyValue(accTag, accValue);
         return {true, tag, val};
     } else {
@@ -547,8 +550,11 @@ std::tuple<bool, value::TypeTags, value::Value> ByteCode::aggMax(value::TypeTags
         return {true, tag, val};
     }
 
-    auto [tag, val] = genericCompare<std::greater<>>(accTag, accValue, fieldTag, fieldValue);
-    if (tag == value::TypeTags::Boolean && val) {
+    // Use the total order over all types rather than a numeric comparison, so that values of
+    // different types are ranked the same way as in the rest of the query language. On a tie the
+    // accumulated value is kept.
+    auto [tag, val] = value::compareValue(accTag, accValue, fieldTag, fieldValue);
+    if (tag == value::TypeTags::NumberInt32 && value::bitcastTo<int32_t>(val) >= 0) {
         auto [tag, val] = value::copyValue(accTag, accValue);
         return {true, tag, val};
     } else {
@@ -1566,6 +1572,40 @@ std::tuple<bool, value::TypeTags, value::Value> ByteCode::dispatchBuiltin(Builti
             return builtinConcat(arity);
         case Builtin::isMember:
             return builtinIsMember(arity);
+        case Builtin::valueBlockAdd:
+            return builtinValueBlockAdd(arity);
+        case Builtin::valueBlockSub:
+            return builtinValueBlockSub(arity);
+        case Builtin::valueBlockMul:
+            return builtinValueBlockMul(arity);
+        case Builtin::valueBlockGt:
+            return builtinValueBlockGt(arity);
+        case Builtin::valueBlockGte:
+            return builtinValueBlockGte(arity);
+        case Builtin::valueBlockLt:
+            return builtinValueBlockLt(arity);
+        case Builtin::valueBlockLte:
+            return builtinValueBlockLte(arity);
+        case Builtin::valueBlockEq:
+            return builtinValueBlockEq(arity);
+        case Builtin::valueBlockNeq:
+            return builtinValueBlockNeq(arity);
+        case Builtin::valueBlockLogicalAnd:
+            return builtinValueBlockLogicalAnd(arity);
+        case Builtin::valueBlockLogicalOr:
+            return builtinValueBlockLogicalOr(arity);
+        case Builtin::valueBlockGetField:
+            return builtinValueBlockGetField(arity);
+        case Builtin::valueBlockFillEmpty:
+            return builtinValueBlockFillEmpty(arity);
+        case Builtin::valueBlockAggSum:
+            return builtinValueBlockAggSum(arity);
+        case Builtin::valueBlockAggMin:
+            return builtinValueBlockAggMin(arity);
+        case Builtin::valueBlockAggMax:
+            return builtinValueBlockAggMax(arity);
+        case Builtin::valueBlockAggCount:
+            return builtinValueBlockAggCount(arity);
     }
 
     MONGO_UNREACHABLE;
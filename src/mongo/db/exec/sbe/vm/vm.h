@@ -214,6 +214,24 @@ enum class Builtin : uint8_t {
     tan,
     tanh,
     isMember,
+    // Block-at-a-time counterparts of the scalar operations. See ValueBlock.
+    valueBlockAdd,
+    valueBlockSub,
+    valueBlockMul,
+    valueBlockGt,
+    valueBlockGte,
+    valueBlockLt,
+    valueBlockLte,
+    valueBlockEq,
+    valueBlockNeq,
+    valueBlockLogicalAnd,
+    valueBlockLogicalOr,
+    valueBlockGetField,
+    valueBlockFillEmpty,
+    valueBlockAggSum,
+    valueBlockAggMin,
+    valueBlockAggMax,
+    valueBlockAggCount,
 };
 
 class CodeFragment {
@@ -527,6 +545,25 @@ private:
     std::tuple<bool, value::TypeTags, value::Value> builtinTanh(uint8_t arity);
     std::tuple<bool, value::TypeTags, value::Value> builtinConcat(uint8_t arity);
     std::tuple<bool, value::TypeTags, value::Value> builtinIsMember(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockAdd(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockSub(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockMul(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockGt(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockGte(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockLt(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockLte(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockEq(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockNeq(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockLogicalAnd(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockLogicalOr(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockGetField(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockFillEmpty(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockAggSum(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockAggMin(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockAggMax(uint8_t arity);
+    std::tuple<bool, value::TypeTags, value::Value> builtinValueBlockAggCount(uint8_t arity);
+    template <typename Op>
+    std::tuple<bool, value::TypeTags, value::Value> valueBlockCompare(uint8_t arity);
 
     std::tuple<bool, value::TypeTags, value::Value> dispatchBuiltin(Builtin f, uint8_t arity);
 
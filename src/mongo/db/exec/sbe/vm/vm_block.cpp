@@ -0,0 +1,522 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sbe/vm/vm.h"
+
+#include <algorithm>
+
+namespace mongo {
+namespace sbe {
+namespace vm {
+
+using namespace value;
+
+namespace {
+
+/**
+ * Gives uniform per-element access to an argument of a block builtin. A scalar argument behaves
+ * like a block repeating the same value, so that blocks can be combined with constants.
+ */
+class BlockOrScalar {
+public:
+    BlockOrScalar(TypeTags tag, Value val)
+        : _block(tag == TypeTags::valueBlock ? getValueBlockView(val) : nullptr),
+          _tag(tag),
+          _val(val) {}
+
+    bool isBlock() const {
+        return _block != nullptr;
+    }
+
+    size_t size() const {
+        return _block ? _block->size() : 1;
+    }
+
+    std::pair<TypeTags, Value> operator[](size_t idx) const {
+        return _block ? std::make_pair(_block->tags()[idx], _block->values()[idx])
+                      : std::make_pair(_tag, _val);
+    }
+
+    /**
+     * Returns true if every element has the given type, in which case the caller may read the raw
+     * values directly without dispatching on the tag.
+     */
+    bool allOfType(TypeTags tag) const {
+        if (!_block) {
+            return _tag == tag;
+        }
+        return std::all_of(
+            _block->tags(), _block->tags() + _block->size(), [tag](auto t) { return t == tag; });
+    }
+
+private:
+    const ValueBlock* _block;
+    TypeTags _tag;
+    Value _val;
+};
+
+/**
+ * Returns true if the element at position 'idx' is selected by the optional bitmap. Only a
+ * Boolean true selects an element.
+ */
+bool isSelected(const ValueBlock* bitmap, size_t idx) {
+    return !bitmap ||
+        (bitmap->tags()[idx] == TypeTags::Boolean && bitcastTo<bool>(bitmap->values()[idx]));
+}
+
+/**
+ * Applies 'op' to the corresponding elements of 'lhs' and 'rhs' and collects the results into a
+ * new owned block. At least one of the arguments must be a block, and if both are they must have
+ * the same size; otherwise the result is Nothing.
+ */
+template <typename ElementOp>
+std::tuple<bool, TypeTags, Value> binaryBlockOp(const BlockOrScalar& lhs,
+                                                const BlockOrScalar& rhs,
+                                                ElementOp op) {
+    if (!lhs.isBlock() && !rhs.isBlock()) {
+        return {false, TypeTags::Nothing, 0};
+    }
+    if (lhs.isBlock() && rhs.isBlock() && lhs.size() != rhs.size()) {
+        return {false, TypeTags::Nothing, 0};
+    }
+    const size_t count = lhs.isBlock() ? lhs.size() : rhs.size();
+
+    auto [resTag, resVal] = makeNewValueBlock();
+    ValueGuard guard{resTag, resVal};
+    auto res = getValueBlockView(resVal);
+    res->reserve(count);
+
+    for (size_t idx = 0; idx < count; ++idx) {
+        auto [lhsTag, lhsVal] = lhs[idx];
+        auto [rhsTag, rhsVal] = rhs[idx];
+        auto [owned, tag, val] = op(lhsTag, lhsVal, rhsTag, rhsVal);
+        if (!owned) {
+            std::tie(tag, val) = copyValue(tag, val);
+        }
+        res->push_back(tag, val);
+    }
+
+    guard.reset();
+    return {true, resTag, resVal};
+}
+
+/**
+ * The fast path for arithmetic over blocks where every element is a double. Returns Nothing if
+ * the arguments do not qualify, in which case the caller falls back to the generic path.
+ */
+template <typename Op>
+std::tuple<bool, TypeTags, Value> doubleBlockArithmeticOp(const BlockOrScalar& lhs,
+                                                          const BlockOrScalar& rhs,
+                                                          Op op) {
+    if ((!lhs.isBlock() && !rhs.isBlock()) ||
+        (lhs.isBlock() && rhs.isBlock() && lhs.size() != rhs.size()) ||
+        !lhs.allOfType(TypeTags::NumberDouble) || !rhs.allOfType(TypeTags::NumberDouble)) {
+        return {false, TypeTags::Nothing, 0};
+    }
+    const size_t count = lhs.isBlock() ? lhs.size() : rhs.size();
+
+    auto [resTag, resVal] = makeNewValueBlock();
+    ValueGuard guard{resTag, resVal};
+    auto res = getValueBlockView(resVal);
+    res->resize(count);
+
+    auto tags = res->tags();
+    auto vals = res->values();
+    for (size_t idx = 0; idx < count; ++idx) {
+        tags[idx] = TypeTags::NumberDouble;
+        vals[idx] = bitcastFrom<double>(
+            op(bitcastTo<double>(lhs[idx].second), bitcastTo<double>(rhs[idx].second)));
+    }
+
+    guard.reset();
+    return {true, resTag, resVal};
+}
+
+/**
+ * Resolves the optional bitmap argument of a block aggregate into 'bitmap'. Returns false if the
+ * bitmap is present but is not a block of the same size as 'block', in which case nothing should
+ * be aggregated.
+ */
+bool resolveBitmap(bool hasBitmap,
+                   TypeTags bitmapTag,
+                   Value bitmapVal,
+                   const ValueBlock* block,
+                   const ValueBlock*& bitmap) {
+    bitmap = nullptr;
+    if (!hasBitmap) {
+        return true;
+    }
+    if (bitmapTag != TypeTags::valueBlock ||
+        getValueBlockView(bitmapVal)->size() != block->size()) {
+        return false;
+    }
+    bitmap = getValueBlockView(bitmapVal);
+    return true;
+}
+
+/**
+ * Folds the selected elements of 'block' into the accumulator using 'aggOp', which has the same
+ * contract as the scalar aggregate helpers (e.g. ByteCode::aggSum): it does not consume its inputs
+ * and returns a new accumulator value.
+ */
+template <typename AggOp>
+std::tuple<bool, TypeTags, Value> foldValueBlock(bool ownedAcc,
+                                                 TypeTags accTag,
+                                                 Value accVal,
+                                                 const ValueBlock* block,
+                                                 const ValueBlock* bitmap,
+                                                 AggOp aggOp) {
+    for (size_t idx = 0; idx < block->size(); ++idx) {
+        if (!isSelected(bitmap, idx)) {
+            continue;
+        }
+        auto [owned, tag, val] = aggOp(accTag, accVal, block->tags()[idx], block->values()[idx]);
+        if (ownedAcc) {
+            releaseValue(accTag, accVal);
+        }
+        ownedAcc = owned;
+        accTag = tag;
+        accVal = val;
+    }
+    return {ownedAcc, accTag, accVal};
+}
+}  // namespace
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockAdd(uint8_t arity) {
+    invariant(arity == 2);
+    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(1);
+    BlockOrScalar lhs{lhsTag, lhsVal}, rhs{rhsTag, rhsVal};
+
+    if (auto res = doubleBlockArithmeticOp(lhs, rhs, std::plus<>{});
+        std::get<1>(res) != TypeTags::Nothing) {
+        return res;
+    }
+    return binaryBlockOp(lhs, rhs, [this](TypeTags lt, Value lv, TypeTags rt, Value rv) {
+        return genericAdd(lt, lv, rt, rv);
+    });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockSub(uint8_t arity) {
+    invariant(arity == 2);
+    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(1);
+    BlockOrScalar lhs{lhsTag, lhsVal}, rhs{rhsTag, rhsVal};
+
+    if (auto res = doubleBlockArithmeticOp(lhs, rhs, std::minus<>{});
+        std::get<1>(res) != TypeTags::Nothing) {
+        return res;
+    }
+    return binaryBlockOp(lhs, rhs, [this](TypeTags lt, Value lv, TypeTags rt, Value rv) {
+        return genericSub(lt, lv, rt, rv);
+    });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockMul(uint8_t arity) {
+    invariant(arity == 2);
+    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(1);
+    BlockOrScalar lhs{lhsTag, lhsVal}, rhs{rhsTag, rhsVal};
+
+    if (auto res = doubleBlockArithmeticOp(lhs, rhs, std::multiplies<>{});
+        std::get<1>(res) != TypeTags::Nothing) {
+        return res;
+    }
+    return binaryBlockOp(lhs, rhs, [this](TypeTags lt, Value lv, TypeTags rt, Value rv) {
+        return genericMul(lt, lv, rt, rv);
+    });
+}
+
+template <typename Op>
+std::tuple<bool, TypeTags, Value> ByteCode::valueBlockCompare(uint8_t arity) {
+    invariant(arity == 2);
+    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(1);
+
+    return binaryBlockOp(BlockOrScalar{lhsTag, lhsVal},
+                         BlockOrScalar{rhsTag, rhsVal},
+                         [this](TypeTags lt, Value lv, TypeTags rt, Value rv) {
+                             auto [tag, val] = genericCompare<Op>(lt, lv, rt, rv);
+                             return std::make_tuple(false, tag, val);
+                         });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockGt(uint8_t arity) {
+    return valueBlockCompare<std::greater<>>(arity);
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockGte(uint8_t arity) {
+    return valueBlockCompare<std::greater_equal<>>(arity);
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockLt(uint8_t arity) {
+    return valueBlockCompare<std::less<>>(arity);
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockLte(uint8_t arity) {
+    return valueBlockCompare<std::less_equal<>>(arity);
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockEq(uint8_t arity) {
+    invariant(arity == 2);
+    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(1);
+
+    return binaryBlockOp(BlockOrScalar{lhsTag, lhsVal},
+                         BlockOrScalar{rhsTag, rhsVal},
+                         [this](TypeTags lt, Value lv, TypeTags rt, Value rv) {
+                             auto [tag, val] = genericCompareEq(lt, lv, rt, rv);
+                             return std::make_tuple(false, tag, val);
+                         });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockNeq(uint8_t arity) {
+    invariant(arity == 2);
+    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(1);
+
+    return binaryBlockOp(BlockOrScalar{lhsTag, lhsVal},
+                         BlockOrScalar{rhsTag, rhsVal},
+                         [this](TypeTags lt, Value lv, TypeTags rt, Value rv) {
+                             auto [tag, val] = genericCompareNeq(lt, lv, rt, rv);
+                             return std::make_tuple(false, tag, val);
+                         });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockLogicalAnd(uint8_t arity) {
+    invariant(arity == 2);
+    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(1);
+
+    // A false operand makes the result false even if the other operand is Nothing, which matches
+    // the short-circuiting of the scalar '&&'.
+    return binaryBlockOp(BlockOrScalar{lhsTag, lhsVal},
+                         BlockOrScalar{rhsTag, rhsVal},
+                         [](TypeTags lt, Value lv, TypeTags rt, Value rv) {
+                             const bool lhsBool = lt == TypeTags::Boolean;
+                             const bool rhsBool = rt == TypeTags::Boolean;
+                             if ((lhsBool && !bitcastTo<bool>(lv)) ||
+                                 (rhsBool && !bitcastTo<bool>(rv))) {
+                                 return std::make_tuple(
+                                     false, TypeTags::Boolean, bitcastFrom<bool>(false));
+                             }
+                             if (lhsBool && rhsBool) {
+                                 return std::make_tuple(
+                                     false, TypeTags::Boolean, bitcastFrom<bool>(true));
+                             }
+                             return std::make_tuple(false, TypeTags::Nothing, Value{0});
+                         });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockLogicalOr(uint8_t arity) {
+    invariant(arity == 2);
+    auto [lhsOwned, lhsTag, lhsVal] = getFromStack(0);
+    auto [rhsOwned, rhsTag, rhsVal] = getFromStack(1);
+
+    return binaryBlockOp(BlockOrScalar{lhsTag, lhsVal},
+                         BlockOrScalar{rhsTag, rhsVal},
+                         [](TypeTags lt, Value lv, TypeTags rt, Value rv) {
+                             const bool lhsBool = lt == TypeTags::Boolean;
+                             const bool rhsBool = rt == TypeTags::Boolean;
+                             if ((lhsBool && bitcastTo<bool>(lv)) ||
+                                 (rhsBool && bitcastTo<bool>(rv))) {
+                                 return std::make_tuple(
+                                     false, TypeTags::Boolean, bitcastFrom<bool>(true));
+                             }
+                             if (lhsBool && rhsBool) {
+                                 return std::make_tuple(
+                                     false, TypeTags::Boolean, bitcastFrom<bool>(false));
+                             }
+                             return std::make_tuple(false, TypeTags::Nothing, Value{0});
+                         });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockGetField(uint8_t arity) {
+    invariant(arity == 2);
+    auto [blockOwned, blockTag, blockVal] = getFromStack(0);
+    auto [fieldOwned, fieldTag, fieldVal] = getFromStack(1);
+
+    if (blockTag != TypeTags::valueBlock) {
+        return {false, TypeTags::Nothing, 0};
+    }
+    auto block = getValueBlockView(blockVal);
+
+    // The extracted fields are views into the input block. If the input is a temporary that is
+    // released once this builtin returns, the result has to own copies instead.
+    auto [resTag, resVal] = makeNewValueBlock(blockOwned);
+    ValueGuard guard{resTag, resVal};
+    auto res = getValueBlockView(resVal);
+    res->reserve(block->size());
+
+    for (size_t idx = 0; idx < block->size(); ++idx) {
+        auto [owned, tag, val] =
+            getField(block->tags()[idx], block->values()[idx], fieldTag, fieldVal);
+        invariant(!owned);
+        if (blockOwned) {
+            std::tie(tag, val) = copyValue(tag, val);
+        }
+        res->push_back(tag, val);
+    }
+
+    guard.reset();
+    return {true, resTag, resVal};
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockFillEmpty(uint8_t arity) {
+    invariant(arity == 2);
+    auto [blockOwned, blockTag, blockVal] = getFromStack(0);
+    auto [fillOwned, fillTag, fillVal] = getFromStack(1);
+
+    if (blockTag != TypeTags::valueBlock) {
+        return {false, TypeTags::Nothing, 0};
+    }
+
+    return binaryBlockOp(BlockOrScalar{blockTag, blockVal},
+                         BlockOrScalar{fillTag, fillVal},
+                         [](TypeTags lt, Value lv, TypeTags rt, Value rv) {
+                             return lt == TypeTags::Nothing ? std::make_tuple(false, rt, rv)
+                                                            : std::make_tuple(false, lt, lv);
+                         });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockAggSum(uint8_t arity) {
+    auto [ownedAcc, accTag, accVal] = getFromStack(0);
+    // Take ownership of the accumulator.
+    topStack(false, TypeTags::Nothing, 0);
+
+    auto [blockOwned, blockTag, blockVal] = getFromStack(1);
+    auto [bitmapOwned, bitmapTag, bitmapVal] =
+        arity == 3 ? getFromStack(2) : std::make_tuple(false, TypeTags::Nothing, Value{0});
+    const ValueBlock* bitmap;
+    if (blockTag != TypeTags::valueBlock ||
+        !resolveBitmap(arity == 3, bitmapTag, bitmapVal, getValueBlockView(blockVal), bitmap)) {
+        return {ownedAcc, accTag, accVal};
+    }
+    auto block = getValueBlockView(blockVal);
+
+    // Sum a column of doubles without going through the generic addition for every element.
+    if ((accTag == TypeTags::Nothing || accTag == TypeTags::NumberDouble) &&
+        BlockOrScalar{blockTag, blockVal}.allOfType(TypeTags::NumberDouble)) {
+        bool any = accTag == TypeTags::NumberDouble;
+        double sum = any ? bitcastTo<double>(accVal) : 0.0;
+        for (size_t idx = 0; idx < block->size(); ++idx) {
+            if (isSelected(bitmap, idx)) {
+                sum += bitcastTo<double>(block->values()[idx]);
+                any = true;
+            }
+        }
+        if (!any) {
+            return {false, TypeTags::Nothing, 0};
+        }
+        return {false, TypeTags::NumberDouble, bitcastFrom<double>(sum)};
+    }
+
+    return foldValueBlock(ownedAcc,
+                          accTag,
+                          accVal,
+                          block,
+                          bitmap,
+                          [this](TypeTags accTag, Value accVal, TypeTags tag, Value val) {
+                              return aggSum(accTag, accVal, tag, val);
+                          });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockAggMin(uint8_t arity) {
+    auto [ownedAcc, accTag, accVal] = getFromStack(0);
+    // Take ownership of the accumulator.
+    topStack(false, TypeTags::Nothing, 0);
+
+    auto [blockOwned, blockTag, blockVal] = getFromStack(1);
+    auto [bitmapOwned, bitmapTag, bitmapVal] =
+        arity == 3 ? getFromStack(2) : std::make_tuple(false, TypeTags::Nothing, Value{0});
+    const ValueBlock* bitmap;
+    if (blockTag != TypeTags::valueBlock ||
+        !resolveBitmap(arity == 3, bitmapTag, bitmapVal, getValueBlockView(blockVal), bitmap)) {
+        return {ownedAcc, accTag, accVal};
+    }
+
+    return foldValueBlock(ownedAcc,
+                          accTag,
+                          accVal,
+                          getValueBlockView(blockVal),
+                          bitmap,
+                          [this](TypeTags accTag, Value accVal, TypeTags tag, Value val) {
+                              return aggMin(accTag, accVal, tag, val);
+                          });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockAggMax(uint8_t arity) {
+    auto [ownedAcc, accTag, accVal] = getFromStack(0);
+    // Take ownership of the accumulator.
+    topStack(false, TypeTags::Nothing, 0);
+
+    auto [blockOwned, blockTag, blockVal] = getFromStack(1);
+    auto [bitmapOwned, bitmapTag, bitmapVal] =
+        arity == 3 ? getFromStack(2) : std::make_tuple(false, TypeTags::Nothing, Value{0});
+    const ValueBlock* bitmap;
+    if (blockTag != TypeTags::valueBlock ||
+        !resolveBitmap(arity == 3, bitmapTag, bitmapVal, getValueBlockView(blockVal), bitmap)) {
+        return {ownedAcc, accTag, accVal};
+    }
+
+    return foldValueBlock(ownedAcc,
+                          accTag,
+                          accVal,
+                          getValueBlockView(blockVal),
+                          bitmap,
+                          [this](TypeTags accTag, Value accVal, TypeTags tag, Value val) {
+                              return aggMax(accTag, accVal, tag, val);
+                          });
+}
+
+std::tuple<bool, TypeTags, Value> ByteCode::builtinValueBlockAggCount(uint8_t arity) {
+    auto [ownedAcc, accTag, accVal] = getFromStack(0);
+    auto [blockOwned, blockTag, blockVal] = getFromStack(1);
+    auto [bitmapOwned, bitmapTag, bitmapVal] =
+        arity == 3 ? getFromStack(2) : std::make_tuple(false, TypeTags::Nothing, Value{0});
+
+    int64_t count = accTag == TypeTags::NumberInt64 ? bitcastTo<int64_t>(accVal) : 0;
+    const ValueBlock* bitmap;
+    if (blockTag == TypeTags::valueBlock &&
+        resolveBitmap(arity == 3, bitmapTag, bitmapVal, getValueBlockView(blockVal), bitmap)) {
+        auto block = getValueBlockView(blockVal);
+        for (size_t idx = 0; idx < block->size(); ++idx) {
+            if (isSelected(bitmap, idx) && block->tags()[idx] != TypeTags::Nothing) {
+                ++count;
+            }
+        }
+    }
+
+    return {false, TypeTags::NumberInt64, bitcastFrom<int64_t>(count)};
+}
+}  // namespace vm
+}  // namespace sbe
+}  // namespace mongo
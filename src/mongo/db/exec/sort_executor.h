@@ -172,8 +172,9 @@ public:
     }
 
 private:
-    SortOptions makeSortOptions() const {
+    SortOptions makeSortOptions() {
         SortOptions opts;
+        opts.fileStats = &_stats.spillStats;
         if (_stats.limit) {
             opts.limit = _stats.limit;
         }
@@ -33,6 +33,8 @@
 
 #include "mongo/db/index/btree_access_method.h"
 
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
 #include <utility>
 #include <vector>
 
@@ -54,6 +56,9 @@
 #include "mongo/db/storage/execution_context.h"
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/logv2/log.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/producer_consumer_queue.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/stacktrace.h"
@@ -102,6 +107,71 @@ MultikeyPaths createMultikeyPaths(const std::vector<MultikeyPath>& multikeyPaths
     return multikeyPaths;
 }
 
+/**
+ * Adds the path components in 'from' to those in 'into'.
+ */
+void mergeMultikeyPaths(MultikeyPaths* into, const MultikeyPaths& from) {
+    if (from.empty()) {
+        return;
+    }
+    if (into->empty()) {
+        *into = from;
+        return;
+    }
+
+    invariant(into->size() == from.size());
+    for (size_t i = 0; i < from.size(); ++i) {
+        (*into)[i].insert(
+            boost::container::ordered_unique_range_t(), from[i].begin(), from[i].end());
+    }
+}
+
+void logSuppressedKeyGenerationError(const Status& status,
+                                     const RecordId& loc,
+                                     const BSONObj& obj) {
+    LOGV2_DEBUG(20684,
+                1,
+                "Recording suppressed key generation error to retry later: "
+                "{error} on {loc}: {obj}",
+                "error"_attr = status,
+                "loc"_attr = loc,
+                "obj"_attr = redact(obj));
+}
+
+// Limits on the documents the thread scanning the collection accumulates before handing them to
+// the thread of a partition, and on the batches queued for each such thread.
+constexpr size_t kMaxDocumentsPerBatch = 256;
+constexpr size_t kMaxBytesPerBatch = 1024 * 1024;
+constexpr size_t kMaxQueuedBatchesPerThread = 2;
+
+/**
+ * Returns the most bytes of documents held in batches for 'numThreads' partition threads: the
+ * batches queued for each thread and the one it works on, and the batch being filled. This ignores
+ * that a batch may go over kMaxBytesPerBatch by its last document.
+ */
+size_t getMaxBatchedBytes(size_t numThreads) {
+    return (numThreads * (kMaxQueuedBatchesPerThread + 1) + 1) * kMaxBytesPerBatch;
+}
+
+/**
+ * Returns the number of partitions, out of at most 'numThreads', that an index build with a budget
+ * of 'maxMemoryUsageBytes' splits its documents into. The batched documents take up at most half
+ * of the budget, and the Sorters of the partitions share the rest.
+ */
+size_t getNumPartitions(size_t maxMemoryUsageBytes, size_t numThreads) {
+    while (numThreads > 1 && getMaxBatchedBytes(numThreads) > maxMemoryUsageBytes / 2) {
+        --numThreads;
+    }
+    return numThreads;
+}
+
+size_t getSorterMaxMemoryUsageBytes(size_t maxMemoryUsageBytes, size_t numPartitions) {
+    if (numPartitions == 1) {
+        return maxMemoryUsageBytes;
+    }
+    return (maxMemoryUsageBytes - getMaxBatchedBytes(numPartitions)) / numPartitions;
+}
+
 }  // namespace
 
 struct BtreeExternalSortComparison {
@@ -471,17 +541,24 @@ Status AbstractIndexAccessMethod::compact(OperationContext* opCtx) {
 
 class AbstractIndexAccessMethod::BulkBuilderImpl : public IndexAccessMethod::BulkBuilder {
 public:
-    BulkBuilderImpl(IndexCatalogEntry* indexCatalogEntry, size_t maxMemoryUsageBytes);
+    BulkBuilderImpl(IndexCatalogEntry* indexCatalogEntry,
+                    size_t maxMemoryUsageBytes,
+                    size_t numThreads);
 
     BulkBuilderImpl(IndexCatalogEntry* index,
                     size_t maxMemoryUsageBytes,
+                    size_t numThreads,
                     const IndexStateInfo& stateInfo);
 
+    ~BulkBuilderImpl();
+
     Status insert(OperationContext* opCtx,
                   const BSONObj& obj,
                   const RecordId& loc,
                   const InsertDeleteOptions& options) final;
 
+    Status waitForPendingInserts(OperationContext* opCtx) final;
+
     const MultikeyPaths& getMultikeyPaths() const final;
 
     bool isMultikey() const final;
@@ -497,6 +574,56 @@ public:
     Sorter::PersistedState persistDataForShutdown() final;
 
 private:
+    // A batch of owned documents handed to the thread of a partition.
+    struct Batch {
+        std::vector<std::pair<BSONObj, RecordId>> docs;
+        InsertDeleteOptions options;
+    };
+
+    using BatchQueue = SingleProducerSingleConsumerQueue<Batch>;
+
+    /**
+     * Generates and sorts the keys of a subset of the documents. When there is more than one
+     * partition, each has its own thread and the documents are dealt out among them in batches.
+     * Otherwise the only partition is filled by the thread calling insert().
+     */
+    struct Partition {
+        explicit Partition(std::unique_ptr<Sorter> sorter) : sorter(std::move(sorter)) {}
+
+        std::unique_ptr<Sorter> sorter;
+
+        // Accumulated since the last call to waitForPendingInserts(), which merges them into the
+        // BulkBuilderImpl.
+        int64_t keysInserted = 0;
+        bool isMultiKey = false;
+        MultikeyPaths indexMultikeyPaths;
+        KeyStringSet multikeyMetadataKeys;
+
+        // Documents whose key generation errors were suppressed on the thread of this partition,
+        // to be recorded as skipped by waitForPendingInserts(), which has an OperationContext.
+        std::vector<RecordId> skippedRecords;
+
+        // The first error encountered by the thread of this partition.
+        Status status = Status::OK();
+
+        std::unique_ptr<BatchQueue> queue;
+    };
+
+    void _insertIntoPartition(Partition* partition,
+                              StorageExecutionContext& executionCtx,
+                              const BSONObj& obj,
+                              const RecordId& loc,
+                              const InsertDeleteOptions& options,
+                              const OnSuppressedErrorFn& onSuppressedError);
+
+    void _startThreads();
+
+    void _runThread(Partition* partition);
+
+    void _pushPendingBatch(OperationContext* opCtx);
+
+    void _stopThreads();
+
     void _insertMultikeyMetadataKeysIntoSorter();
 
     Sorter* _makeSorter(
@@ -507,7 +634,24 @@ private:
     Sorter::Settings _makeSorterSettings() const;
 
     IndexCatalogEntry* _indexCatalogEntry;
-    std::unique_ptr<Sorter> _sorter;
+
+    // The first partition also receives the multikey metadata keys and, when resuming, holds the
+    // keys sorted before the index build was interrupted.
+    std::vector<std::unique_ptr<Partition>> _partitions;
+
+    // Runs the thread of each partition while the documents are dealt out among them.
+    std::unique_ptr<ThreadPool> _threadPool;
+
+    // Documents which have not been handed to a partition yet.
+    Batch _pendingBatch;
+    size_t _pendingBatchBytes = 0;
+
+    size_t _nextPartition = 0;
+    bool _threadsRunning = false;
+
+    // Set when the thread of any partition has failed, to stop the collection scan early.
+    AtomicWord<bool> _threadFailed{false};
+
     int64_t _keysInserted = 0;
 
     // Set to true if any document added to the BulkBuilder causes the index to become multikey.
@@ -524,85 +668,279 @@ private:
 };
 
 std::unique_ptr<IndexAccessMethod::BulkBuilder> AbstractIndexAccessMethod::initiateBulk(
-    size_t maxMemoryUsageBytes, const boost::optional<IndexStateInfo>& stateInfo) {
-    return stateInfo
-        ? std::make_unique<BulkBuilderImpl>(_indexCatalogEntry, maxMemoryUsageBytes, *stateInfo)
-        : std::make_unique<BulkBuilderImpl>(_indexCatalogEntry, maxMemoryUsageBytes);
+    size_t maxMemoryUsageBytes,
+    const boost::optional<IndexStateInfo>& stateInfo,
+    size_t numThreads) {
+    return stateInfo ? std::make_unique<BulkBuilderImpl>(
+                           _indexCatalogEntry, maxMemoryUsageBytes, numThreads, *stateInfo)
+                     : std::make_unique<BulkBuilderImpl>(
+                           _indexCatalogEntry, maxMemoryUsageBytes, numThreads);
 }
 
 AbstractIndexAccessMethod::BulkBuilderImpl::BulkBuilderImpl(IndexCatalogEntry* index,
-                                                            size_t maxMemoryUsageBytes)
-    : _indexCatalogEntry(index), _sorter(_makeSorter(maxMemoryUsageBytes)) {}
+                                                            size_t maxMemoryUsageBytes,
+                                                            size_t numThreads)
+    : _indexCatalogEntry(index) {
+    invariant(numThreads > 0);
+    const auto numPartitions = getNumPartitions(maxMemoryUsageBytes, numThreads);
+    const auto sorterMaxMemoryUsageBytes =
+        getSorterMaxMemoryUsageBytes(maxMemoryUsageBytes, numPartitions);
+    for (size_t i = 0; i < numPartitions; ++i) {
+        _partitions.push_back(std::make_unique<Partition>(
+            std::unique_ptr<Sorter>(_makeSorter(sorterMaxMemoryUsageBytes))));
+    }
+}
 
 AbstractIndexAccessMethod::BulkBuilderImpl::BulkBuilderImpl(IndexCatalogEntry* index,
                                                             size_t maxMemoryUsageBytes,
+                                                            size_t numThreads,
                                                             const IndexStateInfo& stateInfo)
     : _indexCatalogEntry(index),
-      _sorter(_makeSorter(maxMemoryUsageBytes, stateInfo.getFileName(), stateInfo.getRanges())),
       _keysInserted(stateInfo.getNumKeys().value_or(0)),
       _isMultiKey(stateInfo.getIsMultikey()),
-      _indexMultikeyPaths(createMultikeyPaths(stateInfo.getMultikeyPaths())) {}
+      _indexMultikeyPaths(createMultikeyPaths(stateInfo.getMultikeyPaths())) {
+    invariant(numThreads > 0);
+    const auto numPartitions = getNumPartitions(maxMemoryUsageBytes, numThreads);
+    const auto sorterMaxMemoryUsageBytes =
+        getSorterMaxMemoryUsageBytes(maxMemoryUsageBytes, numPartitions);
+    _partitions.push_back(std::make_unique<Partition>(std::unique_ptr<Sorter>(_makeSorter(
+        sorterMaxMemoryUsageBytes, stateInfo.getFileName(), stateInfo.getRanges()))));
+    for (size_t i = 1; i < numPartitions; ++i) {
+        _partitions.push_back(std::make_unique<Partition>(
+            std::unique_ptr<Sorter>(_makeSorter(sorterMaxMemoryUsageBytes))));
+    }
+}
+
+AbstractIndexAccessMethod::BulkBuilderImpl::~BulkBuilderImpl() {
+    if (_threadsRunning) {
+        _stopThreads();
+    }
+}
 
 Status AbstractIndexAccessMethod::BulkBuilderImpl::insert(OperationContext* opCtx,
                                                           const BSONObj& obj,
                                                           const RecordId& loc,
                                                           const InsertDeleteOptions& options) {
-    auto& executionCtx = StorageExecutionContext::get(opCtx);
+    if (_partitions.size() == 1) {
+        try {
+            _insertIntoPartition(
+                _partitions.front().get(),
+                StorageExecutionContext::get(opCtx),
+                obj,
+                loc,
+                options,
+                [&](Status status, const BSONObj&, boost::optional<RecordId>) {
+                    // If a key generation error was suppressed, record the document as "skipped"
+                    // so the index builder can retry at a point when data is consistent.
+                    auto interceptor = _indexCatalogEntry->indexBuildInterceptor();
+                    if (interceptor && interceptor->getSkippedRecordTracker()) {
+                        logSuppressedKeyGenerationError(status, loc, obj);
+                        interceptor->getSkippedRecordTracker()->record(opCtx, loc);
+                    }
+                });
+        } catch (...) {
+            return exceptionToStatus();
+        }
+        return Status::OK();
+    }
 
-    auto keys = executionCtx.keys();
-    auto multikeyPaths = executionCtx.multikeyPaths();
+    if (_threadFailed.load()) {
+        // Returns the error which stopped the thread.
+        return waitForPendingInserts(opCtx);
+    }
 
     try {
-        _indexCatalogEntry->accessMethod()->getKeys(
-            executionCtx.pooledBufferBuilder(),
-            obj,
-            options.getKeysMode,
-            GetKeysContext::kAddingKeys,
-            keys.get(),
-            &_multikeyMetadataKeys,
-            multikeyPaths.get(),
-            loc,
-            [&](Status status, const BSONObj&, boost::optional<RecordId>) {
-                // If a key generation error was suppressed, record the document as "skipped" so the
-                // index builder can retry at a point when data is consistent.
-                auto interceptor = _indexCatalogEntry->indexBuildInterceptor();
-                if (interceptor && interceptor->getSkippedRecordTracker()) {
-                    LOGV2_DEBUG(20684,
-                                1,
-                                "Recording suppressed key generation error to retry later: "
-                                "{error} on {loc}: {obj}",
-                                "error"_attr = status,
-                                "loc"_attr = loc,
-                                "obj"_attr = redact(obj));
-                    interceptor->getSkippedRecordTracker()->record(opCtx, loc);
-                }
-            });
+        if (!_threadsRunning) {
+            _startThreads();
+        }
+
+        // Hand off a full batch before adding the document to the next one, so that a document
+        // is not partially inserted if the push is interrupted.
+        if (_pendingBatch.docs.size() >= kMaxDocumentsPerBatch ||
+            _pendingBatchBytes >= kMaxBytesPerBatch) {
+            _pushPendingBatch(opCtx);
+        }
+
+        _pendingBatch.docs.emplace_back(obj.getOwned(), loc);
+        _pendingBatch.options = options;
+        _pendingBatchBytes += obj.objsize();
     } catch (...) {
         return exceptionToStatus();
     }
+    return Status::OK();
+}
 
-    if (!multikeyPaths->empty()) {
-        if (_indexMultikeyPaths.empty()) {
-            _indexMultikeyPaths = *multikeyPaths;
-        } else {
-            invariant(_indexMultikeyPaths.size() == multikeyPaths->size());
-            for (size_t i = 0; i < multikeyPaths->size(); ++i) {
-                _indexMultikeyPaths[i].insert(boost::container::ordered_unique_range_t(),
-                                              (*multikeyPaths)[i].begin(),
-                                              (*multikeyPaths)[i].end());
+void AbstractIndexAccessMethod::BulkBuilderImpl::_insertIntoPartition(
+    Partition* partition,
+    StorageExecutionContext& executionCtx,
+    const BSONObj& obj,
+    const RecordId& loc,
+    const InsertDeleteOptions& options,
+    const OnSuppressedErrorFn& onSuppressedError) {
+    auto keys = executionCtx.keys();
+    auto multikeyPaths = executionCtx.multikeyPaths();
+
+    _indexCatalogEntry->accessMethod()->getKeys(executionCtx.pooledBufferBuilder(),
+                                                obj,
+                                                options.getKeysMode,
+                                                GetKeysContext::kAddingKeys,
+                                                keys.get(),
+                                                &partition->multikeyMetadataKeys,
+                                                multikeyPaths.get(),
+                                                loc,
+                                                onSuppressedError);
+
+    mergeMultikeyPaths(&partition->indexMultikeyPaths, *multikeyPaths);
+
+    for (const auto& keyString : *keys) {
+        partition->sorter->add(keyString, mongo::NullValue());
+        ++partition->keysInserted;
+    }
+
+    partition->isMultiKey = partition->isMultiKey ||
+        _indexCatalogEntry->accessMethod()->shouldMarkIndexAsMultikey(
+            keys->size(), partition->multikeyMetadataKeys, *multikeyPaths);
+}
+
+void AbstractIndexAccessMethod::BulkBuilderImpl::_startThreads() {
+    invariant(!_threadsRunning);
+
+    ThreadPool::Options options;
+    options.poolName = "IndexBuildSorter";
+    options.threadNamePrefix = "IndexBuildSorter-";
+    options.minThreads = 0;
+    options.maxThreads = _partitions.size();
+    options.onCreateThread = [](const std::string& name) { Client::initThread(name); };
+    _threadPool = std::make_unique<ThreadPool>(options);
+    _threadPool->startup();
+
+    for (auto& partition : _partitions) {
+        BatchQueue::Options queueOptions;
+        queueOptions.maxQueueDepth = kMaxQueuedBatchesPerThread;
+        partition->queue = std::make_unique<BatchQueue>(queueOptions);
+        _threadPool->schedule([this, partition = partition.get()](Status status) {
+            if (!status.isOK()) {
+                partition->status = std::move(status);
+                _threadFailed.store(true);
+                return;
             }
+            _runThread(partition);
+        });
+    }
+    _threadsRunning = true;
+}
+
+void AbstractIndexAccessMethod::BulkBuilderImpl::_runThread(Partition* partition) {
+    StorageExecutionContext executionCtx;
+    auto interceptor = _indexCatalogEntry->indexBuildInterceptor();
+    const bool trackSkippedRecords = interceptor && interceptor->getSkippedRecordTracker();
+
+    while (true) {
+        Batch batch;
+        try {
+            batch = partition->queue->pop();
+        } catch (const ExceptionFor<ErrorCodes::ProducerConsumerQueueConsumed>&) {
+            return;
+        }
+
+        // After an error, keep consuming so that the producer never blocks on a full queue.
+        if (!partition->status.isOK()) {
+            continue;
+        }
+
+        try {
+            for (const auto& doc : batch.docs) {
+                const auto& loc = doc.second;
+                _insertIntoPartition(
+                    partition,
+                    executionCtx,
+                    doc.first,
+                    loc,
+                    batch.options,
+                    [&](Status status, const BSONObj& obj, boost::optional<RecordId>) {
+                        if (trackSkippedRecords) {
+                            logSuppressedKeyGenerationError(status, loc, obj);
+                            partition->skippedRecords.push_back(loc);
+                        }
+                    });
+            }
+        } catch (...) {
+            partition->status = exceptionToStatus();
+            _threadFailed.store(true);
         }
     }
+}
 
-    for (const auto& keyString : *keys) {
-        _sorter->add(keyString, mongo::NullValue());
-        ++_keysInserted;
+void AbstractIndexAccessMethod::BulkBuilderImpl::_pushPendingBatch(OperationContext* opCtx) {
+    auto& partition = _partitions[_nextPartition];
+    _nextPartition = (_nextPartition + 1) % _partitions.size();
+
+    // Blocks while the thread of the partition is behind. Without an OperationContext, the wait is
+    // not interruptible, which is only used once the collection scan is over.
+    if (opCtx) {
+        partition->queue->push(std::move(_pendingBatch), opCtx);
+    } else {
+        partition->queue->push(std::move(_pendingBatch));
     }
+    _pendingBatch.docs.clear();
+    _pendingBatchBytes = 0;
+}
 
-    _isMultiKey = _isMultiKey ||
-        _indexCatalogEntry->accessMethod()->shouldMarkIndexAsMultikey(
-            keys->size(), _multikeyMetadataKeys, *multikeyPaths);
+void AbstractIndexAccessMethod::BulkBuilderImpl::_stopThreads() {
+    invariant(_threadsRunning);
+    for (auto& partition : _partitions) {
+        partition->queue->closeProducerEnd();
+    }
+    _threadPool->shutdown();
+    _threadPool->join();
+    _threadPool.reset();
+    for (auto& partition : _partitions) {
+        partition->queue.reset();
+    }
+    _threadsRunning = false;
+}
+
+Status AbstractIndexAccessMethod::BulkBuilderImpl::waitForPendingInserts(OperationContext* opCtx) {
+    if (_threadsRunning) {
+        try {
+            if (!_pendingBatch.docs.empty()) {
+                _pushPendingBatch(nullptr);
+            }
+        } catch (...) {
+            return exceptionToStatus();
+        }
+        _stopThreads();
+    }
+
+    for (const auto& partition : _partitions) {
+        if (!partition->status.isOK()) {
+            return partition->status;
+        }
+    }
+
+    auto interceptor = _indexCatalogEntry->indexBuildInterceptor();
+    for (auto& partition : _partitions) {
+        if (!partition->skippedRecords.empty()) {
+            // If a key generation error was suppressed, record the document as "skipped" so the
+            // index builder can retry at a point when data is consistent.
+            try {
+                for (const auto& loc : partition->skippedRecords) {
+                    interceptor->getSkippedRecordTracker()->record(opCtx, loc);
+                }
+            } catch (...) {
+                return exceptionToStatus();
+            }
+            partition->skippedRecords.clear();
+        }
 
+        _keysInserted += std::exchange(partition->keysInserted, 0);
+        _isMultiKey = std::exchange(partition->isMultiKey, false) || _isMultiKey;
+        mergeMultikeyPaths(&_indexMultikeyPaths, partition->indexMultikeyPaths);
+        partition->indexMultikeyPaths.clear();
+        _multikeyMetadataKeys.insert(partition->multikeyMetadataKeys.begin(),
+                                     partition->multikeyMetadataKeys.end());
+        partition->multikeyMetadataKeys.clear();
+    }
     return Status::OK();
 }
 
@@ -616,8 +954,20 @@ bool AbstractIndexAccessMethod::BulkBuilderImpl::isMultikey() const {
 
 IndexAccessMethod::BulkBuilder::Sorter::Iterator*
 AbstractIndexAccessMethod::BulkBuilderImpl::done() {
+    invariant(!_threadsRunning);
     _insertMultikeyMetadataKeysIntoSorter();
-    return _sorter->done();
+    if (_partitions.size() == 1) {
+        return _partitions.front()->sorter->done();
+    }
+
+    // Each partition merges its own spilled ranges, and the partitions are merged in turn. The
+    // merge has no file of its own to delete.
+    std::vector<std::shared_ptr<Sorter::Iterator>> iterators;
+    for (auto& partition : _partitions) {
+        iterators.emplace_back(partition->sorter->done());
+    }
+    return Sorter::Iterator::merge(
+        iterators, std::string(), SortOptions(), BtreeExternalSortComparison());
 }
 
 int64_t AbstractIndexAccessMethod::BulkBuilderImpl::getKeysInserted() const {
@@ -626,13 +976,49 @@ int64_t AbstractIndexAccessMethod::BulkBuilderImpl::getKeysInserted() const {
 
 AbstractIndexAccessMethod::BulkBuilder::Sorter::PersistedState
 AbstractIndexAccessMethod::BulkBuilderImpl::persistDataForShutdown() {
+    invariant(!_threadsRunning);
     _insertMultikeyMetadataKeysIntoSorter();
-    return _sorter->persistDataForShutdown();
+    auto state = _partitions.front()->sorter->persistDataForShutdown();
+    if (_partitions.size() == 1) {
+        return state;
+    }
+
+    // An index build resumes from a single file, so the ranges spilled by the other partitions are
+    // appended to the file of the first one. Ranges are checksummed independently of their offset.
+    const auto tempDir = makeSortOptions(0).tempDir;
+    const auto fileFullPath = tempDir + "/" + state.fileName;
+    for (size_t i = 1; i < _partitions.size(); ++i) {
+        auto partitionState = _partitions[i]->sorter->persistDataForShutdown();
+        if (partitionState.ranges.empty()) {
+            continue;
+        }
+
+        const auto partitionFileFullPath = tempDir + "/" + partitionState.fileName;
+        const long long offset = boost::filesystem::exists(fileFullPath)
+            ? boost::filesystem::file_size(fileFullPath)
+            : 0;
+        {
+            std::ifstream in(partitionFileFullPath, std::ios::in | std::ios::binary);
+            std::ofstream out(fileFullPath, std::ios::out | std::ios::binary | std::ios::app);
+            uassert(5150809,
+                    str::stream() << "error appending file \"" << partitionFileFullPath
+                                  << "\" to \"" << fileFullPath << "\"",
+                    in.is_open() && out.is_open() && (out << in.rdbuf()) && out.flush());
+        }
+        for (auto range : partitionState.ranges) {
+            range.setStartOffset(range.getStartOffset() + offset);
+            range.setEndOffset(range.getEndOffset() + offset);
+            state.ranges.push_back(std::move(range));
+        }
+        boost::filesystem::remove(partitionFileFullPath);
+    }
+    return state;
 }
 
 void AbstractIndexAccessMethod::BulkBuilderImpl::_insertMultikeyMetadataKeysIntoSorter() {
+    auto& sorter = _partitions.front()->sorter;
     for (const auto& keyString : _multikeyMetadataKeys) {
-        _sorter->add(keyString, mongo::NullValue());
+        sorter->add(keyString, mongo::NullValue());
         ++_keysInserted;
     }
 
@@ -670,6 +1056,10 @@ Status AbstractIndexAccessMethod::commitBulk(OperationContext* opCtx,
                                              const RecordIdHandlerFn& onDuplicateRecord) {
     Timer timer;
 
+    if (auto status = bulk->waitForPendingInserts(opCtx); !status.isOK()) {
+        return status;
+    }
+
     std::unique_ptr<BulkBuilder::Sorter::Iterator> it(bulk->done());
 
     static constexpr char message[] = "Index Build: inserting keys from external sorter into index";
@@ -237,6 +237,15 @@ public:
                               const RecordId& loc,
                               const InsertDeleteOptions& options) = 0;
 
+        /**
+         * Waits until the keys of all documents passed to insert() have been added to the
+         * underlying Sorter, and records any documents whose key generation errors were
+         * suppressed. Returns the first error encountered while generating or sorting keys on
+         * another thread. Must be called before done(), persistDataForShutdown() and any of the
+         * accessors below, which only reflect the documents inserted before the last call to this.
+         */
+        virtual Status waitForPendingInserts(OperationContext* opCtx) = 0;
+
         virtual const MultikeyPaths& getMultikeyPaths() const = 0;
 
         virtual bool isMultikey() const = 0;
@@ -271,9 +280,15 @@ public:
      *                      disk
      * stateInfo: the information to use to resume the index build, or boost::none if starting a
      * new index build.
+     * numThreads: most threads generating and sorting keys. With more than one, documents are
+     *             partitioned across that many Sorters, which are merged by done(). The Sorters
+     *             share 'maxMemoryUsageBytes' with the documents queued for their threads, and
+     *             fewer are used if those documents would take up more than half of it.
      */
     virtual std::unique_ptr<BulkBuilder> initiateBulk(
-        size_t maxMemoryUsageBytes, const boost::optional<IndexStateInfo>& stateInfo) = 0;
+        size_t maxMemoryUsageBytes,
+        const boost::optional<IndexStateInfo>& stateInfo,
+        size_t numThreads) = 0;
 
     /**
      * Call this when you are ready to finish your bulk work.
@@ -524,8 +539,9 @@ public:
                             KeyStringSet multikeyMetadataKeys,
                             MultikeyPaths paths) final;
 
-    std::unique_ptr<BulkBuilder> initiateBulk(
-        size_t maxMemoryUsageBytes, const boost::optional<IndexStateInfo>& stateInfo) final;
+    std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes,
+                                              const boost::optional<IndexStateInfo>& stateInfo,
+                                              size_t numThreads) final;
 
     Status commitBulk(OperationContext* opCtx,
                       BulkBuilder* bulk,
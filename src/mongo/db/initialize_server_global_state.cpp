@@ -365,6 +365,9 @@ MONGO_INITIALIZER_GENERAL(ServerLogRedirection,
     }
 
     lv2Config.timestampFormat = serverGlobalParams.logTimestampFormat;
+    lv2Config.asyncEnabled = serverGlobalParams.logAsyncWrites;
+    lv2Config.asyncOverflowPolicy = serverGlobalParams.logAsyncOverflowPolicy;
+    lv2Config.asyncBufferSize = serverGlobalParams.logAsyncBufferSize;
     Status result = lv2Manager.getGlobalDomainInternal().configure(lv2Config);
     if (result.isOK() && writeServerRestartedAfterLogConfig) {
         LOGV2(20698, "***** SERVER RESTARTED *****");
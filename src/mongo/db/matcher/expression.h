@@ -41,6 +41,7 @@
 #include "mongo/db/matcher/match_details.h"
 #include "mongo/db/matcher/matchable.h"
 #include "mongo/db/pipeline/dependencies.h"
+#include "mongo/util/arena.h"
 #include "mongo/util/fail_point.h"
 
 namespace mongo {
@@ -57,7 +58,11 @@ class TreeMatchExpression;
 
 typedef StatusWith<std::unique_ptr<MatchExpression>> StatusWithMatchExpression;
 
-class MatchExpression {
+/**
+ * MatchExpression trees are built on behalf of a single query, and are placed in its arena while a
+ * QueryArenaScope is active.
+ */
+class MatchExpression : public ArenaAllocatable {
     MatchExpression(const MatchExpression&) = delete;
     MatchExpression& operator=(const MatchExpression&) = delete;
 
@@ -203,6 +208,13 @@ public:
     using Iterator = MatchExpressionIterator<false>;
     using ConstIterator = MatchExpressionIterator<true>;
 
+    /**
+     * Identifies a constant of a query which a plan built for the query reads from its inputs, so
+     * that the plan can be reused for another query of the same shape by binding that query's
+     * constant instead. Parameter ids are assigned in order, starting from zero.
+     */
+    using InputParamId = int32_t;
+
     /**
      * Tracks the information needed to generate a document validation error for a
      * MatchExpression node.
@@ -471,6 +471,115 @@ void mapOver(MatchExpression* expr, NodeTraversalFunc func, std::string path) {
     func(expr, path);
 }
 
+void parameterize(MatchExpression* tree) {
+    if (!getInputParams(tree).empty()) {
+        return;
+    }
+
+    // Only a path which no other predicate refers to has index bounds derived from a single
+    // constant.
+    StringMap<size_t> numPredicatesByPath;
+    mapOver(tree, [&](MatchExpression* node, std::string path) {
+        if (!node->path().empty()) {
+            ++numPredicatesByPath[path];
+        }
+    });
+
+    auto isParameterizable = [&](const MatchExpression* node) {
+        if (node->matchType() != MatchExpression::EQ || numPredicatesByPath[node->path()] != 1) {
+            return false;
+        }
+
+        auto expr = static_cast<const EqualityMatchExpression*>(node);
+        if (expr->getCollator()) {
+            return false;
+        }
+
+        // Constants of other types, such as null, arrays or objects, turn into index bounds which
+        // are not a single point of the constant.
+        switch (expr->getData().type()) {
+            case NumberInt:
+            case NumberLong:
+            case NumberDouble:
+            case NumberDecimal:
+            case String:
+            case Bool:
+            case Date:
+            case jstOID:
+            case bsonTimestamp:
+                return true;
+            default:
+                return false;
+        }
+    };
+
+    MatchExpression::InputParamId nextParamId = 0;
+    auto maybeParameterize = [&](MatchExpression* node) {
+        if (isParameterizable(node)) {
+            static_cast<EqualityMatchExpression*>(node)->setInputParamId(nextParamId++);
+        }
+    };
+
+    if (tree->matchType() == MatchExpression::AND) {
+        for (size_t i = 0; i < tree->numChildren(); ++i) {
+            maybeParameterize(tree->getChild(i));
+        }
+    } else {
+        maybeParameterize(tree);
+    }
+}
+
+std::vector<BSONElement> getInputParams(const MatchExpression* tree) {
+    std::vector<BSONElement> inputParams;
+    std::function<void(const MatchExpression*)> collect = [&](const MatchExpression* node) {
+        for (size_t i = 0; i < node->numChildren(); ++i) {
+            collect(node->getChild(i));
+        }
+
+        if (node->matchType() != MatchExpression::EQ) {
+            return;
+        }
+
+        auto expr = static_cast<const EqualityMatchExpression*>(node);
+        if (auto paramId = expr->getInputParamId()) {
+            if (inputParams.size() <= static_cast<size_t>(*paramId)) {
+                inputParams.resize(*paramId + 1);
+            }
+            inputParams[*paramId] = expr->getData();
+        }
+    };
+
+    collect(tree);
+    return inputParams;
+}
+
+BSONObj serializeWithoutInputParams(const MatchExpression* tree) {
+    // The placeholder must outlive the clone of 'tree' which refers to it. It may equal the
+    // constant of a predicate which is not parameterized, which the input parameter ids below tell
+    // apart.
+    const auto placeholder = BSON("" << BSONNULL);
+    auto clone = tree->shallowClone();
+    BSONArrayBuilder inputParamIds;
+    mapOver(clone.get(), [&](MatchExpression* node, std::string path) {
+        if (node->matchType() != MatchExpression::EQ) {
+            return;
+        }
+
+        auto expr = static_cast<EqualityMatchExpression*>(node);
+        if (auto paramId = expr->getInputParamId()) {
+            expr->setData(placeholder.firstElement());
+            inputParamIds.append(*paramId);
+        } else {
+            inputParamIds.appendNull();
+        }
+    });
+
+    BSONObjBuilder bob;
+    bob.append("filter", clone->serialize());
+    bob.append("inputParamIds", inputParamIds.arr());
+    return bob.obj();
+}
+
 bool isPathPrefixOf(StringData first, StringData second) {
     if (first.size() >= second.size()) {
         return false;
@@ -32,13 +32,15 @@
 #include <functional>
 #include <memory>
 #include <set>
+#include <vector>
 
 #include "mongo/base/string_data.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/db/matcher/expression.h"
 #include "mongo/util/string_map.h"
 
 namespace mongo {
 
-class MatchExpression;
 struct DepsTracker;
 
 namespace expression {
@@ -111,6 +113,31 @@ bool isPathPrefixOf(StringData first, StringData second);
  */
 void mapOver(MatchExpression* expr, NodeTraversalFunc func, std::string path = "");
 
+/**
+ * Assigns input parameter ids to the constants of 'tree' which a plan built for the query may read
+ * from its inputs rather than bake in. These are the scalar constants of the $eq predicates at the
+ * top level of 'tree' which do not use a collator, and whose path no other predicate of 'tree'
+ * refers to, so that the index bounds on the path are derived from the constant alone. Constants
+ * of the same type then lead to the same plan.
+ *
+ * Does nothing if 'tree' already has input parameters, such as a subtree cloned from a query which
+ * has been parameterized, so that the ids stay consistent with the original query.
+ */
+void parameterize(MatchExpression* tree);
+
+/**
+ * Returns the constants of the parameterized predicates of 'tree', indexed by input parameter id.
+ */
+std::vector<BSONElement> getInputParams(const MatchExpression* tree);
+
+/**
+ * Returns the serialization of 'tree' with the constants of its input parameters left out, along
+ * with the input parameter id of each $eq predicate of 'tree', or null if it has none. Two trees
+ * which differ only in the constants of their input parameters have the same result, and any two
+ * other trees have different results.
+ */
+BSONObj serializeWithoutInputParams(const MatchExpression* tree);
+
 /**
  * Attempt to split 'expr' into two MatchExpressions, where the first is not reliant upon any
  * path from 'fields', such that applying the matches in sequence is equivalent to applying
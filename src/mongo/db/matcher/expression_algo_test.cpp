@@ -1344,4 +1344,84 @@ TEST(HasExistencePredicateOnPath, ReturnsFalseWhenExistsOnSubpath) {
         expression::hasExistencePredicateOnPath(*swMatchExpression.getValue().get(), "a"_sd));
 }
 
+TEST(Parameterize, AssignsInputParamsToTopLevelScalarEqualities) {
+    BSONObj matchPredicate = fromjson(
+        "{a: 1, b: 'x', c: {$gt: 2}, d: null, e: [1], f: {g: 1}, h: true, i: {$eq: 2.5}}");
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto swMatchExpression = MatchExpressionParser::parse(matchPredicate, std::move(expCtx));
+    ASSERT_OK(swMatchExpression.getStatus());
+    auto expr = swMatchExpression.getValue().get();
+
+    expression::parameterize(expr);
+    auto inputParams = expression::getInputParams(expr);
+    ASSERT_EQ(inputParams.size(), 4U);
+    ASSERT_BSONELT_EQ(inputParams[0], matchPredicate["a"]);
+    ASSERT_BSONELT_EQ(inputParams[1], matchPredicate["b"]);
+    ASSERT_BSONELT_EQ(inputParams[2], matchPredicate["h"]);
+    ASSERT_EQ(inputParams[3].numberDouble(), 2.5);
+}
+
+TEST(Parameterize, DoesNotAssignInputParamsToPathsWithSeveralPredicates) {
+    BSONObj matchPredicate =
+        fromjson("{a: 1, b: 2, c: 3, $or: [{a: 4}, {d: 5}], $nor: [{b: 6}]}");
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto swMatchExpression = MatchExpressionParser::parse(matchPredicate, std::move(expCtx));
+    ASSERT_OK(swMatchExpression.getStatus());
+    auto expr = swMatchExpression.getValue().get();
+
+    // Neither the predicates on 'a' and 'b', nor the predicates within the $or are parameterized.
+    expression::parameterize(expr);
+    auto inputParams = expression::getInputParams(expr);
+    ASSERT_EQ(inputParams.size(), 1U);
+    ASSERT_BSONELT_EQ(inputParams[0], matchPredicate["c"]);
+}
+
+TEST(Parameterize, DoesNotAssignInputParamsToCollatedEqualities) {
+    BSONObj matchPredicate = fromjson("{a: 'x'}");
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    expCtx->setCollator(
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kAlwaysEqual));
+    auto swMatchExpression = MatchExpressionParser::parse(matchPredicate, std::move(expCtx));
+    ASSERT_OK(swMatchExpression.getStatus());
+    auto expr = swMatchExpression.getValue().get();
+
+    expression::parameterize(expr);
+    ASSERT(expression::getInputParams(expr).empty());
+}
+
+TEST(Parameterize, SerializationWithoutInputParamsTellsNullConstantsApart) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto serialize = [&](const BSONObj& matchPredicate) {
+        auto swMatchExpression = MatchExpressionParser::parse(matchPredicate, expCtx);
+        ASSERT_OK(swMatchExpression.getStatus());
+        auto expr = swMatchExpression.getValue().get();
+        expression::parameterize(expr);
+        return expression::serializeWithoutInputParams(expr);
+    };
+
+    // The null constant is not parameterized, so it must not be confused with the parameterized
+    // constant of the other predicate.
+    ASSERT_BSONOBJ_NE(serialize(fromjson("{a: 5, b: null}")),
+                      serialize(fromjson("{a: null, b: 7}")));
+    ASSERT_BSONOBJ_EQ(serialize(fromjson("{a: 5, b: null}")),
+                      serialize(fromjson("{a: 6, b: null}")));
+}
+
+TEST(Parameterize, ClonesKeepTheInputParamsOfTheOriginal) {
+    BSONObj matchPredicate = fromjson("{a: 1, $or: [{b: 2}, {c: 3}]}");
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto swMatchExpression = MatchExpressionParser::parse(matchPredicate, std::move(expCtx));
+    ASSERT_OK(swMatchExpression.getStatus());
+    auto expr = swMatchExpression.getValue().get();
+    expression::parameterize(expr);
+
+    // Parameterizing a clone of a parameterized tree keeps the parameter ids of the original, even
+    // though the clone has predicates which would otherwise be parameterized.
+    auto clone = expr->shallowClone();
+    expression::parameterize(clone.get());
+    auto inputParams = expression::getInputParams(clone.get());
+    ASSERT_EQ(inputParams.size(), 1U);
+    ASSERT_BSONELT_EQ(inputParams[0], matchPredicate["a"]);
+}
+
 }  // namespace mongo
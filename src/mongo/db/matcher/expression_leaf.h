@@ -142,6 +142,18 @@ public:
         return _collator;
     }
 
+    /**
+     * The input parameter id of the RHS constant, if the constant has been parameterized (see
+     * expression::parameterize()).
+     */
+    boost::optional<InputParamId> getInputParamId() const {
+        return _inputParamId;
+    }
+
+    void setInputParamId(boost::optional<InputParamId> paramId) {
+        _inputParamId = paramId;
+    }
+
 protected:
     /**
      * 'collator' must outlive the ComparisonMatchExpression and any clones made of it.
@@ -157,6 +169,8 @@ protected:
     // Collator used to compare elements. By default, simple binary comparison will be used.
     const CollatorInterface* _collator = nullptr;
 
+    boost::optional<InputParamId> _inputParamId;
+
 private:
     ExpressionOptimizerFunc getOptimizer() const final {
         return [](std::unique_ptr<MatchExpression> expression) { return expression; };
@@ -221,6 +235,7 @@ public:
             e->setTag(getTag()->clone());
         }
         e->setCollator(_collator);
+        e->setInputParamId(_inputParamId);
         return e;
     }
 
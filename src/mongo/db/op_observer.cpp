@@ -31,17 +31,33 @@
 
 #include "mongo/db/op_observer.h"
 
+#include <utility>
+
 #include "mongo/db/operation_context.h"
 
 namespace mongo {
 namespace {
 const auto getOpObserverTimes = OperationContext::declareDecoration<OpObserver::Times>();
+const auto getObservedRecordIds =
+    OperationContext::declareDecoration<OpObserver::ObservedRecordIds>();
 }  // namespace
 
 auto OpObserver::Times::get(OperationContext* const opCtx) -> Times& {
     return getOpObserverTimes(opCtx);
 }
 
+auto OpObserver::ObservedRecordIds::get(OperationContext* const opCtx) -> ObservedRecordIds& {
+    return getObservedRecordIds(opCtx);
+}
+
+OpObserver::ObservedRecordIds::Scope::Scope(OperationContext* const opCtx,
+                                            std::vector<RecordId> ids)
+    : _ids(get(opCtx).ids), _outerIds(std::exchange(_ids, std::move(ids))) {}
+
+OpObserver::ObservedRecordIds::Scope::~Scope() {
+    _ids = std::move(_outerIds);
+}
+
 OpObserver::ReservedTimes::ReservedTimes(OperationContext* const opCtx)
     : _times(Times::get(opCtx)) {
     // Every time that a `ReservedTimes` scope object is instantiated, we have to track if there was
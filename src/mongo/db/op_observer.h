@@ -419,6 +419,7 @@ public:
                                              const repl::OpTime& newCommitPoint) = 0;
 
     struct Times;
+    struct ObservedRecordIds;
 
 protected:
     class ReservedTimes;
@@ -442,6 +443,41 @@ private:
     int _recursionDepth = 0;
 };
 
+/**
+ * This struct is a decoration for `OperationContext` which holds the RecordIds of the documents
+ * passed to the `onInserts`, `onUpdate` or `onDelete` call in progress on the operation, in the
+ * same order as the documents. The collection write paths fill it in through a `Scope` right
+ * before notifying the OpObserver chain, so observers which mirror the contents of a record store
+ * must treat a mismatch with the number of documents as "unknown".
+ */
+struct OpObserver::ObservedRecordIds {
+    class Scope;
+
+    static ObservedRecordIds& get(OperationContext*);
+
+    std::vector<RecordId> ids;
+};
+
+/**
+ * This class is an RAII object which publishes the RecordIds of a write in the
+ * `OpObserver::ObservedRecordIds` decoration for its lifetime, and restores those of the enclosing
+ * write on destruction. Writes made while the OpObserver chain is notified of another write, such
+ * as the update of config.transactions for a retryable write, then leave the RecordIds of the
+ * outer write in place for the observers notified after them.
+ */
+class OpObserver::ObservedRecordIds::Scope {
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+public:
+    explicit Scope(OperationContext* opCtx, std::vector<RecordId> ids = {});
+    ~Scope();
+
+private:
+    std::vector<RecordId>& _ids;
+    std::vector<RecordId> _outerIds;
+};
+
 /**
  * This class is an RAII object to manage the state of the `OpObserver::Times` decoration on an
  * operation context. Upon destruction the list of times in the decoration on the operation context
@@ -37,6 +37,8 @@
 #include "mongo/db/keys_collection_manager.h"
 #include "mongo/db/logical_time_validator.h"
 #include "mongo/db/op_observer_impl.h"
+#include "mongo/db/op_observer_noop.h"
+#include "mongo/db/op_observer_registry.h"
 #include "mongo/db/read_write_concern_defaults.h"
 #include "mongo/db/read_write_concern_defaults_cache_lookup_mock.h"
 #include "mongo/db/repl/oplog.h"
@@ -539,6 +541,95 @@ TEST_F(OpObserverSessionCatalogRollbackTest,
     }
 }
 
+/**
+ * Records the RecordIds published to the OpObserver chain for the inserts and updates of 'nss'.
+ */
+class ObservedRecordIdsRecorder : public OpObserverNoop {
+public:
+    explicit ObservedRecordIdsRecorder(NamespaceString nss) : _nss(std::move(nss)) {}
+
+    void onInserts(OperationContext* opCtx,
+                   const NamespaceString& nss,
+                   OptionalCollectionUUID uuid,
+                   std::vector<InsertStatement>::const_iterator begin,
+                   std::vector<InsertStatement>::const_iterator end,
+                   bool fromMigrate) override {
+        if (nss == _nss) {
+            observed.push_back(OpObserver::ObservedRecordIds::get(opCtx).ids);
+        }
+    }
+
+    void onUpdate(OperationContext* opCtx, const OplogUpdateEntryArgs& args) override {
+        if (args.nss == _nss) {
+            observed.push_back(OpObserver::ObservedRecordIds::get(opCtx).ids);
+        }
+    }
+
+    std::vector<std::vector<RecordId>> observed;
+
+private:
+    const NamespaceString _nss;
+};
+
+TEST_F(OpObserverSessionCatalogRollbackTest,
+       RetryableWritesPublishTheirRecordIdsToObserversAfterTheSessionEntryUpdate) {
+    const NamespaceString nss("testDB", "testColl");
+
+    // The recorder is notified after OpObserverImpl has written the session entry of each write.
+    auto registry = std::make_unique<OpObserverRegistry>();
+    registry->addObserver(std::make_unique<OpObserverImpl>());
+    auto recorder = std::make_unique<ObservedRecordIdsRecorder>(nss);
+    auto recorderPtr = recorder.get();
+    registry->addObserver(std::move(recorder));
+    getServiceContext()->setOpObserver(std::move(registry));
+
+    auto opCtx = cc().makeOperationContext();
+    ASSERT_OK(repl::StorageInterface::get(opCtx.get())
+                  ->createCollection(opCtx.get(), nss, CollectionOptions()));
+
+    opCtx->setLogicalSessionId(makeLogicalSessionIdForTest());
+    opCtx->setTxnNumber(0);
+    MongoDOperationContextSession ocs(opCtx.get());
+    auto txnParticipant = TransactionParticipant::get(opCtx.get());
+    txnParticipant.refreshFromStorageIfNeeded(opCtx.get());
+    txnParticipant.beginOrContinue(opCtx.get(), 0, boost::none, boost::none);
+
+    AutoGetCollection autoColl(opCtx.get(), nss, MODE_IX);
+    const auto& collection = autoColl.getCollection();
+    {
+        WriteUnitOfWork wuow(opCtx.get());
+        ASSERT_OK(collection->insertDocument(
+            opCtx.get(), InsertStatement(0, BSON("_id" << 0 << "x" << 0)), nullptr));
+        wuow.commit();
+    }
+    ASSERT_EQ(recorderPtr->observed.size(), 1U);
+    ASSERT_EQ(recorderPtr->observed[0].size(), 1U);
+    auto insertedRecordId = recorderPtr->observed[0][0];
+    ASSERT(OpObserver::ObservedRecordIds::get(opCtx.get()).ids.empty());
+
+    {
+        WriteUnitOfWork wuow(opCtx.get());
+        auto oldDoc = collection->docFor(opCtx.get(), insertedRecordId);
+        CollectionUpdateArgs args;
+        args.stmtId = 1;
+        args.preImageDoc = oldDoc.value().getOwned();
+        args.update = BSON("$set" << BSON("x" << 1));
+        args.criteria = BSON("_id" << 0);
+        collection->updateDocument(opCtx.get(),
+                                   insertedRecordId,
+                                   oldDoc,
+                                   BSON("_id" << 0 << "x" << 1),
+                                   false,
+                                   nullptr,
+                                   &args);
+        wuow.commit();
+    }
+    ASSERT_EQ(recorderPtr->observed.size(), 2U);
+    ASSERT_EQ(recorderPtr->observed[1].size(), 1U);
+    ASSERT_EQ(recorderPtr->observed[1][0], insertedRecordId);
+    ASSERT(OpObserver::ObservedRecordIds::get(opCtx.get()).ids.empty());
+}
+
 TEST_F(OpObserverTest, MultipleAboutToDeleteAndOnDelete) {
     auto uuid = UUID::gen();
     OpObserverImpl opObserver;
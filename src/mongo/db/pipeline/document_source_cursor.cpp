@@ -240,6 +240,13 @@ Value DocumentSourceCursor::serialize(boost::optional<ExplainOptions::Verbosity>
         out["executionStats"] = Value(explainStats["executionStats"]);
     }
 
+    // Report any pipeline stages which have been pushed down into the query plan and so no longer
+    // appear in the pipeline.
+    if (auto cq = _exec->getCanonicalQuery(); cq && cq->getPushedDownGroup()) {
+        out["pushedDownStages"] =
+            Value(std::vector<Value>{Value(cq->getPushedDownGroup()->explainInfo)});
+    }
+
     return Value(DOC(getSourceName() << out.freezeToValue()));
 }
 
@@ -27,10 +27,14 @@
  *    it in the license file.
  */
 
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kQuery
+
 #include "mongo/platform/basic.h"
 
 #include "mongo/db/pipeline/document_source_lookup.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 
 #include "mongo/base/init.h"
@@ -38,12 +42,15 @@
 #include "mongo/db/exec/document_value/value.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_algo.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/extensions_callback_noop.h"
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/document_source_merge_gen.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/variable_validation.h"
 #include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/logv2/log.h"
 #include "mongo/platform/overflow_arithmetic.h"
 #include "mongo/util/fail_point.h"
 
@@ -87,6 +94,27 @@ bool foreignShardedLookupAllowed() {
     return getTestCommandsEnabled() && internalQueryAllowShardedLookup.load();
 }
 
+/**
+ * Runs 'buildFn', which builds a pipeline over the foreign collection, and turns the stale shard
+ * version error raised when the foreign collection is sharded into a $lookup specific error.
+ */
+template <typename BuildFn>
+std::unique_ptr<Pipeline, PipelineDeleter> buildForeignPipeline(BuildFn buildFn) {
+    try {
+        return buildFn();
+    } catch (const ExceptionForCat<ErrorCategory::StaleShardVersionError>& ex) {
+        // If lookup on a sharded collection is disallowed and the foreign collection is sharded,
+        // throw a custom exception.
+        if (auto staleInfo = ex.extraInfo<StaleConfigInfo>()) {
+            uassert(51069,
+                    "Cannot run $lookup with sharded foreign collection",
+                    foreignShardedLookupAllowed() || !staleInfo->getVersionWanted() ||
+                        staleInfo->getVersionWanted() == ChunkVersion::UNSHARDED());
+        }
+        throw;
+    }
+}
+
 // Parses $lookup 'from' field. The 'from' field must be a string or an object in the form of
 // {from: {db: "config", coll: "cache.chunks.*}, ...}.
 NamespaceString parseLookupFromAndResolveNamespace(const BSONElement& elem, StringData defaultDb) {
@@ -139,6 +167,10 @@ DocumentSourceLookUp::DocumentSourceLookUp(NamespaceString fromNs,
     _resolvedPipeline.reserve(_resolvedPipeline.size() + 1);
     _resolvedPipeline.push_back(BSON("$match" << BSONObj()));
     initializeResolvedIntrospectionPipeline();
+
+    if (internalLookupHashJoinMaxMemoryBytes.load() > 0) {
+        _joinStrategy = JoinStrategy::kHashJoin;
+    }
 }
 
 DocumentSourceLookUp::DocumentSourceLookUp(NamespaceString fromNs,
@@ -287,35 +319,12 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
-    if (!wasConstructedWithPipelineSyntax()) {
-        auto matchStage =
-            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
-        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-        _resolvedPipeline.back() = matchStage;
-    }
-
-    std::unique_ptr<Pipeline, PipelineDeleter> pipeline;
-    try {
-        pipeline = buildPipeline(inputDoc);
-    } catch (const ExceptionForCat<ErrorCategory::StaleShardVersionError>& ex) {
-        // If lookup on a sharded collection is disallowed and the foreign collection is sharded,
-        // throw a custom exception.
-        if (auto staleInfo = ex.extraInfo<StaleConfigInfo>()) {
-            uassert(51069,
-                    "Cannot run $lookup with sharded foreign collection",
-                    foreignShardedLookupAllowed() || !staleInfo->getVersionWanted() ||
-                        staleInfo->getVersionWanted() == ChunkVersion::UNSHARDED());
-        }
-        throw;
-    }
-
     std::vector<Value> results;
     long long objsize = 0;
     const auto maxBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
-
-    while (auto result = pipeline->getNext()) {
+    auto appendResult = [&](Document result) {
         long long safeSum = 0;
-        bool hasOverflowed = overflow::add(objsize, result->getApproximateSize(), &safeSum);
+        bool hasOverflowed = overflow::add(objsize, result.getApproximateSize(), &safeSum);
         uassert(4568,
                 str::stream() << "Total size of documents in " << _fromNs.coll()
                               << " matching pipeline's $lookup stage exceeds " << maxBytes
@@ -323,15 +332,148 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
 
                 !hasOverflowed && objsize <= maxBytes);
         objsize = safeSum;
-        results.emplace_back(std::move(*result));
+        results.emplace_back(std::move(result));
+    };
+
+    if (auto matches = getHashJoinMatches(inputDoc)) {
+        for (auto&& match : *matches) {
+            appendResult(std::move(match));
+        }
+    } else {
+        if (!wasConstructedWithPipelineSyntax()) {
+            auto matchStage = makeMatchStageFromInput(
+                inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
+            // We've already allocated space for the trailing $match stage in
+            // '_resolvedPipeline'.
+            _resolvedPipeline.back() = matchStage;
+        }
+
+        auto pipeline = buildForeignPipeline([&] { return buildPipeline(inputDoc); });
+        while (auto result = pipeline->getNext()) {
+            appendResult(std::move(*result));
+        }
+        _usedDisk = _usedDisk || pipeline->usedDisk();
     }
-    _usedDisk = _usedDisk || pipeline->usedDisk();
 
     MutableDocument output(std::move(inputDoc));
     output.setNestedField(_as, Value(std::move(results)));
     return output.freeze();
 }
 
+boost::optional<std::vector<Document>> DocumentSourceLookUp::getHashJoinMatches(
+    const Document& inputDoc) {
+    if (_joinStrategy != JoinStrategy::kHashJoin) {
+        return boost::none;
+    }
+    if (!_hashTable) {
+        buildHashTable();
+        if (_joinStrategy != JoinStrategy::kHashJoin) {
+            return boost::none;
+        }
+    }
+
+    // A null or missing local value matches the foreign documents which are null or missing at
+    // 'foreignField', which were found once when the table was built. The nested loop join reports
+    // the error that an undefined local value raises.
+    std::vector<Value> localValues;
+    size_t numLocalValues = 0;
+    bool matchesNull = false;
+    bool hasUndefined = false;
+    document_path_support::visitAllValuesAtPath(inputDoc, *_localField, [&](const Value& value) {
+        ++numLocalValues;
+        if (value.getType() == BSONType::Undefined) {
+            hasUndefined = true;
+        } else if (value.nullish()) {
+            matchesNull = true;
+        } else {
+            localValues.push_back(value);
+        }
+    });
+    if (hasUndefined) {
+        return boost::none;
+    }
+    matchesNull = matchesNull || numLocalValues == 0;
+
+    std::vector<size_t> positions;
+    if (!localValues.empty()) {
+        positions = _hashTable->getCandidates(localValues);
+    }
+    if (matchesNull) {
+        std::vector<size_t> withNullMatches;
+        std::set_union(positions.begin(),
+                       positions.end(),
+                       _hashJoinNullMatches.begin(),
+                       _hashJoinNullMatches.end(),
+                       std::back_inserter(withNullMatches));
+        positions = std::move(withNullMatches);
+    }
+
+    std::vector<Document> matches;
+    matches.reserve(positions.size());
+    for (auto pos : positions) {
+        matches.emplace_back(_hashTable->getDocument(pos));
+    }
+    return matches;
+}
+
+void DocumentSourceLookUp::buildHashTable() {
+    invariant(_joinStrategy == JoinStrategy::kHashJoin && !_hashTable);
+    _hashTable.emplace(*_foreignField,
+                       _fromExpCtx->getValueComparator(),
+                       internalLookupHashJoinMaxMemoryBytes.load());
+
+    // Read the whole foreign side. Only the filter absorbed from a subsequent $match, which does
+    // not depend on the input document, can be applied up front.
+    _resolvedPipeline.back() = BSON("$match" << _additionalFilter.value_or(BSONObj()));
+    auto pipeline = buildForeignPipeline([&] { return buildPipeline(Document()); });
+    while (auto foreignDoc = pipeline->getNext()) {
+        if (!_hashTable->insert(foreignDoc->toBson())) {
+            LOGV2_DEBUG(5150806,
+                        3,
+                        "$lookup foreign collection does not fit in the hash join memory limit, "
+                        "falling back to a nested loop join",
+                        "from"_attr = _fromNs,
+                        "memoryLimitBytes"_attr = internalLookupHashJoinMaxMemoryBytes.load());
+            _hashTable.reset();
+            _joinStrategy = JoinStrategy::kNestedLoopJoin;
+            _hashJoinExceededMemoryLimit = true;
+            break;
+        }
+    }
+    _usedDisk = _usedDisk || pipeline->usedDisk();
+
+    if (!_hashTable) {
+        return;
+    }
+
+    // Probing the table finds the foreign documents equal to a value, but null also matches the
+    // documents missing 'foreignField', so find those once with the predicate the nested loop join
+    // would use.
+    auto nullMatcher = uassertStatusOK(
+        MatchExpressionParser::parse(BSON(_foreignField->fullPath() << BSON("$eq" << BSONNULL)),
+                                     _fromExpCtx,
+                                     ExtensionsCallbackNoop(),
+                                     Pipeline::kAllowedMatcherFeatures));
+    for (size_t pos = 0; pos < _hashTable->size(); ++pos) {
+        if (nullMatcher->matchesBSON(_hashTable->getDocument(pos))) {
+            _hashJoinNullMatches.push_back(pos);
+        }
+    }
+}
+
+boost::optional<Document> DocumentSourceLookUp::getNextUnwindMatch() {
+    if (!_hashJoinMatches) {
+        return _pipeline->getNext();
+    }
+    if (_hashJoinMatches->empty()) {
+        return boost::none;
+    }
+
+    auto match = std::move(_hashJoinMatches->front());
+    _hashJoinMatches->pop_front();
+    return match;
+}
+
 std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
     const Document& inputDoc) {
     // Copy all 'let' variables into the foreign pipeline's expression context.
@@ -536,6 +678,9 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _hashTable.reset();
+    _hashJoinNullMatches.clear();
+    _hashJoinMatches.reset();
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
@@ -628,7 +773,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_pipeline || !_nextValue) {
+    while (!_nextValue) {
         auto nextInput = pSource->getNext();
         if (!nextInput.isAdvanced()) {
             return nextInput;
@@ -636,28 +781,36 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
         _input = nextInput.releaseDocument();
 
-        if (!wasConstructedWithPipelineSyntax()) {
-            BSONObj filter = _additionalFilter.value_or(BSONObj());
-            auto matchStage =
-                makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
-            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-            _resolvedPipeline.back() = matchStage;
-        }
+        if (auto matches = getHashJoinMatches(*_input)) {
+            _hashJoinMatches.emplace(std::make_move_iterator(matches->begin()),
+                                     std::make_move_iterator(matches->end()));
+        } else {
+            _hashJoinMatches.reset();
+
+            if (!wasConstructedWithPipelineSyntax()) {
+                BSONObj filter = _additionalFilter.value_or(BSONObj());
+                auto matchStage = makeMatchStageFromInput(
+                    *_input, *_localField, _foreignField->fullPath(), filter);
+                // We've already allocated space for the trailing $match stage in
+                // '_resolvedPipeline'.
+                _resolvedPipeline.back() = matchStage;
+            }
 
-        if (_pipeline) {
-            _usedDisk = _usedDisk || _pipeline->usedDisk();
-            _pipeline->dispose(pExpCtx->opCtx);
-        }
+            if (_pipeline) {
+                _usedDisk = _usedDisk || _pipeline->usedDisk();
+                _pipeline->dispose(pExpCtx->opCtx);
+            }
 
-        _pipeline = buildPipeline(*_input);
+            _pipeline = buildPipeline(*_input);
 
-        // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
-        // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
-        // outer Pipeline that will propagate dispose() calls before being destroyed.
-        _pipeline.get_deleter().dismissDisposal();
+            // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
+            // potentially be used by multiple OperationContexts, and the $lookup stage is part of
+            // an outer Pipeline that will propagate dispose() calls before being destroyed.
+            _pipeline.get_deleter().dismissDisposal();
+        }
 
         _cursorIndex = 0;
-        _nextValue = _pipeline->getNext();
+        _nextValue = getNextUnwindMatch();
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_nextValue) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -675,7 +828,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
     invariant(bool(_input) && bool(_nextValue));
     auto currentValue = *_nextValue;
-    _nextValue = _pipeline->getNext();
+    _nextValue = getNextUnwindMatch();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
     MutableDocument output(_nextValue ? *_input : std::move(*_input));
@@ -757,6 +910,14 @@ void DocumentSourceLookUp::serializeToArray(
             output[getSourceName()]["matching"] = Value(*_additionalFilter);
         }
 
+        if (!wasConstructedWithPipelineSyntax()) {
+            output[getSourceName()]["strategy"] = Value(
+                _joinStrategy == JoinStrategy::kHashJoin ? "HashJoin"_sd : "NestedLoopJoin"_sd);
+            if (_hashJoinExceededMemoryLimit) {
+                output[getSourceName()]["hashJoinExceededMemoryLimit"] = Value(true);
+            }
+        }
+
         array.push_back(Value(output.freeze()));
     } else {
         array.push_back(Value(output.freeze()));
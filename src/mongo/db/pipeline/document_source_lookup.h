@@ -38,6 +38,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 
 namespace mongo {
@@ -50,6 +51,18 @@ class DocumentSourceLookUp final : public DocumentSource {
 public:
     static constexpr StringData kStageName = "$lookup"_sd;
 
+    /**
+     * How the foreign documents matching an input document are found when $lookup is specified
+     * with localField/foreignField syntax.
+     */
+    enum class JoinStrategy {
+        // Queries the foreign collection once per input document.
+        kNestedLoopJoin,
+        // Reads the foreign collection once into an in-memory hash table keyed by 'foreignField',
+        // then probes the table with each input document.
+        kHashJoin,
+    };
+
     struct LetVariable {
         LetVariable(std::string name, boost::intrusive_ptr<Expression> expression, Variables::Id id)
             : name(std::move(name)), expression(std::move(expression)), id(id) {}
@@ -159,6 +172,10 @@ public:
         return _localField;
     }
 
+    JoinStrategy getJoinStrategy() const {
+        return _joinStrategy;
+    }
+
     const std::vector<LetVariable>& getLetVariables() const {
         return _letVariables;
     }
@@ -239,6 +256,27 @@ private:
 
     GetNextResult unwindResult();
 
+    /**
+     * If this stage executes as a hash join, returns the foreign documents matching 'inputDoc',
+     * building the hash table on first use. Returns boost::none if the stage executes as a nested
+     * loop join, which includes the case where the foreign side did not fit in the memory budget
+     * of the hash table, or if 'inputDoc' has an undefined local value, for which the nested loop
+     * join reports an error.
+     */
+    boost::optional<std::vector<Document>> getHashJoinMatches(const Document& inputDoc);
+
+    /**
+     * Reads the whole foreign side into '_hashTable'. Switches '_joinStrategy' to a nested loop
+     * join if it does not fit.
+     */
+    void buildHashTable();
+
+    /**
+     * Returns the next foreign document matching '_input' when unwinding, or boost::none once they
+     * are exhausted.
+     */
+    boost::optional<Document> getNextUnwindMatch();
+
     /**
      * Resolves let defined variables against 'localDoc' and stores the results in 'variables'.
      */
@@ -277,6 +315,17 @@ private:
     boost::optional<FieldPath> _localField;
     boost::optional<FieldPath> _foreignField;
 
+    // The join strategy for localField/foreignField syntax. A hash join is chosen up front when it
+    // is enabled, and abandoned in favour of a nested loop join if the foreign side turns out not
+    // to fit in '_hashTable', which explain then reports.
+    JoinStrategy _joinStrategy = JoinStrategy::kNestedLoopJoin;
+    bool _hashJoinExceededMemoryLimit = false;
+    boost::optional<LookupHashTable> _hashTable;
+
+    // The positions in '_hashTable' of the foreign documents matched by a null or missing local
+    // value, in ascending order.
+    std::vector<size_t> _hashJoinNullMatches;
+
     // Holds 'let' defined variables defined both in this stage and in parent pipelines. These are
     // copied to the '_fromExpCtx' ExpressionContext's 'variables' and 'variablesParseState' for use
     // in foreign pipeline execution.
@@ -312,6 +361,9 @@ private:
     // not null.
     long long _cursorIndex = 0;
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
+    // Used instead of '_pipeline' to hold the matches of the current input when executing as a
+    // hash join.
+    boost::optional<std::deque<Document>> _hashJoinMatches;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
 };
@@ -50,6 +50,7 @@
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -800,6 +801,151 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     lookup->dispose();
 }
 
+TEST_F(DocumentSourceLookUpTest, HashJoinProducesSameResultsAsNestedLoopJoin) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const auto foreignDoc0 = Document{{"_id", 0}, {"key", 1}};
+    const auto foreignDoc1 = Document{{"_id", 1}, {"key", vector<Value>{Value(2), Value(1)}}};
+    const auto foreignDoc2 = Document{{"_id", 2}, {"key", 3}};
+    const auto foreignDoc3 = Document{{"_id", 3}};
+
+    // The hash join is disabled by default.
+    const auto originalLimit = internalLookupHashJoinMaxMemoryBytes.load();
+    ON_BLOCK_EXIT([&] { internalLookupHashJoinMaxMemoryBytes.store(originalLimit); });
+
+    auto runLookup = [&](DocumentSourceLookUp::JoinStrategy expectedStrategy,
+                         bool exceededMemoryLimit) {
+        auto mockLocalSource = DocumentSourceMock::createForTest(
+            {Document{{"foreignId", 1}},
+             Document{{"foreignId", vector<Value>{Value(2), Value(3)}}},
+             Document{{"foreignId", 4}},
+             Document{{"other", 1}},
+             Document{{"foreignId", vector<Value>{Value(BSONNULL), Value(3)}}}},
+            expCtx);
+
+        deque<DocumentSource::GetNextResult> mockForeignContents{Document(foreignDoc0),
+                                                                 Document(foreignDoc1),
+                                                                 Document(foreignDoc2),
+                                                                 Document(foreignDoc3)};
+        expCtx->mongoProcessInterface =
+            std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+
+        auto lookupSpec = Document{{"$lookup",
+                                    Document{{"from", fromNs.coll()},
+                                             {"localField", "foreignId"_sd},
+                                             {"foreignField", "key"_sd},
+                                             {"as", "foreignDocs"_sd}}}}
+                              .toBson();
+        auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+        auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+        lookup->setSource(mockLocalSource.get());
+
+        vector<Document> results;
+        for (auto next = lookup->getNext(); next.isAdvanced(); next = lookup->getNext()) {
+            results.push_back(next.releaseDocument());
+        }
+        ASSERT(lookup->getJoinStrategy() == expectedStrategy);
+
+        vector<Value> explain;
+        lookup->serializeToArray(explain, kExplain);
+        ASSERT_EQ(1U, explain.size());
+        ASSERT_VALUE_EQ(explain[0]["$lookup"]["strategy"],
+                        Value(expectedStrategy == DocumentSourceLookUp::JoinStrategy::kHashJoin
+                                  ? "HashJoin"_sd
+                                  : "NestedLoopJoin"_sd));
+        ASSERT_VALUE_EQ(explain[0]["$lookup"]["hashJoinExceededMemoryLimit"],
+                        exceededMemoryLimit ? Value(true) : Value());
+
+        lookup->dispose();
+        return results;
+    };
+
+    vector<Document> expectedResults{
+        Document{{"foreignId", 1},
+                 {"foreignDocs", vector<Value>{Value(foreignDoc0), Value(foreignDoc1)}}},
+        Document{{"foreignId", vector<Value>{Value(2), Value(3)}},
+                 {"foreignDocs", vector<Value>{Value(foreignDoc1), Value(foreignDoc2)}}},
+        Document{{"foreignId", 4}, {"foreignDocs", vector<Value>{}}},
+        Document{{"other", 1}, {"foreignDocs", vector<Value>{Value(foreignDoc3)}}},
+        Document{{"foreignId", vector<Value>{Value(BSONNULL), Value(3)}},
+                 {"foreignDocs", vector<Value>{Value(foreignDoc2), Value(foreignDoc3)}}}};
+    auto assertExpectedResults = [&](const vector<Document>& results) {
+        ASSERT_EQ(expectedResults.size(), results.size());
+        for (size_t i = 0; i < expectedResults.size(); ++i) {
+            ASSERT_DOCUMENT_EQ(expectedResults[i], results[i]);
+        }
+    };
+
+    assertExpectedResults(runLookup(DocumentSourceLookUp::JoinStrategy::kNestedLoopJoin, false));
+
+    // With a large enough memory limit the foreign collection fits in the hash table.
+    internalLookupHashJoinMaxMemoryBytes.store(100 * 1024 * 1024);
+    assertExpectedResults(runLookup(DocumentSourceLookUp::JoinStrategy::kHashJoin, false));
+
+    // Once the foreign collection exceeds the memory limit, $lookup falls back to querying the
+    // foreign collection for every input document.
+    internalLookupHashJoinMaxMemoryBytes.store(1);
+    assertExpectedResults(runLookup(DocumentSourceLookUp::JoinStrategy::kNestedLoopJoin, true));
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinUnwindsMatches) {
+    const auto originalLimit = internalLookupHashJoinMaxMemoryBytes.load();
+    internalLookupHashJoinMaxMemoryBytes.store(100 * 1024 * 1024);
+    ON_BLOCK_EXIT([&] { internalLookupHashJoinMaxMemoryBytes.store(originalLimit); });
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}, {"key", 1}},
+                                                             Document{{"_id", 1}, {"key", 2}},
+                                                             Document{{"_id", 2}, {"key", 1}}};
+    expCtx->mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "key"_sd},
+                                         {"as", "foreignDoc"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    const bool preserveNullAndEmptyArrays = true;
+    const boost::optional<std::string> includeArrayIndex = boost::none;
+    lookup->setUnwindStage(DocumentSourceUnwind::create(
+        expCtx, "foreignDoc", preserveNullAndEmptyArrays, includeArrayIndex));
+
+    auto mockLocalSource = DocumentSourceMock::createForTest(
+        {Document{{"foreignId", 1}}, Document{{"foreignId", 3}}}, expCtx);
+    lookup->setSource(mockLocalSource.get());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 1}, {"foreignDoc", Document{{"_id", 0}, {"key", 1}}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 1}, {"foreignDoc", Document{{"_id", 2}, {"key", 1}}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"foreignId", 3}}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kHashJoin);
+    lookup->dispose();
+}
+
 TEST_F(DocumentSourceLookUpTest, LookupReportsAsFieldIsModified) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
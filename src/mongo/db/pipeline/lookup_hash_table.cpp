@@ -0,0 +1,134 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/lookup_hash_table.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "mongo/db/matcher/path_internal.h"
+
+namespace mongo {
+
+LookupHashTable::LookupHashTable(FieldPath foreignField,
+                                 const ValueComparator& comparator,
+                                 size_t maxMemoryUsageBytes)
+    : _foreignField(std::move(foreignField)),
+      _maxMemoryUsageBytes(maxMemoryUsageBytes),
+      _table(comparator.makeUnorderedValueMap<std::vector<size_t>>()) {}
+
+bool LookupHashTable::insert(BSONObj foreignDoc) {
+    const auto pos = _documents.size();
+    _memoryUsageBytes += foreignDoc.objsize() + sizeof(BSONObj);
+    _documents.push_back(foreignDoc.getOwned());
+
+    if (auto elem = _documents.back()[_foreignField.getFieldName(0)]; !elem.eoo()) {
+        addKeys(elem, 1, pos);
+    }
+
+    return _memoryUsageBytes <= _maxMemoryUsageBytes;
+}
+
+void LookupHashTable::addKeys(const BSONElement& elem, size_t depth, size_t pos) {
+    if (depth == _foreignField.getPathLength()) {
+        // An equality predicate matches both an array as a whole and each of its elements.
+        addKey(Value(elem), pos);
+        if (elem.type() == BSONType::Array) {
+            for (auto&& arrayElem : elem.Obj()) {
+                addKey(Value(arrayElem), pos);
+            }
+        }
+        return;
+    }
+
+    const auto fieldName = _foreignField.getFieldName(depth);
+    if (elem.type() == BSONType::Object) {
+        if (auto child = elem.Obj()[fieldName]; !child.eoo()) {
+            addKeys(child, depth + 1, pos);
+        }
+    } else if (elem.type() == BSONType::Array) {
+        // The path descends implicitly into the objects of an array. A numeric path component may
+        // also address an array element directly.
+        for (auto&& arrayElem : elem.Obj()) {
+            if (arrayElem.type() == BSONType::Object) {
+                if (auto child = arrayElem.Obj()[fieldName]; !child.eoo()) {
+                    addKeys(child, depth + 1, pos);
+                }
+            }
+        }
+        if (isAllDigits(fieldName)) {
+            if (auto child = elem.Obj()[fieldName]; !child.eoo()) {
+                addKeys(child, depth + 1, pos);
+            }
+        }
+    }
+}
+
+void LookupHashTable::addKey(Value key, size_t pos) {
+    auto [it, inserted] = _table.try_emplace(std::move(key));
+    if (inserted) {
+        _memoryUsageBytes += it->first.getApproximateSize();
+    }
+
+    // A document may produce the same key more than once, e.g. from repeated array elements.
+    auto& positions = it->second;
+    if (positions.empty() || positions.back() != pos) {
+        positions.push_back(pos);
+        _memoryUsageBytes += sizeof(size_t);
+    }
+}
+
+std::vector<size_t> LookupHashTable::getCandidates(const std::vector<Value>& localValues) const {
+    const bool matchesMissing = localValues.empty() ||
+        std::any_of(localValues.begin(), localValues.end(), [](const Value& value) {
+            return value.nullish();
+        });
+
+    std::vector<size_t> candidates;
+    if (matchesMissing) {
+        candidates.resize(_documents.size());
+        std::iota(candidates.begin(), candidates.end(), 0);
+        return candidates;
+    }
+
+    for (auto&& value : localValues) {
+        if (auto it = _table.find(value); it != _table.end()) {
+            candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    // Restore the foreign order and drop the documents found through more than one value.
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    return candidates;
+}
+
+}  // namespace mongo
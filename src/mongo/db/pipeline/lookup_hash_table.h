@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/db/pipeline/field_path.h"
+
+namespace mongo {
+
+/**
+ * An in-memory hash table over the documents of a $lookup's foreign collection, keyed by the
+ * values found at the 'foreignField' path. It lets an equality $lookup be executed as a hash join:
+ * the foreign side is read once into the table, which is then probed with the 'localField' values
+ * of every input document.
+ *
+ * Keys are added for the values at 'foreignField' the way an equality predicate reaches them: for
+ * arrays both as a whole and element by element, descending implicitly through arrays of objects.
+ * Probing with values which are neither null nor missing therefore returns exactly the documents
+ * the join predicate matches. Matching null against missing fields is not reproduced here, so a
+ * null or missing probe value returns every document as a candidate, to which the caller must
+ * still apply the predicate.
+ */
+class LookupHashTable {
+public:
+    /**
+     * The 'comparator' must outlive this object.
+     */
+    LookupHashTable(FieldPath foreignField,
+                    const ValueComparator& comparator,
+                    size_t maxMemoryUsageBytes);
+
+    /**
+     * Adds a foreign document to the table. Returns false if doing so makes the table exceed its
+     * memory budget, in which case the table must no longer be used.
+     */
+    bool insert(BSONObj foreignDoc);
+
+    /**
+     * Returns the positions of the candidate foreign documents for a local document whose
+     * 'localField' has the given values, in insertion order and without duplicates. An empty
+     * 'localValues' stands for a missing 'localField'. Since null matches missing fields, a null
+     * or missing local value makes every foreign document a candidate.
+     */
+    std::vector<size_t> getCandidates(const std::vector<Value>& localValues) const;
+
+    const BSONObj& getDocument(size_t pos) const {
+        return _documents[pos];
+    }
+
+    size_t size() const {
+        return _documents.size();
+    }
+
+    size_t getMemoryUsageBytes() const {
+        return _memoryUsageBytes;
+    }
+
+private:
+    /**
+     * Adds 'pos' under every key that 'elem', found after following the first 'depth' components
+     * of the foreign field path, can be matched by.
+     */
+    void addKeys(const BSONElement& elem, size_t depth, size_t pos);
+
+    void addKey(Value key, size_t pos);
+
+    const FieldPath _foreignField;
+    const size_t _maxMemoryUsageBytes;
+
+    std::vector<BSONObj> _documents;
+    ValueUnorderedMap<std::vector<size_t>> _table;
+    size_t _memoryUsageBytes = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,126 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/bson/json.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using Positions = std::vector<size_t>;
+
+const ValueComparator defaultComparator{nullptr};
+const size_t kUnlimited = std::numeric_limits<size_t>::max();
+
+LookupHashTable makeTable(StringData foreignField,
+                          const std::vector<BSONObj>& docs,
+                          const ValueComparator& comparator = defaultComparator) {
+    LookupHashTable table(FieldPath(foreignField), comparator, kUnlimited);
+    for (auto&& doc : docs) {
+        ASSERT_TRUE(table.insert(doc));
+    }
+    return table;
+}
+
+TEST(LookupHashTableTest, FindsScalarKeys) {
+    auto table = makeTable("a", {fromjson("{a: 1}"), fromjson("{a: 2}"), fromjson("{a: 1.0}")});
+    ASSERT_EQ(3U, table.size());
+    ASSERT(table.getCandidates({Value(1)}) == (Positions{0, 2}));
+    ASSERT(table.getCandidates({Value(2)}) == (Positions{1}));
+    ASSERT(table.getCandidates({Value(3)}).empty());
+    ASSERT_BSONOBJ_EQ(table.getDocument(1), fromjson("{a: 2}"));
+}
+
+TEST(LookupHashTableTest, FindsArraysAndTheirElements) {
+    auto table = makeTable("a", {fromjson("{a: [1, 2, 2]}"), fromjson("{a: 2}")});
+    ASSERT(table.getCandidates({Value(1)}) == (Positions{0}));
+    ASSERT(table.getCandidates({Value(2)}) == (Positions{0, 1}));
+    ASSERT(table.getCandidates({Value(BSON_ARRAY(1 << 2 << 2))}) == (Positions{0}));
+}
+
+TEST(LookupHashTableTest, ReturnsUnionOfCandidatesInInsertionOrder) {
+    auto table = makeTable("a", {fromjson("{a: 3}"), fromjson("{a: [1, 3]}"), fromjson("{a: 1}")});
+    ASSERT(table.getCandidates({Value(3), Value(1)}) == (Positions{0, 1, 2}));
+}
+
+TEST(LookupHashTableTest, FollowsDottedPathsThroughObjectsAndArrays) {
+    auto table = makeTable("a.b",
+                           {fromjson("{a: {b: 1}}"),
+                            fromjson("{a: [{b: 2}, {b: [3]}]}"),
+                            fromjson("{a: 1}"),
+                            fromjson("{b: 1}")});
+    ASSERT(table.getCandidates({Value(1)}) == (Positions{0}));
+    ASSERT(table.getCandidates({Value(2)}) == (Positions{1}));
+    ASSERT(table.getCandidates({Value(3)}) == (Positions{1}));
+}
+
+TEST(LookupHashTableTest, FollowsNumericPathComponentsIntoArrays) {
+    auto table = makeTable("a.1", {fromjson("{a: [5, 6]}"), fromjson("{a: {'1': 7}}")});
+    ASSERT(table.getCandidates({Value(6)}) == (Positions{0}));
+    ASSERT(table.getCandidates({Value(5)}).empty());
+    ASSERT(table.getCandidates({Value(7)}) == (Positions{1}));
+}
+
+TEST(LookupHashTableTest, NullOrMissingLocalValueMakesEveryDocumentACandidate) {
+    auto table = makeTable("a", {fromjson("{a: 1}"), fromjson("{b: 1}"), fromjson("{a: null}")});
+    ASSERT(table.getCandidates({}) == (Positions{0, 1, 2}));
+    ASSERT(table.getCandidates({Value(BSONNULL)}) == (Positions{0, 1, 2}));
+    ASSERT(table.getCandidates({Value(1), Value(BSONUndefined)}) == (Positions{0, 1, 2}));
+}
+
+TEST(LookupHashTableTest, RespectsCollation) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    ValueComparator comparator(&collator);
+    auto table = makeTable("a", {fromjson("{a: 'foo'}"), fromjson("{a: 'bar'}")}, comparator);
+    ASSERT(table.getCandidates({Value("baz"_sd)}) == (Positions{0, 1}));
+}
+
+TEST(LookupHashTableTest, InsertFailsOnceMemoryLimitIsExceeded) {
+    auto doc = fromjson("{a: 1}");
+    LookupHashTable table(FieldPath("a"), defaultComparator, 2 * doc.objsize() + 200);
+    ASSERT_TRUE(table.insert(doc));
+    ASSERT_GT(table.getMemoryUsageBytes(), static_cast<size_t>(doc.objsize()));
+
+    bool exceeded = false;
+    for (int i = 0; i < 10 && !exceeded; ++i) {
+        exceeded = !table.insert(BSON("a" << i));
+    }
+    ASSERT_TRUE(exceeded);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -69,7 +69,9 @@
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_executor_factory.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/query/sbe_stage_builder_group.h"
 #include "mongo/db/query/sort_pattern.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/service_context.h"
@@ -197,7 +199,8 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExe
     boost::optional<std::string> groupIdForDistinctScan,
     const AggregationRequest* aggRequest,
     const size_t plannerOpts,
-    const MatchExpressionParser::AllowedFeatureSet& matcherFeatures) {
+    const MatchExpressionParser::AllowedFeatureSet& matcherFeatures,
+    boost::optional<PushedDownGroup> pushedDownGroup = boost::none) {
     auto qr = std::make_unique<QueryRequest>(nss);
     qr->setTailableMode(expCtx->tailableMode);
     qr->setFilter(queryObj);
@@ -235,6 +238,10 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExe
     // Mark the metadata that's requested by the pipeline on the CQ.
     cq.getValue()->requestAdditionalMetadata(metadataRequested);
 
+    if (pushedDownGroup) {
+        cq.getValue()->setPushedDownGroup(std::move(*pushedDownGroup));
+    }
+
     if (groupIdForDistinctScan) {
         // When the pipeline includes a $group that groups by a single field
         // (groupIdForDistinctScan), we use getExecutorDistinct() to attempt to get an executor that
@@ -267,6 +274,39 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExe
         expCtx->opCtx, collection, std::move(cq.getValue()), permitYield, plannerOpts);
 }
 
+/**
+ * Returns a description of the $group at the front of 'pipeline' if it can be pushed down into the
+ * slot-based execution engine, and boost::none otherwise. A $group which merges partial results,
+ * produces partial results for a merger, or depends on a non-simple collation stays in the
+ * pipeline, as does any $group on top of a tailable or oplog-tracking query.
+ */
+boost::optional<PushedDownGroup> getGroupForPushdown(
+    const intrusive_ptr<ExpressionContext>& expCtx, Pipeline* pipeline, size_t plannerOpts) {
+    if (!internalQueryEnableSlotBasedExecutionEngine.load() || expCtx->needsMerge ||
+        expCtx->getCollator() || expCtx->tailableMode != TailableModeEnum::kNormal ||
+        (plannerOpts & QueryPlannerParams::TRACK_LATEST_OPLOG_TS)) {
+        return boost::none;
+    }
+
+    auto groupStage = dynamic_cast<DocumentSourceGroup*>(pipeline->peekFront());
+    if (!groupStage || groupStage->doingMerge()) {
+        return boost::none;
+    }
+
+    auto idFields = groupStage->getIdFields();
+    if (idFields.size() != 1 || idFields.begin()->first != "_id") {
+        return boost::none;
+    }
+
+    PushedDownGroup group{idFields.begin()->second,
+                          groupStage->getAccumulatedFields(),
+                          groupStage->serialize(expCtx->explain).getDocument().toBson()};
+    if (!stage_builder::isGroupPushdownSupported(group)) {
+        return boost::none;
+    }
+    return group;
+}
+
 /**
  * Examines the indexes in 'collection' and returns the field name of a geo-indexed field suitable
  * for use in $geoNear. 2d indexes are given priority over 2dsphere indexes.
@@ -740,6 +780,30 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
         }
     }
 
+    // If the slot-based execution engine is enabled and the pipeline now begins with a $group which
+    // SBE can compute, push the $group down so that it is executed by a HashAggStage on top of the
+    // query plan. The count optimization is preferred when the $group does not need any fields.
+    if (auto pushedDownGroup = getGroupForPushdown(expCtx, pipeline, plannerOpts);
+        pushedDownGroup && !*hasNoRequirements) {
+        auto swExecutor = attemptToGetExecutor(expCtx,
+                                               collection,
+                                               nss,
+                                               queryObj,
+                                               projObj,
+                                               deps.metadataDeps(),
+                                               sortObj,
+                                               limit,
+                                               boost::none, /* groupIdForDistinctScan */
+                                               aggRequest,
+                                               plannerOpts,
+                                               matcherFeatures,
+                                               std::move(pushedDownGroup));
+        if (swExecutor.isOK()) {
+            pipeline->popFrontWithName(DocumentSourceGroup::kStageName);
+        }
+        return swExecutor;
+    }
+
     return attemptToGetExecutor(expCtx,
                                 collection,
                                 nss,
@@ -54,6 +54,7 @@
 #include "mongo/db/pipeline/pipeline_d.h"
 #include "mongo/db/query/collection_index_usage_tracker_decoration.h"
 #include "mongo/db/query/collection_query_info.h"
+#include "mongo/db/query/sbe_plan_cache.h"
 #include "mongo/db/repl/primary_only_service.h"
 #include "mongo/db/repl/speculative_majority_read_info.h"
 #include "mongo/db/s/collection_sharding_state.h"
@@ -398,8 +399,11 @@ BackupCursorExtendState CommonMongodProcessInterface::extendBackupCursor(
 
 std::vector<BSONObj> CommonMongodProcessInterface::getMatchingPlanCacheEntryStats(
     OperationContext* opCtx, const NamespaceString& nss, const MatchExpression* matchExp) const {
+    // The entries of the classic and slot-based engine plan caches have different fields, so each
+    // document says which cache it comes from.
     const auto serializer = [](const PlanCacheEntry& entry) {
         BSONObjBuilder out;
+        out.append("engine", "classic");
         Explain::planCacheEntryToBSON(entry, &out);
         return out.obj();
     };
@@ -415,7 +419,12 @@ std::vector<BSONObj> CommonMongodProcessInterface::getMatchingPlanCacheEntryStat
     const auto planCache = CollectionQueryInfo::get(collection.getCollection()).getPlanCache();
     invariant(planCache);
 
-    return planCache->getMatchingStats(serializer, predicate);
+    auto stats = planCache->getMatchingStats(serializer, predicate);
+    auto sbeStats = sbe::PlanCache::get(collection.getCollection()).getMatchingStats(predicate);
+    stats.insert(stats.end(),
+                 std::make_move_iterator(sbeStats.begin()),
+                 std::make_move_iterator(sbeStats.end()));
+    return stats;
 }
 
 bool CommonMongodProcessInterface::fieldsHaveSupportingUniqueIndex(
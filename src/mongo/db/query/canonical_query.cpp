@@ -37,6 +37,7 @@
 #include "mongo/db/commands/test_commands_enabled.h"
 #include "mongo/db/cst/cst_parser.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/expression_algo.h"
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
@@ -44,6 +45,7 @@
 #include "mongo/db/query/collation/collator_factory_interface.h"
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/projection_parser.h"
+#include "mongo/db/query/query_arena.h"
 #include "mongo/db/query/query_planner_common.h"
 
 namespace mongo {
@@ -83,6 +85,9 @@ StatusWith<std::unique_ptr<CanonicalQuery>> CanonicalQuery::canonicalize(
     const ExtensionsCallback& extensionsCallback,
     MatchExpressionParser::AllowedFeatureSet allowedFeatures,
     const ProjectionPolicies& projectionPolicies) {
+    auto arena = makeQueryArena();
+    QueryArenaScope arenaScope(arena.get());
+
     auto qrStatus = qr->validate();
     if (!qrStatus.isOK()) {
         return qrStatus;
@@ -118,6 +123,7 @@ StatusWith<std::unique_ptr<CanonicalQuery>> CanonicalQuery::canonicalize(
 
     // Make the CQ we'll hopefully return.
     std::unique_ptr<CanonicalQuery> cq(new CanonicalQuery());
+    cq->_arena = std::move(arena);
 
     StatusWithMatchExpression statusWithMatcher = [&]() -> StatusWithMatchExpression {
         if (getTestCommandsEnabled() && internalQueryEnableCSTParser.load()) {
@@ -147,12 +153,19 @@ StatusWith<std::unique_ptr<CanonicalQuery>> CanonicalQuery::canonicalize(
     if (!initStatus.isOK()) {
         return initStatus;
     }
+
+    // Queries derived from this one, such as the branches of a rooted $or, keep the input
+    // parameters assigned here, so that all the plans built for this query agree on their ids.
+    expression::parameterize(cq->_root.get());
     return std::move(cq);
 }
 
 // static
 StatusWith<std::unique_ptr<CanonicalQuery>> CanonicalQuery::canonicalize(
     OperationContext* opCtx, const CanonicalQuery& baseQuery, MatchExpression* root) {
+    auto arena = makeQueryArena();
+    QueryArenaScope arenaScope(arena.get());
+
     auto qr = std::make_unique<QueryRequest>(baseQuery.nss());
     BSONObjBuilder builder;
     root->serialize(&builder, true);
@@ -168,6 +181,7 @@ StatusWith<std::unique_ptr<CanonicalQuery>> CanonicalQuery::canonicalize(
 
     // Make the CQ we'll hopefully return.
     std::unique_ptr<CanonicalQuery> cq(new CanonicalQuery());
+    cq->_arena = std::move(arena);
     Status initStatus = cq->init(opCtx,
                                  baseQuery.getExpCtx(),
                                  std::move(qr),
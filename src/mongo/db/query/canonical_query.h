@@ -35,16 +35,33 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/matcher/extensions_callback_noop.h"
+#include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/projection.h"
 #include "mongo/db/query/projection_policies.h"
 #include "mongo/db/query/query_request.h"
 #include "mongo/db/query/sort_pattern.h"
+#include "mongo/util/arena.h"
 
 namespace mongo {
 
 class OperationContext;
 
+/**
+ * A $group stage of an aggregation pipeline which has been pushed down into the query, so that it
+ * is executed by the slot-based execution engine on top of the plan for the query.
+ */
+struct PushedDownGroup {
+    // The expression evaluated to compute the group key.
+    boost::intrusive_ptr<Expression> idExpression;
+
+    // The accumulators computed for every group, in the order of the output fields.
+    std::vector<AccumulationStatement> accumulators;
+
+    // The $group stage as serialized for explain, so that it can be reported with the query plan.
+    BSONObj explainInfo;
+};
+
 class CanonicalQuery {
 public:
     // A type that encodes the notion of query shape. Essentialy a query's match, projection and
@@ -216,6 +233,26 @@ public:
         return _expCtx.get();
     }
 
+    /**
+     * Returns the $group stage pushed down into this query, if any. It must be executed over the
+     * results of the query plan, which does not account for it.
+     */
+    const boost::optional<PushedDownGroup>& getPushedDownGroup() const {
+        return _pushedDownGroup;
+    }
+
+    void setPushedDownGroup(PushedDownGroup group) {
+        _pushedDownGroup = std::move(group);
+    }
+
+    /**
+     * Returns the arena which the MatchExpression tree of this query was placed in, and which the
+     * solutions planned for it should be placed in, or nullptr if they use the heap.
+     */
+    Arena* getArena() const {
+        return _arena.get();
+    }
+
 private:
     // You must go through canonicalize to create a CanonicalQuery.
     CanonicalQuery() {}
@@ -247,6 +284,10 @@ private:
     QueryMetadataBitSet _metadataDeps;
 
     bool _canHaveNoopMatchNodes = false;
+
+    boost::optional<PushedDownGroup> _pushedDownGroup;
+
+    boost::intrusive_ptr<Arena> _arena;
 };
 
 }  // namespace mongo
@@ -30,11 +30,14 @@
 #include "mongo/db/query/canonical_query.h"
 
 #include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_algo.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/query/collation/collator_factory_interface.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -286,6 +289,35 @@ TEST(CanonicalQueryTest, CanonicalizeFromBaseQuery) {
     ASSERT_TRUE(childCq->getQueryRequest().isExplain());
 }
 
+TEST(CanonicalQueryTest, EachQueryOwnsTheArenaOfItsTreeWhenEnabled) {
+    QueryTestServiceContext serviceContext;
+    auto opCtx = serviceContext.makeOperationContext();
+    auto makeQuery = [&] {
+        auto qr = std::make_unique<QueryRequest>(nss);
+        qr->setFilter(fromjson("{$or: [{a: 1}, {b: {$gt: 2}}]}"));
+        return assertGet(CanonicalQuery::canonicalize(opCtx.get(), std::move(qr)));
+    };
+
+    ASSERT(makeQuery()->getArena() == nullptr);
+
+    const bool wasEnabled = internalQueryEnableQueryArena.load();
+    internalQueryEnableQueryArena.store(true);
+    ON_BLOCK_EXIT([&] { internalQueryEnableQueryArena.store(wasEnabled); });
+
+    // Queries of the same operation don't share an arena, so it goes away with its query.
+    auto first = makeQuery();
+    auto second = makeQuery();
+    ASSERT(first->getArena() != nullptr);
+    ASSERT(second->getArena() != nullptr);
+    ASSERT(first->getArena() != second->getArena());
+    ASSERT_GT(first->getArena()->stats().allocations, 0U);
+
+    auto child = assertGet(
+        CanonicalQuery::canonicalize(opCtx.get(), *first, first->root()->getChild(0)));
+    ASSERT(child->getArena() != nullptr);
+    ASSERT(child->getArena() != first->getArena());
+}
+
 TEST(CanonicalQueryTest, CanonicalQueryFromQRWithNoCollation) {
     QueryTestServiceContext serviceContext;
     auto opCtx = serviceContext.makeOperationContext();
@@ -448,5 +480,30 @@ TEST(CanonicalQueryTest, InvalidSortOrdersFailToCanonicalize) {
     assertInvalidSortOrder(fromjson("{'': -1}"));
 }
 
+TEST(CanonicalQueryTest, CanonicalizeAssignsInputParamsInNormalizedOrder) {
+    // The ids follow the normalized order of the predicates, so that queries of the same shape
+    // agree on them however their predicates are ordered.
+    auto cq = canonicalize("{c: {$gt: 1}, b: 'x', a: 2}");
+    auto inputParams = expression::getInputParams(cq->root());
+    ASSERT_EQ(inputParams.size(), 2U);
+    ASSERT_EQ(inputParams[0].numberInt(), 2);
+    ASSERT_EQ(inputParams[1].str(), "x");
+}
+
+TEST(CanonicalQueryTest, CanonicalizeFromBaseQueryDoesNotAssignInputParams) {
+    QueryTestServiceContext serviceContext;
+    auto opCtx = serviceContext.makeOperationContext();
+    auto qr = std::make_unique<QueryRequest>(nss);
+    qr->setFilter(fromjson("{$or: [{a: 1}, {b: 2}]}"));
+    auto baseCq = assertGet(CanonicalQuery::canonicalize(opCtx.get(), std::move(qr)));
+    ASSERT(expression::getInputParams(baseCq->root()).empty());
+
+    // The branches of a rooted $or are not parameterized, although they would be as queries of
+    // their own.
+    auto childCq = assertGet(
+        CanonicalQuery::canonicalize(opCtx.get(), *baseCq, baseCq->root()->getChild(0)));
+    ASSERT(expression::getInputParams(childCq->root()).empty());
+}
+
 }  // namespace
 }  // namespace mongo
@@ -0,0 +1,97 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/column_segment.h"
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+void ColumnSegment::Builder::append(const BSONElement& value) {
+    uint32_t code = kMissing;
+    if (!value.eoo()) {
+        // The key is the element without its field name: the type byte followed by the value.
+        std::string key;
+        key.reserve(1 + value.valuesize());
+        key.push_back(static_cast<char>(value.type()));
+        key.append(value.value(), value.valuesize());
+
+        auto [it, inserted] = _codes.emplace(std::move(key), _segment._offsets.size());
+        if (inserted) {
+            _segment._offsets.push_back(_segment._dictionary.size());
+            _segment._dictionary.push_back(static_cast<char>(value.type()));
+            _segment._dictionary.push_back('\0');
+            _segment._dictionary.append(value.value(), value.valuesize());
+        }
+        code = it->second;
+    }
+
+    auto& runs = _segment._runs;
+    if (!runs.empty() && runs.back().code == code &&
+        runs.back().length < std::numeric_limits<uint32_t>::max()) {
+        ++runs.back().length;
+    } else {
+        runs.push_back({code, 1});
+    }
+    ++_segment._numRows;
+}
+
+ColumnSegment ColumnSegment::Builder::done() {
+    _codes.clear();
+    _segment._dictionary.shrink_to_fit();
+    _segment._offsets.shrink_to_fit();
+    _segment._runs.shrink_to_fit();
+    return std::move(_segment);
+}
+
+BSONElement ColumnSegment::Cursor::next() {
+    invariant(_run < _segment->_runs.size());
+    const auto& run = _segment->_runs[_run];
+    if (++_consumed == run.length) {
+        ++_run;
+        _consumed = 0;
+    }
+    return _segment->_value(run.code);
+}
+
+size_t ColumnSegment::memUsageBytes() const {
+    return _dictionary.capacity() + _offsets.capacity() * sizeof(uint32_t) +
+        _runs.capacity() * sizeof(Run);
+}
+
+BSONElement ColumnSegment::_value(uint32_t code) const {
+    if (code == kMissing) {
+        return BSONElement();
+    }
+    return BSONElement(_dictionary.data() + _offsets[code]);
+}
+
+}  // namespace mongo
@@ -0,0 +1,131 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bsonelement.h"
+#include "mongo/stdx/unordered_map.h"
+
+namespace mongo {
+
+/**
+ * An immutable, compressed sequence of the values of one field in consecutive rows of a
+ * collection. Every distinct value is stored once in a dictionary, and the rows are stored as runs
+ * of dictionary codes, so a low-cardinality field (a status, a category, a day) costs a few bytes
+ * per run of equal values rather than a full BSON element per document. Rows which don't have the
+ * field are encoded with the reserved code 'kMissing'.
+ *
+ * Values keep their exact BSON representation: two values are only folded into one dictionary
+ * entry if they have the same type and the same bytes, so 1 and 1.0 are kept apart.
+ */
+class ColumnSegment {
+public:
+    static constexpr uint32_t kMissing = std::numeric_limits<uint32_t>::max();
+
+    class Builder;
+
+    /**
+     * Decodes the rows of a segment in order. The segment must outlive the cursor.
+     */
+    class Cursor {
+    public:
+        explicit Cursor(const ColumnSegment& segment) : _segment(&segment) {}
+
+        /**
+         * Returns the value of the next row, or an EOO element if the row doesn't have the field.
+         * The element has an empty field name and points into the segment's dictionary.
+         */
+        BSONElement next();
+
+    private:
+        const ColumnSegment* _segment;
+        size_t _run{0};
+        uint32_t _consumed{0};
+    };
+
+    ColumnSegment() = default;
+
+    size_t numRows() const {
+        return _numRows;
+    }
+
+    size_t numRuns() const {
+        return _runs.size();
+    }
+
+    size_t dictionarySize() const {
+        return _offsets.size();
+    }
+
+    /**
+     * Returns the number of heap bytes held by the segment.
+     */
+    size_t memUsageBytes() const;
+
+private:
+    struct Run {
+        uint32_t code;
+        uint32_t length;
+    };
+
+    BSONElement _value(uint32_t code) const;
+
+    // The dictionary, as a sequence of BSON elements with empty field names, and the offset of
+    // each entry in it.
+    std::string _dictionary;
+    std::vector<uint32_t> _offsets;
+
+    std::vector<Run> _runs;
+    size_t _numRows{0};
+};
+
+/**
+ * Encodes the values of a segment one row at a time.
+ */
+class ColumnSegment::Builder {
+public:
+    /**
+     * Appends the value of the next row. An EOO element means that the field is missing.
+     */
+    void append(const BSONElement& value);
+
+    ColumnSegment done();
+
+private:
+    ColumnSegment _segment;
+
+    // Maps the type and value bytes of every dictionary entry to its code.
+    stdx::unordered_map<std::string, uint32_t> _codes;
+};
+
+}  // namespace mongo
@@ -0,0 +1,109 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/query/column_segment.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(ColumnSegmentTest, EncodesEqualNeighboursAsRuns) {
+    auto values = BSON_ARRAY(1 << 1 << 1 << "a"
+                               << "a" << 1);
+    ColumnSegment::Builder builder;
+    for (auto&& elem : values) {
+        builder.append(elem);
+    }
+    builder.append(BSONElement());
+    builder.append(BSONElement());
+    auto segment = builder.done();
+
+    ASSERT_EQ(segment.numRows(), 8U);
+    ASSERT_EQ(segment.numRuns(), 4U);
+    ASSERT_EQ(segment.dictionarySize(), 2U);
+
+    ColumnSegment::Cursor cursor(segment);
+    for (auto&& elem : values) {
+        auto decoded = cursor.next();
+        ASSERT_EQ(decoded.fieldNameStringData(), "");
+        ASSERT_EQ(decoded.woCompare(elem, false), 0);
+    }
+    ASSERT(cursor.next().eoo());
+    ASSERT(cursor.next().eoo());
+}
+
+TEST(ColumnSegmentTest, KeepsValuesOfDifferentTypesApart) {
+    BSONObjBuilder bob;
+    bob.append("a", 1);
+    bob.append("b", 1LL);
+    bob.append("c", 1.0);
+    bob.append("d", 1);
+    auto values = bob.obj();
+
+    ColumnSegment::Builder builder;
+    for (auto&& elem : values) {
+        builder.append(elem);
+    }
+    auto segment = builder.done();
+
+    ASSERT_EQ(segment.numRuns(), 4U);
+    ASSERT_EQ(segment.dictionarySize(), 3U);
+
+    ColumnSegment::Cursor cursor(segment);
+    for (auto&& elem : values) {
+        auto decoded = cursor.next();
+        ASSERT_EQ(decoded.type(), elem.type());
+        ASSERT_EQ(decoded.valuesize(), elem.valuesize());
+        ASSERT_EQ(memcmp(decoded.value(), elem.value(), elem.valuesize()), 0);
+    }
+}
+
+TEST(ColumnSegmentTest, StoresNestedValues) {
+    auto values = BSON("a" << BSON("x" << 1 << "y" << BSON_ARRAY(2 << 3)) << "b"
+                           << BSON_ARRAY("s" << BSONNULL) << "c"
+                           << BSON("x" << 1 << "y" << BSON_ARRAY(2 << 3)));
+
+    ColumnSegment::Builder builder;
+    for (auto&& elem : values) {
+        builder.append(elem);
+    }
+    auto segment = builder.done();
+    ASSERT_EQ(segment.dictionarySize(), 2U);
+
+    ColumnSegment::Cursor cursor(segment);
+    for (auto&& elem : values) {
+        ASSERT_EQ(cursor.next().woCompare(elem, false), 0);
+    }
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,677 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/columnar_cache.h"
+
+#include <bitset>
+
+#include "mongo/base/data_view.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/json.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/query/columnar_cache_gen.h"
+#include "mongo/db/service_context.h"
+#include "mongo/logv2/log.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace {
+
+// How long a build waits for the writes in flight on its collection to finish.
+constexpr auto kBuildLockTimeout = Seconds(1);
+
+// The number of records a build reads before releasing its locks and storage snapshot.
+constexpr size_t kBuildBatchSize = 4096;
+
+/**
+ * The collections and fields set through the 'columnarCacheCollections' server parameter. The
+ * generation changes on every update, so that registries know when to reconcile their caches.
+ */
+struct ColumnarCacheConfig {
+    BSONObj spec;
+    StringMap<std::vector<std::string>> collections;
+    uint64_t generation{0};
+};
+
+Mutex configMutex = MONGO_MAKE_LATCH("ColumnarCacheConfig::mutex");
+ColumnarCacheConfig config;
+AtomicWord<uint64_t> configGeneration{0};
+AtomicWord<bool> anyCollectionConfigured{false};
+
+const auto getColumnarCacheRegistry = ServiceContext::declareDecoration<ColumnarCacheRegistry>();
+
+StringMap<std::vector<std::string>> parseConfig(const BSONObj& spec) {
+    StringMap<std::vector<std::string>> collections;
+    for (auto&& collElem : spec) {
+        const NamespaceString nss(collElem.fieldNameStringData());
+        uassert(5150813,
+                str::stream() << "Invalid namespace for a columnar cache: " << nss,
+                nss.isValid() && !nss.isSystem() && !nss.isOnInternalDb());
+        uassert(5150814,
+                str::stream() << "The cached fields of " << nss << " must be an array",
+                collElem.type() == BSONType::Array);
+
+        std::vector<std::string> fields;
+        for (auto&& fieldElem : collElem.Obj()) {
+            uassert(5150815,
+                    str::stream() << "The cached fields of " << nss << " must be strings",
+                    fieldElem.type() == BSONType::String);
+            auto field = fieldElem.valueStringData();
+            uassert(5150816,
+                    str::stream() << "Invalid cached field name '" << field << "' for " << nss
+                                  << ": only non-empty top-level field names can be cached",
+                    !field.empty() && !field.startsWith("$") &&
+                        field.find('.') == std::string::npos);
+            uassert(5150817,
+                    str::stream() << "Duplicate cached field '" << field << "' for " << nss,
+                    std::find(fields.begin(), fields.end(), field) == fields.end());
+            fields.push_back(field.toString());
+        }
+        uassert(5150818,
+                str::stream() << "The number of cached fields of " << nss
+                              << " must be between 1 and " << ColumnarCollectionCache::kMaxFields,
+                !fields.empty() && fields.size() <= ColumnarCollectionCache::kMaxFields);
+        uassert(5150819,
+                str::stream() << "Duplicate columnar cache namespace " << nss,
+                collections.emplace(nss.ns(), std::move(fields)).second);
+    }
+    return collections;
+}
+
+void setConfig(const BSONObj& spec) {
+    auto collections = parseConfig(spec);
+
+    stdx::lock_guard<Latch> lk(configMutex);
+    config.spec = spec.getOwned();
+    config.collections = std::move(collections);
+    config.generation = configGeneration.addAndFetch(1);
+    anyCollectionConfigured.store(!config.collections.empty());
+}
+
+/**
+ * Returns a BinData element listing the field indexes of a row in order, stored in 'buf'.
+ */
+BSONElement makeFieldOrderElement(const std::vector<uint8_t>& order, std::string* buf) {
+    buf->assign(2 + sizeof(int32_t) + 1, '\0');
+    (*buf)[0] = static_cast<char>(BSONType::BinData);
+    DataView(&(*buf)[2]).write<LittleEndian<int32_t>>(order.size());
+    (*buf)[2 + sizeof(int32_t)] = static_cast<char>(BinDataGeneral);
+    buf->append(reinterpret_cast<const char*>(order.data()), order.size());
+    return BSONElement(buf->data());
+}
+
+}  // namespace
+
+ColumnarCollectionCache::ColumnarCollectionCache(NamespaceString nss,
+                                                 std::vector<std::string> fields)
+    : _nss(std::move(nss)), _fields(std::move(fields)) {
+    invariant(!_fields.empty() && _fields.size() <= kMaxFields);
+    for (size_t idx = 0; idx < _fields.size(); ++idx) {
+        _fieldIndexes.emplace(_fields[idx], idx);
+    }
+}
+
+BSONObj ColumnarCollectionCache::projectRow(const BSONObj& doc) const {
+    BSONObjBuilder builder;
+    std::bitset<kMaxFields> seen;
+    for (auto&& elem : doc) {
+        auto it = _fieldIndexes.find(elem.fieldNameStringData());
+        if (it != _fieldIndexes.end() && !seen[it->second]) {
+            seen.set(it->second);
+            builder.append(elem);
+        }
+    }
+    return builder.obj();
+}
+
+ColumnarCollectionCache::SnapshotBuilder::SnapshotBuilder(const ColumnarCollectionCache& cache)
+    : _cache(cache),
+      _snapshot(std::make_shared<ColumnarSnapshot>()),
+      _columns(cache._fields.size()) {}
+
+void ColumnarCollectionCache::SnapshotBuilder::append(const RecordId& recordId,
+                                                      const BSONObj& row) {
+    invariant(_recordIds.empty() || _recordIds.back() < recordId);
+
+    std::vector<BSONElement> values(_columns.size());
+    std::vector<uint8_t> order;
+    for (auto&& elem : row) {
+        auto it = _cache._fieldIndexes.find(elem.fieldNameStringData());
+        invariant(it != _cache._fieldIndexes.end() && values[it->second].eoo());
+        values[it->second] = elem;
+        order.push_back(it->second);
+    }
+
+    for (size_t idx = 0; idx < _columns.size(); ++idx) {
+        _columns[idx].append(values[idx]);
+    }
+    std::string orderBuf;
+    _fieldOrder.append(makeFieldOrderElement(order, &orderBuf));
+    _recordIds.push_back(recordId);
+
+    if (_recordIds.size() == kRowGroupSize) {
+        _flush();
+    }
+}
+
+std::shared_ptr<const ColumnarSnapshot> ColumnarCollectionCache::SnapshotBuilder::done() {
+    if (!_recordIds.empty()) {
+        _flush();
+    }
+    return std::move(_snapshot);
+}
+
+void ColumnarCollectionCache::SnapshotBuilder::_flush() {
+    auto rowGroup = std::make_shared<ColumnarRowGroup>();
+    rowGroup->recordIds = std::move(_recordIds);
+    for (auto&& column : _columns) {
+        rowGroup->columns.push_back(column.done());
+    }
+    rowGroup->fieldOrder = _fieldOrder.done();
+    _snapshot->rowGroups.push_back(std::move(rowGroup));
+
+    _recordIds.clear();
+    _columns = std::vector<ColumnSegment::Builder>(_cache._fields.size());
+    _fieldOrder = ColumnSegment::Builder();
+}
+
+ColumnarCollectionCache::RowReader::RowReader(const ColumnarCollectionCache& cache,
+                                              const ColumnarRowGroup& rowGroup)
+    : _cache(cache), _fieldOrder(rowGroup.fieldOrder), _values(rowGroup.columns.size()) {
+    for (auto&& column : rowGroup.columns) {
+        _columns.emplace_back(column);
+    }
+}
+
+void ColumnarCollectionCache::RowReader::next(BSONObjBuilder* builder) {
+    for (size_t idx = 0; idx < _columns.size(); ++idx) {
+        _values[idx] = _columns[idx].next();
+    }
+
+    int len = 0;
+    auto order = reinterpret_cast<const uint8_t*>(_fieldOrder.next().binData(len));
+    for (int pos = 0; pos < len; ++pos) {
+        const auto idx = order[pos];
+        builder->appendAs(_values[idx], _cache._fields[idx]);
+    }
+}
+
+void ColumnarCollectionCache::RowReader::skip() {
+    for (auto&& column : _columns) {
+        column.next();
+    }
+    _fieldOrder.next();
+}
+
+boost::optional<uint64_t> ColumnarCollectionCache::beginWrite(const RecordId& recordId) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_state != State::kBuilding && _state != State::kBuilt) {
+        return boost::none;
+    }
+
+    auto& pending = _pending[recordId];
+    if (pending.inFlight++ == 0 && pending.committed) {
+        --_numSettled;
+    }
+    return _nextSeq++;
+}
+
+void ColumnarCollectionCache::commitWrite(const RecordId& recordId,
+                                          uint64_t seq,
+                                          boost::optional<BSONObj> row) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto it = _pending.find(recordId);
+    if (seq < _firstSeq || it == _pending.end()) {
+        // The cache was invalidated since the write began.
+        return;
+    }
+
+    auto& pending = it->second;
+    invariant(pending.inFlight > 0);
+    --pending.inFlight;
+    if (!pending.committed || seq > pending.seq) {
+        pending.committed = true;
+        pending.seq = seq;
+        pending.row = std::move(row);
+    }
+    _settle(lk, it);
+
+    if (_state == State::kBuilt && _numSettled >= kFoldThreshold) {
+        _fold(lk);
+    }
+}
+
+void ColumnarCollectionCache::abortWrite(const RecordId& recordId, uint64_t seq) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto it = _pending.find(recordId);
+    if (seq < _firstSeq || it == _pending.end()) {
+        return;
+    }
+
+    invariant(it->second.inFlight > 0);
+    --it->second.inFlight;
+    _settle(lk, it);
+}
+
+void ColumnarCollectionCache::_settle(WithLock, std::map<RecordId, PendingRow>::iterator it) {
+    if (it->second.inFlight > 0) {
+        return;
+    }
+
+    if (it->second.committed) {
+        ++_numSettled;
+    } else {
+        _pending.erase(it);
+    }
+}
+
+bool ColumnarCollectionCache::startBuild(const UUID& collectionUUID) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_state != State::kUnbuilt) {
+        return false;
+    }
+
+    invariant(_pending.empty());
+    _state = State::kBuilding;
+    _uuid = collectionUUID;
+    _firstSeq = _nextSeq;
+    return true;
+}
+
+void ColumnarCollectionCache::finishBuild(std::shared_ptr<const ColumnarSnapshot> snapshot) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_state != State::kBuilding) {
+        // The cache was invalidated while the build was scanning.
+        return;
+    }
+
+    _snapshot = std::move(snapshot);
+    _state = State::kBuilt;
+    _fold(lk);
+}
+
+void ColumnarCollectionCache::invalidate() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _reset(lk, State::kUnbuilt);
+}
+
+void ColumnarCollectionCache::markUnsupported() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _reset(lk, State::kUnsupported);
+}
+
+void ColumnarCollectionCache::_reset(WithLock, State state) {
+    _state = state;
+    _uuid.reset();
+    _snapshot.reset();
+    _pending.clear();
+    _numSettled = 0;
+    _firstSeq = _nextSeq;
+}
+
+boost::optional<ColumnarCollectionCache::ReadView> ColumnarCollectionCache::acquireReadView(
+    const UUID& collectionUUID) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_state != State::kBuilt) {
+        return boost::none;
+    }
+
+    if (*_uuid != collectionUUID) {
+        // The collection was dropped and recreated, or renamed over, without us noticing.
+        _reset(lk, State::kUnbuilt);
+        return boost::none;
+    }
+
+    _fold(lk);
+
+    ReadView view;
+    view.snapshot = _snapshot;
+    view.inFlight.reserve(_pending.size());
+    for (auto&& [recordId, pending] : _pending) {
+        view.inFlight.push_back(recordId);
+    }
+    return view;
+}
+
+ColumnarCollectionCache::State ColumnarCollectionCache::getState() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _state;
+}
+
+ColumnarCollectionCache::Stats ColumnarCollectionCache::getStats() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    Stats stats;
+    stats.pendingWrites = _pending.size();
+    if (_snapshot) {
+        stats.rowGroups = _snapshot->rowGroups.size();
+        for (auto&& rowGroup : _snapshot->rowGroups) {
+            stats.rows += rowGroup->recordIds.size();
+            stats.memUsageBytes += rowGroup->recordIds.capacity() * sizeof(RecordId) +
+                rowGroup->fieldOrder.memUsageBytes();
+            for (auto&& column : rowGroup->columns) {
+                stats.memUsageBytes += column.memUsageBytes();
+            }
+        }
+    }
+    return stats;
+}
+
+void ColumnarCollectionCache::_fold(WithLock) {
+    if (_numSettled == 0) {
+        return;
+    }
+
+    // Take the settled writes out of the pending set, in RecordId order.
+    std::vector<std::pair<RecordId, boost::optional<BSONObj>>> changes;
+    changes.reserve(_numSettled);
+    for (auto it = _pending.begin(); it != _pending.end();) {
+        if (it->second.inFlight == 0) {
+            changes.emplace_back(it->first, std::move(it->second.row));
+            it = _pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    invariant(changes.size() == _numSettled);
+    _numSettled = 0;
+
+    // Each change goes to the last row group which starts at or before its RecordId, or to the
+    // first one. Only the row groups which receive changes are rebuilt, and they may split.
+    const auto& rowGroups = _snapshot->rowGroups;
+    auto next = std::make_shared<ColumnarSnapshot>();
+    auto rebuild = [&](const ColumnarRowGroup* rowGroup, auto first, auto last) {
+        SnapshotBuilder builder(*this);
+        if (rowGroup) {
+            RowReader reader(*this, *rowGroup);
+            for (auto&& recordId : rowGroup->recordIds) {
+                BSONObjBuilder rowBuilder;
+                reader.next(&rowBuilder);
+                for (; first != last && first->first < recordId; ++first) {
+                    if (first->second) {
+                        builder.append(first->first, *first->second);
+                    }
+                }
+                if (first != last && first->first == recordId) {
+                    if (first->second) {
+                        builder.append(recordId, *first->second);
+                    }
+                    ++first;
+                } else {
+                    builder.append(recordId, rowBuilder.obj());
+                }
+            }
+        }
+        for (; first != last; ++first) {
+            if (first->second) {
+                builder.append(first->first, *first->second);
+            }
+        }
+
+        auto rebuilt = builder.done();
+        next->rowGroups.insert(
+            next->rowGroups.end(), rebuilt->rowGroups.begin(), rebuilt->rowGroups.end());
+    };
+
+    auto first = changes.begin();
+    for (size_t idx = 0; idx < rowGroups.size(); ++idx) {
+        auto last = changes.end();
+        if (idx + 1 < rowGroups.size()) {
+            const auto& bound = rowGroups[idx + 1]->recordIds.front();
+            last = std::find_if(
+                first, changes.end(), [&](const auto& change) { return !(change.first < bound); });
+        }
+
+        if (first == last) {
+            next->rowGroups.push_back(rowGroups[idx]);
+        } else {
+            rebuild(rowGroups[idx].get(), first, last);
+            first = last;
+        }
+    }
+    if (rowGroups.empty()) {
+        rebuild(nullptr, changes.begin(), changes.end());
+    }
+
+    _snapshot = std::move(next);
+}
+
+ColumnarCacheRegistry& ColumnarCacheRegistry::get(ServiceContext* serviceContext) {
+    return getColumnarCacheRegistry(serviceContext);
+}
+
+ColumnarCacheRegistry::~ColumnarCacheRegistry() {
+    if (_buildPool) {
+        _buildPool->shutdown();
+        _buildPool->join();
+    }
+}
+
+std::shared_ptr<ColumnarCollectionCache> ColumnarCacheRegistry::lookup(const NamespaceString& nss) {
+    if (!anyCollectionConfigured.load()) {
+        return nullptr;
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _reconcile(lk);
+    auto it = _caches.find(nss.ns());
+    return it == _caches.end() ? nullptr : it->second;
+}
+
+void ColumnarCacheRegistry::_reconcile(WithLock) {
+    if (configGeneration.load() == _configGeneration) {
+        return;
+    }
+
+    stdx::lock_guard<Latch> configLk(configMutex);
+    StringMap<std::shared_ptr<ColumnarCollectionCache>> caches;
+    for (auto&& [ns, fields] : config.collections) {
+        auto it = _caches.find(ns);
+        if (it != _caches.end() && it->second->fields() == fields) {
+            caches.emplace(ns, it->second);
+        } else {
+            caches.emplace(ns,
+                           std::make_shared<ColumnarCollectionCache>(NamespaceString(ns), fields));
+        }
+    }
+    _caches = std::move(caches);
+    _configGeneration = config.generation;
+}
+
+boost::optional<ColumnarCollectionCache::ReadView> ColumnarCacheRegistry::acquireReadView(
+    const std::shared_ptr<ColumnarCollectionCache>& cache, const UUID& collectionUUID) {
+    if (auto view = cache->acquireReadView(collectionUUID)) {
+        return view;
+    }
+
+    if (cache->getState() != ColumnarCollectionCache::State::kUnbuilt) {
+        return boost::none;
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (!_building.insert(cache.get()).second) {
+        return boost::none;
+    }
+
+    if (!_buildPool) {
+        ThreadPool::Options options;
+        options.poolName = "ColumnarCacheBuild";
+        options.minThreads = 0;
+        options.maxThreads = 1;
+        options.onCreateThread = [](const std::string& threadName) {
+            Client::initThread(threadName);
+        };
+        _buildPool = std::make_unique<ThreadPool>(options);
+        _buildPool->startup();
+    }
+
+    _buildPool->schedule([this, cache](Status status) {
+        ON_BLOCK_EXIT([&] {
+            stdx::lock_guard<Latch> lk(_mutex);
+            _building.erase(cache.get());
+        });
+
+        if (status.isOK()) {
+            auto opCtx = cc().makeOperationContext();
+            buildColumnarCache(opCtx.get(), cache.get());
+        }
+    });
+    return boost::none;
+}
+
+void ColumnarCacheRegistry::invalidate(const NamespaceString& nss) {
+    if (auto cache = lookup(nss)) {
+        cache->invalidate();
+    }
+}
+
+void ColumnarCacheRegistry::invalidateDatabase(StringData dbName) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto&& [ns, cache] : _caches) {
+        if (cache->nss().db() == dbName) {
+            cache->invalidate();
+        }
+    }
+}
+
+void ColumnarCacheRegistry::invalidateAll() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto&& [ns, cache] : _caches) {
+        cache->invalidate();
+    }
+}
+
+void buildColumnarCache(OperationContext* opCtx, ColumnarCollectionCache* cache) try {
+    boost::optional<UUID> uuid;
+    {
+        // Writers hold an intent lock on the collection until their writes commit or abort, so
+        // once this lock is granted no untracked write is in flight.
+        AutoGetCollection coll(opCtx,
+                               cache->nss(),
+                               MODE_S,
+                               AutoGetCollectionViewMode::kViewsForbidden,
+                               Date_t::now() + kBuildLockTimeout);
+        if (!coll) {
+            return;
+        }
+        if (coll->isCapped()) {
+            // Capped collections delete their oldest documents without notifying the OpObserver.
+            cache->markUnsupported();
+            return;
+        }
+        if (!cache->startBuild(coll->uuid())) {
+            return;
+        }
+        uuid = coll->uuid();
+    }
+    opCtx->recoveryUnit()->abandonSnapshot();
+
+    // Read the collection in batches, each at a new storage snapshot. A record which changes
+    // after being read has a tracked write, which finishBuild() folds over what was read.
+    ColumnarCollectionCache::SnapshotBuilder builder(*cache);
+    std::unique_ptr<SeekableRecordCursor> cursor;
+    for (bool exhausted = false; !exhausted;) {
+        {
+            AutoGetCollectionForRead coll(opCtx, {cache->nss().db().toString(), *uuid});
+            if (!cursor) {
+                cursor = coll.getCollection()->getCursor(opCtx);
+            } else if (!cursor->restore()) {
+                cache->invalidate();
+                return;
+            }
+
+            for (size_t numRecords = 0; numRecords < kBuildBatchSize; ++numRecords) {
+                auto record = cursor->next();
+                if (!record) {
+                    exhausted = true;
+                    break;
+                }
+                builder.append(record->id, cache->projectRow(record->data.toBson()));
+            }
+
+            if (exhausted) {
+                cursor.reset();
+            } else {
+                cursor->save();
+            }
+        }
+        opCtx->recoveryUnit()->abandonSnapshot();
+        opCtx->checkForInterrupt();
+    }
+
+    cache->finishBuild(builder.done());
+
+    const auto stats = cache->getStats();
+    LOGV2_DEBUG(5150820,
+                1,
+                "Built columnar cache",
+                "namespace"_attr = cache->nss(),
+                "rows"_attr = stats.rows,
+                "rowGroups"_attr = stats.rowGroups,
+                "memUsageBytes"_attr = stats.memUsageBytes);
+} catch (const DBException& ex) {
+    LOGV2_DEBUG(5150821,
+                1,
+                "Failed to build columnar cache",
+                "namespace"_attr = cache->nss(),
+                "error"_attr = ex.toStatus());
+    cache->invalidate();
+}
+
+void ColumnarCacheCollectionsServerParameter::append(OperationContext*,
+                                                     BSONObjBuilder& bob,
+                                                     const std::string& name) {
+    stdx::lock_guard<Latch> lk(configMutex);
+    bob.append(name, config.spec);
+}
+
+Status ColumnarCacheCollectionsServerParameter::set(const BSONElement& value) try {
+    uassert(ErrorCodes::TypeMismatch,
+            str::stream() << name() << " must be an object",
+            value.type() == BSONType::Object);
+    setConfig(value.Obj());
+    return Status::OK();
+} catch (const AssertionException& e) {
+    return e.toStatus();
+}
+
+Status ColumnarCacheCollectionsServerParameter::setFromString(const std::string& str) try {
+    setConfig(fromjson(str));
+    return Status::OK();
+} catch (const AssertionException& e) {
+    return e.toStatus();
+}
+
+}  // namespace mongo
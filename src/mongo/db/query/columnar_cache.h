@@ -0,0 +1,342 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/query/column_segment.h"
+#include "mongo/db/record_id.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/unordered_set.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/string_map.h"
+#include "mongo/util/uuid.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+class OperationContext;
+class ServiceContext;
+class ThreadPool;
+
+/**
+ * Consecutive rows of a columnar cache, stored column by column.
+ */
+struct ColumnarRowGroup {
+    // The RecordIds of the rows, in increasing order.
+    std::vector<RecordId> recordIds;
+
+    // One segment per cached field, in the order of ColumnarCollectionCache::fields().
+    std::vector<ColumnSegment> columns;
+
+    // The order in which the cached fields appear in each row, as BinData holding the index of one
+    // field per byte. Documents of a collection usually share their field order, so this column
+    // is a handful of runs.
+    ColumnSegment fieldOrder;
+};
+
+/**
+ * An immutable version of the contents of a columnar cache. Row groups which are not affected by
+ * a change are shared between versions.
+ */
+struct ColumnarSnapshot {
+    std::vector<std::shared_ptr<const ColumnarRowGroup>> rowGroups;
+};
+
+/**
+ * An in-memory, column oriented copy of a handful of top-level fields of one collection, for
+ * analytic scans which only depend on those fields. A scan served by the cache reads the row
+ * groups of a snapshot and rebuilds, for each row, a document holding the cached fields in their
+ * original order, instead of reading and decoding full documents from the record store.
+ *
+ * The cache is built by a scan of the collection and maintained incrementally from the OpObserver
+ * write path. Every write to a tracked collection registers the RecordId it touches as "in
+ * flight" until its storage transaction commits or aborts; committed writes carry the projection
+ * of the new document (or nothing, for a delete) and are folded into the next snapshot. A reader
+ * takes the latest snapshot together with the RecordIds which still have writes in flight, and
+ * reads those rows from the record store at its own storage snapshot. Writes are ordered by the
+ * sequence number they get when they are observed, so that a commit notification which runs late
+ * can't overwrite a newer version of the same row.
+ */
+class ColumnarCollectionCache {
+    ColumnarCollectionCache(const ColumnarCollectionCache&) = delete;
+    ColumnarCollectionCache& operator=(const ColumnarCollectionCache&) = delete;
+
+public:
+    // The maximum number of rows in a row group built from scratch.
+    static constexpr size_t kRowGroupSize = 4096;
+
+    // The number of committed writes after which a commit notification folds them into a new
+    // snapshot, rather than waiting for the next reader.
+    static constexpr size_t kFoldThreshold = 1024;
+
+    // The maximum number of cached fields of a collection, so that field indexes fit in a byte.
+    static constexpr size_t kMaxFields = 255;
+
+    enum class State {
+        // The cache has no contents and doesn't track writes.
+        kUnbuilt,
+        // A scan is populating the cache. Writes are tracked but not folded.
+        kBuilding,
+        // The cache can serve readers.
+        kBuilt,
+        // The collection can't be cached, e.g. because it is capped.
+        kUnsupported,
+    };
+
+    /**
+     * The rows a reader sees: the cached rows of 'snapshot', except for the rows in 'inFlight',
+     * which must be read from the record store.
+     */
+    struct ReadView {
+        std::shared_ptr<const ColumnarSnapshot> snapshot;
+        std::vector<RecordId> inFlight;
+    };
+
+    struct Stats {
+        size_t rowGroups{0};
+        size_t rows{0};
+        size_t memUsageBytes{0};
+        size_t pendingWrites{0};
+    };
+
+    ColumnarCollectionCache(NamespaceString nss, std::vector<std::string> fields);
+
+    const NamespaceString& nss() const {
+        return _nss;
+    }
+
+    const std::vector<std::string>& fields() const {
+        return _fields;
+    }
+
+    /**
+     * Returns whether the cache holds the top-level field 'fieldName'.
+     */
+    bool hasField(StringData fieldName) const {
+        return _fieldIndexes.find(fieldName) != _fieldIndexes.end();
+    }
+
+    /**
+     * Returns an owned document holding the first occurrence of each cached field of 'doc', in
+     * the order of 'doc'.
+     */
+    BSONObj projectRow(const BSONObj& doc) const;
+
+    /**
+     * Encodes rows given in increasing RecordId order, as projected by projectRow(), into row
+     * groups.
+     */
+    class SnapshotBuilder {
+    public:
+        explicit SnapshotBuilder(const ColumnarCollectionCache& cache);
+
+        void append(const RecordId& recordId, const BSONObj& row);
+
+        std::shared_ptr<const ColumnarSnapshot> done();
+
+    private:
+        void _flush();
+
+        const ColumnarCollectionCache& _cache;
+        std::shared_ptr<ColumnarSnapshot> _snapshot;
+
+        std::vector<RecordId> _recordIds;
+        std::vector<ColumnSegment::Builder> _columns;
+        ColumnSegment::Builder _fieldOrder;
+    };
+
+    /**
+     * Rebuilds the rows of a row group one at a time.
+     */
+    class RowReader {
+    public:
+        RowReader(const ColumnarCollectionCache& cache, const ColumnarRowGroup& rowGroup);
+
+        /**
+         * Appends the next row to 'builder', as a document holding the cached fields the row has.
+         */
+        void next(BSONObjBuilder* builder);
+
+        /**
+         * Moves past the next row without rebuilding it.
+         */
+        void skip();
+
+    private:
+        const ColumnarCollectionCache& _cache;
+        std::vector<ColumnSegment::Cursor> _columns;
+        ColumnSegment::Cursor _fieldOrder;
+        std::vector<BSONElement> _values;
+    };
+
+    /**
+     * Write tracking. beginWrite() is called when a write to 'recordId' is observed, and returns
+     * its sequence number, or boost::none if the cache doesn't track writes at the moment. Exactly
+     * one of commitWrite() or abortWrite() must follow a tracked write. 'row' is the projection of
+     * the new version of the document, or boost::none if the write deleted it.
+     */
+    boost::optional<uint64_t> beginWrite(const RecordId& recordId);
+    void commitWrite(const RecordId& recordId, uint64_t seq, boost::optional<BSONObj> row);
+    void abortWrite(const RecordId& recordId, uint64_t seq);
+
+    /**
+     * Moves an unbuilt cache to the building state, in which writes are tracked. The caller must
+     * hold a lock on the collection which excludes writers, so that no write which started
+     * before tracking is still in flight. Returns false if the cache was not unbuilt.
+     */
+    bool startBuild(const UUID& collectionUUID);
+
+    /**
+     * Installs the contents scanned by a build, which must have started reading after
+     * startBuild(), and folds the writes tracked since then on top of them.
+     */
+    void finishBuild(std::shared_ptr<const ColumnarSnapshot> snapshot);
+
+    /**
+     * Returns the cache to the unbuilt state, dropping its contents and tracked writes.
+     */
+    void invalidate();
+
+    /**
+     * Marks the collection as unsupported until the cache is invalidated.
+     */
+    void markUnsupported();
+
+    /**
+     * Returns the rows visible to a reader of the collection with the given UUID, or boost::none
+     * if the cache is not built for it.
+     */
+    boost::optional<ReadView> acquireReadView(const UUID& collectionUUID);
+
+    State getState() const;
+    Stats getStats() const;
+
+private:
+    struct PendingRow {
+        // The number of writes to the row which neither committed nor aborted yet.
+        int inFlight{0};
+
+        // The sequence number and new contents of the latest committed write, if any.
+        bool committed{false};
+        uint64_t seq{0};
+        boost::optional<BSONObj> row;
+    };
+
+    void _settle(WithLock, std::map<RecordId, PendingRow>::iterator it);
+
+    void _reset(WithLock, State state);
+
+    /**
+     * Builds a new snapshot from the current one and the committed writes with nothing in flight.
+     */
+    void _fold(WithLock);
+
+    const NamespaceString _nss;
+    const std::vector<std::string> _fields;
+    StringMap<size_t> _fieldIndexes;
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("ColumnarCollectionCache::_mutex");
+
+    State _state{State::kUnbuilt};
+    boost::optional<UUID> _uuid;
+    std::shared_ptr<const ColumnarSnapshot> _snapshot;
+
+    std::map<RecordId, PendingRow> _pending;
+    // The number of pending rows with a committed write and no write in flight.
+    size_t _numSettled{0};
+
+    // The sequence number of the next write, and of the first write tracked since the cache was
+    // last reset. Notifications for writes which began before the reset are ignored.
+    uint64_t _nextSeq{1};
+    uint64_t _firstSeq{1};
+};
+
+/**
+ * The columnar caches of the collections listed in the 'columnarCacheCollections' server
+ * parameter. Builds run on a dedicated thread, so that the query which finds a cache unbuilt falls
+ * back to the record store instead of waiting for a full scan.
+ */
+class ColumnarCacheRegistry {
+public:
+    static ColumnarCacheRegistry& get(ServiceContext* serviceContext);
+
+    ~ColumnarCacheRegistry();
+
+    /**
+     * Returns the cache configured for 'nss', or nullptr.
+     */
+    std::shared_ptr<ColumnarCollectionCache> lookup(const NamespaceString& nss);
+
+    /**
+     * Returns the rows of 'cache' visible to a reader of the collection with the given UUID,
+     * scheduling a build if the cache is unbuilt.
+     */
+    boost::optional<ColumnarCollectionCache::ReadView> acquireReadView(
+        const std::shared_ptr<ColumnarCollectionCache>& cache, const UUID& collectionUUID);
+
+    /**
+     * Drops the contents of the caches of 'nss', of the collections of 'dbName', or of all
+     * collections, after DDL or a rollback changed them outside of the observed write path.
+     */
+    void invalidate(const NamespaceString& nss);
+    void invalidateDatabase(StringData dbName);
+    void invalidateAll();
+
+private:
+    /**
+     * Brings the set of caches in line with the server parameter.
+     */
+    void _reconcile(WithLock);
+
+    Mutex _mutex = MONGO_MAKE_LATCH("ColumnarCacheRegistry::_mutex");
+
+    uint64_t _configGeneration{0};
+    StringMap<std::shared_ptr<ColumnarCollectionCache>> _caches;
+
+    // Caches with a build scheduled or running.
+    stdx::unordered_set<ColumnarCollectionCache*> _building;
+    std::unique_ptr<ThreadPool> _buildPool;
+};
+
+/**
+ * Populates 'cache' from its collection. Returns quietly if the collection can't be scanned right
+ * now; the next reader schedules another attempt.
+ */
+void buildColumnarCache(OperationContext* opCtx, ColumnarCollectionCache* cache);
+
+}  // namespace mongo
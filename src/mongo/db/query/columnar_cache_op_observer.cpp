@@ -0,0 +1,179 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/columnar_cache_op_observer.h"
+
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/columnar_cache.h"
+#include "mongo/db/repl/oplog.h"
+#include "mongo/db/storage/recovery_unit.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Reports the outcome of a tracked write to the cache when the storage transaction that made it
+ * commits or aborts. '_row' is the new version of the document, or boost::none for a delete.
+ */
+class TrackedWrite final : public RecoveryUnit::Change {
+public:
+    TrackedWrite(std::shared_ptr<ColumnarCollectionCache> cache,
+                 RecordId recordId,
+                 uint64_t seq,
+                 boost::optional<BSONObj> row)
+        : _cache(std::move(cache)), _recordId(recordId), _seq(seq), _row(std::move(row)) {}
+
+    void commit(boost::optional<Timestamp>) final {
+        _cache->commitWrite(_recordId, _seq, std::move(_row));
+    }
+
+    void rollback() final {
+        _cache->abortWrite(_recordId, _seq);
+    }
+
+private:
+    const std::shared_ptr<ColumnarCollectionCache> _cache;
+    const RecordId _recordId;
+    const uint64_t _seq;
+    boost::optional<BSONObj> _row;
+};
+
+void trackWrite(OperationContext* opCtx,
+                const std::shared_ptr<ColumnarCollectionCache>& cache,
+                const RecordId& recordId,
+                boost::optional<BSONObj> row) {
+    if (auto seq = cache->beginWrite(recordId)) {
+        opCtx->recoveryUnit()->registerChange(
+            std::make_unique<TrackedWrite>(cache, recordId, *seq, std::move(row)));
+    }
+}
+
+/**
+ * Returns the cache of 'nss', or nullptr if it has none. A write whose RecordIds were not published
+ * can't be tracked, so it invalidates the cache instead.
+ */
+std::shared_ptr<ColumnarCollectionCache> getCacheForWrite(OperationContext* opCtx,
+                                                          const NamespaceString& nss,
+                                                          size_t numDocs) {
+    auto cache = ColumnarCacheRegistry::get(opCtx->getServiceContext()).lookup(nss);
+    if (cache && OpObserver::ObservedRecordIds::get(opCtx).ids.size() != numDocs) {
+        cache->invalidate();
+        return nullptr;
+    }
+    return cache;
+}
+
+}  // namespace
+
+void ColumnarCacheOpObserver::onInserts(OperationContext* opCtx,
+                                        const NamespaceString& nss,
+                                        OptionalCollectionUUID uuid,
+                                        std::vector<InsertStatement>::const_iterator first,
+                                        std::vector<InsertStatement>::const_iterator last,
+                                        bool fromMigrate) {
+    auto cache = getCacheForWrite(opCtx, nss, std::distance(first, last));
+    if (!cache) {
+        return;
+    }
+
+    auto recordId = OpObserver::ObservedRecordIds::get(opCtx).ids.begin();
+    for (auto it = first; it != last; ++it, ++recordId) {
+        trackWrite(opCtx, cache, *recordId, cache->projectRow(it->doc));
+    }
+}
+
+void ColumnarCacheOpObserver::onUpdate(OperationContext* opCtx, const OplogUpdateEntryArgs& args) {
+    if (auto cache = getCacheForWrite(opCtx, args.nss, 1)) {
+        trackWrite(opCtx,
+                   cache,
+                   OpObserver::ObservedRecordIds::get(opCtx).ids.front(),
+                   cache->projectRow(args.updateArgs.updatedDoc));
+    }
+}
+
+void ColumnarCacheOpObserver::onDelete(OperationContext* opCtx,
+                                       const NamespaceString& nss,
+                                       OptionalCollectionUUID uuid,
+                                       StmtId stmtId,
+                                       bool fromMigrate,
+                                       const boost::optional<BSONObj>& deletedDoc) {
+    if (auto cache = getCacheForWrite(opCtx, nss, 1)) {
+        const auto& recordId = OpObserver::ObservedRecordIds::get(opCtx).ids.front();
+        trackWrite(opCtx, cache, recordId, boost::none);
+    }
+}
+
+void ColumnarCacheOpObserver::onDropDatabase(OperationContext* opCtx, const std::string& dbName) {
+    ColumnarCacheRegistry::get(opCtx->getServiceContext()).invalidateDatabase(dbName);
+}
+
+repl::OpTime ColumnarCacheOpObserver::onDropCollection(OperationContext* opCtx,
+                                                       const NamespaceString& collectionName,
+                                                       OptionalCollectionUUID uuid,
+                                                       std::uint64_t numRecords,
+                                                       const CollectionDropType dropType) {
+    ColumnarCacheRegistry::get(opCtx->getServiceContext()).invalidate(collectionName);
+    return {};
+}
+
+void ColumnarCacheOpObserver::onRenameCollection(OperationContext* opCtx,
+                                                 const NamespaceString& fromCollection,
+                                                 const NamespaceString& toCollection,
+                                                 OptionalCollectionUUID uuid,
+                                                 OptionalCollectionUUID dropTargetUUID,
+                                                 std::uint64_t numRecords,
+                                                 bool stayTemp) {
+    postRenameCollection(opCtx, fromCollection, toCollection, uuid, dropTargetUUID, stayTemp);
+}
+
+void ColumnarCacheOpObserver::postRenameCollection(OperationContext* opCtx,
+                                                   const NamespaceString& fromCollection,
+                                                   const NamespaceString& toCollection,
+                                                   OptionalCollectionUUID uuid,
+                                                   OptionalCollectionUUID dropTargetUUID,
+                                                   bool stayTemp) {
+    auto& registry = ColumnarCacheRegistry::get(opCtx->getServiceContext());
+    registry.invalidate(fromCollection);
+    registry.invalidate(toCollection);
+}
+
+void ColumnarCacheOpObserver::onEmptyCapped(OperationContext* opCtx,
+                                            const NamespaceString& collectionName,
+                                            OptionalCollectionUUID uuid) {
+    ColumnarCacheRegistry::get(opCtx->getServiceContext()).invalidate(collectionName);
+}
+
+void ColumnarCacheOpObserver::onReplicationRollback(OperationContext* opCtx,
+                                                    const RollbackObserverInfo& rbInfo) {
+    ColumnarCacheRegistry::get(opCtx->getServiceContext()).invalidateAll();
+}
+
+}  // namespace mongo
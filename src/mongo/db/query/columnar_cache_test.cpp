@@ -0,0 +1,313 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/query/columnar_cache.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kNss("test.coll");
+
+std::vector<std::pair<RecordId, BSONObj>> readAll(const ColumnarCollectionCache& cache,
+                                                  const ColumnarSnapshot& snapshot) {
+    std::vector<std::pair<RecordId, BSONObj>> rows;
+    for (auto&& rowGroup : snapshot.rowGroups) {
+        ColumnarCollectionCache::RowReader reader(cache, *rowGroup);
+        for (auto&& recordId : rowGroup->recordIds) {
+            BSONObjBuilder bob;
+            reader.next(&bob);
+            rows.emplace_back(recordId, bob.obj());
+        }
+    }
+    return rows;
+}
+
+/**
+ * Builds 'cache' from 'numRows' rows {a: i, b: "x"} with RecordIds 1 to 'numRows'.
+ */
+void buildCache(ColumnarCollectionCache* cache, const UUID& uuid, size_t numRows) {
+    ASSERT(cache->startBuild(uuid));
+    ColumnarCollectionCache::SnapshotBuilder builder(*cache);
+    for (size_t i = 1; i <= numRows; ++i) {
+        builder.append(RecordId(i), BSON("a" << static_cast<int>(i) << "b"
+                                             << "x"));
+    }
+    cache->finishBuild(builder.done());
+    ASSERT(cache->getState() == ColumnarCollectionCache::State::kBuilt);
+}
+
+void commitWrite(ColumnarCollectionCache* cache,
+                 const RecordId& recordId,
+                 boost::optional<BSONObj> row) {
+    auto seq = cache->beginWrite(recordId);
+    ASSERT(seq);
+    cache->commitWrite(recordId, *seq, std::move(row));
+}
+
+TEST(ColumnarCacheTest, ProjectRowKeepsFirstOccurrenceOfCachedFieldsInDocumentOrder) {
+    ColumnarCollectionCache cache(kNss, {"a", "c"});
+    ASSERT(cache.hasField("a"));
+    ASSERT_FALSE(cache.hasField("b"));
+
+    auto row = cache.projectRow(BSON("c" << 1 << "b" << 2 << "a" << BSON("x" << 3) << "c" << 4));
+    ASSERT_BSONOBJ_BINARY_EQ(row, BSON("c" << 1 << "a" << BSON("x" << 3)));
+    ASSERT_BSONOBJ_BINARY_EQ(cache.projectRow(BSON("b" << 1)), BSONObj());
+}
+
+TEST(ColumnarCacheTest, SnapshotBuilderRoundTripsRows) {
+    ColumnarCollectionCache cache(kNss, {"a", "b"});
+    const size_t numRows = 2 * ColumnarCollectionCache::kRowGroupSize + 5;
+
+    std::vector<BSONObj> expected;
+    ColumnarCollectionCache::SnapshotBuilder builder(cache);
+    for (size_t i = 0; i < numRows; ++i) {
+        BSONObj row;
+        switch (i % 4) {
+            case 0:
+                row = BSON("a" << static_cast<int>(i) << "b"
+                               << "x");
+                break;
+            case 1:
+                row = BSON("b"
+                           << "y"
+                           << "a" << BSON_ARRAY(1 << 2));
+                break;
+            case 2:
+                row = BSON("b" << BSONNULL);
+                break;
+            default:
+                break;
+        }
+        builder.append(RecordId(i + 1), row);
+        expected.push_back(row);
+    }
+    auto snapshot = builder.done();
+    ASSERT_EQ(snapshot->rowGroups.size(), 3U);
+
+    auto rows = readAll(cache, *snapshot);
+    ASSERT_EQ(rows.size(), numRows);
+    for (size_t i = 0; i < numRows; ++i) {
+        ASSERT_EQ(rows[i].first, RecordId(i + 1));
+        ASSERT_BSONOBJ_BINARY_EQ(rows[i].second, expected[i]);
+    }
+}
+
+TEST(ColumnarCacheTest, UnbuiltCacheDoesNotTrackWrites) {
+    ColumnarCollectionCache cache(kNss, {"a"});
+    ASSERT_FALSE(cache.beginWrite(RecordId(1)));
+    ASSERT_FALSE(cache.acquireReadView(UUID::gen()));
+    ASSERT(cache.getState() == ColumnarCollectionCache::State::kUnbuilt);
+}
+
+TEST(ColumnarCacheTest, FoldsCommittedWrites) {
+    ColumnarCollectionCache cache(kNss, {"a", "b"});
+    auto uuid = UUID::gen();
+    buildCache(&cache, uuid, 3);
+
+    commitWrite(&cache, RecordId(2), BSON("a" << 20));
+    commitWrite(&cache, RecordId(4), BSON("b"
+                                          << "y"
+                                          << "a" << 4));
+    commitWrite(&cache, RecordId(1), boost::none);
+
+    auto view = cache.acquireReadView(uuid);
+    ASSERT(view);
+    ASSERT(view->inFlight.empty());
+
+    auto rows = readAll(cache, *view->snapshot);
+    ASSERT_EQ(rows.size(), 3U);
+    ASSERT_EQ(rows[0].first, RecordId(2));
+    ASSERT_BSONOBJ_BINARY_EQ(rows[0].second, BSON("a" << 20));
+    ASSERT_EQ(rows[1].first, RecordId(3));
+    ASSERT_BSONOBJ_BINARY_EQ(rows[1].second,
+                             BSON("a" << 3 << "b"
+                                      << "x"));
+    ASSERT_EQ(rows[2].first, RecordId(4));
+    ASSERT_BSONOBJ_BINARY_EQ(rows[2].second,
+                             BSON("b"
+                                  << "y"
+                                  << "a" << 4));
+    ASSERT_EQ(cache.getStats().pendingWrites, 0U);
+}
+
+TEST(ColumnarCacheTest, ReportsRowsWithWritesInFlight) {
+    ColumnarCollectionCache cache(kNss, {"a"});
+    auto uuid = UUID::gen();
+    buildCache(&cache, uuid, 3);
+
+    auto seq = cache.beginWrite(RecordId(2));
+    ASSERT(seq);
+
+    auto view = cache.acquireReadView(uuid);
+    ASSERT(view);
+    ASSERT_EQ(view->inFlight.size(), 1U);
+    ASSERT_EQ(view->inFlight[0], RecordId(2));
+
+    cache.commitWrite(RecordId(2), *seq, BSON("a" << 20));
+    view = cache.acquireReadView(uuid);
+    ASSERT(view);
+    ASSERT(view->inFlight.empty());
+    ASSERT_BSONOBJ_BINARY_EQ(readAll(cache, *view->snapshot)[1].second, BSON("a" << 20));
+}
+
+TEST(ColumnarCacheTest, LateCommitDoesNotOverwriteNewerWrite) {
+    ColumnarCollectionCache cache(kNss, {"a"});
+    auto uuid = UUID::gen();
+    buildCache(&cache, uuid, 1);
+
+    auto first = cache.beginWrite(RecordId(1));
+    auto second = cache.beginWrite(RecordId(1));
+    ASSERT(first && second);
+    cache.commitWrite(RecordId(1), *second, BSON("a" << 2));
+    cache.commitWrite(RecordId(1), *first, BSON("a" << 1));
+
+    auto view = cache.acquireReadView(uuid);
+    ASSERT(view);
+    ASSERT(view->inFlight.empty());
+    ASSERT_BSONOBJ_BINARY_EQ(readAll(cache, *view->snapshot)[0].second, BSON("a" << 2));
+}
+
+TEST(ColumnarCacheTest, AbortedWriteLeavesRowUnchanged) {
+    ColumnarCollectionCache cache(kNss, {"a"});
+    auto uuid = UUID::gen();
+    buildCache(&cache, uuid, 1);
+
+    auto seq = cache.beginWrite(RecordId(1));
+    ASSERT(seq);
+    cache.abortWrite(RecordId(1), *seq);
+    ASSERT_EQ(cache.getStats().pendingWrites, 0U);
+
+    auto view = cache.acquireReadView(uuid);
+    ASSERT(view);
+    ASSERT(view->inFlight.empty());
+    ASSERT_BSONOBJ_BINARY_EQ(readAll(cache, *view->snapshot)[0].second, BSON("a" << 1));
+}
+
+TEST(ColumnarCacheTest, FoldsWritesTrackedDuringBuildOverScannedRows) {
+    ColumnarCollectionCache cache(kNss, {"a"});
+    auto uuid = UUID::gen();
+    ASSERT(cache.startBuild(uuid));
+    ASSERT(cache.getState() == ColumnarCollectionCache::State::kBuilding);
+    ASSERT_FALSE(cache.acquireReadView(uuid));
+
+    // The scan read the old version of RecordId 1 and missed the insert of RecordId 3.
+    ColumnarCollectionCache::SnapshotBuilder builder(cache);
+    builder.append(RecordId(1), BSON("a" << 1));
+    builder.append(RecordId(2), BSON("a" << 2));
+    commitWrite(&cache, RecordId(1), BSON("a" << 10));
+    commitWrite(&cache, RecordId(3), BSON("a" << 3));
+    cache.finishBuild(builder.done());
+
+    auto view = cache.acquireReadView(uuid);
+    ASSERT(view);
+    auto rows = readAll(cache, *view->snapshot);
+    ASSERT_EQ(rows.size(), 3U);
+    ASSERT_BSONOBJ_BINARY_EQ(rows[0].second, BSON("a" << 10));
+    ASSERT_BSONOBJ_BINARY_EQ(rows[1].second, BSON("a" << 2));
+    ASSERT_EQ(rows[2].first, RecordId(3));
+    ASSERT_BSONOBJ_BINARY_EQ(rows[2].second, BSON("a" << 3));
+}
+
+TEST(ColumnarCacheTest, IgnoresWritesWhichBeganBeforeInvalidation) {
+    ColumnarCollectionCache cache(kNss, {"a"});
+    auto uuid = UUID::gen();
+    buildCache(&cache, uuid, 1);
+
+    auto seq = cache.beginWrite(RecordId(1));
+    ASSERT(seq);
+    cache.invalidate();
+    ASSERT(cache.getState() == ColumnarCollectionCache::State::kUnbuilt);
+
+    buildCache(&cache, uuid, 1);
+    cache.commitWrite(RecordId(1), *seq, BSON("a" << 10));
+    ASSERT_EQ(cache.getStats().pendingWrites, 0U);
+
+    auto view = cache.acquireReadView(uuid);
+    ASSERT(view);
+    ASSERT_BSONOBJ_BINARY_EQ(readAll(cache, *view->snapshot)[0].second, BSON("a" << 1));
+}
+
+TEST(ColumnarCacheTest, FinishBuildAfterInvalidationIsIgnored) {
+    ColumnarCollectionCache cache(kNss, {"a"});
+    auto uuid = UUID::gen();
+    ASSERT(cache.startBuild(uuid));
+    ColumnarCollectionCache::SnapshotBuilder builder(cache);
+    builder.append(RecordId(1), BSON("a" << 1));
+    cache.invalidate();
+    cache.finishBuild(builder.done());
+    ASSERT(cache.getState() == ColumnarCollectionCache::State::kUnbuilt);
+}
+
+TEST(ColumnarCacheTest, UUIDMismatchResetsCache) {
+    ColumnarCollectionCache cache(kNss, {"a"});
+    buildCache(&cache, UUID::gen(), 1);
+
+    ASSERT_FALSE(cache.acquireReadView(UUID::gen()));
+    ASSERT(cache.getState() == ColumnarCollectionCache::State::kUnbuilt);
+}
+
+TEST(ColumnarCacheTest, UnsupportedCacheDoesNotBuild) {
+    ColumnarCollectionCache cache(kNss, {"a"});
+    cache.markUnsupported();
+    ASSERT_FALSE(cache.startBuild(UUID::gen()));
+    ASSERT_FALSE(cache.beginWrite(RecordId(1)));
+
+    cache.invalidate();
+    ASSERT(cache.getState() == ColumnarCollectionCache::State::kUnbuilt);
+}
+
+TEST(ColumnarCacheTest, FoldSharesUnaffectedRowGroups) {
+    ColumnarCollectionCache cache(kNss, {"a", "b"});
+    auto uuid = UUID::gen();
+    buildCache(&cache, uuid, 3 * ColumnarCollectionCache::kRowGroupSize);
+
+    auto before = cache.acquireReadView(uuid);
+    ASSERT(before);
+    ASSERT_EQ(before->snapshot->rowGroups.size(), 3U);
+
+    commitWrite(&cache, RecordId(ColumnarCollectionCache::kRowGroupSize + 1), BSON("a" << -1));
+    auto after = cache.acquireReadView(uuid);
+    ASSERT(after);
+    ASSERT_EQ(after->snapshot->rowGroups.size(), 3U);
+    ASSERT_EQ(after->snapshot->rowGroups[0], before->snapshot->rowGroups[0]);
+    ASSERT_NE(after->snapshot->rowGroups[1], before->snapshot->rowGroups[1]);
+    ASSERT_EQ(after->snapshot->rowGroups[2], before->snapshot->rowGroups[2]);
+
+    auto rows = readAll(cache, *after->snapshot);
+    ASSERT_EQ(rows.size(), 3 * ColumnarCollectionCache::kRowGroupSize);
+    ASSERT_BSONOBJ_BINARY_EQ(rows[ColumnarCollectionCache::kRowGroupSize].second,
+                             BSON("a" << -1));
+}
+
+}  // namespace
+}  // namespace mongo
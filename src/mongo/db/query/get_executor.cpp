@@ -61,6 +61,8 @@
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index/wildcard_access_method.h"
 #include "mongo/db/index_names.h"
+#include "mongo/db/matcher/expression_algo.h"
+#include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/matcher/extensions_callback_noop.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/query/canonical_query.h"
@@ -77,6 +79,7 @@
 #include "mongo/db/query/planner_ixselect.h"
 #include "mongo/db/query/planner_wildcard_helpers.h"
 #include "mongo/db/query/projection_parser.h"
+#include "mongo/db/query/query_arena.h"
 #include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_common.h"
@@ -84,6 +87,7 @@
 #include "mongo/db/query/query_settings_decoration.h"
 #include "mongo/db/query/sbe_cached_solution_planner.h"
 #include "mongo/db/query/sbe_multi_planner.h"
+#include "mongo/db/query/sbe_plan_cache.h"
 #include "mongo/db/query/sbe_sub_planner.h"
 #include "mongo/db/query/stage_builder_util.h"
 #include "mongo/db/query/util/make_data_structure.h"
@@ -98,6 +102,7 @@
 #include "mongo/logv2/log.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/str.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -540,6 +545,10 @@ public:
             return buildEofPlan();
         }
 
+        // The solutions built below go into the arena of the query, which they keep alive for as
+        // long as a cached or executing plan refers to them.
+        QueryArenaScope arenaScope(_cq->getArena());
+
         // Fill out the planning params.  We use these for both cached solutions and non-cached.
         QueryPlannerParams plannerParams;
         plannerParams.options = _plannerOptions;
@@ -962,6 +971,9 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getClassicExecu
     std::unique_ptr<CanonicalQuery> canonicalQuery,
     PlanYieldPolicy::YieldPolicy yieldPolicy,
     size_t plannerOptions) {
+    // The classic engine cannot run a $group which was pushed down into the query.
+    invariant(!canonicalQuery->getPushedDownGroup());
+
     auto ws = std::make_unique<WorkingSet>();
     ClassicPrepareExecutionHelper helper{
         opCtx, collection, ws.get(), canonicalQuery.get(), nullptr, plannerOptions};
@@ -1053,6 +1065,112 @@ std::unique_ptr<PlanYieldPolicySBE> makeSbeYieldPolicy(
                                                 std::move(whileYieldingFn));
 }
 
+/**
+ * Checks if the SBE plan tree for 'cq' may be looked up in, and added to, the SBE plan cache. A
+ * cached tree must not depend on anything about the query beyond its shape and the values returned
+ * by 'makeSbePlanCacheLiterals()'.
+ */
+bool isEligibleForSbePlanCache(const CollectionPtr& collection,
+                               const CanonicalQuery& cq,
+                               size_t plannerOptions) {
+    if (!internalQueryEnableSBEPlanCache.load() || !collection) {
+        return false;
+    }
+
+    // Scans of the oplog wait for oplog visibility, and shard filtering depends on the ownership
+    // metadata of the operation.
+    if (collection->ns().isOplog() || (plannerOptions & QueryPlannerParams::INCLUDE_SHARD_FILTER)) {
+        return false;
+    }
+
+    if (cq.getCollator() || collection->getDefaultCollator() || cq.getPushedDownGroup() ||
+        cq.getQueryRequest().getLetParameters()) {
+        return false;
+    }
+
+    // Agg expressions may have had variables such as $$NOW folded into constants, which the
+    // literal values of the query do not capture.
+    if (QueryPlannerCommon::hasNode(cq.root(), MatchExpression::EXPRESSION) ||
+        QueryPlannerCommon::hasNode(cq.root(), MatchExpression::TEXT) ||
+        (cq.getProj() && !cq.getProj()->isSimple())) {
+        return false;
+    }
+
+    return PlanCache::shouldCacheQuery(cq);
+}
+
+/**
+ * Appends the options of 'cq' which, together with its filter and shape, determine the SBE plan
+ * tree built for 'cq'.
+ */
+void appendSbePlanCacheOptions(const CanonicalQuery& cq,
+                               size_t plannerOptions,
+                               BSONObjBuilder* bob) {
+    const auto& qr = cq.getQueryRequest();
+    bob->append("sort", qr.getSort());
+    bob->append("projection", qr.getProj());
+    if (auto skip = qr.getSkip()) {
+        bob->append("skip", *skip);
+    }
+    if (auto limit = qr.getLimit()) {
+        bob->append("limit", *limit);
+    }
+    if (auto ntoreturn = qr.getNToReturn()) {
+        bob->append("ntoreturn", *ntoreturn);
+    }
+    bob->append("wantMore", qr.wantMore());
+    bob->append("returnKey", qr.returnKey());
+    bob->append("allowDiskUse", cq.getExpCtx()->allowDiskUse);
+    bob->append("metadataDeps", cq.metadataDeps().to_string());
+    bob->append("plannerOptions", static_cast<long long>(plannerOptions));
+}
+
+/**
+ * Returns the values which, together with the query shape, determine the SBE plan tree built for
+ * 'cq'.
+ */
+BSONObj makeSbePlanCacheLiterals(const CanonicalQuery& cq, size_t plannerOptions) {
+    BSONObjBuilder bob;
+    bob.append("query", cq.getQueryRequest().getFilter());
+    appendSbePlanCacheOptions(cq, plannerOptions, &bob);
+    return bob.obj();
+}
+
+/**
+ * Returns the values which, together with the query shape, determine the SBE plan tree built for
+ * 'cq' once the tree reads the constants of the input parameters of 'cq' from its inputs. These
+ * are the literals of the query, less the constants of the input parameters, of which only the
+ * types are kept, as they may affect the choice of indexes. Returns boost::none if 'cq' has no
+ * input parameters, or if the collection has partial indexes, which are only used for a query if
+ * its constants fall within the filter of the index.
+ */
+boost::optional<BSONObj> makeSbePlanCacheParameterizedLiterals(OperationContext* opCtx,
+                                                               const CollectionPtr& collection,
+                                                               const CanonicalQuery& cq,
+                                                               size_t plannerOptions) {
+    auto inputParams = expression::getInputParams(cq.root());
+    if (inputParams.empty()) {
+        return boost::none;
+    }
+
+    auto ii = collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+    while (ii->more()) {
+        if (ii->next()->descriptor()->isPartial()) {
+            return boost::none;
+        }
+    }
+
+    BSONObjBuilder bob;
+    bob.append("parameterizedQuery", expression::serializeWithoutInputParams(cq.root()));
+    BSONArrayBuilder typesBuilder(bob.subarrayStart("inputParamTypes"));
+    for (auto&& inputParam : inputParams) {
+        typesBuilder.append(inputParam.canonicalType());
+    }
+    typesBuilder.doneFast();
+    appendSbePlanCacheOptions(cq, plannerOptions, &bob);
+    return bob.obj();
+}
+
 StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getSlotBasedExecutor(
     OperationContext* opCtx,
     const CollectionPtr& collection,
@@ -1062,6 +1180,57 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getSlotBasedExe
     invariant(cq);
     auto nss = cq->nss();
     auto yieldPolicy = makeSbeYieldPolicy(opCtx, requestedYieldPolicy, nss);
+
+    // The epoch is read before planning, so that a tree planned while the query plan cache is
+    // being invalidated is cached as stale.
+    //
+    // A tree which reads the constants of all the input parameters of the query from its inputs
+    // is cached under a key without these constants, and is rebound to the constants of the query
+    // on a hit. Other trees are cached under a key with all the literals of the query.
+    boost::optional<sbe::PlanCache::Key> sbePlanCacheKey;
+    boost::optional<sbe::PlanCache::Key> sbeParameterizedPlanCacheKey;
+    uint64_t planCacheEpoch = 0;
+    if (isEligibleForSbePlanCache(collection, *cq, plannerOptions)) {
+        auto planCache = CollectionQueryInfo::get(collection).getPlanCache();
+        planCacheEpoch = planCache->epoch();
+        auto planCacheKey = planCache->computeKey(*cq);
+        if (auto literals =
+                makeSbePlanCacheParameterizedLiterals(opCtx, collection, *cq, plannerOptions)) {
+            sbeParameterizedPlanCacheKey.emplace(planCacheKey, std::move(*literals));
+        }
+        sbePlanCacheKey.emplace(std::move(planCacheKey),
+                                makeSbePlanCacheLiterals(*cq, plannerOptions));
+
+        auto& sbePlanCache = sbe::PlanCache::get(collection);
+        boost::optional<sbe::PlanCache::PlanTree> tree;
+        if (sbeParameterizedPlanCacheKey) {
+            tree = sbePlanCache.getPlan(
+                *sbeParameterizedPlanCacheKey, planCacheEpoch, yieldPolicy.get());
+            if (tree) {
+                stage_builder::bindInputParams(*cq, &tree->second);
+            }
+        }
+        if (!tree) {
+            tree = sbePlanCache.getPlan(*sbePlanCacheKey, planCacheEpoch, yieldPolicy.get());
+        }
+
+        if (tree) {
+            const auto& planCacheKey = sbePlanCacheKey->shapeKey();
+            CurOp::get(opCtx)->debug().queryHash =
+                canonical_query_encoder::computeHash(planCacheKey.getStableKeyStringData());
+            CurOp::get(opCtx)->debug().planCacheKey =
+                canonical_query_encoder::computeHash(planCacheKey.toString());
+
+            return plan_executor_factory::make(opCtx,
+                                               std::move(cq),
+                                               std::move(*tree),
+                                               collection,
+                                               std::move(nss),
+                                               std::move(yieldPolicy));
+        }
+    }
+
+    Timer buildTimer;
     SlotBasedPrepareExecutionHelper helper{
         opCtx, collection, cq.get(), yieldPolicy.get(), plannerOptions};
     auto executionResult = helper.prepare();
@@ -1093,6 +1262,13 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getSlotBasedExe
     }
     // No need for runtime planning, just use the constructed plan stage tree.
     invariant(roots.size() == 1);
+    if (sbePlanCacheKey) {
+        const auto& key = sbeParameterizedPlanCacheKey && roots[0].second.inputParamsAreBound
+            ? *sbeParameterizedPlanCacheKey
+            : *sbePlanCacheKey;
+        sbe::PlanCache::get(collection).setPlan(
+            key, planCacheEpoch, roots[0], Microseconds{buildTimer.micros()});
+    }
     return plan_executor_factory::make(opCtx,
                                        std::move(cq),
                                        std::move(roots[0]),
@@ -1108,7 +1284,12 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutor(
     std::unique_ptr<CanonicalQuery> canonicalQuery,
     PlanYieldPolicy::YieldPolicy yieldPolicy,
     size_t plannerOptions) {
-    return internalQueryEnableSlotBasedExecutionEngine.load()
+    // A $group is only pushed down into a query when the slot-based engine is enabled, and it is
+    // removed from the pipeline. Such a query is run by the slot-based engine even if the engine
+    // was disabled in the meantime, so that the $group is not lost.
+    const bool useSbe = canonicalQuery->getPushedDownGroup() ||
+        internalQueryEnableSlotBasedExecutionEngine.load();
+    return useSbe
         ? getSlotBasedExecutor(
               opCtx, collection, std::move(canonicalQuery), yieldPolicy, plannerOptions)
         : getClassicExecutor(
@@ -1328,8 +1509,9 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDele
     }
 
     // The underlying query plan must preserve the record id, since it will be needed in order to
-    // identify the record to update.
-    const size_t defaultPlannerOptions = QueryPlannerParams::PRESERVE_RECORD_ID;
+    // identify the record to update. It feeds a stage which writes each document it returns.
+    const size_t defaultPlannerOptions =
+        QueryPlannerParams::PRESERVE_RECORD_ID | QueryPlannerParams::IS_WRITE;
 
     ClassicPrepareExecutionHelper helper{
         opCtx, collection, ws.get(), cq.get(), nullptr, defaultPlannerOptions};
@@ -1489,8 +1671,9 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorUpda
     }
 
     // The underlying query plan must preserve the record id, since it will be needed in order to
-    // identify the record to update.
-    const size_t defaultPlannerOptions = QueryPlannerParams::PRESERVE_RECORD_ID;
+    // identify the record to update. It feeds a stage which writes each document it returns.
+    const size_t defaultPlannerOptions =
+        QueryPlannerParams::PRESERVE_RECORD_ID | QueryPlannerParams::IS_WRITE;
 
     ClassicPrepareExecutionHelper helper{
         opCtx, collection, ws.get(), cq.get(), nullptr, defaultPlannerOptions};
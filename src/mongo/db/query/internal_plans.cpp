@@ -92,7 +92,7 @@ std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> InternalPlanner::deleteWith
     auto expCtx = make_intrusive<ExpressionContext>(
         opCtx, std::unique_ptr<CollatorInterface>(nullptr), collection->ns());
 
-    auto root = _collectionScan(expCtx, ws.get(), collection, direction);
+    auto root = _collectionScan(expCtx, ws.get(), collection, direction, boost::none, true);
 
     root = std::make_unique<DeleteStage>(
         expCtx.get(), std::move(params), ws.get(), collection, root.release());
@@ -203,13 +203,15 @@ std::unique_ptr<PlanStage> InternalPlanner::_collectionScan(
     WorkingSet* ws,
     const CollectionPtr& collection,
     Direction direction,
-    boost::optional<RecordId> resumeAfterRecordId) {
+    boost::optional<RecordId> resumeAfterRecordId,
+    bool feedsWriteStage) {
     invariant(collection);
 
     CollectionScanParams params;
     params.shouldWaitForOplogVisibility =
         shouldWaitForOplogVisibility(expCtx->opCtx, collection, false);
     params.resumeAfterRecordId = resumeAfterRecordId;
+    params.feedsWriteStage = feedsWriteStage;
 
     if (FORWARD == direction) {
         params.direction = CollectionScanParams::FORWARD;
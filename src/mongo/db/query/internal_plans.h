@@ -131,14 +131,16 @@ private:
     /**
      * Returns a plan stage that can be used for a collection scan.
      *
-     * Used as a helper for collectionScan() and deleteWithCollectionScan().
+     * Used as a helper for collectionScan() and deleteWithCollectionScan(), which sets
+     * 'feedsWriteStage'.
      */
     static std::unique_ptr<PlanStage> _collectionScan(
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         WorkingSet* ws,
         const CollectionPtr& collection,
         Direction direction,
-        boost::optional<RecordId> resumeAfterRecordId = boost::none);
+        boost::optional<RecordId> resumeAfterRecordId = boost::none,
+        bool feedsWriteStage = false);
 
     /**
      * Returns a plan stage that is either an index scan or an index scan with a fetch stage.
@@ -52,6 +52,7 @@
 #include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/logv2/log.h"
+#include "mongo/platform/random.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/hex.h"
 #include "mongo/util/transitional_tools_do_not_use/vector_spooling.h"
@@ -63,6 +64,9 @@ namespace {
 ServerStatusMetricField<Counter64> totalPlanCacheSizeEstimateBytesMetric(
     "query.planCacheTotalSizeEstimateBytes", &PlanCacheEntry::planCacheTotalSizeEstimateBytes);
 
+// Picks where eviction starts sampling within a partition.
+thread_local PseudoRandom evictionRandom(SecureRandom().nextInt64());
+
 // Delimiters for cache key encoding.
 const char kEncodeDiscriminatorsBegin = '<';
 const char kEncodeDiscriminatorsEnd = '>';
@@ -168,30 +172,16 @@ bool PlanCache::shouldCacheQuery(const CanonicalQuery& query) {
 // CachedSolution
 //
 
-CachedSolution::CachedSolution(const PlanCacheKey& key, const PlanCacheEntry& entry)
-    : plannerData(entry.plannerData.size()),
+CachedSolution::CachedSolution(const PlanCacheKey& key,
+                               std::shared_ptr<const PlanCacheEntry> entry)
+    : _entry(std::move(entry)),
+      plannerData(_entry->plannerData),
       key(key),
-      query(entry.query.getOwned()),
-      sort(entry.sort.getOwned()),
-      projection(entry.projection.getOwned()),
-      collation(entry.collation.getOwned()),
-      decisionWorks(entry.works) {
-    // CachedSolution should not having any references into
-    // cache entry. All relevant data should be cloned/copied.
-    for (size_t i = 0; i < entry.plannerData.size(); ++i) {
-        verify(entry.plannerData[i]);
-        plannerData[i] = entry.plannerData[i]->clone();
-    }
-}
-
-CachedSolution::~CachedSolution() {
-    for (std::vector<SolutionCacheData*>::const_iterator i = plannerData.begin();
-         i != plannerData.end();
-         ++i) {
-        SolutionCacheData* scd = *i;
-        delete scd;
-    }
-}
+      query(_entry->query.getOwned()),
+      sort(_entry->sort.getOwned()),
+      projection(_entry->projection.getOwned()),
+      collation(_entry->collation.getOwned()),
+      decisionWorks(_entry->works) {}
 
 //
 // PlanCacheEntry
@@ -425,11 +415,160 @@ std::string SolutionCacheData::toString() const {
 
 PlanCache::PlanCache() : PlanCache(internalQueryCacheSize.load()) {}
 
-PlanCache::PlanCache(size_t size) : _cache(size) {}
+PlanCache::PlanCache(size_t size) : _maxSize(size) {}
 
 PlanCache::~PlanCache() {}
 
-std::unique_ptr<CachedSolution> PlanCache::getCacheEntryIfActive(const PlanCacheKey& key) const {
+PlanCache::Partition& PlanCache::_partitionFor(const PlanCacheKey& key) const {
+    return _partitions[key.hash() % kNumPartitions];
+}
+
+std::shared_ptr<const PlanCache::Bucket>& PlanCache::_bucketFor(const PlanCacheKey& key,
+                                                                 Table& table) {
+    // The low bits of the hash already picked the partition.
+    return table.buckets[(key.hash() / kNumPartitions) % table.buckets.size()];
+}
+
+std::shared_ptr<const PlanCache::Slot> PlanCache::_lookup(const PlanCacheKey& key) const {
+    auto table = atomic_load(&_partitionFor(key).table);
+    auto bucket = atomic_load(&_bucketFor(key, *table));
+    if (!bucket) {
+        return nullptr;
+    }
+
+    for (auto&& slot : *bucket) {
+        if (slot->key == key) {
+            slot->lastUsed.store(_useClock.addAndFetch(1));
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const PlanCache::Slot> PlanCache::_makeSlot(
+    const PlanCacheKey& key, std::unique_ptr<const PlanCacheEntry> entry) const {
+    auto slot = std::make_shared<Slot>(key);
+    slot->entry = std::move(entry);
+    slot->cachedSolution = std::make_shared<const CachedSolution>(key, slot->entry);
+    slot->lastUsed.store(_useClock.addAndFetch(1));
+    return slot;
+}
+
+std::shared_ptr<const PlanCache::Slot> PlanCache::_store(WithLock,
+                                                         Partition* partition,
+                                                         const PlanCacheKey& key,
+                                                         std::shared_ptr<const Slot> slot) {
+    auto& bucket = _bucketFor(key, *partition->table);
+    auto newBucket = std::make_shared<Bucket>();
+    std::shared_ptr<const Slot> oldSlot;
+    if (bucket) {
+        newBucket->reserve(bucket->size() + 1);
+        for (auto&& bucketSlot : *bucket) {
+            if (bucketSlot->key == key) {
+                oldSlot = bucketSlot;
+            } else {
+                newBucket->push_back(bucketSlot);
+            }
+        }
+    }
+
+    const bool storesSlot = !!slot;
+    if (slot) {
+        newBucket->push_back(std::move(slot));
+    }
+    atomic_store(&bucket,
+                 newBucket->empty() ? nullptr
+                                    : std::shared_ptr<const Bucket>(std::move(newBucket)));
+
+    if (oldSlot && !storesSlot) {
+        --partition->size;
+        _size.subtractAndFetch(1);
+    } else if (!oldSlot && storesSlot) {
+        ++partition->size;
+        _size.addAndFetch(1);
+    }
+
+    const auto& table = *partition->table;
+    if (partition->size > table.buckets.size() * kMaxSlotsPerBucket) {
+        // Rehash into twice as many buckets. Readers keep using the old table until the new one
+        // is published, and no writer can change the old one meanwhile.
+        std::vector<Bucket> buckets(table.buckets.size() * 2);
+        for (auto&& oldBucket : table.buckets) {
+            if (!oldBucket) {
+                continue;
+            }
+            for (auto&& bucketSlot : *oldBucket) {
+                buckets[(bucketSlot->key.hash() / kNumPartitions) % buckets.size()].push_back(
+                    bucketSlot);
+            }
+        }
+
+        auto newTable = std::make_shared<Table>(buckets.size());
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            if (!buckets[i].empty()) {
+                newTable->buckets[i] = std::make_shared<const Bucket>(std::move(buckets[i]));
+            }
+        }
+        atomic_store(&partition->table, std::move(newTable));
+    }
+
+    return oldSlot;
+}
+
+void PlanCache::_evictIfFull(const NamespaceString& nss) {
+    while (_size.load() > _maxSize) {
+        // Pick the least recently used of up to 'kEvictionSampleSize' entries, visiting the
+        // partitions in turn from a different one each time. Within a partition the sample starts
+        // at a random bucket, so that the entries of the first buckets are not always the ones
+        // considered. The sample is taken from the published tables, without any lock.
+        std::shared_ptr<const Slot> victim;
+        size_t victimPartition = 0;
+        size_t sampled = 0;
+        const size_t firstPartition = _evictionCursor.fetchAndAdd(1);
+        for (size_t i = 0; i < kNumPartitions && sampled < kEvictionSampleSize; ++i) {
+            const size_t partitionId = (firstPartition + i) % kNumPartitions;
+            auto table = atomic_load(&_partitions[partitionId].table);
+            const auto numBuckets = table->buckets.size();
+            const size_t firstBucket = evictionRandom.nextInt64(numBuckets);
+            for (size_t j = 0; j < numBuckets && sampled < kEvictionSampleSize; ++j) {
+                auto bucket = atomic_load(&table->buckets[(firstBucket + j) % numBuckets]);
+                if (!bucket) {
+                    continue;
+                }
+
+                for (auto&& slot : *bucket) {
+                    if (!victim || slot->lastUsed.load() < victim->lastUsed.load()) {
+                        victim = slot;
+                        victimPartition = partitionId;
+                    }
+                    ++sampled;
+                }
+            }
+        }
+
+        if (!victim) {
+            return;
+        }
+
+        // Evict the victim unless a concurrent writer has replaced or removed it meanwhile.
+        Partition& partition = _partitions[victimPartition];
+        stdx::lock_guard<Latch> lk(partition.mutex);
+        const auto& bucket = _bucketFor(victim->key, *partition.table);
+        if (!bucket || std::find(bucket->begin(), bucket->end(), victim) == bucket->end()) {
+            continue;
+        }
+        _store(lk, &partition, victim->key, nullptr);
+
+        LOGV2_DEBUG(20942,
+                    1,
+                    "Plan cache maximum size exceeded - removed least recently used entry",
+                    "namespace"_attr = nss,
+                    "evictedEntry"_attr = redact(victim->entry->toString()));
+    }
+}
+
+std::shared_ptr<const CachedSolution> PlanCache::getCacheEntryIfActive(
+    const PlanCacheKey& key) const {
 
     PlanCache::GetResult res = get(key);
     if (res.state == PlanCache::CacheEntryState::kPresentInactive) {
@@ -452,7 +591,7 @@ std::unique_ptr<CachedSolution> PlanCache::getCacheEntryIfActive(const PlanCache
 PlanCache::NewEntryState PlanCache::getNewEntryState(const CanonicalQuery& query,
                                                      uint32_t queryHash,
                                                      uint32_t planCacheKey,
-                                                     PlanCacheEntry* oldEntry,
+                                                     const PlanCacheEntry* oldEntry,
                                                      size_t newWorks,
                                                      double growthCoefficient) {
     NewEntryState res;
@@ -516,7 +655,7 @@ PlanCache::NewEntryState PlanCache::getNewEntryState(const CanonicalQuery& query
                     "planCacheKey"_attr = zeroPaddedHex(planCacheKey),
                     "oldWorks"_attr = oldEntry->works,
                     "increasedWorks"_attr = increasedWorks);
-        oldEntry->works = increasedWorks;
+        res.increasedWorks = increasedWorks;
 
         // Don't create a new entry.
         res.shouldBeCreated = false;
@@ -577,54 +716,60 @@ Status PlanCache::set(const CanonicalQuery& query,
                                  }},
         why->stats);
     const auto key = computeKey(query);
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    bool isNewEntryActive = false;
-    uint32_t queryHash;
-    uint32_t planCacheKey;
-    if (internalQueryCacheDisableInactiveEntries.load()) {
-        // All entries are always active.
-        isNewEntryActive = true;
-        planCacheKey = canonical_query_encoder::computeHash(key.stringData());
-        queryHash = canonical_query_encoder::computeHash(key.getStableKeyStringData());
-    } else {
-        PlanCacheEntry* oldEntry = nullptr;
-        Status cacheStatus = _cache.get(key, &oldEntry);
-        invariant(cacheStatus.isOK() || cacheStatus == ErrorCodes::NoSuchKey);
-        if (oldEntry) {
-            queryHash = oldEntry->queryHash;
-            planCacheKey = oldEntry->planCacheKey;
-        } else {
+    {
+        Partition& partition = _partitionFor(key);
+        stdx::lock_guard<Latch> partitionLock(partition.mutex);
+        bool isNewEntryActive = false;
+        uint32_t queryHash;
+        uint32_t planCacheKey;
+        if (internalQueryCacheDisableInactiveEntries.load()) {
+            // All entries are always active.
+            isNewEntryActive = true;
             planCacheKey = canonical_query_encoder::computeHash(key.stringData());
             queryHash = canonical_query_encoder::computeHash(key.getStableKeyStringData());
-        }
+        } else {
+            auto oldSlot = _lookup(key);
+            const PlanCacheEntry* oldEntry = oldSlot ? oldSlot->entry.get() : nullptr;
+            if (oldEntry) {
+                queryHash = oldEntry->queryHash;
+                planCacheKey = oldEntry->planCacheKey;
+            } else {
+                planCacheKey = canonical_query_encoder::computeHash(key.stringData());
+                queryHash = canonical_query_encoder::computeHash(key.getStableKeyStringData());
+            }
 
-        const auto newState = getNewEntryState(
-            query,
-            queryHash,
-            planCacheKey,
-            oldEntry,
-            newWorks,
-            worksGrowthCoefficient.get_value_or(internalQueryCacheWorksGrowthCoefficient));
+            const auto newState = getNewEntryState(
+                query,
+                queryHash,
+                planCacheKey,
+                oldEntry,
+                newWorks,
+                worksGrowthCoefficient.get_value_or(internalQueryCacheWorksGrowthCoefficient));
+
+            if (newState.increasedWorks) {
+                auto updatedEntry = oldEntry->clone();
+                updatedEntry->works = *newState.increasedWorks;
+                _store(partitionLock, &partition, key, _makeSlot(key, std::move(updatedEntry)));
+            }
 
-        if (!newState.shouldBeCreated) {
-            return Status::OK();
+            if (!newState.shouldBeCreated) {
+                return Status::OK();
+            }
+            isNewEntryActive = newState.shouldBeActive;
         }
-        isNewEntryActive = newState.shouldBeActive;
-    }
-
-    auto newEntry(PlanCacheEntry::create(
-        solns, std::move(why), query, queryHash, planCacheKey, now, isNewEntryActive, newWorks));
-
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(key, newEntry.release());
 
-    if (nullptr != evictedEntry.get()) {
-        LOGV2_DEBUG(20942,
-                    1,
-                    "Plan cache maximum size exceeded - removed least recently used entry",
-                    "namespace"_attr = query.nss(),
-                    "evictedEntry"_attr = redact(evictedEntry->toString()));
+        auto newEntry(PlanCacheEntry::create(solns,
+                                             std::move(why),
+                                             query,
+                                             queryHash,
+                                             planCacheKey,
+                                             now,
+                                             isNewEntryActive,
+                                             newWorks));
+        _store(partitionLock, &partition, key, _makeSlot(key, std::move(newEntry)));
     }
 
+    _evictIfFull(query.nss());
     return Status::OK();
 }
 
@@ -635,15 +780,29 @@ void PlanCache::deactivate(const CanonicalQuery& query) {
     }
 
     PlanCacheKey key = computeKey(query);
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
-    if (!cacheStatus.isOK()) {
-        invariant(cacheStatus == ErrorCodes::NoSuchKey);
+    Partition& partition = _partitionFor(key);
+    stdx::lock_guard<Latch> partitionLock(partition.mutex);
+    auto slot = _lookup(key);
+    if (!slot || !slot->entry->isActive) {
         return;
     }
-    invariant(entry);
-    entry->isActive = false;
+
+    auto deactivatedEntry = slot->entry->clone();
+    deactivatedEntry->isActive = false;
+    _store(partitionLock, &partition, key, _makeSlot(key, std::move(deactivatedEntry)));
+}
+
+void PlanCache::_forEachSlot(const std::function<void(const Slot&)>& fn) const {
+    for (auto&& partition : _partitions) {
+        auto table = atomic_load(&partition.table);
+        for (auto&& tableBucket : table->buckets) {
+            if (auto bucket = atomic_load(&tableBucket)) {
+                for (auto&& slot : *bucket) {
+                    fn(*slot);
+                }
+            }
+        }
+    }
 }
 
 PlanCache::GetResult PlanCache::get(const CanonicalQuery& query) const {
@@ -652,28 +811,35 @@ PlanCache::GetResult PlanCache::get(const CanonicalQuery& query) const {
 }
 
 PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
-    if (!cacheStatus.isOK()) {
-        invariant(cacheStatus == ErrorCodes::NoSuchKey);
+    auto slot = _lookup(key);
+    if (!slot) {
         return {CacheEntryState::kNotPresent, nullptr};
     }
-    invariant(entry);
 
     auto state =
-        entry->isActive ? CacheEntryState::kPresentActive : CacheEntryState::kPresentInactive;
-    return {state, std::make_unique<CachedSolution>(key, *entry)};
+        slot->entry->isActive ? CacheEntryState::kPresentActive : CacheEntryState::kPresentInactive;
+    return {state, slot->cachedSolution};
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    PlanCacheKey key = computeKey(canonicalQuery);
+    _epoch.fetchAndAdd(1);
+    Partition& partition = _partitionFor(key);
+    stdx::lock_guard<Latch> partitionLock(partition.mutex);
+    if (!_store(partitionLock, &partition, key, nullptr)) {
+        return Status(ErrorCodes::NoSuchKey, "no such key in plan cache");
+    }
+    return Status::OK();
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    _cache.clear();
+    _epoch.fetchAndAdd(1);
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<Latch> partitionLock(partition.mutex);
+        _size.subtractAndFetch(partition.size);
+        partition.size = 0;
+        atomic_store(&partition.table, std::make_shared<Table>(kInitialBucketsPerPartition));
+    }
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
@@ -687,51 +853,42 @@ PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
 StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQuery& query) const {
     PlanCacheKey key = computeKey(query);
 
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
-    if (!cacheStatus.isOK()) {
-        return cacheStatus;
+    auto slot = _lookup(key);
+    if (!slot) {
+        return Status(ErrorCodes::NoSuchKey, "no such key in plan cache");
     }
-    invariant(entry);
 
-    return std::unique_ptr<PlanCacheEntry>(entry->clone());
+    return slot->entry->clone();
 }
 
 std::vector<std::unique_ptr<PlanCacheEntry>> PlanCache::getAllEntries() const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
     std::vector<std::unique_ptr<PlanCacheEntry>> entries;
 
-    for (auto&& cacheEntry : _cache) {
-        auto entry = cacheEntry.second;
-        entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
-    }
+    _forEachSlot([&](const Slot& slot) { entries.push_back(slot.entry->clone()); });
 
     return entries;
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    return _cache.size();
+    return _size.load();
 }
 
 void PlanCache::notifyOfIndexUpdates(const std::vector<CoreIndexInfo>& indexCores) {
     _indexabilityState.updateDiscriminators(indexCores);
+    _epoch.fetchAndAdd(1);
 }
 
 std::vector<BSONObj> PlanCache::getMatchingStats(
     const std::function<BSONObj(const PlanCacheEntry&)>& serializationFunc,
     const std::function<bool(const BSONObj&)>& filterFunc) const {
     std::vector<BSONObj> results;
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
 
-    for (auto&& cacheEntry : _cache) {
-        const auto entry = cacheEntry.second;
-        auto serializedEntry = serializationFunc(*entry);
+    _forEachSlot([&](const Slot& slot) {
+        auto serializedEntry = serializationFunc(*slot.entry);
         if (filterFunc(serializedEntry)) {
             results.push_back(serializedEntry);
         }
-    }
+    });
 
     return results;
 }
@@ -29,18 +29,21 @@
 
 #pragma once
 
+#include <array>
 #include <boost/optional/optional.hpp>
 #include <set>
+#include <vector>
 
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_tag.h"
-#include "mongo/db/query/lru_key_value.h"
 #include "mongo/db/query/plan_cache_indexability.h"
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/platform/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/container_size_helper.h"
+#include "mongo/util/with_alignment.h"
 
 namespace mongo {
 /**
@@ -52,6 +55,7 @@ public:
         _lengthOfStablePart = shapeString.size();
         _key = std::move(shapeString);
         _key += indexabilityString;
+        _hash = std::hash<std::string>{}(_key);
     }
 
     CanonicalQuery::QueryShapeString getStableKey() const {
@@ -77,6 +81,13 @@ public:
         return _key;
     }
 
+    /**
+     * Returns the hash of the key, which is computed once on construction.
+     */
+    std::size_t hash() const {
+        return _hash;
+    }
+
     bool operator==(const PlanCacheKey& other) const {
         return other._key == _key && other._lengthOfStablePart == _lengthOfStablePart;
     }
@@ -94,6 +105,8 @@ private:
 
     // How long the "stable key" is.
     size_t _lengthOfStablePart;
+
+    std::size_t _hash;
 };
 
 std::ostream& operator<<(std::ostream& stream, const PlanCacheKey& key);
@@ -102,7 +115,7 @@ StringBuilder& operator<<(StringBuilder& builder, const PlanCacheKey& key);
 class PlanCacheKeyHasher {
 public:
     std::size_t operator()(const PlanCacheKey& k) const {
-        return std::hash<std::string>{}(k.toString());
+        return k.hash();
     }
 };
 
@@ -267,7 +280,8 @@ struct SolutionCacheData {
 class PlanCacheEntry;
 
 /**
- * Information returned from a get(...) query.
+ * Information returned from a get(...) query. The plan cache creates one CachedSolution per entry
+ * and hands out shared references to it, so it must not be modified.
  */
 class CachedSolution {
 private:
@@ -275,11 +289,16 @@ private:
     CachedSolution& operator=(const CachedSolution&) = delete;
 
 public:
-    CachedSolution(const PlanCacheKey& key, const PlanCacheEntry& entry);
-    ~CachedSolution();
+    CachedSolution(const PlanCacheKey& key, std::shared_ptr<const PlanCacheEntry> entry);
 
-    // Owned here.
-    std::vector<SolutionCacheData*> plannerData;
+private:
+    // Keeps the planner data alive. Declared first so that it is initialized before the members
+    // referring into it.
+    const std::shared_ptr<const PlanCacheEntry> _entry;
+
+public:
+    // Owned by the cache entry.
+    const std::vector<std::unique_ptr<const SolutionCacheData>>& plannerData;
 
     // Key used to provide feedback on the entry.
     PlanCacheKey key;
@@ -336,8 +355,8 @@ public:
     //
 
     // Data provided to the planner to allow it to recreate the solutions this entry
-    // represents. Each SolutionCacheData is fully owned here, so in order to return
-    // it from the cache a deep copy is made and returned inside CachedSolution.
+    // represents. Each SolutionCacheData is fully owned here. The CachedSolution returned from
+    // the cache shares ownership of the entry rather than copying it.
     const std::vector<std::unique_ptr<const SolutionCacheData>> plannerData;
 
     // TODO: Do we really want to just hold a copy of the CanonicalQuery?  For now we just
@@ -366,7 +385,8 @@ public:
     const std::unique_ptr<const plan_ranker::PlanRankingDecision> decision;
 
     // Whether or not the cache entry is active. Inactive cache entries should not be used for
-    // planning.
+    // planning. Once an entry is in the cache, it is never modified. Changing this or 'works'
+    // replaces the entry with a modified clone.
     bool isActive = false;
 
     // The number of "works" required for a plan to run on this shape before it becomes
@@ -411,6 +431,15 @@ private:
  * Caches the best solution to a query.  Aside from the (CanonicalQuery -> QuerySolution)
  * mapping, the cache contains information on why that mapping was made and statistics on the
  * cache entry's actual performance on subsequent runs.
+ *
+ * The entries are spread over a fixed number of partitions by the hash of their key. Each
+ * partition is a hash table whose buckets are immutable once published. Lookups load the table
+ * and then the bucket atomically, without taking any lock. Writers serialize on the partition's
+ * mutex and publish a modified copy of the one bucket they change, so a write costs as much as
+ * the few entries of a bucket. The table doubles its buckets when they grow too full. Lookups
+ * timestamp the entry they find. When the cache is full, the least recently used of a sample of
+ * entries is evicted, which approximates an LRU policy. The approximation is exact while the
+ * cache holds no more entries than the sample size.
  */
 class PlanCache {
 private:
@@ -442,7 +471,7 @@ public:
      */
     struct GetResult {
         CacheEntryState state;
-        std::unique_ptr<CachedSolution> cachedSolution;
+        std::shared_ptr<const CachedSolution> cachedSolution;
     };
 
     /**
@@ -510,7 +539,7 @@ public:
      * If the cache entry exists and is active, return a CachedSolution. If the cache entry is
      * inactive, log a message and return a nullptr. If no cache entry exists, return a nullptr.
      */
-    std::unique_ptr<CachedSolution> getCacheEntryIfActive(const PlanCacheKey& key) const;
+    std::shared_ptr<const CachedSolution> getCacheEntryIfActive(const PlanCacheKey& key) const;
 
     /**
      * Remove the entry corresponding to 'ck' from the cache.  Returns Status::OK() if the plan
@@ -561,6 +590,16 @@ public:
      */
     void notifyOfIndexUpdates(const std::vector<CoreIndexInfo>& indexCores);
 
+    /**
+     * Returns a counter which is advanced whenever entries are removed from this cache, the cache
+     * is cleared or index information changes. Caches of artifacts derived from query planning,
+     * such as the SBE plan cache, record the epoch at planning time and discard an artifact once
+     * the epoch has moved on.
+     */
+    uint64_t epoch() const {
+        return _epoch.load();
+    }
+
     /**
      * Iterates over the plan cache. For each entry, serializes the PlanCacheEntry according to
      * 'serializationFunc'. Returns a vector of all serialized entries which match 'filterFunc'.
@@ -573,19 +612,119 @@ private:
     struct NewEntryState {
         bool shouldBeCreated = false;
         bool shouldBeActive = false;
+
+        // If set, the existing inactive entry is kept, but its 'works' is raised to this value.
+        boost::optional<size_t> increasedWorks;
+    };
+
+    /**
+     * A cache entry together with the CachedSolution handed out for it.
+     */
+    struct Slot {
+        explicit Slot(PlanCacheKey key) : key(std::move(key)) {}
+
+        PlanCacheKey key;
+        std::shared_ptr<const PlanCacheEntry> entry;
+        std::shared_ptr<const CachedSolution> cachedSolution;
+
+        // The value of '_useClock' when the entry was last set or looked up.
+        mutable AtomicWord<unsigned long long> lastUsed;
+    };
+
+    // The slots whose keys fall into one bucket of a partition's table.
+    using Bucket = std::vector<std::shared_ptr<const Slot>>;
+
+    struct Table {
+        explicit Table(size_t numBuckets) : buckets(numBuckets) {}
+
+        // An empty bucket is nullptr. Readers load a bucket with atomic_load(). Writers never
+        // modify a bucket, but store a modified copy in its place with atomic_store().
+        std::vector<std::shared_ptr<const Bucket>> buckets;
+    };
+
+    struct Partition {
+        // Serializes the writers of this partition.
+        Mutex mutex = MONGO_MAKE_LATCH("PlanCache::Partition::mutex");
+
+        // Readers load the table with atomic_load(). Writers replace it with a larger one as the
+        // partition grows, and with an empty one when the cache is cleared.
+        std::shared_ptr<Table> table = std::make_shared<Table>(kInitialBucketsPerPartition);
+
+        // The number of slots in 'table'. Guarded by 'mutex'.
+        size_t size = 0;
     };
 
+    static constexpr size_t kNumPartitions = 16;
+
+    static constexpr size_t kInitialBucketsPerPartition = 4;
+
+    // The average number of slots per bucket above which a partition's table doubles its buckets.
+    static constexpr size_t kMaxSlotsPerBucket = 2;
+
+    // The number of entries considered for eviction when the cache is full. They are taken from
+    // consecutive partitions, starting at a random bucket within each.
+    static constexpr size_t kEvictionSampleSize = 16;
+
     NewEntryState getNewEntryState(const CanonicalQuery& query,
                                    uint32_t queryHash,
                                    uint32_t planCacheKey,
-                                   PlanCacheEntry* oldEntry,
+                                   const PlanCacheEntry* oldEntry,
                                    size_t newWorks,
                                    double growthCoefficient);
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry, PlanCacheKeyHasher> _cache;
+    Partition& _partitionFor(const PlanCacheKey& key) const;
+
+    /**
+     * Returns the bucket of 'table' which 'key' falls into.
+     */
+    static std::shared_ptr<const Bucket>& _bucketFor(const PlanCacheKey& key, Table& table);
+
+    /**
+     * Returns the slot for 'key', or nullptr if there is none. Marks the slot as used.
+     */
+    std::shared_ptr<const Slot> _lookup(const PlanCacheKey& key) const;
+
+    /**
+     * Creates a slot for a new or replacement entry.
+     */
+    std::shared_ptr<const Slot> _makeSlot(const PlanCacheKey& key,
+                                          std::unique_ptr<const PlanCacheEntry> entry) const;
+
+    /**
+     * Stores 'slot' for 'key' in 'partition', replacing any existing slot, or removes the slot
+     * for 'key' if 'slot' is nullptr. Returns the slot that was replaced or removed, if any.
+     * Grows the table of 'partition' if its buckets are too full.
+     */
+    std::shared_ptr<const Slot> _store(WithLock,
+                                       Partition* partition,
+                                       const PlanCacheKey& key,
+                                       std::shared_ptr<const Slot> slot);
+
+    /**
+     * Calls 'fn' on every slot of the published tables, without taking any lock.
+     */
+    void _forEachSlot(const std::function<void(const Slot&)>& fn) const;
+
+    /**
+     * Evicts entries until the cache is within its maximum size.
+     */
+    void _evictIfFull(const NamespaceString& nss);
+
+    const size_t _maxSize;
+
+    // The number of entries across all partitions.
+    AtomicWord<size_t> _size{0};
+
+    // Ticks on every set or lookup, to order entries by recency of use.
+    mutable AtomicWord<unsigned long long> _useClock{0};
+
+    // The partition at which the next eviction starts sampling.
+    AtomicWord<size_t> _evictionCursor{0};
+
+    // See epoch().
+    AtomicWord<uint64_t> _epoch{0};
 
-    // Protects _cache.
-    mutable Mutex _cacheMutex = MONGO_MAKE_LATCH("PlanCache::_cacheMutex");
+    mutable std::array<CacheAligned<Partition>, kNumPartitions> _partitions;
 
     // Holds computed information about the collection's indexes.  Used for generating plan
     // cache keys.
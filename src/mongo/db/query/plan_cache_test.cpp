@@ -572,6 +572,80 @@ TEST(PlanCacheTest, PlanCacheLRUPolicyRemovesInactiveEntries) {
     ASSERT_EQ(planCache.get(*cqC).state, PlanCache::CacheEntryState::kPresentInactive);
 }
 
+TEST(PlanCacheTest, PlanCacheEvictionKeepsMostRecentlyUsedEntries) {
+    // Use a cache larger than the eviction sample, so that eviction is approximate.
+    const size_t kCacheSize = 50;
+    PlanCache planCache(kCacheSize);
+    QueryTestServiceContext serviceContext;
+
+    unique_ptr<CanonicalQuery> cqHot(canonicalize("{hot: 1}"));
+    addCacheEntryForShape(*cqHot, &planCache);
+
+    for (size_t i = 0; i < 10 * kCacheSize; ++i) {
+        unique_ptr<CanonicalQuery> cq(canonicalize(BSON("a" + std::to_string(i) << 1)));
+        addCacheEntryForShape(*cq, &planCache);
+        ASSERT_LTE(planCache.size(), kCacheSize);
+
+        // The most recently added entry and the one looked up before every addition survive.
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
+        ASSERT_EQ(planCache.get(*cqHot).state, PlanCache::CacheEntryState::kPresentInactive);
+    }
+    ASSERT_EQ(planCache.size(), kCacheSize);
+}
+
+TEST(PlanCacheTest, PlanCacheKeepsEntriesAcrossTableGrowth) {
+    // Enough entries for every partition to rehash its buckets several times.
+    const size_t kNumEntries = 2000;
+    PlanCache planCache(kNumEntries);
+    QueryTestServiceContext serviceContext;
+
+    std::vector<unique_ptr<CanonicalQuery>> cqs;
+    for (size_t i = 0; i < kNumEntries; ++i) {
+        cqs.push_back(canonicalize(BSON("a" + std::to_string(i) << 1)));
+        addCacheEntryForShape(*cqs.back(), &planCache);
+    }
+    ASSERT_EQ(planCache.size(), kNumEntries);
+    ASSERT_EQ(planCache.getAllEntries().size(), kNumEntries);
+    for (auto&& cq : cqs) {
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
+    }
+
+    for (size_t i = 0; i < kNumEntries; i += 2) {
+        ASSERT_OK(planCache.remove(*cqs[i]));
+    }
+    ASSERT_EQ(planCache.size(), kNumEntries / 2);
+    for (size_t i = 0; i < kNumEntries; ++i) {
+        ASSERT_EQ(planCache.get(*cqs[i]).state,
+                  i % 2 ? PlanCache::CacheEntryState::kPresentInactive
+                        : PlanCache::CacheEntryState::kNotPresent);
+    }
+
+    planCache.clear();
+    ASSERT_EQ(planCache.size(), 0U);
+    ASSERT_EQ(planCache.getAllEntries().size(), 0U);
+    ASSERT_EQ(planCache.get(*cqs[1]).state, PlanCache::CacheEntryState::kNotPresent);
+}
+
+TEST(PlanCacheTest, LookupsShareCachedSolution) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    QueryTestServiceContext serviceContext;
+    addCacheEntryForShape(*cq, &planCache);
+    addCacheEntryForShape(*cq, &planCache);
+
+    auto first = planCache.get(*cq);
+    ASSERT_EQ(first.state, PlanCache::CacheEntryState::kPresentActive);
+    ASSERT_EQ(first.cachedSolution.get(), planCache.get(*cq).cachedSolution.get());
+
+    // Deactivating replaces the entry rather than modifying the shared one.
+    planCache.deactivate(*cq);
+    auto second = planCache.get(*cq);
+    ASSERT_EQ(second.state, PlanCache::CacheEntryState::kPresentInactive);
+    ASSERT_NE(first.cachedSolution.get(), second.cachedSolution.get());
+    ASSERT_EQ(first.cachedSolution->plannerData.size(), 1U);
+    ASSERT_EQ(planCache.size(), 1U);
+}
+
 TEST(PlanCacheTest, PlanCacheRemoveDeletesInactiveEntries) {
     PlanCache planCache;
     unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
@@ -1138,7 +1212,7 @@ protected:
         uint32_t planCacheKey = queryHash;
         auto entry = PlanCacheEntry::create(
             solutions, createDecision(1U), *scopedCq, queryHash, planCacheKey, Date_t(), false, 0);
-        CachedSolution cachedSoln(ck, *entry);
+        CachedSolution cachedSoln(ck, std::move(entry));
 
         auto statusWithQs = QueryPlanner::planFromCache(*scopedCq, params, cachedSoln);
         ASSERT_OK(statusWithQs.getStatus());
@@ -457,6 +457,20 @@ void statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendIntOrLL("totalDataSizeSorted", spec->totalDataSizeBytes);
             bob->appendBool("usedDisk", spec->wasDiskUsed);
+
+            if (spec->wasDiskUsed) {
+                const auto& spillStats = spec->spillStats;
+                bob->appendNumber("spilledBytes", spillStats.bytesSpilled);
+                bob->appendNumber("spilledUncompressedBytes",
+                                  spillStats.bytesSpilledUncompressed);
+                if (spillStats.bytesSpilled > 0) {
+                    bob->append("spillCompressionRatio",
+                                static_cast<double>(spillStats.bytesSpilledUncompressed) /
+                                    spillStats.bytesSpilled);
+                }
+                bob->appendNumber("mergeReadWaitMicros",
+                                  durationCount<Microseconds>(spillStats.mergeReadWaitTime));
+            }
         }
     } else if (STAGE_SORT_MERGE == stats.stageType) {
         MergeSortStats* spec = static_cast<MergeSortStats*>(stats.specific.get());
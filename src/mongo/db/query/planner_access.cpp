@@ -221,6 +221,7 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
         params.options & QueryPlannerParams::ASSERT_MIN_TS_HAS_NOT_FALLEN_OFF_OPLOG;
     csn->shouldWaitForOplogVisibility =
         params.options & QueryPlannerParams::OPLOG_SCAN_WAIT_FOR_VISIBLE;
+    csn->feedsWriteStage = params.options & QueryPlannerParams::IS_WRITE;
 
     // If the hint is {$natural: +-1} this changes the direction of the collection scan.
     const BSONObj& hint = query.getQueryRequest().getHint();
@@ -0,0 +1,65 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/optional.hpp>
+
+#include "mongo/util/arena.h"
+
+namespace mongo {
+
+/**
+ * Returns a new arena for the MatchExpression and QuerySolutionNode trees of a single query, or
+ * null unless 'internalQueryEnableQueryArena' is set. A CanonicalQuery owns the arena of its
+ * trees, which are freed at once when the query and the plans built for it are gone.
+ */
+boost::intrusive_ptr<Arena> makeQueryArena();
+
+/**
+ * Places the ArenaAllocatable objects created on this thread, such as MatchExpression and
+ * QuerySolutionNode trees, in 'arena' for the lifetime of the scope. Does nothing if 'arena' is
+ * null.
+ *
+ * Objects placed in the arena keep it alive until they are destroyed, so a tree may outlive the
+ * query it was built for.
+ */
+class QueryArenaScope {
+    QueryArenaScope(const QueryArenaScope&) = delete;
+    QueryArenaScope& operator=(const QueryArenaScope&) = delete;
+
+public:
+    explicit QueryArenaScope(Arena* arena);
+
+private:
+    boost::optional<ArenaScope> _scope;
+};
+
+}  // namespace mongo
@@ -0,0 +1,146 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/json.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/query_arena.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/query/query_planner.h"
+#include "mongo/db/query/query_test_service_context.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kNss("test.coll");
+
+struct QueryShape {
+    const char* name;
+    BSONObj filter;
+    BSONObj sort;
+    BSONObj proj;
+};
+
+// Typical find commands, and the queries that aggregations push down into the find layer.
+const std::vector<QueryShape> kShapes = {
+    {"findPoint", fromjson("{a: 1}"), BSONObj(), BSONObj()},
+    {"findRangeSortProject",
+     fromjson("{a: {$gte: 1, $lt: 100}, b: {$in: [1, 2, 3]}, c: {$ne: null}}"),
+     fromjson("{c: 1}"),
+     fromjson("{_id: 0, a: 1, b: 1, c: 1}")},
+    {"findRootedOr",
+     fromjson("{$or: [{a: 1, b: {$gt: 5}}, {b: 2, c: {$exists: true}}, {d: {$regex: '^x'}}]}"),
+     BSONObj(),
+     BSONObj()},
+    {"aggregateMatchElemMatch",
+     fromjson("{d: {$elemMatch: {x: {$gt: 1}, y: 'foo'}}, a: {$nin: [1, 2]}, e: {$type: 2}}"),
+     BSONObj(),
+     fromjson("{_id: 0, a: 1, d: 1}")},
+};
+
+QueryPlannerParams makePlannerParams() {
+    QueryPlannerParams params;
+    params.options = QueryPlannerParams::INCLUDE_COLLSCAN;
+    for (auto&& [keyPattern, name] : std::vector<std::pair<BSONObj, std::string>>{
+             {BSON("a" << 1), "a_1"}, {BSON("b" << 1 << "c" << 1), "b_1_c_1"}}) {
+        params.indices.push_back({keyPattern,
+                                  IndexNames::nameToType(IndexNames::findPluginName(keyPattern)),
+                                  false,  // multikey
+                                  {},
+                                  {},
+                                  false,  // sparse
+                                  false,  // unique
+                                  IndexEntry::Identifier{name},
+                                  nullptr,  // filterExpr
+                                  BSONObj(),
+                                  nullptr,
+                                  nullptr});
+    }
+    return params;
+}
+
+/**
+ * Parses and plans a query shape in a new operation per iteration, with the query arena enabled
+ * or not. Besides the time, reports how many allocations went to the arena instead of the
+ * heap, and how many blocks the arena took from the heap in exchange.
+ */
+void BM_CanonicalizeAndPlan(benchmark::State& state) {
+    const auto& shape = kShapes[state.range(0)];
+    const bool useArena = state.range(1);
+    state.SetLabel(str::stream() << shape.name << (useArena ? "/arena" : "/heap"));
+
+    const bool wasEnabled = internalQueryEnableQueryArena.load();
+    internalQueryEnableQueryArena.store(useArena);
+
+    QueryTestServiceContext serviceContext;
+    const auto params = makePlannerParams();
+    size_t arenaAllocations = 0;
+    size_t arenaBlocks = 0;
+    for (auto _ : state) {
+        auto opCtx = serviceContext.makeOperationContext();
+        auto qr = std::make_unique<QueryRequest>(kNss);
+        qr->setFilter(shape.filter);
+        qr->setSort(shape.sort);
+        qr->setProj(shape.proj);
+        auto cq = uassertStatusOK(CanonicalQuery::canonicalize(opCtx.get(), std::move(qr)));
+        {
+            QueryArenaScope arenaScope(cq->getArena());
+            auto solutions = uassertStatusOK(QueryPlanner::plan(*cq, params));
+            benchmark::DoNotOptimize(solutions);
+        }
+
+        if (auto arena = cq->getArena()) {
+            arenaAllocations += arena->stats().allocations;
+            arenaBlocks += arena->stats().blocks;
+        }
+    }
+
+    state.counters["arenaAllocations"] =
+        benchmark::Counter(arenaAllocations, benchmark::Counter::kAvgIterations);
+    state.counters["arenaBlocks"] =
+        benchmark::Counter(arenaBlocks, benchmark::Counter::kAvgIterations);
+    internalQueryEnableQueryArena.store(wasEnabled);
+}
+
+void allShapes(benchmark::internal::Benchmark* bm) {
+    for (int64_t shape = 0; shape < static_cast<int64_t>(kShapes.size()); ++shape) {
+        bm->Args({shape, 0});
+        bm->Args({shape, 1});
+    }
+}
+
+BENCHMARK(BM_CanonicalizeAndPlan)->Apply(allShapes);
+
+}  // namespace
+}  // namespace mongo
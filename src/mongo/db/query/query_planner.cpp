@@ -63,7 +63,7 @@ namespace {
  * plan for 'orChild') to 'compositeCacheData'.
  */
 Status tagOrChildAccordingToCache(PlanCacheIndexTree* compositeCacheData,
-                                  SolutionCacheData* branchCacheData,
+                                  const SolutionCacheData* branchCacheData,
                                   MatchExpression* orChild,
                                   const std::map<IndexEntry::Identifier, size_t>& indexMap) {
     invariant(compositeCacheData);
@@ -179,6 +179,9 @@ string optionString(size_t options) {
             case QueryPlannerParams::ENUMERATE_OR_CHILDREN_LOCKSTEP:
                 ss << "ENUMERATE_OR_CHILDREN_LOCKSTEP ";
                 break;
+            case QueryPlannerParams::IS_WRITE:
+                ss << "IS_WRITE ";
+                break;
             case QueryPlannerParams::DEFAULT:
                 MONGO_UNREACHABLE;
                 break;
@@ -1227,7 +1230,7 @@ StatusWith<std::unique_ptr<QuerySolution>> QueryPlanner::choosePlanForSubqueries
             // We can get the index tags we need out of the cache.
             Status tagStatus =
                 tagOrChildAccordingToCache(cacheData.get(),
-                                           branchResult->cachedSolution->plannerData[0],
+                                           branchResult->cachedSolution->plannerData[0].get(),
                                            orChild,
                                            planningResult.indexMap);
             if (!tagStatus.isOK()) {
@@ -62,7 +62,7 @@ public:
             // a set of alternate plans for the branch. The index tags from the cache data
             // can be applied directly to the parent $or MatchExpression when generating the
             // composite solution.
-            std::unique_ptr<CachedSolution> cachedSolution;
+            std::shared_ptr<const CachedSolution> cachedSolution;
 
             // Query solutions resulting from planning the $or branch.
             std::vector<std::unique_ptr<QuerySolution>> solutions;
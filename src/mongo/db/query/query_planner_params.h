@@ -118,6 +118,11 @@ struct QueryPlannerParams {
         // is thought to be helpful in general, but particularly in cases where all children of the
         // $or use the same fields and have the same indexes available, as in this example.
         ENUMERATE_OR_CHILDREN_LOCKSTEP = 1 << 12,
+
+        // Set this if the plan feeds a stage which writes each document it returns, such as an
+        // update or a delete. Every write moves the operation to a new snapshot, so collection
+        // scans read records one at a time rather than in batches which would be fetched again.
+        IS_WRITE = 1 << 13,
     };
 
     // See Options enum above.
@@ -39,6 +39,7 @@
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/stage_types.h"
+#include "mongo/util/arena.h"
 #include "mongo/util/id_generator.h"
 
 namespace mongo {
@@ -109,8 +110,11 @@ private:
 /**
  * This is an abstract representation of a query plan.  It can be transcribed into a tree of
  * PlanStages, which can then be handed to a PlanRunner for execution.
+ *
+ * Like MatchExpressions, nodes are placed in the arena of their query while a QueryArenaScope is
+ * active.
  */
-struct QuerySolutionNode {
+struct QuerySolutionNode : public ArenaAllocatable {
     QuerySolutionNode() = default;
 
     /**
@@ -480,6 +484,9 @@ struct CollectionScanNode : public QuerySolutionNodeWithSortSet {
 
     // Once the first matching document is found, assume that all documents after it must match.
     bool stopApplyingFilterAfterFirstMatch = false;
+
+    // Whether the documents returned by the scan are written to by the plan.
+    bool feedsWriteStage = false;
 };
 
 struct AndHashNode : public QuerySolutionNode {
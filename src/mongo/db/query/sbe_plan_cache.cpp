@@ -0,0 +1,224 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/sbe_plan_cache.h"
+
+#include <boost/container_hash/hash.hpp>
+
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/query/canonical_query_encoder.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/util/hex.h"
+#include "mongo/util/timer.h"
+
+namespace mongo::sbe {
+namespace {
+// Holds the cache through a pointer, as the decorations of a Collection are only reachable through
+// a const Collection.
+struct PlanCacheDecoration {
+    std::unique_ptr<PlanCache> planCache = std::make_unique<PlanCache>();
+};
+
+const auto getPlanCacheDecoration = Collection::declareDecoration<PlanCacheDecoration>();
+}  // namespace
+
+PlanCache::Key::Key(mongo::PlanCacheKey shapeKey, BSONObj literals)
+    : _shapeKey(std::move(shapeKey)), _literals(literals.getOwned()), _hash(_shapeKey.hash()) {
+    boost::hash_combine(_hash, SimpleBSONObjComparator::kInstance.hash(_literals));
+}
+
+PlanCache& PlanCache::get(const CollectionPtr& collection) {
+    return *getPlanCacheDecoration(collection.get()).planCache;
+}
+
+PlanCache::PlanCache() : PlanCache(internalQuerySBEPlanCacheSize.load()) {}
+
+PlanCache::PlanCache(size_t maxSize) : _entries(maxSize) {}
+
+boost::optional<PlanCache::PlanTree> PlanCache::getPlan(const Key& key,
+                                                        uint64_t epoch,
+                                                        PlanYieldPolicy* yieldPolicy) {
+    Timer timer;
+    std::shared_ptr<const Entry> entry;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (!_advanceEpoch(lk, epoch)) {
+            return boost::none;
+        }
+
+        auto shapeStats = _shapeStats.find(key.shapeKey());
+        Slot* slot;
+        if (!_entries.get(key, &slot).isOK()) {
+            if (shapeStats != _shapeStats.end()) {
+                ++shapeStats->second.misses;
+            }
+            return boost::none;
+        }
+
+        invariant(shapeStats != _shapeStats.end());
+        ++shapeStats->second.hits;
+        entry = slot->entry;
+    }
+
+    auto root = entry->root->clone();
+    root->attachNewYieldPolicy(yieldPolicy);
+
+    stage_builder::PlanStageData data{entry->env->makeDeepCopy()};
+    data.resultSlot = entry->resultSlot;
+    data.recordIdSlot = entry->recordIdSlot;
+    data.oplogTsSlot = entry->oplogTsSlot;
+    data.inputParamToSlotMap = entry->inputParamToSlotMap;
+    data.indexBoundsBindings = entry->indexBoundsBindings;
+    data.inputParamsAreBound = entry->inputParamsAreBound;
+
+    auto savedTime = entry->buildTime - Microseconds{timer.micros()};
+    if (savedTime > Microseconds{0}) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (auto shapeStats = _shapeStats.find(key.shapeKey()); shapeStats != _shapeStats.end()) {
+            shapeStats->second.savedTime += savedTime;
+        }
+    }
+
+    return PlanTree{std::move(root), std::move(data)};
+}
+
+void PlanCache::setPlan(const Key& key,
+                        uint64_t epoch,
+                        const PlanTree& tree,
+                        Microseconds buildTime) {
+    auto&& [root, data] = tree;
+    invariant(root);
+    invariant(!data.trialRunProgressTracker);
+
+    // The executor of a parallel plan, or of a plan which tracks its position in the collection,
+    // depends on more state than what is cached.
+    if (data.parallelWorkers.numWorkers() > 1 || data.shouldTrackLatestOplogTimestamp ||
+        data.shouldTrackResumeToken || data.shouldUseTailableScan) {
+        return;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->root = root->clone();
+    entry->env = data.env->makeDeepCopy();
+    entry->resultSlot = data.resultSlot;
+    entry->recordIdSlot = data.recordIdSlot;
+    entry->oplogTsSlot = data.oplogTsSlot;
+    entry->inputParamToSlotMap = data.inputParamToSlotMap;
+    entry->indexBoundsBindings = data.indexBoundsBindings;
+    entry->inputParamsAreBound = data.inputParamsAreBound;
+    entry->buildTime = buildTime;
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (!_advanceEpoch(lk, epoch) || _entries.hasKey(key)) {
+        return;
+    }
+
+    auto [shapeStats, inserted] = _shapeStats.try_emplace(key.shapeKey());
+    if (inserted) {
+        // Lookups only count misses for shapes which are already known, so account for the miss
+        // which led to building this tree here.
+        shapeStats->second.misses = 1;
+    }
+    shapeStats->second.literals = key.literals();
+    ++shapeStats->second.numPlans;
+
+    if (auto evicted = _entries.add(key, new Slot{key.shapeKey(), std::move(entry)})) {
+        _onRemoved(lk, evicted->shapeKey);
+    }
+}
+
+void PlanCache::clear() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _entries.clear();
+    _shapeStats.clear();
+}
+
+size_t PlanCache::size() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _entries.size();
+}
+
+std::vector<BSONObj> PlanCache::getMatchingStats(
+    const std::function<bool(const BSONObj&)>& filterFunc) const {
+    std::vector<BSONObj> results;
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto&& [shapeKey, shapeStats] : _shapeStats) {
+        BSONObjBuilder out;
+        out.append("engine", "sbe");
+        out.append("createdFromQuery", shapeStats.literals);
+        out.append("queryHash",
+                   zeroPaddedHex(
+                       canonical_query_encoder::computeHash(shapeKey.getStableKeyStringData())));
+        out.append("planCacheKey",
+                   zeroPaddedHex(canonical_query_encoder::computeHash(shapeKey.toString())));
+
+        BSONObjBuilder sbeBuilder(out.subobjStart("sbePlanCache"));
+        sbeBuilder.appendNumber("cachedPlans", static_cast<long long>(shapeStats.numPlans));
+        sbeBuilder.appendNumber("hits", shapeStats.hits);
+        sbeBuilder.appendNumber("misses", shapeStats.misses);
+        sbeBuilder.appendNumber("savedMicros", durationCount<Microseconds>(shapeStats.savedTime));
+        sbeBuilder.doneFast();
+
+        auto serializedStats = out.obj();
+        if (filterFunc(serializedStats)) {
+            results.push_back(std::move(serializedStats));
+        }
+    }
+
+    return results;
+}
+
+bool PlanCache::_advanceEpoch(WithLock, uint64_t epoch) {
+    if (epoch < _epoch) {
+        return false;
+    }
+
+    if (epoch > _epoch) {
+        _entries.clear();
+        _shapeStats.clear();
+        _epoch = epoch;
+    }
+    return true;
+}
+
+void PlanCache::_onRemoved(WithLock, const mongo::PlanCacheKey& shapeKey) {
+    auto shapeStats = _shapeStats.find(shapeKey);
+    invariant(shapeStats != _shapeStats.end());
+    if (--shapeStats->second.numPlans == 0) {
+        _shapeStats.erase(shapeStats);
+    }
+}
+}  // namespace mongo::sbe
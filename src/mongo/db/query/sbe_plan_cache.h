@@ -0,0 +1,212 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/exec/sbe/stages/stages.h"
+#include "mongo/db/query/lru_key_value.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/sbe_stage_builder.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/duration.h"
+
+namespace mongo {
+class CollectionPtr;
+
+namespace sbe {
+/**
+ * A per-collection cache of SBE plan trees, for queries which have a single query solution and so
+ * need no runtime planning. Such queries are typically short point queries, for which planning and
+ * stage building take a large share of the execution time.
+ *
+ * A cached tree has never been prepared: the VM code compiled by PlanStage::prepare() refers to the
+ * slot accessors of the tree it was compiled for, so it cannot be shared between trees. A hit
+ * clones the cached tree and binds the clone to a copy of the runtime environment the tree was
+ * built against; the caller still prepares the clone, but skips query planning and stage building.
+ *
+ * A tree is keyed by the query shape together with the literal values which are baked into the
+ * tree. A tree which reads the constants of the input parameters of its query from runtime
+ * environment slots does not depend on these constants, and the caller may key it without them,
+ * and rebind the clone handed out by a hit to the constants of another query of the same shape
+ * (see stage_builder::bindInputParams()).
+ *
+ * Entries are tied to an epoch of the collection's query plan cache (see PlanCache::epoch()), and
+ * are dropped once any event which invalidates query plans, such as an index change or a change of
+ * index filters, has advanced the epoch.
+ *
+ * This class is thread-safe.
+ */
+class PlanCache {
+public:
+    /**
+     * Identifies a cached tree: the plan cache key of the query shape, and the values which are not
+     * part of the shape but are baked into the tree.
+     */
+    class Key {
+    public:
+        Key(mongo::PlanCacheKey shapeKey, BSONObj literals);
+
+        const mongo::PlanCacheKey& shapeKey() const {
+            return _shapeKey;
+        }
+
+        const BSONObj& literals() const {
+            return _literals;
+        }
+
+        std::size_t hash() const {
+            return _hash;
+        }
+
+        bool operator==(const Key& other) const {
+            return _hash == other._hash && _shapeKey == other._shapeKey &&
+                _literals.binaryEqual(other._literals);
+        }
+
+        bool operator!=(const Key& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        mongo::PlanCacheKey _shapeKey;
+        BSONObj _literals;
+        std::size_t _hash;
+    };
+
+    struct KeyHasher {
+        std::size_t operator()(const Key& key) const {
+            return key.hash();
+        }
+    };
+
+    using PlanTree = std::pair<std::unique_ptr<PlanStage>, stage_builder::PlanStageData>;
+
+    static PlanCache& get(const CollectionPtr& collection);
+
+    /**
+     * Creates a cache holding up to 'internalQuerySBEPlanCacheSize' trees.
+     */
+    PlanCache();
+    explicit PlanCache(size_t maxSize);
+
+    /**
+     * Returns a clone of the tree cached for 'key', or boost::none if there is no such tree, or if
+     * it was cached in an epoch other than 'epoch'. The clone yields according to 'yieldPolicy'
+     * and is not prepared yet.
+     */
+    boost::optional<PlanTree> getPlan(const Key& key, uint64_t epoch, PlanYieldPolicy* yieldPolicy);
+
+    /**
+     * Caches a clone of 'tree' under 'key'. The tree must not have been prepared and must not be
+     * tracked by a trial run. Trees which run in parallel, or which track their position in the
+     * collection, are not cached. 'buildTime' is the time it took to plan the query and build the
+     * tree, which a later hit saves, less the time it spends on cloning.
+     */
+    void setPlan(const Key& key, uint64_t epoch, const PlanTree& tree, Microseconds buildTime);
+
+    /**
+     * Removes all cached trees, together with their statistics.
+     */
+    void clear();
+
+    /**
+     * Returns the number of cached trees.
+     */
+    size_t size() const;
+
+    /**
+     * Returns one document per cached query shape, describing the shape and how much the cached
+     * trees of that shape have been used. Each document has an 'engine' field set to "sbe", which
+     * tells it apart from the entries of the classic plan cache. The documents for which
+     * 'filterFunc' returns false are skipped.
+     */
+    std::vector<BSONObj> getMatchingStats(
+        const std::function<bool(const BSONObj&)>& filterFunc) const;
+
+private:
+    struct Entry {
+        // The stages of the tree still refer to the yield policy of the query the tree was built
+        // for, which is replaced in every clone handed out.
+        std::unique_ptr<PlanStage> root;
+
+        // The runtime environment 'root' was built against. It is never attached to a tree.
+        std::unique_ptr<RuntimeEnvironment> env;
+
+        boost::optional<value::SlotId> resultSlot;
+        boost::optional<value::SlotId> recordIdSlot;
+        boost::optional<value::SlotId> oplogTsSlot;
+        stdx::unordered_map<MatchExpression::InputParamId, value::SlotId> inputParamToSlotMap;
+        std::vector<stage_builder::IndexBoundsBinding> indexBoundsBindings;
+        bool inputParamsAreBound;
+        Microseconds buildTime;
+    };
+
+    // LRUKeyValue owns its values through raw pointers, so wrap the shared pointer which lets a hit
+    // clone the tree without holding '_mutex'. The shape key lets an evicted slot update the
+    // statistics of its shape.
+    struct Slot {
+        mongo::PlanCacheKey shapeKey;
+        std::shared_ptr<const Entry> entry;
+    };
+
+    struct ShapeStats {
+        // The literal values of the most recently cached tree of the shape.
+        BSONObj literals;
+        size_t numPlans = 0;
+        long long hits = 0;
+        long long misses = 0;
+        Microseconds savedTime{0};
+    };
+
+    /**
+     * Drops all entries if 'epoch' is newer than the epoch of the cached entries. Returns false if
+     * 'epoch' is older, in which case the caller's view of the query plan cache is stale.
+     */
+    bool _advanceEpoch(WithLock, uint64_t epoch);
+
+    /**
+     * Accounts for the removal of a cached tree of the shape 'shapeKey'.
+     */
+    void _onRemoved(WithLock, const mongo::PlanCacheKey& shapeKey);
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("sbe::PlanCache::_mutex");
+    uint64_t _epoch{0};
+    LRUKeyValue<Key, Slot, KeyHasher> _entries;
+    stdx::unordered_map<mongo::PlanCacheKey, ShapeStats, PlanCacheKeyHasher> _shapeStats;
+};
+}  // namespace sbe
+}  // namespace mongo
@@ -0,0 +1,236 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+/**
+ * This file contains tests for mongo/db/query/sbe_plan_cache.h
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/sbe_plan_cache.h"
+
+#include "mongo/db/exec/sbe/stages/co_scan.h"
+#include "mongo/db/exec/sbe/stages/limit_skip.h"
+#include "mongo/db/storage/index_entry_comparison.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo::sbe {
+namespace {
+
+constexpr uint64_t kEpoch = 1;
+
+PlanCache::Key makeKey(StringData shape, BSONObj literals) {
+    return {mongo::PlanCacheKey(shape.toString(), ""), std::move(literals)};
+}
+
+/**
+ * Builds a small tree which limits an endless scan, and registers a slot holding 'value' in its
+ * runtime environment.
+ */
+PlanCache::PlanTree makeTree(long long value) {
+    value::SlotIdGenerator slotIdGenerator;
+    stage_builder::PlanStageData data{std::make_unique<RuntimeEnvironment>()};
+    data.resultSlot = data.env->registerSlot("value"_sd,
+                                             value::TypeTags::NumberInt64,
+                                             value::bitcastFrom<int64_t>(value),
+                                             false,
+                                             &slotIdGenerator);
+    auto root = makeS<LimitSkipStage>(
+        makeS<CoScanStage>(kEmptyPlanNodeId), 1, boost::none, kEmptyPlanNodeId);
+    return {std::move(root), std::move(data)};
+}
+
+long long getValue(const PlanCache::PlanTree& tree) {
+    auto [tag, val] = tree.second.env->getAccessor(*tree.second.resultSlot)->getViewOfValue();
+    ASSERT(tag == value::TypeTags::NumberInt64);
+    return value::bitcastTo<int64_t>(val);
+}
+
+BSONObj getSbeStats(const PlanCache& cache) {
+    auto stats = cache.getMatchingStats([](const BSONObj&) { return true; });
+    ASSERT_EQ(stats.size(), 1U);
+    return stats[0]["sbePlanCache"].Obj().getOwned();
+}
+
+TEST(SbePlanCacheTest, HitReturnsCloneWithPrivateRuntimeEnvironment) {
+    PlanCache cache(10);
+    auto key = makeKey("shape", BSON("query" << BSON("a" << 1)));
+    ASSERT_FALSE(cache.getPlan(key, kEpoch, nullptr));
+
+    auto tree = makeTree(5);
+    cache.setPlan(key, kEpoch, tree, Microseconds{1000});
+    ASSERT_EQ(cache.size(), 1U);
+
+    auto first = cache.getPlan(key, kEpoch, nullptr);
+    auto second = cache.getPlan(key, kEpoch, nullptr);
+    ASSERT(first);
+    ASSERT(second);
+    ASSERT(first->first.get() != tree.first.get());
+    ASSERT(first->first.get() != second->first.get());
+    ASSERT_EQ(*first->second.resultSlot, *tree.second.resultSlot);
+
+    // Resetting a slot of one clone affects neither the other clones nor the cached tree.
+    first->second.env->resetSlot(*first->second.resultSlot,
+                                 value::TypeTags::NumberInt64,
+                                 value::bitcastFrom<int64_t>(7),
+                                 false);
+    ASSERT_EQ(getValue(*first), 7);
+    ASSERT_EQ(getValue(*second), 5);
+    ASSERT_EQ(getValue(*cache.getPlan(key, kEpoch, nullptr)), 5);
+
+    auto stats = getSbeStats(cache);
+    ASSERT_EQ(stats["cachedPlans"].numberLong(), 1);
+    ASSERT_EQ(stats["hits"].numberLong(), 3);
+    ASSERT_EQ(stats["misses"].numberLong(), 1);
+}
+
+TEST(SbePlanCacheTest, DifferentLiteralsAreCachedSeparately) {
+    PlanCache cache(10);
+    auto keyA = makeKey("shape", BSON("query" << BSON("a" << 1)));
+    auto keyB = makeKey("shape", BSON("query" << BSON("a" << 2)));
+    auto keyC = makeKey("shape", BSON("query" << BSON("a" << 1.0)));
+
+    cache.setPlan(keyA, kEpoch, makeTree(1), Microseconds{1000});
+    ASSERT_FALSE(cache.getPlan(keyB, kEpoch, nullptr));
+    ASSERT_FALSE(cache.getPlan(keyC, kEpoch, nullptr));
+    cache.setPlan(keyB, kEpoch, makeTree(2), Microseconds{1000});
+
+    ASSERT_EQ(getValue(*cache.getPlan(keyA, kEpoch, nullptr)), 1);
+    ASSERT_EQ(getValue(*cache.getPlan(keyB, kEpoch, nullptr)), 2);
+
+    auto stats = getSbeStats(cache);
+    ASSERT_EQ(stats["cachedPlans"].numberLong(), 2);
+    ASSERT_EQ(stats["hits"].numberLong(), 2);
+    ASSERT_EQ(stats["misses"].numberLong(), 3);
+}
+
+TEST(SbePlanCacheTest, NewerEpochDropsCachedTrees) {
+    PlanCache cache(10);
+    auto key = makeKey("shape", BSON("query" << BSON("a" << 1)));
+    cache.setPlan(key, kEpoch, makeTree(1), Microseconds{1000});
+    ASSERT(cache.getPlan(key, kEpoch, nullptr));
+
+    ASSERT_FALSE(cache.getPlan(key, kEpoch + 1, nullptr));
+    ASSERT_EQ(cache.size(), 0U);
+
+    // A tree planned before the epoch advanced is not cached.
+    cache.setPlan(key, kEpoch, makeTree(1), Microseconds{1000});
+    ASSERT_EQ(cache.size(), 0U);
+    ASSERT_FALSE(cache.getPlan(key, kEpoch + 1, nullptr));
+
+    cache.setPlan(key, kEpoch + 1, makeTree(1), Microseconds{1000});
+    ASSERT(cache.getPlan(key, kEpoch + 1, nullptr));
+}
+
+TEST(SbePlanCacheTest, EvictsLeastRecentlyUsedTree) {
+    PlanCache cache(2);
+    auto keyA = makeKey("shapeA", BSON("query" << BSON("a" << 1)));
+    auto keyB = makeKey("shapeB", BSON("query" << BSON("b" << 1)));
+    auto keyC = makeKey("shapeC", BSON("query" << BSON("c" << 1)));
+
+    cache.setPlan(keyA, kEpoch, makeTree(1), Microseconds{1000});
+    cache.setPlan(keyB, kEpoch, makeTree(2), Microseconds{1000});
+    ASSERT(cache.getPlan(keyA, kEpoch, nullptr));
+    cache.setPlan(keyC, kEpoch, makeTree(3), Microseconds{1000});
+
+    ASSERT_EQ(cache.size(), 2U);
+    ASSERT(cache.getPlan(keyA, kEpoch, nullptr));
+    ASSERT_FALSE(cache.getPlan(keyB, kEpoch, nullptr));
+    ASSERT(cache.getPlan(keyC, kEpoch, nullptr));
+
+    // The statistics of a shape go away with its last cached tree.
+    auto stats = cache.getMatchingStats([](const BSONObj&) { return true; });
+    ASSERT_EQ(stats.size(), 2U);
+    ASSERT_EQ(stats[0]["engine"].str(), "sbe");
+
+    cache.clear();
+    ASSERT_EQ(cache.size(), 0U);
+    ASSERT(cache.getMatchingStats([](const BSONObj&) { return true; }).empty());
+}
+
+KeyString::Value makeSeekKey(const BSONObj& key, bool inclusive) {
+    return IndexEntryComparison::makeKeyStringFromBSONKeyForSeek(
+        key, KeyString::Version::kLatestVersion, Ordering::allAscending(), true, inclusive);
+}
+
+const KeyString::Value& getKeyString(const PlanCache::PlanTree& tree, value::SlotId slot) {
+    auto [tag, val] = tree.second.env->getAccessor(slot)->getViewOfValue();
+    ASSERT(tag == value::TypeTags::ksValue);
+    return *value::getKeyStringView(val);
+}
+
+TEST(SbePlanCacheTest, HitCanBeReboundToOtherInputParams) {
+    PlanCache cache(10);
+    auto key = makeKey("shape", BSON("parameterizedQuery" << BSON("a" << BSONNULL)));
+
+    // Build a tree whose index scan seeks to the keys of the point interval {a: 5}.
+    auto tree = makeTree(5);
+    value::SlotIdGenerator slotIdGenerator{100};
+    stage_builder::IndexBoundsBinding binding;
+    binding.lowKey = BSON("" << 5 << "" << MINKEY);
+    binding.highKey = BSON("" << 5 << "" << MAXKEY);
+    binding.inputParamFields = {{0, 0}};
+    binding.lowKeySlot = tree.second.env->registerSlot(
+        "indexBoundsLowKey"_sd,
+        value::TypeTags::ksValue,
+        value::bitcastFrom(new KeyString::Value(makeSeekKey(binding.lowKey, true))),
+        true,
+        &slotIdGenerator);
+    binding.highKeySlot = tree.second.env->registerSlot(
+        "indexBoundsHighKey"_sd,
+        value::TypeTags::ksValue,
+        value::bitcastFrom(new KeyString::Value(makeSeekKey(binding.highKey, false))),
+        true,
+        &slotIdGenerator);
+    tree.second.inputParamToSlotMap.emplace(0, *tree.second.resultSlot);
+    tree.second.indexBoundsBindings.push_back(binding);
+    cache.setPlan(key, kEpoch, tree, Microseconds{1000});
+
+    auto hit = cache.getPlan(key, kEpoch, nullptr);
+    ASSERT(hit);
+    ASSERT_EQ(hit->second.inputParamToSlotMap.at(0), *tree.second.resultSlot);
+    ASSERT_EQ(hit->second.indexBoundsBindings.size(), 1U);
+    ASSERT(hit->second.inputParamsAreBound);
+
+    // Rebinding the clone to {a: 7} moves its seek keys, but not those of the cached tree.
+    auto inputParams = BSON("a" << 7);
+    stage_builder::bindIndexBounds(
+        hit->second.indexBoundsBindings[0], {inputParams["a"]}, hit->second.env);
+    ASSERT_EQ(getKeyString(*hit, binding.lowKeySlot),
+              makeSeekKey(BSON("" << 7 << "" << MINKEY), true));
+    ASSERT_EQ(getKeyString(*hit, binding.highKeySlot),
+              makeSeekKey(BSON("" << 7 << "" << MAXKEY), false));
+
+    auto other = cache.getPlan(key, kEpoch, nullptr);
+    ASSERT_EQ(getKeyString(*other, binding.lowKeySlot), makeSeekKey(binding.lowKey, true));
+}
+
+}  // namespace
+}  // namespace mongo::sbe
@@ -44,12 +44,18 @@
 #include "mongo/db/exec/sbe/stages/text_match.h"
 #include "mongo/db/exec/sbe/stages/traverse.h"
 #include "mongo/db/exec/sbe/stages/union.h"
+#include "mongo/db/exec/sbe/values/bson.h"
 #include "mongo/db/fts/fts_index_format.h"
 #include "mongo/db/fts/fts_query_impl.h"
 #include "mongo/db/fts/fts_spec.h"
 #include "mongo/db/index/fts_access_method.h"
+#include "mongo/db/matcher/expression_algo.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/pipeline/dependencies.h"
+#include "mongo/db/query/columnar_cache.h"
 #include "mongo/db/query/sbe_stage_builder_coll_scan.h"
 #include "mongo/db/query/sbe_stage_builder_filter.h"
+#include "mongo/db/query/sbe_stage_builder_group.h"
 #include "mongo/db/query/sbe_stage_builder_index_scan.h"
 #include "mongo/db/query/sbe_stage_builder_projection.h"
 #include "mongo/db/query/util/make_data_structure.h"
@@ -68,9 +74,59 @@ std::unique_ptr<sbe::RuntimeEnvironment> makeRuntimeEnvironment(
     return env;
 }
 
+namespace {
+/**
+ * Returns the columnar cache of the scanned collection if it holds the top-level field of every
+ * path the query depends on, so that the documents the scan produces can be rebuilt from it.
+ * The dependencies are those of the filter, the sort and an inclusion projection; a query without
+ * one returns whole documents.
+ */
+std::shared_ptr<ColumnarCollectionCache> getCoveringColumnarCache(OperationContext* opCtx,
+                                                                  const CollectionPtr& collection,
+                                                                  const CanonicalQuery& cq,
+                                                                  const CollectionScanNode* csn) {
+    if (csn->direction != CollectionScanParams::FORWARD || csn->tailable ||
+        csn->resumeAfterRecordId || csn->minTs || csn->maxTs) {
+        return nullptr;
+    }
+
+    auto cache = ColumnarCacheRegistry::get(opCtx->getServiceContext()).lookup(collection->ns());
+    if (!cache) {
+        return nullptr;
+    }
+
+    auto proj = cq.getProj();
+    if (!proj || proj->type() != projection_ast::ProjectType::kInclusion ||
+        proj->requiresDocument() || proj->requiresMatchDetails()) {
+        return nullptr;
+    }
+
+    DepsTracker deps;
+    cq.root()->addDependencies(&deps);
+    if (deps.needWholeDocument) {
+        return nullptr;
+    }
+
+    std::vector<std::string> paths(deps.fields.begin(), deps.fields.end());
+    const auto& projFields = proj->getRequiredFields();
+    paths.insert(paths.end(), projFields.begin(), projFields.end());
+    for (auto&& sortElem : cq.getQueryRequest().getSort()) {
+        paths.push_back(sortElem.fieldName());
+    }
+
+    for (auto&& path : paths) {
+        if (!cache->hasField(StringData(path).substr(0, path.find('.')))) {
+            return nullptr;
+        }
+    }
+    return cache;
+}
+}  // namespace
+
 std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildCollScan(
     const QuerySolutionNode* root) {
     auto csn = static_cast<const CollectionScanNode*>(root);
+    const bool useParallelScan = _data.parallelWorkers.numWorkers() > 1;
     auto [resultSlot, recordIdSlot, oplogTsSlot, stage] =
         generateCollScan(_opCtx,
                          _collection,
@@ -80,7 +136,11 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildCollScan(
                          _yieldPolicy,
                          _data.env,
                          _isTailableCollScanResumeBranch,
-                         _data.trialRunProgressTracker.get());
+                         _data.trialRunProgressTracker.get(),
+                         useParallelScan,
+                         useParallelScan
+                             ? nullptr
+                             : getCoveringColumnarCache(_opCtx, _collection, _cq, csn));
     _data.resultSlot = resultSlot;
     _data.recordIdSlot = recordIdSlot;
     _data.oplogTsSlot = oplogTsSlot;
@@ -102,14 +162,52 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildCollScan(
 std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildIndexScan(
     const QuerySolutionNode* root) {
     auto ixn = static_cast<const IndexScanNode*>(root);
-    auto [slot, stage] = generateIndexScan(_opCtx,
-                                           _collection,
-                                           ixn,
-                                           _returnKeySlot,
-                                           &_slotIdGenerator,
-                                           &_spoolIdGenerator,
-                                           _yieldPolicy,
-                                           _data.trialRunProgressTracker.get());
+
+    // The input parameters are the constants of $eq predicates at the top level of the query, on
+    // paths which no other predicate refers to, so the bounds of an index field on such a path are
+    // the point interval of the constant.
+    std::vector<std::pair<size_t, MatchExpression::InputParamId>> inputParamFields;
+    auto findInputParam = [&](const MatchExpression* node, StringData path) {
+        if (node->matchType() == MatchExpression::EQ && node->path() == path) {
+            return static_cast<const EqualityMatchExpression*>(node)->getInputParamId();
+        }
+        return boost::optional<MatchExpression::InputParamId>{};
+    };
+    auto queryRoot = _cq.root();
+    size_t fieldNo = 0;
+    for (auto&& elem : ixn->index.keyPattern) {
+        auto path = elem.fieldNameStringData();
+        boost::optional<MatchExpression::InputParamId> paramId;
+        if (queryRoot->matchType() == MatchExpression::AND) {
+            for (size_t i = 0; i < queryRoot->numChildren() && !paramId; ++i) {
+                paramId = findInputParam(queryRoot->getChild(i), path);
+            }
+        } else {
+            paramId = findInputParam(queryRoot, path);
+        }
+
+        if (paramId) {
+            inputParamFields.emplace_back(fieldNo, *paramId);
+        }
+        ++fieldNo;
+    }
+
+    auto [slot, stage, indexBoundsBinding] = generateIndexScan(_opCtx,
+                                                               _collection,
+                                                               ixn,
+                                                               inputParamFields,
+                                                               _returnKeySlot,
+                                                               &_slotIdGenerator,
+                                                               &_spoolIdGenerator,
+                                                               _data.env,
+                                                               _yieldPolicy,
+                                                               _data.trialRunProgressTracker.get());
+    if (indexBoundsBinding) {
+        _data.indexBoundsBindings.push_back(std::move(*indexBoundsBinding));
+    } else if (!inputParamFields.empty()) {
+        _data.inputParamsAreBound = false;
+    }
+
     _data.recordIdSlot = slot;
     return std::move(stage);
 }
@@ -391,8 +489,13 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildOr(const QuerySoluti
                                              root->nodeId());
 
     if (orn->dedup) {
-        stage = sbe::makeS<sbe::HashAggStage>(
-            std::move(stage), sbe::makeSV(*_data.recordIdSlot), sbe::makeEM(), root->nodeId());
+        stage = sbe::makeS<sbe::HashAggStage>(std::move(stage),
+                                              sbe::makeSV(*_data.recordIdSlot),
+                                              sbe::makeEM(),
+                                              sbe::makeEM(),
+                                              boost::none,
+                                              false,
+                                              root->nodeId());
     }
 
     if (orn->filter) {
@@ -482,8 +585,13 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::buildText(const QuerySolu
     // TODO: If text score metadata is requested, then we should sum over the text scores inside the
     // index keys for a given document. This will require expression evaluation to be able to
     // extract the score directly from the key string.
-    auto hashAggStage = sbe::makeS<sbe::HashAggStage>(
-        std::move(unionStage), sbe::makeSV(*_data.recordIdSlot), sbe::makeEM(), root->nodeId());
+    auto hashAggStage = sbe::makeS<sbe::HashAggStage>(std::move(unionStage),
+                                                      sbe::makeSV(*_data.recordIdSlot),
+                                                      sbe::makeEM(),
+                                                      sbe::makeEM(),
+                                                      boost::none,
+                                                      false,
+                                                      root->nodeId());
 
     auto nljStage =
         makeLoopJoinForFetch(std::move(hashAggStage), *_data.recordIdSlot, root->nodeId());
@@ -614,6 +722,44 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::makeUnionForTailableCollS
     return unionStage;
 }
 
+void SlotBasedStageBuilder::reserveParallelWorkersIfEligible(const QuerySolutionNode* root) {
+    const auto requestedDegree = internalQueryDefaultDOP.load();
+    if (requestedDegree < 2) {
+        return;
+    }
+
+    // Only a $group over a plain forward scan of the whole collection is parallelized. The plan
+    // must not take part in a trial run, since the exchange cannot be reopened once the winning
+    // plan has been picked.
+    auto&& group = _cq.getPushedDownGroup();
+    if (!group || !isParallelGroupSupported(*group) || _data.trialRunProgressTracker ||
+        _returnKeySlot || _cq.getQueryRequest().isTailable() || _collection->ns().isOplog()) {
+        return;
+    }
+
+    auto node = root;
+    while (node->getType() == STAGE_PROJECTION_SIMPLE ||
+           node->getType() == STAGE_PROJECTION_DEFAULT) {
+        node = node->children[0];
+    }
+    if (node->getType() != STAGE_COLLSCAN) {
+        return;
+    }
+
+    auto csn = static_cast<const CollectionScanNode*>(node);
+    if (csn->direction != CollectionScanParams::FORWARD || csn->minTs || csn->maxTs ||
+        csn->resumeAfterRecordId || csn->tailable || csn->shouldTrackLatestOplogTimestamp ||
+        csn->requestResumeToken || csn->stopApplyingFilterAfterFirstMatch) {
+        return;
+    }
+
+    auto reservation = sbe::ExchangeWorkerReservation::reserve(
+        requestedDegree, std::max(internalQueryMaxParallelWorkers.load(), 0));
+    if (reservation.numWorkers() > 1) {
+        _data.parallelWorkers = std::move(reservation);
+    }
+}
+
 // Returns a non-null pointer to the root of a plan tree, or a non-OK status if the PlanStage tree
 // could not be constructed.
 std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::build(const QuerySolutionNode* root) {
@@ -655,6 +801,62 @@ std::unique_ptr<sbe::PlanStage> SlotBasedStageBuilder::build(const QuerySolution
             break;
     }
 
-    return std::invoke(kStageBuilders.at(root->getType()), *this, root);
+    if (root == _solution.root()) {
+        reserveParallelWorkersIfEligible(root);
+    }
+
+    auto stage = std::invoke(kStageBuilders.at(root->getType()), *this, root);
+
+    // If a $group has been pushed down from the pipeline into this query, apply it on top of the
+    // root of the query solution. The plan now returns the group's output documents, which are not
+    // associated with any record.
+    if (root == _solution.root() && _cq.getPushedDownGroup()) {
+        invariant(_data.resultSlot);
+        auto [groupSlot, groupStage] =
+            generateGroup(_opCtx,
+                          *_cq.getPushedDownGroup(),
+                          std::move(stage),
+                          &_slotIdGenerator,
+                          &_frameIdGenerator,
+                          *_data.resultSlot,
+                          _data.env,
+                          static_cast<size_t>(internalDocumentSourceGroupMaxMemoryBytes.load()),
+                          _cq.getExpCtx()->allowDiskUse,
+                          _data.trialRunProgressTracker.get(),
+                          _data.parallelWorkers.numWorkers(),
+                          root->nodeId());
+        _data.resultSlot = groupSlot;
+        _data.recordIdSlot = boost::none;
+        _data.oplogTsSlot = boost::none;
+        return std::move(groupStage);
+    }
+
+    return stage;
+}
+
+PlanStageData SlotBasedStageBuilder::getPlanStageData() {
+    auto inputParams = expression::getInputParams(_cq.root());
+    for (size_t paramId = 0; paramId < inputParams.size(); ++paramId) {
+        if (auto slot = _data.env->getSlotIfExists(makeInputParamSlotName(paramId))) {
+            _data.inputParamToSlotMap.emplace(paramId, *slot);
+        }
+    }
+    return std::move(_data);
+}
+
+void bindInputParams(const CanonicalQuery& cq, PlanStageData* data) {
+    auto inputParams = expression::getInputParams(cq.root());
+    for (auto&& [paramId, slot] : data->inputParamToSlotMap) {
+        invariant(static_cast<size_t>(paramId) < inputParams.size());
+        const auto& elem = inputParams[paramId];
+        auto [tagView, valView] = sbe::bson::convertFrom(
+            true, elem.rawdata(), elem.rawdata() + elem.size(), elem.fieldNameSize() - 1);
+        auto [tag, val] = sbe::value::copyValue(tagView, valView);
+        data->env->resetSlot(slot, tag, val, true);
+    }
+
+    for (auto&& binding : data->indexBoundsBindings) {
+        bindIndexBounds(binding, inputParams, data->env);
+    }
 }
 }  // namespace mongo::stage_builder
@@ -30,12 +30,15 @@
 #pragma once
 
 #include "mongo/db/exec/sbe/expressions/expression.h"
+#include "mongo/db/exec/sbe/stages/exchange.h"
 #include "mongo/db/exec/sbe/values/slot.h"
 #include "mongo/db/exec/sbe/values/value.h"
 #include "mongo/db/exec/trial_period_utils.h"
 #include "mongo/db/exec/trial_run_progress_tracker.h"
 #include "mongo/db/query/plan_yield_policy_sbe.h"
+#include "mongo/db/query/sbe_stage_builder_index_scan.h"
 #include "mongo/db/query/stage_builder.h"
+#include "mongo/stdx/unordered_map.h"
 
 namespace mongo::stage_builder {
 /**
@@ -81,8 +84,26 @@ struct PlanStageData {
     bool shouldUseTailableScan{false};
     // Used during the trial run of the runtime planner to track progress of the work done so far.
     std::unique_ptr<TrialRunProgressTracker> trialRunProgressTracker;
+    // The workers reserved for the producers of a parallel plan. The plan runs serially if this
+    // holds fewer than two workers.
+    sbe::ExchangeWorkerReservation parallelWorkers;
+
+    // The runtime environment slots from which the filters of the plan read the constants of the
+    // input parameters of the query.
+    stdx::unordered_map<MatchExpression::InputParamId, sbe::value::SlotId> inputParamToSlotMap;
+    // The index scans of the plan whose bounds are derived from input parameters.
+    std::vector<IndexBoundsBinding> indexBoundsBindings;
+    // False if the constant of an input parameter is baked into the plan, such as into the bounds
+    // of a multi-interval index scan, in which case the plan cannot be rebound to other constants.
+    bool inputParamsAreBound{true};
 };
 
+/**
+ * Binds the plan described by 'data' to the constants of the input parameters of 'cq', which must
+ * have the shape of the query the plan was built for. The plan must not have been opened yet.
+ */
+void bindInputParams(const CanonicalQuery& cq, PlanStageData* data);
+
 /**
  * A stage builder which builds an executable tree using slot-based PlanStages.
  */
@@ -105,9 +126,7 @@ public:
 
     std::unique_ptr<sbe::PlanStage> build(const QuerySolutionNode* root) final;
 
-    PlanStageData getPlanStageData() {
-        return std::move(_data);
-    }
+    PlanStageData getPlanStageData();
 
 private:
     std::unique_ptr<sbe::PlanStage> buildCollScan(const QuerySolutionNode* root);
@@ -131,6 +150,13 @@ private:
 
     std::unique_ptr<sbe::PlanStage> makeUnionForTailableCollScan(const QuerySolutionNode* root);
 
+    /**
+     * Reserves workers to run the plan for the solution rooted at 'root' in parallel, if the
+     * degree of parallelism requested by the 'internalQueryDefaultDOP' knob is greater than one
+     * and the plan can be parallelized.
+     */
+    void reserveParallelWorkersIfEligible(const QuerySolutionNode* root);
+
     sbe::value::SlotIdGenerator _slotIdGenerator;
     sbe::value::FrameIdGenerator _frameIdGenerator;
     sbe::value::SpoolIdGenerator _spoolIdGenerator;
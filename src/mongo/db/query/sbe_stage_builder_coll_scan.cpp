@@ -307,7 +307,9 @@ generateGenericCollScan(OperationContext* opCtx,
                         PlanYieldPolicy* yieldPolicy,
                         sbe::RuntimeEnvironment* env,
                         bool isTailableResumeBranch,
-                        TrialRunProgressTracker* tracker) {
+                        TrialRunProgressTracker* tracker,
+                        bool useParallelScan,
+                        std::shared_ptr<ColumnarCollectionCache> columnarCache) {
     const auto forward = csn->direction == CollectionScanParams::FORWARD;
 
     invariant(!csn->shouldTrackLatestOplogTimestamp || collection->ns().isOplog());
@@ -332,17 +334,32 @@ generateGenericCollScan(OperationContext* opCtx,
         collection, slotIdGenerator, csn->shouldTrackLatestOplogTimestamp);
 
     NamespaceStringOrUUID nss{collection->ns().db().toString(), collection->uuid()};
-    auto stage = sbe::makeS<sbe::ScanStage>(nss,
-                                            resultSlot,
-                                            recordIdSlot,
-                                            std::move(fields),
-                                            std::move(slots),
-                                            seekRecordIdSlot,
-                                            forward,
-                                            yieldPolicy,
-                                            tracker,
-                                            csn->nodeId(),
-                                            makeOpenCallbackIfNeeded(collection, csn));
+    auto stage = [&]() {
+        if (useParallelScan) {
+            // Every producer runs its own copy of the scan under its own operation context, so the
+            // scan neither yields nor takes part in a trial run.
+            invariant(forward && !seekRecordIdSlot && !tsSlot && !tracker && !columnarCache);
+            return sbe::makeS<sbe::ParallelScanStage>(nss,
+                                                      resultSlot,
+                                                      recordIdSlot,
+                                                      std::move(fields),
+                                                      std::move(slots),
+                                                      nullptr,
+                                                      csn->nodeId());
+        }
+        return sbe::makeS<sbe::ScanStage>(nss,
+                                          resultSlot,
+                                          recordIdSlot,
+                                          std::move(fields),
+                                          std::move(slots),
+                                          seekRecordIdSlot,
+                                          forward,
+                                          yieldPolicy,
+                                          tracker,
+                                          csn->nodeId(),
+                                          makeOpenCallbackIfNeeded(collection, csn),
+                                          std::move(columnarCache));
+    }();
 
     // Check if the scan should be started after the provided resume RecordId and construct a nested
     // loop join sub-tree to project out the resume RecordId as a seekRecordIdSlot and feed it to
@@ -454,7 +471,12 @@ generateCollScan(OperationContext* opCtx,
                  PlanYieldPolicy* yieldPolicy,
                  sbe::RuntimeEnvironment* env,
                  bool isTailableResumeBranch,
-                 TrialRunProgressTracker* tracker) {
+                 TrialRunProgressTracker* tracker,
+                 bool useParallelScan,
+                 std::shared_ptr<ColumnarCollectionCache> columnarCache) {
+    invariant(!useParallelScan || !(csn->minTs || csn->maxTs));
+    invariant(!columnarCache ||
+              !(csn->minTs || csn->maxTs || csn->resumeAfterRecordId || csn->tailable));
 
     auto [resultSlot, recordIdSlot, oplogTsSlot, stage] = [&]() {
         if (csn->minTs || csn->maxTs) {
@@ -476,7 +498,9 @@ generateCollScan(OperationContext* opCtx,
                                            yieldPolicy,
                                            env,
                                            isTailableResumeBranch,
-                                           tracker);
+                                           tracker,
+                                           useParallelScan,
+                                           std::move(columnarCache));
         }
     }();
 
@@ -33,6 +33,7 @@
 #include "mongo/db/exec/sbe/stages/stages.h"
 #include "mongo/db/exec/sbe/values/value.h"
 #include "mongo/db/exec/trial_run_progress_tracker.h"
+#include "mongo/db/query/columnar_cache.h"
 #include "mongo/db/query/query_solution.h"
 
 namespace mongo::stage_builder {
@@ -46,6 +47,14 @@ namespace mongo::stage_builder {
  *     were requested to track this data.
  *   * A generated PlanStage sub-tree.
  *
+ * If 'useParallelScan' is true, the collection is scanned with a ParallelScanStage which splits
+ * the collection into RecordId ranges, so that several copies of the generated sub-tree can run
+ * as producers of an exchange. This is only supported for a generic forward scan.
+ *
+ * If 'columnarCache' is set, it must hold every field the query depends on, and the scan reads
+ * from it whenever it can. This is only supported for a generic forward scan without a resume
+ * RecordId.
+ *
  * In cases of an error, throws.
  */
 std::tuple<sbe::value::SlotId,
@@ -60,5 +69,7 @@ generateCollScan(OperationContext* opCtx,
                  PlanYieldPolicy* yieldPolicy,
                  sbe::RuntimeEnvironment* env,
                  bool isTailableResumeBranch,
-                 TrialRunProgressTracker* tracker);
+                 TrialRunProgressTracker* tracker,
+                 bool useParallelScan = false,
+                 std::shared_ptr<ColumnarCollectionCache> columnarCache = nullptr);
 }  // namespace mongo::stage_builder
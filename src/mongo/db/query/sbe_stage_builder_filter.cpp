@@ -573,21 +573,44 @@ void generateArraySize(MatchExpressionVisitorContext* context,
 void generateComparison(MatchExpressionVisitorContext* context,
                         const ComparisonMatchExpression* expr,
                         sbe::EPrimBinary::Op binaryOp) {
+    // The constant of a parameterized expression is read from a runtime environment slot, so that
+    // a cached plan can be reused for a query with a different constant by resetting the slot. All
+    // the clones of the expression within the plan share the slot.
+    boost::optional<sbe::value::SlotId> inputParamSlot;
+    if (auto paramId = expr->getInputParamId()) {
+        auto slotName = makeInputParamSlotName(*paramId);
+        inputParamSlot = context->env->getSlotIfExists(slotName);
+        if (!inputParamSlot) {
+            const auto& rhs = expr->getData();
+            auto [tagView, valView] = sbe::bson::convertFrom(
+                true, rhs.rawdata(), rhs.rawdata() + rhs.size(), rhs.fieldNameSize() - 1);
+            auto [tag, val] = sbe::value::copyValue(tagView, valView);
+            inputParamSlot =
+                context->env->registerSlot(slotName, tag, val, true, context->slotIdGenerator);
+        }
+    }
+
     auto makePredicate =
-        [expr, binaryOp](sbe::value::SlotId inputSlot,
-                         std::unique_ptr<sbe::PlanStage> inputStage) -> MakePredicateReturnType {
-        const auto& rhs = expr->getData();
-        auto [tagView, valView] = sbe::bson::convertFrom(
-            true, rhs.rawdata(), rhs.rawdata() + rhs.size(), rhs.fieldNameSize() - 1);
-
-        // SBE EConstant assumes ownership of the value so we have to make a copy here.
-        auto [tag, val] = sbe::value::copyValue(tagView, valView);
-
-        return {
-            makeFillEmptyFalse(sbe::makeE<sbe::EPrimBinary>(binaryOp,
-                                                            sbe::makeE<sbe::EVariable>(inputSlot),
-                                                            sbe::makeE<sbe::EConstant>(tag, val))),
-            std::move(inputStage)};
+        [expr, binaryOp, inputParamSlot](
+            sbe::value::SlotId inputSlot,
+            std::unique_ptr<sbe::PlanStage> inputStage) -> MakePredicateReturnType {
+        auto rhsExpr = [&]() -> std::unique_ptr<sbe::EExpression> {
+            if (inputParamSlot) {
+                return sbe::makeE<sbe::EVariable>(*inputParamSlot);
+            }
+
+            const auto& rhs = expr->getData();
+            auto [tagView, valView] = sbe::bson::convertFrom(
+                true, rhs.rawdata(), rhs.rawdata() + rhs.size(), rhs.fieldNameSize() - 1);
+
+            // SBE EConstant assumes ownership of the value so we have to make a copy here.
+            auto [tag, val] = sbe::value::copyValue(tagView, valView);
+            return sbe::makeE<sbe::EConstant>(tag, val);
+        }();
+
+        return {makeFillEmptyFalse(sbe::makeE<sbe::EPrimBinary>(
+                    binaryOp, sbe::makeE<sbe::EVariable>(inputSlot), std::move(rhsExpr))),
+                std::move(inputStage)};
     };
 
     generateTraverse(context, expr->path(), std::move(makePredicate));
@@ -1519,4 +1542,8 @@ std::unique_ptr<sbe::PlanStage> generateFilter(OperationContext* opCtx,
     tree_walker::walk<true, MatchExpression>(root, &walker);
     return context.done();
 }
+
+std::string makeInputParamSlotName(MatchExpression::InputParamId paramId) {
+    return str::stream() << "inputParam" << paramId;
+}
 }  // namespace mongo::stage_builder
@@ -52,4 +52,9 @@ std::unique_ptr<sbe::PlanStage> generateFilter(OperationContext* opCtx,
                                                sbe::value::SlotVector relevantSlotsIn,
                                                PlanNodeId planNodeId);
 
+/**
+ * Returns the name of the runtime environment slot from which a filter generated by
+ * 'generateFilter()' reads the constant of the input parameter 'paramId'.
+ */
+std::string makeInputParamSlotName(MatchExpression::InputParamId paramId);
 }  // namespace mongo::stage_builder
@@ -0,0 +1,328 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/sbe_stage_builder_group.h"
+
+#include "mongo/db/exec/sbe/stages/exchange.h"
+#include "mongo/db/exec/sbe/stages/hash_agg.h"
+#include "mongo/db/exec/sbe/stages/makeobj.h"
+#include "mongo/db/exec/sbe/stages/project.h"
+#include "mongo/db/matcher/matcher_type_set.h"
+#include "mongo/db/query/sbe_stage_builder_expression.h"
+
+namespace mongo::stage_builder {
+namespace {
+using ExpressionType = std::unique_ptr<sbe::EExpression>;
+
+ExpressionType makeVariable(sbe::value::SlotId slot) {
+    return sbe::makeE<sbe::EVariable>(slot);
+}
+
+ExpressionType makeFunction(StringData name, ExpressionType arg) {
+    return sbe::makeE<sbe::EFunction>(name.toString(), sbe::makeEs(std::move(arg)));
+}
+
+ExpressionType makeNullConstant() {
+    return sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::Null, 0);
+}
+
+ExpressionType makeInt64Constant(int64_t value) {
+    return sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::NumberInt64,
+                                      sbe::value::bitcastFrom<int64_t>(value));
+}
+
+ExpressionType makeNothingConstant() {
+    return sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::Nothing, 0);
+}
+
+ExpressionType makeFillEmptyNull(ExpressionType expr) {
+    return sbe::makeE<sbe::EFunction>("fillEmpty", sbe::makeEs(std::move(expr), makeNullConstant()));
+}
+
+/**
+ * Returns 'expr' if the value in 'slot' is a number, and Nothing otherwise. Aggregate functions
+ * ignore Nothing, so this is used to skip non-numeric inputs in $sum and $avg.
+ */
+ExpressionType makeIfNumber(sbe::value::SlotId slot, ExpressionType expr) {
+    return sbe::makeE<sbe::EIf>(
+        makeFunction("isNumber", makeVariable(slot)), std::move(expr), makeNothingConstant());
+}
+
+/**
+ * The aggregates computed by the HashAggStage for a single accumulator, and an expression to
+ * compute the accumulated value from them once all the input has been consumed.
+ */
+struct LoweredAccumulator {
+    // Each entry is an aggregate output slot along with the aggregate function and its argument.
+    // Partial aggregates are always combined by applying the same function to them again.
+    std::vector<std::tuple<sbe::value::SlotId, StringData, ExpressionType>> aggs;
+    ExpressionType finalExpr;
+};
+
+LoweredAccumulator lowerAccumulator(StringData opName,
+                                    sbe::value::SlotId argSlot,
+                                    sbe::value::SlotIdGenerator* slotIdGenerator) {
+    LoweredAccumulator lowered;
+    auto addAgg = [&](StringData aggName, ExpressionType aggArg) {
+        auto slot = slotIdGenerator->generate();
+        lowered.aggs.emplace_back(slot, aggName, std::move(aggArg));
+        return slot;
+    };
+
+    if (opName == "$sum"_sd) {
+        // Non-numeric values are ignored. The classic $sum returns an int if all numeric inputs were
+        // ints and the sum fits, so track whether any non-int number was seen in a 'rank' aggregate.
+        auto sumSlot = addAgg("sum"_sd, makeIfNumber(argSlot, makeVariable(argSlot)));
+        auto rankSlot = addAgg(
+            "max"_sd,
+            makeIfNumber(argSlot,
+                         sbe::makeE<sbe::EIf>(
+                             sbe::makeE<sbe::ETypeMatch>(
+                                 makeVariable(argSlot),
+                                 MatcherTypeSet{BSONType::NumberInt}.getBSONTypeMask()),
+                             makeInt64Constant(0),
+                             makeInt64Constant(1))));
+        lowered.finalExpr = sbe::makeE<sbe::EIf>(
+            sbe::makeE<sbe::EPrimBinary>(
+                sbe::EPrimBinary::eq,
+                sbe::makeE<sbe::EFunction>(
+                    "fillEmpty", sbe::makeEs(makeVariable(rankSlot), makeInt64Constant(0))),
+                makeInt64Constant(0)),
+            sbe::makeE<sbe::EFunction>(
+                "fillEmpty",
+                sbe::makeEs(sbe::makeE<sbe::ENumericConvert>(
+                                sbe::makeE<sbe::EFunction>(
+                                    "fillEmpty",
+                                    sbe::makeEs(makeVariable(sumSlot), makeInt64Constant(0))),
+                                sbe::value::TypeTags::NumberInt32),
+                            makeVariable(sumSlot))),
+            makeVariable(sumSlot));
+    } else if (opName == "$avg"_sd) {
+        // Non-numeric values are ignored, and the average of no numbers is null.
+        auto sumSlot = addAgg("sum"_sd, makeIfNumber(argSlot, makeVariable(argSlot)));
+        auto countSlot = addAgg("sum"_sd, makeIfNumber(argSlot, makeInt64Constant(1)));
+        lowered.finalExpr = sbe::makeE<sbe::EIf>(
+            makeFunction("exists", makeVariable(countSlot)),
+            sbe::makeE<sbe::EPrimBinary>(
+                sbe::EPrimBinary::div, makeVariable(sumSlot), makeVariable(countSlot)),
+            makeNullConstant());
+    } else if (opName == "$min"_sd || opName == "$max"_sd) {
+        // Null and missing values are ignored, and the result is null if there were no other
+        // values.
+        auto isNullOrMissing = sbe::makeE<sbe::EPrimBinary>(
+            sbe::EPrimBinary::logicOr,
+            sbe::makeE<sbe::EPrimUnary>(sbe::EPrimUnary::logicNot,
+                                        makeFunction("exists", makeVariable(argSlot))),
+            makeFunction("isNull", makeVariable(argSlot)));
+        auto accSlot = addAgg(opName == "$min"_sd ? "min"_sd : "max"_sd,
+                              sbe::makeE<sbe::EIf>(std::move(isNullOrMissing),
+                                                   makeNothingConstant(),
+                                                   makeVariable(argSlot)));
+        lowered.finalExpr = makeFillEmptyNull(makeVariable(accSlot));
+    } else {
+        invariant(opName == "$first"_sd || opName == "$last"_sd);
+        // A missing value is accumulated as null, like the classic $first and $last.
+        auto accSlot = addAgg(opName == "$first"_sd ? "first"_sd : "last"_sd,
+                              makeFillEmptyNull(makeVariable(argSlot)));
+        lowered.finalExpr = makeVariable(accSlot);
+    }
+
+    return lowered;
+}
+
+bool isSupportedArgument(Expression* expr) {
+    if (dynamic_cast<ExpressionConstant*>(expr)) {
+        return true;
+    }
+    auto fieldPath = dynamic_cast<ExpressionFieldPath*>(expr);
+    return fieldPath && fieldPath->isRootFieldPath();
+}
+}  // namespace
+
+bool isGroupPushdownSupported(const PushedDownGroup& group) {
+    static const std::set<StringData> kSupportedAccumulators = {
+        "$sum"_sd, "$avg"_sd, "$min"_sd, "$max"_sd, "$first"_sd, "$last"_sd};
+
+    if (!group.idExpression || !isSupportedArgument(group.idExpression.get())) {
+        return false;
+    }
+
+    for (auto&& acc : group.accumulators) {
+        if (!kSupportedAccumulators.count(acc.expr.factory()->getOpName()) ||
+            !isSupportedArgument(acc.expr.argument.get())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isParallelGroupSupported(const PushedDownGroup& group) {
+    if (!isGroupPushdownSupported(group)) {
+        return false;
+    }
+
+    // The result of $first and $last depends on the order of the input, which is lost once the
+    // input is split between several producers.
+    return std::none_of(group.accumulators.begin(), group.accumulators.end(), [](auto&& acc) {
+        auto opName = StringData{acc.expr.factory()->getOpName()};
+        return opName == "$first"_sd || opName == "$last"_sd;
+    });
+}
+
+std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateGroup(
+    OperationContext* opCtx,
+    const PushedDownGroup& group,
+    std::unique_ptr<sbe::PlanStage> stage,
+    sbe::value::SlotIdGenerator* slotIdGenerator,
+    sbe::value::FrameIdGenerator* frameIdGenerator,
+    sbe::value::SlotId inputVar,
+    sbe::RuntimeEnvironment* env,
+    boost::optional<size_t> memoryLimit,
+    bool allowDiskUse,
+    TrialRunProgressTracker* tracker,
+    size_t degreeOfParallelism,
+    PlanNodeId planNodeId) {
+    invariant(isGroupPushdownSupported(group));
+
+    // Evaluate the group key and every accumulator argument into its own slot. A missing group key
+    // is grouped together with null, as in the classic $group.
+    auto relevantSlots = sbe::makeSV(inputVar);
+    auto evalIntoSlot = [&](Expression* expr, bool fillEmptyNull) {
+        auto [outputSlot, outputExpr, outputStage] = generateExpression(opCtx,
+                                                                        expr,
+                                                                        std::move(stage),
+                                                                        slotIdGenerator,
+                                                                        frameIdGenerator,
+                                                                        inputVar,
+                                                                        env,
+                                                                        planNodeId,
+                                                                        &relevantSlots);
+        stage = sbe::makeProjectStage(std::move(outputStage),
+                                      planNodeId,
+                                      outputSlot,
+                                      fillEmptyNull ? makeFillEmptyNull(std::move(outputExpr))
+                                                    : std::move(outputExpr));
+        relevantSlots.push_back(outputSlot);
+        return outputSlot;
+    };
+
+    auto keySlot = evalIntoSlot(group.idExpression.get(), true);
+
+    std::vector<LoweredAccumulator> lowered;
+    for (auto&& acc : group.accumulators) {
+        auto argSlot = evalIntoSlot(acc.expr.argument.get(), false);
+        lowered.push_back(
+            lowerAccumulator(acc.expr.factory()->getOpName(), argSlot, slotIdGenerator));
+    }
+
+    sbe::value::SlotMap<ExpressionType> aggs;
+    sbe::value::SlotMap<ExpressionType> mergingExprs;
+    if (degreeOfParallelism > 1) {
+        // Every producer of the exchange computes partial aggregates over the part of the input it
+        // has scanned, and the partial aggregates of all producers are then combined per group.
+        invariant(isParallelGroupSupported(group));
+        sbe::value::SlotMap<ExpressionType> partialAggs;
+        sbe::value::SlotMap<ExpressionType> partialMergingExprs;
+        auto exchangeSlots = sbe::makeSV(keySlot);
+        for (auto&& acc : lowered) {
+            for (auto&& [slot, aggName, aggArg] : acc.aggs) {
+                auto partialSlot = slotIdGenerator->generate();
+                partialAggs.emplace(partialSlot, makeFunction(aggName, std::move(aggArg)));
+                partialMergingExprs.emplace(partialSlot,
+                                            makeFunction(aggName, makeVariable(partialSlot)));
+                aggs.emplace(slot, makeFunction(aggName, makeVariable(partialSlot)));
+                mergingExprs.emplace(slot, makeFunction(aggName, makeVariable(slot)));
+                exchangeSlots.push_back(partialSlot);
+            }
+        }
+
+        stage = sbe::makeS<sbe::HashAggStage>(std::move(stage),
+                                              sbe::makeSV(keySlot),
+                                              std::move(partialAggs),
+                                              std::move(partialMergingExprs),
+                                              memoryLimit,
+                                              allowDiskUse,
+                                              planNodeId);
+        stage = sbe::makeS<sbe::ExchangeConsumer>(std::move(stage),
+                                                  degreeOfParallelism,
+                                                  std::move(exchangeSlots),
+                                                  sbe::ExchangePolicy::roundrobin,
+                                                  nullptr,
+                                                  nullptr,
+                                                  planNodeId);
+    } else {
+        for (auto&& acc : lowered) {
+            for (auto&& [slot, aggName, aggArg] : acc.aggs) {
+                aggs.emplace(slot, makeFunction(aggName, std::move(aggArg)));
+                mergingExprs.emplace(slot, makeFunction(aggName, makeVariable(slot)));
+            }
+        }
+    }
+
+    stage = sbe::makeS<sbe::HashAggStage>(std::move(stage),
+                                          sbe::makeSV(keySlot),
+                                          std::move(aggs),
+                                          std::move(mergingExprs),
+                                          memoryLimit,
+                                          allowDiskUse,
+                                          planNodeId,
+                                          tracker);
+
+    // Compute the final value of every accumulator and assemble the output documents.
+    sbe::value::SlotMap<ExpressionType> finalExprs;
+    std::vector<std::string> fields{"_id"};
+    auto fieldSlots = sbe::makeSV(keySlot);
+    for (size_t i = 0; i < lowered.size(); ++i) {
+        auto slot = slotIdGenerator->generate();
+        finalExprs.emplace(slot, std::move(lowered[i].finalExpr));
+        fields.push_back(group.accumulators[i].fieldName);
+        fieldSlots.push_back(slot);
+    }
+    if (!finalExprs.empty()) {
+        stage = sbe::makeS<sbe::ProjectStage>(std::move(stage), std::move(finalExprs), planNodeId);
+    }
+
+    auto resultSlot = slotIdGenerator->generate();
+    stage = sbe::makeS<sbe::MakeObjStage>(std::move(stage),
+                                          resultSlot,
+                                          boost::none,
+                                          std::vector<std::string>{},
+                                          std::move(fields),
+                                          std::move(fieldSlots),
+                                          true,
+                                          false,
+                                          planNodeId);
+
+    return {resultSlot, std::move(stage)};
+}
+}  // namespace mongo::stage_builder
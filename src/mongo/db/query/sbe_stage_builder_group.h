@@ -0,0 +1,82 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include "mongo/db/exec/sbe/expressions/expression.h"
+#include "mongo/db/exec/sbe/stages/stages.h"
+#include "mongo/db/exec/sbe/values/value.h"
+#include "mongo/db/exec/trial_run_progress_tracker.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/canonical_query.h"
+
+namespace mongo::stage_builder {
+/**
+ * Returns true if the given $group can be lowered into an SBE HashAggStage by 'generateGroup()'.
+ * Only a single '_id' expression and the $sum, $avg, $min, $max, $first and $last accumulators
+ * over constants or paths rooted at the current document are currently supported.
+ */
+bool isGroupPushdownSupported(const PushedDownGroup& group);
+
+/**
+ * Returns true if the given $group can be computed by 'generateGroup()' with a degree of
+ * parallelism greater than one, which requires that its result does not depend on the order of
+ * its input.
+ */
+bool isParallelGroupSupported(const PushedDownGroup& group);
+
+/**
+ * Generates an SBE plan stage sub-tree implementing the given $group on top of the 'stage' input.
+ * The 'inputVar' defines a variable to read the input document from. Returns a slot holding the
+ * output documents of the group, each of which has an '_id' field followed by the accumulated
+ * fields in their original order.
+ *
+ * The 'tracker', if provided, is passed to the HashAggStage so that the trial run of the runtime
+ * planner can be stopped while the stage is still consuming its input.
+ *
+ * If 'degreeOfParallelism' is greater than one, the 'stage' input must be safe to run as that many
+ * exchange producers at once, e.g. built around a ParallelScanStage. Each producer then computes
+ * partial aggregates which are combined by a final HashAggStage above the exchange.
+ */
+std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateGroup(
+    OperationContext* opCtx,
+    const PushedDownGroup& group,
+    std::unique_ptr<sbe::PlanStage> stage,
+    sbe::value::SlotIdGenerator* slotIdGenerator,
+    sbe::value::FrameIdGenerator* frameIdGenerator,
+    sbe::value::SlotId inputVar,
+    sbe::RuntimeEnvironment* env,
+    boost::optional<size_t> memoryLimit,
+    bool allowDiskUse,
+    TrialRunProgressTracker* tracker,
+    size_t degreeOfParallelism,
+    PlanNodeId planNodeId);
+
+}  // namespace mongo::stage_builder
@@ -190,6 +190,28 @@ std::vector<std::pair<BSONObj, BSONObj>> decomposeIntoSingleIntervals(
     return {keysQueue.begin(), keysQueue.end()};
 }
 
+/**
+ * Constructs the KeyStrings to seek to for the given low and high keys of an index scan interval.
+ */
+std::pair<std::unique_ptr<KeyString::Value>, std::unique_ptr<KeyString::Value>> makeKeyStrings(
+    const BSONObj& lowKey,
+    bool lowKeyInclusive,
+    const BSONObj& highKey,
+    bool highKeyInclusive,
+    bool forward,
+    KeyString::Version version,
+    Ordering ordering) {
+    // For high keys use the opposite rule as a normal seek because a forward scan should end
+    // after the key if inclusive, and before if exclusive.
+    const auto inclusive = forward != highKeyInclusive;
+    return {std::make_unique<KeyString::Value>(
+                IndexEntryComparison::makeKeyStringFromBSONKeyForSeek(
+                    lowKey, version, ordering, forward, lowKeyInclusive)),
+            std::make_unique<KeyString::Value>(
+                IndexEntryComparison::makeKeyStringFromBSONKeyForSeek(
+                    highKey, version, ordering, forward, inclusive))};
+}
+
 /**
  * Constructs low/high key values from the given index 'bounds if they can be represented either as
  * a single interval between the low and high keys, or multiple single intervals. If index bounds
@@ -228,19 +250,133 @@ makeIntervalsFromIndexBounds(const IndexBounds& bounds,
                     "Generated interval [lowKey, highKey]",
                     "lowKey"_attr = lowKey,
                     "highKey"_attr = highKey);
-        // For high keys use the opposite rule as a normal seek because a forward scan should end
-        // after the key if inclusive, and before if exclusive.
-        const auto inclusive = forward != highKeyInclusive;
-        result.push_back({std::make_unique<KeyString::Value>(
-                              IndexEntryComparison::makeKeyStringFromBSONKeyForSeek(
-                                  lowKey, version, ordering, forward, lowKeyInclusive)),
-                          std::make_unique<KeyString::Value>(
-                              IndexEntryComparison::makeKeyStringFromBSONKeyForSeek(
-                                  highKey, version, ordering, forward, inclusive))});
+        result.push_back(makeKeyStrings(
+            lowKey, lowKeyInclusive, highKey, highKeyInclusive, forward, version, ordering));
     }
     return result;
 }
 
+/**
+ * Builds the binding of the low and high keys of an index scan to the input parameters whose
+ * constants are the point intervals of the index fields at the positions in 'inputParamFields'.
+ * Returns boost::none if the bounds of the scan do not form a single interval, or if the bounds of
+ * any of these fields are not just the point of the constant, as with hashed or collated indexes.
+ */
+boost::optional<IndexBoundsBinding> makeIndexBoundsBinding(
+    const IndexScanNode* ixn,
+    const std::vector<std::pair<size_t, MatchExpression::InputParamId>>& inputParamFields,
+    KeyString::Version version,
+    Ordering ordering) {
+    const auto& bounds = ixn->bounds;
+    if (ixn->index.type != INDEX_BTREE || ixn->index.collator || bounds.isSimpleRange) {
+        return boost::none;
+    }
+
+    for (auto&& [fieldNo, paramId] : inputParamFields) {
+        if (fieldNo >= bounds.fields.size() || bounds.fields[fieldNo].intervals.size() != 1 ||
+            !bounds.fields[fieldNo].intervals[0].isPoint()) {
+            return boost::none;
+        }
+    }
+
+    IndexBoundsBinding binding;
+    if (!IndexBoundsBuilder::isSingleInterval(bounds,
+                                              &binding.lowKey,
+                                              &binding.lowKeyInclusive,
+                                              &binding.highKey,
+                                              &binding.highKeyInclusive)) {
+        return boost::none;
+    }
+
+    binding.inputParamFields = inputParamFields;
+    binding.forward = ixn->direction == 1;
+    binding.version = version;
+    binding.ordering = ordering;
+    return binding;
+}
+
+/**
+ * Returns a copy of 'key' in which the fields at the positions in 'inputParamFields' are replaced
+ * by the constants of the corresponding input parameters.
+ */
+BSONObj bindKey(
+    const BSONObj& key,
+    const std::vector<std::pair<size_t, MatchExpression::InputParamId>>& inputParamFields,
+    const std::vector<BSONElement>& inputParams) {
+    std::vector<BSONElement> elems;
+    key.elems(elems);
+    for (auto&& [fieldNo, paramId] : inputParamFields) {
+        invariant(fieldNo < elems.size());
+        invariant(static_cast<size_t>(paramId) < inputParams.size());
+        elems[fieldNo] = inputParams[paramId];
+    }
+
+    BSONObjBuilder bob;
+    for (auto&& elem : elems) {
+        bob.appendAs(elem, ""_sd);
+    }
+    return bob.obj();
+}
+
+/**
+ * Constructs a single-interval index scan, as 'generateSingleIntervalIndexScan()' does, which
+ * seeks to the keys computed by the 'lowKeyExpr' and 'highKeyExpr' expressions.
+ */
+std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateSingleIntervalIndexScan(
+    const CollectionPtr& collection,
+    const std::string& indexName,
+    bool forward,
+    std::unique_ptr<sbe::EExpression> lowKeyExpr,
+    std::unique_ptr<sbe::EExpression> highKeyExpr,
+    sbe::IndexKeysInclusionSet indexKeysToInclude,
+    sbe::value::SlotVector vars,
+    boost::optional<sbe::value::SlotId> recordSlot,
+    sbe::value::SlotIdGenerator* slotIdGenerator,
+    PlanYieldPolicy* yieldPolicy,
+    TrialRunProgressTracker* tracker,
+    PlanNodeId planNodeId) {
+    auto recordIdSlot = slotIdGenerator->generate();
+    auto lowKeySlot = slotIdGenerator->generate();
+    auto highKeySlot = slotIdGenerator->generate();
+
+    // Construct a constant table scan to deliver a single row with two fields 'lowKeySlot' and
+    // 'highKeySlot', representing seek boundaries, into the index scan.
+    auto project = sbe::makeProjectStage(
+        sbe::makeS<sbe::LimitSkipStage>(
+            sbe::makeS<sbe::CoScanStage>(planNodeId), 1, boost::none, planNodeId),
+        planNodeId,
+        lowKeySlot,
+        std::move(lowKeyExpr),
+        highKeySlot,
+        std::move(highKeyExpr));
+
+    // Scan the index in the range {'lowKeySlot', 'highKeySlot'} (subject to inclusive or
+    // exclusive boundaries), and produce a single field recordIdSlot that can be used to
+    // position into the collection.
+    auto ixscan = sbe::makeS<sbe::IndexScanStage>(
+        NamespaceStringOrUUID{collection->ns().db().toString(), collection->uuid()},
+        indexName,
+        forward,
+        recordSlot,
+        recordIdSlot,
+        indexKeysToInclude,
+        std::move(vars),
+        lowKeySlot,
+        highKeySlot,
+        yieldPolicy,
+        tracker,
+        planNodeId);
+
+    // Finally, get the keys from the outer side and feed them to the inner side.
+    return {recordIdSlot,
+            sbe::makeS<sbe::LoopJoinStage>(std::move(project),
+                                           std::move(ixscan),
+                                           sbe::makeSV(),
+                                           sbe::makeSV(lowKeySlot, highKeySlot),
+                                           nullptr,
+                                           planNodeId)};
+}
+
 /**
  * Constructs an optimized version of an index scan for multi-interval index bounds for the case
  * when the bounds can be decomposed in a number of single-interval bounds. In this case, instead
@@ -626,58 +762,33 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateSingleInt
     PlanYieldPolicy* yieldPolicy,
     TrialRunProgressTracker* tracker,
     PlanNodeId planNodeId) {
-    auto recordIdSlot = slotIdGenerator->generate();
-    auto lowKeySlot = slotIdGenerator->generate();
-    auto highKeySlot = slotIdGenerator->generate();
-
-    // Construct a constant table scan to deliver a single row with two fields 'lowKeySlot' and
-    // 'highKeySlot', representing seek boundaries, into the index scan.
-    auto project = sbe::makeProjectStage(
-        sbe::makeS<sbe::LimitSkipStage>(
-            sbe::makeS<sbe::CoScanStage>(planNodeId), 1, boost::none, planNodeId),
-        planNodeId,
-        lowKeySlot,
+    return generateSingleIntervalIndexScan(
+        collection,
+        indexName,
+        forward,
         sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::ksValue,
                                    sbe::value::bitcastFrom(lowKey.release())),
-        highKeySlot,
         sbe::makeE<sbe::EConstant>(sbe::value::TypeTags::ksValue,
-                                   sbe::value::bitcastFrom(highKey.release())));
-
-    // Scan the index in the range {'lowKeySlot', 'highKeySlot'} (subject to inclusive or
-    // exclusive boundaries), and produce a single field recordIdSlot that can be used to
-    // position into the collection.
-    auto ixscan = sbe::makeS<sbe::IndexScanStage>(
-        NamespaceStringOrUUID{collection->ns().db().toString(), collection->uuid()},
-        indexName,
-        forward,
-        recordSlot,
-        recordIdSlot,
+                                   sbe::value::bitcastFrom(highKey.release())),
         indexKeysToInclude,
         std::move(vars),
-        lowKeySlot,
-        highKeySlot,
+        recordSlot,
+        slotIdGenerator,
         yieldPolicy,
         tracker,
         planNodeId);
-
-    // Finally, get the keys from the outer side and feed them to the inner side.
-    return {recordIdSlot,
-            sbe::makeS<sbe::LoopJoinStage>(std::move(project),
-                                           std::move(ixscan),
-                                           sbe::makeSV(),
-                                           sbe::makeSV(lowKeySlot, highKeySlot),
-                                           nullptr,
-                                           planNodeId)};
 }
 
-
-std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan(
+std::tuple<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>, boost::optional<IndexBoundsBinding>>
+generateIndexScan(
     OperationContext* opCtx,
     const CollectionPtr& collection,
     const IndexScanNode* ixn,
+    const std::vector<std::pair<size_t, MatchExpression::InputParamId>>& inputParamFields,
     boost::optional<sbe::value::SlotId> returnKeySlot,
     sbe::value::SlotIdGenerator* slotIdGenerator,
     sbe::value::SpoolIdGenerator* spoolIdGenerator,
+    sbe::RuntimeEnvironment* env,
     PlanYieldPolicy* yieldPolicy,
     TrialRunProgressTracker* tracker) {
     invariant(returnKeySlot || !ixn->addKeyMetadata);
@@ -686,11 +797,21 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
     auto descriptor =
         collection->getIndexCatalog()->findIndexByName(opCtx, ixn->index.identifier.catalogName);
     auto accessMethod = collection->getIndexCatalog()->getEntry(descriptor)->accessMethod();
-    auto intervals =
-        makeIntervalsFromIndexBounds(ixn->bounds,
-                                     ixn->direction == 1,
-                                     accessMethod->getSortedDataInterface()->getKeyStringVersion(),
-                                     accessMethod->getSortedDataInterface()->getOrdering());
+    auto version = accessMethod->getSortedDataInterface()->getKeyStringVersion();
+    auto ordering = accessMethod->getSortedDataInterface()->getOrdering();
+
+    boost::optional<IndexBoundsBinding> indexBoundsBinding;
+    if (!inputParamFields.empty()) {
+        indexBoundsBinding = makeIndexBoundsBinding(ixn, inputParamFields, version, ordering);
+    }
+
+    // The keys of a scan bound to input parameters are built from the binding instead.
+    std::vector<std::pair<std::unique_ptr<KeyString::Value>, std::unique_ptr<KeyString::Value>>>
+        intervals;
+    if (!indexBoundsBinding) {
+        intervals =
+            makeIntervalsFromIndexBounds(ixn->bounds, ixn->direction == 1, version, ordering);
+    }
 
 
     auto [returnKeyExpr, vars, indexKeysToInclude] =
@@ -726,7 +847,42 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
 
     auto [slot,
           stage] = [&, vars = std::ref(vars), indexKeysToInclude = std::ref(indexKeysToInclude)]() {
-        if (intervals.size() == 1) {
+        if (indexBoundsBinding) {
+            // The keys of a scan bound to input parameters are read from the runtime environment,
+            // so that they can be reset for other constants.
+            auto&& [lowKey, highKey] = makeKeyStrings(indexBoundsBinding->lowKey,
+                                                      indexBoundsBinding->lowKeyInclusive,
+                                                      indexBoundsBinding->highKey,
+                                                      indexBoundsBinding->highKeyInclusive,
+                                                      indexBoundsBinding->forward,
+                                                      version,
+                                                      ordering);
+            indexBoundsBinding->lowKeySlot =
+                env->registerSlot(str::stream() << "indexBoundsLowKey" << ixn->nodeId(),
+                                  sbe::value::TypeTags::ksValue,
+                                  sbe::value::bitcastFrom(lowKey.release()),
+                                  true,
+                                  slotIdGenerator);
+            indexBoundsBinding->highKeySlot =
+                env->registerSlot(str::stream() << "indexBoundsHighKey" << ixn->nodeId(),
+                                  sbe::value::TypeTags::ksValue,
+                                  sbe::value::bitcastFrom(highKey.release()),
+                                  true,
+                                  slotIdGenerator);
+            return generateSingleIntervalIndexScan(
+                collection,
+                ixn->index.identifier.catalogName,
+                ixn->direction == 1,
+                sbe::makeE<sbe::EVariable>(indexBoundsBinding->lowKeySlot),
+                sbe::makeE<sbe::EVariable>(indexBoundsBinding->highKeySlot),
+                indexKeysToInclude,
+                vars,
+                boost::none,  // recordSlot
+                slotIdGenerator,
+                yieldPolicy,
+                tracker,
+                ixn->nodeId());
+        } else if (intervals.size() == 1) {
             // If we have just a single interval, we can construct a simplified sub-tree.
             auto&& [lowKey, highKey] = intervals[0];
             return generateSingleIntervalIndexScan(collection,
@@ -760,8 +916,8 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
             return generateGenericMultiIntervalIndexScan(
                 collection,
                 ixn,
-                accessMethod->getSortedDataInterface()->getKeyStringVersion(),
-                accessMethod->getSortedDataInterface()->getOrdering(),
+                version,
+                ordering,
                 indexKeysToInclude,
                 vars,
                 slotIdGenerator,
@@ -779,8 +935,13 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
                  sbe::makeE<sbe::EFunction>("first",
                                             sbe::makeEs(sbe::makeE<sbe::EVariable>(varSlot)))});
         }
-        stage = sbe::makeS<sbe::HashAggStage>(
-            std::move(stage), sbe::makeSV(slot), std::move(forwardedVarSlots), ixn->nodeId());
+        stage = sbe::makeS<sbe::HashAggStage>(std::move(stage),
+                                              sbe::makeSV(slot),
+                                              std::move(forwardedVarSlots),
+                                              sbe::makeEM(),
+                                              boost::none,
+                                              false,
+                                              ixn->nodeId());
     }
 
     if (returnKeyExpr) {
@@ -788,6 +949,27 @@ std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan
             std::move(stage), ixn->nodeId(), *returnKeySlot, std::move(returnKeyExpr));
     }
 
-    return {slot, std::move(stage)};
+    return {slot, std::move(stage), std::move(indexBoundsBinding)};
+}
+
+void bindIndexBounds(const IndexBoundsBinding& binding,
+                     const std::vector<BSONElement>& inputParams,
+                     sbe::RuntimeEnvironment* env) {
+    auto [lowKey, highKey] =
+        makeKeyStrings(bindKey(binding.lowKey, binding.inputParamFields, inputParams),
+                       binding.lowKeyInclusive,
+                       bindKey(binding.highKey, binding.inputParamFields, inputParams),
+                       binding.highKeyInclusive,
+                       binding.forward,
+                       binding.version,
+                       binding.ordering);
+    env->resetSlot(binding.lowKeySlot,
+                   sbe::value::TypeTags::ksValue,
+                   sbe::value::bitcastFrom(lowKey.release()),
+                   true);
+    env->resetSlot(binding.highKeySlot,
+                   sbe::value::TypeTags::ksValue,
+                   sbe::value::bitcastFrom(highKey.release()),
+                   true);
 }
 }  // namespace mongo::stage_builder
@@ -29,25 +29,69 @@
 
 #pragma once
 
+#include "mongo/bson/ordering.h"
+#include "mongo/db/exec/sbe/expressions/expression.h"
 #include "mongo/db/exec/sbe/stages/stages.h"
 #include "mongo/db/exec/sbe/values/value.h"
 #include "mongo/db/exec/trial_run_progress_tracker.h"
+#include "mongo/db/matcher/expression.h"
 #include "mongo/db/query/query_solution.h"
+#include "mongo/db/storage/key_string.h"
 
 namespace mongo::stage_builder {
+/**
+ * Describes how the low and high keys of a single-interval index scan are derived from the input
+ * parameters of a query, so that the scan can be rebound to the constants of another query of the
+ * same shape.
+ */
+struct IndexBoundsBinding {
+    // The runtime environment slots holding the low and high KeyStrings of the scan.
+    sbe::value::SlotId lowKeySlot;
+    sbe::value::SlotId highKeySlot;
+
+    // The BSON low and high keys the scan was built with. The fields at the positions listed in
+    // 'inputParamFields' are the point intervals of the constants of the given input parameters.
+    BSONObj lowKey;
+    BSONObj highKey;
+    std::vector<std::pair<size_t, MatchExpression::InputParamId>> inputParamFields;
+
+    bool lowKeyInclusive{true};
+    bool highKeyInclusive{true};
+    bool forward{true};
+    KeyString::Version version{KeyString::Version::kLatestVersion};
+    Ordering ordering{Ordering::allAscending()};
+};
+
 /**
  * Generates an SBE plan stage sub-tree implementing an index scan.
+ *
+ * 'inputParamFields' lists the positions of the index key fields whose bounds are the point
+ * interval of the constant of an input parameter. If it is not empty and the bounds of the scan
+ * form a single interval, then the scan reads its low and high keys from slots registered in 'env',
+ * and a binding to recompute them for other constants is returned. Otherwise, the constants are
+ * baked into the scan, and no binding is returned.
  */
-std::pair<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>> generateIndexScan(
+std::tuple<sbe::value::SlotId, std::unique_ptr<sbe::PlanStage>, boost::optional<IndexBoundsBinding>>
+generateIndexScan(
     OperationContext* opCtx,
     const CollectionPtr& collection,
     const IndexScanNode* ixn,
+    const std::vector<std::pair<size_t, MatchExpression::InputParamId>>& inputParamFields,
     boost::optional<sbe::value::SlotId> returnKeySlot,
     sbe::value::SlotIdGenerator* slotIdGenerator,
     sbe::value::SpoolIdGenerator* spoolIdGenerator,
+    sbe::RuntimeEnvironment* env,
     PlanYieldPolicy* yieldPolicy,
     TrialRunProgressTracker* tracker);
 
+/**
+ * Resets the low and high key slots of the index scan described by 'binding' in 'env' to the keys
+ * for the given input parameters, indexed by input parameter id.
+ */
+void bindIndexBounds(const IndexBoundsBinding& binding,
+                     const std::vector<BSONElement>& inputParams,
+                     sbe::RuntimeEnvironment* env);
+
 /**
  * Constructs the most simple version of an index scan from the single interval index bounds. The
  * generated subtree will have the following form:
@@ -32,6 +32,9 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/base/string_data.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/client/dbclient_connection.h"
+#include "mongo/db/client.h"
 #include "mongo/db/commands/list_collections_filter.h"
 #include "mongo/db/index_build_entry_helpers.h"
 #include "mongo/db/index_builds_coordinator.h"
@@ -39,9 +42,13 @@
 #include "mongo/db/repl/collection_cloner.h"
 #include "mongo/db/repl/database_cloner_gen.h"
 #include "mongo/db/repl/repl_server_parameters_gen.h"
+#include "mongo/db/repl/replication_auth.h"
 #include "mongo/db/wire_version.h"
 #include "mongo/logv2/log.h"
+#include "mongo/rpc/get_status_from_command_result.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace repl {
@@ -94,6 +101,8 @@ CollectionCloner::CollectionCloner(const NamespaceString& sourceNss,
           _dbWorkTaskRunner.schedule(std::move(task));
           return executor::TaskExecutor::CallbackHandle();
       }),
+      _createClientFn(
+          [] { return std::make_unique<DBClientConnection>(true /* autoReconnect */); }),
       _dbWorkTaskRunner(dbPool) {
     invariant(sourceNss.isValid());
     invariant(collectionOptions.uuid);
@@ -216,7 +225,19 @@ BaseCloner::AfterStageBehavior CollectionCloner::createCollectionStage() {
 }
 
 BaseCloner::AfterStageBehavior CollectionCloner::queryStage() {
-    runQuery();
+    if (!_rangesChosen) {
+        auto numRanges = getNumRangesToClone();
+        if (numRanges > 1) {
+            setUpRanges(numRanges);
+        }
+        _rangesChosen = true;
+    }
+
+    if (getStats().ranges.empty()) {
+        runQuery();
+    } else {
+        runRangeQueries();
+    }
     waitForDatabaseWorkToComplete();
     // We want to free the _collLoader regardless of whether the commit succeeds.
     std::unique_ptr<CollectionBulkLoader> loader = std::move(_collLoader);
@@ -351,17 +372,49 @@ void CollectionCloner::runQuery() {
     }
 }
 
-void CollectionCloner::handleNextBatch(DBClientCursorBatchIterator& iter) {
-    {
-        stdx::lock_guard<InitialSyncSharedData> lk(*getSharedData());
-        if (!getSharedData()->getStatus(lk).isOK()) {
-            static constexpr char message[] =
-                "Collection cloning cancelled due to initial sync failure";
-            LOGV2(21136, message, "error"_attr = getSharedData()->getStatus(lk));
-            uasserted(ErrorCodes::CallbackCanceled,
-                      str::stream() << message << ": " << getSharedData()->getStatus(lk));
+void CollectionCloner::uassertInitialSyncNotFailed() {
+    stdx::lock_guard<InitialSyncSharedData> lk(*getSharedData());
+    if (!getSharedData()->getStatus(lk).isOK()) {
+        static constexpr char message[] = "Collection cloning cancelled due to initial sync failure";
+        LOGV2(21136, message, "error"_attr = getSharedData()->getStatus(lk));
+        uasserted(ErrorCodes::CallbackCanceled,
+                  str::stream() << message << ": " << getSharedData()->getStatus(lk));
+    }
+}
+
+void CollectionCloner::scheduleInsertDocuments() {
+    auto&& scheduleResult = _scheduleDbWorkFn(
+        [=](const executor::TaskExecutor::CallbackArgs& cbd) { insertDocumentsCallback(cbd); });
+
+    if (!scheduleResult.isOK()) {
+        Status newStatus = scheduleResult.getStatus().withContext(
+            str::stream() << "Error cloning collection '" << _sourceNss.ns() << "'");
+        // We must throw an exception to terminate query.
+        uassertStatusOK(newStatus);
+    }
+}
+
+void CollectionCloner::waitForInsertsToCatchUp() {
+    const auto maxBytes = static_cast<size_t>(initialSyncCollectionClonerMaxBufferedBytes.load());
+    stdx::unique_lock<Latch> lk(_mutex);
+    while (_bufferedBytes >= maxBytes) {
+        // A failed insert leaves its documents counted, so failures are checked for periodically.
+        _insertFinishedCond.wait_for(lk, Milliseconds(100).toSystemDuration());
+        if (_bufferedBytes < maxBytes) {
+            break;
         }
+
+        lk.unlock();
+        uassertInitialSyncNotFailed();
+        uassert(ErrorCodes::CallbackCanceled,
+                "Fetching collection range cancelled because fetching another range failed",
+                !_rangeQueryFailed.load());
+        lk.lock();
     }
+}
+
+void CollectionCloner::handleNextBatch(DBClientCursorBatchIterator& iter) {
+    uassertInitialSyncNotFailed();
 
     // If this is 'true', it means that something happened to our remote cursor for a reason other
     // than the collection being dropped, all while we were running a non-resumable (4.2) clone.
@@ -382,19 +435,13 @@ void CollectionCloner::handleNextBatch(DBClientCursorBatchIterator& iter) {
         _stats.receivedBatches++;
         while (iter.moreInCurrentBatch()) {
             _documentsToInsert.emplace_back(iter.nextSafe());
+            _bufferedBytes += _documentsToInsert.back().objsize();
         }
     }
 
     // Schedule the next document batch insertion.
-    auto&& scheduleResult = _scheduleDbWorkFn(
-        [=](const executor::TaskExecutor::CallbackArgs& cbd) { insertDocumentsCallback(cbd); });
-
-    if (!scheduleResult.isOK()) {
-        Status newStatus = scheduleResult.getStatus().withContext(
-            str::stream() << "Error cloning collection '" << _sourceNss.ns() << "'");
-        // We must throw an exception to terminate query.
-        uassertStatusOK(newStatus);
-    }
+    scheduleInsertDocuments();
+    waitForInsertsToCatchUp();
 
     if (_resumeSupported) {
         // Store the resume token for this batch.
@@ -422,30 +469,285 @@ void CollectionCloner::handleNextBatch(DBClientCursorBatchIterator& iter) {
         });
 }
 
+size_t CollectionCloner::getNumRangesToClone() const {
+    // Ranges are fetched with an '_id' index scan bounded by 'min' and 'max', which is only
+    // equivalent to a collection scan when the index compares '_id' values with the simple
+    // collation. Capped collections must be cloned in their natural order.
+    if (_idIndexSpec.isEmpty() || _idIndexSpec.hasField("collation") ||
+        !_collectionOptions.collation.isEmpty() || _collectionOptions.capped) {
+        return 1;
+    }
+
+    const auto maxRanges = static_cast<size_t>(initialSyncCollectionClonerMaxRanges.load());
+    const auto minDocsPerRange =
+        static_cast<size_t>(initialSyncCollectionClonerMinDocumentsPerRange.load());
+    return std::max<size_t>(1, std::min(maxRanges, getStats().documentToCopy / minDocsPerRange));
+}
+
+std::vector<BSONObj> CollectionCloner::chooseRangeBoundaries(std::vector<BSONObj> sampledIds,
+                                                             size_t numRanges) {
+    const auto& comparator = SimpleBSONObjComparator::kInstance;
+    std::sort(sampledIds.begin(), sampledIds.end(), comparator.makeLessThan());
+
+    std::vector<BSONObj> boundaries;
+    for (size_t i = 1; i < numRanges; ++i) {
+        auto pos = i * sampledIds.size() / numRanges;
+        if (pos == 0 || pos >= sampledIds.size()) {
+            continue;
+        }
+        if (boundaries.empty() || comparator.evaluate(boundaries.back() < sampledIds[pos])) {
+            boundaries.push_back(sampledIds[pos].getOwned());
+        }
+    }
+    return boundaries;
+}
+
+void CollectionCloner::setUpRanges(size_t numRanges) {
+    // Oversample so that the ranges come out close to equal in size.
+    const int sampleSize = numRanges * 32;
+    BSONObj res;
+    getClient()->runCommand(
+        _sourceNss.db().toString(),
+        BSON("aggregate" << _sourceNss.coll() << "pipeline"
+                         << BSON_ARRAY(BSON("$sample" << BSON("size" << sampleSize))
+                                       << BSON("$project" << BSON("_id" << 1)))
+                         << "cursor" << BSON("batchSize" << sampleSize)),
+        res,
+        QueryOption_SlaveOk);
+    uassertStatusOK(getStatusFromCommandResult(res));
+
+    std::vector<BSONObj> sampledIds;
+    for (auto&& elem : res["cursor"]["firstBatch"].Array()) {
+        sampledIds.push_back(elem.Obj().getOwned());
+    }
+
+    auto boundaries = chooseRangeBoundaries(std::move(sampledIds), numRanges);
+    if (boundaries.empty()) {
+        return;
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    BSONObj min;
+    for (auto&& boundary : boundaries) {
+        _stats.ranges.push_back({min, boundary});
+        min = boundary;
+    }
+    _stats.ranges.push_back({min, BSONObj()});
+    _rangeLastIds.resize(_stats.ranges.size());
+
+    LOGV2(5150807,
+          "Collection cloner will fetch the collection in ranges",
+          "namespace"_attr = _sourceNss,
+          "numRanges"_attr = _stats.ranges.size());
+}
+
+void CollectionCloner::runRangeQueries() {
+    std::vector<size_t> rangesToFetch;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        for (size_t i = 0; i < _stats.ranges.size(); ++i) {
+            if (!_stats.ranges[i].done) {
+                rangesToFetch.push_back(i);
+            }
+        }
+    }
+
+    _rangeQueryFailed.store(false);
+    std::vector<Status> statuses(rangesToFetch.size(), Status::OK());
+
+    ThreadPool::Options options;
+    options.poolName = "CollectionClonerRanges";
+    options.threadNamePrefix = "CollectionClonerRange-";
+    options.minThreads = 0;
+    options.maxThreads = rangesToFetch.size();
+    options.onCreateThread = [](const std::string& name) { Client::initThread(name); };
+    ThreadPool pool(options);
+    pool.startup();
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _numRangeQueriesRunning = rangesToFetch.size();
+    }
+    for (size_t i = 0; i < rangesToFetch.size(); ++i) {
+        pool.schedule([this, i, rangeIndex = rangesToFetch[i], &statuses](Status status) {
+            if (status.isOK()) {
+                try {
+                    runRangeQuery(rangeIndex);
+                } catch (const DBException& e) {
+                    status = e.toStatus();
+                }
+            }
+
+            stdx::lock_guard<Latch> lk(_mutex);
+            statuses[i] = std::move(status);
+            if (!statuses[i].isOK() && !_rangeQueryFailed.swap(true)) {
+                stopRangeQueries(lk);
+            }
+            if (--_numRangeQueriesRunning == 0) {
+                _rangeQueriesDoneCond.notify_all();
+            }
+        });
+    }
+
+    // Initial sync failing, for instance because the initial syncer is shut down, does not wake
+    // up this thread, so it is checked for periodically.
+    stdx::unique_lock<Latch> lk(_mutex);
+    while (_numRangeQueriesRunning > 0) {
+        _rangeQueriesDoneCond.wait_for(lk, Milliseconds(100).toSystemDuration());
+        if (_numRangeQueriesRunning == 0 || _rangeQueryFailed.load()) {
+            continue;
+        }
+
+        lk.unlock();
+        const bool stop = mustExit();
+        lk.lock();
+        if (stop && !_rangeQueryFailed.swap(true)) {
+            stopRangeQueries(lk);
+        }
+    }
+    lk.unlock();
+
+    pool.shutdown();
+    pool.join();
+
+    // Errors other than the one which stopped the other ranges early are more interesting.
+    auto it = std::find_if(statuses.begin(), statuses.end(), [](auto&& status) {
+        return !status.isOK() && status != ErrorCodes::CallbackCanceled;
+    });
+    if (it == statuses.end()) {
+        it = std::find_if(
+            statuses.begin(), statuses.end(), [](auto&& status) { return !status.isOK(); });
+    }
+    if (it != statuses.end()) {
+        uassertStatusOK(*it);
+    }
+}
+
+void CollectionCloner::stopRangeQueries(WithLock) {
+    for (auto client : _rangeClients) {
+        client->shutdownAndDisallowReconnect();
+    }
+}
+
+void CollectionCloner::runRangeQuery(size_t rangeIndex) {
+    auto client = _createClientFn();
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        uassert(ErrorCodes::CallbackCanceled,
+                "Fetching collection range cancelled before it started",
+                !_rangeQueryFailed.load());
+        _rangeClients.push_back(client.get());
+    }
+    ON_BLOCK_EXIT([&] {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _rangeClients.erase(std::find(_rangeClients.begin(), _rangeClients.end(), client.get()));
+    });
+
+    uassertStatusOK(client->connect(getSource(), StringData()));
+    uassertStatusOK(replAuthenticate(client.get())
+                        .withContext(str::stream() << "Failed to authenticate to " << getSource()));
+
+    // If a previous attempt fetched part of the range, resume from the last '_id' it fetched. That
+    // document is returned again, and is skipped by handleNextRangeBatch().
+    Query query;
+    query.hint(BSON("_id" << 1));
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        const auto& range = _stats.ranges[rangeIndex];
+        const auto& min = _rangeLastIds[rangeIndex].isEmpty() ? range.min
+                                                              : _rangeLastIds[rangeIndex];
+        if (!min.isEmpty()) {
+            query.minKey(min);
+        }
+        if (!range.max.isEmpty()) {
+            query.maxKey(range.max);
+        }
+    }
+
+    client->query(
+        [this, rangeIndex](DBClientCursorBatchIterator& iter) {
+            handleNextRangeBatch(rangeIndex, iter);
+        },
+        _sourceDbAndUuid,
+        query,
+        nullptr /* fieldsToReturn */,
+        QueryOption_NoCursorTimeout | QueryOption_SlaveOk |
+            (collectionClonerUsesExhaust ? QueryOption_Exhaust : 0),
+        _collectionClonerBatchSize,
+        ReadConcernArgs::kImplicitDefault);
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _stats.ranges[rangeIndex].done = true;
+}
+
+void CollectionCloner::handleNextRangeBatch(size_t rangeIndex, DBClientCursorBatchIterator& iter) {
+    uassertInitialSyncNotFailed();
+    uassert(ErrorCodes::CallbackCanceled,
+            "Fetching collection range cancelled because fetching another range failed",
+            !_rangeQueryFailed.load());
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        auto& range = _stats.ranges[rangeIndex];
+        auto& lastId = _rangeLastIds[rangeIndex];
+        _stats.receivedBatches++;
+        range.receivedBatches++;
+        while (iter.moreInCurrentBatch()) {
+            auto doc = iter.nextSafe();
+            auto id = doc["_id"].wrap();
+            if (!lastId.isEmpty() && SimpleBSONObjComparator::kInstance.evaluate(id == lastId)) {
+                continue;
+            }
+            _bufferedBytes += doc.objsize();
+            _documentsToInsert.emplace_back(std::move(doc));
+            range.documentsReceived++;
+            lastId = std::move(id);
+        }
+    }
+
+    scheduleInsertDocuments();
+    waitForInsertsToCatchUp();
+}
+
 void CollectionCloner::insertDocumentsCallback(const executor::TaskExecutor::CallbackArgs& cbd) {
     uassertStatusOK(cbd.status);
 
+    std::vector<BSONObj> docs;
+    size_t docsBytes = 0;
     {
         stdx::lock_guard<Latch> lk(_mutex);
-        std::vector<BSONObj> docs;
         if (_documentsToInsert.size() == 0) {
-            LOGV2_WARNING(21145,
-                          "insertDocumentsCallback, but no documents to insert for ns:{namespace}",
-                          "insertDocumentsCallback, but no documents to insert",
-                          "namespace"_attr = _sourceNss);
+            // An earlier callback inserted the documents of more than one batch, which is expected
+            // whenever fetching gets ahead of inserting.
+            LOGV2_DEBUG(21145,
+                        3,
+                        "insertDocumentsCallback, but no documents to insert for ns:{namespace}",
+                        "insertDocumentsCallback, but no documents to insert",
+                        "namespace"_attr = _sourceNss);
             return;
         }
         _documentsToInsert.swap(docs);
+        for (auto&& doc : docs) {
+            docsBytes += doc.objsize();
+        }
         _stats.documentsCopied += docs.size();
         ++_stats.fetchedBatches;
         _progressMeter.hit(int(docs.size()));
-        invariant(_collLoader);
+    }
 
-        // The insert must be done within the lock, because CollectionBulkLoader is not
-        // thread safe.
+    {
+        // The inserts must be serialized, because CollectionBulkLoader is not thread safe.
+        stdx::lock_guard<Latch> lk(_insertMutex);
+        invariant(_collLoader);
         uassertStatusOK(_collLoader->insertDocuments(docs.cbegin(), docs.cend()));
     }
 
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _bufferedBytes -= docsBytes;
+        _insertFinishedCond.notify_all();
+    }
+
     initialSyncHangDuringCollectionClone.executeIf(
         [&](const BSONObj&) {
             LOGV2(21138,
@@ -500,6 +802,14 @@ BSONObj CollectionCloner::Stats::toBSON() const {
     return bob.obj();
 }
 
+void CollectionCloner::Stats::Range::append(BSONObjBuilder* builder) const {
+    builder->append("min", min.isEmpty() ? BSON("_id" << MINKEY) : min);
+    builder->append("max", max.isEmpty() ? BSON("_id" << MAXKEY) : max);
+    builder->appendNumber("documentsReceived", documentsReceived);
+    builder->appendNumber("receivedBatches", receivedBatches);
+    builder->append("done", done);
+}
+
 void CollectionCloner::Stats::append(BSONObjBuilder* builder) const {
     builder->appendNumber(kDocumentsToCopyFieldName, documentToCopy);
     builder->appendNumber(kDocumentsCopiedFieldName, documentsCopied);
@@ -515,6 +825,13 @@ void CollectionCloner::Stats::append(BSONObjBuilder* builder) const {
         }
     }
     builder->appendNumber("receivedBatches", receivedBatches);
+    if (!ranges.empty()) {
+        BSONArrayBuilder rangesBuilder(builder->subarrayStart("ranges"));
+        for (auto&& range : ranges) {
+            BSONObjBuilder rangeBuilder(rangesBuilder.subobjStart());
+            range.append(&rangeBuilder);
+        }
+    }
 }
 
 }  // namespace repl
@@ -36,6 +36,8 @@
 #include "mongo/db/repl/initial_sync_base_cloner.h"
 #include "mongo/db/repl/initial_sync_shared_data.h"
 #include "mongo/db/repl/task_runner.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/util/progress_meter.h"
 
 namespace mongo {
@@ -52,6 +54,21 @@ public:
         static constexpr StringData kDocumentsToCopyFieldName = "documentsToCopy"_sd;
         static constexpr StringData kDocumentsCopiedFieldName = "documentsCopied"_sd;
 
+        /**
+         * Progress of one of the '_id' ranges that a large collection is split into so that it can
+         * be fetched over several cursors at once. An empty 'min' or 'max' leaves that end of the
+         * range unbounded.
+         */
+        struct Range {
+            BSONObj min;
+            BSONObj max;
+            size_t documentsReceived{0};
+            size_t receivedBatches{0};
+            bool done{false};
+
+            void append(BSONObjBuilder* builder) const;
+        };
+
         std::string ns;
         Date_t start;
         Date_t end;
@@ -60,6 +77,7 @@ public:
         size_t indexes{0};
         size_t fetchedBatches{0};  // This is actually inserted batches.
         size_t receivedBatches{0};
+        std::vector<Range> ranges;
 
         std::string toString() const;
         BSONObj toBSON() const;
@@ -74,6 +92,12 @@ public:
     using ScheduleDbWorkFn = unique_function<StatusWith<executor::TaskExecutor::CallbackHandle>(
         executor::TaskExecutor::CallbackFn)>;
 
+    /**
+     * Type of function to create the additional connections to the sync source which are used to
+     * fetch the ranges of a collection cloned over several cursors.
+     */
+    using CreateClientFn = std::function<std::unique_ptr<DBClientConnection>()>;
+
     CollectionCloner(const NamespaceString& ns,
                      const CollectionOptions& collectionOptions,
                      InitialSyncSharedData* sharedData,
@@ -119,6 +143,24 @@ public:
         _scheduleDbWorkFn = std::move(scheduleDbWorkFn);
     }
 
+    /**
+     * Overrides how connections for fetching collection ranges are created.
+     *
+     * For testing only.
+     */
+    void setCreateClientFn_forTest(CreateClientFn createClientFn) {
+        _createClientFn = std::move(createClientFn);
+    }
+
+    /**
+     * Chooses the '_id' values at which to split a collection into 'numRanges' ranges holding
+     * about the same number of documents, given a random sample of the collection's '_id' values
+     * as '{_id: <value>}' objects. The boundaries are returned in ascending '_id' index order
+     * without duplicates, so there may be fewer than 'numRanges - 1' of them.
+     */
+    static std::vector<BSONObj> chooseRangeBoundaries(std::vector<BSONObj> sampledIds,
+                                                      size_t numRanges);
+
 protected:
     ClonerStages getStages() final;
 
@@ -209,6 +251,61 @@ private:
      */
     void handleNextBatch(DBClientCursorBatchIterator& iter);
 
+    /**
+     * Throws if initial sync has failed, so that an in-progress query stops fetching.
+     */
+    void uassertInitialSyncNotFailed();
+
+    /**
+     * Schedules the documents buffered in '_documentsToInsert' to be inserted.
+     */
+    void scheduleInsertDocuments();
+
+    /**
+     * Waits until the documents fetched and not inserted yet take up less than
+     * 'initialSyncCollectionClonerMaxBufferedBytes', so that fetching can't get arbitrarily far
+     * ahead of inserting. Throws if initial sync or another range query fails meanwhile.
+     */
+    void waitForInsertsToCatchUp();
+
+    /**
+     * Returns the number of '_id' ranges to split the collection into, or 1 if it should be cloned
+     * over a single cursor.
+     */
+    size_t getNumRangesToClone() const;
+
+    /**
+     * Samples the '_id' values of the collection on the source and splits it into up to
+     * 'numRanges' ranges, recorded in '_stats.ranges'.
+     */
+    void setUpRanges(size_t numRanges);
+
+    /**
+     * Fetches all ranges which have not been fetched yet, each over its own connection to the sync
+     * source on a thread of a pool owned by this call. Throws the first error encountered by any of
+     * them. If initial sync fails or one of the ranges fails, the connections of the others are
+     * shut down so that they stop without waiting for their next batch.
+     */
+    void runRangeQueries();
+
+    /**
+     * Shuts down the connections of all ranges being fetched, and makes ranges which have not
+     * connected yet fail as soon as they do.
+     */
+    void stopRangeQueries(WithLock);
+
+    /**
+     * Fetches the range at 'rangeIndex' in '_stats.ranges', starting after the last '_id' fetched
+     * for it by a previous attempt.
+     */
+    void runRangeQuery(size_t rangeIndex);
+
+    /**
+     * Puts the results of a range query batch into the buffer to be inserted, and schedules them
+     * to be inserted.
+     */
+    void handleNextRangeBatch(size_t rangeIndex, DBClientCursorBatchIterator& iter);
+
     /**
      * Called whenever there is a new batch of documents ready from the DBClientConnection.
      *
@@ -256,8 +353,15 @@ private:
     std::unique_ptr<CollectionBulkLoader> _collLoader;  // (X)
     //  Function for scheduling database work using the executor.
     ScheduleDbWorkFn _scheduleDbWorkFn;  // (R)
+    // Function for creating connections to fetch collection ranges.
+    CreateClientFn _createClientFn;  // (R)
     // Documents read from source to insert.
     std::vector<BSONObj> _documentsToInsert;  // (M)
+    // The total size of the documents fetched and not inserted yet, including those taken out of
+    // '_documentsToInsert' by an insert which is still running, and the condition signalled
+    // whenever an insert finishes.
+    size_t _bufferedBytes = 0;  // (M)
+    stdx::condition_variable _insertFinishedCond;
     Stats _stats;                             // (M)
     // Putting _dbWorkTaskRunner last ensures anything the database work threads depend on,
     // like _documentsToInsert, is destroyed after those threads exit.
@@ -275,6 +379,26 @@ private:
     // If true, it means we are starting a new query or resuming an interrupted one.
     bool _firstBatchOfQueryRound = true;  // (X)
 
+    // Whether the ranges to clone the collection in, if any, have been chosen. The choice is kept
+    // when the query stage is retried, so that ranges which are complete are not fetched again.
+    bool _rangesChosen = false;  // (X)
+
+    // For each entry in '_stats.ranges', the '{_id: <value>}' of the last document fetched for it,
+    // or an empty object if none has been fetched yet.
+    std::vector<BSONObj> _rangeLastIds;  // (M)
+
+    // Set when fetching one of the ranges failed, so that the others stop early.
+    AtomicWord<bool> _rangeQueryFailed{false};  // (S)
+
+    // The connections of the ranges being fetched, and the number of ranges still running.
+    std::vector<DBClientConnection*> _rangeClients;  // (M)
+    size_t _numRangeQueriesRunning = 0;               // (M)
+    stdx::condition_variable _rangeQueriesDoneCond;
+
+    // Serializes inserts into '_collLoader', which is not thread safe, without holding '_mutex'
+    // so that the range queries can keep buffering documents meanwhile.
+    Mutex _insertMutex = MONGO_MAKE_LATCH("CollectionCloner::_insertMutex");
+
     // Only set during non-resumable (4.2) queries.
     // Signifies that there were changes to the collection on the sync source that resulted in
     // our remote cursor getting killed.
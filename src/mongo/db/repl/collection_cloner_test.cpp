@@ -39,6 +39,8 @@
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/service_context_test_fixture.h"
 #include "mongo/dbtests/mock/mock_dbclient_connection.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/concurrency/thread_pool.h"
 
@@ -1180,5 +1182,289 @@ TEST_F(CollectionClonerTestNonResumable, NonResumableCursorErrorThenSuccessEqual
     clonerThread.join();
 }
 
+std::vector<BSONObj> makeIds(std::vector<int> values) {
+    std::vector<BSONObj> ids;
+    for (auto value : values) {
+        ids.push_back(BSON("_id" << value));
+    }
+    return ids;
+}
+
+TEST(CollectionClonerRangesTest, ChooseRangeBoundariesSplitsSampleEvenly) {
+    auto boundaries =
+        CollectionCloner::chooseRangeBoundaries(makeIds({7, 3, 11, 1, 9, 5, 12, 2}), 4);
+    ASSERT_EQ(3U, boundaries.size());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 3), boundaries[0]);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 7), boundaries[1]);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 11), boundaries[2]);
+}
+
+TEST(CollectionClonerRangesTest, ChooseRangeBoundariesDropsDuplicateBoundaries) {
+    auto boundaries = CollectionCloner::chooseRangeBoundaries(makeIds({1, 2, 2, 2, 2, 2}), 3);
+    ASSERT_EQ(1U, boundaries.size());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 2), boundaries[0]);
+
+    ASSERT(CollectionCloner::chooseRangeBoundaries(makeIds({4}), 4).empty());
+    ASSERT(CollectionCloner::chooseRangeBoundaries({}, 4).empty());
+}
+
+TEST(CollectionClonerRangesTest, ChooseRangeBoundariesOrdersByCanonicalType) {
+    std::vector<BSONObj> ids{BSON("_id"
+                                  << "b"),
+                             BSON("_id" << 2),
+                             BSON("_id" << OID()),
+                             BSON("_id"
+                                  << "a")};
+    auto boundaries = CollectionCloner::chooseRangeBoundaries(ids, 2);
+    ASSERT_EQ(1U, boundaries.size());
+    ASSERT_BSONOBJ_EQ(BSON("_id"
+                           << "b"),
+                      boundaries[0]);
+}
+
+TEST(CollectionClonerRangesTest, StatsReportRangeProgress) {
+    CollectionCloner::Stats stats;
+    stats.ranges.push_back({BSONObj(), BSON("_id" << 10)});
+    stats.ranges.push_back({BSON("_id" << 10), BSONObj()});
+    stats.ranges[0].documentsReceived = 10;
+    stats.ranges[0].receivedBatches = 2;
+    stats.ranges[0].done = true;
+    stats.ranges[1].documentsReceived = 3;
+    stats.ranges[1].receivedBatches = 1;
+
+    auto ranges = stats.toBSON()["ranges"].Array();
+    ASSERT_EQ(2U, ranges.size());
+    ASSERT_BSONOBJ_EQ(BSON("min" << BSON("_id" << MINKEY) << "max" << BSON("_id" << 10)
+                                 << "documentsReceived" << 10 << "receivedBatches" << 2 << "done"
+                                 << true),
+                      ranges[0].Obj());
+    ASSERT_BSONOBJ_EQ(BSON("min" << BSON("_id" << 10) << "max" << BSON("_id" << MAXKEY)
+                                 << "documentsReceived" << 3 << "receivedBatches" << 1 << "done"
+                                 << false),
+                      ranges[1].Obj());
+}
+
+/**
+ * Clones a collection which is large enough to be split into several '_id' ranges, each fetched
+ * over its own connection to the mock sync source.
+ */
+class CollectionClonerTestRanges : public CollectionClonerTest {
+protected:
+    static constexpr int kNumDocs = 40;
+    static constexpr int kDocsPerRange = 10;
+    static constexpr size_t kNumRanges = kNumDocs / kDocsPerRange;
+
+    void setUp() final {
+        CollectionClonerTest::setUp();
+        setInitialSyncId();
+        _minDocumentsPerRange = initialSyncCollectionClonerMinDocumentsPerRange.load();
+        _maxBufferedBytes = initialSyncCollectionClonerMaxBufferedBytes.load();
+        initialSyncCollectionClonerMinDocumentsPerRange.store(kDocsPerRange);
+
+        _mockServer->setCommandReply("count", createCountResponse(kNumDocs));
+        _mockServer->setCommandReply("listIndexes",
+                                     createCursorResponse(_nss.ns(), BSON_ARRAY(_idIndexSpec)));
+
+        // The '$sample' which chooses the range boundaries returns every '_id', so the ranges come
+        // out the same size.
+        BSONArrayBuilder sample;
+        for (int id = 0; id < kNumDocs; ++id) {
+            _mockServer->insert(_nss.ns(), BSON("_id" << id));
+            sample.append(BSON("_id" << id));
+        }
+        _mockServer->setCommandReply("aggregate", createCursorResponse(_nss.ns(), sample.arr()));
+    }
+
+    void tearDown() final {
+        initialSyncCollectionClonerMinDocumentsPerRange.store(_minDocumentsPerRange);
+        initialSyncCollectionClonerMaxBufferedBytes.store(_maxBufferedBytes);
+        CollectionClonerTest::tearDown();
+    }
+
+    std::unique_ptr<CollectionCloner> makeRangeCloner() {
+        auto cloner = makeCollectionCloner();
+        cloner->setBatchSize_forTest(3);
+        cloner->setCreateClientFn_forTest(
+            [this] { return std::make_unique<MockDBClientConnection>(_mockServer.get()); });
+        return cloner;
+    }
+
+    /**
+     * Makes the bulk loader hold up every insert until unblockInserts() is called. The cloner must
+     * already have created the collection.
+     */
+    void blockInserts() {
+        _loader->insertDocsFn = [this](const std::vector<BSONObj>::const_iterator,
+                                       const std::vector<BSONObj>::const_iterator) {
+            stdx::unique_lock<Latch> lk(_insertsMutex);
+            _insertsUnblockedCond.wait(lk, [&] { return _insertsUnblocked; });
+            return Status::OK();
+        };
+    }
+
+    void unblockInserts() {
+        stdx::lock_guard<Latch> lk(_insertsMutex);
+        _insertsUnblocked = true;
+        _insertsUnblockedCond.notify_all();
+    }
+
+    void waitForReceivedBatches(CollectionCloner* cloner, size_t numBatches) {
+        while (cloner->getStats().receivedBatches < numBatches) {
+            sleepmillis(10);
+        }
+    }
+
+    void assertRangesCloned(CollectionCloner* cloner) {
+        ASSERT_EQUALS(kNumDocs, _collectionStats->insertCount);
+        ASSERT_TRUE(_collectionStats->commitCalled);
+        auto stats = cloner->getStats();
+        ASSERT_EQUALS(static_cast<size_t>(kNumDocs), stats.documentsCopied);
+        ASSERT_EQUALS(kNumRanges, stats.ranges.size());
+        for (auto&& range : stats.ranges) {
+            ASSERT_TRUE(range.done);
+            ASSERT_EQUALS(static_cast<size_t>(kDocsPerRange), range.documentsReceived);
+        }
+    }
+
+private:
+    int _minDocumentsPerRange;
+    long long _maxBufferedBytes;
+
+    Mutex _insertsMutex = MONGO_MAKE_LATCH("CollectionClonerTestRanges::_insertsMutex");
+    stdx::condition_variable _insertsUnblockedCond;
+    bool _insertsUnblocked = false;
+};
+
+TEST_F(CollectionClonerTestRanges, CloneInRanges) {
+    auto cloner = makeRangeCloner();
+    ASSERT_OK(cloner->run());
+
+    assertRangesCloned(cloner.get());
+    auto stats = cloner->getStats();
+    for (size_t i = 0; i < kNumRanges; ++i) {
+        const auto& range = stats.ranges[i];
+        ASSERT_BSONOBJ_EQ(i == 0 ? BSONObj() : BSON("_id" << int(i) * kDocsPerRange), range.min);
+        ASSERT_BSONOBJ_EQ(i == kNumRanges - 1 ? BSONObj()
+                                              : BSON("_id" << int(i + 1) * kDocsPerRange),
+                          range.max);
+    }
+}
+
+TEST_F(CollectionClonerTestRanges, FetchingWaitsForBufferedDocumentsToBeInserted) {
+    initialSyncCollectionClonerMaxBufferedBytes.store(1);
+
+    auto cloner = makeRangeCloner();
+    auto beforeStageFailPoint = globalFailPointRegistry().find("hangBeforeClonerStage");
+    auto timesEnteredBeforeStage = beforeStageFailPoint->setMode(
+        FailPoint::alwaysOn, 0, fromjson("{cloner: 'CollectionCloner', stage: 'query'}"));
+
+    // Run the cloner in a separate thread.
+    stdx::thread clonerThread([&] {
+        Client::initThread("ClonerRunner");
+        ASSERT_OK(cloner->run());
+    });
+
+    beforeStageFailPoint->waitForTimesEntered(timesEnteredBeforeStage + 1);
+    blockInserts();
+    beforeStageFailPoint->setMode(FailPoint::off, 0);
+
+    // Each range fetches its first batch, and then waits for the buffered documents to be
+    // inserted before fetching any more.
+    waitForReceivedBatches(cloner.get(), kNumRanges);
+    sleepmillis(100);
+    ASSERT_EQUALS(kNumRanges, cloner->getStats().receivedBatches);
+    ASSERT_EQUALS(0, _collectionStats->insertCount);
+
+    unblockInserts();
+    clonerThread.join();
+
+    assertRangesCloned(cloner.get());
+}
+
+TEST_F(CollectionClonerTestRanges, RangeResumesAfterLastFetchedIdOnTransientError) {
+    // Hold every range after its first batch, so that whichever range fails has already fetched
+    // part of itself.
+    initialSyncCollectionClonerMaxBufferedBytes.store(1);
+
+    auto cloner = makeRangeCloner();
+    auto beforeStageFailPoint = globalFailPointRegistry().find("hangBeforeClonerStage");
+    auto timesEnteredBeforeStage = beforeStageFailPoint->setMode(
+        FailPoint::alwaysOn, 0, fromjson("{cloner: 'CollectionCloner', stage: 'query'}"));
+
+    // Run the cloner in a separate thread.
+    stdx::thread clonerThread([&] {
+        Client::initThread("ClonerRunner");
+        ASSERT_OK(cloner->run());
+    });
+
+    beforeStageFailPoint->waitForTimesEntered(timesEnteredBeforeStage + 1);
+    blockInserts();
+    beforeStageFailPoint->setMode(FailPoint::off, 0);
+    waitForReceivedBatches(cloner.get(), kNumRanges);
+
+    // This will cause the next batch of one of the ranges to fail once (transiently), which stops
+    // the other ranges too.
+    auto failNextBatch = globalFailPointRegistry().find("mockCursorThrowErrorOnGetMore");
+    auto timesEnteredFailNextBatch = failNextBatch->setMode(
+        FailPoint::nTimes, 1, fromjson("{errorType: 'HostUnreachable'}"));
+
+    unblockInserts();
+    clonerThread.join();
+    failNextBatch->waitForTimesEntered(timesEnteredFailNextBatch + 1);
+
+    // Since the CollectionMockStats class does not de-duplicate inserts, inserting exactly one
+    // document per '_id' is evidence that the ranges resumed after the last '_id' they fetched
+    // instead of fetching the whole range again.
+    assertRangesCloned(cloner.get());
+}
+
+TEST_F(CollectionClonerTestRanges, RangeFailureStopsTheOtherRanges) {
+    // The first range to start cannot connect to the sync source.
+    MockRemoteDBServer unreachableServer("unreachable:27017");
+    unreachableServer.shutdown();
+    AtomicWord<int> numClients{0};
+
+    auto cloner = makeCollectionCloner();
+    cloner->setBatchSize_forTest(3);
+    cloner->setCreateClientFn_forTest([&]() -> std::unique_ptr<DBClientConnection> {
+        auto server = numClients.fetchAndAdd(1) == 0 ? &unreachableServer : _mockServer.get();
+        return std::make_unique<MockDBClientConnection>(server);
+    });
+
+    auto beforeStageFailPoint = globalFailPointRegistry().find("hangBeforeClonerStage");
+    auto timesEnteredBeforeStage = beforeStageFailPoint->setMode(
+        FailPoint::alwaysOn, 0, fromjson("{cloner: 'CollectionCloner', stage: 'query'}"));
+    auto beforeRetryFailPoint = globalFailPointRegistry().find("hangBeforeRetryingClonerStage");
+    auto timesEnteredBeforeRetry = beforeRetryFailPoint->setMode(
+        FailPoint::alwaysOn, 0, fromjson("{cloner: 'CollectionCloner', stage: 'query'}"));
+
+    // Run the cloner in a separate thread.
+    stdx::thread clonerThread([&] {
+        Client::initThread("ClonerRunner");
+        ASSERT_OK(cloner->run());
+    });
+
+    // Hold up the queries of the other ranges until the failure has stopped them.
+    beforeStageFailPoint->waitForTimesEntered(timesEnteredBeforeStage + 1);
+    _mockServer->setDelay(300);
+    beforeStageFailPoint->setMode(FailPoint::off, 0);
+
+    // None of the other ranges inserted any documents before the stage was retried.
+    beforeRetryFailPoint->waitForTimesEntered(timesEnteredBeforeRetry + 1);
+    auto stats = cloner->getStats();
+    ASSERT_EQUALS(kNumRanges, stats.ranges.size());
+    for (auto&& range : stats.ranges) {
+        ASSERT_FALSE(range.done);
+        ASSERT_EQUALS(0U, range.documentsReceived);
+    }
+    ASSERT_EQUALS(0, _collectionStats->insertCount);
+
+    _mockServer->setDelay(0);
+    beforeRetryFailPoint->setMode(FailPoint::off, 0);
+    clonerThread.join();
+
+    assertRangesCloned(cloner.get());
+}
+
 }  // namespace repl
 }  // namespace mongo
@@ -44,6 +44,8 @@
 namespace mongo {
 namespace repl {
 
+class WriterAssignments;
+
 /**
  * Applies oplog entries.
  * Primarily used to apply batches of operations fetched from a sync source during steady state
@@ -102,6 +104,7 @@ private:
                                         std::vector<OplogEntry>* ops,
                                         std::vector<std::vector<const OplogEntry*>>* writerVectors,
                                         std::vector<std::vector<OplogEntry>>* derivedOps,
+                                        WriterAssignments* writerAssignments,
                                         SessionUpdateTracker* sessionUpdateTracker) noexcept;
 
     // Not owned by us.
@@ -56,6 +56,7 @@
 #include "mongo/db/repl/idempotency_test_fixture.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplog_applier.h"
+#include "mongo/db/repl/oplog_applier_utils.h"
 #include "mongo/db/repl/oplog_entry_test_helpers.h"
 #include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/replication_coordinator.h"
@@ -3721,6 +3722,71 @@ TEST_F(IdempotencyTestTxns, CommitPreparedTransactionIgnoresNamespaceNotFoundErr
     // operation has no effect.
     ASSERT_FALSE(docExists(_opCtx.get(), nss, doc));
 }
+
+/**
+ * Assigns an entry with the given conflict key and records it in the chosen writer vector.
+ */
+uint32_t assignWriter(WriterAssignments* writerAssignments,
+                      std::vector<std::vector<const OplogEntry*>>* writerVectors,
+                      uint32_t conflictKey,
+                      boost::optional<uint32_t> forceWriterId = boost::none) {
+    auto writerId = writerAssignments->assign(conflictKey, *writerVectors, forceWriterId);
+    (*writerVectors)[writerId].push_back(nullptr);
+    return writerId;
+}
+
+TEST(WriterAssignmentsTest, HashBasedAssignmentUsesConflictKeyModuloNumWriters) {
+    WriterAssignments writerAssignments(false /* balanceLoad */);
+    std::vector<std::vector<const OplogEntry*>> writerVectors(4);
+    ASSERT_EQ(1U, assignWriter(&writerAssignments, &writerVectors, 5));
+    ASSERT_EQ(1U, assignWriter(&writerAssignments, &writerVectors, 9));
+    ASSERT_EQ(3U, assignWriter(&writerAssignments, &writerVectors, 7, 3U));
+}
+
+TEST(WriterAssignmentsTest, ConflictingEntriesAreAssignedToTheSameWriter) {
+    WriterAssignments writerAssignments(true /* balanceLoad */);
+    std::vector<std::vector<const OplogEntry*>> writerVectors(4);
+    auto writerId = assignWriter(&writerAssignments, &writerVectors, 42);
+    for (int i = 0; i < 10; ++i) {
+        assignWriter(&writerAssignments, &writerVectors, 100 + i);
+        ASSERT_EQ(writerId, assignWriter(&writerAssignments, &writerVectors, 42));
+    }
+}
+
+TEST(WriterAssignmentsTest, KeysWhichCollideModuloNumWritersAreSpreadAcrossWriters) {
+    WriterAssignments writerAssignments(true /* balanceLoad */);
+    std::vector<std::vector<const OplogEntry*>> writerVectors(4);
+
+    // All of these keys hash to writer 0, but none of them conflict with each other.
+    for (uint32_t key = 0; key < 400; key += 4) {
+        assignWriter(&writerAssignments, &writerVectors, key);
+    }
+    for (const auto& writer : writerVectors) {
+        ASSERT_EQ(25U, writer.size());
+    }
+}
+
+TEST(WriterAssignmentsTest, NewKeysGoToTheLeastLoadedWriter) {
+    WriterAssignments writerAssignments(true /* balanceLoad */);
+    std::vector<std::vector<const OplogEntry*>> writerVectors(3);
+
+    // A hot document fills up one writer.
+    auto hotWriterId = assignWriter(&writerAssignments, &writerVectors, 7);
+    for (int i = 0; i < 10; ++i) {
+        assignWriter(&writerAssignments, &writerVectors, 7);
+    }
+    for (uint32_t key = 100; key < 120; ++key) {
+        ASSERT_NE(hotWriterId, assignWriter(&writerAssignments, &writerVectors, key));
+    }
+}
+
+TEST(WriterAssignmentsTest, ForcedWriterIsFollowedByLaterEntriesWithTheSameKey) {
+    WriterAssignments writerAssignments(true /* balanceLoad */);
+    std::vector<std::vector<const OplogEntry*>> writerVectors(4);
+    ASSERT_EQ(2U, assignWriter(&writerAssignments, &writerVectors, 11, 2U));
+    ASSERT_EQ(2U, assignWriter(&writerAssignments, &writerVectors, 11));
+}
+
 }  // namespace
 }  // namespace repl
 }  // namespace mongo
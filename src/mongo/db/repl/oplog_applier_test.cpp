@@ -347,6 +347,53 @@ TEST_F(OplogApplierTest, LastOpInLargeTransactionIsProcessedIndividually) {
     ASSERT_EQUALS(srcOps[4], batch[0]);
 }
 
+TEST(OplogBatchSizeControllerTest, LimitIsClampedToBounds) {
+    OplogBatchSizeController controller(5000);
+    ASSERT_EQ(1000U, controller.getOpsLimit(100, 1000));
+    ASSERT_EQ(2000U, controller.getOpsLimit(2000, 4000));
+}
+
+TEST(OplogBatchSizeControllerTest, ShrinksWhileThroughputHoldsAndTurnsAroundWhenItDrops) {
+    OplogBatchSizeController controller(1600);
+    ASSERT_EQ(1600U, controller.getOpsLimit(100, 1600));
+
+    // Starting at the maximum, the controller can only probe smaller batches.
+    controller.recordAppliedBatch(1600, 1600, Microseconds(1600), 100, 1600);
+    ASSERT_EQ(1400U, controller.getOpsLimit(100, 1600));
+
+    // Same throughput: keep going.
+    controller.recordAppliedBatch(1400, 1400, Microseconds(1400), 100, 1600);
+    ASSERT_EQ(1225U, controller.getOpsLimit(100, 1600));
+
+    // Half the throughput: turn around.
+    controller.recordAppliedBatch(1225, 1225, Microseconds(2450), 100, 1600);
+    ASSERT_EQ(1378U, controller.getOpsLimit(100, 1600));
+}
+
+TEST(OplogBatchSizeControllerTest, IgnoresPartialAndStaleBatches) {
+    OplogBatchSizeController controller(1000);
+    ASSERT_EQ(1000U, controller.getOpsLimit(100, 1000));
+
+    // A batch cut short, e.g. by the byte limit or an empty buffer.
+    controller.recordAppliedBatch(1000, 10, Microseconds(10), 100, 1000);
+    ASSERT_EQ(1000U, controller.getOpsLimit(100, 1000));
+
+    // A batch filled with a limit that is no longer current.
+    controller.recordAppliedBatch(2000, 2000, Microseconds(10), 100, 1000);
+    ASSERT_EQ(1000U, controller.getOpsLimit(100, 1000));
+
+    // A batch which is full up to one step below the limit is still a sample.
+    controller.recordAppliedBatch(1000, 900, Microseconds(900), 100, 1000);
+    ASSERT_EQ(875U, controller.getOpsLimit(100, 1000));
+}
+
+TEST(OplogBatchSizeControllerTest, TurnsAroundAtTheMinimum) {
+    OplogBatchSizeController controller(100);
+    ASSERT_EQ(100U, controller.getOpsLimit(100, 1000));
+    controller.recordAppliedBatch(100, 100, Microseconds(100), 100, 1000);
+    ASSERT_EQ(112U, controller.getOpsLimit(100, 1000));
+}
+
 }  // namespace
 }  // namespace repl
 }  // namespace mongo
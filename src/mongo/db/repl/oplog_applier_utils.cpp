@@ -74,6 +74,41 @@ CachedCollectionProperties::getCollectionPropertiesImpl(OperationContext* opCtx,
     return collProperties;
 }
 
+WriterAssignments::WriterAssignments()
+    : WriterAssignments(oplogApplicationBalanceWriterLoad.load()) {}
+
+WriterAssignments::WriterAssignments(bool balanceLoad) : _balanceLoad(balanceLoad) {}
+
+uint32_t WriterAssignments::assign(uint32_t conflictKey,
+                                   const std::vector<std::vector<const OplogEntry*>>& writerVectors,
+                                   boost::optional<uint32_t> forceWriterId) {
+    const uint32_t numWriters = writerVectors.size();
+    if (!_balanceLoad) {
+        return (forceWriterId ? *forceWriterId : conflictKey) % numWriters;
+    }
+
+    if (forceWriterId) {
+        _writerByKey.emplace(conflictKey, *forceWriterId);
+        return *forceWriterId;
+    }
+
+    auto [it, inserted] = _writerByKey.emplace(conflictKey, 0);
+    if (!inserted) {
+        return it->second;
+    }
+
+    // Start the scan at the hashed writer so that ties are still spread by hash.
+    uint32_t writerId = conflictKey % numWriters;
+    for (uint32_t i = 1; i < numWriters && !writerVectors[writerId].empty(); ++i) {
+        const uint32_t candidate = (conflictKey + i) % numWriters;
+        if (writerVectors[candidate].size() < writerVectors[writerId].size()) {
+            writerId = candidate;
+        }
+    }
+    it->second = writerId;
+    return writerId;
+}
+
 void OplogApplierUtils::processCrudOp(OperationContext* opCtx,
                                       OplogEntry* op,
                                       uint32_t* hash,
@@ -106,19 +141,19 @@ uint32_t OplogApplierUtils::addToWriterVector(
     OplogEntry* op,
     std::vector<std::vector<const OplogEntry*>>* writerVectors,
     CachedCollectionProperties* collPropertiesCache,
+    WriterAssignments* writerAssignments,
     boost::optional<uint32_t> forceWriterId) {
     auto hashedNs = StringMapHasher().hashed_key(op->getNss().ns());
 
     // Reduce the hash from 64bit down to 32bit, just to allow combinations with murmur3 later
-    // on. Bit depth not important, we end up just doing integer modulo with this in the end.
+    // on. Bit depth not important, we end up just using this as the conflict key of the op.
     // The hash function should provide entropy in the lower bits as it's used in hash tables.
     uint32_t hash = static_cast<uint32_t>(hashedNs.hash());
 
     if (op->isCrudOpType())
         processCrudOp(opCtx, op, &hash, &hashedNs, collPropertiesCache);
 
-    const uint32_t numWriters = writerVectors->size();
-    auto writerId = (forceWriterId ? *forceWriterId : hash) % numWriters;
+    auto writerId = writerAssignments->assign(hash, *writerVectors, forceWriterId);
     auto& writer = (*writerVectors)[writerId];
     if (writer.empty()) {
         writer.reserve(8);  // Skip a few growth rounds
@@ -148,13 +183,14 @@ void OplogApplierUtils::addDerivedOps(OperationContext* opCtx,
                                       std::vector<OplogEntry>* derivedOps,
                                       std::vector<std::vector<const OplogEntry*>>* writerVectors,
                                       CachedCollectionProperties* collPropertiesCache,
+                                      WriterAssignments* writerAssignments,
                                       bool serial) {
     boost::optional<uint32_t>
         serialWriterId;  // Used to determine which writer vector to assign serial ops.
 
     for (auto&& op : *derivedOps) {
-        auto writerId =
-            addToWriterVector(opCtx, &op, writerVectors, collPropertiesCache, serialWriterId);
+        auto writerId = addToWriterVector(
+            opCtx, &op, writerVectors, collPropertiesCache, writerAssignments, serialWriterId);
         if (serial && !serialWriterId) {
             serialWriterId.emplace(writerId);
         }
@@ -30,6 +30,7 @@
 #pragma once
 
 #include "mongo/db/repl/insert_group.h"
+#include "mongo/stdx/unordered_map.h"
 
 namespace mongo {
 class CollatorInterface;
@@ -58,6 +59,41 @@ private:
     StringMap<CollectionProperties> _cache;
 };
 
+/**
+ * Chooses the writer vector for each oplog entry of a single batch. Entries which share a conflict
+ * key (the namespace hash, combined with the _id hash for CRUD ops on non-capped collections) may
+ * depend on each other and are always assigned to the same writer, so that they are applied in
+ * oplog order. An entry whose conflict key has not been seen yet in the batch does not depend on
+ * anything assigned so far, so it goes to the writer with the fewest entries. This keeps the
+ * writers evenly loaded when a batch is dominated by a single collection or by a few hot documents
+ * whose hashes collide modulo the number of writers.
+ *
+ * Distinct documents whose conflict keys collide are treated as conflicting, which is safe.
+ */
+class WriterAssignments {
+public:
+    /**
+     * Uses the 'oplogApplicationBalanceWriterLoad' server parameter to choose between load-based
+     * and purely hash-based assignment.
+     */
+    WriterAssignments();
+    explicit WriterAssignments(bool balanceLoad);
+
+    /**
+     * Returns the writer vector for an entry with the given conflict key. If 'forceWriterId' is
+     * set, the entry is assigned to that writer and later entries with the same key follow it.
+     */
+    uint32_t assign(uint32_t conflictKey,
+                    const std::vector<std::vector<const OplogEntry*>>& writerVectors,
+                    boost::optional<uint32_t> forceWriterId = boost::none);
+
+private:
+    const bool _balanceLoad;
+
+    // The writer each conflict key of the batch was assigned to.
+    stdx::unordered_map<uint32_t, uint32_t> _writerByKey;
+};
+
 /**
  * This class contains some static methods common to ordinary oplog application and oplog
  * application as part of tenant migration.
@@ -84,23 +120,25 @@ public:
 
 
     /**
-     * Adds a single oplog entry to the appropriate writer vector.  Returns the index of the
-     * writer vector the entry was written to.
+     * Adds a single oplog entry to the writer vector chosen by 'writerAssignments'.  Returns the
+     * index of the writer vector the entry was written to.
      */
     static uint32_t addToWriterVector(OperationContext* opCtx,
                                       OplogEntry* op,
                                       std::vector<std::vector<const OplogEntry*>>* writerVectors,
                                       CachedCollectionProperties* collPropertiesCache,
+                                      WriterAssignments* writerAssignments,
                                       boost::optional<uint32_t> forceWriterId = boost::none);
     /**
      * Adds a set of derivedOps to writerVectors.
-     * If `serial` is true, assign all derived operations to the writer vector corresponding to the
-     * hash of the first operation in `derivedOps`.
+     * If `serial` is true, assign all derived operations to the writer vector chosen for the first
+     * operation in `derivedOps`.
      */
     static void addDerivedOps(OperationContext* opCtx,
                               std::vector<OplogEntry>* derivedOps,
                               std::vector<std::vector<const OplogEntry*>>* writerVectors,
                               CachedCollectionProperties* collPropertiesCache,
+                              WriterAssignments* writerAssignments,
                               bool serial);
 
     /**
@@ -41,8 +41,49 @@ namespace mongo {
 namespace repl {
 MONGO_FAIL_POINT_DEFINE(skipOplogBatcherWaitForData);
 
+OplogBatchSizeController::OplogBatchSizeController(std::size_t initialOpsLimit)
+    : _opsLimit(std::max<std::size_t>(initialOpsLimit, 1)) {}
+
+std::size_t OplogBatchSizeController::getOpsLimit(std::size_t minOps, std::size_t maxOps) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _opsLimit = std::max(minOps, std::min(_opsLimit, maxOps));
+    return _opsLimit;
+}
+
+void OplogBatchSizeController::recordAppliedBatch(std::size_t batchLimitOps,
+                                                  std::size_t numOps,
+                                                  Microseconds duration,
+                                                  std::size_t minOps,
+                                                  std::size_t maxOps) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (batchLimitOps != _opsLimit || numOps < batchLimitOps - batchLimitOps / 8 ||
+        duration <= Microseconds(0)) {
+        return;
+    }
+
+    const double throughput = double(numOps) / durationCount<Microseconds>(duration);
+    if (_lastThroughput && throughput < *_lastThroughput * (1 - kThroughputTolerance)) {
+        _growing = !_growing;
+    }
+    _lastThroughput = throughput;
+
+    maxOps = std::max(minOps, maxOps);
+    if (_growing && _opsLimit >= maxOps) {
+        _growing = false;
+    } else if (!_growing && _opsLimit <= minOps) {
+        _growing = true;
+    }
+
+    const std::size_t step = std::max<std::size_t>(1, _opsLimit / 8);
+    _opsLimit = _growing ? std::min(maxOps, _opsLimit + step)
+                         : std::max(minOps, _opsLimit - std::min(step, _opsLimit));
+}
+
 OplogBatcher::OplogBatcher(OplogApplier* oplogApplier, OplogBuffer* oplogBuffer)
-    : _oplogApplier(oplogApplier), _oplogBuffer(oplogBuffer), _ops(0) {}
+    : _oplogApplier(oplogApplier),
+      _oplogBuffer(oplogBuffer),
+      _ops(0),
+      _batchSizeController(getBatchLimitOplogEntries()) {}
 OplogBatcher::~OplogBatcher() {
     invariant(!_thread);
 }
@@ -262,7 +303,10 @@ void OplogBatcher::_run(StorageInterface* storageInterface) {
         batchLimits.slaveDelayLatestTimestamp = _calculateSlaveDelayLatestTimestamp();
 
         // Check the limits once per batch since users can change them at runtime.
-        batchLimits.ops = getBatchLimitOplogEntries();
+        batchLimits.ops = replBatchLimitOperationsAdaptive.load()
+            ? _batchSizeController.getOpsLimit(getBatchLimitOplogEntriesAdaptiveMinimum(),
+                                               getBatchLimitOplogEntries())
+            : getBatchLimitOplogEntries();
 
         // Use the OplogBuffer to populate a local OplogBatch. Note that the buffer may be empty.
         OplogBatch ops(batchLimits.ops);
@@ -340,10 +384,27 @@ void OplogBatcher::_run(StorageInterface* storageInterface) {
     }
 }
 
+void OplogBatcher::recordAppliedBatch(std::size_t batchLimitOps,
+                                      std::size_t numOps,
+                                      Microseconds duration) {
+    if (!replBatchLimitOperationsAdaptive.load()) {
+        return;
+    }
+    _batchSizeController.recordAppliedBatch(batchLimitOps,
+                                            numOps,
+                                            duration,
+                                            getBatchLimitOplogEntriesAdaptiveMinimum(),
+                                            getBatchLimitOplogEntries());
+}
+
 std::size_t getBatchLimitOplogEntries() {
     return std::size_t(replBatchLimitOperations.load());
 }
 
+std::size_t getBatchLimitOplogEntriesAdaptiveMinimum() {
+    return std::size_t(replBatchLimitOperationsAdaptiveMinimum.load());
+}
+
 std::size_t getBatchLimitOplogBytes(OperationContext* opCtx, StorageInterface* storageInterface) {
     // We can't change the timestamp source within a write unit of work.
     invariant(!opCtx->lockState()->inAWriteUnitOfWork());
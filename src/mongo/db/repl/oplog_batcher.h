@@ -46,7 +46,7 @@ class OplogApplier;
  */
 class OplogBatch {
 public:
-    explicit OplogBatch(std::size_t batchLimitOps) {
+    explicit OplogBatch(std::size_t batchLimitOps) : _batchLimitOps(batchLimitOps) {
         _batch.reserve(batchLimitOps);
     }
     bool empty() const {
@@ -64,6 +64,13 @@ public:
         return _batch;
     }
 
+    /**
+     * The limit on the number of operations this batch was filled with.
+     */
+    std::size_t getBatchLimitOps() const {
+        return _batchLimitOps;
+    }
+
     void emplace_back(OplogEntry oplog) {
         invariant(!_mustShutdown);
         _batch.emplace_back(std::move(oplog));
@@ -107,10 +114,55 @@ public:
 
 private:
     std::vector<OplogEntry> _batch;
+    std::size_t _batchLimitOps;
     bool _mustShutdown = false;
     boost::optional<long long> _termWhenExhausted;
 };
 
+/**
+ * Adapts the limit on the number of operations per batch to the throughput the applier achieves.
+ *
+ * Every applied batch which was (nearly) filled up to the current limit is a sample. The limit
+ * moves by an eighth of its value in one direction for as long as throughput holds up, and turns
+ * around when a sample is noticeably slower than the previous one or a bound is reached. Batches
+ * cut short by the byte limit, by a command or by an empty buffer, and batches that were filled
+ * before the latest change to the limit, say nothing about the current limit and are ignored.
+ */
+class OplogBatchSizeController {
+    OplogBatchSizeController(const OplogBatchSizeController&) = delete;
+    OplogBatchSizeController& operator=(const OplogBatchSizeController&) = delete;
+
+public:
+    // A sample must be at least this much slower than the previous one to reverse direction.
+    static constexpr double kThroughputTolerance = 0.05;
+
+    explicit OplogBatchSizeController(std::size_t initialOpsLimit);
+
+    /**
+     * Returns the limit for the next batch, clamped to [minOps, maxOps].
+     */
+    std::size_t getOpsLimit(std::size_t minOps, std::size_t maxOps);
+
+    /**
+     * Records that a batch of 'numOps' operations, filled with a limit of 'batchLimitOps', took
+     * 'duration' to apply.
+     */
+    void recordAppliedBatch(std::size_t batchLimitOps,
+                            std::size_t numOps,
+                            Microseconds duration,
+                            std::size_t minOps,
+                            std::size_t maxOps);
+
+private:
+    Mutex _mutex = MONGO_MAKE_LATCH("OplogBatchSizeController::_mutex");
+
+    std::size_t _opsLimit;
+    bool _growing = false;
+
+    // Operations per microsecond of the previous sample.
+    boost::optional<double> _lastThroughput;
+};
+
 /**
  * Consumes batches of oplog entries from the OplogBuffer to give to the oplog applier, freeing
  * up space for more operations to be fetched from a sync source and allocated onto the OplogBuffer.
@@ -185,6 +237,12 @@ public:
      */
     static std::size_t getOpCount(const OplogEntry& entry);
 
+    /**
+     * Reports how long the applier took to apply a batch produced by this batcher. Used to adapt
+     * the size of later batches when 'replBatchLimitOperationsAdaptive' is enabled.
+     */
+    void recordAppliedBatch(std::size_t batchLimitOps, std::size_t numOps, Microseconds duration);
+
 private:
     /**
      * If slaveDelay is enabled, this function calculates the most recent timestamp of any oplog
@@ -210,6 +268,8 @@ private:
      */
     OplogBatch _ops;
 
+    OplogBatchSizeController _batchSizeController;
+
     std::unique_ptr<stdx::thread> _thread;
 };
 
@@ -219,6 +279,11 @@ private:
  */
 std::size_t getBatchLimitOplogEntries();
 
+/**
+ * Returns the smallest number of operations per batch the adaptive batch limit may choose.
+ */
+std::size_t getBatchLimitOplogEntriesAdaptiveMinimum();
+
 /**
  * Calculates batch limit size (in bytes) using the maximum capped collection size of the oplog
  * size.  Must not be called from within a WriteUnitOfWork.
@@ -101,6 +101,10 @@ struct ServerGlobalParams {
     bool logWithSyslog = false;     // True if logging to syslog; must not be set if logpath is set.
     int syslogFacility;             // Facility used when appending messages to the syslog.
 
+    bool logAsyncWrites = false;  // True if log messages are written by a dedicated thread.
+    logv2::LogOverflowPolicy logAsyncOverflowPolicy = logv2::LogOverflowPolicy::kBlock;
+    size_t logAsyncBufferSize = 256;  // Number of log messages each thread buffers when async.
+
 #ifndef _WIN32
     int forkReadyFd = -1;  // for `--fork`. Write to it and close it when daemon service is up.
 #endif
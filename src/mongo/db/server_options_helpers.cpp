@@ -381,6 +381,26 @@ Status storeBaseOptions(const moe::Environment& params) {
         serverGlobalParams.logAppend = true;
     }
 
+    if (params.count("systemLog.asyncWrites") && params["systemLog.asyncWrites"].as<bool>()) {
+        serverGlobalParams.logAsyncWrites = true;
+    }
+
+    if (params.count("systemLog.asyncOverflowPolicy")) {
+        std::string policy = params["systemLog.asyncOverflowPolicy"].as<string>();
+        if (policy == "block") {
+            serverGlobalParams.logAsyncOverflowPolicy = logv2::LogOverflowPolicy::kBlock;
+        } else if (policy == "drop") {
+            serverGlobalParams.logAsyncOverflowPolicy = logv2::LogOverflowPolicy::kDrop;
+        } else {
+            return Status(ErrorCodes::BadValue,
+                          "unsupported value for asyncOverflowPolicy " + policy);
+        }
+    }
+
+    if (params.count("systemLog.asyncBufferSize")) {
+        serverGlobalParams.logAsyncBufferSize = params["systemLog.asyncBufferSize"].as<int>();
+    }
+
     if (params.count("systemLog.logRotate")) {
         std::string logRotateParam = params["systemLog.logRotate"].as<string>();
         if (logRotateParam == "reopen") {
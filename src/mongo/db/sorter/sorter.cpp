@@ -49,13 +49,13 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem/operations.hpp>
-#include <snappy.h>
 #include <vector>
 
 #include "mongo/base/string_data.h"
 #include "mongo/config.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/service_context.h"
+#include "mongo/db/sorter/sorter_file_util.h"
 #include "mongo/db/storage/encryption_hooks.h"
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/platform/atomic_word.h"
@@ -63,13 +63,23 @@
 #include "mongo/s/is_mongos.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/destructor_guard.h"
+#include "mongo/util/future.h"
 #include "mongo/util/str.h"
+#include "mongo/util/timer.h"
 #include "mongo/util/unowned_ptr.h"
 
 namespace mongo {
 
 namespace {
 
+// Data is spilled in blocks of about this many bytes, each compressed separately.
+constexpr int kSpillBlockBytes = 64 * 1024;
+
+// Spilled blocks are written to the file once this many bytes of them are pending, in writes which
+// end on a multiple of kWriteAlignment bytes of the file offset.
+constexpr size_t kWriteChunkBytes = 1024 * 1024;
+constexpr std::streamoff kWriteAlignment = 4096;
+
 /**
  * Calculates and returns a new murmur hash value based on the prior murmur hash and a new piece
  * of data.
@@ -162,6 +172,10 @@ private:
  * Returns results from a sorted range within a file. Each instance is given a file name and start
  * and end offsets.
  *
+ * While the data of one block is being returned, the next block is read from the file on the
+ * sorter read-ahead pool, so that merging many ranges does not wait on each of their reads in turn.
+ * Only the raw block is read ahead; it is decrypted and decompressed once it is needed.
+ *
  * This class is NOT responsible for file clean up / deletion. There are openSource() and
  * closeSource() functions to ensure the FileIterator is not holding the file open when the file is
  * deleted. Since it is one among many FileIterators, it cannot close a file that may still be in
@@ -179,18 +193,27 @@ public:
                  std::streampos fileStartOffset,
                  std::streampos fileEndOffset,
                  const Settings& settings,
-                 const uint32_t checksum)
+                 const uint32_t checksum,
+                 SorterCompressionEnum compression,
+                 SorterFileStats* fileStats)
         : _settings(settings),
           _done(false),
           _fileFullPath(fileFullPath),
           _fileStartOffset(fileStartOffset),
           _fileEndOffset(fileEndOffset),
-          _originalChecksum(checksum) {
+          _originalChecksum(checksum),
+          _compression(compression),
+          _fileStats(fileStats) {
         uassert(16815,
                 str::stream() << "unexpected empty file: " << _fileFullPath,
                 boost::filesystem::file_size(_fileFullPath) != 0);
     }
 
+    ~FileIterator() {
+        // The read-ahead task refers to this iterator.
+        waitForReadAhead();
+    }
+
     void openSource() {
         _file.open(_fileFullPath.c_str(), std::ios::in | std::ios::binary);
         uassert(16814,
@@ -203,9 +226,13 @@ public:
                               << "' in file \"" << _fileFullPath
                               << "\": " << myErrnoWithDescription(),
                 _file.good());
+
+        // Start reading the first block, so that the ranges being merged are read concurrently.
+        scheduleReadAhead();
     }
 
     void closeSource() {
+        waitForReadAhead();
         _file.close();
         uassert(50969,
                 str::stream() << "error closing file \"" << _fileFullPath
@@ -255,10 +282,21 @@ public:
     }
 
     SorterRange getRange() const {
-        return {_fileStartOffset, _fileEndOffset, _originalChecksum};
+        SorterRange range{_fileStartOffset, _fileEndOffset, _originalChecksum};
+        range.setCompression(_compression);
+        return range;
     }
 
 private:
+    /**
+     * A block as stored in the file. A negative size means that the block is compressed.
+     */
+    struct RawBlock {
+        int32_t rawSize = 0;
+        std::unique_ptr<char[]> data;
+        bool eof = false;
+    };
+
     /**
      * Attempts to refill the _bufferReader if it is empty. Expects _done to be false.
      */
@@ -274,18 +312,29 @@ private:
      * read, then _done is set to true and the function returns immediately.
      */
     void fillBufferFromDisk() {
-        int32_t rawSize;
-        read(&rawSize, sizeof(rawSize));
-        if (_done)
+        RawBlock block;
+        {
+            Timer timer;
+            if (_readAhead) {
+                auto readAhead = std::move(*_readAhead);
+                _readAhead = boost::none;
+                block = std::move(readAhead).get();
+            } else {
+                block = readRawBlock();
+            }
+            recordMergeReadWait(_fileStats, Microseconds(timer.micros()));
+        }
+
+        if (block.eof) {
+            _done = true;
             return;
+        }
+        scheduleReadAhead();
 
         // negative size means compressed
-        const bool compressed = rawSize < 0;
-        int32_t blockSize = std::abs(rawSize);
-
-        _buffer.reset(new char[blockSize]);
-        read(_buffer.get(), blockSize);
-        uassert(16816, "file too short?", !_done);
+        const bool compressed = block.rawSize < 0;
+        int32_t blockSize = std::abs(block.rawSize);
+        _buffer = std::move(block.data);
 
         auto encryptionHooks = EncryptionHooks::get(getGlobalServiceContext());
         if (encryptionHooks->enabled()) {
@@ -309,17 +358,9 @@ private:
             return;
         }
 
-        dassert(snappy::IsValidCompressedBuffer(_buffer.get(), blockSize));
-
         size_t uncompressedSize;
-        uassert(17061,
-                "couldn't get uncompressed length",
-                snappy::GetUncompressedLength(_buffer.get(), blockSize, &uncompressedSize));
-
-        std::unique_ptr<char[]> decompressionBuffer(new char[uncompressedSize]);
-        uassert(17062,
-                "decompression failed",
-                snappy::RawUncompress(_buffer.get(), blockSize, decompressionBuffer.get()));
+        auto decompressionBuffer =
+            decompressSpilledBlock(_compression, _buffer.get(), blockSize, &uncompressedSize);
 
         // hold on to decompressed data and throw out compressed data at block exit
         _buffer.swap(decompressionBuffer);
@@ -327,11 +368,59 @@ private:
     }
 
     /**
-     * Attempts to read data from disk. Sets _done to true when file offset reaches _fileEndOffset.
+     * Reads the next block from the file, or returns a block with 'eof' set if the whole range has
+     * been read. May run on the read-ahead pool, so must not access any state besides _file.
+     */
+    RawBlock readRawBlock() {
+        RawBlock block;
+        if (!read(&block.rawSize, sizeof(block.rawSize))) {
+            block.eof = true;
+            return block;
+        }
+
+        const int32_t blockSize = std::abs(block.rawSize);
+        block.data.reset(new char[blockSize]);
+        uassert(16816, "file too short?", read(block.data.get(), blockSize));
+        return block;
+    }
+
+    /**
+     * Starts reading the next block on the read-ahead pool, unless read-ahead is disabled.
+     */
+    void scheduleReadAhead() {
+        invariant(!_readAhead);
+
+        auto pf = makePromiseFuture<RawBlock>();
+        auto task = [this, promise = std::move(pf.promise)](Status status) mutable {
+            if (!status.isOK()) {
+                promise.setError(status);
+                return;
+            }
+            promise.setWith([&] { return readRawBlock(); });
+        };
+        if (scheduleSpillReadAhead(std::move(task))) {
+            _readAhead.emplace(std::move(pf.future));
+        }
+    }
+
+    /**
+     * Waits for any block being read ahead, and discards it.
+     */
+    void waitForReadAhead() {
+        if (_readAhead) {
+            auto readAhead = std::move(*_readAhead);
+            _readAhead = boost::none;
+            std::move(readAhead).getNoThrow().getStatus().ignore();
+        }
+    }
+
+    /**
+     * Attempts to read data from disk. Returns false if the file offset has reached
+     * _fileEndOffset.
      *
      * Masserts on any file errors
      */
-    void read(void* out, size_t size) {
+    bool read(void* out, size_t size) {
         invariant(_file.is_open());
 
         const std::streampos offset = _file.tellg();
@@ -342,8 +431,7 @@ private:
 
         if (offset >= _fileEndOffset) {
             invariant(offset == _fileEndOffset);
-            _done = true;
-            return;
+            return false;
         }
 
         _file.read(reinterpret_cast<char*>(out), size);
@@ -352,6 +440,7 @@ private:
                               << "\": " << myErrnoWithDescription(),
                 _file.good());
         verify(_file.gcount() == static_cast<std::streamsize>(size));
+        return true;
     }
 
     const Settings _settings;
@@ -373,6 +462,15 @@ private:
     // to disk. This is not modified, and is only used for comparison against _afterReadChecksum
     // when the FileIterator is exhausted to ensure no data corruption.
     const uint32_t _originalChecksum;
+
+    // The codec the blocks of the range were compressed with.
+    const SorterCompressionEnum _compression;
+
+    SorterFileStats* const _fileStats;
+
+    // The next block, while it is being read on the read-ahead pool. No other thread may access
+    // _file until it is ready.
+    boost::optional<Future<RawBlock>> _readAhead;
 };
 
 /**
@@ -562,7 +660,9 @@ public:
                                range.getStartOffset(),
                                range.getEndOffset(),
                                this->_settings,
-                               range.getChecksum());
+                               range.getChecksum(),
+                               range.getCompression().value_or(SorterCompressionEnum::kSnappy),
+                               this->_opts.fileStats);
                        });
     }
 
@@ -1011,10 +1111,13 @@ SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts,
                                                const std::streampos fileStartOffset,
                                                const Settings& settings)
     : _settings(settings),
+      _compression(opts.compression.value_or(sorter::getDefaultSpillCompression())),
+      _fileStats(opts.fileStats),
       _fileFullPath(fileFullPath),
       // The file descriptor is positioned at the end of a file when opened in append mode, but
       // _file.tellp() is not initialized on all systems to reflect this. Therefore, we must also
       // pass in the expected offset to this constructor.
+      _pendingOutputOffset(fileStartOffset),
       _fileStartOffset(fileStartOffset) {
 
     // This should be checked by consumers, but if we get here don't allow writes.
@@ -1029,7 +1132,8 @@ SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts,
 
     // We open the provided file in append mode so that SortedFileWriter instances can share the
     // same file, used serially. We want to share files in order to stay below system open file
-    // limits.
+    // limits. The stream is unbuffered, as the output is already gathered in _pendingOutput.
+    _file.rdbuf()->pubsetbuf(nullptr, 0);
     _file.open(_fileFullPath.c_str(), std::ios::binary | std::ios::app | std::ios::out);
     uassert(16818,
             str::stream() << "error opening file \"" << _fileFullPath
@@ -1055,7 +1159,7 @@ void SortedFileWriter<Key, Value>::addAlreadySorted(const Key& key, const Value&
     _checksum =
         addDataToChecksum(_buffer.buf() + _nextObjPos, _buffer.len() - _nextObjPos, _checksum);
 
-    if (_buffer.len() > 64 * 1024)
+    if (_buffer.len() > kSpillBlockBytes)
         spill();
 }
 
@@ -1068,10 +1172,13 @@ void SortedFileWriter<Key, Value>::spill() {
         return;
 
     std::string compressed;
-    snappy::Compress(outBuffer, size, &compressed);
-    verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+    bool shouldCompress = false;
+    if (_compression != SorterCompressionEnum::kNone) {
+        sorter::compressSpilledBlock(_compression, outBuffer, size, &compressed);
+        verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+        shouldCompress = compressed.size() < size_t(_buffer.len() / 10 * 9);
+    }
 
-    const bool shouldCompress = compressed.size() < size_t(_buffer.len() / 10 * 9);
     if (shouldCompress) {
         size = compressed.size();
         outBuffer = const_cast<char*>(compressed.data());
@@ -1095,23 +1202,45 @@ void SortedFileWriter<Key, Value>::spill() {
         size = resultLen;
     }
 
+    sorter::recordSpilledBlock(_fileStats, _buffer.len(), sizeof(size) + size);
+
     // negative size means compressed
     size = shouldCompress ? -size : size;
+    _pendingOutput.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    _pendingOutput.append(outBuffer, std::abs(size));
+    _buffer.reset();
+
+    if (_pendingOutput.size() >= kWriteChunkBytes)
+        writePendingOutput(false);
+}
+
+template <typename Key, typename Value>
+void SortedFileWriter<Key, Value>::writePendingOutput(bool all) {
+    size_t size = _pendingOutput.size();
+    if (!all) {
+        // Hold back the tail past the last aligned offset for the next write.
+        size -= (_pendingOutputOffset + std::streamoff(size)) % kWriteAlignment;
+    }
+
+    if (size == 0)
+        return;
+
     try {
-        _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
-        _file.write(outBuffer, std::abs(size));
+        _file.write(_pendingOutput.data(), size);
     } catch (const std::exception&) {
         msgasserted(16821,
                     str::stream() << "error writing to file \"" << _fileFullPath
                                   << "\": " << sorter::myErrnoWithDescription());
     }
 
-    _buffer.reset();
+    _pendingOutput.erase(0, size);
+    _pendingOutputOffset += size;
 }
 
 template <typename Key, typename Value>
 SortIteratorInterface<Key, Value>* SortedFileWriter<Key, Value>::done() {
     spill();
+    writePendingOutput(true);
     std::streampos currentFileOffset = _file.tellp();
     uassert(50980,
             str::stream() << "error fetching current file descriptor offset in file \""
@@ -1123,8 +1252,13 @@ SortIteratorInterface<Key, Value>* SortedFileWriter<Key, Value>::done() {
     _fileEndOffset = currentFileOffset < _fileStartOffset ? _fileStartOffset : currentFileOffset;
     _file.close();
 
-    return new sorter::FileIterator<Key, Value>(
-        _fileFullPath, _fileStartOffset, _fileEndOffset, _settings, _checksum);
+    return new sorter::FileIterator<Key, Value>(_fileFullPath,
+                                                _fileStartOffset,
+                                                _fileEndOffset,
+                                                _settings,
+                                                _checksum,
+                                                _compression,
+                                                _fileStats);
 }
 
 //
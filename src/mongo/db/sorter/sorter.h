@@ -31,6 +31,7 @@
 
 #include <third_party/murmurhash3/MurmurHash3.h>
 
+#include <boost/optional.hpp>
 #include <deque>
 #include <fstream>
 #include <memory>
@@ -40,6 +41,7 @@
 
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/sorter/sorter_gen.h"
+#include "mongo/db/sorter/sorter_stats.h"
 #include "mongo/util/bufreader.h"
 
 /**
@@ -108,6 +110,14 @@ struct SortOptions {
     // extSortAllowed is true.
     std::string tempDir;
 
+    // The codec used to compress data spilled to disk. Defaults to the 'sorterSpillCompressor'
+    // server parameter when unset.
+    boost::optional<SorterCompressionEnum> compression;
+
+    // If set, accumulates statistics about the data spilled to disk and read back. Must outlive
+    // the Sorter and its iterators.
+    SorterFileStats* fileStats = nullptr;
+
     SortOptions() : limit(0), maxMemoryUsageBytes(64 * 1024 * 1024), extSortAllowed(false) {}
 
     // Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
@@ -131,6 +141,16 @@ struct SortOptions {
         tempDir = newTempDir;
         return *this;
     }
+
+    SortOptions& Compression(SorterCompressionEnum newCompression) {
+        compression = newCompression;
+        return *this;
+    }
+
+    SortOptions& FileStats(SorterFileStats* newFileStats) {
+        fileStats = newFileStats;
+        return *this;
+    }
 };
 
 /**
@@ -327,11 +347,26 @@ public:
 private:
     void spill();
 
+    /**
+     * Writes the pending output to the file. Unless 'all' is true, only writes up to the last
+     * kWriteAlignment boundary of the file offset and keeps the remainder pending.
+     */
+    void writePendingOutput(bool all);
+
     const Settings _settings;
+    const SorterCompressionEnum _compression;
+    SorterFileStats* const _fileStats;
     std::string _fileFullPath;
     std::ofstream _file;
     BufBuilder _buffer;
 
+    // Blocks which have been spilled but not yet written to the file. Blocks are small compared to
+    // what the file system handles efficiently, so they are written together in larger chunks.
+    std::string _pendingOutput;
+
+    // The file offset at which the pending output will be written.
+    std::streamoff _pendingOutputOffset;
+
     // Keeps track of the hash of all data objects spilled to disk. Passed to the FileIterator
     // to ensure data has not been corrupted after reading from disk.
     uint32_t _checksum = 0;
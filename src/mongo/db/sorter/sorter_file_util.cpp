@@ -0,0 +1,188 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/sorter/sorter_file_util.h"
+
+#include <snappy.h>
+#include <zstd.h>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/sorter/sorter_parameters_gen.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/str.h"
+
+namespace mongo::sorter {
+namespace {
+
+// Favors speed over compression ratio, since spilling is on the critical path of the sort.
+constexpr int kZstdCompressionLevel = 1;
+
+Counter64 spilledBytesCounter;
+Counter64 spilledUncompressedBytesCounter;
+Counter64 mergeReadWaitMicrosCounter;
+
+ServerStatusMetricField<Counter64> displaySpilledBytes("sorter.spilledBytes",
+                                                       &spilledBytesCounter);
+ServerStatusMetricField<Counter64> displaySpilledUncompressedBytes(
+    "sorter.spilledUncompressedBytes", &spilledUncompressedBytesCounter);
+ServerStatusMetricField<Counter64> displayMergeReadWaitMicros("sorter.mergeReadWaitMicros",
+                                                              &mergeReadWaitMicrosCounter);
+
+/**
+ * Returns the pool reading spilled data ahead of the merge, or nullptr if read-ahead is disabled.
+ * The pool is created on first use and intentionally leaked, so that Sorters destroyed during
+ * shutdown never race with its destruction.
+ */
+ThreadPool* getReadAheadPool() {
+    static ThreadPool* const pool = []() -> ThreadPool* {
+        if (sorterReadAheadThreads == 0) {
+            return nullptr;
+        }
+
+        ThreadPool::Options options;
+        options.poolName = "SorterReadAhead";
+        options.threadNamePrefix = "SorterReadAhead-";
+        options.minThreads = 0;
+        options.maxThreads = sorterReadAheadThreads;
+        auto pool = new ThreadPool(std::move(options));
+        pool->startup();
+        return pool;
+    }();
+    return pool;
+}
+
+}  // namespace
+
+SorterCompressionEnum getDefaultSpillCompression() {
+    return SorterCompression_parse(IDLParserErrorContext("sorterSpillCompressor"),
+                                   sorterSpillCompressor.get());
+}
+
+Status validateSorterSpillCompressor(const std::string& compressor) {
+    try {
+        SorterCompression_parse(IDLParserErrorContext("sorterSpillCompressor"), compressor);
+    } catch (const DBException& ex) {
+        return ex.toStatus();
+    }
+    return Status::OK();
+}
+
+void compressSpilledBlock(SorterCompressionEnum codec,
+                          const char* data,
+                          size_t size,
+                          std::string* out) {
+    switch (codec) {
+        case SorterCompressionEnum::kSnappy:
+            snappy::Compress(data, size, out);
+            return;
+        case SorterCompressionEnum::kZstd: {
+            out->resize(ZSTD_compressBound(size));
+            size_t compressedSize =
+                ZSTD_compress(out->data(), out->size(), data, size, kZstdCompressionLevel);
+            uassert(5150810,
+                    str::stream() << "Failed to compress spilled data: "
+                                  << ZSTD_getErrorName(compressedSize),
+                    !ZSTD_isError(compressedSize));
+            out->resize(compressedSize);
+            return;
+        }
+        case SorterCompressionEnum::kNone:
+            break;
+    }
+    MONGO_UNREACHABLE;
+}
+
+std::unique_ptr<char[]> decompressSpilledBlock(SorterCompressionEnum codec,
+                                               const char* data,
+                                               size_t size,
+                                               size_t* uncompressedSize) {
+    switch (codec) {
+        case SorterCompressionEnum::kSnappy: {
+            dassert(snappy::IsValidCompressedBuffer(data, size));
+            uassert(17061,
+                    "couldn't get uncompressed length",
+                    snappy::GetUncompressedLength(data, size, uncompressedSize));
+
+            std::unique_ptr<char[]> out(new char[*uncompressedSize]);
+            uassert(17062, "decompression failed", snappy::RawUncompress(data, size, out.get()));
+            return out;
+        }
+        case SorterCompressionEnum::kZstd: {
+            auto contentSize = ZSTD_getFrameContentSize(data, size);
+            uassert(5150811,
+                    "couldn't get uncompressed length",
+                    contentSize != ZSTD_CONTENTSIZE_UNKNOWN &&
+                        contentSize != ZSTD_CONTENTSIZE_ERROR);
+
+            std::unique_ptr<char[]> out(new char[contentSize]);
+            *uncompressedSize = ZSTD_decompress(out.get(), contentSize, data, size);
+            uassert(5150812,
+                    str::stream() << "decompression failed: "
+                                  << ZSTD_getErrorName(*uncompressedSize),
+                    !ZSTD_isError(*uncompressedSize) && *uncompressedSize == contentSize);
+            return out;
+        }
+        case SorterCompressionEnum::kNone:
+            break;
+    }
+    MONGO_UNREACHABLE;
+}
+
+bool scheduleSpillReadAhead(unique_function<void(Status)> task) {
+    auto pool = getReadAheadPool();
+    if (!pool) {
+        return false;
+    }
+
+    pool->schedule(std::move(task));
+    return true;
+}
+
+void recordSpilledBlock(SorterFileStats* stats, long long uncompressedBytes, long long bytes) {
+    if (stats) {
+        stats->bytesSpilledUncompressed += uncompressedBytes;
+        stats->bytesSpilled += bytes;
+    }
+    spilledUncompressedBytesCounter.increment(uncompressedBytes);
+    spilledBytesCounter.increment(bytes);
+}
+
+void recordMergeReadWait(SorterFileStats* stats, Microseconds waitTime) {
+    if (stats) {
+        stats->mergeReadWaitTime += waitTime;
+    }
+    mergeReadWaitMicrosCounter.increment(durationCount<Microseconds>(waitTime));
+}
+
+}  // namespace mongo::sorter
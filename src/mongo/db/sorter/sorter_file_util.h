@@ -0,0 +1,94 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "mongo/base/status.h"
+#include "mongo/db/sorter/sorter_gen.h"
+#include "mongo/db/sorter/sorter_stats.h"
+#include "mongo/util/functional.h"
+
+/**
+ * Helpers shared by every instantiation of the Sorter for reading and writing spill files. The
+ * Sorter itself is compiled into each of its users (see sorter.cpp), so anything which must exist
+ * once per process lives here instead.
+ */
+namespace mongo::sorter {
+
+/**
+ * Returns the codec to compress spilled data with when the SortOptions do not choose one, as set
+ * by the 'sorterSpillCompressor' server parameter.
+ */
+SorterCompressionEnum getDefaultSpillCompression();
+
+/**
+ * Validator for the 'sorterSpillCompressor' server parameter.
+ */
+Status validateSorterSpillCompressor(const std::string& compressor);
+
+/**
+ * Compresses 'size' bytes starting at 'data' with 'codec' into 'out'. The codec must not be kNone.
+ */
+void compressSpilledBlock(SorterCompressionEnum codec,
+                          const char* data,
+                          size_t size,
+                          std::string* out);
+
+/**
+ * Decompresses a block written by compressSpilledBlock() with the same codec. Stores the size of
+ * the returned data in 'uncompressedSize'. Throws if the block is corrupt.
+ */
+std::unique_ptr<char[]> decompressSpilledBlock(SorterCompressionEnum codec,
+                                               const char* data,
+                                               size_t size,
+                                               size_t* uncompressedSize);
+
+/**
+ * Schedules 'task' on the process-wide pool used to read spilled data ahead of the merge. The task
+ * runs with a non-OK status if the pool is shutting down. Returns false without running the task
+ * if read-ahead is disabled through the 'sorterReadAheadThreads' server parameter.
+ */
+bool scheduleSpillReadAhead(unique_function<void(Status)> task);
+
+/**
+ * Records a block of spilled data in 'stats', if set, and in the serverStatus sorter metrics.
+ */
+void recordSpilledBlock(SorterFileStats* stats, long long uncompressedBytes, long long bytes);
+
+/**
+ * Records time spent waiting for spilled data to be read back in 'stats', if set, and in the
+ * serverStatus sorter metrics.
+ */
+void recordMergeReadWait(SorterFileStats* stats, Microseconds waitTime);
+
+}  // namespace mongo::sorter
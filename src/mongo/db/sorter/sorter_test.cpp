@@ -314,6 +314,43 @@ public:
     }
 };
 
+class SortedFileWriterCompressionTests : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("sortedFileWriterCompressionTests");
+        for (auto compression : {SorterCompressionEnum::kNone,
+                                 SorterCompressionEnum::kSnappy,
+                                 SorterCompressionEnum::kZstd}) {
+            SorterFileStats fileStats;
+            const SortOptions opts = SortOptions()
+                                         .TempDir(tempDir.path())
+                                         .Compression(compression)
+                                         .FileStats(&fileStats);
+            std::string fileName = opts.tempDir + "/" + nextFileName();
+            SortedFileWriter<IntWrapper, IntWrapper> sorter(opts, fileName, 0);
+            for (int i = 0; i < 1000 * 1000; i++)
+                sorter.addAlreadySorted(i, -i);
+
+            std::shared_ptr<IWIterator> iter(sorter.done());
+            const auto range = iter->getRange();
+            ASSERT(range.getCompression() == compression);
+            ASSERT_EQ(fileStats.bytesSpilled, range.getEndOffset());
+            ASSERT_GT(fileStats.bytesSpilledUncompressed, 0);
+            if (compression == SorterCompressionEnum::kNone) {
+                ASSERT_GT(fileStats.bytesSpilled, fileStats.bytesSpilledUncompressed);
+            } else {
+                ASSERT_LT(fileStats.bytesSpilled, fileStats.bytesSpilledUncompressed);
+            }
+
+            ASSERT_ITERATORS_EQUIVALENT(iter, make_shared<IntIterator>(0, 1000 * 1000));
+            iter.reset();
+
+            ASSERT_TRUE(boost::filesystem::remove(fileName));
+        }
+
+        ASSERT(boost::filesystem::is_empty(tempDir.path()));
+    }
+};
 
 class MergeIteratorTests {
 public:
@@ -628,6 +665,7 @@ public:
     void setupTests() override {
         add<InMemIterTests>();
         add<SortedFileWriterAndFileIteratorTests>();
+        add<SortedFileWriterCompressionTests>();
         add<MergeIteratorTests>();
         add<SorterTests::Basic>();
         add<SorterTests::Limit>();
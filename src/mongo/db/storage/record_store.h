@@ -30,9 +30,11 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <vector>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/bson/mutable/damage_vector.h"
+#include "mongo/bson/util/builder.h"
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/record_id.h"
@@ -60,6 +62,77 @@ struct Record {
     RecordData data;
 };
 
+/**
+ * A caller-provided, reusable buffer of Records filled by RecordCursor::nextBatch().
+ *
+ * The data of every record is copied into a single arena owned by the batch, so filling a batch
+ * does not allocate once the arena has grown to its working size. The RecordData returned by
+ * data() is unowned and remains valid, regardless of any calls on the cursor, until the batch is
+ * cleared or refilled.
+ */
+class RecordBatch {
+    RecordBatch(const RecordBatch&) = delete;
+    RecordBatch& operator=(const RecordBatch&) = delete;
+
+public:
+    // Filling stops once the arena holds at least this many bytes.
+    static constexpr size_t kDefaultMaxBytes = 1024 * 1024;
+
+    explicit RecordBatch(size_t maxBytes = kDefaultMaxBytes) : _maxBytes(maxBytes) {}
+
+    size_t size() const {
+        return _ids.size();
+    }
+
+    bool empty() const {
+        return _ids.empty();
+    }
+
+    /**
+     * Returns true if no more records should be added because the byte budget is used up.
+     */
+    bool isFull() const {
+        return static_cast<size_t>(_arena.len()) >= _maxBytes;
+    }
+
+    const RecordId& id(size_t i) const {
+        return _ids[i];
+    }
+
+    RecordData data(size_t i) const {
+        const auto& [offset, size] = _spans[i];
+        return RecordData(_arena.buf() + offset, size);
+    }
+
+    /**
+     * Appends a record, copying 'size' bytes from 'data' into the arena.
+     */
+    void append(const RecordId& id, const char* data, int size) {
+        _ids.push_back(id);
+        _spans.emplace_back(_arena.len(), size);
+        _arena.appendBuf(data, size);
+    }
+
+    /**
+     * Removes all records. Keeps the memory of the arena for reuse, unless it grew beyond the
+     * byte budget because of a single large record.
+     */
+    void clear() {
+        _ids.clear();
+        _spans.clear();
+        _arena.reset(2 * _maxBytes);
+    }
+
+private:
+    const size_t _maxBytes;
+    std::vector<RecordId> _ids;
+
+    // The offset and size of the data of each record in '_arena'.
+    std::vector<std::pair<int, int>> _spans;
+
+    BufBuilder _arena;
+};
+
 /**
  * Retrieves Records from a RecordStore.
  *
@@ -111,6 +184,29 @@ public:
      */
     virtual boost::optional<Record> next() = 0;
 
+    /**
+     * Clears 'batch' and fills it with up to 'maxRecords' records, as if by calling next() for
+     * each of them, until the cursor reaches EOF or the batch is full. Returns the number of
+     * records in the batch, which is zero only at EOF.
+     *
+     * If this throws a WriteConflictException, 'batch' holds the records read before the
+     * conflict. Once the cursor has been saved and restored, it continues after the last of them.
+     *
+     * Implementations may override this to amortize per-call work, such as transaction and
+     * visibility setup, over the whole batch.
+     */
+    virtual size_t nextBatch(RecordBatch* batch, size_t maxRecords) {
+        batch->clear();
+        while (batch->size() < maxRecords && !batch->isFull()) {
+            auto record = next();
+            if (!record) {
+                break;
+            }
+            batch->append(record->id, record->data.data(), record->data.size());
+        }
+        return batch->size();
+    }
+
     //
     // Saving and restoring state
     //
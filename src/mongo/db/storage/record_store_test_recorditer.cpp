@@ -32,6 +32,7 @@
 #include "mongo/db/storage/record_store_test_harness.h"
 
 #include <algorithm>
+#include <vector>
 
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/record_id.h"
@@ -483,5 +484,88 @@ TEST(RecordStoreTestHarness, SeekExactForMissingRecordReturnsNone) {
     ASSERT_FALSE(recordStore->findRecord(opCtx.get(), recordIds[1], &outputData));
 }
 
+// nextBatch() must return the same records as next(), in the same order, and stop at 'maxRecords'
+// and at EOF. The data of a batch must remain valid while the cursor moves on.
+TEST(RecordStoreTestHarness, NextBatchMatchesNext) {
+    const auto harnessHelper{newRecordStoreHarnessHelper()};
+    auto recordStore = harnessHelper->newNonCappedRecordStore();
+    ServiceContext::UniqueOperationContext opCtx{harnessHelper->newOperationContext()};
+
+    const int nToInsert = 10;
+    for (int i = 0; i < nToInsert; ++i) {
+        StringBuilder sb;
+        sb << "record " << i;
+        string data = sb.str();
+
+        WriteUnitOfWork uow{opCtx.get()};
+        auto res =
+            recordStore->insertRecord(opCtx.get(), data.c_str(), data.size() + 1, Timestamp{});
+        ASSERT_OK(res.getStatus());
+        uow.commit();
+    }
+
+    for (bool direction : {true, false}) {
+        std::vector<std::pair<RecordId, std::string>> expected;
+        auto cursor = recordStore->getCursor(opCtx.get(), direction);
+        while (auto record = cursor->next()) {
+            expected.emplace_back(record->id, record->data.data());
+        }
+        ASSERT_EQUALS(static_cast<size_t>(nToInsert), expected.size());
+
+        cursor = recordStore->getCursor(opCtx.get(), direction);
+        RecordBatch batch;
+        std::vector<std::pair<RecordId, std::string>> actual;
+        ASSERT_EQUALS(4U, cursor->nextBatch(&batch, 4));
+        const auto firstData = batch.data(0);
+        const std::string firstCopy = firstData.data();
+
+        // Mixing next() with batches must continue from the end of the last batch.
+        auto record = cursor->next();
+        ASSERT(record);
+        ASSERT_EQUALS(expected[4].first, record->id);
+        ASSERT_EQUALS(firstCopy, firstData.data());
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            actual.emplace_back(batch.id(i), batch.data(i).data());
+        }
+        actual.emplace_back(record->id, record->data.data());
+
+        ASSERT_EQUALS(5U, cursor->nextBatch(&batch, 100));
+        for (size_t i = 0; i < batch.size(); ++i) {
+            actual.emplace_back(batch.id(i), batch.data(i).data());
+        }
+        ASSERT_EQUALS(0U, cursor->nextBatch(&batch, 100));
+        ASSERT(batch.empty());
+        ASSERT(!cursor->next());
+
+        ASSERT(expected == actual);
+    }
+}
+
+// nextBatch() must stop filling a batch once its byte budget is used up, but always return at
+// least one record when not at EOF.
+TEST(RecordStoreTestHarness, NextBatchRespectsByteBudget) {
+    const auto harnessHelper{newRecordStoreHarnessHelper()};
+    auto recordStore = harnessHelper->newNonCappedRecordStore();
+    ServiceContext::UniqueOperationContext opCtx{harnessHelper->newOperationContext()};
+
+    const std::string data(100, 'x');
+    for (int i = 0; i < 3; ++i) {
+        WriteUnitOfWork uow{opCtx.get()};
+        ASSERT_OK(
+            recordStore->insertRecord(opCtx.get(), data.c_str(), data.size() + 1, Timestamp{})
+                .getStatus());
+        uow.commit();
+    }
+
+    auto cursor = recordStore->getCursor(opCtx.get());
+    RecordBatch batch(10);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQUALS(1U, cursor->nextBatch(&batch, 100));
+        ASSERT_EQUALS(data, batch.data(0).data());
+    }
+    ASSERT_EQUALS(0U, cursor->nextBatch(&batch, 100));
+}
+
 }  // namespace
 }  // namespace mongo
@@ -90,7 +90,7 @@
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/background.h"
 #include "mongo/util/concurrency/idle_thread_block.h"
-#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/concurrency/priority_ticketholder.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/processinfo.h"
@@ -254,8 +254,38 @@ std::string toString(const StorageEngine::OldestActiveTransactionTimestampResult
 }
 
 namespace {
-TicketHolder openWriteTransaction(128);
-TicketHolder openReadTransaction(128);
+PriorityTicketHolder openWriteTransaction(128);
+PriorityTicketHolder openReadTransaction(128);
+
+/**
+ * Samples the usage of 'holder' and, if adaptive sizing is enabled, resizes it as chosen by
+ * 'sizer'.
+ */
+void resizeTicketPool(StringData name, PriorityTicketHolder& holder, TicketPoolSizer& sizer) {
+    auto sample = holder.takeSample();
+    if (!gWiredTigerAdaptiveTicketPoolSizing.load()) {
+        return;
+    }
+
+    const auto maxSize = gWiredTigerAdaptiveTicketPoolMaximum.load();
+    const auto minSize = std::min(gWiredTigerAdaptiveTicketPoolMinimum.load(), maxSize);
+    const auto currentSize = holder.outof();
+    const auto newSize = sizer.nextSize(currentSize, sample, minSize, maxSize);
+    if (newSize == currentSize) {
+        return;
+    }
+
+    invariant(holder.resize(newSize));
+    LOGV2_DEBUG(5150808,
+                1,
+                "Resized ticket pool",
+                "pool"_attr = name,
+                "previousSize"_attr = currentSize,
+                "newSize"_attr = newSize,
+                "released"_attr = sample.released,
+                "elapsed"_attr = sample.elapsed,
+                "ticketHeldTime"_attr = sample.ticketHeldTime);
+}
 }  // namespace
 
 OpenWriteTransactionParam::OpenWriteTransactionParam(StringData name, ServerParameterType spt)
@@ -517,6 +547,19 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
 
     Locker::setGlobalThrottling(&openReadTransaction, &openWriteTransaction);
 
+    if (hasGlobalServiceContext()) {
+        if (auto runner = getGlobalServiceContext()->getPeriodicRunner()) {
+            _ticketPoolResizer = runner->makeJob(
+                {"WiredTigerTicketPoolResizer",
+                 [readSizer = TicketPoolSizer(), writeSizer = TicketPoolSizer()](Client*) mutable {
+                     resizeTicketPool("read"_sd, openReadTransaction, readSizer);
+                     resizeTicketPool("write"_sd, openWriteTransaction, writeSizer);
+                 },
+                 Seconds(1)});
+            _ticketPoolResizer.start();
+        }
+    }
+
     _runTimeConfigParam.reset(new WiredTigerEngineRuntimeConfigParameter(
         "wiredTigerEngineRuntimeConfig", ServerParameterType::kRuntimeOnly));
     _runTimeConfigParam->_data.second = this;
@@ -540,16 +583,12 @@ void WiredTigerKVEngine::appendGlobalStats(BSONObjBuilder& b) {
     BSONObjBuilder bb(b.subobjStart("concurrentTransactions"));
     {
         BSONObjBuilder bbb(bb.subobjStart("write"));
-        bbb.append("out", openWriteTransaction.used());
-        bbb.append("available", openWriteTransaction.available());
-        bbb.append("totalTickets", openWriteTransaction.outof());
+        openWriteTransaction.appendStats(bbb);
         bbb.done();
     }
     {
         BSONObjBuilder bbb(bb.subobjStart("read"));
-        bbb.append("out", openReadTransaction.used());
-        bbb.append("available", openReadTransaction.available());
-        bbb.append("totalTickets", openReadTransaction.outof());
+        openReadTransaction.appendStats(bbb);
         bbb.done();
     }
     bb.done();
@@ -655,6 +694,10 @@ void WiredTigerKVEngine::cleanShutdown() {
         return;
     }
 
+    if (_ticketPoolResizer) {
+        _ticketPoolResizer.stop();
+    }
+
     // these must be the last things we do before _conn->close();
     if (_sessionSweeper) {
         LOGV2(22318, "Shutting down session sweeper thread");
@@ -47,6 +47,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/util/elapsed_tracker.h"
+#include "mongo/util/periodic_runner.h"
 
 namespace mongo {
 
@@ -469,6 +470,9 @@ private:
 
     std::unique_ptr<WiredTigerSessionSweeper> _sessionSweeper;
 
+    // Periodically resizes the read and write ticket pools when adaptive sizing is enabled.
+    PeriodicJobAnchor _ticketPoolResizer;
+
     std::string _rsOptions;
     std::string _indexOptions;
 
@@ -2132,6 +2132,42 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::next() {
     WT_CURSOR* c = _cursor->get();
 
     RecordId id;
+    if (!_advance(c, &id)) {
+        return {};
+    }
+
+    WT_ITEM value;
+    invariantWTOK(c->get_value(c, &value));
+
+    _lastReturnedId = id;
+    return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
+}
+
+size_t WiredTigerRecordStoreCursorBase::nextBatch(RecordBatch* batch, size_t maxRecords) {
+    invariant(_hasRestored);
+    batch->clear();
+    if (_eof)
+        return 0;
+
+    // The transaction only needs to be checked once for the whole batch. See next().
+    WiredTigerRecoveryUnit::get(_opCtx)->getSession();
+
+    WT_CURSOR* c = _cursor->get();
+
+    RecordId id;
+    while (batch->size() < maxRecords && !batch->isFull() && _advance(c, &id)) {
+        // The value is only valid until the cursor moves, so it is copied into the batch.
+        WT_ITEM value;
+        invariantWTOK(c->get_value(c, &value));
+
+        _lastReturnedId = id;
+        batch->append(id, static_cast<const char*>(value.data), static_cast<int>(value.size));
+    }
+    return batch->size();
+}
+
+bool WiredTigerRecordStoreCursorBase::_advance(WT_CURSOR* c, RecordId* id) {
+    *id = RecordId();
     if (!_skipNextAdvance) {
         // Nothing after the next line can throw WCEs.
         // Note that an unpositioned (or eof) WT_CURSOR returns the first/last entry in the
@@ -2140,31 +2176,31 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::next() {
             _opCtx, [&] { return _forward ? c->next(c) : c->prev(c); });
         if (advanceRet == WT_NOTFOUND) {
             _eof = true;
-            return {};
+            return false;
         }
         invariantWTOK(advanceRet);
-        if (hasWrongPrefix(c, &id)) {
+        if (hasWrongPrefix(c, id)) {
             _eof = true;
-            return {};
+            return false;
         }
     }
 
     _skipNextAdvance = false;
-    if (!id.isValid()) {
-        id = getKey(c);
+    if (!id->isValid()) {
+        *id = getKey(c);
     }
 
-    if (_oplogVisibleTs && id.repr() > *_oplogVisibleTs) {
+    if (_oplogVisibleTs && id->repr() > *_oplogVisibleTs) {
         _eof = true;
-        return {};
+        return false;
     }
 
-    if (_forward && _lastReturnedId >= id) {
+    if (_forward && _lastReturnedId >= *id) {
         LOGV2(22406,
               "WTCursor::next -- c->next_key ( {next}) was not greater than _lastReturnedId "
               "({last}) which is a bug.",
               "WTCursor::next -- next was not greater than last which is a bug",
-              "next"_attr = id,
+              "next"_attr = *id,
               "last"_attr = _lastReturnedId);
 
         // Crash when testing diagnostics are enabled.
@@ -2175,11 +2211,7 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::next() {
         throw WriteConflictException();
     }
 
-    WT_ITEM value;
-    invariantWTOK(c->get_value(c, &value));
-
-    _lastReturnedId = id;
-    return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
+    return true;
 }
 
 boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordId& id) {
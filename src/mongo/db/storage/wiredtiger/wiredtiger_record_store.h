@@ -438,6 +438,8 @@ public:
 
     boost::optional<Record> next();
 
+    size_t nextBatch(RecordBatch* batch, size_t maxRecords);
+
     boost::optional<Record> seekExact(const RecordId& id);
 
     void save();
@@ -481,6 +483,12 @@ protected:
 private:
     bool isVisible(const RecordId& id);
 
+    /**
+     * Moves the cursor to the next record and sets 'id' to its RecordId. Returns false at EOF.
+     * The caller is responsible for ensuring that a transaction is open.
+     */
+    bool _advance(WT_CURSOR* c, RecordId* id);
+
     /**
      * This value is used for visibility calculations on what oplog entries can be returned to a
      * client. This value *must* be initialized/updated *before* a WiredTiger snapshot is
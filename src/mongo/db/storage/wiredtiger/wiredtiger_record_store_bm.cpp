@@ -0,0 +1,162 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/base/checked_cast.h"
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/repl/repl_settings.h"
+#include "mongo/db/repl/replication_coordinator_mock.h"
+#include "mongo/db/service_context_test_fixture.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/util/clock_source_mock.h"
+
+namespace mongo {
+namespace {
+
+const auto kNumRecords = 10 * 1000;
+
+class WiredTigerRecordStoreHelper : public ScopedGlobalServiceContextForTest {
+public:
+    explicit WiredTigerRecordStoreHelper(int recordSize)
+        : _dbpath("wt_test"),
+          _engine(kWiredTigerEngineName,
+                  _dbpath.path(),
+                  &_cs,
+                  "",
+                  1,
+                  0,
+                  false,
+                  false,
+                  false,
+                  false) {
+        repl::ReplicationCoordinator::set(getServiceContext(),
+                                          std::make_unique<repl::ReplicationCoordinatorMock>(
+                                              getServiceContext(), repl::ReplSettings()));
+        _engine.notifyStartupComplete();
+
+        const std::string ns = "a.b";
+        auto opCtx = newOperationContext();
+        auto ru = WiredTigerRecoveryUnit::get(opCtx.get());
+        auto config = WiredTigerRecordStore::generateCreateString(
+            kWiredTigerEngineName, ns, CollectionOptions(), "", false /* prefixed */);
+        invariant(config.isOK());
+        {
+            WriteUnitOfWork uow(opCtx.get());
+            WT_SESSION* s = ru->getSession()->getSession();
+            const std::string uri = WiredTigerKVEngine::kTableUriPrefix + ns;
+            invariantWTOK(s->create(s, uri.c_str(), config.getValue().c_str()));
+            uow.commit();
+        }
+
+        WiredTigerRecordStore::Params params;
+        params.ns = ns;
+        params.ident = ns;
+        params.engineName = kWiredTigerEngineName;
+        params.isCapped = false;
+        params.isEphemeral = false;
+        params.cappedMaxSize = -1;
+        params.cappedMaxDocs = -1;
+        params.cappedCallback = nullptr;
+        params.sizeStorer = nullptr;
+        params.tracksSizeAdjustments = true;
+        auto rs = std::make_unique<StandardWiredTigerRecordStore>(&_engine, opCtx.get(), params);
+        rs->postConstructorInit(opCtx.get());
+        _rs = std::move(rs);
+
+        const std::string data(recordSize, 'x');
+        WriteUnitOfWork uow(opCtx.get());
+        for (int i = 0; i < kNumRecords; ++i) {
+            invariant(
+                _rs->insertRecord(opCtx.get(), data.c_str(), data.size(), Timestamp()).getStatus());
+        }
+        uow.commit();
+    }
+
+    std::unique_ptr<OperationContext> newOperationContext() {
+        return std::make_unique<OperationContextNoop>(
+            checked_cast<WiredTigerRecoveryUnit*>(_engine.newRecoveryUnit()));
+    }
+
+    RecordStore* recordStore() const {
+        return _rs.get();
+    }
+
+private:
+    unittest::TempDir _dbpath;
+    ClockSourceMock _cs;
+    WiredTigerKVEngine _engine;
+    std::unique_ptr<RecordStore> _rs;
+};
+
+void BM_RecordCursorNext(benchmark::State& state) {
+    WiredTigerRecordStoreHelper helper(state.range(0));
+    auto opCtx = helper.newOperationContext();
+    for (auto _ : state) {
+        auto cursor = helper.recordStore()->getCursor(opCtx.get());
+        while (auto record = cursor->next()) {
+            benchmark::DoNotOptimize(record->data.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kNumRecords);
+}
+
+void BM_RecordCursorNextBatch(benchmark::State& state) {
+    WiredTigerRecordStoreHelper helper(state.range(0));
+    auto opCtx = helper.newOperationContext();
+    RecordBatch batch;
+    for (auto _ : state) {
+        auto cursor = helper.recordStore()->getCursor(opCtx.get());
+        while (cursor->nextBatch(&batch, state.range(1))) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                benchmark::DoNotOptimize(batch.data(i).data());
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kNumRecords);
+}
+
+BENCHMARK(BM_RecordCursorNext)->Arg(64)->Arg(1024);
+// Arguments are the record size in bytes and, for batched iteration, the records per batch.
+BENCHMARK(BM_RecordCursorNextBatch)
+    ->Args({64, 16})
+    ->Args({64, 64})
+    ->Args({64, 1024})
+    ->Args({1024, 64})
+    ->Args({1024, 1024});
+
+}  // namespace
+}  // namespace mongo
@@ -31,6 +31,7 @@
 
 #include "mongo/dbtests/mock/mock_dbclient_connection.h"
 
+#include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/client/dbclient_mockcursor.h"
 #include "mongo/db/query/cursor_response.h"
 #include "mongo/rpc/get_status_from_command_result.h"
@@ -133,6 +134,26 @@ std::unique_ptr<mongo::DBClientCursor> MockDBClientConnection::query(
             }
         }
 
+        // A simple mock implementation of an '_id' index scan bounded by '$min' and '$max', which
+        // only returns the documents whose '_id' falls between the bounds.
+        if (queryBson.hasField("$min") || queryBson.hasField("$max")) {
+            const auto& comparator = SimpleBSONObjComparator::kInstance;
+            BSONArrayBuilder builder;
+            for (auto&& elem : result) {
+                auto id = elem.Obj()["_id"].wrap();
+                if (queryBson.hasField("$min") &&
+                    comparator.evaluate(id < queryBson["$min"].Obj())) {
+                    continue;
+                }
+                if (queryBson.hasField("$max") &&
+                    !comparator.evaluate(id < queryBson["$max"].Obj())) {
+                    continue;
+                }
+                builder.append(elem.Obj());
+            }
+            result = BSONArray(builder.obj());
+        }
+
         bool provideResumeToken = false;
         if (queryBson.hasField("$_requestResumeToken")) {
             provideResumeToken = true;
@@ -50,6 +50,7 @@
 #include "mongo/db/storage/record_store.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/fail_point.h"
 
 namespace query_stage_collection_scan {
@@ -437,4 +438,40 @@ TEST_F(QueryStageCollectionScanTest, QueryTestCollscanResumeAfterRecordIdSeekFai
     ASSERT_THROWS_CODE(ps->work(&id), DBException, ErrorCodes::KeyNotFound);
 }
 
+// Verify that an unbounded scan lowers the ticket priority of its operation only while it is
+// yielding.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanDeprioritizesOnlyWhileYielding) {
+    dbtests::WriteContextForTests ctx(&_opCtx, nss.ns());
+    const CollectionPtr& coll = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = false;
+
+    WorkingSet ws;
+    unique_ptr<PlanStage> scan(new CollectionScan(_expCtx.get(), coll, params, &ws, nullptr));
+    WorkingSetID id = WorkingSet::INVALID_ID;
+    scan->work(&id);
+    ASSERT(TicketPriority::kNormal == getTicketPriority(&_opCtx));
+
+    scan->saveState();
+    ASSERT(TicketPriority::kLow == getTicketPriority(&_opCtx));
+    scan->restoreState();
+    ASSERT(TicketPriority::kNormal == getTicketPriority(&_opCtx));
+
+    // A scan handed to another operation leaves the priority of this one as it was.
+    scan->saveState();
+    scan->detachFromOperationContext();
+    ASSERT(TicketPriority::kNormal == getTicketPriority(&_opCtx));
+    scan->reattachToOperationContext(&_opCtx);
+    scan->restoreState();
+
+    // An operation which has a priority of its own keeps it.
+    ScopedTicketPriority highPriority(&_opCtx, TicketPriority::kHigh);
+    scan->saveState();
+    ASSERT(TicketPriority::kHigh == getTicketPriority(&_opCtx));
+    scan->restoreState();
+    ASSERT(TicketPriority::kHigh == getTicketPriority(&_opCtx));
+}
+
 }  // namespace query_stage_collection_scan
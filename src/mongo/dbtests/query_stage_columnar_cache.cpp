@@ -0,0 +1,426 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file tests SBE collection scans served by a columnar cache, see db/query/columnar_cache.h.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/exec/sbe/stages/plan_stats.h"
+#include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/columnar_cache.h"
+#include "mongo/db/query/plan_executor_sbe.h"
+#include "mongo/db/query/plan_yield_policy_sbe.h"
+#include "mongo/db/query/query_planner.h"
+#include "mongo/db/query/query_planner_params.h"
+#include "mongo/db/query/stage_builder_util.h"
+#include "mongo/dbtests/dbtests.h"
+#include "mongo/idl/server_parameter.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/platform/random.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
+
+namespace query_stage_columnar_cache {
+
+static const NamespaceString nss{"unittests.QueryStageColumnarCache"};
+
+// Enough documents for the cache to hold several row groups.
+static const int kNumDocs = 2 * ColumnarCollectionCache::kRowGroupSize + 100;
+
+class QueryStageColumnarCacheTest : public unittest::Test {
+public:
+    QueryStageColumnarCacheTest() : _client(&_opCtx) {
+        setCachedCollections(BSON(nss.ns() << BSON_ARRAY("_id"
+                                                         << "a"
+                                                         << "b")));
+
+        dbtests::WriteContextForTests ctx(&_opCtx, nss.ns());
+        std::vector<BSONObj> docs;
+        for (int id = 0; id < kNumDocs; ++id) {
+            docs.push_back(makeDoc(id, 0));
+        }
+        _client.insert(nss.ns(), docs);
+    }
+
+    virtual ~QueryStageColumnarCacheTest() {
+        {
+            dbtests::WriteContextForTests ctx(&_opCtx, nss.ns());
+            _client.dropCollection(nss.ns());
+        }
+        setCachedCollections(BSONObj());
+    }
+
+    static void setCachedCollections(const BSONObj& spec) {
+        auto param = ServerParameterSet::getGlobal()->get("columnarCacheCollections");
+        ASSERT_OK(param->set(BSON("" << spec).firstElement()));
+    }
+
+    /**
+     * Returns version 'version' of the document with _id 'id'. Its cached fields 'a' and 'b' both
+     * hold the version, and its field 'c' is not cached.
+     */
+    static BSONObj makeDoc(int id, int version) {
+        return BSON("_id" << id << "a" << version << "b" << version << "c" << id);
+    }
+
+    /**
+     * Returns the versions of the documents inserted by the fixture, by _id.
+     */
+    static std::map<int, int> initialVersions() {
+        std::map<int, int> versions;
+        for (int id = 0; id < kNumDocs; ++id) {
+            versions.emplace(id, 0);
+        }
+        return versions;
+    }
+
+    /**
+     * Builds the cache of the collection, as the first query which could use it would.
+     */
+    void buildCache() {
+        auto cache = ColumnarCacheRegistry::get(_opCtx.getServiceContext()).lookup(nss);
+        ASSERT(cache);
+        buildColumnarCache(&_opCtx, cache.get());
+        ASSERT(cache->getState() == ColumnarCollectionCache::State::kBuilt);
+    }
+
+    struct QueryResult {
+        std::vector<BSONObj> docs;
+        size_t numColumnarCacheReads{0};
+    };
+
+    /**
+     * Runs the query through an SBE plan built the way the find command would, and returns the
+     * documents it produces together with the number of rows its scan read from the cache.
+     */
+    QueryResult runQuery(const BSONObj& filter,
+                         const BSONObj& proj,
+                         const BSONObj& sort = BSONObj()) {
+        AutoGetCollectionForReadCommand coll(&_opCtx, nss);
+
+        auto qr = std::make_unique<QueryRequest>(nss);
+        qr->setFilter(filter);
+        qr->setProj(proj);
+        qr->setSort(sort);
+        auto cq = unittest::assertGet(CanonicalQuery::canonicalize(
+            &_opCtx, std::move(qr), nullptr, ExtensionsCallbackReal(&_opCtx, &nss)));
+
+        auto solutions = unittest::assertGet(QueryPlanner::plan(*cq, QueryPlannerParams()));
+        ASSERT_EQ(solutions.size(), 1U);
+
+        PlanYieldPolicySBE yieldPolicy(PlanYieldPolicy::YieldPolicy::NO_YIELD,
+                                       _opCtx.getServiceContext()->getFastClockSource(),
+                                       0,
+                                       Milliseconds::zero(),
+                                       nullptr);
+        auto [root, data] = stage_builder::buildSlotBasedExecutableTree(
+            &_opCtx, coll.getCollection(), *cq, *solutions[0], &yieldPolicy, false);
+        root->prepare(data.ctx);
+        auto resultSlot = root->getAccessor(data.ctx, *data.resultSlot);
+        root->attachFromOperationContext(&_opCtx);
+        root->open(false);
+
+        QueryResult result;
+        BSONObj obj;
+        while (fetchNext(root.get(), resultSlot, nullptr, &obj, nullptr) ==
+               sbe::PlanState::ADVANCED) {
+            result.docs.push_back(obj.getOwned());
+        }
+        result.numColumnarCacheReads = countColumnarCacheReads(*root->getStats());
+        root->close();
+        return result;
+    }
+
+    static size_t countColumnarCacheReads(const sbe::PlanStageStats& stats) {
+        size_t count = 0;
+        if (auto scanStats = dynamic_cast<const sbe::ScanStats*>(stats.specific.get())) {
+            count += scanStats->numColumnarCacheReads;
+        }
+        for (auto&& child : stats.children) {
+            count += countColumnarCacheReads(*child);
+        }
+        return count;
+    }
+
+    /**
+     * Asserts that 'docs' hold the fields _id, 'a' and 'b' of the documents with the versions in
+     * 'expected', in _id order.
+     */
+    static void assertDocs(const std::vector<BSONObj>& docs, const std::map<int, int>& expected) {
+        ASSERT_EQ(docs.size(), expected.size());
+        auto doc = docs.begin();
+        for (auto&& [id, version] : expected) {
+            ASSERT_BSONOBJ_EQ(*doc, BSON("_id" << id << "a" << version << "b" << version));
+            ++doc;
+        }
+    }
+
+protected:
+    const ServiceContext::UniqueOperationContext _txnPtr = cc().makeOperationContext();
+    OperationContext& _opCtx = *_txnPtr;
+
+private:
+    DBDirectClient _client;
+};
+
+TEST_F(QueryStageColumnarCacheTest, CoveredScanReadsFromCache) {
+    buildCache();
+
+    auto result = runQuery(BSONObj(), BSON("a" << 1 << "b" << 1));
+    ASSERT_EQ(result.numColumnarCacheReads, static_cast<size_t>(kNumDocs));
+    assertDocs(result.docs, initialVersions());
+
+    // The filter and the sort only depend on cached fields as well.
+    result = runQuery(BSON("a" << 0 << "_id" << BSON("$lt" << 10)),
+                      BSON("_id" << 0 << "b" << 1),
+                      BSON("_id" << -1));
+    ASSERT_EQ(result.numColumnarCacheReads, static_cast<size_t>(kNumDocs));
+    ASSERT_EQ(result.docs.size(), 10U);
+    for (auto&& doc : result.docs) {
+        ASSERT_BSONOBJ_EQ(doc, BSON("b" << 0));
+    }
+}
+
+TEST_F(QueryStageColumnarCacheTest, UncoveredProjectionReadsFromRecordStore) {
+    buildCache();
+
+    auto result = runQuery(BSON("_id" << BSON("$lt" << 10)), BSON("a" << 1 << "c" << 1));
+    ASSERT_EQ(result.numColumnarCacheReads, 0U);
+    ASSERT_EQ(result.docs.size(), 10U);
+    for (int id = 0; id < 10; ++id) {
+        ASSERT_BSONOBJ_EQ(result.docs[id], BSON("_id" << id << "a" << 0 << "c" << id));
+    }
+}
+
+TEST_F(QueryStageColumnarCacheTest, UncoveredFilterReadsFromRecordStore) {
+    buildCache();
+
+    auto result = runQuery(BSON("c" << BSON("$lt" << 10)), BSON("a" << 1));
+    ASSERT_EQ(result.numColumnarCacheReads, 0U);
+    ASSERT_EQ(result.docs.size(), 10U);
+    for (int id = 0; id < 10; ++id) {
+        ASSERT_BSONOBJ_EQ(result.docs[id], BSON("_id" << id << "a" << 0));
+    }
+}
+
+TEST_F(QueryStageColumnarCacheTest, UncoveredSortReadsFromRecordStore) {
+    buildCache();
+
+    auto result = runQuery(BSON("_id" << BSON("$lt" << 10)), BSON("a" << 1), BSON("c" << -1));
+    ASSERT_EQ(result.numColumnarCacheReads, 0U);
+    ASSERT_EQ(result.docs.size(), 10U);
+    for (int id = 0; id < 10; ++id) {
+        ASSERT_BSONOBJ_EQ(result.docs[id], BSON("_id" << 9 - id << "a" << 0));
+    }
+}
+
+TEST_F(QueryStageColumnarCacheTest, WholeDocumentsAreReadFromRecordStore) {
+    buildCache();
+
+    // Neither a query without a projection nor one with an exclusion projection can tell which
+    // fields it returns.
+    for (auto&& proj : {BSONObj(), BSON("a" << 0)}) {
+        auto result = runQuery(BSON("_id" << BSON("$lt" << 10)), proj);
+        ASSERT_EQ(result.numColumnarCacheReads, 0U);
+        ASSERT_EQ(result.docs.size(), 10U);
+        for (int id = 0; id < 10; ++id) {
+            auto expected = makeDoc(id, 0);
+            if (!proj.isEmpty()) {
+                expected = expected.removeField("a");
+            }
+            ASSERT_BSONOBJ_EQ(result.docs[id], expected);
+        }
+    }
+}
+
+TEST_F(QueryStageColumnarCacheTest, RowsWithWritesInFlightAreReadFromRecordStore) {
+    buildCache();
+
+    auto writerClient = getGlobalServiceContext()->makeClient("writer");
+    auto writerOpCtx = writerClient->makeOperationContext();
+    auto expected = initialVersions();
+    {
+        // Update one document, delete another and insert a new one, without committing.
+        AutoGetCollection coll(writerOpCtx.get(), nss, MODE_IX);
+        WriteUnitOfWork wuow(writerOpCtx.get());
+
+        auto recordId =
+            Helpers::findById(writerOpCtx.get(), coll.getCollection(), BSON("_id" << 1));
+        auto oldDoc = coll->docFor(writerOpCtx.get(), recordId);
+        CollectionUpdateArgs args;
+        args.criteria = BSON("_id" << 1);
+        args.update = BSON("$set" << BSON("a" << 1 << "b" << 1));
+        coll->updateDocument(
+            writerOpCtx.get(), recordId, oldDoc, makeDoc(1, 1), false, nullptr, &args);
+
+        recordId = Helpers::findById(writerOpCtx.get(), coll.getCollection(), BSON("_id" << 2));
+        coll->deleteDocument(writerOpCtx.get(), kUninitializedStmtId, recordId, nullptr);
+
+        ASSERT_OK(coll->insertDocument(
+            writerOpCtx.get(), InsertStatement(makeDoc(kNumDocs, 1)), nullptr));
+
+        // The rows of the updated and the deleted document come from the record store, which
+        // doesn't show any of the writes yet.
+        auto result = runQuery(BSONObj(), BSON("a" << 1 << "b" << 1));
+        ASSERT_EQ(result.numColumnarCacheReads, static_cast<size_t>(kNumDocs - 2));
+        assertDocs(result.docs, expected);
+
+        wuow.commit();
+    }
+
+    expected[1] = 1;
+    expected.erase(2);
+    expected[kNumDocs] = 1;
+    auto result = runQuery(BSONObj(), BSON("a" << 1 << "b" << 1));
+    ASSERT_EQ(result.numColumnarCacheReads, static_cast<size_t>(kNumDocs));
+    assertDocs(result.docs, expected);
+}
+
+TEST_F(QueryStageColumnarCacheTest, CoveredScansSeeConcurrentWrites) {
+    buildCache();
+
+    // The version of each document as of the last write to it which committed, and as of the last
+    // write to it which started. Deleted documents are absent, and are never inserted again.
+    auto mutex = MONGO_MAKE_LATCH("QueryStageColumnarCacheTest::mutex");
+    auto committed = initialVersions();
+    auto started = committed;
+
+    AtomicWord<bool> done{false};
+    stdx::thread writer([&] {
+        ThreadClient tc("columnarCacheWriter", getGlobalServiceContext());
+        auto opCtx = cc().makeOperationContext();
+        DBDirectClient client(opCtx.get());
+        PseudoRandom random(1);
+
+        int nextId = kNumDocs;
+        for (int version = 1; !done.load(); ++version) {
+            if (version % 4 == 0) {
+                const int id = nextId++;
+                {
+                    stdx::lock_guard<Latch> lk(mutex);
+                    started[id] = version;
+                }
+                client.insert(nss.ns(), makeDoc(id, version));
+                stdx::lock_guard<Latch> lk(mutex);
+                committed[id] = version;
+                continue;
+            }
+
+            const int id = random.nextInt32(kNumDocs);
+            const bool remove = version % 4 == 1;
+            {
+                stdx::lock_guard<Latch> lk(mutex);
+                if (!started.count(id)) {
+                    continue;
+                }
+                if (remove) {
+                    started.erase(id);
+                } else {
+                    started[id] = version;
+                }
+            }
+            if (remove) {
+                client.remove(nss.ns(), BSON("_id" << id));
+            } else {
+                client.update(nss.ns(),
+                              BSON("_id" << id),
+                              BSON("$set" << BSON("a" << version << "b" << version)));
+            }
+            stdx::lock_guard<Latch> lk(mutex);
+            if (remove) {
+                committed.erase(id);
+            } else {
+                committed[id] = version;
+            }
+        }
+    });
+    ON_BLOCK_EXIT([&] {
+        done.store(true);
+        writer.join();
+    });
+
+    size_t numColumnarCacheReads = 0;
+    for (int scan = 0; scan < 20; ++scan) {
+        std::map<int, int> before;
+        {
+            stdx::lock_guard<Latch> lk(mutex);
+            before = committed;
+        }
+        auto result = runQuery(BSONObj(), BSON("a" << 1 << "b" << 1));
+        std::map<int, int> after;
+        {
+            stdx::lock_guard<Latch> lk(mutex);
+            after = started;
+        }
+        numColumnarCacheReads += result.numColumnarCacheReads;
+
+        // Every document is seen once, at a version no older than the one committed before the
+        // scan and no newer than the one started before it finished. A document which existed
+        // throughout the scan must be seen.
+        std::map<int, int> seen;
+        for (auto&& doc : result.docs) {
+            const int id = doc["_id"].numberInt();
+            const int version = doc["a"].numberInt();
+            ASSERT_EQ(doc["b"].numberInt(), version) << doc;
+            ASSERT(seen.emplace(id, version).second) << "Duplicate document " << doc;
+
+            auto beforeIt = before.find(id);
+            auto afterIt = after.find(id);
+            ASSERT(beforeIt != before.end() || afterIt != after.end()) << doc;
+            if (beforeIt != before.end()) {
+                ASSERT_GTE(version, beforeIt->second) << "Stale document " << doc;
+            }
+            if (afterIt != after.end()) {
+                ASSERT_LTE(version, afterIt->second) << doc;
+            }
+        }
+        for (auto&& [id, version] : before) {
+            if (after.count(id)) {
+                ASSERT(seen.count(id)) << "Lost document " << id;
+            }
+        }
+    }
+    ASSERT_GT(numColumnarCacheReads, 0U);
+}
+
+}  // namespace query_stage_columnar_cache
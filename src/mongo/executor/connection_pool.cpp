@@ -320,6 +320,11 @@ public:
      */
     size_t requestsPending() const;
 
+    /**
+     * Returns how long the requests fulfilled by this pool have waited for their connection.
+     */
+    const ConnectionWaitTimeHistogram& acquisitionWaitTimes() const;
+
     /**
      * Returns the HostAndPort for this pool.
      */
@@ -352,10 +357,14 @@ private:
     using OwnedConnection = std::shared_ptr<ConnectionInterface>;
     using OwnershipPool = stdx::unordered_map<ConnectionInterface*, OwnedConnection>;
     using LRUOwnershipPool = LRUCache<OwnershipPool::key_type, OwnershipPool::mapped_type>;
-    using Request = std::pair<Date_t, Promise<ConnectionHandle>>;
+    struct Request {
+        Date_t expiration;
+        Date_t requestedAt;
+        Promise<ConnectionHandle> promise;
+    };
     struct RequestComparator {
         bool operator()(const Request& a, const Request& b) {
-            return a.first > b.first;
+            return a.expiration > b.expiration;
         }
     };
 
@@ -409,6 +418,9 @@ private:
     std::vector<Request> _requests;
     Date_t _lastActiveTime;
 
+    // How long each successful checkout waited for its connection.
+    ConnectionWaitTimeHistogram _acquisitionWaitTimes;
+
     std::shared_ptr<TimerInterface> _eventTimer;
     Date_t _eventTimerExpiration;
     Date_t _hostExpiration;
@@ -576,6 +588,7 @@ void ConnectionPool::appendConnectionStats(ConnectionPoolStats* stats) const {
                                      pool->availableConnections(),
                                      pool->createdConnections(),
                                      pool->refreshingConnections()};
+        hostStats.acquisitionWaitTimes = pool->acquisitionWaitTimes();
         stats->updateStatsForHost(_name, host, hostStats);
     }
 }
@@ -635,6 +648,10 @@ size_t ConnectionPool::SpecificPool::requestsPending() const {
     return _requests.size();
 }
 
+const ConnectionWaitTimeHistogram& ConnectionPool::SpecificPool::acquisitionWaitTimes() const {
+    return _acquisitionWaitTimes;
+}
+
 Future<ConnectionPool::ConnectionHandle> ConnectionPool::SpecificPool::getConnection(
     Milliseconds timeout) {
 
@@ -652,6 +669,7 @@ Future<ConnectionPool::ConnectionHandle> ConnectionPool::SpecificPool::getConnec
                         "Using existing idle connection to {hostAndPort}",
                         "Using existing idle connection",
                         "hostAndPort"_attr = _hostAndPort);
+            _acquisitionWaitTimes.increment(Milliseconds(0));
             return Future<ConnectionPool::ConnectionHandle>::makeReady(std::move(conn));
         }
     }
@@ -670,7 +688,7 @@ Future<ConnectionPool::ConnectionHandle> ConnectionPool::SpecificPool::getConnec
     const auto expiration = now + timeout;
     auto pf = makePromiseFuture<ConnectionHandle>();
 
-    _requests.push_back(make_pair(expiration, std::move(pf.promise)));
+    _requests.push_back(Request{expiration, now, std::move(pf.promise)});
     std::push_heap(begin(_requests), end(_requests), RequestComparator{});
 
     return std::move(pf.future);
@@ -947,7 +965,7 @@ void ConnectionPool::SpecificPool::processFailure(const Status& status) {
     }
 
     for (auto& request : _requests) {
-        request.second.setError(status);
+        request.promise.setError(status);
     }
 
     LOGV2_DEBUG(22573,
@@ -976,10 +994,12 @@ void ConnectionPool::SpecificPool::fulfillRequests() {
         }
 
         // Grab the request and callback
-        auto promise = std::move(_requests.front().second);
+        auto promise = std::move(_requests.front().promise);
+        auto requestedAt = _requests.front().requestedAt;
         std::pop_heap(begin(_requests), end(_requests), RequestComparator{});
         _requests.pop_back();
 
+        _acquisitionWaitTimes.increment(_lastActiveTime - requestedAt);
         promise.emplaceValue(std::move(conn));
     }
 }
@@ -1108,8 +1128,8 @@ void ConnectionPool::SpecificPool::updateEventTimer() {
     }
 
     // If a request would timeout before the next event, then it is the next event
-    if (_requests.size() && (_requests.front().first < nextEventTime)) {
-        nextEventTime = _requests.front().first;
+    if (_requests.size() && (_requests.front().expiration < nextEventTime)) {
+        nextEventTime = _requests.front().expiration;
     }
 
     // If our timer is already set to the next event, then we're done
@@ -1129,12 +1149,12 @@ void ConnectionPool::SpecificPool::updateEventTimer() {
 
         _health.isFailed = false;
 
-        while (_requests.size() && (_requests.front().first <= now)) {
+        while (_requests.size() && (_requests.front().expiration <= now)) {
             std::pop_heap(begin(_requests), end(_requests), RequestComparator{});
 
             auto& request = _requests.back();
-            request.second.setError(Status(ErrorCodes::NetworkInterfaceExceededTimeLimit,
-                                           "Couldn't get a connection within the time limit"));
+            request.promise.setError(Status(ErrorCodes::NetworkInterfaceExceededTimeLimit,
+                                            "Couldn't get a connection within the time limit"));
             _requests.pop_back();
 
             // Since we've failed a request, we've interacted with external users
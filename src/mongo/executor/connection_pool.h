@@ -87,6 +87,7 @@ public:
     static constexpr Milliseconds kDefaultHostTimeout = Minutes(5);
     static constexpr Milliseconds kDefaultRefreshRequirement = Minutes(1);
     static constexpr Milliseconds kDefaultRefreshTimeout = Seconds(20);
+    static constexpr Milliseconds kDefaultPipelineStallTimeout = Milliseconds(20);
     static constexpr Milliseconds kHostRetryTimeout = Seconds(1);
 
     static const Status kConnectionStateUnknown;
@@ -150,6 +151,20 @@ public:
          */
         bool skipAuthentication = false;
 
+        /**
+         * The number of requests a network interface may have in flight at once over a single
+         * connection from this pool. Values above one let the interface pipeline requests to a
+         * host over the connections it already holds, rather than checking out one connection per
+         * request. Like skipAuthentication, this is read by the user of the pool, not the pool.
+         */
+        size_t maxRequestsPerConnection = 1;
+
+        /**
+         * How long a connection shared by several requests may go without completing one before
+         * it stops taking new requests. Only read along with maxRequestsPerConnection.
+         */
+        Milliseconds pipelineStallTimeout = kDefaultPipelineStallTimeout;
+
         std::function<std::shared_ptr<ControllerInterface>(void)> controllerFactory =
             &ConnectionPool::makeLimitController;
     };
@@ -251,6 +266,10 @@ public:
 
     void appendConnectionStats(ConnectionPoolStats* stats) const;
 
+    const std::string& getName() const {
+        return _name;
+    }
+
     size_t getNumConnectionsPerHost(const HostAndPort& hostAndPort) const;
 
 private:
@@ -31,11 +31,45 @@
 
 #include "mongo/executor/connection_pool_stats.h"
 
+#include <algorithm>
+#include <fmt/format.h>
+
 #include "mongo/bson/bsonobjbuilder.h"
 
 namespace mongo {
 namespace executor {
 
+using namespace fmt::literals;
+
+void ConnectionWaitTimeHistogram::increment(Milliseconds waitTime) {
+    const auto& bounds = kBucketLowerBounds;
+    auto it = std::upper_bound(bounds.begin(), bounds.end(), waitTime.count());
+    // Negative durations, which a clock adjustment can produce, count as immediate checkouts.
+    auto bucket = it == bounds.begin() ? 0 : std::distance(bounds.begin(), it) - 1;
+    ++_counts[bucket];
+    ++_totalCount;
+}
+
+ConnectionWaitTimeHistogram& ConnectionWaitTimeHistogram::operator+=(
+    const ConnectionWaitTimeHistogram& other) {
+    for (size_t i = 0; i < _counts.size(); ++i) {
+        _counts[i] += other._counts[i];
+    }
+    _totalCount += other._totalCount;
+
+    return *this;
+}
+
+void ConnectionWaitTimeHistogram::appendToBSON(BSONObjBuilder& builder) const {
+    const auto& bounds = kBucketLowerBounds;
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        auto name = i + 1 < bounds.size() ? "{}-{}ms"_format(bounds[i], bounds[i + 1])
+                                          : "{}+ms"_format(bounds[i]);
+        builder.appendNumber(name, static_cast<long long>(_counts[i]));
+    }
+    builder.appendNumber("totalCount", static_cast<long long>(_totalCount));
+}
+
 ConnectionStatsPer::ConnectionStatsPer(size_t nInUse,
                                        size_t nAvailable,
                                        size_t nCreated,
@@ -49,6 +83,7 @@ ConnectionStatsPer& ConnectionStatsPer::operator+=(const ConnectionStatsPer& oth
     available += other.available;
     created += other.created;
     refreshing += other.refreshing;
+    acquisitionWaitTimes += other.acquisitionWaitTimes;
 
     return *this;
 }
@@ -76,6 +111,23 @@ void ConnectionPoolStats::updateStatsForHost(std::string pool,
     totalRefreshing += newStats.refreshing;
 }
 
+void ConnectionPoolStats::updateWaitTimesForHost(const std::string& pool,
+                                                 const HostAndPort& host,
+                                                 const ConnectionWaitTimeHistogram& waitTimes) {
+    auto byPool = statsByPool.find(pool);
+    if (byPool == statsByPool.end()) {
+        return;
+    }
+    auto byPoolAndHost = byPool->second.statsByHost.find(host);
+    if (byPoolAndHost == byPool->second.statsByHost.end()) {
+        return;
+    }
+
+    byPool->second.acquisitionWaitTimes += waitTimes;
+    byPoolAndHost->second.acquisitionWaitTimes += waitTimes;
+    statsByHost[host].acquisitionWaitTimes += waitTimes;
+}
+
 void ConnectionPoolStats::appendToBSON(mongo::BSONObjBuilder& result, bool forFTDC) {
     result.appendNumber("totalInUse", totalInUse);
     result.appendNumber("totalAvailable", totalAvailable);
@@ -114,6 +166,8 @@ void ConnectionPoolStats::appendToBSON(mongo::BSONObjBuilder& result, bool forFT
                 hostInfo.appendNumber("available", hostStats.available);
                 hostInfo.appendNumber("created", hostStats.created);
                 hostInfo.appendNumber("refreshing", hostStats.refreshing);
+                BSONObjBuilder waitTimes(hostInfo.subobjStart("acquisitionWaitTimes"));
+                hostStats.acquisitionWaitTimes.appendToBSON(waitTimes);
             }
         }
     }
@@ -126,6 +180,8 @@ void ConnectionPoolStats::appendToBSON(mongo::BSONObjBuilder& result, bool forFT
             hostInfo.appendNumber("available", hostStats.available);
             hostInfo.appendNumber("created", hostStats.created);
             hostInfo.appendNumber("refreshing", hostStats.refreshing);
+            BSONObjBuilder waitTimes(hostInfo.subobjStart("acquisitionWaitTimes"));
+            hostStats.acquisitionWaitTimes.appendToBSON(waitTimes);
         }
     }
 }
@@ -29,12 +29,48 @@
 
 #pragma once
 
+#include <array>
+
 #include "mongo/stdx/unordered_map.h"
+#include "mongo/util/duration.h"
 #include "mongo/util/net/hostandport.h"
 
 namespace mongo {
 namespace executor {
 
+/**
+ * Counts how long requests waited to check a connection out of a pool, in fixed millisecond
+ * buckets. A request which is handed a connection immediately counts towards the first bucket.
+ */
+class ConnectionWaitTimeHistogram {
+public:
+    // The lower bound of each bucket, in milliseconds. The last bucket is unbounded.
+    static constexpr std::array<int64_t, 13> kBucketLowerBounds{
+        0, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+
+    void increment(Milliseconds waitTime);
+
+    ConnectionWaitTimeHistogram& operator+=(const ConnectionWaitTimeHistogram& other);
+
+    /**
+     * Appends one field per bucket, named after its bounds (e.g. "5-10ms", "5000+ms"), followed by
+     * "totalCount".
+     */
+    void appendToBSON(BSONObjBuilder& builder) const;
+
+    size_t getTotalCount() const {
+        return _totalCount;
+    }
+
+    size_t getCountForBucket(size_t bucket) const {
+        return _counts[bucket];
+    }
+
+private:
+    std::array<size_t, kBucketLowerBounds.size()> _counts{};
+    size_t _totalCount = 0u;
+};
+
 /**
  * Holds connection information for a specific pool or remote host. These objects are maintained by
  * a parent ConnectionPoolStats object and should not need to be created directly.
@@ -50,6 +86,7 @@ struct ConnectionStatsPer {
     size_t available = 0u;
     size_t created = 0u;
     size_t refreshing = 0u;
+    ConnectionWaitTimeHistogram acquisitionWaitTimes;
 };
 
 /**
@@ -60,6 +97,14 @@ struct ConnectionStatsPer {
 struct ConnectionPoolStats {
     void updateStatsForHost(std::string pool, HostAndPort host, ConnectionStatsPer newStats);
 
+    /**
+     * Adds to the acquisition wait times of a host which is already listed for 'pool'. Lets a user
+     * of the pool account for waits which the pool does not see.
+     */
+    void updateWaitTimesForHost(const std::string& pool,
+                                const HostAndPort& host,
+                                const ConnectionWaitTimeHistogram& waitTimes);
+
     void appendToBSON(mongo::BSONObjBuilder& result, bool forFTDC = false);
 
     size_t totalInUse = 0u;
@@ -40,7 +40,9 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/executor/connection_pool.h"
+#include "mongo/executor/connection_pool_stats.h"
 #include "mongo/stdx/future.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/scopeguard.h"
@@ -1530,6 +1532,55 @@ TEST_F(ConnectionPoolTest, ReturnAfterShutdown) {
     pool->shutdown();
 }
 
+/**
+ * Verify that each checkout records how long it waited for its connection in the stats of its
+ * host.
+ */
+TEST_F(ConnectionPoolTest, AcquisitionWaitTimesAreRecorded) {
+    auto pool = makePool();
+
+    auto now = Date_t::now();
+    PoolImpl::setNow(now);
+
+    // The first request waits for a connection to be set up.
+    ConnectionPool::ConnectionHandle conn;
+    pool->get_forTest(HostAndPort(),
+                      Milliseconds(5000),
+                      [&](StatusWith<ConnectionPool::ConnectionHandle> swConn) {
+                          ASSERT(swConn.isOK());
+                          conn = std::move(swConn.getValue());
+                      });
+    ASSERT(!conn);
+
+    PoolImpl::setNow(now + Milliseconds(30));
+    ConnectionImpl::pushSetup(Status::OK());
+    ASSERT(conn);
+    doneWith(conn);
+
+    // The second request is served by the now idle connection.
+    pool->get_forTest(HostAndPort(),
+                      Milliseconds(5000),
+                      [&](StatusWith<ConnectionPool::ConnectionHandle> swConn) {
+                          ASSERT(swConn.isOK());
+                          conn = std::move(swConn.getValue());
+                      });
+    ASSERT(conn);
+    doneWith(conn);
+
+    ConnectionPoolStats stats;
+    pool->appendConnectionStats(&stats);
+    const auto& waitTimes = stats.statsByHost[HostAndPort()].acquisitionWaitTimes;
+    ASSERT_EQ(waitTimes.getTotalCount(), 2u);
+
+    BSONObjBuilder builder;
+    waitTimes.appendToBSON(builder);
+    auto waitTimesObj = builder.obj();
+    ASSERT_EQ(waitTimesObj["0-1ms"].numberLong(), 1);
+    ASSERT_EQ(waitTimesObj["20-50ms"].numberLong(), 1);
+    ASSERT_EQ(waitTimesObj["5000+ms"].numberLong(), 0);
+    ASSERT_EQ(waitTimesObj["totalCount"].numberLong(), 2);
+}
+
 }  // namespace connection_pool_test_details
 }  // namespace executor
 }  // namespace mongo
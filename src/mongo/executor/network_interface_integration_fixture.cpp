@@ -48,9 +48,7 @@ namespace mongo {
 namespace executor {
 
 void NetworkInterfaceIntegrationFixture::createNet(
-    std::unique_ptr<NetworkConnectionHook> connectHook) {
-    ConnectionPool::Options options;
-
+    std::unique_ptr<NetworkConnectionHook> connectHook, ConnectionPool::Options options) {
     options.minConnections = 0u;
 
 #ifdef _WIN32
@@ -65,9 +63,9 @@ void NetworkInterfaceIntegrationFixture::createNet(
 }
 
 void NetworkInterfaceIntegrationFixture::startNet(
-    std::unique_ptr<NetworkConnectionHook> connectHook) {
+    std::unique_ptr<NetworkConnectionHook> connectHook, ConnectionPool::Options options) {
 
-    createNet(std::move(connectHook));
+    createNet(std::move(connectHook), std::move(options));
     net().startup();
 }
 
@@ -666,6 +666,146 @@ TEST_F(NetworkInterfaceTest, FireAndForget) {
     assertNumOps(0u, 0u, 0u, 5u);
 }
 
+class NetworkInterfaceMultiplexingTest : public NetworkInterfaceTest {
+public:
+    static constexpr size_t kMaxRequestsPerConnection = 4;
+
+    void setUp() override {
+        ConnectionPool::Options options;
+        options.maxRequestsPerConnection = kMaxRequestsPerConnection;
+        startNet(nullptr, std::move(options));
+    }
+
+    /**
+     * Blocks every command named 'cmdName' on the server for 'blockTime'.
+     */
+    void blockCommand(StringData cmdName, Milliseconds blockTime) {
+        assertCommandOK("admin",
+                        BSON("configureFailPoint"
+                             << "failCommand"
+                             << "mode"
+                             << "alwaysOn"
+                             << "data"
+                             << BSON("blockConnection" << true << "blockTimeMS"
+                                                       << durationCount<Milliseconds>(blockTime)
+                                                       << "failCommands" << BSON_ARRAY(cmdName))),
+                        kNoTimeout);
+    }
+
+    void disableFailCommand() {
+        assertCommandOK("admin",
+                        BSON("configureFailPoint"
+                             << "failCommand"
+                             << "mode"
+                             << "off"),
+                        kNoTimeout);
+    }
+
+    ConnectionStatsPer getStatsForFixtureHost() {
+        ConnectionPoolStats stats;
+        net().appendConnectionStats(&stats);
+        return stats.statsByHost[fixture().getServers().front()];
+    }
+
+    /**
+     * Waits until no connection to the fixture host is in use, and returns the stats of the host.
+     */
+    ConnectionStatsPer waitForConnectionsToBeReleased() {
+        ClockSource::StopWatch stopwatch;
+        auto stats = getStatsForFixtureHost();
+        while (stats.inUse > 0 && stopwatch.elapsed() < kMaxWait) {
+            sleepmillis(10);
+            stats = getStatsForFixtureHost();
+        }
+        ASSERT_EQ(stats.inUse, 0u);
+        return stats;
+    }
+};
+
+TEST_F(NetworkInterfaceMultiplexingTest, RequestsShareOneConnection) {
+    std::vector<Future<RemoteCommandResponse>> futures;
+    for (size_t i = 0; i < kMaxRequestsPerConnection; ++i) {
+        futures.push_back(
+            runCommand(makeCallbackHandle(), makeTestCommand(kNoTimeout, makeEchoCmdObj())));
+    }
+
+    for (auto& future : futures) {
+        auto result = future.get();
+        uassertStatusOK(result.status);
+        ASSERT_EQ(1, result.data.getIntField("ok"));
+    }
+
+    // The requests waited for one connection, which is handed back to the pool once they are done.
+    auto stats = waitForConnectionsToBeReleased();
+    ASSERT_EQ(stats.created, 1u);
+    ASSERT_EQ(stats.available, 1u);
+    ASSERT_EQ(stats.acquisitionWaitTimes.getTotalCount(), kMaxRequestsPerConnection);
+    assertNumOps(0u, 0u, 0u, kMaxRequestsPerConnection);
+}
+
+TEST_F(NetworkInterfaceMultiplexingTest, CancelingRequestLeavesOthersRunning) {
+    blockCommand("ping", Seconds(2));
+    ON_BLOCK_EXIT([&] { disableFailCommand(); });
+
+    auto canceledCbh = makeCallbackHandle();
+    auto canceled = runCommand(canceledCbh, makeTestCommand(kNoTimeout, BSON("ping" << 1)));
+    auto other = runCommand(makeCallbackHandle(), makeTestCommand(kNoTimeout, makeEchoCmdObj()));
+
+    // The connection stalls behind the ping, so currentOp runs over a connection of its own.
+    waitForCommandToStart("ping", kMaxWait);
+    net().cancelCommand(canceledCbh);
+    ASSERT_EQ(ErrorCodes::CallbackCanceled, canceled.get().status);
+
+    auto result = other.get();
+    uassertStatusOK(result.status);
+    ASSERT_EQ(1, result.data.getIntField("ok"));
+
+    // The server runs the requests in order, so the reply to the canceled request was read before
+    // the reply to the other one, and the connection went back to the pool.
+    auto stats = waitForConnectionsToBeReleased();
+    ASSERT_EQ(stats.available, stats.created);
+}
+
+TEST_F(NetworkInterfaceMultiplexingTest, ConnectionWithOutstandingCanceledReplyIsDiscarded) {
+    blockCommand("ping", Seconds(2));
+    ON_BLOCK_EXIT([&] { disableFailCommand(); });
+
+    auto other = runCommand(makeCallbackHandle(), makeTestCommand(kNoTimeout, makeEchoCmdObj()));
+    auto canceledCbh = makeCallbackHandle();
+    auto canceled = runCommand(canceledCbh, makeTestCommand(kNoTimeout, BSON("ping" << 1)));
+    uassertStatusOK(other.get().status);
+
+    waitForCommandToStart("ping", kMaxWait);
+    net().cancelCommand(canceledCbh);
+    ASSERT_EQ(ErrorCodes::CallbackCanceled, canceled.get().status);
+
+    // The reply to the canceled request is still on its way once no request uses the connection,
+    // so the connection is discarded rather than handed to another request.
+    auto stats = waitForConnectionsToBeReleased();
+    ASSERT_EQ(stats.available + 1, stats.created);
+}
+
+TEST_F(NetworkInterfaceMultiplexingTest, TransportFailureFailsEveryRequest) {
+    assertCommandOK("admin",
+                    BSON("configureFailPoint"
+                         << "failCommand"
+                         << "mode" << BSON("times" << 1) << "data"
+                         << BSON("closeConnection" << true << "failCommands"
+                                                   << BSON_ARRAY("ping"))),
+                    kNoTimeout);
+    ON_BLOCK_EXIT([&] { disableFailCommand(); });
+
+    auto closing = runCommand(makeCallbackHandle(), makeTestCommand(kNoTimeout, BSON("ping" << 1)));
+    auto other = runCommand(makeCallbackHandle(), makeTestCommand(kNoTimeout, makeEchoCmdObj()));
+
+    ASSERT_NOT_OK(closing.get().status);
+    ASSERT_NOT_OK(other.get().status);
+
+    // The failed connection is discarded rather than handed back to the pool.
+    auto stats = waitForConnectionsToBeReleased();
+    ASSERT_EQ(stats.available + 1, stats.created);
+}
+
 TEST_F(NetworkInterfaceInternalClientTest, StartCommandOnAny) {
     // The echo command below uses hedging so after a response is returned, we will issue
     // a _killOperations command to kill the pending operation. As a result, the number of
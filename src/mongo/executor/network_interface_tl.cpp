@@ -42,6 +42,7 @@
 #include "mongo/transport/transport_layer_manager.h"
 #include "mongo/util/concurrency/idle_thread_block.h"
 #include "mongo/util/net/socket_utils.h"
+#include "mongo/util/string_map.h"
 #include "mongo/util/testing_proctor.h"
 
 namespace mongo {
@@ -155,8 +156,15 @@ void NetworkInterfaceTL::appendConnectionStats(ConnectionPoolStats* stats) const
         stdx::lock_guard<Latch> lk(_mutex);
         return _pool.get();
     }();
-    if (pool)
-        pool->appendConnectionStats(stats);
+    if (!pool)
+        return;
+    pool->appendConnectionStats(stats);
+
+    // Requests sharing a connection wait behind each other on the server rather than in the pool.
+    stdx::lock_guard lk(_multiplexedMutex);
+    for (const auto& [host, waitTimes] : _multiplexedWaitTimes) {
+        stats->updateWaitTimesForHost(pool->getName(), host, waitTimes);
+    }
 }
 
 NetworkInterface::Counters NetworkInterfaceTL::getCounters() const {
@@ -366,6 +374,12 @@ void NetworkInterfaceTL::CommandStateBase::setTimer() {
 }
 
 void NetworkInterfaceTL::RequestState::returnConnection(Status status) noexcept {
+    if (lease) {
+        auto leaseToReturn = std::exchange(lease, {});
+        interface()->_releaseMultiplexedConnection(std::move(*leaseToReturn), std::move(status));
+        return;
+    }
+
     invariant(conn);
 
     auto connToReturn = std::exchange(conn, {});
@@ -430,6 +444,14 @@ void NetworkInterfaceTL::CommandStateBase::tryFinish(Status status) noexcept {
 }
 
 void NetworkInterfaceTL::RequestState::cancel() noexcept {
+    if (auto leaseToCancel = weakLease.lock()) {
+        // Other requests are in flight on the connection, so only give up on this one.
+        leaseToCancel->conn->client()->cancelPipelinedRequest(
+            leaseToCancel->msgId,
+            Status(ErrorCodes::CallbackCanceled, "Multiplexed request was canceled"));
+        return;
+    }
+
     auto connToCancel = weakConn.lock();
     if (auto clientPtr = getClient(connToCancel)) {
         // If we have a client, cancel it
@@ -439,6 +461,7 @@ void NetworkInterfaceTL::RequestState::cancel() noexcept {
 
 NetworkInterfaceTL::RequestState::~RequestState() {
     invariant(!conn);
+    invariant(!lease);
 }
 
 Status NetworkInterfaceTL::startCommand(const TaskExecutor::CallbackHandle& cbHandle,
@@ -537,6 +560,20 @@ Status NetworkInterfaceTL::startCommand(const TaskExecutor::CallbackHandle& cbHa
         return Status::OK();
     }
 
+    if (_canMultiplex(request)) {
+        auto connFuture =
+            _getMultiplexedConnection(request.target[0], request.sslMode, request.timeout);
+        if (connFuture.isReady()) {
+            cmdState->requestManager->trySend(std::move(connFuture).getNoThrow(), 0);
+            return Status::OK();
+        }
+
+        std::move(connFuture).thenRunOn(_reactor).getAsync([cmdState = cmdState](auto swLease) {
+            cmdState->requestManager->trySend(std::move(swLease), 0);
+        });
+        return Status::OK();
+    }
+
     // Attempt to get a connection to every target host
     for (size_t idx = 0; idx < request.target.size(); ++idx) {
         auto connFuture = _pool->get(request.target[idx], request.sslMode, request.timeout);
@@ -575,6 +612,10 @@ Future<RemoteCommandResponse> NetworkInterfaceTL::CommandState::sendRequest(
     std::shared_ptr<RequestState> requestState) {
     return makeReadyFutureWith([this, requestState] {
                setTimer();
+               if (auto& lease = requestState->lease) {
+                   return lease->conn->client()->runPipelinedCommandRequest(
+                       *requestState->request, lease->msgId);
+               }
                return RequestState::getClient(requestState->conn)
                    ->runCommandRequest(*requestState->request, baton);
            })
@@ -647,8 +688,9 @@ void NetworkInterfaceTL::RequestManager::killOperationsForPendingRequests() {
         }
 
         auto conn = requestState->weakConn.lock();
-        if (!conn) {
-            // If there is nothing from weakConn, the networking has already finished.
+        auto lease = requestState->weakLease.lock();
+        if (!conn && !lease) {
+            // If there is nothing from weakConn or weakLease, the networking has already finished.
             continue;
         }
 
@@ -673,38 +715,35 @@ void NetworkInterfaceTL::RequestManager::trySend(
     StatusWith<ConnectionPool::ConnectionHandle> swConn, size_t idx) noexcept {
     // Our connection wasn't any good
     if (!swConn.isOK()) {
-        {
-            stdx::lock_guard<Latch> lk(mutex);
+        failIfNoConnections(std::move(swConn.getStatus()));
+        return;
+    }
 
-            auto currentConnsResolved = ++connsResolved;
-            if (currentConnsResolved < cmdState->maxPossibleConns()) {
-                // If we still have connections outstanding, we don't need to fail the promise.
-                return;
-            }
+    std::shared_ptr<RequestState> requestState;
 
-            if (sentIdx > 0) {
-                // If a request has been sent, we shouldn't fail the promise.
-                return;
-            }
+    {
+        stdx::lock_guard<Latch> lk(mutex);
 
-            if (isLocked) {
-                // If we've finished, obviously we don't need to fail the promise.
-                return;
-            }
+        requestState = makeRequestState(lk, idx);
+        if (!requestState) {
+            // Our command has already been satisfied or we have already sent out all
+            // the requests.
+            swConn.getValue()->indicateSuccess();
+            return;
         }
 
-        // We're the last one, set the promise if it hasn't already been set via cancel or timeout
-        if (cmdState->finishLine.arriveStrongly()) {
-            auto& reactor = cmdState->interface->_reactor;
-            if (reactor->onReactorThread()) {
-                cmdState->fulfillFinalPromise(std::move(swConn.getStatus()));
-            } else {
-                ExecutorFuture<void>(reactor, swConn.getStatus())
-                    .getAsync([this, anchor = cmdState->shared_from_this()](Status status) {
-                        cmdState->fulfillFinalPromise(std::move(status));
-                    });
-            }
-        }
+        // Set conn/weakConn+request under the lock so they will always be observed during cancel.
+        requestState->conn = std::move(swConn.getValue());
+        requestState->weakConn = requestState->conn;
+    }
+
+    sendRequest(std::move(requestState), idx);
+}
+
+void NetworkInterfaceTL::RequestManager::trySend(StatusWith<MultiplexedLease> swLease,
+                                                 size_t idx) noexcept {
+    if (!swLease.isOK()) {
+        failIfNoConnections(std::move(swLease.getStatus()));
         return;
     }
 
@@ -713,32 +752,85 @@ void NetworkInterfaceTL::RequestManager::trySend(
     {
         stdx::lock_guard<Latch> lk(mutex);
 
-        // Increment the number of conns we were able to resolve.
-        ++connsResolved;
+        requestState = makeRequestState(lk, idx);
+        if (requestState) {
+            // Set lease/weakLease under the lock so they will always be observed during cancel.
+            swLease.getValue().msgId = nextMessageId();
+            requestState->lease = std::make_shared<MultiplexedLease>(std::move(swLease.getValue()));
+            requestState->weakLease = requestState->lease;
+        }
+    }
 
-        auto haveSentAll = sentIdx >= cmdState->maxConcurrentRequests();
-        if (haveSentAll || isLocked) {
-            // Our command has already been satisfied or we have already sent out all
-            // the requests.
-            swConn.getValue()->indicateSuccess();
+    if (!requestState) {
+        // Our command has already been satisfied, give up the slot we reserved.
+        cmdState->interface->_releaseMultiplexedConnection(std::move(swLease.getValue()),
+                                                           Status::OK());
+        return;
+    }
+
+    sendRequest(std::move(requestState), idx);
+}
+
+void NetworkInterfaceTL::RequestManager::failIfNoConnections(Status status) noexcept {
+    {
+        stdx::lock_guard<Latch> lk(mutex);
+
+        auto currentConnsResolved = ++connsResolved;
+        if (currentConnsResolved < cmdState->maxPossibleConns()) {
+            // If we still have connections outstanding, we don't need to fail the promise.
             return;
         }
 
-        auto currentSentIdx = sentIdx++;
+        if (sentIdx > 0) {
+            // If a request has been sent, we shouldn't fail the promise.
+            return;
+        }
 
-        requestState = std::make_shared<RequestState>(this, cmdState->shared_from_this(), idx);
-        requestState->isHedge = currentSentIdx > 0;
+        if (isLocked) {
+            // If we've finished, obviously we don't need to fail the promise.
+            return;
+        }
+    }
 
-        // Set conn/weakConn+request under the lock so they will always be observed during cancel.
-        requestState->conn = std::move(swConn.getValue());
-        requestState->weakConn = requestState->conn;
+    // We're the last one, set the promise if it hasn't already been set via cancel or timeout
+    if (cmdState->finishLine.arriveStrongly()) {
+        auto& reactor = cmdState->interface->_reactor;
+        if (reactor->onReactorThread()) {
+            cmdState->fulfillFinalPromise(std::move(status));
+        } else {
+            ExecutorFuture<void>(reactor, std::move(status))
+                .getAsync([this, anchor = cmdState->shared_from_this()](Status status) {
+                    cmdState->fulfillFinalPromise(std::move(status));
+                });
+        }
+    }
+}
 
-        requestState->request = RemoteCommandRequest(cmdState->requestOnAny, idx);
-        requestState->host = requestState->request->target;
+auto NetworkInterfaceTL::RequestManager::makeRequestState(WithLock, size_t idx)
+    -> std::shared_ptr<RequestState> {
+    // Increment the number of conns we were able to resolve.
+    ++connsResolved;
 
-        requests.at(currentSentIdx) = requestState;
+    auto haveSentAll = sentIdx >= cmdState->maxConcurrentRequests();
+    if (haveSentAll || isLocked) {
+        return nullptr;
     }
 
+    auto currentSentIdx = sentIdx++;
+
+    auto requestState = std::make_shared<RequestState>(this, cmdState->shared_from_this(), idx);
+    requestState->isHedge = currentSentIdx > 0;
+
+    requestState->request = RemoteCommandRequest(cmdState->requestOnAny, idx);
+    requestState->host = requestState->request->target;
+
+    requests.at(currentSentIdx) = requestState;
+
+    return requestState;
+}
+
+void NetworkInterfaceTL::RequestManager::sendRequest(std::shared_ptr<RequestState> requestState,
+                                                     size_t idx) noexcept {
     LOGV2_DEBUG(4646300,
                 2,
                 "Sending request",
@@ -1265,6 +1357,179 @@ void NetworkInterfaceTL::_answerAlarm(Status status, std::shared_ptr<AlarmState>
     });
 }
 
+AsyncDBClient* NetworkInterfaceTL::MultiplexedConnection::client() const noexcept {
+    return checked_cast<connection_pool_tl::TLConnection*>(conn.get())->client();
+}
+
+bool NetworkInterfaceTL::_canMultiplex(const RemoteCommandRequestOnAny& request) const {
+    // Hedged requests and requests to several targets race connections against each other, and
+    // fire-and-forget requests have no reply to match.
+    if (_connPoolOpts.maxRequestsPerConnection <= 1 || request.target.size() != 1 ||
+        request.hedgeOptions ||
+        request.fireAndForgetMode != RemoteCommandRequest::FireAndForgetMode::kOff) {
+        return false;
+    }
+
+    // The server runs the requests on a connection one after another, so a command which may
+    // wait on the server would hold up every request queued behind it.
+    static const StringDataSet kWaitingCommands{
+        "getMore", "hello", "isMaster", "ismaster", "sleep", "waitForFailPoint"};
+    const auto& cmdObj = request.cmdObj;
+    if (kWaitingCommands.count(cmdObj.firstElementFieldNameStringData())) {
+        return false;
+    }
+
+    if (auto wc = cmdObj["writeConcern"]; wc.type() == Object) {
+        auto w = wc.Obj()["w"];
+        if ((!w.eoo() && (!w.isNumber() || w.safeNumberLong() > 1)) || wc.Obj()["j"].trueValue() ||
+            wc.Obj().hasField("wtimeout")) {
+            return false;
+        }
+    }
+
+    if (auto rc = cmdObj["readConcern"]; rc.type() == Object) {
+        const auto& rcObj = rc.Obj();
+        if (rcObj.hasField("afterClusterTime") || rcObj.hasField("afterOpTime") ||
+            rcObj.hasField("atClusterTime") || rcObj["level"].str() == "linearizable") {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+SemiFuture<NetworkInterfaceTL::MultiplexedLease> NetworkInterfaceTL::_getMultiplexedConnection(
+    const HostAndPort& target, transport::ConnectSSLMode sslMode, Milliseconds timeout) {
+    const auto maxRequests = _connPoolOpts.maxRequestsPerConnection;
+    const auto requestedAt = now();
+    auto pending = std::make_shared<PendingMultiplexedConnection>();
+    auto pf = makePromiseFuture<MultiplexedLease>();
+    {
+        stdx::lock_guard lk(_multiplexedMutex);
+        auto& hostState = _multiplexedHosts[target];
+
+        // A connection which has not completed a request for a while is likely stuck behind a slow
+        // command, so new requests go elsewhere until it catches up.
+        std::shared_ptr<MultiplexedConnection> leastLoaded;
+        for (auto& conn : hostState.connections) {
+            if (conn->status.isOK() && conn->requests < maxRequests &&
+                requestedAt - conn->lastCompletion < _connPoolOpts.pipelineStallTimeout &&
+                (!leastLoaded || conn->requests < leastLoaded->requests)) {
+                leastLoaded = conn;
+            }
+        }
+        if (leastLoaded) {
+            ++leastLoaded->requests;
+            return MultiplexedLease{std::move(leastLoaded), 0, requestedAt, true};
+        }
+
+        for (auto& pendingConn : hostState.pending) {
+            if (pendingConn->waiters.size() < maxRequests) {
+                pendingConn->waiters.push_back({std::move(pf.promise), requestedAt});
+                return std::move(pf.future).semi();
+            }
+        }
+
+        pending->waiters.push_back({std::move(pf.promise), requestedAt});
+        hostState.pending.push_back(pending);
+    }
+
+    _pool->get(target, sslMode, timeout)
+        .thenRunOn(_reactor)
+        .getAsync([this, target, pending](StatusWith<ConnectionPool::ConnectionHandle> swConn) {
+            std::shared_ptr<MultiplexedConnection> conn;
+            std::vector<PendingMultiplexedConnection::Waiter> waiters;
+            {
+                stdx::lock_guard lk(_multiplexedMutex);
+                auto& hostState = _multiplexedHosts[target];
+                auto& pendingConns = hostState.pending;
+                pendingConns.erase(std::remove(pendingConns.begin(), pendingConns.end(), pending),
+                                   pendingConns.end());
+                waiters = std::exchange(pending->waiters, {});
+
+                if (swConn.isOK()) {
+                    conn = std::make_shared<MultiplexedConnection>(target,
+                                                                   std::move(swConn.getValue()));
+                    conn->requests = waiters.size();
+                    conn->lastCompletion = now();
+                    hostState.connections.push_back(conn);
+                } else if (hostState.connections.empty() && pendingConns.empty()) {
+                    _multiplexedHosts.erase(target);
+                }
+            }
+
+            for (size_t i = 0; i < waiters.size(); ++i) {
+                auto& waiter = waiters[i];
+                if (!conn) {
+                    waiter.promise.setError(swConn.getStatus());
+                    continue;
+                }
+                // The pool records the wait of the first request, which checked the connection
+                // out.
+                waiter.promise.emplaceValue(MultiplexedLease{conn, 0, waiter.requestedAt, i > 0});
+            }
+        });
+
+    return std::move(pf.future).semi();
+}
+
+void NetworkInterfaceTL::_releaseMultiplexedConnection(MultiplexedLease lease, Status status) {
+    auto& conn = lease.conn;
+    ConnectionPool::ConnectionHandle connToReturn;
+    {
+        stdx::lock_guard lk(_multiplexedMutex);
+        const auto completedAt = now();
+        if (lease.joined) {
+            // The request waited for the ones ahead of it on the connection until the last of
+            // those completed.
+            _multiplexedWaitTimes[conn->host].increment(
+                std::max(Milliseconds(0), conn->lastCompletion - lease.requestedAt));
+        }
+        conn->lastCompletion = completedAt;
+
+        // A canceled request leaves the others on the connection running, so only a transport
+        // failure marks the connection as failed.
+        if (!status.isOK() && status != ErrorCodes::CallbackCanceled && conn->status.isOK()) {
+            conn->status = std::move(status);
+        }
+
+        invariant(conn->requests > 0);
+        if (--conn->requests > 0) {
+            return;
+        }
+
+        // The connection is idle, so hand it back to the pool.
+        auto& hostState = _multiplexedHosts[conn->host];
+        auto& connections = hostState.connections;
+        connections.erase(std::remove(connections.begin(), connections.end(), conn),
+                          connections.end());
+        if (connections.empty() && hostState.pending.empty()) {
+            _multiplexedHosts.erase(conn->host);
+        }
+
+        connToReturn = std::move(conn->conn);
+    }
+
+    if (!conn->status.isOK()) {
+        connToReturn->indicateFailure(conn->status);
+        return;
+    }
+
+    // A canceled request may still have a reply nobody is waiting for on the connection, so it
+    // cannot be reused.
+    if (!checked_cast<connection_pool_tl::TLConnection*>(connToReturn.get())
+             ->client()
+             ->isPipelineIdle()) {
+        connToReturn->indicateFailure(
+            Status(ErrorCodes::CallbackCanceled,
+                   "Multiplexed connection still has a reply to a canceled request in flight"));
+        return;
+    }
+
+    connToReturn->indicateUsed();
+    connToReturn->indicateSuccess();
+}
+
 bool NetworkInterfaceTL::onNetworkThread() {
     return _reactor->onReactorThread();
 }
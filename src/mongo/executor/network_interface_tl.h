@@ -34,6 +34,7 @@
 #include "mongo/client/async_client.h"
 #include "mongo/db/service_context.h"
 #include "mongo/executor/connection_pool.h"
+#include "mongo/executor/connection_pool_stats.h"
 #include "mongo/executor/network_interface.h"
 #include "mongo/logv2/log_severity.h"
 #include "mongo/platform/mutex.h"
@@ -42,6 +43,7 @@
 #include "mongo/stdx/unordered_map.h"
 #include "mongo/transport/baton.h"
 #include "mongo/transport/transport_layer.h"
+#include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/hierarchical_acquisition.h"
 #include "mongo/util/strong_weak_finish_line.h"
 
@@ -105,6 +107,74 @@ private:
     struct RequestState;
     struct RequestManager;
 
+    /**
+     * A connection which several requests to the same host use at once, when the connection pool
+     * options allow more than one request per connection. The requests are pipelined over it by
+     * AsyncDBClient::runPipelinedCommandRequest(), and it goes back to the pool once none of them
+     * is in flight anymore.
+     */
+    struct MultiplexedConnection {
+        MultiplexedConnection(HostAndPort host_, ConnectionPool::ConnectionHandle conn_)
+            : host(std::move(host_)), conn(std::move(conn_)) {}
+
+        AsyncDBClient* client() const noexcept;
+
+        const HostAndPort host;
+        ConnectionPool::ConnectionHandle conn;
+
+        // The following members are guarded by NetworkInterfaceTL::_multiplexedMutex.
+
+        // The number of requests which have reserved a slot on this connection.
+        size_t requests = 0;
+
+        // When the connection was checked out or last completed a request. The server runs the
+        // requests on a connection one after another, so a connection which has not completed one
+        // for long is likely stuck behind a slow command.
+        Date_t lastCompletion;
+
+        // The first transport failure of a request on this connection. Once set, no new request is
+        // assigned to the connection, and it is discarded once idle.
+        Status status = Status::OK();
+    };
+
+    /**
+     * A request's slot on a MultiplexedConnection.
+     */
+    struct MultiplexedLease {
+        std::shared_ptr<MultiplexedConnection> conn;
+
+        // The id of the message carrying the request.
+        int32_t msgId = 0;
+
+        // When the request asked for a connection.
+        Date_t requestedAt;
+
+        // Whether the request joined a connection checked out for another request. The pool only
+        // records the wait of the request which checked the connection out, so the wait of the
+        // others is recorded by the interface.
+        bool joined = false;
+    };
+
+    /**
+     * A connection being checked out of the pool on behalf of a multiplexed request, which other
+     * requests to the same host may wait for rather than checking out a connection of their own.
+     */
+    struct PendingMultiplexedConnection {
+        struct Waiter {
+            Promise<MultiplexedLease> promise;
+            Date_t requestedAt;
+        };
+
+        // The requests waiting for the connection, the first being the one which checks it out.
+        // Guarded by _multiplexedMutex.
+        std::vector<Waiter> waiters;
+    };
+
+    struct MultiplexedHost {
+        std::vector<std::shared_ptr<MultiplexedConnection>> connections;
+        std::vector<std::shared_ptr<PendingMultiplexedConnection>> pending;
+    };
+
     struct CommandStateBase : public std::enable_shared_from_this<CommandStateBase> {
         CommandStateBase(NetworkInterfaceTL* interface_,
                          RemoteCommandRequestOnAny request_,
@@ -233,9 +303,24 @@ private:
         RequestManager(CommandStateBase* cmdState);
 
         void trySend(StatusWith<ConnectionPool::ConnectionHandle> swConn, size_t idx) noexcept;
+        void trySend(StatusWith<MultiplexedLease> swLease, size_t idx) noexcept;
         void cancelRequests();
         void killOperationsForPendingRequests();
 
+        /**
+         * Fails the command if the connection attempt which failed with 'status' was the last one
+         * outstanding and no request has been sent.
+         */
+        void failIfNoConnections(Status status) noexcept;
+
+        /**
+         * Creates the state of the request to send to the target at 'idx', or returns nullptr if
+         * no more requests should be sent for the command.
+         */
+        std::shared_ptr<RequestState> makeRequestState(WithLock, size_t idx);
+
+        void sendRequest(std::shared_ptr<RequestState> requestState, size_t idx) noexcept;
+
         CommandStateBase* cmdState;
         std::vector<std::weak_ptr<RequestState>> requests;
 
@@ -296,6 +381,10 @@ private:
         ConnectionHandle conn;
         WeakConnectionHandle weakConn;
 
+        // Set instead of 'conn' when the request shares its connection with other requests.
+        std::shared_ptr<MultiplexedLease> lease;
+        std::weak_ptr<MultiplexedLease> weakLease;
+
         // Internal id of this request as tracked by the RequestManager.
         size_t reqId;
 
@@ -333,6 +422,28 @@ private:
 
     Status _killOperation(std::shared_ptr<RequestState> requestStateToKill);
 
+    /**
+     * Whether 'request' may share a connection with other requests. Only requests with a single
+     * target, which expect a reply, are not hedged and are not expected to wait on the server, are.
+     */
+    bool _canMultiplex(const RemoteCommandRequestOnAny& request) const;
+
+    /**
+     * Returns a slot for one more request on a connection to 'target'. Prefers the least loaded
+     * connection which is already checked out and has completed a request recently, then a
+     * connection being checked out, and only checks a new connection out of the pool when none of
+     * them can take the request.
+     */
+    SemiFuture<MultiplexedLease> _getMultiplexedConnection(const HostAndPort& target,
+                                                           transport::ConnectSSLMode sslMode,
+                                                           Milliseconds timeout);
+
+    /**
+     * Releases the slot of 'lease', recording 'status' if it is the first transport failure on the
+     * connection, and returns the connection to the pool if this was its last request.
+     */
+    void _releaseMultiplexedConnection(MultiplexedLease lease, Status status);
+
     std::string _instanceName;
     ServiceContext* _svcCtx = nullptr;
     transport::TransportLayer* _tl = nullptr;
@@ -346,6 +457,12 @@ private:
     std::unique_ptr<NetworkConnectionHook> _onConnectHook;
     std::shared_ptr<ConnectionPool> _pool;
 
+    mutable Mutex _multiplexedMutex = MONGO_MAKE_LATCH("NetworkInterfaceTL::_multiplexedMutex");
+    stdx::unordered_map<HostAndPort, MultiplexedHost> _multiplexedHosts;
+    // How long requests which joined a multiplexed connection waited for the requests ahead of
+    // them on it. Merged into the wait times the pool reports for each host.
+    stdx::unordered_map<HostAndPort, ConnectionWaitTimeHistogram> _multiplexedWaitTimes;
+
     class SynchronizedCounters;
     std::shared_ptr<SynchronizedCounters> _counters;
 
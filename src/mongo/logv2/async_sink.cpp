@@ -0,0 +1,345 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kControl
+
+#include "mongo/logv2/async_sink.h"
+
+#include <algorithm>
+#include <boost/log/attributes/value_extraction.hpp>
+
+#include "mongo/logv2/attributes.h"
+#include "mongo/logv2/log.h"
+#include "mongo/logv2/log_severity.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_name.h"
+
+namespace mongo::logv2 {
+namespace {
+
+// How long the writer sleeps when it is not woken up by a logging thread.
+constexpr auto kWriterIdleTimeout = Milliseconds(100);
+
+// The minimum interval between two reports of dropped records.
+constexpr auto kDropReportInterval = Seconds(1);
+
+AtomicWord<uint64_t> nextQueueId{0};
+
+// Set on the writer threads, which must never wait for a ring to have room.
+thread_local bool isWriterThread = false;
+
+// Set once the rings of the current thread were destroyed at thread exit. Trivially
+// destructible, so that it can be read by thread_local destructors which log.
+thread_local bool threadRingsDestroyed = false;
+
+// How long a non-blocking thread tries to take a lock of the queue before it gives up.
+constexpr auto kNonBlockingLockTimeout = Seconds(1);
+
+// Set on threads handling a fatal signal. Once such a thread gave up on a lock, it does not try
+// again, since the lock is most likely held by the thread itself.
+thread_local bool isNonBlockingThread = false;
+thread_local bool nonBlockingThreadGaveUp = false;
+
+size_t roundUpToPowerOfTwo(size_t n) {
+    size_t capacity = 1;
+    while (capacity < n) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+}  // namespace
+
+/**
+ * A single-producer, single-consumer ring of records. The producer is the thread owning the ring,
+ * and the consumer is whoever holds the write mutex of the queue.
+ */
+class AsyncLogQueue::Ring {
+public:
+    explicit Ring(size_t capacity)
+        : _slots(std::make_unique<Entry[]>(capacity)), _mask(capacity - 1) {}
+
+    /**
+     * Moves 'entry' into the ring, unless the ring is full. Producer only.
+     */
+    bool tryPush(Entry& entry) {
+        auto tail = _tail.loadRelaxed();
+        if (tail - _head.load() > _mask) {
+            return false;
+        }
+        _slots[tail & _mask] = std::move(entry);
+        _tail.store(tail + 1);
+        return true;
+    }
+
+    /**
+     * Moves all records in the ring to the end of 'out'. Consumer only.
+     */
+    void drain(std::vector<Entry>* out) {
+        auto head = _head.loadRelaxed();
+        auto tail = _tail.load();
+        for (; head != tail; ++head) {
+            auto& slot = _slots[head & _mask];
+            out->push_back(std::move(slot));
+            // Release the record and the string now, rather than when the slot is reused.
+            slot = Entry();
+        }
+        _head.store(head);
+    }
+
+    bool empty() const {
+        return _head.load() == _tail.load();
+    }
+
+    // Set when the owning thread exits. The ring is dropped once drained.
+    AtomicWord<bool> abandoned{false};
+
+private:
+    std::unique_ptr<Entry[]> _slots;
+    const uint64_t _mask;
+
+    AtomicWord<uint64_t> _head{0};
+    AtomicWord<uint64_t> _tail{0};
+};
+
+/**
+ * The rings of the current thread, one per queue it logged to.
+ */
+struct AsyncLogQueue::ThreadRings {
+    ~ThreadRings() {
+        for (auto&& [queueId, ring] : rings) {
+            ring->abandoned.store(true);
+        }
+        threadRingsDestroyed = true;
+    }
+
+    std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> rings;
+};
+
+AsyncLogQueue::AsyncLogQueue(Options options, stdx::mutex& writeMutex, WriteBatchFn writeBatch)
+    : _options(std::move(options)),
+      _ringCapacity(roundUpToPowerOfTwo(std::max<size_t>(_options.bufferSize, 1))),
+      _id(nextQueueId.fetchAndAdd(1)),
+      _writeMutex(writeMutex),
+      _writeBatch(std::move(writeBatch)) {
+    _writer = stdx::thread([this] { _writerLoop(); });
+}
+
+AsyncLogQueue::~AsyncLogQueue() {
+    {
+        stdx::lock_guard lk(_mutex);
+        _shutdown = true;
+        _writerCond.notify_one();
+    }
+    _writer.join();
+
+    _lockAndDrainAndWrite();
+}
+
+void AsyncLogQueue::setNonBlockingForThread() {
+    isNonBlockingThread = true;
+}
+
+bool AsyncLogQueue::_lock(stdx::mutex& mutex, stdx::unique_lock<stdx::mutex>& lk) {
+    if (!isNonBlockingThread) {
+        lk = stdx::unique_lock(mutex);
+        return true;
+    }
+
+    lk = stdx::unique_lock(mutex, stdx::try_to_lock);
+    const auto deadline = Date_t::now() + kNonBlockingLockTimeout;
+    while (!lk.owns_lock() && !nonBlockingThreadGaveUp) {
+        if (Date_t::now() >= deadline) {
+            nonBlockingThreadGaveUp = true;
+            break;
+        }
+        stdx::this_thread::sleep_for(Milliseconds(1).toSystemDuration());
+        lk.try_lock();
+    }
+    return lk.owns_lock();
+}
+
+bool AsyncLogQueue::_lockAndDrainAndWrite(Entry* extra) {
+    stdx::unique_lock<stdx::mutex> lk;
+    return _lock(_writeMutex, lk) && _drainAndWrite(extra);
+}
+
+AsyncLogQueue::Ring* AsyncLogQueue::_threadRing() {
+    thread_local ThreadRings threadRings;
+
+    auto& rings = threadRings.rings;
+    for (auto&& [queueId, ring] : rings) {
+        if (queueId == _id) {
+            return ring.get();
+        }
+    }
+
+    // Forget the rings of queues which were destroyed since this thread last registered.
+    rings.erase(std::remove_if(rings.begin(),
+                               rings.end(),
+                               [](const auto& entry) { return entry.second.use_count() == 1; }),
+                rings.end());
+
+    auto ring = std::make_shared<Ring>(_ringCapacity);
+    {
+        stdx::lock_guard lk(_mutex);
+        _rings.push_back(ring);
+    }
+    rings.emplace_back(_id, ring);
+    return ring.get();
+}
+
+void AsyncLogQueue::push(const boost::log::record_view& rec, const std::string& formatted) {
+    Entry entry{_nextSeq.fetchAndAdd(1), rec, formatted};
+
+    const bool urgent =
+        boost::log::extract<LogSeverity>(attributes::severity(), rec).get() >= LogSeverity::Error();
+    if (threadRingsDestroyed) {
+        // The thread is exiting and can't own a ring any more.
+        if (!_lockAndDrainAndWrite(&entry)) {
+            _dropped.fetchAndAdd(1);
+        }
+        return;
+    }
+
+    auto ring = _threadRing();
+    while (!ring->tryPush(entry)) {
+        if (_options.overflowPolicy == LogOverflowPolicy::kDrop || isWriterThread) {
+            _dropped.fetchAndAdd(1);
+            return;
+        }
+
+        // Block until the records of the ring are written, by writing them ourselves.
+        if (!_lockAndDrainAndWrite()) {
+            _dropped.fetchAndAdd(1);
+            return;
+        }
+    }
+
+    if (urgent) {
+        _lockAndDrainAndWrite();
+        return;
+    }
+
+    _wakeWriter();
+}
+
+void AsyncLogQueue::flush() {
+    _lockAndDrainAndWrite();
+}
+
+bool AsyncLogQueue::_drainAndWrite(Entry* extra) {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        stdx::unique_lock<stdx::mutex> lk;
+        if (!_lock(_mutex, lk)) {
+            return false;
+        }
+        // Rings whose thread exited can go once they were drained for the last time below.
+        rings = _rings;
+        _rings.erase(std::remove_if(_rings.begin(),
+                                    _rings.end(),
+                                    [](const auto& ring) {
+                                        return ring->abandoned.load() && ring->empty();
+                                    }),
+                     _rings.end());
+    }
+
+    for (auto&& ring : rings) {
+        ring->drain(&_batch);
+    }
+    if (extra) {
+        _batch.push_back(std::move(*extra));
+    }
+    if (_batch.empty()) {
+        return true;
+    }
+
+    std::sort(_batch.begin(), _batch.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.seq < rhs.seq;
+    });
+    _writeBatch(_batch);
+    _batch.clear();
+    return true;
+}
+
+void AsyncLogQueue::_wakeWriter() {
+    // Pairs with the writer publishing '_writerIdle' before checking the rings one last time.
+    if (_writerIdle.load() && _writerIdle.swap(false)) {
+        stdx::lock_guard lk(_mutex);
+        _writerCond.notify_one();
+    }
+}
+
+void AsyncLogQueue::_writerLoop() {
+    setThreadName("AsyncLogWriter");
+    isWriterThread = true;
+
+    while (true) {
+        _lockAndDrainAndWrite();
+        _reportDrops();
+
+        stdx::unique_lock lk(_mutex);
+        if (_shutdown) {
+            return;
+        }
+
+        _writerIdle.store(true);
+        if (std::any_of(
+                _rings.begin(), _rings.end(), [](const auto& ring) { return !ring->empty(); })) {
+            _writerIdle.store(false);
+            continue;
+        }
+        _writerCond.wait_for(lk, kWriterIdleTimeout.toSystemDuration(), [&] {
+            return _shutdown || !_writerIdle.load();
+        });
+        _writerIdle.store(false);
+    }
+}
+
+void AsyncLogQueue::_reportDrops() {
+    auto dropped = _dropped.load();
+    if (dropped == _reportedDrops) {
+        return;
+    }
+
+    auto now = Date_t::now();
+    if (now - _lastDropReport < kDropReportInterval) {
+        return;
+    }
+
+    LOGV2_WARNING(5150822,
+                  "Dropped log messages because the log buffer of their thread was full",
+                  "dropped"_attr = dropped - _reportedDrops,
+                  "totalDropped"_attr = dropped);
+    _reportedDrops = dropped;
+    _lastDropReport = now;
+}
+
+}  // namespace mongo::logv2
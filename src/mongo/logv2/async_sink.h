@@ -0,0 +1,255 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/log/core/record_view.hpp>
+#include <boost/log/detail/locking_ptr.hpp>
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/sinks/frontend_requirements.hpp>
+#include <boost/optional.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/logv2/log_format.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo::logv2 {
+
+/**
+ * Hands formatted log records from the threads which log them to a dedicated writer thread, which
+ * writes them in batches. Each logging thread pushes into a ring buffer of its own, so that
+ * logging takes no lock unless the ring is full. The writer gathers the records of all rings and
+ * writes each batch in the order in which its records were logged.
+ *
+ * The order holds within a batch only. A record gets its sequence number before it is pushed, so
+ * a thread which is descheduled in between may push its record after a batch holding later
+ * records was written, and the record then comes out in the next batch.
+ *
+ * Records of severity Error and above are written before push() returns: the logging thread
+ * drains all rings itself, so that the record and the ones before it reach their destination even
+ * if the process is about to abort.
+ *
+ * The records are written after the logging call returned, so the writer must only use their
+ * formatted text and the attributes which hold values, such as the severity. The message and the
+ * attributes of a log statement refer to the stack of the logging thread.
+ */
+class AsyncLogQueue {
+    AsyncLogQueue(const AsyncLogQueue&) = delete;
+    AsyncLogQueue& operator=(const AsyncLogQueue&) = delete;
+
+public:
+    struct Options {
+        // The capacity of the ring of each logging thread, rounded up to a power of two.
+        size_t bufferSize = 256;
+        LogOverflowPolicy overflowPolicy = LogOverflowPolicy::kBlock;
+    };
+
+    struct Entry {
+        uint64_t seq;
+        boost::log::record_view rec;
+        std::string formatted;
+    };
+
+    /**
+     * Writes a batch of records, in order, and flushes the destination. Called with the write
+     * mutex held.
+     */
+    using WriteBatchFn = std::function<void(const std::vector<Entry>&)>;
+
+    AsyncLogQueue(Options options, stdx::mutex& writeMutex, WriteBatchFn writeBatch);
+
+    /**
+     * Writes the records still queued and stops the writer thread.
+     */
+    ~AsyncLogQueue();
+
+    void push(const boost::log::record_view& rec, const std::string& formatted);
+
+    /**
+     * Writes the records pushed so far on the calling thread.
+     */
+    void flush();
+
+    /**
+     * Makes the calling thread give up on writing records when it can't get hold of the queue
+     * within a short time, rather than wait for it. Records it would have written are left for the
+     * writer thread, or dropped if it has no ring to leave them in.
+     *
+     * For fatal signal handlers: they may have interrupted their thread while it held the queue,
+     * in which case waiting would never end.
+     */
+    static void setNonBlockingForThread();
+
+    /**
+     * The number of records dropped because the ring of their thread was full, under the kDrop
+     * overflow policy.
+     */
+    uint64_t droppedCount() const {
+        return _dropped.load();
+    }
+
+private:
+    class Ring;
+    struct ThreadRings;
+
+    Ring* _threadRing();
+
+    /**
+     * Locks 'mutex' into 'lk', or, on a thread set to be non-blocking, tries to for a short time.
+     * Returns whether the mutex is held.
+     */
+    static bool _lock(stdx::mutex& mutex, stdx::unique_lock<stdx::mutex>& lk);
+
+    /**
+     * Takes the write mutex and writes the records of all rings, plus 'extra' if given. Returns
+     * false, leaving the records queued, if the calling thread is non-blocking and could not take
+     * the locks.
+     */
+    bool _lockAndDrainAndWrite(Entry* extra = nullptr);
+
+    /**
+     * Writes the records of all rings, plus 'extra' if given. Requires the write mutex. Returns
+     * false, writing nothing, if the calling thread is non-blocking and could not take '_mutex'.
+     */
+    bool _drainAndWrite(Entry* extra = nullptr);
+
+    void _wakeWriter();
+    void _writerLoop();
+    void _reportDrops();
+
+    const Options _options;
+    const size_t _ringCapacity;
+    const uint64_t _id;
+
+    // Held while writing to the destination, and by whoever consumes from the rings.
+    stdx::mutex& _writeMutex;
+    const WriteBatchFn _writeBatch;
+    std::vector<Entry> _batch;
+
+    AtomicWord<uint64_t> _nextSeq{0};
+    AtomicWord<uint64_t> _dropped{0};
+
+    // Protects the list of rings and the writer's sleep.
+    stdx::mutex _mutex;
+    stdx::condition_variable _writerCond;
+    std::vector<std::shared_ptr<Ring>> _rings;
+    AtomicWord<bool> _writerIdle{false};
+    bool _shutdown{false};
+
+    // Only used by the writer thread.
+    uint64_t _reportedDrops{0};
+    Date_t _lastDropReport;
+
+    stdx::thread _writer;
+};
+
+/**
+ * boost::log backend which writes to 'Backend', either synchronously on the logging thread, or
+ * through an AsyncLogQueue. Access to the wrapped backend goes through lockedBackend(), which
+ * excludes concurrent writes.
+ */
+template <typename Backend>
+class AsyncBackend
+    : public boost::log::sinks::basic_formatted_sink_backend<
+          char,
+          boost::log::sinks::combine_requirements<boost::log::sinks::concurrent_feeding,
+                                                  boost::log::sinks::flushing>::type> {
+public:
+    AsyncBackend(boost::shared_ptr<Backend> backend,
+                 boost::optional<AsyncLogQueue::Options> asyncOptions)
+        : _backend(std::move(backend)) {
+        if (asyncOptions) {
+            _queue = std::make_unique<AsyncLogQueue>(
+                *asyncOptions, _mutex, [this](const std::vector<AsyncLogQueue::Entry>& batch) {
+                    for (auto&& entry : batch) {
+                        _backend->consume(entry.rec, entry.formatted);
+                    }
+                    _flushBackend();
+                });
+        }
+    }
+
+    /**
+     * Locking accessor to the wrapped backend.
+     */
+    auto lockedBackend() {
+        return boost::log::aux::locking_ptr(_backend, _mutex);
+    }
+
+    bool isAsync() const {
+        return static_cast<bool>(_queue);
+    }
+
+    const AsyncLogQueue* queue() const {
+        return _queue.get();
+    }
+
+    void consume(boost::log::record_view const& rec, string_type const& formatted_string) {
+        if (_queue) {
+            _queue->push(rec, formatted_string);
+            return;
+        }
+
+        stdx::lock_guard lock(_mutex);
+        _backend->consume(rec, formatted_string);
+    }
+
+    void flush() {
+        if (_queue) {
+            _queue->flush();
+            return;
+        }
+
+        stdx::lock_guard lock(_mutex);
+        _flushBackend();
+    }
+
+private:
+    void _flushBackend() {
+        if constexpr (boost::log::sinks::has_requirement<typename Backend::frontend_requirements,
+                                                         boost::log::sinks::flushing>::value) {
+            _backend->flush();
+        }
+    }
+
+    boost::shared_ptr<Backend> _backend;
+    stdx::mutex _mutex;
+
+    // Destroyed first, so that the records still queued are written to '_backend'.
+    std::unique_ptr<AsyncLogQueue> _queue;
+};
+
+}  // namespace mongo::logv2
@@ -30,6 +30,7 @@
 #include "log_domain_global.h"
 
 #include "mongo/config.h"
+#include "mongo/logv2/async_sink.h"
 #include "mongo/logv2/component_settings_filter.h"
 #include "mongo/logv2/composite_backend.h"
 #include "mongo/logv2/console.h"
@@ -54,22 +55,23 @@ void LogDomainGlobal::ConfigurationOptions::makeDisabled() {
 }
 
 struct LogDomainGlobal::Impl {
-    typedef CompositeBackend<boost::log::sinks::text_ostream_backend,
+    typedef CompositeBackend<AsyncBackend<boost::log::sinks::text_ostream_backend>,
                              RamLogSink,
                              RamLogSink,
                              UserAssertSink>
         ConsoleBackend;
 #ifndef _WIN32
-    typedef CompositeBackend<boost::log::sinks::syslog_backend,
+    typedef CompositeBackend<AsyncBackend<boost::log::sinks::syslog_backend>,
                              RamLogSink,
                              RamLogSink,
                              UserAssertSink>
         SyslogBackend;
 #endif
-    typedef CompositeBackend<FileRotateSink, RamLogSink, RamLogSink, UserAssertSink>
+    typedef CompositeBackend<AsyncBackend<FileRotateSink>, RamLogSink, RamLogSink, UserAssertSink>
         RotatableFileBackend;
 
     Impl(LogDomainGlobal& parent);
+    void makeConsoleSink(boost::optional<AsyncLogQueue::Options> asyncOptions);
     Status configure(LogDomainGlobal::ConfigurationOptions const& options);
     Status rotate(bool rename, StringData renameSuffix);
 
@@ -91,39 +93,54 @@ struct LogDomainGlobal::Impl {
 };
 
 LogDomainGlobal::Impl::Impl(LogDomainGlobal& parent) : _parent(parent) {
+    makeConsoleSink(boost::none);
+
+    // Set default configuration
+    invariant(configure({}).isOK());
+
+    // Make a call to source() to make sure the internal thread_local is created as early as
+    // possible and thus destroyed as late as possible.
+    source();
+}
+
+void LogDomainGlobal::Impl::makeConsoleSink(boost::optional<AsyncLogQueue::Options> asyncOptions) {
     auto console = boost::make_shared<ConsoleBackend>(
-        boost::make_shared<boost::log::sinks::text_ostream_backend>(),
+        boost::make_shared<AsyncBackend<boost::log::sinks::text_ostream_backend>>(
+            boost::make_shared<boost::log::sinks::text_ostream_backend>(), asyncOptions),
         boost::make_shared<RamLogSink>(RamLog::get("global")),
         boost::make_shared<RamLogSink>(RamLog::get("startupWarnings")),
         boost::make_shared<UserAssertSink>());
 
-    console->lockedBackend<0>()->add_stream(
+    console->lockedBackend<0>()->lockedBackend()->add_stream(
         boost::shared_ptr<std::ostream>(&Console::out(), boost::null_deleter()));
-    console->lockedBackend<0>()->auto_flush();
+    // Asynchronous writes flush once per batch.
+    console->lockedBackend<0>()->lockedBackend()->auto_flush(!asyncOptions);
     console->setFilter<2>(
         TaggedSeverityFilter(_parent, {LogTag::kStartupWarnings}, LogSeverity::Log()));
 
     _consoleSink =
         boost::make_shared<boost::log::sinks::unlocked_sink<ConsoleBackend>>(std::move(console));
     _consoleSink->set_filter(ComponentSettingsFilter(_parent, _settings));
-
-    // Set default configuration
-    invariant(configure({}).isOK());
-
-    // Make a call to source() to make sure the internal thread_local is created as early as
-    // possible and thus destroyed as late as possible.
-    source();
 }
 
 Status LogDomainGlobal::Impl::configure(LogDomainGlobal::ConfigurationOptions const& options) {
+    boost::optional<AsyncLogQueue::Options> asyncOptions;
+    if (options.asyncEnabled) {
+        asyncOptions.emplace();
+        asyncOptions->bufferSize = options.asyncBufferSize;
+        asyncOptions->overflowPolicy = options.asyncOverflowPolicy;
+    }
+
 #ifndef _WIN32
     if (options.syslogEnabled) {
         // Create a backend
         auto backend = boost::make_shared<SyslogBackend>(
-            boost::make_shared<boost::log::sinks::syslog_backend>(
-                boost::log::keywords::facility =
-                    boost::log::sinks::syslog::make_facility(options.syslogFacility),
-                boost::log::keywords::use_impl = boost::log::sinks::syslog::native),
+            boost::make_shared<AsyncBackend<boost::log::sinks::syslog_backend>>(
+                boost::make_shared<boost::log::sinks::syslog_backend>(
+                    boost::log::keywords::facility =
+                        boost::log::sinks::syslog::make_facility(options.syslogFacility),
+                    boost::log::keywords::use_impl = boost::log::sinks::syslog::native),
+                asyncOptions),
             boost::make_shared<RamLogSink>(RamLog::get("global")),
             boost::make_shared<RamLogSink>(RamLog::get("startupWarnings")),
             boost::make_shared<UserAssertSink>());
@@ -142,7 +159,7 @@ Status LogDomainGlobal::Impl::configure(LogDomainGlobal::ConfigurationOptions co
         mapping[LogSeverity::Error()] = boost::log::sinks::syslog::critical;
         mapping[LogSeverity::Severe()] = boost::log::sinks::syslog::alert;
 
-        backend->lockedBackend<0>()->set_severity_mapper(mapping);
+        backend->lockedBackend<0>()->lockedBackend()->set_severity_mapper(mapping);
         backend->setFilter<2>(
             TaggedSeverityFilter(_parent, {LogTag::kStartupWarnings}, LogSeverity::Log()));
 
@@ -159,16 +176,17 @@ Status LogDomainGlobal::Impl::configure(LogDomainGlobal::ConfigurationOptions co
 
     if (options.fileEnabled) {
         auto backend = boost::make_shared<RotatableFileBackend>(
-            boost::make_shared<FileRotateSink>(options.timestampFormat),
+            boost::make_shared<AsyncBackend<FileRotateSink>>(
+                boost::make_shared<FileRotateSink>(options.timestampFormat), asyncOptions),
             boost::make_shared<RamLogSink>(RamLog::get("global")),
             boost::make_shared<RamLogSink>(RamLog::get("startupWarnings")),
             boost::make_shared<UserAssertSink>());
-        Status ret = backend->lockedBackend<0>()->addFile(
+        Status ret = backend->lockedBackend<0>()->lockedBackend()->addFile(
             options.filePath,
             options.fileOpenMode == ConfigurationOptions::OpenMode::kAppend ? true : false);
         if (!ret.isOK())
             return ret;
-        backend->lockedBackend<0>()->auto_flush(true);
+        backend->lockedBackend<0>()->lockedBackend()->auto_flush(!asyncOptions);
         backend->setFilter<2>(
             TaggedSeverityFilter(_parent, {LogTag::kStartupWarnings}, LogSeverity::Log()));
 
@@ -182,6 +200,18 @@ Status LogDomainGlobal::Impl::configure(LogDomainGlobal::ConfigurationOptions co
         _rotatableFileSink.reset();
     }
 
+    if (options.asyncEnabled != _consoleSink->locked_backend()->lockedBackend<0>()->isAsync() ||
+        (options.asyncEnabled &&
+         (options.asyncBufferSize != _config.asyncBufferSize ||
+          options.asyncOverflowPolicy != _config.asyncOverflowPolicy))) {
+        // Replace the console sink by one writing in the requested mode. It is added back below
+        // if the console is enabled.
+        if (_consoleSink.use_count() > 1) {
+            boost::log::core::get()->remove_sink(_consoleSink);
+        }
+        makeConsoleSink(asyncOptions);
+    }
+
     auto setFormatters = [this](auto&& mkFmt) {
         _consoleSink->set_formatter(mkFmt());
         if (_rotatableFileSink)
@@ -225,7 +255,9 @@ const LogDomainGlobal::ConfigurationOptions& LogDomainGlobal::Impl::config() con
 Status LogDomainGlobal::Impl::rotate(bool rename, StringData renameSuffix) {
     if (_rotatableFileSink) {
         auto backend = _rotatableFileSink->locked_backend()->lockedBackend<0>();
-        return backend->rotate(rename, renameSuffix);
+        // Write out what was logged before the rotation to the current file.
+        backend->flush();
+        return backend->lockedBackend()->rotate(rename, renameSuffix);
     }
     return Status::OK();
 }
@@ -51,6 +51,13 @@ public:
         LogFormat format{LogFormat::kDefault};
         const AtomicWord<int32_t>* maxAttributeSizeKB = nullptr;
 
+        // Whether the console, file and syslog destinations are written by a dedicated thread
+        // rather than by the logging threads, and what a logging thread does when its buffer of
+        // 'asyncBufferSize' records is full.
+        bool asyncEnabled{false};
+        size_t asyncBufferSize{256};
+        LogOverflowPolicy asyncOverflowPolicy{LogOverflowPolicy::kBlock};
+
         void makeDisabled();
     };
 
@@ -34,4 +34,8 @@ namespace mongo::logv2 {
 enum class LogFormat { kDefault, kJson, kPlain };
 enum class LogTimestampFormat { kISO8601UTC, kISO8601Local };
 
+// What a thread logging asynchronously does when its log buffer is full: drop the record, or
+// block until the buffer was written out.
+enum class LogOverflowPolicy { kDrop, kBlock };
+
 }  // namespace mongo::logv2
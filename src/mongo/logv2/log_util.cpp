@@ -31,10 +31,12 @@
 
 #include "mongo/logv2/log_util.h"
 
+#include "mongo/logv2/async_sink.h"
 #include "mongo/logv2/log.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/time_support.h"
 
+#include <boost/log/core/core.hpp>
 #include <string>
 #include <vector>
 
@@ -68,6 +70,14 @@ bool rotateLogs(bool renameFiles) {
     return success;
 }
 
+void flushLogs() {
+    boost::log::core::get()->flush();
+}
+
+void setLogWritesNonBlockingForThread() {
+    AsyncLogQueue::setNonBlockingForThread();
+}
+
 bool shouldRedactLogs() {
     return redactionEnabled.loadRelaxed();
 }
@@ -52,6 +52,19 @@ void addLogRotator(LogRotateCallback cb);
  */
 bool rotateLogs(bool renameFiles);
 
+/**
+ * Writes out the log records which are still buffered, e.g. by asynchronous sinks. Call before
+ * exiting the process.
+ */
+void flushLogs();
+
+/**
+ * Makes the calling thread give up on writing or flushing buffered log records when it can't get
+ * hold of their destination within a short time, rather than wait for it. Called by fatal signal
+ * handlers, which may have interrupted their thread while it was writing a log record itself.
+ */
+void setLogWritesNonBlockingForThread();
+
 /**
  * Returns true if system logs should be redacted.
  */
@@ -29,6 +29,7 @@
 
 #define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kDefault
 
+#include "mongo/logv2/async_sink.h"
 #include "mongo/logv2/component_settings_filter.h"
 #include "mongo/logv2/log.h"
 #include "mongo/logv2/log_domain_global.h"
@@ -40,7 +41,9 @@
 #include <boost/iostreams/stream.hpp>
 #include <boost/log/sinks/sync_frontend.hpp>
 #include <boost/log/sinks/text_ostream_backend.hpp>
+#include <boost/log/sinks/unlocked_frontend.hpp>
 #include <boost/make_shared.hpp>
+#include <fstream>
 #include <iostream>
 
 
@@ -52,13 +55,34 @@ boost::shared_ptr<std::ostream> makeNullStream() {
     return boost::make_shared<bios::stream<bios::null_sink>>(bios::null_sink{});
 }
 
+// A file stream on the null device, so that every flush costs a write system call, as it does
+// when logging to a real file.
+boost::shared_ptr<std::ostream> makeNullDeviceStream() {
+#ifdef _WIN32
+    return boost::make_shared<std::ofstream>("NUL");
+#else
+    return boost::make_shared<std::ofstream>("/dev/null");
+#endif
+}
+
+enum class SinkMode {
+    // The logging threads format and write each line, flushing the stream every time.
+    kSynchronous,
+    // Writes to the null device, synchronously or through an asynchronous sink with the given
+    // overflow policy.
+    kNullDeviceSynchronous,
+    kNullDeviceAsyncBlock,
+    kNullDeviceAsyncDrop,
+};
+
 // RAII style helper class for init/deinit new log system
 class ScopedLogV2Bench {
 public:
-    ScopedLogV2Bench(benchmark::State& state) {
+    ScopedLogV2Bench(benchmark::State& state, SinkMode mode = SinkMode::kSynchronous)
+        : _state(state) {
         _shouldInit = state.thread_index == 0;
         if (_shouldInit) {
-            setupAppender();
+            setupAppender(mode);
         }
     }
 
@@ -69,31 +93,55 @@ public:
     }
 
 private:
-    void setupAppender() {
+    using TextBackend = boost::log::sinks::text_ostream_backend;
+
+    template <typename Sink>
+    void addSink(boost::shared_ptr<Sink> sink) {
+        sink->set_filter(
+            logv2::ComponentSettingsFilter(logv2::LogManager::global().getGlobalDomain(),
+                                           logv2::LogManager::global().getGlobalSettings()));
+        sink->set_formatter(logv2::TextFormatter());
+        boost::log::core::get()->add_sink(sink);
+        _sink = std::move(sink);
+    }
+
+    void setupAppender(SinkMode mode) {
         logv2::LogDomainGlobal::ConfigurationOptions config;
         config.makeDisabled();
         invariant(logv2::LogManager::global().getGlobalDomainInternal().configure(config).isOK());
 
-        auto backend = boost::make_shared<boost::log::sinks::text_ostream_backend>();
-        backend->add_stream(makeNullStream());
-        backend->auto_flush(true);
+        auto backend = boost::make_shared<TextBackend>();
+        backend->add_stream(mode == SinkMode::kSynchronous ? makeNullStream()
+                                                           : makeNullDeviceStream());
 
-        _sink = boost::make_shared<
-            boost::log::sinks::synchronous_sink<boost::log::sinks::text_ostream_backend>>(backend);
-        _sink->set_filter(
-            logv2::ComponentSettingsFilter(logv2::LogManager::global().getGlobalDomain(),
-                                           logv2::LogManager::global().getGlobalSettings()));
-        _sink->set_formatter(logv2::TextFormatter());
-        boost::log::core::get()->add_sink(_sink);
+        if (mode == SinkMode::kSynchronous || mode == SinkMode::kNullDeviceSynchronous) {
+            backend->auto_flush(true);
+            addSink(boost::make_shared<boost::log::sinks::synchronous_sink<TextBackend>>(backend));
+            return;
+        }
+
+        logv2::AsyncLogQueue::Options options;
+        options.overflowPolicy = mode == SinkMode::kNullDeviceAsyncBlock
+            ? logv2::LogOverflowPolicy::kBlock
+            : logv2::LogOverflowPolicy::kDrop;
+        _asyncBackend = boost::make_shared<logv2::AsyncBackend<TextBackend>>(backend, options);
+        addSink(boost::make_shared<
+                boost::log::sinks::unlocked_sink<logv2::AsyncBackend<TextBackend>>>(
+            _asyncBackend));
     }
 
     void tearDownAppender() {
         boost::log::core::get()->remove_sink(_sink);
+        if (_asyncBackend) {
+            _asyncBackend->flush();
+            _state.counters["dropped"] = _asyncBackend->queue()->droppedCount();
+        }
         invariant(logv2::LogManager::global().getGlobalDomainInternal().configure({}).isOK());
     }
 
-    boost::shared_ptr<boost::log::sinks::synchronous_sink<boost::log::sinks::text_ostream_backend>>
-        _sink;
+    benchmark::State& _state;
+    boost::shared_ptr<boost::log::sinks::sink> _sink;
+    boost::shared_ptr<logv2::AsyncBackend<TextBackend>> _asyncBackend;
     bool _shouldInit;
 };
 
@@ -150,17 +198,59 @@ void BM_EnabledLogV2ManySmallArg(benchmark::State& state) {
     }
 }
 
+void logSlowOperation() {
+    LOGV2(5150829,
+          "Slow query",
+          "ns"_attr = "test.coll"_sd,
+          "command"_attr = BSON("find"
+                                << "coll"
+                                << "filter" << BSON("a" << 1)),
+          "planSummary"_attr = "COLLSCAN"_sd,
+          "docsExamined"_attr = 1000,
+          "durationMillis"_attr = 0);
+}
+
+void BM_SlowOpLogV2NullDeviceSync(benchmark::State& state) {
+    ScopedLogV2Bench init(state, SinkMode::kNullDeviceSynchronous);
+
+    for (auto _ : state)
+        logSlowOperation();
+}
+
+void BM_SlowOpLogV2NullDeviceAsyncBlock(benchmark::State& state) {
+    ScopedLogV2Bench init(state, SinkMode::kNullDeviceAsyncBlock);
+
+    for (auto _ : state)
+        logSlowOperation();
+}
+
+void BM_SlowOpLogV2NullDeviceAsyncDrop(benchmark::State& state) {
+    ScopedLogV2Bench init(state, SinkMode::kNullDeviceAsyncDrop);
+
+    for (auto _ : state)
+        logSlowOperation();
+}
+
 void ThreadCounts(benchmark::internal::Benchmark* b) {
     int tc[] = {1, 2, 4, 8};
     for (int t : tc)
         b->Threads(t);
 }
 
+void ContendedThreadCounts(benchmark::internal::Benchmark* b) {
+    int tc[] = {1, 4, 16, 32};
+    for (int t : tc)
+        b->Threads(t);
+}
+
 BENCHMARK(BM_NoopLogV2)->Apply(ThreadCounts);
 BENCHMARK(BM_NoopLogV2Arg)->Apply(ThreadCounts);
 BENCHMARK(BM_EnabledLogV2)->Apply(ThreadCounts);
 BENCHMARK(BM_EnabledLogV2ExpensiveArg)->Apply(ThreadCounts);
 BENCHMARK(BM_EnabledLogV2ManySmallArg)->Apply(ThreadCounts);
+BENCHMARK(BM_SlowOpLogV2NullDeviceSync)->Apply(ContendedThreadCounts);
+BENCHMARK(BM_SlowOpLogV2NullDeviceAsyncBlock)->Apply(ContendedThreadCounts);
+BENCHMARK(BM_SlowOpLogV2NullDeviceAsyncDrop)->Apply(ContendedThreadCounts);
 
 }  // namespace
 }  // namespace mongo
@@ -40,6 +40,7 @@
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/json.h"
 #include "mongo/bson/oid.h"
+#include "mongo/logv2/async_sink.h"
 #include "mongo/logv2/bson_formatter.h"
 #include "mongo/logv2/component_settings_filter.h"
 #include "mongo/logv2/composite_backend.h"
@@ -1516,6 +1517,154 @@ TEST_F(LogV2Test, Threads) {
     ASSERT(linesJson.size() == threads.size() * kNumPerThread);
 }
 
+// Holds the lines captured by LogV2AsyncTest. A base class of the fixture, so that the lines
+// outlive the sinks, which the writer threads may still write to until LogV2Test detaches them.
+struct AsyncCapturedLines {
+    std::vector<std::string> capturedLines;
+};
+
+class LogV2AsyncTest : private AsyncCapturedLines, public LogV2Test {
+public:
+    using Backend = AsyncBackend<LogCaptureBackend>;
+
+    boost::shared_ptr<Backend> makeAsyncCapture(
+        boost::optional<AsyncLogQueue::Options> options) {
+        auto backend = boost::make_shared<Backend>(
+            boost::make_shared<LogCaptureBackend>(capturedLines), options);
+        auto sink = wrapInUnlockedSink(backend);
+        applyDefaultFilterToSink(sink);
+        sink->set_formatter(PlainFormatter());
+        attachSink(sink);
+        return backend;
+    }
+
+    /**
+     * Returns the lines written so far. The writer may still be running, so the caller must hold
+     * the lock of the backend.
+     */
+    const std::vector<std::string>& lines() const {
+        return capturedLines;
+    }
+};
+
+TEST_F(LogV2AsyncTest, Threads) {
+    auto backend = makeAsyncCapture(AsyncLogQueue::Options());
+    ASSERT(backend->isAsync());
+
+    constexpr int kNumThreads = 4;
+    constexpr int kNumPerThread = 1000;
+    std::vector<stdx::thread> threads;
+    for (int t = 0; t < kNumThreads; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < kNumPerThread; ++i) {
+                LOGV2(5150823, "{thread} {i}", "thread"_attr = t, "i"_attr = i);
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+    backend->flush();
+
+    // Every line is written once, and the lines of each thread are in order.
+    auto locked = backend->lockedBackend();
+    ASSERT_EQ(lines().size(), kNumThreads * kNumPerThread);
+    std::vector<int> next(kNumThreads, 0);
+    for (auto&& line : lines()) {
+        auto space = line.find(' ');
+        auto t = std::stoi(line.substr(0, space));
+        ASSERT_EQ(std::stoi(line.substr(space + 1)), next[t]++);
+    }
+    ASSERT_EQ(backend->queue()->droppedCount(), 0U);
+}
+
+TEST_F(LogV2AsyncTest, BlockPolicyWritesFullBuffer) {
+    AsyncLogQueue::Options options;
+    options.bufferSize = 4;
+    options.overflowPolicy = LogOverflowPolicy::kBlock;
+    auto backend = makeAsyncCapture(options);
+
+    for (int i = 0; i < 100; ++i) {
+        LOGV2(5150824, "{i}", "i"_attr = i);
+    }
+    backend->flush();
+
+    auto locked = backend->lockedBackend();
+    ASSERT_EQ(lines().size(), 100U);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(lines()[i], std::to_string(i));
+    }
+    ASSERT_EQ(backend->queue()->droppedCount(), 0U);
+}
+
+TEST_F(LogV2AsyncTest, DropPolicyCountsDroppedLines) {
+    AsyncLogQueue::Options options;
+    options.bufferSize = 4;
+    options.overflowPolicy = LogOverflowPolicy::kDrop;
+    auto backend = makeAsyncCapture(options);
+
+    {
+        // Keep the writer from draining the buffer.
+        auto locked = backend->lockedBackend();
+        for (int i = 0; i < 7; ++i) {
+            LOGV2(5150825, "{i}", "i"_attr = i);
+        }
+        ASSERT_EQ(backend->queue()->droppedCount(), 3U);
+    }
+    backend->flush();
+
+    auto locked = backend->lockedBackend();
+    ASSERT_GTE(lines().size(), 4U);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(lines()[i], std::to_string(i));
+    }
+}
+
+TEST_F(LogV2AsyncTest, ErrorsAreWrittenBeforeReturning) {
+    auto backend = makeAsyncCapture(AsyncLogQueue::Options());
+
+    LOGV2(5150826, "before");
+    LOGV2_ERROR(5150827, "error");
+
+    auto locked = backend->lockedBackend();
+    ASSERT_GTE(lines().size(), 2U);
+    auto error = std::find(lines().begin(), lines().end(), "error");
+    ASSERT(error != lines().end());
+    ASSERT(std::find(lines().begin(), error, "before") != error);
+}
+
+TEST_F(LogV2AsyncTest, NonBlockingThreadGivesUpWhenTheDestinationIsHeld) {
+    auto backend = makeAsyncCapture(AsyncLogQueue::Options());
+
+    {
+        // Stands in for the destination being held by a thread which never lets go of it.
+        auto locked = backend->lockedBackend();
+        stdx::thread thread([&] {
+            AsyncLogQueue::setNonBlockingForThread();
+            LOGV2_ERROR(5150837, "error");
+            backend->flush();
+        });
+        thread.join();
+        ASSERT(lines().empty());
+    }
+
+    // The line was left in the buffer rather than lost.
+    backend->flush();
+    auto locked = backend->lockedBackend();
+    ASSERT_EQ(lines().size(), 1U);
+    ASSERT_EQ(lines().back(), "error");
+}
+
+TEST_F(LogV2AsyncTest, SynchronousModeWritesBeforeReturning) {
+    auto backend = makeAsyncCapture(boost::none);
+    ASSERT_FALSE(backend->isAsync());
+
+    LOGV2(5150828, "sync");
+    auto locked = backend->lockedBackend();
+    ASSERT_EQ(lines().size(), 1U);
+    ASSERT_EQ(lines().back(), "sync");
+}
+
 TEST_F(LogV2Test, Ramlog) {
     RamLog* ramlog = RamLog::get("test_ramlog");
     auto sink = wrapInUnlockedSink(boost::make_shared<RamLogSink>(ramlog));
@@ -111,93 +111,173 @@ std::vector<std::shared_ptr<ChunkInfo>> flatten(const std::vector<ChunkType>& ch
     return flattened;
 }
 
-}  // namespace
+void checkContinuity(const ChunkInfo& prevChunk, const ChunkInfo& chunk) {
+    const auto& lastMax = prevChunk.getMax();
+    const auto& min = chunk.getMin();
+    if (SimpleBSONObjComparator::kInstance.evaluate(lastMax == min)) {
+        return;
+    }
 
-ShardVersionMap ChunkMap::constructShardVersionMap() const {
-    ShardVersionMap shardVersions;
-    ChunkVector::const_iterator current = _chunkMap.cbegin();
+    if (SimpleBSONObjComparator::kInstance.evaluate(lastMax < min))
+        uasserted(ErrorCodes::ConflictingOperationInProgress,
+                  str::stream() << "Gap exists in the routing table between chunks "
+                                << prevChunk.getRange().toString() << " and "
+                                << chunk.getRange().toString());
+    else
+        uasserted(ErrorCodes::ConflictingOperationInProgress,
+                  str::stream() << "Overlap exists in the routing table between chunks "
+                                << prevChunk.getRange().toString() << " and "
+                                << chunk.getRange().toString());
+}
 
-    boost::optional<BSONObj> firstMin = boost::none;
-    boost::optional<BSONObj> lastMax = boost::none;
+}  // namespace
 
-    while (current != _chunkMap.cend()) {
-        const auto& firstChunkInRange = *current;
-        const auto& currentRangeShardId = firstChunkInRange->getShardIdAt(boost::none);
+void ChunkMap::Block::seal() {
+    invariant(!chunks.empty());
 
-        // Tracks the max shard version for the shard on which the current range will reside
-        auto shardVersionIt = shardVersions.find(currentRangeShardId);
-        if (shardVersionIt == shardVersions.end()) {
-            shardVersionIt =
-                shardVersions.emplace(currentRangeShardId, _collectionVersion.epoch()).first;
-        }
+    maxVersion = chunks.front()->getLastmod();
+    shardVersions.clear();
+    discontinuity = boost::none;
 
-        auto& maxShardVersion = shardVersionIt->second.shardVersion;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const auto& chunk = chunks[i];
+        const auto& version = chunk->getLastmod();
+        maxVersion = std::max(maxVersion, version);
 
-        current =
-            std::find_if(current,
-                         _chunkMap.cend(),
-                         [&currentRangeShardId, &maxShardVersion](const auto& currentChunk) {
-                             if (currentChunk->getShardIdAt(boost::none) != currentRangeShardId)
-                                 return true;
+        auto it = shardVersions.emplace(chunk->getShardIdAt(boost::none), version).first;
+        it->second = std::max(it->second, version);
 
-                             if (currentChunk->getLastmod() > maxShardVersion)
-                                 maxShardVersion = currentChunk->getLastmod();
+        if (i > 0 && !discontinuity &&
+            !SimpleBSONObjComparator::kInstance.evaluate(chunks[i - 1]->getMax() ==
+                                                         chunk->getMin())) {
+            discontinuity = i;
+        }
+    }
 
-                             return false;
-                         });
+    sealed = true;
+}
 
-        const auto rangeLast = *std::prev(current);
+ShardVersionMap ChunkMap::constructShardVersionMap() const {
+    ShardVersionMap shardVersions;
 
-        const auto& rangeMin = firstChunkInRange->getMin();
-        const auto& rangeMax = rangeLast->getMax();
+    for (size_t i = 0; i < _blocks.size(); ++i) {
+        const auto& block = *_blocks[i];
+        invariant(block.sealed);
 
         // Check the continuity of the chunks map
-        if (lastMax && !SimpleBSONObjComparator::kInstance.evaluate(*lastMax == rangeMin)) {
-            if (SimpleBSONObjComparator::kInstance.evaluate(*lastMax < rangeMin))
-                uasserted(ErrorCodes::ConflictingOperationInProgress,
-                          str::stream() << "Gap exists in the routing table between chunks "
-                                        << findIntersectingChunk(*lastMax)->getRange().toString()
-                                        << " and " << rangeLast->getRange().toString());
-            else
-                uasserted(ErrorCodes::ConflictingOperationInProgress,
-                          str::stream() << "Overlap exists in the routing table between chunks "
-                                        << findIntersectingChunk(*lastMax)->getRange().toString()
-                                        << " and " << rangeLast->getRange().toString());
+        if (block.discontinuity) {
+            checkContinuity(*block.chunks[*block.discontinuity - 1],
+                            *block.chunks[*block.discontinuity]);
+        }
+        if (i > 0) {
+            checkContinuity(*_blocks[i - 1]->chunks.back(), *block.chunks.front());
         }
 
-        if (!firstMin)
-            firstMin = rangeMin;
+        for (const auto& [shardId, version] : block.shardVersions) {
+            // Tracks the max shard version for the shard
+            auto shardVersionIt = shardVersions.find(shardId);
+            if (shardVersionIt == shardVersions.end()) {
+                shardVersionIt = shardVersions.emplace(shardId, _collectionVersion.epoch()).first;
+            }
 
-        lastMax = rangeMax;
+            auto& maxShardVersion = shardVersionIt->second.shardVersion;
+            if (version > maxShardVersion)
+                maxShardVersion = version;
 
-        // If a shard has chunks it must have a shard version, otherwise we have an invalid chunk
-        // somewhere, which should have been caught at chunk load time
-        invariant(maxShardVersion.isSet());
+            // If a shard has chunks it must have a shard version, otherwise we have an invalid
+            // chunk somewhere, which should have been caught at chunk load time
+            invariant(maxShardVersion.isSet());
+        }
     }
 
-    if (!_chunkMap.empty()) {
+    if (!_blocks.empty()) {
         invariant(!shardVersions.empty());
-        invariant(firstMin.is_initialized());
-        invariant(lastMax.is_initialized());
 
-        checkAllElementsAreOfType(MinKey, firstMin.get());
-        checkAllElementsAreOfType(MaxKey, lastMax.get());
+        checkAllElementsAreOfType(MinKey, _blocks.front()->chunks.front()->getMin());
+        checkAllElementsAreOfType(MaxKey, _blocks.back()->chunks.back()->getMax());
     }
 
     return shardVersions;
 }
 
-void ChunkMap::appendChunk(const std::shared_ptr<ChunkInfo>& chunk) {
-    appendChunkTo(_chunkMap, chunk);
+ChunkMap::Block& ChunkMap::_mutableLastBlock() {
+    invariant(!_blocks.empty());
+
+    // Sealed blocks may be shared with other ChunkMaps, so they are copied before being modified.
+    if (_blocks.back()->sealed) {
+        auto block = std::make_shared<Block>(*_blocks.back());
+        block->sealed = false;
+        _blocks.back() = std::move(block);
+    }
 
+    return *_blocks.back();
+}
+
+void ChunkMap::_appendChunk(const std::shared_ptr<ChunkInfo>& chunk) {
     _collectionVersion = std::max(_collectionVersion, chunk->getLastmod());
+
+    if (!_blocks.empty() && chunk->getRange().overlaps(_blocks.back()->chunks.back()->getRange())) {
+        if (chunk->getLastmod() > _blocks.back()->chunks.back()->getLastmod()) {
+            auto& block = _mutableLastBlock();
+            block.chunks.back() = chunk;
+            block.maxKeyStrings.back() = chunk->getMaxKeyString();
+            _blockMaxKeyStrings.back() = chunk->getMaxKeyString();
+        }
+        return;
+    }
+
+    if (_blocks.empty() || _blocks.back()->sealed ||
+        _blocks.back()->chunks.size() >= kMaxChunksPerBlock) {
+        auto block = std::make_shared<Block>();
+        block->chunks.reserve(kMaxChunksPerBlock);
+        block->maxKeyStrings.reserve(kMaxChunksPerBlock);
+        _blocks.push_back(std::move(block));
+        _blockMaxKeyStrings.emplace_back();
+    }
+
+    auto& block = *_blocks.back();
+    block.chunks.push_back(chunk);
+    block.maxKeyStrings.push_back(chunk->getMaxKeyString());
+    _blockMaxKeyStrings.back() = chunk->getMaxKeyString();
+    ++_size;
+}
+
+bool ChunkMap::_canAppendBlock(const Block& block, const ChunkInfo* nextChangedChunk) const {
+    // A changed chunk which starts before the end of the block may replace some of its chunks.
+    if (nextChangedChunk &&
+        SimpleBSONObjComparator::kInstance.evaluate(nextChangedChunk->getMin() <
+                                                    block.chunks.back()->getMax())) {
+        return false;
+    }
+
+    if (_blocks.empty()) {
+        return true;
+    }
+
+    const auto& lastBlock = *_blocks.back();
+    if (lastBlock.chunks.back()->getRange().overlaps(block.chunks.front()->getRange())) {
+        return false;
+    }
+
+    // Rather than leave behind a partially filled block, fill it with the chunks of 'block' if
+    // they fit, so that repeated refreshes don't fragment the map into ever smaller blocks.
+    return lastBlock.sealed || lastBlock.chunks.size() + block.chunks.size() > kMaxChunksPerBlock;
+}
+
+void ChunkMap::_appendBlock(const std::shared_ptr<Block>& block) {
+    invariant(block->sealed);
+
+    _collectionVersion = std::max(_collectionVersion, block->maxVersion);
+    _blocks.push_back(block);
+    _blockMaxKeyStrings.push_back(block->maxKeyStrings.back());
+    _size += block->chunks.size();
 }
 
 std::shared_ptr<ChunkInfo> ChunkMap::findIntersectingChunk(const BSONObj& shardKey) const {
-    const auto it = _findIntersectingChunk(shardKey);
+    const auto pos = _findIntersectingChunk(shardKey);
 
-    if (it != _chunkMap.end())
-        return *it;
+    if (pos < _end())
+        return _blocks[pos.block]->chunks[pos.chunk];
 
     return std::shared_ptr<ChunkInfo>();
 }
@@ -213,86 +293,120 @@ void validateChunk(const std::shared_ptr<ChunkInfo>& chunk, const ChunkVersion&
 
 ChunkMap ChunkMap::createMerged(
     const std::vector<std::shared_ptr<ChunkInfo>>& changedChunks) const {
-    size_t chunkMapIndex = 0;
+    Position pos;
     size_t changedChunkIndex = 0;
 
-    ChunkMap updatedChunkMap(getVersion().epoch(), _chunkMap.size() + changedChunks.size());
+    ChunkMap updatedChunkMap(getVersion().epoch(), _size + changedChunks.size());
 
-    while (chunkMapIndex < _chunkMap.size() || changedChunkIndex < changedChunks.size()) {
-        if (chunkMapIndex >= _chunkMap.size()) {
+    while (pos < _end() || changedChunkIndex < changedChunks.size()) {
+        if (!(pos < _end())) {
             validateChunk(changedChunks[changedChunkIndex], getVersion());
-            updatedChunkMap.appendChunk(changedChunks[changedChunkIndex++]);
+            updatedChunkMap._appendChunk(changedChunks[changedChunkIndex++]);
+            continue;
+        }
+
+        const auto& block = _blocks[pos.block];
+        const auto* nextChangedChunk = changedChunkIndex < changedChunks.size()
+            ? changedChunks[changedChunkIndex].get()
+            : nullptr;
+
+        // Share the blocks which none of the changed chunks touch with this ChunkMap.
+        if (pos.chunk == 0 && updatedChunkMap._canAppendBlock(*block, nextChangedChunk)) {
+            updatedChunkMap._appendBlock(block);
+            pos = {pos.block + 1, 0};
             continue;
         }
 
-        if (changedChunkIndex >= changedChunks.size()) {
-            updatedChunkMap.appendChunk(_chunkMap[chunkMapIndex++]);
+        const auto& chunkInfo = block->chunks[pos.chunk];
+
+        if (!nextChangedChunk) {
+            updatedChunkMap._appendChunk(chunkInfo);
+            pos = _next(pos);
             continue;
         }
 
-        auto overlap = _chunkMap[chunkMapIndex]->getRange().overlaps(
-            changedChunks[changedChunkIndex]->getRange());
+        auto overlap = chunkInfo->getRange().overlaps(nextChangedChunk->getRange());
 
         if (overlap) {
             auto& changedChunk = changedChunks[changedChunkIndex++];
-            auto& chunkInfo = _chunkMap[chunkMapIndex];
 
             auto bytesInReplacedChunk = chunkInfo->getWritesTracker()->getBytesWritten();
             changedChunk->getWritesTracker()->addBytesWritten(bytesInReplacedChunk);
 
             validateChunk(changedChunk, getVersion());
-            updatedChunkMap.appendChunk(changedChunk);
+            updatedChunkMap._appendChunk(changedChunk);
         } else {
-            updatedChunkMap.appendChunk(_chunkMap[chunkMapIndex++]);
+            updatedChunkMap._appendChunk(chunkInfo);
+            pos = _next(pos);
+        }
+    }
+
+    for (auto& block : updatedChunkMap._blocks) {
+        if (!block->sealed) {
+            block->seal();
         }
     }
 
     return updatedChunkMap;
 }
 
+size_t ChunkMap::numBlocksSharedWith(const ChunkMap& other) const {
+    std::set<const Block*> otherBlocks;
+    for (const auto& block : other._blocks) {
+        otherBlocks.insert(block.get());
+    }
+
+    return std::count_if(_blocks.begin(), _blocks.end(), [&](const auto& block) {
+        return otherBlocks.count(block.get()) > 0;
+    });
+}
+
 BSONObj ChunkMap::toBSON() const {
     BSONObjBuilder builder;
 
     builder.append("startingVersion"_sd, getVersion().toBSON());
-    builder.append("chunkCount", static_cast<int64_t>(_chunkMap.size()));
+    builder.append("chunkCount", static_cast<int64_t>(_size));
 
     {
         BSONArrayBuilder arrayBuilder(builder.subarrayStart("chunks"_sd));
-        for (const auto& chunk : _chunkMap) {
-            arrayBuilder.append(chunk->toString());
+        for (const auto& block : _blocks) {
+            for (const auto& chunk : block->chunks) {
+                arrayBuilder.append(chunk->toString());
+            }
         }
     }
 
     return builder.obj();
 }
 
-ChunkMap::ChunkVector::const_iterator ChunkMap::_findIntersectingChunk(const BSONObj& shardKey,
-                                                                       bool isMaxInclusive) const {
+ChunkMap::Position ChunkMap::_findIntersectingChunk(const BSONObj& shardKey,
+                                                    bool isMaxInclusive) const {
     auto shardKeyString = ShardKeyPattern::toKeyString(shardKey);
 
-    if (!isMaxInclusive) {
-        return std::lower_bound(_chunkMap.begin(),
-                                _chunkMap.end(),
-                                shardKey,
-                                [&shardKeyString](const auto& chunkInfo, const BSONObj& shardKey) {
-                                    return chunkInfo->getMaxKeyString() < shardKeyString;
-                                });
-    } else {
-        return std::upper_bound(_chunkMap.begin(),
-                                _chunkMap.end(),
-                                shardKey,
-                                [&shardKeyString](const BSONObj& shardKey, const auto& chunkInfo) {
-                                    return shardKeyString < chunkInfo->getMaxKeyString();
-                                });
+    // Finds the first max key which is greater than the shard key, or greater or equal if the max
+    // is not inclusive.
+    auto findInMaxKeyStrings = [&](const std::vector<std::string>& maxKeyStrings) {
+        return isMaxInclusive
+            ? std::upper_bound(maxKeyStrings.begin(), maxKeyStrings.end(), shardKeyString)
+            : std::lower_bound(maxKeyStrings.begin(), maxKeyStrings.end(), shardKeyString);
+    };
+
+    auto blockIt = findInMaxKeyStrings(_blockMaxKeyStrings);
+    if (blockIt == _blockMaxKeyStrings.end()) {
+        return _end();
     }
+
+    const size_t blockIndex = blockIt - _blockMaxKeyStrings.begin();
+    const auto& maxKeyStrings = _blocks[blockIndex]->maxKeyStrings;
+    return {blockIndex, size_t(findInMaxKeyStrings(maxKeyStrings) - maxKeyStrings.begin())};
 }
 
-std::pair<ChunkMap::ChunkVector::const_iterator, ChunkMap::ChunkVector::const_iterator>
-ChunkMap::_overlappingBounds(const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const {
+std::pair<ChunkMap::Position, ChunkMap::Position> ChunkMap::_overlappingBounds(
+    const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const {
     const auto itMin = _findIntersectingChunk(min);
     const auto itMax = [&]() {
         auto it = _findIntersectingChunk(max, isMaxInclusive);
-        return it == _chunkMap.end() ? it : ++it;
+        return it < _end() ? _next(it) : it;
     }();
 
     return {itMin, itMax};
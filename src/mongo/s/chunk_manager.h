@@ -31,6 +31,7 @@
 
 #include <set>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "mongo/db/namespace_string.h"
@@ -69,18 +70,57 @@ using ShardVersionMap = stdx::unordered_map<ShardId, ShardVersionTargetingInfo,
  * This class serves as a Facade around how the mapping of ranges to chunks is represented. It also
  * provides a simpler, high-level interface for domain specific operations without exposing the
  * underlying implementation.
+ *
+ * The chunks are ordered by max key and stored in blocks of up to kMaxChunksPerBlock consecutive
+ * chunks. Blocks are immutable once the ChunkMap which built them is complete, so the ChunkMaps
+ * produced by successive refreshes share every block which has no changed chunks, and a refresh
+ * only copies the blocks which do. Lookups binary search the max key KeyStrings of the blocks and
+ * then of the chunks within one block, both of which are kept in contiguous arrays.
  */
 class ChunkMap {
-    // Vector of chunks ordered by max key.
     using ChunkVector = std::vector<std::shared_ptr<ChunkInfo>>;
 
+    struct Block {
+        /**
+         * Computes the summary fields below from the chunks. Called once the block is complete,
+         * after which it is never modified.
+         */
+        void seal();
+
+        // Chunks ordered by max key, and the KeyString of the max key of each chunk.
+        ChunkVector chunks;
+        std::vector<std::string> maxKeyStrings;
+
+        bool sealed{false};
+
+        // Max version across the chunks in the block, and for each shard owning any of them.
+        ChunkVersion maxVersion;
+        stdx::unordered_map<ShardId, ChunkVersion, ShardId::Hasher> shardVersions;
+
+        // Index of the first chunk whose min is not the max of the chunk before it, if any.
+        boost::optional<size_t> discontinuity;
+    };
+
+    // Position of a chunk as the index of its block and its index within that block.
+    struct Position {
+        bool operator<(const Position& other) const {
+            return std::tie(block, chunk) < std::tie(other.block, other.chunk);
+        }
+
+        size_t block{0};
+        size_t chunk{0};
+    };
+
 public:
+    static constexpr size_t kMaxChunksPerBlock = 256;
+
     explicit ChunkMap(OID epoch, size_t initialCapacity = 0) : _collectionVersion(0, 0, epoch) {
-        _chunkMap.reserve(initialCapacity);
+        _blocks.reserve(initialCapacity / kMaxChunksPerBlock + 1);
+        _blockMaxKeyStrings.reserve(initialCapacity / kMaxChunksPerBlock + 1);
     }
 
     size_t size() const {
-        return _chunkMap.size();
+        return _size;
     }
 
     ChunkVersion getVersion() const {
@@ -89,12 +129,8 @@ public:
 
     template <typename Callable>
     void forEach(Callable&& handler, const BSONObj& shardKey = BSONObj()) const {
-        auto it = shardKey.isEmpty() ? _chunkMap.begin() : _findIntersectingChunk(shardKey);
-
-        for (; it != _chunkMap.end(); ++it) {
-            if (!handler(*it))
-                break;
-        }
+        const auto first = shardKey.isEmpty() ? Position{} : _findIntersectingChunk(shardKey);
+        _forEachBetween(first, _end(), handler);
     }
 
     template <typename Callable>
@@ -103,29 +139,74 @@ public:
                                  bool isMaxInclusive,
                                  Callable&& handler) const {
         const auto bounds = _overlappingBounds(min, max, isMaxInclusive);
-
-        for (auto it = bounds.first; it != bounds.second; ++it) {
-            if (!handler(*it))
-                break;
-        }
+        _forEachBetween(bounds.first, bounds.second, handler);
     }
 
     ShardVersionMap constructShardVersionMap() const;
     std::shared_ptr<ChunkInfo> findIntersectingChunk(const BSONObj& shardKey) const;
 
-    void appendChunk(const std::shared_ptr<ChunkInfo>& chunk);
-
     ChunkMap createMerged(const std::vector<std::shared_ptr<ChunkInfo>>& changedChunks) const;
 
+    /**
+     * Returns the number of blocks the chunks are stored in.
+     */
+    size_t numBlocks() const {
+        return _blocks.size();
+    }
+
+    /**
+     * Returns the number of blocks which this ChunkMap shares with 'other'.
+     */
+    size_t numBlocksSharedWith(const ChunkMap& other) const;
+
     BSONObj toBSON() const;
 
 private:
-    ChunkVector::const_iterator _findIntersectingChunk(const BSONObj& shardKey,
-                                                       bool isMaxInclusive = true) const;
-    std::pair<ChunkVector::const_iterator, ChunkVector::const_iterator> _overlappingBounds(
-        const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const;
+    template <typename Callable>
+    void _forEachBetween(Position first, Position last, Callable& handler) const {
+        for (auto pos = first; pos < last; pos = _next(pos)) {
+            if (!handler(_blocks[pos.block]->chunks[pos.chunk]))
+                break;
+        }
+    }
+
+    Position _end() const {
+        return {_blocks.size(), 0};
+    }
+
+    Position _next(Position pos) const {
+        if (++pos.chunk == _blocks[pos.block]->chunks.size()) {
+            return {pos.block + 1, 0};
+        }
+        return pos;
+    }
+
+    Position _findIntersectingChunk(const BSONObj& shardKey, bool isMaxInclusive = true) const;
+    std::pair<Position, Position> _overlappingBounds(const BSONObj& min,
+                                                     const BSONObj& max,
+                                                     bool isMaxInclusive) const;
+
+    /**
+     * Appends 'chunk' after the last chunk, or replaces the last chunk with it if they overlap and
+     * 'chunk' is newer.
+     */
+    void _appendChunk(const std::shared_ptr<ChunkInfo>& chunk);
+
+    /**
+     * Returns whether the sealed 'block' of another ChunkMap can be appended as-is, given the next
+     * changed chunk to merge after it, if any.
+     */
+    bool _canAppendBlock(const Block& block, const ChunkInfo* nextChangedChunk) const;
+    void _appendBlock(const std::shared_ptr<Block>& block);
+
+    Block& _mutableLastBlock();
+
+    std::vector<std::shared_ptr<Block>> _blocks;
+
+    // The max key KeyString of the last chunk of each block.
+    std::vector<std::string> _blockMaxKeyStrings;
 
-    ChunkVector _chunkMap;
+    size_t _size{0};
 
     // Max version across all chunks
     ChunkVersion _collectionVersion;
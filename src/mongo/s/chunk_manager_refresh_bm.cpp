@@ -139,7 +139,45 @@ void BM_IncrementalRefreshOfPessimalBalancedDistribution(benchmark::State& state
 BENCHMARK(BM_IncrementalRefreshOfPessimalBalancedDistribution)
     ->Args({2, 50000})
     ->Args({2, 250000})
-    ->Args({2, 500000});
+    ->Args({2, 500000})
+    ->Args({2, 1000000});
+
+// Refreshes after 'state.range(2)' chunk moves spread evenly across the key space, each of which
+// changes the chunk that moved and one other chunk on the donor shard.
+void BM_IncrementalRefreshWithManyChangedChunks(benchmark::State& state) {
+    const int nShards = state.range(0);
+    const int nChunks = state.range(1);
+    const int nMoves = state.range(2);
+    auto metadata = makeChunkManagerWithOptimalBalancedDistribution(nShards, nChunks);
+
+    auto postMoveVersion = metadata.getChunkManager()->getVersion();
+    std::vector<ChunkType> newChunks;
+    for (int i = 0; i < nMoves; ++i) {
+        const int movedChunk = 1 + int64_t(i) * (nChunks - 2) / nMoves;
+        postMoveVersion.incMajor();
+        newChunks.emplace_back(kNss,
+                               getRangeForChunk(movedChunk, nChunks),
+                               postMoveVersion,
+                               ShardId(str::stream() << "shard" << ((i + 1) % nShards)));
+        postMoveVersion.incMinor();
+        newChunks.emplace_back(kNss,
+                               getRangeForChunk(movedChunk + 1, nChunks),
+                               postMoveVersion,
+                               optimalShardSelector(movedChunk + 1, nShards, nChunks));
+    }
+
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(runIncrementalUpdate(metadata, newChunks));
+    }
+
+    state.counters["changedChunks"] = newChunks.size();
+}
+
+BENCHMARK(BM_IncrementalRefreshWithManyChangedChunks)
+    ->Args({2, 1000000, 1})
+    ->Args({2, 1000000, 100})
+    ->Args({100, 1000000, 100})
+    ->Args({2, 1000000, 10000});
 
 template <typename ShardSelectorFn>
 auto BM_FullBuildOfChunkManager(benchmark::State& state, ShardSelectorFn selectShard) {
@@ -393,6 +431,8 @@ MONGO_INITIALIZER(RegisterBenchmarks)(InitializerContext* context) {
             ->Args({10, 50000})
             ->Args({100, 50000})
             ->Args({1000, 50000})
+            ->Args({2, 1000000})
+            ->Args({1000, 1000000})
             ->Args({2, 2});
     }
 
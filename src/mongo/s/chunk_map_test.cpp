@@ -45,6 +45,26 @@ public:
         return _shardKeyPattern;
     }
 
+    /**
+     * Makes 'numChunks' chunks covering the whole shard key space, alternating between two shards.
+     * Chunk 'i' has bounds [(i - 1) * 100, i * 100), except for the first and last chunks, which
+     * extend to MinKey and MaxKey respectively.
+     */
+    std::vector<std::shared_ptr<ChunkInfo>> makeChunks(int numChunks, const OID& epoch) const {
+        std::vector<std::shared_ptr<ChunkInfo>> chunks;
+        for (int i = 0; i < numChunks; ++i) {
+            auto min = i == 0 ? getShardKeyPattern().globalMin() : BSON("a" << (i - 1) * 100);
+            auto max =
+                i == numChunks - 1 ? getShardKeyPattern().globalMax() : BSON("a" << i * 100);
+            chunks.push_back(std::make_shared<ChunkInfo>(
+                ChunkType{kNss,
+                          ChunkRange{min, max},
+                          ChunkVersion{uint32_t(i + 1), 0, epoch},
+                          ShardId(str::stream() << "shard" << (i % 2))}));
+        }
+        return chunks;
+    }
+
 private:
     KeyPattern _shardKeyPattern{BSON("a" << 1)};
 };
@@ -165,4 +185,131 @@ TEST_F(ChunkMapTest, TestEnumerateOverlappingChunks) {
     ASSERT_EQ(count, 3);
 }
 
-}  // namespace mongo
\ No newline at end of file
+TEST_F(ChunkMapTest, TestManyChunksSpanSeveralBlocks) {
+    const OID epoch = OID::gen();
+    const int numChunks = 3 * ChunkMap::kMaxChunksPerBlock + 10;
+    auto chunkMap = ChunkMap{epoch}.createMerged(makeChunks(numChunks, epoch));
+
+    ASSERT_EQ(chunkMap.size(), numChunks);
+    ASSERT_EQ(chunkMap.numBlocks(), 4);
+    ASSERT_EQ(chunkMap.getVersion(), (ChunkVersion{uint32_t(numChunks), 0, epoch}));
+
+    int count = 0;
+    auto lastMax = getShardKeyPattern().globalMin();
+    chunkMap.forEach([&](const auto& chunkInfo) {
+        ASSERT_BSONOBJ_EQ(chunkInfo->getMin(), lastMax);
+        lastMax = chunkInfo->getMax();
+        count++;
+        return true;
+    });
+    ASSERT_EQ(count, numChunks);
+
+    // Every chunk, including the ones at either end of a block, is found by its own bounds.
+    for (int i = 1; i < numChunks - 1; ++i) {
+        auto chunk = chunkMap.findIntersectingChunk(BSON("a" << (i - 1) * 100));
+        ASSERT(chunk);
+        ASSERT_BSONOBJ_EQ(chunk->getMin(), BSON("a" << (i - 1) * 100));
+
+        chunk = chunkMap.findIntersectingChunk(BSON("a" << i * 100 - 1));
+        ASSERT(chunk);
+        ASSERT_BSONOBJ_EQ(chunk->getMax(), BSON("a" << i * 100));
+    }
+
+    // Overlapping chunks are enumerated across block boundaries.
+    const int boundary = ChunkMap::kMaxChunksPerBlock;
+    count = 0;
+    chunkMap.forEachOverlappingChunk(BSON("a" << (boundary - 3) * 100),
+                                     BSON("a" << (boundary + 2) * 100),
+                                     false,
+                                     [&](const auto& chunk) {
+                                         count++;
+                                         return true;
+                                     });
+    ASSERT_EQ(count, 5);
+
+    auto shardVersions = chunkMap.constructShardVersionMap();
+    ASSERT_EQ(shardVersions.size(), 2);
+    ASSERT_EQ(shardVersions.at(ShardId("shard1")).shardVersion,
+              (ChunkVersion{uint32_t(numChunks), 0, epoch}));
+    ASSERT_EQ(shardVersions.at(ShardId("shard0")).shardVersion,
+              (ChunkVersion{uint32_t(numChunks - 1), 0, epoch}));
+}
+
+TEST_F(ChunkMapTest, TestIncrementalUpdateSharesUnchangedBlocks) {
+    const OID epoch = OID::gen();
+    const int numChunks = 4 * ChunkMap::kMaxChunksPerBlock;
+    auto chunkMap = ChunkMap{epoch}.createMerged(makeChunks(numChunks, epoch));
+    ASSERT_EQ(chunkMap.numBlocks(), 4);
+
+    // Split a chunk in the second block.
+    const int splitChunk = ChunkMap::kMaxChunksPerBlock + 10;
+    const auto min = BSON("a" << (splitChunk - 1) * 100);
+    const auto mid = BSON("a" << (splitChunk - 1) * 100 + 50);
+    const auto max = BSON("a" << splitChunk * 100);
+    ChunkVersion version{uint32_t(numChunks + 1), 0, epoch};
+    auto updatedChunkMap = chunkMap.createMerged(
+        {std::make_shared<ChunkInfo>(ChunkType{kNss, ChunkRange{min, mid}, version, kThisShard}),
+         std::make_shared<ChunkInfo>(
+             ChunkType{kNss, ChunkRange{mid, max}, version, kThisShard})});
+
+    ASSERT_EQ(updatedChunkMap.size(), numChunks + 1);
+    ASSERT_EQ(updatedChunkMap.getVersion(), version);
+    ASSERT_EQ(updatedChunkMap.numBlocksSharedWith(chunkMap), 3);
+
+    auto chunk = updatedChunkMap.findIntersectingChunk(mid);
+    ASSERT_BSONOBJ_EQ(chunk->getMin(), mid);
+    ASSERT_BSONOBJ_EQ(chunk->getMax(), max);
+    ASSERT_EQ(chunk->getShardIdAt(boost::none), kThisShard);
+
+    auto shardVersions = updatedChunkMap.constructShardVersionMap();
+    ASSERT_EQ(shardVersions.size(), 3);
+    ASSERT_EQ(shardVersions.at(kThisShard).shardVersion, version);
+
+    // The original map is unaffected.
+    ASSERT_EQ(chunkMap.size(), numChunks);
+    ASSERT_BSONOBJ_EQ(chunkMap.findIntersectingChunk(mid)->getMin(), min);
+}
+
+TEST_F(ChunkMapTest, TestRepeatedUpdatesDoNotFragmentBlocks) {
+    const OID epoch = OID::gen();
+    const int numChunks = 4 * ChunkMap::kMaxChunksPerBlock;
+    auto chunkMap = ChunkMap{epoch}.createMerged(makeChunks(numChunks, epoch));
+
+    // Move every chunk of the second and third blocks, one refresh at a time.
+    auto version = chunkMap.getVersion();
+    for (int i = ChunkMap::kMaxChunksPerBlock; i < 3 * ChunkMap::kMaxChunksPerBlock; ++i) {
+        version.incMajor();
+        chunkMap = chunkMap.createMerged({std::make_shared<ChunkInfo>(
+            ChunkType{kNss,
+                      ChunkRange{BSON("a" << (i - 1) * 100), BSON("a" << i * 100)},
+                      version,
+                      kThisShard})});
+    }
+
+    ASSERT_EQ(chunkMap.size(), numChunks);
+    ASSERT_LTE(chunkMap.numBlocks(), 5);
+    chunkMap.constructShardVersionMap();
+}
+
+TEST_F(ChunkMapTest, TestGapBetweenBlocksIsDetected) {
+    const OID epoch = OID::gen();
+    const int numChunks = 2 * ChunkMap::kMaxChunksPerBlock;
+    auto chunks = makeChunks(numChunks, epoch);
+
+    // Drop the first chunk of the second block.
+    chunks.erase(chunks.begin() + ChunkMap::kMaxChunksPerBlock);
+    auto chunkMap = ChunkMap{epoch}.createMerged(chunks);
+    ASSERT_THROWS_CODE(chunkMap.constructShardVersionMap(),
+                       DBException,
+                       ErrorCodes::ConflictingOperationInProgress);
+
+    // Drop a chunk in the middle of a block.
+    chunks = makeChunks(numChunks, epoch);
+    chunks.erase(chunks.begin() + 10);
+    chunkMap = ChunkMap{epoch}.createMerged(chunks);
+    ASSERT_THROWS_CODE(chunkMap.constructShardVersionMap(),
+                       DBException,
+                       ErrorCodes::ConflictingOperationInProgress);
+}
+
+}  // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/base/status_with.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/cursor_id.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/executor/task_executor.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/s/query/async_results_merger_params_gen.h"
@@ -43,6 +44,7 @@
 #include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/time_support.h"
+#include "mongo/util/tournament_tree.h"
 
 namespace mongo {
 
@@ -89,7 +91,7 @@ public:
      *
      * Additionally copies each remote's first batch of results, if one exists, into that remote's
      * docBuffer. If a sort is specified in the ClusterClientCursorParams, places the remotes with
-     * buffered results onto _mergeQueue.
+     * buffered results into _mergeTree.
      *
      * The TaskExecutor* must remain valid for the lifetime of the ARM.
      *
@@ -308,6 +310,11 @@ private:
         // The buffer of results that have been retrieved but not yet returned to the caller.
         std::queue<ClusterQueryResult> docBuffer;
 
+        // For sorted merges, the KeyString encoding of the sort key of the front of 'docBuffer'.
+        // It is refreshed whenever the front changes, so that each sort key is encoded only once
+        // no matter how many comparisons it takes part in.
+        KeyString::HeapBuilder frontSortKey{KeyString::Version::kLatestVersion};
+
         // Is valid if there is currently a pending request to this remote.
         executor::TaskExecutor::CallbackHandle cbHandle;
 
@@ -320,14 +327,22 @@ private:
         long long fetchedCount = 0;
     };
 
+    /**
+     * Orders remotes by the sort key of their next buffered result. Returns true if the next
+     * result of 'lhs' sorts before that of 'rhs'.
+     */
     class MergingComparator {
     public:
         MergingComparator(const std::vector<RemoteCursorData>& remotes,
                           const BSONObj& sort,
-                          bool compareWholeSortKey)
-            : _remotes(remotes), _sort(sort), _compareWholeSortKey(compareWholeSortKey) {}
+                          bool compareWholeSortKey,
+                          bool compareKeyStrings)
+            : _remotes(remotes),
+              _sort(sort),
+              _compareWholeSortKey(compareWholeSortKey),
+              _compareKeyStrings(compareKeyStrings) {}
 
-        bool operator()(const size_t& lhs, const size_t& rhs);
+        bool operator()(size_t lhs, size_t rhs) const;
 
     private:
         const std::vector<RemoteCursorData>& _remotes;
@@ -338,6 +353,10 @@ private:
         // We extract the sort key {$sortKey: <value>}. The sort key pattern '_sort' is verified to
         // be {$sortKey: 1}.
         const bool _compareWholeSortKey;
+
+        // When true, the remotes' 'frontSortKey' encodings are compared instead of the BSON sort
+        // keys.
+        const bool _compareKeyStrings;
     };
 
     using MinSortKeyRemoteIdPair = std::pair<BSONObj, size_t>;
@@ -475,20 +494,33 @@ private:
      */
     void _setInitialHighWaterMark();
 
+    /**
+     * For sorted merges, re-encodes the sort key of the next buffered result of the given remote
+     * and replays its position in '_mergeTree'. Must be called whenever the front of the remote's
+     * buffer changes.
+     */
+    void _updateMergeTree(WithLock, size_t remoteIndex);
+
     OperationContext* _opCtx;
     std::shared_ptr<executor::TaskExecutor> _executor;
     TailableModeEnum _tailableMode;
     AsyncResultsMergerParams _params;
 
+    // The ordering used to encode sort keys as KeyStrings. Not set if there is no sort, or if the
+    // sort pattern has too many fields to be described by an Ordering, in which case the sort keys
+    // are compared as BSON.
+    const boost::optional<Ordering> _sortKeyOrdering;
+
     // Must be acquired before accessing any data members (other than _params, which is read-only).
     mutable Mutex _mutex = MONGO_MAKE_LATCH("AsyncResultsMerger::_mutex");
 
     // Data tracking the state of our communication with each of the remote nodes.
     std::vector<RemoteCursorData> _remotes;
 
-    // The top of this priority queue is the index into '_remotes' for the remote host that has the
-    // next document to return, according to the sort order. Used only if there is a sort.
-    std::priority_queue<size_t, std::vector<size_t>, MergingComparator> _mergeQueue;
+    // A tournament over the remotes which have buffered results. The top of this tree is the index
+    // into '_remotes' for the remote host that has the next document to return, according to the
+    // sort order. Used only if there is a sort.
+    TournamentTree<MergingComparator> _mergeTree;
 
     // The index into '_remotes' for the remote from which we are currently retrieving results.
     // Used only if there is *not* a sort.
@@ -441,6 +441,80 @@ TEST_F(AsyncResultsMergerTest, CompoundSortKey) {
     ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
 }
 
+TEST_F(AsyncResultsMergerTest, SortKeysOfMixedTypesMergeInCanonicalOrder) {
+    BSONObj findCmd = fromjson("{find: 'testcoll', sort: {a: 1}}");
+    auto doc = [](auto value) {
+        return BSON(AsyncResultsMerger::kSortKeyField << BSON_ARRAY(value));
+    };
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[0],
+        kTestShardHosts[0],
+        CursorResponse(kTestNss, CursorId(0), {doc(1), doc(2.5), doc("a")})));
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[1],
+                         kTestShardHosts[1],
+                         CursorResponse(kTestNss, CursorId(0), {doc(2LL), doc(3), doc("b")})));
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[2],
+        kTestShardHosts[2],
+        CursorResponse(kTestNss, CursorId(0), {doc(BSONNULL), doc(1.5), doc(BSON("x" << 1))})));
+    auto arm = makeARMFromExistingCursors(std::move(cursors), findCmd);
+
+    // Numbers of different types compare by value, and types compare in canonical order.
+    std::vector<BSONObj> expected = {doc(BSONNULL),
+                                     doc(1),
+                                     doc(1.5),
+                                     doc(2LL),
+                                     doc(2.5),
+                                     doc(3),
+                                     doc("a"),
+                                     doc("b"),
+                                     doc(BSON("x" << 1))};
+    for (const auto& expectedDoc : expected) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(expectedDoc, *unittest::assertGet(arm->nextReady()).getResult());
+    }
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, SortPatternWithMoreFieldsThanAnOrderingCanDescribe) {
+    // Sort keys of such patterns cannot be encoded as KeyStrings and are compared as BSON.
+    const int numFields = Ordering::kMaxCompoundIndexKeys + 1;
+    BSONObjBuilder sortBuilder;
+    for (int i = 0; i < numFields; ++i) {
+        sortBuilder.append(str::stream() << "f" << i, i == numFields - 1 ? -1 : 1);
+    }
+    BSONObj findCmd = BSON("find"
+                           << "testcoll"
+                           << "sort" << sortBuilder.obj());
+
+    // Sort keys which only differ in the last, descending, component.
+    auto doc = [&](int last) {
+        BSONArrayBuilder key;
+        for (int i = 0; i < numFields - 1; ++i) {
+            key.append(0);
+        }
+        key.append(last);
+        return BSON(AsyncResultsMerger::kSortKeyField << key.arr());
+    };
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(makeRemoteCursor(kTestShardIds[0],
+                                       kTestShardHosts[0],
+                                       CursorResponse(kTestNss, CursorId(0), {doc(5), doc(1)})));
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[1], kTestShardHosts[1], CursorResponse(kTestNss, CursorId(0), {doc(3)})));
+    auto arm = makeARMFromExistingCursors(std::move(cursors), findCmd);
+
+    for (int last : {5, 3, 1}) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(doc(last), *unittest::assertGet(arm->nextReady()).getResult());
+    }
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
 TEST_F(AsyncResultsMergerTest, SortedButNoSortKey) {
     BSONObj findCmd = fromjson("{find: 'testcoll', sort: {a: -1, b: 1}}");
     std::vector<RemoteCursor> cursors;
@@ -194,6 +194,10 @@ Status initializeGlobalShardingState(OperationContext* opCtx,
     connPoolOptions.controllerFactory = []() noexcept {
         return std::make_shared<ShardingTaskExecutorPoolController>();
     };
+    connPoolOptions.maxRequestsPerConnection =
+        ShardingTaskExecutorPoolController::gParameters.maxRequestsPerConnection.load();
+    connPoolOptions.pipelineStallTimeout = Milliseconds(
+        ShardingTaskExecutorPoolController::gParameters.pipelineStallTimeoutMS.load());
 
     auto network = executor::makeNetworkInterface(
         "ShardRegistry", std::make_unique<ShardingNetworkConnectionHook>(), hookBuilder());
@@ -0,0 +1,647 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/io_uring_linux.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+#include "mongo/transport/asio_utils.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/str.h"
+
+// IORING_FEAT_FAST_POLL first appeared in the kernel headers of Linux 5.7, which have every opcode
+// the service issues.
+#if defined(IORING_FEAT_FAST_POLL) && defined(__NR_io_uring_setup)
+#define MONGO_TRANSPORT_HAVE_IO_URING
+#endif
+
+namespace mongo {
+namespace transport {
+namespace {
+
+// The user data of cancelation requests, whose completions carry nothing of interest.
+constexpr uint64_t kCancelUserData = 0;
+
+std::error_code resultToErrorCode(int result) {
+    if (result == 0) {
+        return asio::error::make_error_code(asio::error::eof);
+    }
+    return std::error_code(-result, std::system_category());
+}
+
+}  // namespace
+
+/**
+ * The submission and completion queues of an io_uring instance, driven through the raw system
+ * calls. Submissions must be serialized by the caller, as must reaping completions.
+ */
+class IOUringService::Ring {
+public:
+#ifdef MONGO_TRANSPORT_HAVE_IO_URING
+    static StatusWith<std::unique_ptr<Ring>> make(unsigned entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = syscall(__NR_io_uring_setup, entries, &params);
+        if (fd < 0) {
+            return Status(ErrorCodes::OperationFailed,
+                          str::stream() << "io_uring_setup failed: " << errnoWithDescription());
+        }
+        auto ring = std::unique_ptr<Ring>(new Ring(fd));
+
+        if (!(params.features & IORING_FEAT_NODROP)) {
+            return Status(ErrorCodes::OperationFailed,
+                          "The kernel may drop io_uring completions under load");
+        }
+
+        std::vector<char> probeBuffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+        auto probe = reinterpret_cast<io_uring_probe*>(probeBuffer.data());
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+            return Status(ErrorCodes::OperationFailed,
+                          str::stream() << "Cannot probe io_uring operations: "
+                                        << errnoWithDescription());
+        }
+        for (int op : {IORING_OP_ACCEPT,
+                       IORING_OP_RECV,
+                       IORING_OP_SEND,
+                       IORING_OP_POLL_ADD,
+                       IORING_OP_ASYNC_CANCEL}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                return Status(ErrorCodes::OperationFailed,
+                              str::stream()
+                                  << "The kernel does not support io_uring opcode " << op);
+            }
+        }
+
+        if (auto status = ring->_map(params); !status.isOK()) {
+            return status;
+        }
+        return {std::move(ring)};
+    }
+
+    ~Ring() {
+        if (_sqes) {
+            munmap(_sqes, _sqesSize);
+        }
+        if (_cqRing && _cqRing != _sqRing) {
+            munmap(_cqRing, _cqRingSize);
+        }
+        if (_sqRing) {
+            munmap(_sqRing, _sqRingSize);
+        }
+        close(_fd);
+    }
+
+    int fd() const {
+        return _fd;
+    }
+
+    int queueAccept(int fd, uint64_t userData) {
+        return _queue([&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->fd = fd;
+            sqe->accept_flags = SOCK_CLOEXEC;
+            sqe->user_data = userData;
+        });
+    }
+
+    int queueRecv(int fd, void* data, size_t size, uint64_t userData) {
+        return _queue([&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(data);
+            sqe->len = size;
+            sqe->user_data = userData;
+        });
+    }
+
+    int queueSend(int fd, const void* data, size_t size, uint64_t userData) {
+        return _queue([&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(data);
+            sqe->len = size;
+            sqe->msg_flags = MSG_NOSIGNAL;
+            sqe->user_data = userData;
+        });
+    }
+
+    int queuePoll(int fd, short events, uint64_t userData) {
+        return _queue([&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = fd;
+            sqe->poll_events = events;
+            sqe->user_data = userData;
+        });
+    }
+
+    int queueCancel(uint64_t targetUserData) {
+        return _queue([&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = targetUserData;
+            sqe->user_data = kCancelUserData;
+        });
+    }
+
+    /**
+     * Submits all queued entries with a single system call. Returns the number of entries the
+     * kernel took, or -errno. Entries the kernel did not take stay queued.
+     */
+    int submitQueued() {
+        if (!hasQueued()) {
+            return 0;
+        }
+        return _enter(_queued(), 0, 0);
+    }
+
+    bool hasQueued() const {
+        return _queued() != 0;
+    }
+
+    bool hasCompletions() const {
+        return *_cqHead != __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    }
+
+    /**
+     * Calls 'onCompletion' with the user data and result of every completion available, including
+     * those the kernel had to hold back because the completion queue was full.
+     */
+    template <typename OnCompletion>
+    void reap(OnCompletion&& onCompletion) {
+        while (true) {
+            auto head = *_cqHead;
+            const auto tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const auto& cqe = _cqes[head & *_cqMask];
+                onCompletion(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+
+            if (!(__atomic_load_n(_sqFlags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW)) {
+                return;
+            }
+            _enter(0, 0, IORING_ENTER_GETEVENTS);
+        }
+    }
+
+    /**
+     * Submits the queued entries and blocks until at least one completion is available.
+     */
+    void waitForCompletions() {
+        _enter(_queued(), 1, IORING_ENTER_GETEVENTS);
+    }
+
+private:
+    explicit Ring(int fd) : _fd(fd) {}
+
+    Status _map(const io_uring_params& params) {
+        _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+        }
+
+        auto map = [&](size_t size, off_t offset) -> char* {
+            auto ptr = mmap(nullptr,
+                            size,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE,
+                            _fd,
+                            offset);
+            return ptr == MAP_FAILED ? nullptr : static_cast<char*>(ptr);
+        };
+
+        _sqRing = map(_sqRingSize, IORING_OFF_SQ_RING);
+        _cqRing = (params.features & IORING_FEAT_SINGLE_MMAP)
+            ? _sqRing
+            : map(_cqRingSize, IORING_OFF_CQ_RING);
+        _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = reinterpret_cast<io_uring_sqe*>(map(_sqesSize, IORING_OFF_SQES));
+        if (!_sqRing || !_cqRing || !_sqes) {
+            return Status(ErrorCodes::OperationFailed,
+                          str::stream()
+                              << "Cannot map the io_uring queues: " << errnoWithDescription());
+        }
+
+        _sqHead = reinterpret_cast<unsigned*>(_sqRing + params.sq_off.head);
+        _sqTail = reinterpret_cast<unsigned*>(_sqRing + params.sq_off.tail);
+        _sqMask = reinterpret_cast<unsigned*>(_sqRing + params.sq_off.ring_mask);
+        _sqEntries = reinterpret_cast<unsigned*>(_sqRing + params.sq_off.ring_entries);
+        _sqFlags = reinterpret_cast<unsigned*>(_sqRing + params.sq_off.flags);
+        _sqArray = reinterpret_cast<unsigned*>(_sqRing + params.sq_off.array);
+        _cqHead = reinterpret_cast<unsigned*>(_cqRing + params.cq_off.head);
+        _cqTail = reinterpret_cast<unsigned*>(_cqRing + params.cq_off.tail);
+        _cqMask = reinterpret_cast<unsigned*>(_cqRing + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe*>(_cqRing + params.cq_off.cqes);
+        return Status::OK();
+    }
+
+    /**
+     * Queues the entry filled in by 'fill', without submitting it. Returns 0, or -EAGAIN if the
+     * submission queue is full even after submitting the entries already in it.
+     */
+    template <typename Fill>
+    int _queue(Fill&& fill) {
+        if (_queued() == *_sqEntries) {
+            submitQueued();
+            if (_queued() == *_sqEntries) {
+                return -EAGAIN;
+            }
+        }
+
+        const auto tail = *_sqTail;
+        const auto index = tail & *_sqMask;
+        auto sqe = &_sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        fill(sqe);
+        _sqArray[index] = index;
+        __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+        return 0;
+    }
+
+    /**
+     * The number of entries queued which the kernel has not consumed yet.
+     */
+    unsigned _queued() const {
+        return *_sqTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+    }
+
+    int _enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        while (true) {
+            auto result =
+                syscall(__NR_io_uring_enter, _fd, toSubmit, minComplete, flags, nullptr, 0);
+            if (result >= 0) {
+                return result;
+            }
+            if (errno != EINTR) {
+                return -errno;
+            }
+        }
+    }
+
+    const int _fd;
+
+    char* _sqRing = nullptr;
+    size_t _sqRingSize = 0;
+    char* _cqRing = nullptr;
+    size_t _cqRingSize = 0;
+    io_uring_sqe* _sqes = nullptr;
+    size_t _sqesSize = 0;
+
+    unsigned* _sqHead = nullptr;
+    unsigned* _sqTail = nullptr;
+    unsigned* _sqMask = nullptr;
+    unsigned* _sqEntries = nullptr;
+    unsigned* _sqFlags = nullptr;
+    unsigned* _sqArray = nullptr;
+    unsigned* _cqHead = nullptr;
+    unsigned* _cqTail = nullptr;
+    unsigned* _cqMask = nullptr;
+    io_uring_cqe* _cqes = nullptr;
+#else
+    static StatusWith<std::unique_ptr<Ring>> make(unsigned) {
+        return Status(ErrorCodes::OperationFailed, "This build does not support io_uring");
+    }
+
+    int fd() const {
+        MONGO_UNREACHABLE;
+    }
+
+    int queueAccept(int, uint64_t) {
+        MONGO_UNREACHABLE;
+    }
+
+    int queueRecv(int, void*, size_t, uint64_t) {
+        MONGO_UNREACHABLE;
+    }
+
+    int queueSend(int, const void*, size_t, uint64_t) {
+        MONGO_UNREACHABLE;
+    }
+
+    int queuePoll(int, short, uint64_t) {
+        MONGO_UNREACHABLE;
+    }
+
+    int queueCancel(uint64_t) {
+        MONGO_UNREACHABLE;
+    }
+
+    int submitQueued() {
+        MONGO_UNREACHABLE;
+    }
+
+    bool hasQueued() const {
+        MONGO_UNREACHABLE;
+    }
+
+    bool hasCompletions() const {
+        MONGO_UNREACHABLE;
+    }
+
+    template <typename OnCompletion>
+    void reap(OnCompletion&&) {
+        MONGO_UNREACHABLE;
+    }
+
+    void waitForCompletions() {
+        MONGO_UNREACHABLE;
+    }
+#endif
+};
+
+struct IOUringService::Op {
+    enum class Type { kAccept, kRecv, kSend };
+
+    Type type;
+    int fd;
+    void* data;
+    size_t size;
+    Completion completion;
+
+    // Whether the kernel is waiting for the socket to be ready, after the operation itself
+    // completed with EAGAIN.
+    bool awaitingReadiness = false;
+    bool canceled = false;
+
+    uint64_t userData() {
+        return reinterpret_cast<uint64_t>(this);
+    }
+
+    int queue(Ring& ring) {
+        if (awaitingReadiness) {
+            return ring.queuePoll(fd, type == Type::kSend ? POLLOUT : POLLIN, userData());
+        }
+        switch (type) {
+            case Type::kAccept:
+                return ring.queueAccept(fd, userData());
+            case Type::kRecv:
+                return ring.queueRecv(fd, data, size, userData());
+            case Type::kSend:
+                return ring.queueSend(fd, data, size, userData());
+        }
+        MONGO_UNREACHABLE;
+    }
+};
+
+asio::execution_context::id IOUringService::id;
+
+Status IOUringService::probe() {
+    return Ring::make(1).getStatus();
+}
+
+Status IOUringService::install(asio::io_context& ctx) {
+    try {
+        asio::make_service<IOUringService>(ctx);
+    } catch (const DBException& ex) {
+        return ex.toStatus();
+    } catch (const std::exception& ex) {
+        return Status(ErrorCodes::OperationFailed,
+                      str::stream() << "Cannot install the io_uring service: " << ex.what());
+    }
+    return Status::OK();
+}
+
+IOUringService* IOUringService::get(asio::io_context& ctx) {
+    if (!asio::has_service<IOUringService>(ctx)) {
+        return nullptr;
+    }
+    return &asio::use_service<IOUringService>(ctx);
+}
+
+IOUringService::IOUringService(asio::execution_context& ctx)
+    : asio::execution_context::service(ctx),
+      _ring(uassertStatusOK(Ring::make(kRingEntries))),
+      _ringDescriptor(static_cast<asio::io_context&>(ctx), ::dup(_ring->fd())) {
+    _armWait();
+}
+
+IOUringService::~IOUringService() = default;
+
+void IOUringService::accept(int fd, Completion completion) {
+    _submit(std::unique_ptr<Op>(new Op{Op::Type::kAccept, fd, nullptr, 0, std::move(completion)}));
+}
+
+void IOUringService::recv(int fd, void* data, size_t size, Completion completion) {
+    _submit(std::unique_ptr<Op>(new Op{Op::Type::kRecv, fd, data, size, std::move(completion)}));
+}
+
+void IOUringService::send(int fd, const void* data, size_t size, Completion completion) {
+    _submit(std::unique_ptr<Op>(
+        new Op{Op::Type::kSend, fd, const_cast<void*>(data), size, std::move(completion)}));
+}
+
+Future<size_t> IOUringService::recvSome(int fd, asio::mutable_buffer buffer) {
+    auto pf = makePromiseFuture<size_t>();
+    recv(fd, buffer.data(), buffer.size(), [promise = std::move(pf.promise)](int result) mutable {
+        if (result <= 0) {
+            promise.setError(errorCodeToStatus(resultToErrorCode(result)));
+        } else {
+            promise.emplaceValue(result);
+        }
+    });
+    return std::move(pf.future);
+}
+
+Future<size_t> IOUringService::sendSome(int fd, asio::const_buffer buffer) {
+    auto pf = makePromiseFuture<size_t>();
+    send(fd, buffer.data(), buffer.size(), [promise = std::move(pf.promise)](int result) mutable {
+        if (result < 0) {
+            promise.setError(errorCodeToStatus(resultToErrorCode(result)));
+        } else {
+            promise.emplaceValue(result);
+        }
+    });
+    return std::move(pf.future);
+}
+
+Future<void> IOUringService::recvAll(int fd, asio::mutable_buffer buffer) {
+    if (buffer.size() == 0) {
+        return Future<void>::makeReady();
+    }
+    return recvSome(fd, buffer).then(
+        [this, fd, buffer](size_t size) { return recvAll(fd, buffer + size); });
+}
+
+Future<void> IOUringService::sendAll(int fd, asio::const_buffer buffer) {
+    if (buffer.size() == 0) {
+        return Future<void>::makeReady();
+    }
+    return sendSome(fd, buffer).then(
+        [this, fd, buffer](size_t size) { return sendAll(fd, buffer + size); });
+}
+
+void IOUringService::cancel(int fd) {
+    stdx::lock_guard lk(_mutex);
+    for (auto op : _inProgress) {
+        if (op->fd == fd && !op->canceled) {
+            op->canceled = true;
+            _ring->queueCancel(op->userData());
+        }
+    }
+    if (_ring->hasQueued()) {
+        _scheduleSubmission(lk);
+    }
+}
+
+void IOUringService::shutdown() {
+    // Destroying the completion of an operation may run continuations which start or cancel
+    // operations of this service, so the operations are only destroyed once the mutex is released.
+    std::vector<std::unique_ptr<Op>> completed;
+    {
+        stdx::lock_guard lk(_mutex);
+        _inShutdown = true;
+        for (auto op : _inProgress) {
+            op->canceled = true;
+            _ring->queueCancel(op->userData());
+        }
+        _ring->submitQueued();
+
+        // The kernel may still write into the buffers of the operations until they complete.
+        while (!_inProgress.empty()) {
+            _ring->reap([&](uint64_t userData, int) {
+                if (userData == kCancelUserData) {
+                    return;
+                }
+                auto op = reinterpret_cast<Op*>(userData);
+                _inProgress.erase(op);
+                completed.emplace_back(op);
+            });
+            if (!_inProgress.empty()) {
+                _ring->waitForCompletions();
+            }
+        }
+    }
+}
+
+void IOUringService::_submit(std::unique_ptr<Op> op) {
+    int result;
+    {
+        stdx::lock_guard lk(_mutex);
+        result = _inShutdown ? -ECANCELED : op->queue(*_ring);
+        if (result == 0) {
+            _inProgress.insert(op.release());
+            _scheduleSubmission(lk);
+            return;
+        }
+    }
+
+    // Like asio, never complete an operation on the thread which started it.
+    asio::post(_ringDescriptor.get_executor(),
+               [op = std::move(op), result] { op->completion(result); });
+}
+
+void IOUringService::_scheduleSubmission(WithLock) {
+    if (_submissionScheduled) {
+        return;
+    }
+
+    // Submit once the handlers which are ready have run, along with any operations they start.
+    _submissionScheduled = true;
+    asio::post(_ringDescriptor.get_executor(), [this] {
+        stdx::lock_guard lk(_mutex);
+        _submissionScheduled = false;
+        _ring->submitQueued();
+    });
+}
+
+void IOUringService::_armWait() {
+    _ringDescriptor.async_wait(asio::posix::stream_descriptor::wait_read,
+                               [this](const std::error_code& ec) {
+                                   if (ec) {
+                                       return;
+                                   }
+                                   _reap();
+                                   _armWait();
+                               });
+
+    // Completions which arrived since the last reap may not wake up the wait above.
+    if (_ring->hasCompletions()) {
+        asio::post(_ringDescriptor.get_executor(), [this] { _reap(); });
+    }
+}
+
+void IOUringService::_reap() {
+    std::vector<std::pair<std::unique_ptr<Op>, int>> completed;
+    {
+        stdx::lock_guard lk(_mutex);
+        _ring->reap([&](uint64_t userData, int result) {
+            if (userData == kCancelUserData) {
+                return;
+            }
+
+            auto op = reinterpret_cast<Op*>(userData);
+            if (op->canceled || _inShutdown) {
+                if (op->awaitingReadiness || result == -EAGAIN) {
+                    result = -ECANCELED;
+                }
+            } else if (op->awaitingReadiness || result == -EAGAIN) {
+                // Either the socket just became ready, or the operation has to wait for it to be.
+                op->awaitingReadiness = !op->awaitingReadiness;
+                if (op->awaitingReadiness || result >= 0) {
+                    result = op->queue(*_ring);
+                    if (result == 0) {
+                        return;
+                    }
+                }
+            }
+
+            _inProgress.erase(op);
+            completed.emplace_back(op, result);
+        });
+
+        // This also retries the entries which a previous submission left queued, for instance
+        // because the completion queue was full.
+        if (_ring->hasQueued()) {
+            _scheduleSubmission(lk);
+        }
+    }
+
+    for (auto& [op, result] : completed) {
+        op->completion(result);
+    }
+}
+
+}  // namespace transport
+}  // namespace mongo
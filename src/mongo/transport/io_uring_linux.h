@@ -0,0 +1,156 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "mongo/base/status.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/unordered_set.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/functional.h"
+#include "mongo/util/future.h"
+
+#include "asio.hpp"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * Issues socket accepts, receives and sends through an io_uring instance. It is installed as a
+ * service of the io_context of a reactor which runs on the io_uring backend, and is what the
+ * sessions and acceptors of that reactor use in place of the asio asynchronous operations.
+ *
+ * Completions are reaped on the thread running the io_context, which waits for the ring's file
+ * descriptor to become readable along with the other descriptors of the reactor. Callers thus see
+ * the same threading as with asio, but the kernel does the reads and writes of any number of
+ * sockets for a single wakeup of the reactor, instead of the reactor issuing a system call for
+ * each of them. Operations are queued on the ring as they are started, and all those started
+ * while the reactor runs its ready handlers are submitted together with a single system call.
+ *
+ * An operation the kernel completes with EAGAIN, which older kernels do for sockets in
+ * non-blocking mode, is retried once the socket is ready.
+ */
+class IOUringService final : public asio::execution_context::service {
+public:
+    /**
+     * Called with the result of an operation, which is the result of the equivalent system call
+     * or -errno.
+     */
+    using Completion = unique_function<void(int)>;
+
+    static asio::execution_context::id id;
+
+    /**
+     * Returns OK if the kernel supports io_uring instances with all of the operations this
+     * service issues.
+     */
+    static Status probe();
+
+    /**
+     * Installs the service on 'ctx'. Returns an error, leaving 'ctx' untouched, if the ring could
+     * not be set up.
+     */
+    static Status install(asio::io_context& ctx);
+
+    /**
+     * Returns the service installed on 'ctx', or nullptr if the reactor of 'ctx' runs on epoll.
+     */
+    static IOUringService* get(asio::io_context& ctx);
+
+    /**
+     * Sets up a ring of 'kRingEntries' submission queue entries, and throws if that fails.
+     */
+    explicit IOUringService(asio::execution_context& ctx);
+    ~IOUringService();
+
+    void accept(int fd, Completion completion);
+    void recv(int fd, void* data, size_t size, Completion completion);
+    void send(int fd, const void* data, size_t size, Completion completion);
+
+    /**
+     * Receives or sends at most all of 'buffer', and returns the number of bytes transferred. A
+     * peer which closed the connection fails the future with the same error as asio::read().
+     */
+    Future<size_t> recvSome(int fd, asio::mutable_buffer buffer);
+    Future<size_t> sendSome(int fd, asio::const_buffer buffer);
+
+    /**
+     * Receives or sends all of 'buffer', with as many operations as needed.
+     */
+    Future<void> recvAll(int fd, asio::mutable_buffer buffer);
+    Future<void> sendAll(int fd, asio::const_buffer buffer);
+
+    /**
+     * Cancels the operations in progress on 'fd', which complete with -ECANCELED.
+     */
+    void cancel(int fd);
+
+    /**
+     * Cancels all operations in progress and waits for the kernel to release their buffers. The
+     * completions are destroyed without being called, as asio does for its own handlers.
+     */
+    void shutdown() override;
+
+private:
+    class Ring;
+    struct Op;
+
+    static constexpr unsigned kRingEntries = 4096;
+
+    /**
+     * Queues 'op' on the ring, or completes it with an error if that fails.
+     */
+    void _submit(std::unique_ptr<Op> op);
+
+    /**
+     * Schedules a submission of the queued entries on the io_context, unless one is scheduled
+     * already.
+     */
+    void _scheduleSubmission(WithLock);
+    void _armWait();
+    void _reap();
+
+    std::unique_ptr<Ring> _ring;
+
+    // Waits on the io_context for the ring to have completions.
+    asio::posix::stream_descriptor _ringDescriptor;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("IOUringService::_mutex");
+    stdx::unordered_set<Op*> _inProgress;
+    bool _inShutdown = false;
+
+    // Whether a submission of the queued entries is posted to the io_context.
+    bool _submissionScheduled = false;
+};
+
+}  // namespace transport
+}  // namespace mongo
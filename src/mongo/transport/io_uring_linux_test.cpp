@@ -0,0 +1,254 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kTest
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/io_uring_linux.h"
+
+#include <array>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "mongo/logv2/log.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+/**
+ * Runs an io_context with an IOUringService installed, and provides a connected pair of
+ * non-blocking sockets to issue operations on. The tests do nothing on kernels without io_uring.
+ */
+class IOUringServiceTest : public unittest::Test {
+public:
+    void setUp() override {
+        if (auto status = IOUringService::probe(); !status.isOK()) {
+            LOGV2(5150841, "Skipping test, io_uring is not supported", "error"_attr = status);
+            return;
+        }
+
+        _ctx = std::make_unique<asio::io_context>();
+        ASSERT_OK(IOUringService::install(*_ctx));
+
+        int fds[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds));
+        _fds = {fds[0], fds[1]};
+    }
+
+    void tearDown() override {
+        _ctx.reset();
+        for (auto fd : _fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    bool supported() const {
+        return !!_ctx;
+    }
+
+    IOUringService& service() {
+        return *IOUringService::get(*_ctx);
+    }
+
+    int fd(size_t i) const {
+        return _fds[i];
+    }
+
+    /**
+     * Runs the io_context until 'pred' returns true.
+     */
+    template <typename Pred>
+    void runUntil(Pred&& pred) {
+        const auto deadline = Date_t::now() + Seconds(30);
+        while (!pred()) {
+            ASSERT_LT(Date_t::now(), deadline);
+            _ctx->run_one_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    /**
+     * Runs the io_context for 'duration', whether or not there are handlers to run.
+     */
+    void runFor(Milliseconds duration) {
+        _ctx->run_for(duration.toSystemDuration());
+    }
+
+    void destroyContext() {
+        _ctx.reset();
+    }
+
+private:
+    std::unique_ptr<asio::io_context> _ctx;
+    std::array<int, 2> _fds = {-1, -1};
+};
+
+TEST_F(IOUringServiceTest, SendAndRecv) {
+    if (!supported()) {
+        return;
+    }
+
+    const std::string out = "hello";
+    std::string in(out.size(), '\0');
+    auto sent = service().sendSome(fd(0), asio::buffer(out));
+    auto received = service().recvSome(fd(1), asio::buffer(&in[0], in.size()));
+    runUntil([&] { return sent.isReady() && received.isReady(); });
+
+    ASSERT_EQ(sent.get(), out.size());
+    ASSERT_EQ(received.get(), out.size());
+    ASSERT_EQ(in, out);
+}
+
+TEST_F(IOUringServiceTest, SendAllAndRecvAll) {
+    if (!supported()) {
+        return;
+    }
+
+    // Larger than the socket buffers, so that both sides take several operations.
+    std::string out(8 * 1024 * 1024, '\0');
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = static_cast<char>(i % 251);
+    }
+    std::string in(out.size(), '\0');
+
+    auto sent = service().sendAll(fd(0), asio::buffer(out));
+    auto received = service().recvAll(fd(1), asio::buffer(&in[0], in.size()));
+    runUntil([&] { return sent.isReady() && received.isReady(); });
+
+    ASSERT_OK(sent.getNoThrow());
+    ASSERT_OK(received.getNoThrow());
+    ASSERT(in == out);
+}
+
+TEST_F(IOUringServiceTest, RecvWaitsForData) {
+    if (!supported()) {
+        return;
+    }
+
+    // Kernels which complete the receive with EAGAIN have it retried once the socket is readable.
+    char in = 0;
+    auto received = service().recvSome(fd(1), asio::buffer(&in, 1));
+    runFor(Milliseconds(50));
+    ASSERT_FALSE(received.isReady());
+
+    ASSERT_EQ(1, ::send(fd(0), "x", 1, MSG_NOSIGNAL));
+    runUntil([&] { return received.isReady(); });
+    ASSERT_EQ(received.get(), 1U);
+    ASSERT_EQ(in, 'x');
+}
+
+TEST_F(IOUringServiceTest, SendWaitsForSpace) {
+    if (!supported()) {
+        return;
+    }
+
+    std::string chunk(64 * 1024, 'x');
+    size_t filled = 0;
+    while (true) {
+        auto result = ::send(fd(0), chunk.data(), chunk.size(), MSG_NOSIGNAL);
+        if (result < 0) {
+            ASSERT_EQ(errno, EAGAIN);
+            break;
+        }
+        filled += result;
+    }
+
+    // Kernels which complete the send with EAGAIN have it retried once the socket is writable.
+    auto sent = service().sendSome(fd(0), asio::buffer(chunk));
+    runFor(Milliseconds(50));
+    ASSERT_FALSE(sent.isReady());
+
+    while (filled > 0) {
+        auto result = ::recv(fd(1), &chunk[0], std::min(filled, chunk.size()), 0);
+        if (result < 0) {
+            ASSERT_EQ(errno, EAGAIN);
+            runFor(Milliseconds(1));
+            continue;
+        }
+        filled -= result;
+    }
+    runUntil([&] { return sent.isReady(); });
+    ASSERT_GT(sent.get(), 0U);
+}
+
+TEST_F(IOUringServiceTest, CancelFailsOnlyTheOperationsOfTheSocket) {
+    if (!supported()) {
+        return;
+    }
+
+    char canceledIn = 0;
+    char otherIn = 0;
+    auto canceled = service().recvSome(fd(1), asio::buffer(&canceledIn, 1));
+    auto other = service().recvSome(fd(0), asio::buffer(&otherIn, 1));
+    runFor(Milliseconds(10));
+
+    service().cancel(fd(1));
+    runUntil([&] { return canceled.isReady(); });
+    ASSERT_EQ(canceled.getNoThrow().getStatus(), ErrorCodes::CallbackCanceled);
+    ASSERT_FALSE(other.isReady());
+
+    ASSERT_EQ(1, ::send(fd(1), "x", 1, MSG_NOSIGNAL));
+    runUntil([&] { return other.isReady(); });
+    ASSERT_EQ(other.get(), 1U);
+    ASSERT_EQ(otherIn, 'x');
+}
+
+TEST_F(IOUringServiceTest, ShutdownDestroysOperationsInProgress) {
+    if (!supported()) {
+        return;
+    }
+
+    char in = 0;
+    auto received = service().recvSome(fd(1), asio::buffer(&in, 1));
+    runFor(Milliseconds(10));
+
+    // Destroying the operation breaks its promise, whose continuation may call into the service
+    // again.
+    auto& svc = service();
+    boost::optional<Status> status;
+    std::move(received).getAsync([&](StatusWith<size_t> swSize) {
+        status = swSize.getStatus();
+        svc.cancel(fd(1));
+        svc.recv(fd(1), &in, 1, [](int) {});
+    });
+    ASSERT_FALSE(status);
+
+    destroyContext();
+    ASSERT(status);
+    ASSERT_EQ(*status, ErrorCodes::BrokenPromise);
+}
+
+}  // namespace
+}  // namespace transport
+}  // namespace mongo
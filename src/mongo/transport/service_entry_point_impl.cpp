@@ -169,7 +169,10 @@ void ServiceEntryPointImpl::startSession(transport::SessionHandle session) {
         }
         return;
     } else if (usingMaxConnOverride && _adminInternalPool) {
+        // The reserved executor dedicates a thread to the session, which then sources and sinks
+        // its messages synchronously whatever the transport mode of the other sessions.
         ssm->setServiceExecutor(_adminInternalPool.get());
+        transportMode = _adminInternalPool->transportMode();
     }
 
     if (!quiet) {
@@ -33,6 +33,7 @@
 
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/baton.h"
 #include "mongo/platform/bitwise_enum_operators.h"
 #include "mongo/transport/transport_mode.h"
 #include "mongo/util/duration.h"
@@ -117,6 +118,15 @@ public:
      */
     virtual Mode transportMode() const = 0;
 
+    /*
+     * Returns the networking baton that asynchronous network waits issued by tasks running on the
+     * calling thread should use, or nullptr if those waits are left to the transport layer's
+     * reactor.
+     */
+    virtual BatonHandle getBatonForCurrentThread() {
+        return nullptr;
+    }
+
     /*
      * Appends statistics about task scheduling to a BSONObjBuilder for serverStatus output.
      */
@@ -33,15 +33,21 @@
 
 #include "boost/optional.hpp"
 #include <algorithm>
+#include <array>
 
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/logv2/log.h"
+#include "mongo/rpc/message.h"
 #include "mongo/transport/mock_session.h"
+#include "mongo/transport/service_entry_point.h"
 #include "mongo/transport/service_executor_fixed.h"
 #include "mongo/transport/service_executor_gen.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_thread_per_core.h"
 #include "mongo/transport/transport_layer.h"
+#include "mongo/transport/transport_layer_asio.h"
 #include "mongo/transport/transport_layer_mock.h"
 #include "mongo/unittest/barrier.h"
 #include "mongo/unittest/death_test.h"
@@ -398,5 +404,448 @@ TEST_F(ServiceExecutorFixedFixture, StartAndShutdownAreDeterministic) {
     shutdownThread.join();
 }
 
+class ServiceExecutorThreadPerCoreFixture : public unittest::Test {
+public:
+    static constexpr size_t kNumWorkers = 2;
+
+protected:
+    void setUp() override {
+        // Tests which block a worker on purpose expect it to stay blocked, unless they lower the
+        // threshold again.
+        threadPerCoreServiceExecutorBlockedTaskThresholdMillis.store(
+            durationCount<Milliseconds>(Hours(1)));
+        executor = std::make_unique<ServiceExecutorThreadPerCore>(
+            svcCtx, kNumWorkers, false /* pinWorkers */);
+    }
+
+    void tearDown() override {
+        ASSERT_OK(executor->shutdown(kShutdownTime));
+        threadPerCoreServiceExecutorBlockedTaskThresholdMillis.store(
+            kThreadPerCoreServiceExecutorBlockedTaskThresholdMillisDefault);
+        threadPerCoreServiceExecutorMaxBlockedThreads.store(
+            kThreadPerCoreServiceExecutorMaxBlockedThreadsDefault);
+    }
+
+    /**
+     * Schedules a task that occupies one worker until the returned promise is fulfilled, and
+     * returns once the task runs.
+     */
+    std::shared_ptr<SharedPromise<void>> occupyWorker() {
+        auto running = std::make_shared<SharedPromise<void>>();
+        auto mayReturn = std::make_shared<SharedPromise<void>>();
+        ASSERT_OK(executor->scheduleTask(
+            [running, mayReturn] {
+                running->emplaceValue();
+                mayReturn->getFuture().get();
+            },
+            ServiceExecutor::kEmptyFlags));
+        running->getFuture().get();
+        return mayReturn;
+    }
+
+    BSONObj getStats() {
+        BSONObjBuilder bob;
+        executor->appendStats(&bob);
+        return bob.obj();
+    }
+
+    // Without a service context, the workers have no batons.
+    ServiceContext* svcCtx = nullptr;
+    std::unique_ptr<ServiceExecutorThreadPerCore> executor;
+};
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, ScheduleFailsBeforeStartup) {
+    scheduleBasicTask(executor.get(), false);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, BasicTaskRuns) {
+    ASSERT_OK(executor->start());
+    scheduleBasicTask(executor.get(), true);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, ScheduleFailsAfterShutdown) {
+    ASSERT_OK(executor->start());
+    ASSERT_OK(executor->shutdown(kShutdownTime));
+    scheduleBasicTask(executor.get(), false);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, RecursiveTaskRunsInline) {
+    ASSERT_OK(executor->start());
+    auto done = std::make_shared<SharedPromise<void>>();
+
+    ASSERT_OK(executor->scheduleTask(
+        [this, done] {
+            bool ranInline = false;
+            ASSERT_OK(executor->scheduleTask([&] { ranInline = true; },
+                                             ServiceExecutor::kMayRecurse));
+            ASSERT(ranInline);
+            done->emplaceValue();
+        },
+        ServiceExecutor::kEmptyFlags));
+
+    done->getFuture().get();
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, TasksStayOnTheirWorker) {
+    ASSERT_OK(executor->start());
+
+    // With the other worker occupied, nothing can steal the follow-up task.
+    auto releaseWorker = occupyWorker();
+    auto guard = makeGuard([&] { releaseWorker->emplaceValue(); });
+
+    auto workers = std::make_shared<SharedPromise<std::pair<int, int>>>();
+    ASSERT_OK(executor->scheduleTask(
+        [this, workers] {
+            auto first = executor->getWorkerIndexForCurrentThread();
+            ASSERT_OK(executor->scheduleTask(
+                [this, workers, first] {
+                    workers->emplaceValue(first, executor->getWorkerIndexForCurrentThread());
+                },
+                ServiceExecutor::kEmptyFlags));
+        },
+        ServiceExecutor::kEmptyFlags));
+
+    auto [first, second] = workers->getFuture().get();
+    ASSERT_GTE(first, 0);
+    ASSERT_EQ(first, second);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, IdleWorkerStealsQueuedTasks) {
+    ASSERT_OK(executor->start());
+    constexpr auto kNumTasks = 4;
+
+    struct State {
+        AtomicWord<int> remaining{kNumTasks};
+        SharedPromise<void> allRan;
+        std::array<AtomicWord<int>, kNumTasks> workers;
+    };
+    auto state = std::make_shared<State>();
+    auto blockedWorker = std::make_shared<SharedPromise<int>>();
+
+    // The tasks are queued on the worker that schedules them, which then blocks until they have
+    // all run. Only the other worker can run them.
+    ASSERT_OK(executor->scheduleTask(
+        [this, state, blockedWorker] {
+            for (auto i = 0; i < kNumTasks; ++i) {
+                ASSERT_OK(executor->scheduleTask(
+                    [this, state, i] {
+                        state->workers[i].store(executor->getWorkerIndexForCurrentThread());
+                        if (state->remaining.subtractAndFetch(1) == 0) {
+                            state->allRan.emplaceValue();
+                        }
+                    },
+                    ServiceExecutor::kEmptyFlags));
+            }
+            blockedWorker->emplaceValue(executor->getWorkerIndexForCurrentThread());
+            state->allRan.getFuture().get();
+        },
+        ServiceExecutor::kEmptyFlags));
+
+    auto blocked = blockedWorker->getFuture().get();
+    state->allRan.getFuture().get();
+    for (auto&& worker : state->workers) {
+        ASSERT_GTE(worker.load(), 0);
+        ASSERT_NE(worker.load(), blocked);
+    }
+
+    BSONObjBuilder bob;
+    executor->appendStats(&bob);
+    ASSERT_GTE(bob.obj()["tasksStolen"].numberLong(), kNumTasks);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, BlockedWorkersAreHandedOff) {
+    threadPerCoreServiceExecutorBlockedTaskThresholdMillis.store(10);
+    ASSERT_OK(executor->start());
+
+    std::vector<std::shared_ptr<SharedPromise<void>>> releaseWorkers;
+    auto guard = makeGuard([&] {
+        for (auto&& releaseWorker : releaseWorkers) {
+            releaseWorker->emplaceValue();
+        }
+    });
+    for (size_t i = 0; i < kNumWorkers; ++i) {
+        releaseWorkers.push_back(occupyWorker());
+    }
+
+    // Every worker is blocked, so the task only runs once one of them was handed off.
+    scheduleBasicTask(executor.get(), true);
+
+    BSONObjBuilder bob;
+    executor->appendStats(&bob);
+    ASSERT_GTE(bob.obj()["blockedTaskHandoffs"].numberLong(), 1);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, BlockedThreadsAreLimited) {
+    threadPerCoreServiceExecutorBlockedTaskThresholdMillis.store(10);
+    threadPerCoreServiceExecutorMaxBlockedThreads.store(1);
+    ASSERT_OK(executor->start());
+
+    std::vector<std::shared_ptr<SharedPromise<void>>> releaseWorkers;
+    auto guard = makeGuard([&] {
+        for (auto&& releaseWorker : releaseWorkers) {
+            releaseWorker->emplaceValue();
+        }
+    });
+    for (size_t i = 0; i < kNumWorkers; ++i) {
+        releaseWorkers.push_back(occupyWorker());
+    }
+
+    // Handing off one of the blocked workers is enough for the task to run, and no other worker is
+    // handed off after that.
+    scheduleBasicTask(executor.get(), true);
+    sleepmillis(100);
+    auto stats = getStats();
+    ASSERT_EQ(stats["blockedTaskHandoffs"].numberLong(), 1);
+    ASSERT_EQ(stats.getIntField("blockedThreads"), 1);
+    ASSERT_EQ(stats.getIntField("threadsRunning"), static_cast<int>(kNumWorkers) + 1);
+
+    // The blocked thread exits once its task returns.
+    for (auto&& releaseWorker : releaseWorkers) {
+        releaseWorker->emplaceValue();
+    }
+    releaseWorkers.clear();
+    while (getStats().getIntField("blockedThreads") != 0) {
+        sleepmillis(10);
+    }
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, ShutdownTimeLimit) {
+    ASSERT_OK(executor->start());
+    auto releaseWorker = occupyWorker();
+
+    ASSERT_NOT_OK(executor->shutdown(kShutdownTime));
+
+    // Ensure the service executor is stopped before leaving the test.
+    releaseWorker->emplaceValue();
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, Stats) {
+    ASSERT_OK(executor->start());
+
+    BSONObjBuilder bob;
+    executor->appendStats(&bob);
+    auto obj = bob.obj();
+    ASSERT_EQ(obj.getStringField("executor"), "threadPerCore"_sd);
+    ASSERT_EQ(obj.getIntField("threadsRunning"), static_cast<int>(kNumWorkers));
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, RunTaskAfterWaitingForData) {
+    auto tl = std::make_unique<TransportLayerMock>();
+    auto session = tl->createSession();
+    ASSERT_OK(executor->start());
+
+    auto ranOnWorker = std::make_shared<SharedPromise<int>>();
+    executor->runOnDataAvailable(session.get(), [this, ranOnWorker](Status status) {
+        ASSERT_OK(status);
+        ranOnWorker->emplaceValue(executor->getWorkerIndexForCurrentThread());
+    });
+
+    ASSERT(!ranOnWorker->getFuture().isReady());
+    reinterpret_cast<MockSession*>(session.get())->signalAvailableData();
+    ASSERT_GTE(ranOnWorker->getFuture().get(), 0);
+}
+
+/**
+ * Keeps the sessions a transport layer accepts, without reading from them.
+ */
+class SessionCollectorSEP : public ServiceEntryPoint {
+public:
+    void startSession(SessionHandle session) override {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _sessions.push_back(std::move(session));
+        _cv.notify_one();
+    }
+
+    void endAllSessions(Session::TagMask tags) override {
+        std::vector<SessionHandle> sessions;
+        stdx::lock_guard<Latch> lk(_mutex);
+        sessions.swap(_sessions);
+    }
+
+    Status start() override {
+        return Status::OK();
+    }
+
+    bool shutdown(Milliseconds timeout) override {
+        return true;
+    }
+
+    void appendStats(BSONObjBuilder*) const override {}
+
+    size_t numOpenSessions() const override {
+        stdx::lock_guard<Latch> lk(_mutex);
+        return _sessions.size();
+    }
+
+    Future<DbResponse> handleRequest(OperationContext* opCtx,
+                                     const Message& request) noexcept override {
+        MONGO_UNREACHABLE;
+    }
+
+    SessionHandle waitForSession() {
+        stdx::unique_lock<Latch> lk(_mutex);
+        _cv.wait(lk, [&] { return !_sessions.empty(); });
+        return _sessions.front();
+    }
+
+private:
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("SessionCollectorSEP::_mutex");
+    stdx::condition_variable _cv;
+    std::vector<SessionHandle> _sessions;
+};
+
+/**
+ * Runs the thread-per-core executor on a service context with a transport layer, which gives each
+ * worker a networking baton, and connects a client to the transport layer.
+ */
+class ServiceExecutorThreadPerCoreNetworkFixture : public ServiceExecutorThreadPerCoreFixture {
+protected:
+    void setUp() override {
+        setGlobalServiceContext(ServiceContext::make());
+        svcCtx = getGlobalServiceContext();
+
+        ServerGlobalParams params;
+        params.noUnixSocket = true;
+        TransportLayerASIO::Options opts(&params);
+        opts.port = 0;
+        auto tl = std::make_unique<TransportLayerASIO>(opts, &_sep);
+        _tl = tl.get();
+        ASSERT_OK(_tl->setup());
+        ASSERT_OK(_tl->start());
+        svcCtx->setTransportLayer(std::move(tl));
+
+        ServiceExecutorThreadPerCoreFixture::setUp();
+
+        std::error_code ec;
+        _sock.connect(
+            asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), _tl->listenerPort()), ec);
+        ASSERT_FALSE(ec);
+        session = _sep.waitForSession();
+    }
+
+    void tearDown() override {
+        session.reset();
+        ServiceExecutorThreadPerCoreFixture::tearDown();
+
+        // The clients of the workers must go before the service context does.
+        executor.reset();
+        _sep.endAllSessions({});
+        _tl->shutdown();
+        setGlobalServiceContext(nullptr);
+    }
+
+    /**
+     * The progress of a message sent by sinkLargeMessage().
+     */
+    struct SinkState {
+        // The worker which started to send the message.
+        SharedPromise<int> started;
+
+        // The worker on which sending the message completed, and whether the task scheduled there
+        // to resume the session ran inline.
+        SharedPromise<std::pair<int, bool>> completed;
+
+        // The worker which resumed the session.
+        SharedPromise<int> resumed;
+    };
+
+    /**
+     * Starts to send a message much larger than the socket buffers to the client, so that it waits
+     * on the baton of the calling worker until the client reads it with readLargeMessage(). Once
+     * the message is sent, schedules a task to resume the session, as the ServiceStateMachine does.
+     */
+    void sinkLargeMessage(const std::shared_ptr<SinkState>& state) {
+        auto baton = executor->getBatonForCurrentThread();
+        ASSERT(baton && baton->networking());
+
+        std::string payload(kLargeMessageSize - sizeof(MsgData::Value) + 4, 'x');
+        Message message;
+        message.setData(dbMsg, payload.data(), payload.size());
+
+        session->asyncSinkMessage(std::move(message), baton)
+            .getAsync([this, state](Status status) {
+                ASSERT_OK(status);
+                auto ranInline = std::make_shared<AtomicWord<bool>>(false);
+                ASSERT_OK(executor->scheduleTask(
+                    [this, state, ranInline] {
+                        ranInline->store(true);
+                        state->resumed.emplaceValue(executor->getWorkerIndexForCurrentThread());
+                    },
+                    ServiceExecutor::kMayRecurse));
+                state->completed.emplaceValue(executor->getWorkerIndexForCurrentThread(),
+                                              ranInline->load());
+            });
+        state->started.emplaceValue(executor->getWorkerIndexForCurrentThread());
+    }
+
+    void readLargeMessage() {
+        std::vector<char> buf(kLargeMessageSize);
+        std::error_code ec;
+        asio::read(_sock, asio::buffer(buf), ec);
+        ASSERT_FALSE(ec);
+    }
+
+    static constexpr size_t kLargeMessageSize = 32 * 1024 * 1024;
+
+    SessionHandle session;
+
+private:
+    SessionCollectorSEP _sep;
+    TransportLayerASIO* _tl = nullptr;  // Owned by the service context.
+    asio::io_context _ctx;
+    asio::ip::tcp::socket _sock{_ctx};
+};
+
+TEST_F(ServiceExecutorThreadPerCoreNetworkFixture, SinkWaitsOnWorkerBaton) {
+    ASSERT_OK(executor->start());
+
+    // With the other worker occupied, only the worker which sends the message polls its baton.
+    auto releaseWorker = occupyWorker();
+    auto guard = makeGuard([&] { releaseWorker->emplaceValue(); });
+
+    auto state = std::make_shared<SinkState>();
+    ASSERT_OK(executor->scheduleTask([this, state] { sinkLargeMessage(state); },
+                                     ServiceExecutor::kEmptyFlags));
+    auto sinkingWorker = state->started.getFuture().get();
+    ASSERT_GTE(sinkingWorker, 0);
+
+    sleepmillis(50);
+    ASSERT_FALSE(state->completed.getFuture().isReady());
+    readLargeMessage();
+
+    // The task scheduled from within the baton is queued rather than run inline.
+    auto [completedOn, ranInline] = state->completed.getFuture().get();
+    ASSERT_EQ(completedOn, sinkingWorker);
+    ASSERT_FALSE(ranInline);
+    ASSERT_EQ(state->resumed.getFuture().get(), sinkingWorker);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreNetworkFixture, IdleWorkerPollsBatonOfBusyWorker) {
+    ASSERT_OK(executor->start());
+
+    // The worker which sends the message stays busy until the session resumes, so only the other
+    // worker can find out that the message was sent.
+    auto state = std::make_shared<SinkState>();
+    ASSERT_OK(executor->scheduleTask(
+        [this, state] {
+            sinkLargeMessage(state);
+            state->resumed.getFuture().get();
+        },
+        ServiceExecutor::kEmptyFlags));
+    auto sinkingWorker = state->started.getFuture().get();
+    ASSERT_GTE(sinkingWorker, 0);
+
+    sleepmillis(50);
+    ASSERT_FALSE(state->completed.getFuture().isReady());
+    readLargeMessage();
+
+    // The session moves over to the worker which polled the baton.
+    auto [completedOn, ranInline] = state->completed.getFuture().get();
+    ASSERT_GTE(completedOn, 0);
+    ASSERT_NE(completedOn, sinkingWorker);
+    ASSERT_FALSE(ranInline);
+    ASSERT_EQ(state->resumed.getFuture().get(), completedOn);
+}
+
 }  // namespace
 }  // namespace mongo
@@ -0,0 +1,623 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kExecutor
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/service_executor_thread_per_core.h"
+
+#include <deque>
+#include <iterator>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "mongo/db/client.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/service_context.h"
+#include "mongo/logv2/log.h"
+#include "mongo/transport/baton.h"
+#include "mongo/transport/service_executor_gen.h"
+#include "mongo/transport/service_executor_utils.h"
+#include "mongo/transport/session.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+constexpr auto kThreadsRunning = "threadsRunning"_sd;
+constexpr auto kTasksStolen = "tasksStolen"_sd;
+constexpr auto kBlockedTaskHandoffs = "blockedTaskHandoffs"_sd;
+constexpr auto kBlockedThreads = "blockedThreads"_sd;
+constexpr auto kExecutorLabel = "executor"_sd;
+constexpr auto kExecutorName = "threadPerCore"_sd;
+
+// How long an idle worker waits for work before it looks for tasks to steal again.
+constexpr Milliseconds kIdleWaitInterval{10};
+
+// How long an idle worker polls the baton of a busy worker on its behalf.
+constexpr Milliseconds kBusyWorkerPollInterval{1};
+
+/**
+ * Returns the CPUs the process may run on, in ascending order.
+ */
+std::vector<int> getAvailableCpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t available;
+    CPU_ZERO(&available);
+    if (sched_getaffinity(0, sizeof(available), &available) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &available)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+void pinCurrentThreadToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    if (auto ec = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus); ec != 0) {
+        LOGV2_WARNING(5150835,
+                      "Failed to pin service executor worker thread to its core",
+                      "cpu"_attr = cpu,
+                      "error"_attr = errnoWithDescription(ec));
+    }
+#endif
+}
+}  // namespace
+
+/**
+ * The run queue and network wait state of a single worker thread.
+ *
+ * The queue is only ever locked on its own, so workers never hold two queue mutexes at once.
+ * 'batonMutex' is held by whichever thread runs the worker's baton, and may be held while
+ * acquiring a queue mutex, since continuations fulfilled by the baton schedule tasks.
+ */
+class ServiceExecutorThreadPerCore::Worker {
+public:
+    Worker(ServiceExecutorThreadPerCore* executor, size_t index)
+        : executor(executor), index(index) {}
+
+    /**
+     * Wakes the worker from its idle wait. Must be called with 'mutex' held.
+     */
+    void notifyLocked() {
+        if (networkingBaton) {
+            baton->notify();
+        } else {
+            cv.notify_one();
+        }
+    }
+
+    ServiceExecutorThreadPerCore* const executor;
+    const size_t index;
+
+    // The CPU to pin the worker thread to, if any.
+    int cpu = -1;
+
+    Mutex mutex = MONGO_MAKE_LATCH("ServiceExecutorThreadPerCore::Worker::mutex");
+    std::deque<Task> queue;
+    stdx::condition_variable cv;
+
+    // Mirrors the size of 'queue' so that thieves can look for victims without locking.
+    AtomicWord<size_t> queued{0};
+
+    // Set while the worker has run out of tasks and waits for new ones.
+    AtomicWord<bool> idle{false};
+
+    Mutex batonMutex = MONGO_MAKE_LATCH("ServiceExecutorThreadPerCore::Worker::batonMutex");
+
+    // The worker's baton is the baton of an operation that lives as long as the worker thread.
+    // 'networkingBaton' is only reset by the worker thread on its way out, with both 'mutex' and
+    // 'batonMutex' held.
+    ServiceContext::UniqueClient client;
+    ServiceContext::UniqueOperationContext opCtx;
+    BatonHandle baton;
+    NetworkingBaton* networkingBaton = nullptr;
+
+    // Alternates an idle worker between polling its own baton and that of a busy worker.
+    bool pollBusyWorkerNext = false;
+
+    // The token of the task that the thread running the worker is in, or zero between tasks. A
+    // thread which finds the token reset when its task returns was replaced by another thread
+    // while the task blocked, and exits. Tokens come from 'tasksStarted', which only the thread
+    // running the worker touches.
+    AtomicWord<uint64_t> runningTask{0};
+    uint64_t tasksStarted = 0;
+
+    // The token the monitor saw at its last look, so that it can tell a task that is still running.
+    uint64_t lastSeenTask = 0;
+};
+
+bool ServiceExecutorThreadPerCore::isSupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+ServiceExecutorThreadPerCore::ServiceExecutorThreadPerCore(ServiceContext* ctx,
+                                                           size_t numWorkers,
+                                                           bool pinWorkers)
+    : _svcCtx(ctx), _pinWorkers(pinWorkers) {
+    if (numWorkers == 0) {
+        numWorkers = static_cast<size_t>(ProcessInfo::getNumAvailableCores());
+    }
+    for (size_t i = 0; i < numWorkers; ++i) {
+        _workers.push_back(std::make_unique<Worker>(this, i));
+    }
+}
+
+ServiceExecutorThreadPerCore::ServiceExecutorThreadPerCore(ServiceContext* ctx)
+    : ServiceExecutorThreadPerCore(ctx,
+                                   static_cast<size_t>(threadPerCoreServiceExecutorNumThreads),
+                                   threadPerCoreServiceExecutorPinThreads) {}
+
+ServiceExecutorThreadPerCore::~ServiceExecutorThreadPerCore() {
+    invariant(!_canScheduleWork.load());
+
+    stdx::unique_lock<Latch> lk(_mutex);
+    if (_state == State::kNotStarted)
+        return;
+
+    // Ensures we always call "shutdown" after starting the service executor, and that no worker
+    // thread outlives the worker state it runs on.
+    invariant(_state == State::kStopped);
+    _shutdownCondition.wait(lk, [this] { return _numRunningWorkers.load() == 0; });
+}
+
+Status ServiceExecutorThreadPerCore::start() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto oldState = std::exchange(_state, State::kRunning);
+    invariant(oldState == State::kNotStarted);
+
+    const auto cpus = _pinWorkers ? getAvailableCpus() : std::vector<int>{};
+    for (auto&& worker : _workers) {
+        if (!cpus.empty()) {
+            worker->cpu = cpus[worker->index % cpus.size()];
+        }
+
+        // Operations made by the service context use the networking baton of its transport layer,
+        // if it has one.
+        if (_svcCtx) {
+            worker->client =
+                _svcCtx->makeClient(str::stream() << "ThreadPerCoreWorker-" << worker->index);
+            worker->opCtx = _svcCtx->makeOperationContext(worker->client.get());
+            worker->baton = worker->opCtx->getBaton();
+            worker->networkingBaton = worker->baton->networking();
+        }
+    }
+
+    _canScheduleWork.store(true);
+    for (auto&& worker : _workers) {
+        _numRunningWorkers.addAndFetch(1);
+        auto status =
+            launchServiceWorkerThread([this, worker = worker.get()] { _runWorker(worker); });
+        if (!status.isOK()) {
+            _numRunningWorkers.subtractAndFetch(1);
+            return status;
+        }
+    }
+
+    _monitor = stdx::thread([this] { _runMonitor(); });
+
+    LOGV2_DEBUG(5150833,
+                3,
+                "Started thread-per-core service executor",
+                "numWorkers"_attr = _workers.size(),
+                "pinned"_attr = !cpus.empty());
+    return Status::OK();
+}
+
+Status ServiceExecutorThreadPerCore::shutdown(Milliseconds timeout) {
+    LOGV2_DEBUG(5150834, 3, "Shutting down thread-per-core service executor");
+
+    bool wasRunning;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _canScheduleWork.store(false);
+        wasRunning = std::exchange(_state, State::kStopped) == State::kRunning;
+        _shutdownCondition.notify_all();
+    }
+
+    if (_monitor.joinable()) {
+        _monitor.join();
+    }
+
+    if (wasRunning) {
+        for (auto&& worker : _workers) {
+            stdx::lock_guard<Latch> lk(worker->mutex);
+            worker->notifyLocked();
+        }
+    }
+
+    stdx::unique_lock<Latch> lk(_mutex);
+    bool success = _shutdownCondition.wait_for(lk, timeout.toSystemDuration(), [this] {
+        return _numRunningWorkers.load() == 0;
+    });
+    return success ? Status::OK()
+                   : Status(ErrorCodes::ExceededTimeLimit,
+                            "Failed to shutdown all executor threads within the time limit");
+}
+
+Status ServiceExecutorThreadPerCore::scheduleTask(Task task, ScheduleFlags flags) {
+    if (!_canScheduleWork.load()) {
+        return Status(ErrorCodes::ShutdownInProgress, "Executor is not running");
+    }
+
+    auto worker = _currentWorker();
+
+    // Tasks scheduled by continuations that a baton fulfills are queued rather than run inline, so
+    // that every session that became ready gets queued, and may be stolen, before any of them runs.
+    if (worker && (flags & ScheduleFlags::kMayRecurse) && !_localInBatonRun &&
+        !_isHandedOff(worker) &&
+        _localRecursionDepth < threadPerCoreServiceExecutorRecursionLimit.loadRelaxed()) {
+        _runTask(std::move(task));
+        return Status::OK();
+    }
+
+    _push(worker ? worker : _nextWorker(), std::move(task));
+    return Status::OK();
+}
+
+void ServiceExecutorThreadPerCore::runOnDataAvailable(
+    Session* session, OutOfLineExecutor::Task onCompletionCallback) {
+    invariant(session);
+
+    auto worker = _currentWorker();
+    auto onReady = [this,
+                    worker = worker ? worker : _nextWorker(),
+                    callback = std::move(onCompletionCallback)](Status status) mutable {
+        if (!status.isOK()) {
+            callback(std::move(status));
+            return;
+        }
+        _push(worker, [callback = std::move(callback)]() mutable { callback(Status::OK()); });
+    };
+
+    // The session may stay idle for long, so it waits on the reactor rather than on the baton of
+    // the worker, which would poll it every time it runs.
+    session->waitForData().getAsync(std::move(onReady));
+}
+
+BatonHandle ServiceExecutorThreadPerCore::getBatonForCurrentThread() {
+    auto worker = _currentWorker();
+    if (!worker || !worker->networkingBaton) {
+        return nullptr;
+    }
+    return worker->baton;
+}
+
+void ServiceExecutorThreadPerCore::appendStats(BSONObjBuilder* bob) const {
+    *bob << kExecutorLabel << kExecutorName << kThreadsRunning
+         << static_cast<int>(_numRunningWorkers.load()) << kTasksStolen << _tasksStolen.load()
+         << kBlockedTaskHandoffs << _blockedTaskHandoffs.load() << kBlockedThreads
+         << static_cast<int>(_numBlockedThreads.load());
+}
+
+int ServiceExecutorThreadPerCore::getWorkerIndexForCurrentThread() const {
+    auto worker = _currentWorker();
+    return worker ? static_cast<int>(worker->index) : -1;
+}
+
+ServiceExecutorThreadPerCore::Worker* ServiceExecutorThreadPerCore::_currentWorker() const {
+    if (_localWorker && _localWorker->executor == this) {
+        return _localWorker;
+    }
+    return nullptr;
+}
+
+ServiceExecutorThreadPerCore::Worker* ServiceExecutorThreadPerCore::_nextWorker() {
+    return _workers[_nextWorkerIndex.fetchAndAdd(1) % _workers.size()].get();
+}
+
+void ServiceExecutorThreadPerCore::_runWorker(Worker* worker, uint64_t blockedTask) {
+    ON_BLOCK_EXIT([&] {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (_numRunningWorkers.subtractAndFetch(1) == 0) {
+            _shutdownCondition.notify_all();
+        }
+    });
+
+    // Take the worker over from the thread blocked in 'blockedTask', unless the task returned in
+    // the meantime.
+    if (blockedTask) {
+        if (!worker->runningTask.compareAndSwap(&blockedTask, 0)) {
+            _numBlockedThreads.subtractAndFetch(1);
+            return;
+        }
+        _blockedTaskHandoffs.addAndFetch(1);
+    }
+
+    setThreadName(str::stream() << "ThreadPerCoreWorker-" << worker->index);
+    if (worker->cpu >= 0) {
+        pinCurrentThreadToCpu(worker->cpu);
+    }
+
+    _localWorker = worker;
+    ON_BLOCK_EXIT([] {
+        _localWorker = nullptr;
+        _localTaskToken = 0;
+    });
+    while (_canScheduleWork.load()) {
+        Task task;
+        if (!_popOrSteal(worker, &task)) {
+            _waitForWork(worker);
+            continue;
+        }
+
+        _localTaskToken = ++worker->tasksStarted;
+        worker->runningTask.store(_localTaskToken);
+        _runTask(std::move(task));
+
+        auto token = _localTaskToken;
+        if (!worker->runningTask.compareAndSwap(&token, 0)) {
+            // Another thread runs the worker now.
+            _numBlockedThreads.subtractAndFetch(1);
+            return;
+        }
+    }
+
+    // Detach the baton from this thread, so that the sessions still waiting on it are failed here
+    // rather than on whichever thread destroys the executor.
+    stdx::lock_guard<Latch> batonLk(worker->batonMutex);
+    {
+        stdx::lock_guard<Latch> lk(worker->mutex);
+        worker->networkingBaton = nullptr;
+    }
+    worker->opCtx.reset();
+}
+
+void ServiceExecutorThreadPerCore::_runTask(Task task) {
+    _localRecursionDepth++;
+    ON_BLOCK_EXIT([] { _localRecursionDepth--; });
+    task();
+}
+
+bool ServiceExecutorThreadPerCore::_isHandedOff(Worker* worker) const {
+    return _localWorker == worker && _localTaskToken != 0 &&
+        worker->runningTask.load() != _localTaskToken;
+}
+
+void ServiceExecutorThreadPerCore::_runMonitor() {
+    setThreadName("ThreadPerCoreMonitor");
+
+    stdx::unique_lock<Latch> lk(_mutex);
+    while (true) {
+        const Milliseconds threshold{
+            threadPerCoreServiceExecutorBlockedTaskThresholdMillis.loadRelaxed()};
+        _shutdownCondition.wait_for(
+            lk, threshold.toSystemDuration(), [this] { return !_canScheduleWork.load(); });
+        if (!_canScheduleWork.load()) {
+            return;
+        }
+
+        lk.unlock();
+        _handOffBlockedWorkers();
+        lk.lock();
+    }
+}
+
+void ServiceExecutorThreadPerCore::_handOffBlockedWorkers() {
+    for (auto&& worker : _workers) {
+        // A task that was already running at the last look has run for at least the threshold.
+        const auto task = worker->runningTask.load();
+        if (task == 0 || task != worker->lastSeenTask) {
+            worker->lastSeenTask = task;
+            continue;
+        }
+
+        // Each handoff leaves a thread blocked until its task returns. At the limit, the worker is
+        // looked at again on the next round, and the other workers may steal its queue meanwhile.
+        const auto numBlockedThreads = _numBlockedThreads.load();
+        if (numBlockedThreads >=
+            static_cast<size_t>(threadPerCoreServiceExecutorMaxBlockedThreads.loadRelaxed())) {
+            LOGV2_DEBUG(5150842,
+                        2,
+                        "Not handing off a blocked thread-per-core worker, because too many "
+                        "threads are blocked already",
+                        "worker"_attr = worker->index,
+                        "blockedThreads"_attr = numBlockedThreads);
+            continue;
+        }
+        worker->lastSeenTask = 0;
+
+        LOGV2_DEBUG(5150838,
+                    2,
+                    "Handing off a thread-per-core worker blocked in a task to a new thread",
+                    "worker"_attr = worker->index);
+        _numRunningWorkers.addAndFetch(1);
+        _numBlockedThreads.addAndFetch(1);
+        auto status = launchServiceWorkerThread(
+            [this, worker = worker.get(), task] { _runWorker(worker, task); });
+        if (!status.isOK()) {
+            _numRunningWorkers.subtractAndFetch(1);
+            _numBlockedThreads.subtractAndFetch(1);
+            LOGV2_WARNING(5150839,
+                          "Failed to hand off a blocked thread-per-core worker",
+                          "worker"_attr = worker->index,
+                          "error"_attr = status);
+        }
+    }
+}
+
+void ServiceExecutorThreadPerCore::_push(Worker* worker, Task task) {
+    size_t queued;
+    {
+        stdx::lock_guard<Latch> lk(worker->mutex);
+        worker->queue.push_back(std::move(task));
+        queued = worker->queue.size();
+        worker->queued.store(queued);
+
+        if (worker->idle.load()) {
+            // A worker queueing a task for itself checks its queue before it waits again.
+            if (worker != _localWorker || _isHandedOff(worker)) {
+                worker->notifyLocked();
+            }
+            return;
+        }
+    }
+
+    // The worker is busy, so give an idle one the chance to steal what it cannot get to yet.
+    if (queued > 1) {
+        _wakeIdlePeer(worker);
+    }
+}
+
+bool ServiceExecutorThreadPerCore::_popOrSteal(Worker* worker, Task* task) {
+    {
+        stdx::lock_guard<Latch> lk(worker->mutex);
+        if (!worker->queue.empty()) {
+            *task = std::move(worker->queue.front());
+            worker->queue.pop_front();
+            worker->queued.store(worker->queue.size());
+            return true;
+        }
+    }
+
+    // Steal the newer half of the first non-empty queue. The owner keeps working from the front.
+    const auto numWorkers = _workers.size();
+    for (size_t i = 1; i < numWorkers; ++i) {
+        auto victim = _workers[(worker->index + i) % numWorkers].get();
+        if (victim->queued.load() == 0) {
+            continue;
+        }
+
+        std::deque<Task> stolen;
+        {
+            stdx::lock_guard<Latch> lk(victim->mutex);
+            auto first = victim->queue.end() - (victim->queue.size() + 1) / 2;
+            std::move(first, victim->queue.end(), std::back_inserter(stolen));
+            victim->queue.erase(first, victim->queue.end());
+            victim->queued.store(victim->queue.size());
+        }
+        if (stolen.empty()) {
+            continue;
+        }
+
+        _tasksStolen.addAndFetch(static_cast<long long>(stolen.size()));
+        *task = std::move(stolen.front());
+        stolen.pop_front();
+        if (!stolen.empty()) {
+            stdx::lock_guard<Latch> lk(worker->mutex);
+            std::move(stolen.begin(), stolen.end(), std::back_inserter(worker->queue));
+            worker->queued.store(worker->queue.size());
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void ServiceExecutorThreadPerCore::_waitForWork(Worker* worker) {
+    worker->idle.store(true);
+    ON_BLOCK_EXIT([&] { worker->idle.store(false); });
+
+    // Whoever queues a task from now on sees the worker idle and wakes it up.
+    if (worker->queued.load() || !_canScheduleWork.load()) {
+        return;
+    }
+
+    if (!worker->networkingBaton) {
+        stdx::unique_lock<Latch> lk(worker->mutex);
+        worker->cv.wait_for(lk, kIdleWaitInterval.toSystemDuration(), [&] {
+            return !worker->queue.empty() || !_canScheduleWork.load();
+        });
+        return;
+    }
+
+    worker->pollBusyWorkerNext = !worker->pollBusyWorkerNext;
+    if (worker->pollBusyWorkerNext && _pollBusyWorker(worker)) {
+        return;
+    }
+
+    stdx::lock_guard<Latch> batonLk(worker->batonMutex);
+    _localInBatonRun = true;
+    ON_BLOCK_EXIT([] { _localInBatonRun = false; });
+    auto clkSource = _svcCtx->getPreciseClockSource();
+    worker->baton->run_until(clkSource, clkSource->now() + kIdleWaitInterval);
+}
+
+bool ServiceExecutorThreadPerCore::_pollBusyWorker(Worker* worker) {
+    // Sessions waiting on a busy worker's baton would otherwise wait for its current task. Whatever
+    // becomes ready here is queued on, and so moves over to, the polling worker.
+    const auto numWorkers = _workers.size();
+    for (size_t i = 1; i < numWorkers; ++i) {
+        auto victim = _workers[(worker->index + i) % numWorkers].get();
+        if (victim->idle.load()) {
+            continue;
+        }
+
+        stdx::unique_lock<Latch> batonLk(victim->batonMutex, stdx::try_to_lock);
+        if (!batonLk.owns_lock() || !victim->networkingBaton) {
+            continue;
+        }
+
+        _localInBatonRun = true;
+        ON_BLOCK_EXIT([] { _localInBatonRun = false; });
+        auto clkSource = _svcCtx->getPreciseClockSource();
+        victim->baton->run_until(clkSource, clkSource->now() + kBusyWorkerPollInterval);
+        return true;
+    }
+
+    return false;
+}
+
+void ServiceExecutorThreadPerCore::_wakeIdlePeer(Worker* worker) {
+    const auto numWorkers = _workers.size();
+    for (size_t i = 1; i < numWorkers; ++i) {
+        auto peer = _workers[(worker->index + i) % numWorkers].get();
+        if (!peer->idle.load()) {
+            continue;
+        }
+
+        stdx::lock_guard<Latch> lk(peer->mutex);
+        if (peer->idle.load()) {
+            peer->notifyLocked();
+            return;
+        }
+    }
+}
+
+}  // namespace transport
+}  // namespace mongo
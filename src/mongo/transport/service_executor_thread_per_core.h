@@ -0,0 +1,180 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_executor.h"
+#include "mongo/util/hierarchical_acquisition.h"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * A service executor that runs one worker thread per core, each with its own run queue, so that
+ * neither the number of threads nor a shared queue lock grows with the number of connections.
+ *
+ * Tasks scheduled from a worker thread stay on that worker's queue, which keeps a session's
+ * ServiceStateMachine on the core it started on. Tasks scheduled from any other thread are spread
+ * over the workers round-robin. A worker whose queue is empty steals half of the queue of another
+ * worker before going idle.
+ *
+ * A task which runs for longer than threadPerCoreServiceExecutorBlockedTaskThresholdMillis, e.g.
+ * because it waits for a writeConcern or for an awaitable hello or getMore to return, would hold
+ * up every session queued on its worker. A monitor thread hands such a worker off to a new thread,
+ * which takes over its queue and baton, while the blocked thread exits once its task returns. At
+ * most threadPerCoreServiceExecutorMaxBlockedThreads threads are left blocked this way at a time.
+ *
+ * Each worker owns a networking baton, returned by getBatonForCurrentThread(), on which the
+ * sessions it runs wait to write their responses. Sessions waiting for their next request are
+ * left to the transport layer's reactor, since a baton polls every session it holds each time it
+ * runs. Idle workers poll their own baton, and take turns polling the batons of busy workers so
+ * that a long-running task does not hold back the sessions that are waiting on the same core.
+ * Without a networking baton (e.g. without a transport layer), idle workers wait on a condition
+ * variable instead.
+ */
+class ServiceExecutorThreadPerCore final : public ServiceExecutor {
+public:
+    /**
+     * Returns whether the platform provides the networking batons that this executor relies on to
+     * wait for network readiness.
+     */
+    static bool isSupported();
+
+    /**
+     * Creates an executor with 'numWorkers' worker threads, or one per available core if
+     * 'numWorkers' is zero. Batons are taken from the transport layer of 'ctx' when the executor
+     * starts, if both exist.
+     */
+    ServiceExecutorThreadPerCore(ServiceContext* ctx, size_t numWorkers, bool pinWorkers);
+
+    /**
+     * Creates an executor configured by the threadPerCoreServiceExecutor* server parameters.
+     */
+    explicit ServiceExecutorThreadPerCore(ServiceContext* ctx);
+
+    ~ServiceExecutorThreadPerCore();
+
+    Status start() override;
+    Status shutdown(Milliseconds timeout) override;
+    Status scheduleTask(Task task, ScheduleFlags flags) override;
+
+    void runOnDataAvailable(Session* session,
+                            OutOfLineExecutor::Task onCompletionCallback) override;
+
+    Mode transportMode() const override {
+        return Mode::kAsynchronous;
+    }
+
+    BatonHandle getBatonForCurrentThread() override;
+
+    void appendStats(BSONObjBuilder* bob) const override;
+
+    size_t getNumWorkers() const {
+        return _workers.size();
+    }
+
+    /**
+     * Returns the index of the worker the calling thread runs, or -1 if the calling thread is not
+     * a worker of this executor.
+     */
+    int getWorkerIndexForCurrentThread() const;
+
+private:
+    class Worker;
+
+    Worker* _currentWorker() const;
+    Worker* _nextWorker();
+
+    /**
+     * Runs 'worker' on the calling thread. With a 'blockedTask', the calling thread replaces the
+     * thread blocked in that task, unless the task has returned by then.
+     */
+    void _runWorker(Worker* worker, uint64_t blockedTask = 0);
+    void _runTask(Task task);
+
+    /**
+     * Returns whether the calling thread was handed off from 'worker' while running its current
+     * task, so that it must leave the worker's queue to the thread which replaced it.
+     */
+    bool _isHandedOff(Worker* worker) const;
+
+    void _runMonitor();
+    void _handOffBlockedWorkers();
+
+    void _push(Worker* worker, Task task);
+    bool _popOrSteal(Worker* worker, Task* task);
+    void _waitForWork(Worker* worker);
+    bool _pollBusyWorker(Worker* worker);
+    void _wakeIdlePeer(Worker* worker);
+
+    ServiceContext* const _svcCtx;
+    const bool _pinWorkers;
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    AtomicWord<bool> _canScheduleWork{false};
+    AtomicWord<size_t> _numRunningWorkers{0};
+    AtomicWord<size_t> _nextWorkerIndex{0};
+    AtomicWord<long long> _tasksStolen{0};
+    AtomicWord<long long> _blockedTaskHandoffs{0};
+
+    // Threads which were handed off while blocked in a task, and have not returned from it yet.
+    // Counted from before the handoff starts, so that the monitor never goes over the limit.
+    AtomicWord<size_t> _numBlockedThreads{0};
+
+    mutable Mutex _mutex =
+        MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "ServiceExecutorThreadPerCore::_mutex");
+    stdx::condition_variable _shutdownCondition;
+
+    // Looks for workers blocked in a task. Woken up by shutdown through '_shutdownCondition'.
+    stdx::thread _monitor;
+
+    /**
+     * State transition diagram: kNotStarted ---> kRunning ---> kStopped
+     */
+    enum State { kNotStarted, kRunning, kStopped } _state = kNotStarted;
+
+    static inline thread_local Worker* _localWorker = nullptr;
+    static inline thread_local int _localRecursionDepth = 0;
+    static inline thread_local bool _localInBatonRun = false;
+
+    // Identifies the task that the calling worker thread runs, see Worker::runningTask.
+    static inline thread_local uint64_t _localTaskToken = 0;
+};
+
+}  // namespace transport
+}  // namespace mongo
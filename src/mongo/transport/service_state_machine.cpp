@@ -322,6 +322,8 @@ void ServiceStateMachine::_sourceMessage(ThreadGuard guard) {
             return Future<Message>::makeReady(_session()->sourceMessage());
         } else {
             invariant(_transportMode == transport::Mode::kAsynchronous);
+            // The session may be idle until its next request arrives, so it waits on the reactor
+            // rather than on a baton, which would poll it each time it runs.
             return _session()->asyncSourceMessage();
         }
     };
@@ -349,7 +351,8 @@ void ServiceStateMachine::_sinkMessage(ThreadGuard guard, Message toSink) {
             return Future<void>::makeReady(_session()->sinkMessage(std::move(toSink)));
         } else {
             invariant(_transportMode == transport::Mode::kAsynchronous);
-            return _session()->asyncSinkMessage(std::move(toSink));
+            return _session()->asyncSinkMessage(std::move(toSink),
+                                                _serviceExecutor->getBatonForCurrentThread());
         }
     };
 
@@ -592,6 +595,7 @@ void ServiceStateMachine::start(Ownership ownershipModel) {
 
 void ServiceStateMachine::setServiceExecutor(ServiceExecutor* executor) {
     _serviceExecutor = executor;
+    _transportMode = executor->transportMode();
 }
 
 void ServiceStateMachine::_scheduleNextWithGuard(ThreadGuard guard,
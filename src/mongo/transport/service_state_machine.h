@@ -128,7 +128,8 @@ public:
 
     /*
      * Set the executor to be used for the next call to runNext(). This allows switching between
-     * thread models after the SSM has started.
+     * thread models after the SSM has started. The SSM sources and sinks messages in the transport
+     * mode of the executor from then on.
      */
     void setServiceExecutor(transport::ServiceExecutor* executor);
 
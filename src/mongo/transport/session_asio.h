@@ -37,8 +37,12 @@
 #include "mongo/transport/asio_utils.h"
 #include "mongo/transport/baton.h"
 #include "mongo/transport/transport_layer_asio.h"
+#include "mongo/transport/transport_options_gen.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/net/socket_utils.h"
+#ifdef __linux__
+#include "mongo/transport/io_uring_linux.h"
+#endif
 #ifdef MONGO_CONFIG_SSL
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/net/ssl_peer_info.h"
@@ -168,6 +172,10 @@ public:
     }
 
     Future<void> waitForData() override {
+        if (_readBegin != _readEnd) {
+            // The next message is already buffered, at least in part.
+            return Future<void>::makeReady();
+        }
 #ifdef MONGO_CONFIG_SSL
         if (_sslSocket)
             return asio::async_read(*_sslSocket, asio::null_buffers(), UseFuture{}).ignoreValue();
@@ -209,6 +217,11 @@ public:
         }
 
         getSocket().cancel();
+#ifdef __linux__
+        if (_ioUring) {
+            _ioUring->cancel(getSocket().native_handle());
+        }
+#endif
     }
 
     void setTimeout(boost::optional<Milliseconds> timeout) override {
@@ -349,6 +362,9 @@ protected:
         getSocket().non_blocking(true, ec);
         fassert(50706, errorCodeToStatus(ec));
         _blockingMode = Async;
+#ifdef __linux__
+        _ioUring = IOUringService::get(getSocket().get_executor().context());
+#endif
     }
 
 private:
@@ -403,8 +419,32 @@ private:
         return _socket;
     }
 
+    static constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+
+    static Status validateMessageLength(size_t msgLen) {
+        if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
+            StringBuilder sb;
+            sb << "recv(): message msgLen " << msgLen << " is invalid. "
+               << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
+            const auto str = sb.str();
+            LOGV2(4615638,
+                  "recv(): message msgLen {msgLen} is invalid. Min: {min} Max: {max}",
+                  "recv(): message mstLen is invalid.",
+                  "msgLen"_attr = msgLen,
+                  "min"_attr = kHeaderSize,
+                  "max"_attr = MaxMessageSizeBytes);
+
+            return Status(ErrorCodes::ProtocolError, str);
+        }
+        return Status::OK();
+    }
+
     Future<Message> sourceMessageImpl(const BatonHandle& baton = nullptr) {
-        static constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+        // The first message of a session is read on its own, because it may turn out to be a TLS
+        // handshake or an HTTP request.
+        if (_readBufferCapacity >= kHeaderSize && _sourcedFirstMessage) {
+            return sourceBufferedMessage(baton);
+        }
 
         auto headerBuffer = SharedBuffer::allocate(kHeaderSize);
         auto ptr = headerBuffer.get();
@@ -415,19 +455,8 @@ private:
                 }
 
                 const auto msgLen = size_t(MSGHEADER::View(headerBuffer.get()).getMessageLength());
-                if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
-                    StringBuilder sb;
-                    sb << "recv(): message msgLen " << msgLen << " is invalid. "
-                       << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
-                    const auto str = sb.str();
-                    LOGV2(4615638,
-                          "recv(): message msgLen {msgLen} is invalid. Min: {min} Max: {max}",
-                          "recv(): message mstLen is invalid.",
-                          "msgLen"_attr = msgLen,
-                          "min"_attr = kHeaderSize,
-                          "max"_attr = MaxMessageSizeBytes);
-
-                    return Future<Message>::makeReady(Status(ErrorCodes::ProtocolError, str));
+                if (auto status = validateMessageLength(msgLen); !status.isOK()) {
+                    return Future<Message>::makeReady(std::move(status));
                 }
 
                 if (msgLen == kHeaderSize) {
@@ -435,6 +464,7 @@ private:
                     if (_isIngressSession) {
                         networkCounter.hitPhysicalIn(msgLen);
                     }
+                    _sourcedFirstMessage = true;
                     return Future<Message>::makeReady(Message(std::move(headerBuffer)));
                 }
 
@@ -447,11 +477,212 @@ private:
                         if (_isIngressSession) {
                             networkCounter.hitPhysicalIn(msgLen);
                         }
+                        _sourcedFirstMessage = true;
                         return Message(std::move(buffer));
                     });
             });
     }
 
+    /**
+     * Reads the next message through the read buffer of the session. Each read asks for as many
+     * bytes as fit in the buffer, so that a client which pipelines small messages gets them all
+     * with a single system call, and a message is read with one system call instead of two.
+     * Messages which don't fit in the buffer are read into their own buffer once their header is
+     * known.
+     */
+    Future<Message> sourceBufferedMessage(const BatonHandle& baton) {
+        while (true) {
+            const auto buffered = _readEnd - _readBegin;
+            if (buffered >= kHeaderSize) {
+                const char* data = _readBuffer.get() + _readBegin;
+                const auto msgLen = size_t(MSGHEADER::ConstView(data).getMessageLength());
+                if (auto status = validateMessageLength(msgLen); !status.isOK()) {
+                    return Future<Message>::makeReady(std::move(status));
+                }
+
+                if (msgLen <= buffered) {
+                    auto buffer = SharedBuffer::allocate(msgLen);
+                    memcpy(buffer.get(), data, msgLen);
+                    _readBegin += msgLen;
+                    if (_readBegin == _readEnd) {
+                        _readBegin = _readEnd = 0;
+                        if (_blockingMode == Sync) {
+                            // The session runs the message before it reads again, which may take
+                            // a while, so it doesn't hold on to the drained buffer meanwhile.
+                            _readBuffer.reset();
+                        }
+                    }
+                    if (_isIngressSession) {
+                        networkCounter.hitPhysicalIn(msgLen);
+                    }
+                    return Future<Message>::makeReady(Message(std::move(buffer)));
+                }
+
+                if (msgLen > _readBufferCapacity) {
+                    // Move what was read of the message into a buffer of its own and read the
+                    // rest directly into it.
+                    auto buffer = SharedBuffer::allocate(msgLen);
+                    memcpy(buffer.get(), data, buffered);
+                    _readBegin = _readEnd = 0;
+
+                    auto ptr = buffer.get();
+                    return read(asio::buffer(ptr + buffered, msgLen - buffered), baton)
+                        .then([this, buffer = std::move(buffer), msgLen]() mutable {
+                            if (_isIngressSession) {
+                                networkCounter.hitPhysicalIn(msgLen);
+                            }
+                            return Message(std::move(buffer));
+                        });
+                }
+            }
+
+            std::error_code ec;
+#ifdef MONGO_CONFIG_SSL
+            if (_sslSocket) {
+                readSomeIntoBuffer(*_sslSocket, ec);
+            } else
+#endif
+            {
+                readSomeIntoBuffer(_socket, ec);
+            }
+
+            if (!ec) {
+                continue;
+            }
+
+            if (((ec == asio::error::would_block) || (ec == asio::error::try_again)) &&
+                (_blockingMode == Async)) {
+#ifdef __linux__
+                if (auto ioUring = ioUringForReactor(baton)) {
+                    return recvIntoBuffer(ioUring).then(
+                        [this, baton] { return sourceBufferedMessage(baton); });
+                }
+#endif
+                // A session whose client sends its next request shortly after the reply keeps
+                // the buffer while it waits, rather than freeing and allocating it again for
+                // every request. Only a session which was idle for a while last time frees it.
+                if (_readBegin == _readEnd && _idleLastReadinessWait) {
+                    _readBuffer.reset();
+                    _readBegin = _readEnd = 0;
+                }
+                const auto waitStart = Date_t::now();
+                return waitForReadable(baton).then([this, baton, waitStart] {
+                    _idleLastReadinessWait =
+                        Date_t::now() - waitStart >= kReadBufferIdleReleaseThreshold;
+                    return sourceBufferedMessage(baton);
+                });
+            }
+
+            return Future<Message>::makeReady(errorCodeToStatus(ec));
+        }
+    }
+
+    /**
+     * Reads as many bytes as are available and fit into the free space of the read buffer, after
+     * moving a partially read message to its start.
+     *
+     * A synchronous session which has consumed all it read blocks until the client sends its next
+     * message, which for an idle session may take arbitrarily long. It waits for the start of the
+     * message in a header sized buffer instead, and only allocates the read buffer once the client
+     * has sent something.
+     */
+    template <typename Stream>
+    void readSomeIntoBuffer(Stream& stream, std::error_code& ec) {
+        if (_blockingMode == Sync && _readBegin == _readEnd) {
+            _readBuffer.reset();
+            _readBegin = _readEnd = 0;
+
+            char header[kHeaderSize];
+            size_t size;
+            do {
+                size = stream.read_some(asio::buffer(header, kHeaderSize), ec);
+            } while (ec == asio::error::interrupted);  // retry syscall EINTR
+            if (size > 0) {
+                _readBuffer = std::make_unique<char[]>(_readBufferCapacity);
+                memcpy(_readBuffer.get(), header, size);
+                _readEnd = size;
+            }
+            return;
+        }
+
+        if (!_readBuffer) {
+            _readBuffer = std::make_unique<char[]>(_readBufferCapacity);
+        }
+        if (_readBegin > 0) {
+            memmove(_readBuffer.get(), _readBuffer.get() + _readBegin, _readEnd - _readBegin);
+            _readEnd -= _readBegin;
+            _readBegin = 0;
+        }
+
+        auto freeSpace = asio::buffer(_readBuffer.get() + _readEnd, _readBufferCapacity - _readEnd);
+        if (MONGO_unlikely(transportLayerASIOshortOpportunisticReadWrite.shouldFail()) &&
+            _blockingMode == Async) {
+            freeSpace = asio::buffer(freeSpace.data(), 1);
+        }
+
+        size_t size;
+        do {
+            size = stream.read_some(freeSpace, ec);
+        } while (ec == asio::error::interrupted);  // retry syscall EINTR
+        _readEnd += size;
+    }
+
+#ifdef __linux__
+    /**
+     * Returns the io_uring service to wait for a plain socket with, if the session isn't waiting
+     * through the networking baton and its reactor runs on the io_uring backend.
+     */
+    IOUringService* ioUringForReactor(const BatonHandle& baton) {
+#ifdef MONGO_CONFIG_SSL
+        if (_sslSocket) {
+            return nullptr;
+        }
+#endif
+        if (auto networkingBaton = baton ? baton->networking() : nullptr;
+            networkingBaton && networkingBaton->canWait()) {
+            return nullptr;
+        }
+        return _ioUring;
+    }
+
+    /**
+     * Receives into the free space of the read buffer through io_uring. The session stays alive
+     * until the kernel is done with its buffer.
+     */
+    Future<void> recvIntoBuffer(IOUringService* ioUring) {
+        if (!_readBuffer) {
+            _readBuffer = std::make_unique<char[]>(_readBufferCapacity);
+        }
+        auto freeSpace = asio::buffer(_readBuffer.get() + _readEnd, _readBufferCapacity - _readEnd);
+        return ioUring->recvSome(getSocket().native_handle(), freeSpace)
+            .then([this, self = shared_from_this()](size_t size) { _readEnd += size; });
+    }
+#endif
+
+    /**
+     * Waits until the socket is readable, either through the networking baton or on the reactor.
+     */
+    Future<void> waitForReadable(const BatonHandle& baton) {
+        if (auto networkingBaton = baton ? baton->networking() : nullptr;
+            networkingBaton && networkingBaton->canWait()) {
+            return networkingBaton->addSession(*this, NetworkingBaton::Type::In)
+                .onError([this](Status error) {
+                    if (ErrorCodes::isShutdownError(error)) {
+                        // The baton detached and canceled its polling. Wait on the reactor
+                        // instead.
+                        return waitForReadable(nullptr);
+                    }
+                    return Future<void>::makeReady(std::move(error));
+                });
+        }
+
+#ifdef MONGO_CONFIG_SSL
+        if (_sslSocket)
+            return asio::async_read(*_sslSocket, asio::null_buffers(), UseFuture{}).ignoreValue();
+#endif
+        return asio::async_read(_socket, asio::null_buffers(), UseFuture{}).ignoreValue();
+    }
+
     template <typename MutableBufferSequence>
     Future<void> read(const MutableBufferSequence& buffers, const BatonHandle& baton = nullptr) {
         // TODO SERVER-47229 Guard active ops for cancelation here.
@@ -558,6 +789,16 @@ private:
                     });
             }
 
+#ifdef __linux__
+            if constexpr (std::is_same_v<Stream, GenericSocket>) {
+                if (_ioUring) {
+                    // The session stays alive until the kernel is done with its buffers.
+                    return _ioUring->recvAll(stream.native_handle(), asyncBuffers)
+                        .then([self = shared_from_this()] {});
+                }
+            }
+#endif
+
             return asio::async_read(stream, asyncBuffers, UseFuture{}).ignoreValue();
         } else {
             return futurize(ec);
@@ -660,6 +901,16 @@ private:
                     });
             }
 
+#ifdef __linux__
+            if constexpr (std::is_same_v<Stream, GenericSocket>) {
+                if (_ioUring) {
+                    // The session stays alive until the kernel is done with its buffers.
+                    return _ioUring->sendAll(stream.native_handle(), asyncBuffers)
+                        .then([self = shared_from_this()] {});
+                }
+            }
+#endif
+
             return asio::async_write(stream, asyncBuffers, UseFuture{}).ignoreValue();
         } else {
             return futurize(ec);
@@ -811,7 +1062,25 @@ private:
     boost::optional<Milliseconds> _configuredTimeout;
     boost::optional<Milliseconds> _socketTimeout;
 
+    // How long an asynchronous session must have waited for its socket to become readable to
+    // free its read buffer during the next wait.
+    static constexpr Milliseconds kReadBufferIdleReleaseThreshold{1000};
+
+    // The buffer messages are read through, and the range of it which holds bytes not consumed
+    // yet. A synchronous session releases the buffer as soon as it is drained. An asynchronous
+    // session keeps it while it waits for data, unless it was idle during its last wait.
+    const size_t _readBufferCapacity = static_cast<size_t>(gSessionReadBufferSizeBytes);
+    std::unique_ptr<char[]> _readBuffer;
+    size_t _readBegin = 0;
+    size_t _readEnd = 0;
+    bool _sourcedFirstMessage = false;
+    bool _idleLastReadinessWait = false;
+
     GenericSocket _socket;
+#ifdef __linux__
+    // Set once the session is in asynchronous mode, if its reactor runs on io_uring.
+    IOUringService* _ioUring = nullptr;
+#endif
 #ifdef MONGO_CONFIG_SSL
     boost::optional<asio::ssl::stream<decltype(_socket)>> _sslSocket;
     bool _ranHandshake = false;
@@ -0,0 +1,257 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/server_options.h"
+#include "mongo/rpc/message.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/transport_layer_asio.h"
+#include "mongo/transport/transport_options_gen.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/future.h"
+#include "mongo/util/net/hostandport.h"
+#include "mongo/util/net/sock.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Echoes every message a session receives back to the client, from a thread of its own and with
+ * the synchronous session API.
+ */
+class EchoServiceEntryPoint : public ServiceEntryPoint {
+public:
+    ~EchoServiceEntryPoint() override {
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+    }
+
+    void startSession(transport::SessionHandle session) override {
+        _threads.emplace_back([session = std::move(session)] {
+            while (true) {
+                auto swMessage = session->sourceMessage();
+                if (!swMessage.isOK() || !session->sinkMessage(swMessage.getValue()).isOK()) {
+                    break;
+                }
+            }
+            session->end();
+        });
+    }
+
+    void endAllSessions(transport::Session::TagMask tags) override {}
+
+    Status start() override {
+        return Status::OK();
+    }
+
+    bool shutdown(Milliseconds timeout) override {
+        return true;
+    }
+
+    void appendStats(BSONObjBuilder*) const override {}
+
+    size_t numOpenSessions() const override {
+        return 0;
+    }
+
+    Future<DbResponse> handleRequest(OperationContext* opCtx,
+                                     const Message& request) noexcept override {
+        MONGO_UNREACHABLE;
+    }
+
+private:
+    std::vector<stdx::thread> _threads;
+};
+
+/**
+ * Sends batches of 'state.range(1)' pipelined messages of 'state.range(2)' bytes each over a
+ * loopback connection and waits for all of them to be echoed back. 'state.range(0)' is the value
+ * of the 'sessionReadBufferSizeBytes' server parameter, where 0 reads each message with separate
+ * reads of its header and body.
+ */
+void BM_PipelinedEcho(benchmark::State& state) {
+    const auto savedBufferSize = transport::gSessionReadBufferSizeBytes;
+    transport::gSessionReadBufferSizeBytes = state.range(0);
+    const auto batchSize = state.range(1);
+    const auto messageSize = state.range(2);
+
+    EchoServiceEntryPoint sep;
+    {
+        ServerGlobalParams params;
+        params.noUnixSocket = true;
+        transport::TransportLayerASIO::Options opts(&params);
+        opts.port = 0;
+
+        transport::TransportLayerASIO tla(opts, &sep);
+        invariant(tla.setup());
+        invariant(tla.start());
+
+        Socket client;
+        SockAddr addr{"localhost", tla.listenerPort(), AF_INET};
+        invariant(client.connect(addr));
+
+        std::vector<char> request(batchSize * messageSize);
+        for (int64_t i = 0; i < batchSize; ++i) {
+            MsgData::View msg(request.data() + i * messageSize);
+            msg.setLen(messageSize);
+            msg.setId(i);
+            msg.setResponseToMsgId(0);
+            msg.setOperation(dbMsg);
+        }
+        std::vector<char> response(request.size());
+
+        // The first message of a session always skips the read buffer.
+        client.send(request.data(), messageSize, "BM_PipelinedEcho");
+        client.recv(response.data(), messageSize);
+
+        for (auto _ : state) {
+            client.send(request.data(), request.size(), "BM_PipelinedEcho");
+            client.recv(response.data(), response.size());
+        }
+
+        client.close();
+        tla.shutdown();
+    }
+
+    transport::gSessionReadBufferSizeBytes = savedBufferSize;
+    state.SetItemsProcessed(state.iterations() * batchSize);
+    state.SetBytesProcessed(state.iterations() * batchSize * messageSize);
+}
+
+void pipelinedEchoArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"bufferSize", "batch", "msgSize"});
+    for (int bufferSize : {0, 16384}) {
+        for (int batchSize : {1, 16, 64}) {
+            for (int messageSize : {64, 1024}) {
+                b->Args({bufferSize, batchSize, messageSize});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_PipelinedEcho)->Apply(pipelinedEchoArgs)->UseRealTime();
+
+/**
+ * Sends a message of 'state.range(2)' bytes on each of 'state.range(1)' loopback connections at
+ * once, from an egress transport layer in asynchronous mode, and waits for all of them to be
+ * echoed back. 'state.range(0)' selects the reactor backend of both transport layers, 0 for epoll
+ * and 1 for io_uring, which covers the reads and writes of the client and the accepts of the
+ * server.
+ */
+void BM_AsyncEcho(benchmark::State& state) {
+    const auto savedBackend = transport::gASIOReactorBackend;
+    transport::gASIOReactorBackend = state.range(0) ? "io_uring" : "epoll";
+    const auto numConnections = state.range(1);
+    const auto messageSize = state.range(2);
+
+    EchoServiceEntryPoint sep;
+    {
+        ServerGlobalParams params;
+        params.noUnixSocket = true;
+        transport::TransportLayerASIO::Options serverOpts(&params);
+        serverOpts.port = 0;
+
+        transport::TransportLayerASIO server(serverOpts, &sep);
+        invariant(server.setup());
+        invariant(server.start());
+
+        transport::TransportLayerASIO::Options clientOpts;
+        clientOpts.mode = transport::TransportLayerASIO::Options::kEgress;
+        transport::TransportLayerASIO client(clientOpts, nullptr);
+        invariant(client.setup());
+        invariant(client.start());
+
+        auto reactor = client.getReactor(transport::TransportLayer::kNewReactor);
+        stdx::thread reactorThread([&] { reactor->run(); });
+
+        std::vector<transport::SessionHandle> sessions;
+        for (int64_t i = 0; i < numConnections; ++i) {
+            sessions.push_back(client
+                                   .asyncConnect(HostAndPort("localhost", server.listenerPort()),
+                                                 transport::kDisableSSL,
+                                                 reactor,
+                                                 Seconds(10))
+                                   .get());
+        }
+
+        auto buffer = SharedBuffer::allocate(messageSize);
+        MsgData::View msg(buffer.get());
+        msg.setLen(messageSize);
+        msg.setId(0);
+        msg.setResponseToMsgId(0);
+        msg.setOperation(dbMsg);
+        const Message request(std::move(buffer));
+
+        for (auto _ : state) {
+            std::vector<Future<Message>> responses;
+            responses.reserve(sessions.size());
+            for (auto& session : sessions) {
+                responses.push_back(session->asyncSinkMessage(request).then(
+                    [session] { return session->asyncSourceMessage(); }));
+            }
+            for (auto& response : responses) {
+                response.get();
+            }
+        }
+
+        for (auto& session : sessions) {
+            session->end();
+        }
+        sessions.clear();
+
+        reactor->stop();
+        reactorThread.join();
+        client.shutdown();
+        server.shutdown();
+    }
+
+    transport::gASIOReactorBackend = savedBackend;
+    state.SetItemsProcessed(state.iterations() * numConnections);
+}
+
+void asyncEchoArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"ioUring", "connections", "msgSize"});
+    for (int ioUring : {0, 1}) {
+        for (int numConnections : {1, 16, 256}) {
+            for (int messageSize : {64, 4096}) {
+                b->Args({ioUring, numConnections, messageSize});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_AsyncEcho)->Apply(asyncEchoArgs)->UseRealTime();
+
+}  // namespace
+}  // namespace mongo
@@ -174,7 +174,17 @@ private:
 
 class TransportLayerASIO::ASIOReactor final : public Reactor {
 public:
-    ASIOReactor() : _ioContext() {}
+    explicit ASIOReactor(ReactorBackend backend) : _ioContext() {
+#ifdef __linux__
+        if (backend == ReactorBackend::kIOUring) {
+            if (auto status = IOUringService::install(_ioContext); !status.isOK()) {
+                LOGV2_WARNING(5150830,
+                              "Cannot set up io_uring for a reactor, it will use epoll instead",
+                              "error"_attr = status);
+            }
+        }
+#endif
+    }
 
     void run() noexcept override {
         ThreadIdGuard threadIdGuard(this);
@@ -247,6 +257,36 @@ private:
 thread_local TransportLayerASIO::ASIOReactor* TransportLayerASIO::ASIOReactor::_reactorForThread =
     nullptr;
 
+Status validateASIOReactorBackend(const std::string& value) {
+    if (value != "epoll" && value != "io_uring") {
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "Unknown reactor backend '" << value
+                                    << "', expected 'epoll' or 'io_uring'");
+    }
+    return Status::OK();
+}
+
+TransportLayerASIO::ReactorBackend TransportLayerASIO::_selectReactorBackend() {
+    if (gASIOReactorBackend != "io_uring") {
+        return ReactorBackend::kEpoll;
+    }
+
+#ifdef __linux__
+    auto status = IOUringService::probe();
+#else
+    auto status = Status(ErrorCodes::OperationFailed, "io_uring is only available on Linux");
+#endif
+    if (!status.isOK()) {
+        LOGV2_WARNING(5150831,
+                      "The io_uring reactor backend is not available, using epoll instead",
+                      "error"_attr = status);
+        return ReactorBackend::kEpoll;
+    }
+
+    LOGV2(5150832, "Using the io_uring reactor backend");
+    return ReactorBackend::kIOUring;
+}
+
 TransportLayerASIO::Options::Options(const ServerGlobalParams* params)
     : port(params->port),
       ipList(params->bind_ips),
@@ -261,9 +301,10 @@ TransportLayerASIO::TransportLayerASIO(const TransportLayerASIO::Options& opts,
                                        ServiceEntryPoint* sep,
                                        const WireSpec& wireSpec)
     : TransportLayer(wireSpec),
-      _ingressReactor(std::make_shared<ASIOReactor>()),
-      _egressReactor(std::make_shared<ASIOReactor>()),
-      _acceptorReactor(std::make_shared<ASIOReactor>()),
+      _reactorBackend(_selectReactorBackend()),
+      _ingressReactor(std::make_shared<ASIOReactor>(_reactorBackend)),
+      _egressReactor(std::make_shared<ASIOReactor>(_reactorBackend)),
+      _acceptorReactor(std::make_shared<ASIOReactor>(_reactorBackend)),
       _sep(sep),
       _listenerOptions(opts) {}
 
@@ -1058,6 +1099,11 @@ void TransportLayerASIO::_runListener() noexcept {
     // connections from being opened.
     for (auto& acceptor : _acceptors) {
         acceptor.second.cancel();
+#ifdef __linux__
+        if (auto ioUring = IOUringService::get(*_acceptorReactor)) {
+            ioUring->cancel(acceptor.second.native_handle());
+        }
+#endif
         auto& addr = acceptor.first;
         if (addr.getType() == AF_UNIX && !addr.isAnonymousUNIXSocket()) {
             auto path = addr.getAddr();
@@ -1129,7 +1175,7 @@ ReactorHandle TransportLayerASIO::getReactor(WhichReactor which) {
         case TransportLayer::kEgress:
             return _egressReactor;
         case TransportLayer::kNewReactor:
-            return std::make_shared<ASIOReactor>();
+            return std::make_shared<ASIOReactor>(_reactorBackend);
     }
 
     MONGO_UNREACHABLE;
@@ -1174,6 +1220,29 @@ void TransportLayerASIO::_acceptConnection(GenericAcceptor& acceptor) {
         _acceptConnection(acceptor);
     };
 
+#ifdef __linux__
+    if (auto ioUring = IOUringService::get(*_acceptorReactor)) {
+        ioUring->accept(acceptor.native_handle(),
+                        [this, &acceptor, acceptCb = std::move(acceptCb)](int result) mutable {
+                            std::error_code ec;
+                            GenericSocket peerSocket(*_ingressReactor);
+                            if (result < 0) {
+                                ec = std::error_code(-result, std::system_category());
+                            } else {
+                                auto endpoint = acceptor.local_endpoint(ec);
+                                if (!ec) {
+                                    peerSocket.assign(endpoint.protocol(), result, ec);
+                                }
+                                if (ec) {
+                                    ::close(result);
+                                }
+                            }
+                            acceptCb(ec, std::move(peerSocket));
+                        });
+        return;
+    }
+#endif
+
     acceptor.async_accept(*_ingressReactor, std::move(acceptCb));
 }
 
@@ -76,6 +76,11 @@ extern FailPoint transportLayerASIOshortOpportunisticReadWrite;
 // to the remote peer
 extern FailPoint transportLayerASIOasyncConnectTimesOut;
 
+/**
+ * Validates the asioReactorBackend server parameter.
+ */
+Status validateASIOReactorBackend(const std::string& value);
+
 /**
  * A TransportLayer implementation based on ASIO networking primitives.
  */
@@ -159,6 +164,10 @@ private:
     class ASIOSession;
     class ASIOReactor;
 
+    enum class ReactorBackend { kEpoll, kIOUring };
+
+    static ReactorBackend _selectReactorBackend();
+
     using ASIOSessionHandle = std::shared_ptr<ASIOSession>;
     using ConstASIOSessionHandle = std::shared_ptr<const ASIOSession>;
     using GenericAcceptor = asio::basic_socket_acceptor<asio::generic::stream_protocol>;
@@ -200,6 +209,10 @@ private:
     // state that is associated with the reactors), so that we destroy any existing acceptors or
     // other reactor associated state before we drop the refcount on the reactor, which may destroy
     // it.
+    //
+    // On the io_uring backend, every reactor issues accepts, receives and sends through an
+    // io_uring instance of its own, see IOUringService.
+    const ReactorBackend _reactorBackend;
     std::shared_ptr<ASIOReactor> _ingressReactor;
     std::shared_ptr<ASIOReactor> _egressReactor;
     std::shared_ptr<ASIOReactor> _acceptorReactor;
@@ -35,10 +35,15 @@
 #include "mongo/db/server_options.h"
 #include "mongo/logv2/log.h"
 #include "mongo/rpc/op_msg.h"
+#ifdef __linux__
+#include "mongo/transport/io_uring_linux.h"
+#endif
 #include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/transport_options_gen.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/net/sock.h"
+#include "mongo/util/scopeguard.h"
 
 #include "asio.hpp"
 
@@ -93,6 +98,15 @@ public:
         _cv.wait(lock, [&] { return !_sessions.empty(); });
     }
 
+    /**
+     * Waits for a connection and returns its session.
+     */
+    transport::SessionHandle waitForSession() {
+        stdx::unique_lock<Latch> lock(_mutex);
+        _cv.wait(lock, [&] { return !_sessions.empty(); });
+        return _sessions.front();
+    }
+
 private:
     mutable Mutex _mutex = MONGO_MAKE_LATCH("::_mutex");
     stdx::condition_variable _cv;
@@ -163,6 +177,50 @@ TEST(TransportLayerASIO, PortZeroConnect) {
     tla.shutdown();
 }
 
+TEST(TransportLayerASIO, ValidateReactorBackend) {
+    ASSERT_OK(transport::validateASIOReactorBackend("epoll"));
+    ASSERT_OK(transport::validateASIOReactorBackend("io_uring"));
+    ASSERT_EQ(transport::validateASIOReactorBackend("kqueue"), ErrorCodes::BadValue);
+}
+
+// Accepts through io_uring where the kernel supports it, and through epoll otherwise. The
+// IOUringService itself is tested in io_uring_linux_test.cpp.
+TEST(TransportLayerASIO, IOUringBackendConnect) {
+    const auto savedBackend = transport::gASIOReactorBackend;
+    transport::gASIOReactorBackend = "io_uring";
+    ON_BLOCK_EXIT([&] { transport::gASIOReactorBackend = savedBackend; });
+
+    ServiceEntryPointUtil sepu;
+
+    ServerGlobalParams params;
+    params.noUnixSocket = true;
+    transport::TransportLayerASIO::Options options(&params);
+    options.port = 0;
+
+    startCapturingLogMessages();
+    transport::TransportLayerASIO tla(options, &sepu);
+    sepu.setTransportLayer(&tla);
+    stopCapturingLogMessages();
+
+#ifdef __linux__
+    // The reactors set up their rings, rather than falling back to epoll, when io_uring is
+    // available.
+    if (transport::IOUringService::probe().isOK()) {
+        ASSERT_EQ(1, countBSONFormatLogLinesIsSubset(BSON("id" << 5150832)));
+        ASSERT_EQ(0, countBSONFormatLogLinesIsSubset(BSON("id" << 5150830)));
+    }
+#endif
+
+    ASSERT_OK(tla.setup());
+    ASSERT_OK(tla.start());
+
+    SimpleConnectionThread connect_thread(tla.listenerPort());
+    sepu.waitForConnect();
+    connect_thread.stop();
+    sepu.endAllSessions({});
+    tla.shutdown();
+}
+
 class TimeoutSEP : public ServiceEntryPoint {
 public:
     ~TimeoutSEP() override {
@@ -386,5 +444,181 @@ TEST(TransportLayerASIO, SwitchTimeoutModes) {
     tla->shutdown();
 }
 
+/**
+ * A client which writes raw bytes to a session of the transport layer, which the test sources
+ * messages from itself, to check how the session frames them.
+ */
+class FramingTest : public unittest::Test {
+public:
+    void setUp() override {
+        _tla = makeAndStartTL(&_sep);
+        _sep.setTransportLayer(_tla.get());
+
+        std::error_code ec;
+        _sock.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(),
+                                              _tla->listenerPort()),
+                      ec);
+        ASSERT_EQ(ec, std::error_code());
+        _session = _sep.waitForSession();
+
+        // The first message of a session is read on its own, so get it out of the way.
+        send(makeMessage(0));
+        ASSERT_EQ(sourceMessage().getValue().header().getId(), 0);
+    }
+
+    void tearDown() override {
+        _session.reset();
+        _sep.endAllSessions({});
+        _tla->shutdown();
+    }
+
+    /**
+     * Returns the bytes of a message with id 'id', whose body is padded to make the message at
+     * least 'minSize' bytes long.
+     */
+    static std::string makeMessage(int32_t id, size_t minSize = 0) {
+        OpMsgBuilder builder;
+        builder.setBody(BSON("ping" << 1 << "padding" << std::string(minSize, 'x')));
+        Message msg = builder.finish();
+        msg.header().setResponseToMsgId(0);
+        msg.header().setId(id);
+        return std::string(msg.buf(), msg.size());
+    }
+
+    void send(const std::string& bytes) {
+        std::error_code ec;
+        asio::write(_sock, asio::buffer(bytes), ec);
+        ASSERT_FALSE(ec);
+    }
+
+    StatusWith<Message> sourceMessage() {
+        return _session->sourceMessage();
+    }
+
+    transport::TransportLayerASIO& tla() {
+        return *_tla;
+    }
+
+    transport::Session& session() {
+        return *_session;
+    }
+
+private:
+    ServiceEntryPointUtil _sep;
+    std::unique_ptr<transport::TransportLayerASIO> _tla;
+    asio::io_context _ctx;
+    asio::ip::tcp::socket _sock{_ctx};
+    transport::SessionHandle _session;
+};
+
+TEST_F(FramingTest, PipelinedMessagesInOneRead) {
+    send(makeMessage(1) + makeMessage(2) + makeMessage(3));
+    for (int32_t id = 1; id <= 3; ++id) {
+        auto swMsg = sourceMessage();
+        ASSERT_OK(swMsg.getStatus());
+        ASSERT_EQ(swMsg.getValue().header().getId(), id);
+    }
+}
+
+TEST_F(FramingTest, HeaderSplitAcrossReads) {
+    const auto bytes = makeMessage(1) + makeMessage(2);
+    stdx::thread client([&] {
+        // Split the first header, and then the second header, over separate writes.
+        const auto firstSize = bytes.size() / 2 - 4;
+        for (auto [begin, end] : {std::pair<size_t, size_t>{0, 6},
+                                  {6, firstSize + 10},
+                                  {firstSize + 10, bytes.size()}}) {
+            send(bytes.substr(begin, end - begin));
+            sleepmillis(50);
+        }
+    });
+    ON_BLOCK_EXIT([&] { client.join(); });
+
+    for (int32_t id = 1; id <= 2; ++id) {
+        auto swMsg = sourceMessage();
+        ASSERT_OK(swMsg.getStatus());
+        ASSERT_EQ(swMsg.getValue().header().getId(), id);
+    }
+}
+
+TEST_F(FramingTest, MessageLargerThanBuffer) {
+    const auto bufferSize = static_cast<size_t>(transport::gSessionReadBufferSizeBytes);
+    const auto large = makeMessage(1, 4 * bufferSize);
+    send(large + makeMessage(2));
+
+    auto swMsg = sourceMessage();
+    ASSERT_OK(swMsg.getStatus());
+    const auto& msg = swMsg.getValue();
+    ASSERT_EQ(msg.header().getId(), 1);
+    ASSERT_EQ(static_cast<size_t>(msg.size()), large.size());
+    ASSERT_EQ(0, memcmp(msg.buf(), large.data(), large.size()));
+
+    swMsg = sourceMessage();
+    ASSERT_OK(swMsg.getStatus());
+    ASSERT_EQ(swMsg.getValue().header().getId(), 2);
+}
+
+TEST_F(FramingTest, MessageLengthTooSmall) {
+    auto bytes = makeMessage(1);
+    MSGHEADER::View(&bytes[0]).setMessageLength(4);
+    send(makeMessage(2) + bytes);
+
+    ASSERT_EQ(sourceMessage().getValue().header().getId(), 2);
+    ASSERT_EQ(sourceMessage().getStatus(), ErrorCodes::ProtocolError);
+}
+
+TEST_F(FramingTest, MessageLengthTooLarge) {
+    auto bytes = makeMessage(1);
+    MSGHEADER::View(&bytes[0]).setMessageLength(MaxMessageSizeBytes + 1);
+    send(bytes);
+
+    ASSERT_EQ(sourceMessage().getStatus(), ErrorCodes::ProtocolError);
+}
+
+TEST_F(FramingTest, SyncSessionWaitsWhileIdle) {
+    // The session drains its buffer, and then blocks for the next message while it holds none.
+    send(makeMessage(1));
+    ASSERT_EQ(sourceMessage().getValue().header().getId(), 1);
+
+    stdx::thread client([&] {
+        sleepmillis(100);
+        send(makeMessage(2) + makeMessage(3));
+    });
+    ON_BLOCK_EXIT([&] { client.join(); });
+
+    for (int32_t id = 2; id <= 3; ++id) {
+        auto swMsg = sourceMessage();
+        ASSERT_OK(swMsg.getStatus());
+        ASSERT_EQ(swMsg.getValue().header().getId(), id);
+    }
+}
+
+TEST_F(FramingTest, AsyncSessionWaitsForEachMessage) {
+    auto reactor = tla().getReactor(transport::TransportLayer::kIngress);
+    stdx::thread reactorThread([&] { reactor->run(); });
+    ON_BLOCK_EXIT([&] {
+        reactor->stop();
+        reactorThread.join();
+    });
+
+    // Each message arrives after the session started waiting for it, the second one in pieces.
+    for (int32_t id = 1; id <= 3; ++id) {
+        auto future = session().asyncSourceMessage();
+        sleepmillis(50);
+        const auto bytes = makeMessage(id);
+        if (id == 2) {
+            send(bytes.substr(0, 10));
+            sleepmillis(50);
+            send(bytes.substr(10));
+        } else {
+            send(bytes);
+        }
+
+        auto swMsg = future.getNoThrow();
+        ASSERT_OK(swMsg.getStatus());
+        ASSERT_EQ(swMsg.getValue().header().getId(), id);
+    }
+}
+
 }  // namespace
 }  // namespace mongo
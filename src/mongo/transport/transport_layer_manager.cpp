@@ -42,7 +42,9 @@
 #include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/logv2/log.h"
+#include "mongo/transport/service_executor_gen.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_thread_per_core.h"
 #include "mongo/transport/session.h"
 #include "mongo/transport/transport_layer_asio.h"
 #include "mongo/util/net/ssl_types.h"
@@ -134,9 +136,22 @@ std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
     auto sep = ctx->getServiceEntryPoint();
 
     transport::TransportLayerASIO::Options opts(config);
-    opts.transportMode = transport::Mode::kSynchronous;
 
-    ctx->setServiceExecutor(std::make_unique<ServiceExecutorSynchronous>(ctx));
+    auto useThreadPerCore = useThreadPerCoreServiceExecutor;
+    if (useThreadPerCore && !ServiceExecutorThreadPerCore::isSupported()) {
+        LOGV2_WARNING(5150836,
+                      "The thread-per-core service executor is not supported on this platform, "
+                      "using a thread per connection instead");
+        useThreadPerCore = false;
+    }
+
+    if (useThreadPerCore) {
+        opts.transportMode = transport::Mode::kAsynchronous;
+        ctx->setServiceExecutor(std::make_unique<ServiceExecutorThreadPerCore>(ctx));
+    } else {
+        opts.transportMode = transport::Mode::kSynchronous;
+        ctx->setServiceExecutor(std::make_unique<ServiceExecutorSynchronous>(ctx));
+    }
 
     std::vector<std::unique_ptr<TransportLayer>> retVector;
     retVector.emplace_back(std::make_unique<transport::TransportLayerASIO>(opts, sep));
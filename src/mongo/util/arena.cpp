@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+thread_local Arena* currentArena = nullptr;
+
+// Precedes every ArenaAllocatable object and records where its memory came from. The alignment
+// keeps the object itself suitably aligned for any type.
+struct alignas(std::max_align_t) AllocationHeader {
+    Arena* arena;
+};
+
+char* alignUp(char* ptr, size_t alignment) {
+    auto addr = reinterpret_cast<uintptr_t>(ptr);
+    return ptr + ((alignment - (addr & (alignment - 1))) & (alignment - 1));
+}
+
+}  // namespace
+
+Arena::~Arena() {
+    while (_blocks) {
+        auto next = _blocks->next;
+        ::operator delete(_blocks);
+        _blocks = next;
+    }
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    dassert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    ++_stats.allocations;
+    _stats.bytesAllocated += bytes;
+
+    if (_cursor) {
+        auto ptr = alignUp(_cursor, alignment);
+        if (ptr + bytes <= _end) {
+            _cursor = ptr + bytes;
+            return ptr;
+        }
+    }
+
+    const size_t needed = bytes + alignment - 1;
+    if (needed > _nextBlockSize) {
+        // Give the request a block of its own and keep carving from the current one.
+        return alignUp(_allocateBlock(needed), alignment);
+    }
+
+    _cursor = _allocateBlock(_nextBlockSize);
+    _end = _cursor + _nextBlockSize;
+    _nextBlockSize = std::min(_nextBlockSize * 2, kMaxBlockSize);
+
+    auto ptr = alignUp(_cursor, alignment);
+    _cursor = ptr + bytes;
+    return ptr;
+}
+
+char* Arena::_allocateBlock(size_t size) {
+    auto block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+    block->next = _blocks;
+    block->size = size;
+    _blocks = block;
+
+    ++_stats.blocks;
+    _stats.bytesReserved += size;
+    return reinterpret_cast<char*>(block + 1);
+}
+
+ArenaScope::ArenaScope(Arena* arena) : _previous(currentArena) {
+    currentArena = arena;
+}
+
+ArenaScope::~ArenaScope() {
+    currentArena = _previous;
+}
+
+Arena* ArenaScope::current() {
+    return currentArena;
+}
+
+void* ArenaAllocatable::operator new(size_t size) {
+    auto arena = currentArena;
+    void* mem = arena ? arena->allocate(sizeof(AllocationHeader) + size, alignof(AllocationHeader))
+                      : ::operator new(sizeof(AllocationHeader) + size);
+    if (arena) {
+        intrusive_ptr_add_ref(arena);
+    }
+    auto header = new (mem) AllocationHeader{arena};
+    return header + 1;
+}
+
+void ArenaAllocatable::operator delete(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    auto header = static_cast<AllocationHeader*>(ptr) - 1;
+    if (auto arena = header->arena) {
+        intrusive_ptr_release(arena);
+    } else {
+        ::operator delete(header);
+    }
+}
+
+}  // namespace mongo
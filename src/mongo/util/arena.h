@@ -0,0 +1,132 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/util/intrusive_counter.h"
+
+namespace mongo {
+
+/**
+ * A monotonic allocator for objects which are built together and die together, such as the
+ * parsed and planned representation of a single query. Memory is carved out of a chain of blocks
+ * which grow geometrically; individual allocations are never returned to the heap, and all the
+ * blocks are freed at once when the arena is destroyed.
+ *
+ * Arenas are reference counted. Besides their owner, every object placed in an arena through
+ * ArenaAllocatable holds a reference, so the blocks outlive the owner for as long as any such
+ * object is alive.
+ *
+ * allocate() is not thread-safe. Objects placed in the arena may be destroyed on any thread.
+ */
+class Arena : public RefCountable {
+public:
+    static constexpr size_t kInitialBlockSize = 4 * 1024;
+    static constexpr size_t kMaxBlockSize = 64 * 1024;
+
+    struct Stats {
+        // The number of calls to allocate() and the total number of bytes they requested.
+        size_t allocations{0};
+        size_t bytesAllocated{0};
+
+        // The number of blocks obtained from the heap and their total size.
+        size_t blocks{0};
+        size_t bytesReserved{0};
+    };
+
+    Arena() = default;
+    ~Arena();
+
+    /**
+     * Returns 'bytes' bytes of uninitialized memory aligned to 'alignment', which must be a power
+     * of two. Requests which are larger than the next block get a block of their own, so that they
+     * don't waste the remainder of the current one.
+     */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    const Stats& stats() const {
+        return _stats;
+    }
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+
+    char* _allocateBlock(size_t size);
+
+    Block* _blocks{nullptr};
+    char* _cursor{nullptr};
+    char* _end{nullptr};
+    size_t _nextBlockSize{kInitialBlockSize};
+    Stats _stats;
+};
+
+/**
+ * Installs 'arena' as the arena that ArenaAllocatable objects created on this thread are placed
+ * in, until the scope is destroyed. Scopes nest; a null 'arena' sends allocations back to the
+ * heap for the duration of the scope.
+ */
+class ArenaScope {
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+public:
+    explicit ArenaScope(Arena* arena);
+    ~ArenaScope();
+
+    /**
+     * Returns the arena installed on this thread, or nullptr if there is none.
+     */
+    static Arena* current();
+
+private:
+    Arena* const _previous;
+};
+
+/**
+ * Base class for types whose instances should be placed in the current thread's arena, if any,
+ * when created with 'new'. Deleting such an object runs its destructor as usual, but only returns
+ * its memory to the heap if it was not created inside an ArenaScope.
+ */
+class ArenaAllocatable {
+public:
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
+
+protected:
+    ArenaAllocatable() = default;
+    ~ArenaAllocatable() = default;
+};
+
+}  // namespace mongo
@@ -0,0 +1,180 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/arena.h"
+
+namespace mongo {
+namespace {
+
+bool isAligned(const void* ptr, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+class Tracked : public ArenaAllocatable {
+public:
+    explicit Tracked(int* liveCount) : _liveCount(liveCount) {
+        ++*_liveCount;
+    }
+    virtual ~Tracked() {
+        --*_liveCount;
+    }
+
+private:
+    int* _liveCount;
+};
+
+class TrackedWithPayload : public Tracked {
+public:
+    using Tracked::Tracked;
+
+    std::string payload = "a string which is too long for the small string optimization";
+};
+
+TEST(ArenaTest, SmallAllocationsShareBlocks) {
+    Arena arena;
+    for (int i = 0; i < 100; ++i) {
+        auto ptr = arena.allocate(24);
+        ASSERT(isAligned(ptr, alignof(std::max_align_t)));
+    }
+    ASSERT_EQ(arena.stats().allocations, 100U);
+    ASSERT_EQ(arena.stats().bytesAllocated, 2400U);
+    ASSERT_EQ(arena.stats().blocks, 1U);
+    ASSERT_EQ(arena.stats().bytesReserved, Arena::kInitialBlockSize);
+}
+
+TEST(ArenaTest, HonorsRequestedAlignment) {
+    Arena arena;
+    arena.allocate(1, 1);
+    ASSERT(isAligned(arena.allocate(8, 64), 64));
+    arena.allocate(3, 1);
+    ASSERT(isAligned(arena.allocate(4, 4), 4));
+}
+
+TEST(ArenaTest, BlocksGrowGeometricallyUpToTheMaximum) {
+    Arena arena;
+    size_t expectedReserved = 0;
+    size_t blockSize = Arena::kInitialBlockSize;
+    for (size_t blocks = 1; blocks <= 8; ++blocks) {
+        // Each allocation is too big to share a block with the previous one.
+        arena.allocate(blockSize / 2 + 1, 1);
+        expectedReserved += blockSize;
+        ASSERT_EQ(arena.stats().blocks, blocks);
+        ASSERT_EQ(arena.stats().bytesReserved, expectedReserved);
+        blockSize = std::min(blockSize * 2, Arena::kMaxBlockSize);
+    }
+}
+
+TEST(ArenaTest, LargeAllocationGetsItsOwnBlock) {
+    Arena arena;
+    auto small = static_cast<char*>(arena.allocate(16));
+    arena.allocate(Arena::kInitialBlockSize * 4);
+    ASSERT_EQ(arena.stats().blocks, 2U);
+
+    // The next small allocation is still carved out of the first block.
+    auto next = static_cast<char*>(arena.allocate(16));
+    ASSERT_EQ(arena.stats().blocks, 2U);
+    ASSERT_EQ(next - small, 16);
+}
+
+TEST(ArenaTest, ObjectsAreAllocatedFromTheHeapOutsideOfAScope) {
+    int live = 0;
+    auto arena = make_intrusive<Arena>();
+    auto obj = std::make_unique<TrackedWithPayload>(&live);
+    ASSERT_EQ(live, 1);
+    ASSERT_EQ(arena->stats().allocations, 0U);
+    ASSERT_FALSE(arena->isShared());
+    obj.reset();
+    ASSERT_EQ(live, 0);
+}
+
+TEST(ArenaTest, ObjectsAreAllocatedFromTheArenaInsideAScope) {
+    int live = 0;
+    auto arena = make_intrusive<Arena>();
+    std::unique_ptr<Tracked> first;
+    std::unique_ptr<Tracked> second;
+    {
+        ArenaScope scope(arena.get());
+        ASSERT_EQ(ArenaScope::current(), arena.get());
+        first = std::make_unique<Tracked>(&live);
+        second = std::make_unique<TrackedWithPayload>(&live);
+    }
+    ASSERT_EQ(ArenaScope::current(), nullptr);
+    ASSERT_EQ(live, 2);
+    ASSERT_EQ(arena->stats().allocations, 2U);
+    ASSERT(isAligned(first.get(), alignof(std::max_align_t)));
+    ASSERT(isAligned(second.get(), alignof(std::max_align_t)));
+
+    // Destructors still run, including those of derived classes.
+    first.reset();
+    second.reset();
+    ASSERT_EQ(live, 0);
+    ASSERT_FALSE(arena->isShared());
+}
+
+TEST(ArenaTest, ObjectsKeepTheArenaAlive) {
+    int live = 0;
+    std::unique_ptr<Tracked> obj;
+    {
+        auto arena = make_intrusive<Arena>();
+        ArenaScope scope(arena.get());
+        obj = std::make_unique<TrackedWithPayload>(&live);
+        ASSERT(arena->isShared());
+    }
+    // The arena's owner is gone, but the object's memory is still valid.
+    ASSERT_EQ(static_cast<TrackedWithPayload*>(obj.get())->payload.size(), 60U);
+    obj.reset();
+    ASSERT_EQ(live, 0);
+}
+
+TEST(ArenaTest, ScopesNest) {
+    auto outer = make_intrusive<Arena>();
+    ArenaScope outerScope(outer.get());
+    {
+        ArenaScope heapScope(nullptr);
+        ASSERT_EQ(ArenaScope::current(), nullptr);
+        auto inner = make_intrusive<Arena>();
+        {
+            ArenaScope innerScope(inner.get());
+            ASSERT_EQ(ArenaScope::current(), inner.get());
+        }
+        ASSERT_EQ(ArenaScope::current(), nullptr);
+    }
+    ASSERT_EQ(ArenaScope::current(), outer.get());
+}
+
+}  // namespace
+}  // namespace mongo
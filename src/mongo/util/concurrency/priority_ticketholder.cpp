@@ -0,0 +1,323 @@
+/**
+ *    Copyright (C) 2018-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/priority_ticketholder.h"
+
+#include <algorithm>
+
+#include "mongo/util/str.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+long long nowMicros() {
+    return static_cast<long long>(curTimeMicros64());
+}
+
+// Elapsed time between two readings of nowMicros(), which may go backwards if the clock is reset.
+Microseconds elapsedBetween(long long startMicros, long long endMicros) {
+    return Microseconds(std::max(0LL, endMicros - startMicros));
+}
+
+}  // namespace
+
+PriorityTicketHolder::PriorityTicketHolder(int num, int lowPriorityBypassThreshold)
+    : _lowPriorityBypassThreshold(lowPriorityBypassThreshold),
+      _outof(num),
+      _available(num),
+      _sampleStartMicros(nowMicros()),
+      _lastUsageChangeMicros(_sampleStartMicros) {
+    invariant(_lowPriorityBypassThreshold > 0);
+}
+
+bool PriorityTicketHolder::tryAcquire() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_available <= 0) {
+        return false;
+    }
+
+    _acquire(lk);
+    _recordAdmission(lk, _lanes[static_cast<size_t>(TicketPriority::kNormal)], Microseconds(0));
+    return true;
+}
+
+bool PriorityTicketHolder::_waitForTicketUntil(OperationContext* opCtx,
+                                               Date_t until,
+                                               TicketPriority priority) {
+    auto& lane = _lanes[static_cast<size_t>(priority)];
+    stdx::unique_lock<Latch> lk(_mutex);
+
+    // Tickets are handed to waiting operations as soon as they become available, so an available
+    // ticket means that nobody is waiting for it.
+    if (_available > 0) {
+        _acquire(lk);
+        _recordAdmission(lk, lane, Microseconds(0));
+        return true;
+    }
+
+    _saturated = true;
+    Waiter waiter;
+    auto it = lane.waiters.insert(lane.waiters.end(), &waiter);
+    const auto startMicros = nowMicros();
+    const auto isGranted = [&] { return waiter.granted; };
+
+    bool granted;
+    try {
+        if (opCtx && until == Date_t::max()) {
+            opCtx->waitForConditionOrInterrupt(waiter.cv, lk, isGranted);
+            granted = true;
+        } else if (opCtx) {
+            granted = opCtx->waitForConditionOrInterruptUntil(waiter.cv, lk, until, isGranted);
+        } else if (until == Date_t::max()) {
+            waiter.cv.wait(lk, isGranted);
+            granted = true;
+        } else {
+            granted = waiter.cv.wait_until(lk, until.toSystemTimePoint(), isGranted);
+        }
+    } catch (...) {
+        if (!lk.owns_lock()) {
+            lk.lock();
+        }
+
+        // A ticket granted concurrently with the interruption goes to the next waiter instead.
+        if (waiter.granted) {
+            _release(lk);
+        } else {
+            lane.waiters.erase(it);
+        }
+        throw;
+    }
+
+    const auto waitTime = elapsedBetween(startMicros, nowMicros());
+    if (!granted) {
+        lane.waiters.erase(it);
+        lane.timeouts++;
+        return false;
+    }
+
+    // Granting the ticket removed the waiter from the lane and took the ticket out of the pool.
+    _recordAdmission(lk, lane, waitTime);
+    return true;
+}
+
+void PriorityTicketHolder::release() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _release(lk);
+}
+
+Status PriorityTicketHolder::resize(int newSize) {
+    if (newSize < 1) {
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "Minimum number of tickets is 1; given " << newSize);
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _updateTicketHeldTime(lk);
+    _available += newSize - _outof;
+    _outof = newSize;
+    _grantTickets(lk);
+    return Status::OK();
+}
+
+int PriorityTicketHolder::available() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return std::max(0, _available);
+}
+
+int PriorityTicketHolder::used() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _outof - _available;
+}
+
+int PriorityTicketHolder::outof() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _outof;
+}
+
+void PriorityTicketHolder::appendStats(BSONObjBuilder& b) const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    b.append("out", _outof - _available);
+    b.append("available", std::max(0, _available));
+    b.append("totalTickets", _outof);
+
+    BSONObjBuilder lanesBuilder(b.subobjStart("lanes"));
+    for (size_t i = 0; i < _lanes.size(); ++i) {
+        const auto& lane = _lanes[i];
+        BSONObjBuilder laneBuilder(lanesBuilder.subobjStart(toString(TicketPriority(i))));
+        laneBuilder.append("queued", static_cast<int>(lane.waiters.size()));
+        laneBuilder.append("admissions", lane.admissions);
+        laneBuilder.append("timeouts", lane.timeouts);
+        laneBuilder.append("totalTimeQueuedMicros",
+                           durationCount<Microseconds>(lane.totalTimeQueued));
+
+        BSONObjBuilder histogramBuilder(laneBuilder.subobjStart("waitTimeHistogramMicros"));
+        for (size_t bucket = 0; bucket < kWaitTimeBucketUpperBoundsMicros.size(); ++bucket) {
+            histogramBuilder.append(std::to_string(kWaitTimeBucketUpperBoundsMicros[bucket]),
+                                    lane.waitTimeHistogram[bucket]);
+        }
+        histogramBuilder.append("longer", lane.waitTimeHistogram.back());
+    }
+}
+
+int PriorityTicketHolder::queued(TicketPriority priority) const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _lanes[static_cast<size_t>(priority)].waiters.size();
+}
+
+PriorityTicketHolder::Sample PriorityTicketHolder::takeSample() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _updateTicketHeldTime(lk);
+
+    Sample sample;
+    sample.elapsed = elapsedBetween(_sampleStartMicros, _lastUsageChangeMicros);
+    sample.released = _released;
+    sample.ticketHeldTime = _ticketHeldTime;
+    sample.saturated = _saturated;
+
+    _sampleStartMicros = _lastUsageChangeMicros;
+    _released = 0;
+    _ticketHeldTime = Microseconds(0);
+    _saturated = std::any_of(
+        _lanes.begin(), _lanes.end(), [](const auto& lane) { return !lane.waiters.empty(); });
+    return sample;
+}
+
+void PriorityTicketHolder::_grantTickets(WithLock lk) {
+    while (_available > 0) {
+        auto lane = _nextLaneToGrant(lk);
+        if (!lane) {
+            return;
+        }
+
+        auto waiter = lane->waiters.front();
+        lane->waiters.pop_front();
+        _acquire(lk);
+        waiter->granted = true;
+        waiter->cv.notify_one();
+    }
+}
+
+PriorityTicketHolder::Lane* PriorityTicketHolder::_nextLaneToGrant(WithLock) {
+    auto& lowPriorityLane = _lanes[static_cast<size_t>(TicketPriority::kLow)];
+    if (lowPriorityLane.waiters.empty()) {
+        _grantsBypassingLowPriority = 0;
+    } else if (_grantsBypassingLowPriority >= _lowPriorityBypassThreshold) {
+        _grantsBypassingLowPriority = 0;
+        return &lowPriorityLane;
+    }
+
+    for (auto lane = _lanes.rbegin(); lane != _lanes.rend(); ++lane) {
+        if (lane->waiters.empty()) {
+            continue;
+        }
+
+        if (&*lane == &lowPriorityLane) {
+            _grantsBypassingLowPriority = 0;
+        } else if (!lowPriorityLane.waiters.empty()) {
+            _grantsBypassingLowPriority++;
+        }
+        return &*lane;
+    }
+    return nullptr;
+}
+
+void PriorityTicketHolder::_acquire(WithLock lk) {
+    invariant(_available > 0);
+    _updateTicketHeldTime(lk);
+    _available--;
+}
+
+void PriorityTicketHolder::_recordAdmission(WithLock, Lane& lane, Microseconds waitTime) {
+    lane.admissions++;
+    lane.totalTimeQueued += waitTime;
+
+    const auto bucket = std::lower_bound(kWaitTimeBucketUpperBoundsMicros.begin(),
+                                         kWaitTimeBucketUpperBoundsMicros.end(),
+                                         durationCount<Microseconds>(waitTime)) -
+        kWaitTimeBucketUpperBoundsMicros.begin();
+    lane.waitTimeHistogram[bucket]++;
+}
+
+void PriorityTicketHolder::_release(WithLock lk) {
+    _updateTicketHeldTime(lk);
+    _available++;
+    _released++;
+    _grantTickets(lk);
+}
+
+void PriorityTicketHolder::_updateTicketHeldTime(WithLock) {
+    const auto now = nowMicros();
+    const auto inUse = _outof - _available;
+    _ticketHeldTime += elapsedBetween(_lastUsageChangeMicros, now) * inUse;
+    _lastUsageChangeMicros = std::max(_lastUsageChangeMicros, now);
+}
+
+int TicketPoolSizer::nextSize(int currentSize,
+                              const PriorityTicketHolder::Sample& sample,
+                              int minSize,
+                              int maxSize) {
+    const auto clamp = [&](int size) { return std::max(minSize, std::min(maxSize, size)); };
+
+    // Without saturation or completed operations there is nothing to learn about the effect of the
+    // pool size, so start over from the current size once there is.
+    if (!sample.saturated || sample.released == 0 || sample.elapsed <= Microseconds(0)) {
+        _lastThroughput = boost::none;
+        _direction = 1;
+        return clamp(currentSize);
+    }
+
+    const double throughput = sample.released /
+        (static_cast<double>(durationCount<Microseconds>(sample.elapsed)) / 1000 / 1000);
+    const double meanTicketHeldMicros =
+        static_cast<double>(durationCount<Microseconds>(sample.ticketHeldTime)) / sample.released;
+
+    if (_lastThroughput) {
+        if (throughput < *_lastThroughput * (1 - kThroughputTolerance)) {
+            _direction = -_direction;
+        } else if (throughput <= *_lastThroughput * (1 + kThroughputTolerance)) {
+            if (meanTicketHeldMicros > _lastMeanTicketHeldMicros * (1 + kTicketHeldTimeTolerance)) {
+                _direction = -1;
+            } else {
+                _lastThroughput = throughput;
+                _lastMeanTicketHeldMicros = meanTicketHeldMicros;
+                return clamp(currentSize);
+            }
+        }
+    }
+
+    _lastThroughput = throughput;
+    _lastMeanTicketHeldMicros = meanTicketHeldMicros;
+
+    const int step = std::max(1, currentSize / 8);
+    return clamp(currentSize + _direction * step);
+}
+
+}  // namespace mongo
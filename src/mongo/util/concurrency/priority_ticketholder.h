@@ -0,0 +1,224 @@
+/**
+ *    Copyright (C) 2018-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#pragma once
+
+#include <array>
+#include <list>
+
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/duration.h"
+
+namespace mongo {
+
+/**
+ * A TicketHolder which queues the operations waiting for a ticket in one FIFO lane per
+ * TicketPriority. A released ticket goes to the longest waiting operation of the highest priority,
+ * except that low priority operations are admitted at least once for every
+ * 'lowPriorityBypassThreshold' tickets handed to higher priorities while they wait, so that they
+ * are never starved.
+ *
+ * Shrinking the pool never blocks: if more tickets are in use than the new size, released tickets
+ * are retired until the number in use drops below it.
+ */
+class PriorityTicketHolder final : public TicketHolder {
+public:
+    static constexpr int kDefaultLowPriorityBypassThreshold = 100;
+
+    /**
+     * Upper bounds in microseconds of the buckets of the wait time histogram of each lane. A last
+     * bucket counts the waits longer than all of them.
+     */
+    static constexpr std::array<long long, 5> kWaitTimeBucketUpperBoundsMicros{
+        100, 1000, 10 * 1000, 100 * 1000, 1000 * 1000};
+
+    /**
+     * Usage of the pool over the period since the previous sample.
+     */
+    struct Sample {
+        Microseconds elapsed{0};
+
+        // The number of tickets released.
+        long long released{0};
+
+        // The sum over all tickets of the time they were held for.
+        Microseconds ticketHeldTime{0};
+
+        // Whether any operation had to wait for a ticket.
+        bool saturated{false};
+    };
+
+    explicit PriorityTicketHolder(
+        int num, int lowPriorityBypassThreshold = kDefaultLowPriorityBypassThreshold);
+
+    bool tryAcquire() override;
+
+    void release() override;
+
+    Status resize(int newSize) override;
+
+    int available() const override;
+
+    /**
+     * Counts the tickets in use beyond 'outof()' after the holder was shrunk, which 'available()'
+     * reports as zero rather than negative.
+     */
+    int used() const override;
+
+    int outof() const override;
+
+    /**
+     * Also appends the queue depth, number of admissions, total time queued and wait time
+     * histogram of each priority lane under "lanes".
+     */
+    void appendStats(BSONObjBuilder& b) const override;
+
+    /**
+     * Returns the number of operations waiting for a ticket with the given priority.
+     */
+    int queued(TicketPriority priority) const;
+
+    /**
+     * Returns the usage of the pool since the previous call, for sizing the pool.
+     */
+    Sample takeSample();
+
+private:
+    struct Waiter {
+        stdx::condition_variable cv;
+        bool granted{false};
+    };
+
+    struct Lane {
+        std::list<Waiter*> waiters;
+
+        long long admissions{0};
+        long long timeouts{0};
+        Microseconds totalTimeQueued{0};
+        std::array<long long, kWaitTimeBucketUpperBoundsMicros.size() + 1> waitTimeHistogram{};
+    };
+
+    bool _waitForTicketUntil(OperationContext* opCtx,
+                             Date_t until,
+                             TicketPriority priority) override;
+
+    /**
+     * Hands out available tickets to waiting operations, in priority order.
+     */
+    void _grantTickets(WithLock);
+
+    /**
+     * Returns the lane of the operation which should get the next ticket, or nullptr if none is
+     * waiting.
+     */
+    Lane* _nextLaneToGrant(WithLock);
+
+    /**
+     * Takes an available ticket out of the pool.
+     */
+    void _acquire(WithLock);
+
+    /**
+     * Records that an operation of 'lane' got a ticket after waiting for 'waitTime'.
+     */
+    void _recordAdmission(WithLock, Lane& lane, Microseconds waitTime);
+
+    /**
+     * Returns a ticket to the pool.
+     */
+    void _release(WithLock);
+
+    /**
+     * Accounts for the time for which the tickets currently in use have been held since the last
+     * change in the number of tickets in use.
+     */
+    void _updateTicketHeldTime(WithLock);
+
+    const int _lowPriorityBypassThreshold;
+
+    mutable Mutex _mutex =
+        MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "PriorityTicketHolder::_mutex");
+
+    int _outof;
+
+    // The number of tickets which are neither in use nor granted to a waiting operation. This is
+    // negative while more tickets are in use than the size of the pool after it was shrunk.
+    int _available;
+
+    std::array<Lane, kNumTicketPriorities> _lanes;
+
+    // The number of tickets handed to higher priority operations since a low priority one was last
+    // admitted, while low priority operations were waiting.
+    int _grantsBypassingLowPriority{0};
+
+    // State of the current sample.
+    long long _sampleStartMicros;
+    long long _lastUsageChangeMicros;
+    long long _released{0};
+    Microseconds _ticketHeldTime{0};
+    bool _saturated{false};
+};
+
+/**
+ * Chooses the size of a ticket pool from its observed usage by hill climbing: the size keeps moving
+ * in the same direction for as long as throughput, in tickets released per second, improves, and
+ * changes direction when throughput drops. When throughput stays the same but each ticket is held
+ * longer, the additional concurrency only adds contention in the storage engine, so the pool
+ * shrinks. A pool which is not saturated is left alone, since its size is not what limits
+ * throughput.
+ */
+class TicketPoolSizer {
+public:
+    // The relative changes in throughput and in the time tickets are held for which are considered
+    // significant.
+    static constexpr double kThroughputTolerance = 0.05;
+    static constexpr double kTicketHeldTimeTolerance = 0.1;
+
+    /**
+     * Returns the size the pool should have for the next period, between 'minSize' and 'maxSize',
+     * given that it had 'currentSize' tickets during the period described by 'sample'.
+     */
+    int nextSize(int currentSize,
+                 const PriorityTicketHolder::Sample& sample,
+                 int minSize,
+                 int maxSize);
+
+private:
+    // +1 while growing the pool and -1 while shrinking it.
+    int _direction{1};
+
+    // Throughput and mean time tickets were held for during the previous period, if it is usable
+    // as a baseline.
+    boost::optional<double> _lastThroughput;
+    double _lastMeanTicketHeldMicros{0};
+};
+
+}  // namespace mongo
@@ -32,6 +32,7 @@
 #include <semaphore.h>
 #endif
 
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/stdx/condition_variable.h"
@@ -41,22 +42,68 @@
 
 namespace mongo {
 
+/**
+ * Priority with which an operation waits for a ticket. Holders which support priorities admit
+ * waiting operations in order of decreasing priority; others ignore it.
+ */
+enum class TicketPriority {
+    // Long-running work, such as unbounded collection scans and index builds, which should give
+    // way to latency-sensitive operations.
+    kLow = 0,
+    kNormal = 1,
+    // Work which other operations may be waiting on, such as replication.
+    kHigh = 2,
+};
+
+constexpr size_t kNumTicketPriorities = 3;
+
+StringData toString(TicketPriority priority);
+
+/**
+ * Returns the priority with which 'opCtx' waits for tickets, which is kNormal unless set otherwise.
+ */
+TicketPriority getTicketPriority(OperationContext* opCtx);
+void setTicketPriority(OperationContext* opCtx, TicketPriority priority);
+
+/**
+ * Sets the ticket priority of an operation for the lifetime of this object.
+ */
+class ScopedTicketPriority {
+    ScopedTicketPriority(const ScopedTicketPriority&) = delete;
+    ScopedTicketPriority& operator=(const ScopedTicketPriority&) = delete;
+
+public:
+    ScopedTicketPriority(OperationContext* opCtx, TicketPriority priority)
+        : _opCtx(opCtx), _previous(getTicketPriority(opCtx)) {
+        setTicketPriority(_opCtx, priority);
+    }
+
+    ~ScopedTicketPriority() {
+        setTicketPriority(_opCtx, _previous);
+    }
+
+private:
+    OperationContext* const _opCtx;
+    const TicketPriority _previous;
+};
+
 class TicketHolder {
     TicketHolder(const TicketHolder&) = delete;
     TicketHolder& operator=(const TicketHolder&) = delete;
 
 public:
-    explicit TicketHolder(int num);
-    ~TicketHolder();
+    virtual ~TicketHolder() = default;
 
-    bool tryAcquire();
+    virtual bool tryAcquire() = 0;
 
     /**
      * Attempts to acquire a ticket. Blocks until a ticket is acquired or the OperationContext
      * 'opCtx' is killed, throwing an AssertionException.
      * If 'opCtx' is not provided or equal to nullptr, the wait is not interruptible.
      */
-    void waitForTicket(OperationContext* opCtx);
+    void waitForTicket(OperationContext* opCtx, TicketPriority priority = TicketPriority::kNormal) {
+        invariant(_waitForTicketUntil(opCtx, Date_t::max(), priority));
+    }
     void waitForTicket() {
         waitForTicket(nullptr);
     }
@@ -68,21 +115,64 @@ public:
      * proceed.
      * If 'opCtx' is not provided or equal to nullptr, the wait is not interruptible.
      */
-    bool waitForTicketUntil(OperationContext* opCtx, Date_t until);
+    bool waitForTicketUntil(OperationContext* opCtx,
+                            Date_t until,
+                            TicketPriority priority = TicketPriority::kNormal) {
+        return _waitForTicketUntil(opCtx, until, priority);
+    }
     bool waitForTicketUntil(Date_t until) {
         return waitForTicketUntil(nullptr, until);
     }
-    void release();
 
-    Status resize(int newSize);
+    virtual void release() = 0;
+
+    virtual Status resize(int newSize) = 0;
+
+    virtual int available() const = 0;
+
+    virtual int used() const {
+        return outof() - available();
+    }
+
+    virtual int outof() const = 0;
+
+    /**
+     * Appends the number of tickets in use, available and in total, and any statistics specific to
+     * the implementation, for serverStatus.
+     */
+    virtual void appendStats(BSONObjBuilder& b) const;
+
+protected:
+    TicketHolder() = default;
+
+    virtual bool _waitForTicketUntil(OperationContext* opCtx,
+                                     Date_t until,
+                                     TicketPriority priority) = 0;
+};
+
+/**
+ * A TicketHolder which is a plain counting semaphore. Waiters are not ordered by priority.
+ */
+class SemaphoreTicketHolder final : public TicketHolder {
+public:
+    explicit SemaphoreTicketHolder(int num);
+    ~SemaphoreTicketHolder();
+
+    bool tryAcquire() override;
 
-    int available() const;
+    void release() override;
 
-    int used() const;
+    Status resize(int newSize) override;
 
-    int outof() const;
+    int available() const override;
+
+    int outof() const override;
 
 private:
+    bool _waitForTicketUntil(OperationContext* opCtx,
+                             Date_t until,
+                             TicketPriority priority) override;
+
 #if defined(__linux__)
     mutable sem_t _sem;
 
@@ -32,14 +32,16 @@
 
 #include "mongo/platform/basic.h"
 
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/priority_ticketholder.h"
 #include "mongo/util/concurrency/ticketholder.h"
 
 namespace {
 using namespace mongo;
 
-TEST(TicketholderTest, BasicTimeout) {
-    TicketHolder holder(1);
+void checkBasicTimeout(TicketHolder& holder) {
     ASSERT_EQ(holder.used(), 0);
     ASSERT_EQ(holder.available(), 1);
     ASSERT_EQ(holder.outof(), 1);
@@ -72,4 +74,187 @@ TEST(TicketholderTest, BasicTimeout) {
     holder.release();
     ASSERT_EQ(holder.used(), 0);
 }
+
+TEST(TicketholderTest, BasicTimeout) {
+    SemaphoreTicketHolder holder(1);
+    checkBasicTimeout(holder);
+}
+
+TEST(PriorityTicketholderTest, BasicTimeout) {
+    PriorityTicketHolder holder(1);
+    checkBasicTimeout(holder);
+}
+
+void waitForQueued(const PriorityTicketHolder& holder, TicketPriority priority, int expected) {
+    while (holder.queued(priority) != expected) {
+        sleepmillis(1);
+    }
+}
+
+TEST(PriorityTicketholderTest, AdmitsHigherPriorityFirst) {
+    PriorityTicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    Mutex mutex = MONGO_MAKE_LATCH();
+    std::vector<TicketPriority> admitted;
+    auto waitForTicket = [&](TicketPriority priority) {
+        return stdx::thread([&, priority] {
+            holder.waitForTicket(nullptr, priority);
+            stdx::lock_guard<Latch> lk(mutex);
+            admitted.push_back(priority);
+        });
+    };
+
+    auto low = waitForTicket(TicketPriority::kLow);
+    waitForQueued(holder, TicketPriority::kLow, 1);
+    auto normal = waitForTicket(TicketPriority::kNormal);
+    waitForQueued(holder, TicketPriority::kNormal, 1);
+    auto high = waitForTicket(TicketPriority::kHigh);
+    waitForQueued(holder, TicketPriority::kHigh, 1);
+
+    for (int i = 0; i < 3; ++i) {
+        holder.release();
+        (i == 0 ? high : i == 1 ? normal : low).join();
+    }
+    holder.release();
+
+    ASSERT_EQ(admitted.size(), 3U);
+    ASSERT(admitted[0] == TicketPriority::kHigh);
+    ASSERT(admitted[1] == TicketPriority::kNormal);
+    ASSERT(admitted[2] == TicketPriority::kLow);
+    ASSERT_EQ(holder.used(), 0);
+    ASSERT_EQ(holder.available(), 1);
+}
+
+TEST(PriorityTicketholderTest, LowPriorityIsNotStarved) {
+    PriorityTicketHolder holder(1, 2 /* lowPriorityBypassThreshold */);
+    ASSERT(holder.tryAcquire());
+
+    auto low = stdx::thread([&] { holder.waitForTicket(nullptr, TicketPriority::kLow); });
+    waitForQueued(holder, TicketPriority::kLow, 1);
+
+    // Two normal priority operations get a ticket ahead of the low priority one, but the third has
+    // to wait for it.
+    for (int i = 0; i < 3; ++i) {
+        auto normal = stdx::thread([&] { holder.waitForTicket(nullptr, TicketPriority::kNormal); });
+        waitForQueued(holder, TicketPriority::kNormal, 1);
+        holder.release();
+        if (i < 2) {
+            normal.join();
+            ASSERT_EQ(holder.queued(TicketPriority::kLow), 1);
+        } else {
+            low.join();
+            ASSERT_EQ(holder.queued(TicketPriority::kNormal), 1);
+            holder.release();
+            normal.join();
+        }
+    }
+    holder.release();
+    ASSERT_EQ(holder.used(), 0);
+}
+
+TEST(PriorityTicketholderTest, WaitTimesOutPerPriority) {
+    PriorityTicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+    ASSERT_FALSE(
+        holder.waitForTicketUntil(nullptr, Date_t::now() + Milliseconds(5), TicketPriority::kLow));
+    ASSERT_EQ(holder.queued(TicketPriority::kLow), 0);
+    holder.release();
+
+    BSONObjBuilder builder;
+    holder.appendStats(builder);
+    auto stats = builder.obj();
+    ASSERT_EQ(stats["out"].numberInt(), 0);
+    ASSERT_EQ(stats["totalTickets"].numberInt(), 1);
+    ASSERT_EQ(stats["lanes"]["low"]["timeouts"].numberLong(), 1);
+    ASSERT_EQ(stats["lanes"]["low"]["admissions"].numberLong(), 0);
+    ASSERT_EQ(stats["lanes"]["normal"]["admissions"].numberLong(), 1);
+    ASSERT_EQ(stats["lanes"]["normal"]["waitTimeHistogramMicros"]["100"].numberLong(), 1);
+}
+
+TEST(PriorityTicketholderTest, ShrinkingDoesNotBlock) {
+    PriorityTicketHolder holder(2);
+    ASSERT(holder.tryAcquire());
+    ASSERT(holder.tryAcquire());
+
+    ASSERT_OK(holder.resize(1));
+    ASSERT_EQ(holder.outof(), 1);
+    ASSERT_EQ(holder.used(), 2);
+    ASSERT_EQ(holder.available(), 0);
+
+    // The first released ticket is retired.
+    holder.release();
+    ASSERT_EQ(holder.used(), 1);
+    ASSERT_FALSE(holder.tryAcquire());
+
+    holder.release();
+    ASSERT_EQ(holder.available(), 1);
+    ASSERT(holder.tryAcquire());
+    holder.release();
+
+    ASSERT_NOT_OK(holder.resize(0));
+}
+
+TEST(PriorityTicketholderTest, GrowingAdmitsWaiters) {
+    PriorityTicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    auto waiter = stdx::thread([&] { holder.waitForTicket(); });
+    waitForQueued(holder, TicketPriority::kNormal, 1);
+    ASSERT_OK(holder.resize(2));
+    waiter.join();
+
+    ASSERT_EQ(holder.used(), 2);
+    holder.release();
+    holder.release();
+}
+
+PriorityTicketHolder::Sample makeSample(long long released, int meanTicketHeldMicros) {
+    PriorityTicketHolder::Sample sample;
+    sample.elapsed = Seconds(1);
+    sample.released = released;
+    sample.ticketHeldTime = Microseconds(released * meanTicketHeldMicros);
+    sample.saturated = true;
+    return sample;
+}
+
+TEST(TicketPoolSizerTest, LeavesUnsaturatedPoolAlone) {
+    TicketPoolSizer sizer;
+    auto sample = makeSample(1000, 100);
+    sample.saturated = false;
+    ASSERT_EQ(sizer.nextSize(64, sample, 1, 1000), 64);
+
+    // The size is still clamped to the bounds.
+    ASSERT_EQ(sizer.nextSize(64, sample, 1, 32), 32);
+}
+
+TEST(TicketPoolSizerTest, ClimbsWhileThroughputImproves) {
+    TicketPoolSizer sizer;
+    ASSERT_EQ(sizer.nextSize(64, makeSample(1000, 100), 1, 1000), 72);
+    ASSERT_EQ(sizer.nextSize(72, makeSample(1200, 100), 1, 1000), 81);
+
+    // Throughput dropped, so go back.
+    ASSERT_EQ(sizer.nextSize(81, makeSample(1000, 100), 1, 1000), 71);
+
+    // Throughput improved again, so keep shrinking.
+    ASSERT_EQ(sizer.nextSize(71, makeSample(1200, 100), 1, 1000), 63);
+}
+
+TEST(TicketPoolSizerTest, ShrinksWhenTicketsAreHeldLongerForTheSameThroughput) {
+    TicketPoolSizer sizer;
+    ASSERT_EQ(sizer.nextSize(64, makeSample(1000, 100), 1, 1000), 72);
+
+    // Same throughput and ticket hold time: stay.
+    ASSERT_EQ(sizer.nextSize(72, makeSample(1010, 100), 1, 1000), 72);
+
+    // Same throughput but tickets are held much longer: shrink.
+    ASSERT_EQ(sizer.nextSize(72, makeSample(1000, 200), 1, 1000), 63);
+}
+
+TEST(TicketPoolSizerTest, StaysWithinBounds) {
+    TicketPoolSizer sizer;
+    ASSERT_EQ(sizer.nextSize(64, makeSample(1000, 100), 1, 70), 70);
+    ASSERT_EQ(sizer.nextSize(70, makeSample(2000, 100), 1, 70), 70);
+}
+
 }  // namespace
@@ -45,6 +45,7 @@
 
 #include "mongo/base/string_data.h"
 #include "mongo/logv2/log.h"
+#include "mongo/logv2/log_util.h"
 #include "mongo/platform/compiler.h"
 #include "mongo/stdx/exception.h"
 #include "mongo/stdx/thread.h"
@@ -104,6 +105,10 @@ void endProcessWithSignal(int signalNum) {
 #else
 
 void endProcessWithSignal(int signalNum) {
+    // Write out the log lines explaining the crash, in case log writes are asynchronous. This gives
+    // up rather than wait if the log destination can't be taken, see MallocFreeOStreamGuard.
+    logv2::flushLogs();
+
     // This works by restoring the system-default handler for the given signal and re-raising it, in
     // order to get the system default termination behavior (i.e., dumping core, or just exiting).
     struct sigaction defaultedSignals;
@@ -178,6 +183,9 @@ public:
             quickExit(EXIT_ABRUPT);
         }
         _lk.lock();
+        // The signal may have interrupted this thread while it was writing a log record, in which
+        // case waiting for the log destination would never end.
+        logv2::setLogWritesNonBlockingForThread();
     }
 
 private:
@@ -0,0 +1,152 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+/**
+ * A tournament (winner) tree over a set of leaves, used for k-way merging. Each leaf is either
+ * active or inactive. top() returns the active leaf which compares smallest according to 'Less',
+ * which is a callable comparing two leaf indexes, e.g. by looking at the current head of each input
+ * stream of a merge. Ties are broken in favor of the lower leaf index.
+ *
+ * Whenever the key of a leaf changes or a leaf becomes (in)active, update() must be called for that
+ * leaf. It replays only the matches on the path from the leaf to the root, so it costs
+ * ceil(log2(numLeaves)) comparisons. Unlike a loser tree, any leaf may be updated, not just the
+ * current winner, which lets inputs drop out and rejoin the merge as their buffers drain and refill.
+ *
+ * This structure is not thread safe.
+ */
+template <typename Less>
+class TournamentTree {
+public:
+    static constexpr size_t kNoLeaf = std::numeric_limits<size_t>::max();
+
+    explicit TournamentTree(Less less, size_t numLeaves = 0) : _less(std::move(less)) {
+        _grow(numLeaves);
+    }
+
+    /**
+     * Returns true if there are no active leaves.
+     */
+    bool empty() const {
+        return _winner(1) == kNoLeaf;
+    }
+
+    /**
+     * Returns the smallest active leaf. Must not be called if empty().
+     */
+    size_t top() const {
+        dassert(!empty());
+        return _winner(1);
+    }
+
+    /**
+     * Records that 'leaf' is now 'active' and that its key may have changed, and replays the
+     * matches it took part in. Grows the tree if 'leaf' is beyond the current number of leaves.
+     */
+    void update(size_t leaf, bool active) {
+        if (leaf >= _active.size()) {
+            _grow(leaf + 1);
+        }
+        _active[leaf] = active;
+        for (size_t node = (_capacity + leaf) / 2; node > 0; node /= 2) {
+            _winners[node] = _match(_winner(2 * node), _winner(2 * node + 1));
+        }
+    }
+
+    size_t numLeaves() const {
+        return _active.size();
+    }
+
+private:
+    /**
+     * Returns the winner of the subtree rooted at 'node'. Nodes at or above '_capacity' are
+     * leaves.
+     */
+    size_t _winner(size_t node) const {
+        if (node >= _capacity) {
+            const size_t leaf = node - _capacity;
+            return leaf < _active.size() && _active[leaf] ? leaf : kNoLeaf;
+        }
+        return _winners[node];
+    }
+
+    size_t _match(size_t lhs, size_t rhs) const {
+        if (lhs == kNoLeaf) {
+            return rhs;
+        }
+        if (rhs == kNoLeaf) {
+            return lhs;
+        }
+        return _less(rhs, lhs) ? rhs : lhs;
+    }
+
+    /**
+     * Adds inactive leaves up to 'numLeaves', rebuilding the internal nodes if the capacity must
+     * grow.
+     */
+    void _grow(size_t numLeaves) {
+        _active.resize(std::max(numLeaves, _active.size()), false);
+        if (numLeaves <= _capacity && !_winners.empty()) {
+            return;
+        }
+
+        while (_capacity < numLeaves) {
+            _capacity *= 2;
+        }
+        _winners.assign(_capacity, kNoLeaf);
+        for (size_t node = _capacity - 1; node > 0; --node) {
+            _winners[node] = _match(_winner(2 * node), _winner(2 * node + 1));
+        }
+    }
+
+    Less _less;
+
+    // The number of leaf slots, always a power of two. Internal node i has children 2i and 2i+1,
+    // the root is node 1 and leaf slot j is node '_capacity + j'.
+    size_t _capacity = 1;
+
+    // The winner of the subtree rooted at each internal node, or kNoLeaf if none of its leaves are
+    // active. Index 0 is unused.
+    std::vector<size_t> _winners;
+
+    std::vector<bool> _active;
+};
+
+}  // namespace mongo
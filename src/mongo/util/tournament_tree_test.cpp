@@ -0,0 +1,152 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/tournament_tree.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Merges sorted input streams by their heads, the way a k-way merge would drive the tree.
+ */
+class StreamMerger {
+public:
+    explicit StreamMerger(std::vector<std::deque<int>> streams)
+        : _streams(std::move(streams)), _tree(Less{this}, _streams.size()) {
+        for (size_t i = 0; i < _streams.size(); ++i) {
+            _tree.update(i, !_streams[i].empty());
+        }
+    }
+
+    std::vector<int> mergeAll() {
+        std::vector<int> out;
+        while (!_tree.empty()) {
+            auto leaf = _tree.top();
+            out.push_back(_streams[leaf].front());
+            _streams[leaf].pop_front();
+            _tree.update(leaf, !_streams[leaf].empty());
+        }
+        return out;
+    }
+
+private:
+    struct Less {
+        bool operator()(size_t lhs, size_t rhs) const {
+            return merger->_streams[lhs].front() < merger->_streams[rhs].front();
+        }
+        StreamMerger* merger;
+    };
+
+    std::vector<std::deque<int>> _streams;
+    TournamentTree<Less> _tree;
+};
+
+TEST(TournamentTreeTest, EmptyTree) {
+    TournamentTree<std::less<size_t>> tree(std::less<size_t>{});
+    ASSERT_TRUE(tree.empty());
+    ASSERT_EQ(0U, tree.numLeaves());
+}
+
+TEST(TournamentTreeTest, SingleLeaf) {
+    TournamentTree<std::less<size_t>> tree(std::less<size_t>{}, 1);
+    ASSERT_TRUE(tree.empty());
+    tree.update(0, true);
+    ASSERT_FALSE(tree.empty());
+    ASSERT_EQ(0U, tree.top());
+    tree.update(0, false);
+    ASSERT_TRUE(tree.empty());
+}
+
+TEST(TournamentTreeTest, TiesGoToTheLowerLeaf) {
+    auto alwaysEqual = [](size_t, size_t) { return false; };
+    TournamentTree<decltype(alwaysEqual)> tree(alwaysEqual, 5);
+    tree.update(4, true);
+    tree.update(2, true);
+    tree.update(3, true);
+    ASSERT_EQ(2U, tree.top());
+    tree.update(2, false);
+    ASSERT_EQ(3U, tree.top());
+}
+
+TEST(TournamentTreeTest, MergesSortedStreams) {
+    StreamMerger merger({{1, 4, 7}, {}, {2, 5, 8}, {3, 6, 9}, {0}});
+    ASSERT(merger.mergeAll() == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+}
+
+TEST(TournamentTreeTest, MergesRandomStreams) {
+    PseudoRandom random(1);
+    for (size_t numStreams : {1, 2, 3, 7, 16, 100, 257}) {
+        std::vector<std::deque<int>> streams(numStreams);
+        std::vector<int> expected;
+        for (auto& stream : streams) {
+            auto length = random.nextInt32(20);
+            for (int i = 0; i < length; ++i) {
+                stream.push_back(random.nextInt32(1000));
+            }
+            std::sort(stream.begin(), stream.end());
+            expected.insert(expected.end(), stream.begin(), stream.end());
+        }
+        std::sort(expected.begin(), expected.end());
+        ASSERT(StreamMerger(std::move(streams)).mergeAll() == expected);
+    }
+}
+
+TEST(TournamentTreeTest, UpdatingAnyLeafGrowsTheTree) {
+    std::vector<int> keys{5, 3, 8};
+    auto less = [&](size_t lhs, size_t rhs) { return keys[lhs] < keys[rhs]; };
+    TournamentTree<decltype(less)> tree(less, 2);
+    tree.update(0, true);
+    tree.update(1, true);
+    ASSERT_EQ(1U, tree.top());
+
+    // A leaf which is not the current winner improves.
+    keys[0] = 1;
+    tree.update(0, true);
+    ASSERT_EQ(0U, tree.top());
+
+    // Adding a leaf past the end grows the tree and keeps the existing state.
+    keys.push_back(0);
+    tree.update(3, true);
+    ASSERT_EQ(4U, tree.numLeaves());
+    ASSERT_EQ(3U, tree.top());
+    tree.update(3, false);
+    ASSERT_EQ(0U, tree.top());
+}
+
+}  // namespace
+}  // namespace mongo